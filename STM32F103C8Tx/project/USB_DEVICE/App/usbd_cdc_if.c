@@ -260,9 +260,8 @@ static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 6 */
   extern void USB_CDC_RxCallback(uint8_t *Buf, uint32_t Len);
+  // usb_cdc.c re-arms the OUT endpoint into its next free packet slot
   USB_CDC_RxCallback(Buf, *Len);
-  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
-  USBD_CDC_ReceivePacket(&hUsbDeviceFS);
   return (USBD_OK);
   /* USER CODE END 6 */
 }
@@ -0,0 +1,195 @@
+/**
+ * @file fatfs_bd.c
+ * @brief FatFs disk driver on a Block_Device
+ */
+
+#include "fatfs_bd.h"
+#include <string.h>
+
+// Program granularity of the write-back: one NOR page
+#define FATFS_BD_CHUNK 256
+
+FatFs_BD_Stats fatfs_bd_stats;
+
+static Block_Device *volumes[_VOLUMES];
+static uint8_t volume_count;
+
+// Erase unit being written (shared by all volumes)
+static struct {
+    Block_Device *bd;           // NULL = nothing loaded
+    uint32_t      addr;         // Start of the unit on the device
+    uint8_t       dirty;
+    uint8_t       needs_erase;  // A write sets a bit the flash can only set by erasing
+    uint8_t       chunk_dirty[FATFS_BD_UNIT_SIZE / FATFS_BD_CHUNK];
+    uint8_t       data[FATFS_BD_UNIT_SIZE];
+} unit;
+
+static int FatFs_BD_ChunkErased(const Block_Device *bd, const uint8_t *chunk) {
+    for (uint32_t i = 0; i < FATFS_BD_CHUNK; i++) {
+        if (chunk[i] != bd->erase_value) return 0;
+    }
+    return 1;
+}
+
+int FatFs_BD_Flush(void) {
+    Block_Device *bd = unit.bd;
+    int err = BLOCK_DEV_OK;
+
+    if (bd == NULL || !unit.dirty) return BLOCK_DEV_OK;
+
+    if (unit.needs_erase) {
+        // Erase, then program back every page that holds data
+        err = BlockDev_Erase(bd, unit.addr, bd->erase_size);
+        for (uint32_t off = 0; err == BLOCK_DEV_OK && off < bd->erase_size; off += FATFS_BD_CHUNK) {
+            if (!FatFs_BD_ChunkErased(bd, &unit.data[off])) {
+                err = BlockDev_Prog(bd, unit.addr + off, &unit.data[off], FATFS_BD_CHUNK);
+            }
+        }
+        fatfs_bd_stats.unit_erases++;
+    } else {
+        // Only bits cleared: program the pages that changed
+        for (uint32_t off = 0; err == BLOCK_DEV_OK && off < bd->erase_size; off += FATFS_BD_CHUNK) {
+            if (unit.chunk_dirty[off / FATFS_BD_CHUNK]) {
+                err = BlockDev_Prog(bd, unit.addr + off, &unit.data[off], FATFS_BD_CHUNK);
+            }
+        }
+        fatfs_bd_stats.unit_appends++;
+    }
+
+    unit.dirty = 0;
+    unit.needs_erase = 0;
+    memset(unit.chunk_dirty, 0, sizeof(unit.chunk_dirty));
+    if (err != BLOCK_DEV_OK) {
+        unit.bd = NULL;     // Contents no longer match the flash
+    }
+    return err;
+}
+
+// Put one sector into the unit buffer, loading its unit first
+static int FatFs_BD_WriteSector(Block_Device *bd, uint32_t addr, const uint8_t *src) {
+    uint32_t unit_addr = addr - addr % bd->erase_size;
+    uint32_t off;
+    int err;
+
+    if (unit.bd != bd || unit.addr != unit_addr) {
+        err = FatFs_BD_Flush();
+        if (err != BLOCK_DEV_OK) return err;
+
+        unit.bd = NULL;
+        err = BlockDev_Read(bd, unit_addr, unit.data, bd->erase_size);
+        if (err != BLOCK_DEV_OK) return err;
+        unit.bd = bd;
+        unit.addr = unit_addr;
+        fatfs_bd_stats.unit_loads++;
+    }
+
+    off = addr - unit_addr;
+    for (uint32_t i = 0; i < FATFS_BD_SECTOR_SIZE; i++) {
+        uint8_t old = unit.data[off + i], val = src[i];
+
+        if (old == val) continue;
+        // Programming moves bits away from the erased value only
+        if (bd->erase_value == 0xFF ? (old & val) != val : (old | val) != val) {
+            unit.needs_erase = 1;
+        }
+        unit.chunk_dirty[(off + i) / FATFS_BD_CHUNK] = 1;
+        unit.data[off + i] = val;
+        unit.dirty = 1;
+    }
+    return BLOCK_DEV_OK;
+}
+
+/*
+ * Diskio driver
+ */
+
+static DSTATUS FatFs_BD_Status(BYTE lun) {
+    return (lun < volume_count && volumes[lun] != NULL) ? 0 : STA_NOINIT;
+}
+
+static DRESULT FatFs_BD_Read(BYTE lun, BYTE *buff, DWORD sector, UINT count) {
+    Block_Device *bd = volumes[lun];
+    uint32_t addr = sector * FATFS_BD_SECTOR_SIZE;
+    uint32_t len = count * FATFS_BD_SECTOR_SIZE;
+
+    fatfs_bd_stats.reads++;
+    if (BlockDev_Read(bd, addr, buff, len) != BLOCK_DEV_OK) return RES_ERROR;
+
+    // The buffered unit is newer than the flash
+    if (unit.bd == bd && addr < unit.addr + bd->erase_size && unit.addr < addr + len) {
+        uint32_t start = addr > unit.addr ? addr : unit.addr;
+        uint32_t end = addr + len < unit.addr + bd->erase_size ? addr + len : unit.addr + bd->erase_size;
+
+        memcpy(&buff[start - addr], &unit.data[start - unit.addr], end - start);
+    }
+    return RES_OK;
+}
+
+static DRESULT FatFs_BD_Write(BYTE lun, const BYTE *buff, DWORD sector, UINT count) {
+    Block_Device *bd = volumes[lun];
+    uint32_t addr = sector * FATFS_BD_SECTOR_SIZE;
+
+    fatfs_bd_stats.writes++;
+    if (bd->erase_size == 0) {
+        return BlockDev_Prog(bd, addr, buff, count * FATFS_BD_SECTOR_SIZE) == BLOCK_DEV_OK ? RES_OK : RES_ERROR;
+    }
+
+    for (UINT i = 0; i < count; i++) {
+        if (FatFs_BD_WriteSector(bd, addr, buff) != BLOCK_DEV_OK) return RES_ERROR;
+        addr += FATFS_BD_SECTOR_SIZE;
+        buff += FATFS_BD_SECTOR_SIZE;
+    }
+    return RES_OK;
+}
+
+static DRESULT FatFs_BD_Ioctl(BYTE lun, BYTE cmd, void *buff) {
+    Block_Device *bd = volumes[lun];
+
+    switch (cmd) {
+    case CTRL_SYNC:
+        fatfs_bd_stats.syncs++;
+        if (unit.bd == bd && FatFs_BD_Flush() != BLOCK_DEV_OK) return RES_ERROR;
+        return BlockDev_Sync(bd) == BLOCK_DEV_OK ? RES_OK : RES_ERROR;
+    case GET_SECTOR_COUNT:
+        *(DWORD *)buff = bd->capacity / FATFS_BD_SECTOR_SIZE;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = FATFS_BD_SECTOR_SIZE;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        // In sectors; f_mkfs aligns the data area to it
+        *(DWORD *)buff = bd->erase_size ? bd->erase_size / FATFS_BD_SECTOR_SIZE : 1;
+        return RES_OK;
+    default:
+        return RES_PARERR;
+    }
+}
+
+static const Diskio_drvTypeDef FatFs_BD_Driver = {
+    FatFs_BD_Status,
+    FatFs_BD_Status,
+    FatFs_BD_Read,
+    FatFs_BD_Write,
+    FatFs_BD_Ioctl,
+};
+
+uint8_t FatFs_BD_Link(Block_Device *bd, char *path) {
+    if (volume_count >= _VOLUMES || bd->read_size == 0 || bd->prog_size == 0 ||
+        FATFS_BD_SECTOR_SIZE % bd->read_size != 0) {
+        return 1;
+    }
+    if (bd->erase_size != 0) {
+        if (bd->erase_size > FATFS_BD_UNIT_SIZE || bd->erase_size % FATFS_BD_SECTOR_SIZE != 0 ||
+            FATFS_BD_CHUNK % bd->prog_size != 0) {
+            return 1;
+        }
+    } else if (FATFS_BD_SECTOR_SIZE % bd->prog_size != 0) {
+        return 1;
+    }
+
+    if (FATFS_LinkDriverEx(&FatFs_BD_Driver, path, volume_count) != 0) {
+        return 1;
+    }
+    volumes[volume_count++] = bd;
+    return 0;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file fatfs_bd.h
+ * @brief FatFs disk driver on a Block_Device (NOR flash, SD card)
+ *
+ * FatFs works in 512-byte sectors. On NOR flash (erase_size set) sector
+ * writes are collected in a RAM copy of one erase unit and written when
+ * FatFs syncs (f_sync, f_close, directory updates) or moves on to another
+ * unit. A unit is only erased when a write turns a 0 bit back into 1;
+ * writes into erased space are programmed without an erase. Devices
+ * without an erase (SD) are written sector by sector as they come.
+ *
+ * Usage:
+ *      static Block_Device nor;
+ *      static FATFS fs;
+ *      static char path[4];
+ *      SFUD_Port_BlockDev(&nor, &data_flash);
+ *      FatFs_BD_Link(&nor, path);                 // path becomes "0:/"
+ *      if (f_mount(&fs, path, 1) == FR_NO_FILESYSTEM) {
+ *          f_mkfs(path, FM_ANY, 0, work, sizeof(work));
+ *          f_mount(&fs, path, 1);
+ *      }
+ */
+
+#ifndef FATFS_BD_H
+#define FATFS_BD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ff_gen_drv.h"
+#include "block_dev.h"
+
+#define FATFS_BD_SECTOR_SIZE 512
+
+// Largest erase unit the write-back buffer holds (RAM, shared by all volumes)
+#ifndef FATFS_BD_UNIT_SIZE
+#define FATFS_BD_UNIT_SIZE 4096
+#endif
+
+typedef struct {
+    uint32_t reads;             // disk_read calls
+    uint32_t writes;            // disk_write calls
+    uint32_t unit_loads;        // Erase units read into the buffer
+    uint32_t unit_erases;       // Units erased and reprogrammed
+    uint32_t unit_appends;      // Units written without an erase
+    uint32_t syncs;
+} FatFs_BD_Stats;
+
+extern FatFs_BD_Stats fatfs_bd_stats;
+
+/**
+ * @brief Register bd as a FatFs volume
+ * @param path Receives the drive path ("0:/"), at least 4 chars
+ * @return 0 on success, 1 if no volume is free or the geometry does not
+ *         fit (read/prog size must divide 512, erase unit up to
+ *         FATFS_BD_UNIT_SIZE)
+ */
+uint8_t FatFs_BD_Link(Block_Device *bd, char *path);
+
+/**
+ * @brief Write back the buffered erase unit, if any
+ * @note  FatFs does this on CTRL_SYNC; call it before cutting power.
+ * @return 0 on success, BLOCK_DEV_ERR_xxx
+ */
+int FatFs_BD_Flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,241 @@
+/**
+ * @file fatfs_sd.c
+ * @brief FatFs disk driver on the SPI SD card driver
+ */
+
+#include "fatfs_sd.h"
+#include <string.h>
+
+#define FATFS_SD_SECTOR_SIZE 512
+#define FATFS_SD_CACHE_SLOTS (FATFS_SD_CACHE_SECTORS > 0 ? FATFS_SD_CACHE_SECTORS : 1)
+
+FatFs_SD_Stats fatfs_sd_stats;
+
+static SD_Card_SPI_HandleTypeDef *volumes[_VOLUMES];
+static uint8_t volume_count;
+
+// Sector cache (shared by all volumes)
+static struct {
+    SD_Card_SPI_HandleTypeDef *hsd;     // NULL = empty
+    DWORD    sector;
+    uint32_t used;                      // LRU stamp
+    uint8_t  dirty;
+    uint8_t  data[FATFS_SD_SECTOR_SIZE];
+} cache[FATFS_SD_CACHE_SLOTS];
+static uint8_t cache_sectors = FATFS_SD_CACHE_SECTORS;
+static uint32_t cache_clock;
+
+static int FatFs_SD_Find(const SD_Card_SPI_HandleTypeDef *hsd, DWORD sector) {
+    for (int i = 0; i < cache_sectors; i++) {
+        if (cache[i].hsd == hsd && cache[i].sector == sector) return i;
+    }
+    return -1;
+}
+
+// Write the dirty sectors of one card, lowest first; runs of consecutive
+// sectors go out as one CMD25 stream
+static uint8_t FatFs_SD_WriteBack(SD_Card_SPI_HandleTypeDef *hsd) {
+    for (;;) {
+        int first = -1, i;
+        uint32_t run = 1;
+
+        for (i = 0; i < cache_sectors; i++) {
+            if (cache[i].hsd == hsd && cache[i].dirty &&
+                (first < 0 || cache[i].sector < cache[first].sector)) {
+                first = i;
+            }
+        }
+        if (first < 0) return 0;
+
+        while ((i = FatFs_SD_Find(hsd, cache[first].sector + run)) >= 0 && cache[i].dirty) run++;
+
+        if (run == 1) {
+            if (SD_SPI_WriteBlock(hsd, cache[first].sector, cache[first].data) != 0) return 2;
+        } else {
+            uint8_t res = SD_SPI_WriteStart(hsd, cache[first].sector, run);
+
+            for (uint32_t n = 0; res == 0 && n < run; n++) {
+                res = SD_SPI_WriteNext(hsd, cache[FatFs_SD_Find(hsd, cache[first].sector + n)].data);
+            }
+            if (SD_SPI_WriteStop(hsd) != 0 || res != 0) return 2;
+        }
+
+        for (uint32_t n = 0; n < run; n++) {
+            cache[FatFs_SD_Find(hsd, cache[first].sector + n)].dirty = 0;
+        }
+        fatfs_sd_stats.write_backs += run;
+        fatfs_sd_stats.sectors_written += run;
+    }
+}
+
+// Free slot or the least recently used one, written back first if dirty
+static int FatFs_SD_Victim(void) {
+    int victim = 0;
+
+    for (int i = 0; i < cache_sectors; i++) {
+        if (cache[i].hsd == NULL) return i;
+        if (cache[i].used < cache[victim].used) victim = i;
+    }
+    if (cache[victim].dirty) {
+        if (SD_SPI_WriteBlock(cache[victim].hsd, cache[victim].sector, cache[victim].data) != 0) return -1;
+        fatfs_sd_stats.write_backs++;
+        fatfs_sd_stats.sectors_written++;
+    }
+    cache[victim].hsd = NULL;
+    cache[victim].dirty = 0;
+    return victim;
+}
+
+static void FatFs_SD_Drop(const SD_Card_SPI_HandleTypeDef *hsd) {
+    for (int i = 0; i < FATFS_SD_CACHE_SLOTS; i++) {
+        if (hsd == NULL || cache[i].hsd == hsd) {
+            cache[i].hsd = NULL;
+            cache[i].dirty = 0;
+        }
+    }
+}
+
+uint8_t FatFs_SD_Flush(void) {
+    uint8_t res = 0;
+
+    for (uint8_t v = 0; v < volume_count; v++) {
+        if (FatFs_SD_WriteBack(volumes[v]) != 0) res = 2;
+    }
+    return res;
+}
+
+uint8_t FatFs_SD_SetCache(uint8_t sectors) {
+    uint8_t res = FatFs_SD_Flush();
+
+    FatFs_SD_Drop(NULL);
+    cache_sectors = (sectors > FATFS_SD_CACHE_SECTORS) ? FATFS_SD_CACHE_SECTORS : sectors;
+    return res;
+}
+
+/*
+ * Diskio driver
+ */
+
+static DSTATUS FatFs_SD_Status(BYTE lun) {
+    SD_Card_SPI_HandleTypeDef *hsd = (lun < volume_count) ? volumes[lun] : NULL;
+
+    return (hsd != NULL && hsd->Type != SD_CARD_TYPE_UKN && hsd->Capacity != 0) ? 0 : STA_NOINIT;
+}
+
+static DSTATUS FatFs_SD_Initialize(BYTE lun) {
+    SD_Card_SPI_HandleTypeDef *hsd;
+
+    if (lun >= volume_count) return STA_NOINIT;
+    hsd = volumes[lun];
+
+    // The card may have been swapped: unsynced sectors belong to the old one
+    FatFs_SD_Drop(hsd);
+    if (FatFs_SD_Status(lun) != 0) {
+        SD_SPI_Init(hsd, hsd->hspi, hsd->CsPort, hsd->CsPin);
+    }
+    return FatFs_SD_Status(lun);
+}
+
+static DRESULT FatFs_SD_Read(BYTE lun, BYTE *buff, DWORD sector, UINT count) {
+    SD_Card_SPI_HandleTypeDef *hsd = volumes[lun];
+    int i;
+
+    fatfs_sd_stats.reads++;
+    if (count == 1 && cache_sectors > 0) {
+        i = FatFs_SD_Find(hsd, sector);
+        if (i >= 0) {
+            fatfs_sd_stats.hits++;
+        } else {
+            fatfs_sd_stats.misses++;
+            i = FatFs_SD_Victim();
+            if (i < 0 || SD_SPI_ReadBlock(hsd, sector, cache[i].data) != 0) return RES_ERROR;
+            fatfs_sd_stats.sectors_read++;
+            cache[i].hsd = hsd;
+            cache[i].sector = sector;
+        }
+        cache[i].used = ++cache_clock;
+        memcpy(buff, cache[i].data, FATFS_SD_SECTOR_SIZE);
+        return RES_OK;
+    }
+
+    if (SD_SPI_ReadBlocks(hsd, sector, buff, count) != 0) return RES_ERROR;
+    fatfs_sd_stats.sectors_read += count;
+
+    // Cached sectors not written back yet are newer than the card
+    for (i = 0; i < cache_sectors; i++) {
+        if (cache[i].hsd == hsd && cache[i].dirty && cache[i].sector - sector < count) {
+            memcpy(&buff[(cache[i].sector - sector) * FATFS_SD_SECTOR_SIZE], cache[i].data, FATFS_SD_SECTOR_SIZE);
+        }
+    }
+    return RES_OK;
+}
+
+static DRESULT FatFs_SD_Write(BYTE lun, const BYTE *buff, DWORD sector, UINT count) {
+    SD_Card_SPI_HandleTypeDef *hsd = volumes[lun];
+    int i;
+
+    fatfs_sd_stats.writes++;
+    if (count == 1 && cache_sectors > 0) {
+        i = FatFs_SD_Find(hsd, sector);
+        if (i < 0) {
+            i = FatFs_SD_Victim();
+            if (i < 0) return RES_ERROR;
+            cache[i].hsd = hsd;
+            cache[i].sector = sector;
+        }
+        memcpy(cache[i].data, buff, FATFS_SD_SECTOR_SIZE);
+        cache[i].dirty = 1;
+        cache[i].used = ++cache_clock;
+        return RES_OK;
+    }
+
+    if (SD_SPI_WriteBlocks(hsd, sector, buff, count) != 0) return RES_ERROR;
+    fatfs_sd_stats.sectors_written += count;
+
+    // The card now holds newer data than any cached copy
+    for (i = 0; i < cache_sectors; i++) {
+        if (cache[i].hsd == hsd && cache[i].sector - sector < count) {
+            cache[i].hsd = NULL;
+            cache[i].dirty = 0;
+        }
+    }
+    return RES_OK;
+}
+
+static DRESULT FatFs_SD_Ioctl(BYTE lun, BYTE cmd, void *buff) {
+    SD_Card_SPI_HandleTypeDef *hsd = volumes[lun];
+
+    switch (cmd) {
+    case CTRL_SYNC:
+        // Writes are complete when SD_SPI_WriteBlock(s) returns; only the cache is pending
+        fatfs_sd_stats.syncs++;
+        return FatFs_SD_WriteBack(hsd) == 0 ? RES_OK : RES_ERROR;
+    case GET_SECTOR_COUNT:
+        *(DWORD *)buff = hsd->Capacity;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = FATFS_SD_SECTOR_SIZE;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        // In sectors; f_mkfs aligns the data area to it
+        *(DWORD *)buff = hsd->EraseSectors ? hsd->EraseSectors : 1;
+        return RES_OK;
+    default:
+        return RES_PARERR;
+    }
+}
+
+static const Diskio_drvTypeDef FatFs_SD_Driver = {
+    FatFs_SD_Initialize,
+    FatFs_SD_Status,
+    FatFs_SD_Read,
+    FatFs_SD_Write,
+    FatFs_SD_Ioctl,
+};
+
+uint8_t FatFs_SD_Link(SD_Card_SPI_HandleTypeDef *hsd, char *path) {
+    if (volume_count >= _VOLUMES) return 1;
+    if (FATFS_LinkDriverEx(&FatFs_SD_Driver, path, volume_count) != 0) return 1;
+    volumes[volume_count++] = hsd;
+    return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file fatfs_sd.h
+ * @brief FatFs disk driver on the SPI SD card driver (sd_card_spi.h)
+ *
+ * Sector numbers go to the card as they are (no 4 GB byte-address limit).
+ * Multi-sector disk_read/disk_write calls, which FatFs issues for the
+ * whole-sector part of f_read/f_write, become one CMD18 / ACMD23 + CMD25
+ * stream each. The sector count comes from the card's CSD.
+ *
+ * Sector cache
+ *   Single-sector transfers, which FatFs uses for its window (FAT, directory,
+ *   FSINFO) and for the partial sectors of file buffers, go through a small
+ *   LRU write-back cache of FATFS_SD_CACHE_SECTORS sectors. Path lookups and
+ *   cluster chain walks then hit RAM, and a FAT or directory sector updated
+ *   several times between two syncs is written once. Dirty sectors are
+ *   written on CTRL_SYNC (f_sync, f_close), on eviction, or by
+ *   FatFs_SD_Flush; consecutive ones go out as one CMD25 stream.
+ *
+ * Usage:
+ *      static SD_Card_SPI_HandleTypeDef hsd;
+ *      static FATFS fs;
+ *      static char path[4];
+ *      SD_SPI_Init(&hsd, &hspi2, GPIOB, GPIO_PIN_12);
+ *      FatFs_SD_Link(&hsd, path);                 // path becomes "0:/"
+ *      f_mount(&fs, path, 1);
+ */
+
+#ifndef FATFS_SD_H
+#define FATFS_SD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ff_gen_drv.h"
+#include "sd_card_spi.h"
+
+// Cached sectors, shared by all SD volumes. RAM = 512 bytes each; 0 removes
+// the cache.
+#ifndef FATFS_SD_CACHE_SECTORS
+#define FATFS_SD_CACHE_SECTORS 4
+#endif
+
+typedef struct {
+    uint32_t reads;             // disk_read calls
+    uint32_t writes;            // disk_write calls
+    uint32_t sectors_read;      // Sectors read from the card
+    uint32_t sectors_written;   // Sectors written to the card
+    uint32_t hits;              // Single-sector reads served from the cache
+    uint32_t misses;
+    uint32_t write_backs;       // Dirty cache sectors written
+    uint32_t syncs;
+} FatFs_SD_Stats;
+
+extern FatFs_SD_Stats fatfs_sd_stats;
+
+/**
+ * @brief Register an SD card as a FatFs volume
+ * @note  hsd should be initialized (SD_SPI_Init); if it is not, or the card
+ *        failed, disk_initialize (f_mount) retries SD_SPI_Init on the same
+ *        bus and pins, so hsd->hspi, CsPort and CsPin must be set.
+ * @param path Receives the drive path ("0:/"), at least 4 chars
+ * @return 0 on success, 1 if no volume is free
+ */
+uint8_t FatFs_SD_Link(SD_Card_SPI_HandleTypeDef *hsd, char *path);
+
+/**
+ * @brief Number of cache sectors to use, 0 to turn the cache off
+ * @note  Capped at FATFS_SD_CACHE_SECTORS. Flushes and empties the cache.
+ * @return 0 on success, 2 if writing back dirty sectors failed
+ */
+uint8_t FatFs_SD_SetCache(uint8_t sectors);
+
+/**
+ * @brief Write back all dirty cache sectors
+ * @note  FatFs does this on CTRL_SYNC; call it before cutting power.
+ * @return 0 on success, 2 on a card error
+ */
+uint8_t FatFs_SD_Flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
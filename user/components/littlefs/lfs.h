@@ -0,0 +1,14 @@
+/**
+ * @file lfs.h
+ * @brief LittleFS wrapper header for STM32 project
+ *
+ * The upstream sources in csrc/ include "../lfs.h"; this header forwards
+ * to the official header so the library builds without modification.
+ */
+
+#ifndef __LITTLEFS_LFS_WRAPPER_H__
+#define __LITTLEFS_LFS_WRAPPER_H__
+
+#include "csrc/lfs.h"
+
+#endif /* __LITTLEFS_LFS_WRAPPER_H__ */
@@ -0,0 +1,14 @@
+/**
+ * @file lfs_util.h
+ * @brief LittleFS wrapper header for STM32 project
+ *
+ * The upstream sources in csrc/ include "../lfs_util.h"; this header forwards
+ * to the official header so the library builds without modification.
+ */
+
+#ifndef __LITTLEFS_LFS_UTIL_WRAPPER_H__
+#define __LITTLEFS_LFS_UTIL_WRAPPER_H__
+
+#include "csrc/lfs_util.h"
+
+#endif /* __LITTLEFS_LFS_UTIL_WRAPPER_H__ */
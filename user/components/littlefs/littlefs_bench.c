@@ -0,0 +1,232 @@
+/**
+ * @file littlefs_bench.c
+ * @brief LittleFS workload benchmark
+ */
+
+#include "littlefs_bench.h"
+#include "delay.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_CHUNK 256
+
+static uint8_t chunk[BENCH_CHUNK];
+static uint8_t check[BENCH_CHUNK];
+static uint32_t rng_state;
+
+static uint32_t bench_start(void) {
+    return DWT->CYCCNT;
+}
+
+static uint32_t bench_us(uint32_t start) {
+    return (DWT->CYCCNT - start) / (HAL_RCC_GetHCLKFreq() / 1000000U);
+}
+
+static uint32_t bench_rand(void) {
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return rng_state >> 8;
+}
+
+// Content of byte pos of a file, different per seed
+static void bench_fill(uint8_t *buf, uint32_t pos, uint32_t len, uint8_t seed) {
+    for (uint32_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)((pos + i) * 31U + seed);
+    }
+}
+
+static int bench_seq(lfs_t *fs, const LittleFS_Bench_Params *p, LittleFS_Bench_Result *res) {
+    lfs_file_t file;
+    uint32_t t0, pos, n;
+    int err;
+
+    t0 = bench_start();
+    err = lfs_file_open(fs, &file, "seq.bin", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    if (err) return err;
+    for (pos = 0; pos < p->seq_size; pos += n) {
+        n = (p->seq_size - pos < BENCH_CHUNK) ? p->seq_size - pos : BENCH_CHUNK;
+        bench_fill(chunk, pos, n, 1);
+        if (lfs_file_write(fs, &file, chunk, n) != (lfs_ssize_t)n) {
+            lfs_file_close(fs, &file);
+            return LFS_ERR_IO;
+        }
+    }
+    err = lfs_file_close(fs, &file);
+    if (err) return err;
+    res->seq_write_us = bench_us(t0);
+
+    t0 = bench_start();
+    err = lfs_file_open(fs, &file, "seq.bin", LFS_O_RDONLY);
+    if (err) return err;
+    for (pos = 0; pos < p->seq_size; pos += n) {
+        n = (p->seq_size - pos < BENCH_CHUNK) ? p->seq_size - pos : BENCH_CHUNK;
+        if (lfs_file_read(fs, &file, chunk, n) != (lfs_ssize_t)n) {
+            lfs_file_close(fs, &file);
+            return LFS_ERR_IO;
+        }
+        bench_fill(check, pos, n, 1);
+        if (memcmp(chunk, check, n) != 0) {
+            lfs_file_close(fs, &file);
+            return LFS_ERR_CORRUPT;
+        }
+    }
+    err = lfs_file_close(fs, &file);
+    res->seq_read_us = bench_us(t0);
+    return err;
+}
+
+static int bench_random(lfs_t *fs, const LittleFS_Bench_Params *p, LittleFS_Bench_Result *res) {
+    lfs_file_t file;
+    uint32_t t0, pos, n, off = 0;
+    int err;
+
+    if (p->rand_size > BENCH_CHUNK || p->rand_size >= p->rand_file_size) return LFS_ERR_INVAL;
+
+    // Untimed: the file to overwrite
+    err = lfs_file_open(fs, &file, "rand.bin", LFS_O_RDWR | LFS_O_CREAT | LFS_O_TRUNC);
+    if (err) return err;
+    for (pos = 0; pos < p->rand_file_size; pos += n) {
+        n = (p->rand_file_size - pos < BENCH_CHUNK) ? p->rand_file_size - pos : BENCH_CHUNK;
+        bench_fill(chunk, pos, n, 2);
+        if (lfs_file_write(fs, &file, chunk, n) != (lfs_ssize_t)n) {
+            lfs_file_close(fs, &file);
+            return LFS_ERR_IO;
+        }
+    }
+    err = lfs_file_sync(fs, &file);
+    if (err) {
+        lfs_file_close(fs, &file);
+        return err;
+    }
+
+    t0 = bench_start();
+    for (uint32_t i = 0; i < p->rand_writes; i++) {
+        off = bench_rand() % (p->rand_file_size - p->rand_size);
+        bench_fill(chunk, off, p->rand_size, (uint8_t)(3 + i));
+        if (lfs_file_seek(fs, &file, off, LFS_SEEK_SET) < 0 ||
+            lfs_file_write(fs, &file, chunk, p->rand_size) != (lfs_ssize_t)p->rand_size ||
+            lfs_file_sync(fs, &file) != 0) {
+            lfs_file_close(fs, &file);
+            return LFS_ERR_IO;
+        }
+    }
+    res->rand_write_us = bench_us(t0);
+
+    // The last record reads back
+    if (p->rand_writes > 0) {
+        if (lfs_file_seek(fs, &file, off, LFS_SEEK_SET) < 0 ||
+            lfs_file_read(fs, &file, check, p->rand_size) != (lfs_ssize_t)p->rand_size ||
+            memcmp(chunk, check, p->rand_size) != 0) {
+            lfs_file_close(fs, &file);
+            return LFS_ERR_CORRUPT;
+        }
+    }
+    return lfs_file_close(fs, &file);
+}
+
+static int bench_log(lfs_t *fs, const LittleFS_Bench_Params *p, LittleFS_Bench_Result *res) {
+    lfs_file_t file;
+    uint32_t t0;
+    int err;
+
+    if (p->log_line_size > BENCH_CHUNK) return LFS_ERR_INVAL;
+
+    t0 = bench_start();
+    err = lfs_file_open(fs, &file, "log.txt", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+    if (err) return err;
+    for (uint32_t i = 0; i < p->log_lines; i++) {
+        bench_fill(chunk, i * p->log_line_size, p->log_line_size, 4);
+        if (lfs_file_write(fs, &file, chunk, p->log_line_size) != (lfs_ssize_t)p->log_line_size ||
+            lfs_file_sync(fs, &file) != 0) {
+            lfs_file_close(fs, &file);
+            return LFS_ERR_IO;
+        }
+    }
+    err = lfs_file_close(fs, &file);
+    res->log_us = bench_us(t0);
+    return err;
+}
+
+static int bench_dir(lfs_t *fs, const LittleFS_Bench_Params *p, LittleFS_Bench_Result *res) {
+    struct lfs_info info;
+    lfs_file_t file;
+    lfs_dir_t dir;
+    char name[24];
+    uint32_t t0, entries = 0;
+    int err;
+
+    t0 = bench_start();
+    err = lfs_mkdir(fs, "dir");
+    if (err) return err;
+    for (uint32_t i = 0; i < p->dir_files; i++) {
+        snprintf(name, sizeof(name), "dir/f%04lu.txt", (unsigned long)i);
+        bench_fill(chunk, 0, 16, (uint8_t)i);
+        err = lfs_file_open(fs, &file, name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+        if (err) return err;
+        if (lfs_file_write(fs, &file, chunk, 16) != 16) {
+            lfs_file_close(fs, &file);
+            return LFS_ERR_IO;
+        }
+        err = lfs_file_close(fs, &file);
+        if (err) return err;
+    }
+    res->dir_create_us = bench_us(t0);
+
+    t0 = bench_start();
+    err = lfs_dir_open(fs, &dir, "dir");
+    if (err) return err;
+    while (lfs_dir_read(fs, &dir, &info) > 0) entries++;
+    err = lfs_dir_close(fs, &dir);
+    res->dir_list_us = bench_us(t0);
+
+    if (err) return err;
+    return (entries == p->dir_files + 2) ? LFS_ERR_OK : LFS_ERR_CORRUPT;   // "." and ".."
+}
+
+int LittleFS_Bench_Run(lfs_t *fs, const struct lfs_config *cfg, const LittleFS_Bench_Params *params,
+                       LittleFS_Bench_Result *res) {
+    static const LittleFS_Bench_Params defaults = LFS_BENCH_PARAMS_DEFAULT;
+    const LittleFS_Bench_Params *p = params ? params : &defaults;
+    uint32_t t0;
+    int err;
+
+    memset(res, 0, sizeof(*res));
+    res->seq_size = p->seq_size;
+    res->rand_writes = p->rand_writes;
+    res->log_lines = p->log_lines;
+    rng_state = 12345;
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0) {
+        Delay_Init();
+    }
+
+    t0 = bench_start();
+    err = lfs_format(fs, cfg);
+    res->format_us = bench_us(t0);
+    if (err) return err;
+
+    err = lfs_mount(fs, cfg);
+    if (err) return err;
+
+    err = bench_seq(fs, p, res);
+    if (!err) err = bench_random(fs, p, res);
+    if (!err) err = bench_log(fs, p, res);
+    if (!err) err = bench_dir(fs, p, res);
+    lfs_unmount(fs);
+    if (err) return err;
+
+    // Mount of a filesystem that has seen all of the above
+    t0 = bench_start();
+    err = lfs_mount(fs, cfg);
+    res->mount_us = bench_us(t0);
+    if (err) return err;
+    return lfs_unmount(fs);
+}
+
+void LittleFS_Bench_Print(const char *label, const LittleFS_Bench_Result *res) {
+    printf("BENCH %-26s mount %6.1f ms  seq W %6.1f R %7.1f KB/s  rand %6.2f ms/op  log %6.2f ms/line  dir create %7.1f list %6.1f ms\n",
+           label, res->mount_us / 1000.0,
+           res->seq_write_us ? res->seq_size * 1000000.0 / 1024.0 / res->seq_write_us : 0.0,
+           res->seq_read_us ? res->seq_size * 1000000.0 / 1024.0 / res->seq_read_us : 0.0,
+           res->rand_writes ? res->rand_write_us / 1000.0 / res->rand_writes : 0.0,
+           res->log_lines ? res->log_us / 1000.0 / res->log_lines : 0.0,
+           res->dir_create_us / 1000.0, res->dir_list_us / 1000.0);
+}
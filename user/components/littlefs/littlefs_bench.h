@@ -0,0 +1,76 @@
+/**
+ * @file littlefs_bench.h
+ * @brief LittleFS workload benchmark: mount, sequential I/O, random small
+ *        writes, append logging and directory listing
+ *
+ * Works on any lfs_config (the W25Q port, a partition or littlefs_rambd).
+ * Time is taken from the DWT cycle counter, so each phase must finish
+ * within one CYCCNT period (~59 s at 72 MHz).
+ *
+ * Usage:
+ *      LittleFS_Bench_Result res;
+ *      if (LittleFS_Bench_Run(&fs, &bd_cfg, NULL, &res) == 0) {
+ *          LittleFS_Bench_Print("w25q cache 256", &res);
+ *      }
+ *
+ * The filesystem is formatted first: never point it at data you want to keep.
+ */
+
+#ifndef LITTLEFS_BENCH_H
+#define LITTLEFS_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include "lfs.h"
+
+typedef struct {
+    uint32_t seq_size;          // Bytes written then read back in one file
+    uint32_t rand_file_size;    // File the random writes land in
+    uint32_t rand_writes;       // Overwrites of rand_size bytes, synced each
+    uint32_t rand_size;
+    uint32_t log_lines;         // Appends of log_line_size bytes, synced each
+    uint32_t log_line_size;
+    uint32_t dir_files;         // Files created, then listed
+} LittleFS_Bench_Params;
+
+#define LFS_BENCH_PARAMS_DEFAULT { \
+    .seq_size = 64 * 1024, .rand_file_size = 16 * 1024, .rand_writes = 64, .rand_size = 32, \
+    .log_lines = 200, .log_line_size = 48, .dir_files = 32, \
+}
+
+// Times in microseconds
+typedef struct {
+    uint32_t format_us;
+    uint32_t mount_us;          // Mount of the filled filesystem at the end
+    uint32_t seq_write_us;
+    uint32_t seq_read_us;
+    uint32_t rand_write_us;     // All random writes
+    uint32_t log_us;            // All appends
+    uint32_t dir_create_us;
+    uint32_t dir_list_us;
+    uint32_t seq_size;          // Copied from the params for the KB/s figures
+    uint32_t rand_writes;
+    uint32_t log_lines;
+} LittleFS_Bench_Result;
+
+/**
+ * @brief Format, mount, run every phase and unmount
+ * @param params NULL = LFS_BENCH_PARAMS_DEFAULT
+ * @return 0 on success, <0 lfs error, LFS_ERR_CORRUPT if data read back wrong
+ */
+int LittleFS_Bench_Run(lfs_t *fs, const struct lfs_config *cfg, const LittleFS_Bench_Params *params,
+                       LittleFS_Bench_Result *res);
+
+/**
+ * @brief printf one line of results
+ */
+void LittleFS_Bench_Print(const char *label, const LittleFS_Bench_Result *res);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
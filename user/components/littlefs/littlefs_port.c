@@ -1,106 +1,464 @@
 /**
  * @file littlefs_port.c
- * @brief LittleFS Port Implementation for W25Qxx
+ * @brief LittleFS Port Implementation on a Block_Device (W25Qxx, SFUD, ...)
  */
 
-#include "../littlefs_port.h"
+#include "littlefs_port.h"
 #include <string.h>
 
 // Global LFS instances
 lfs_t lfs;
 struct lfs_config cfg;
+LittleFS_Port_Stats lfs_port_stats;
+
+// State of the whole-chip filesystem
+static LittleFS_Port_Dev default_dev;
+
+// Mounted partitions
+static LittleFS_Partition *partitions;
+
+static uint8_t cache_enabled = 1;
+
+#define DEV(c)          ((LittleFS_Port_Dev *)(c)->context)
+#define ADDR(c, b, o)   (DEV(c)->base + ((b) * (c)->block_size) + (o))
+
+/*
+ * Read cache and write-back buffer
+ */
+
+// Program whatever is pending in the write-back buffer
+static int lfs_port_flush(const struct lfs_config *c) {
+    LittleFS_Port_Dev *dev = DEV(c);
+    int err;
+
+    if (dev->prog_len == 0) return LFS_ERR_OK;
+
+    err = BlockDev_Prog(dev->bd, ADDR(c, dev->prog_block, dev->prog_off), dev->prog_buf, dev->prog_len);
+    dev->prog_len = 0;
+    dev->stats->flushes++;
+    return err ? LFS_ERR_IO : LFS_ERR_OK;
+}
+
+// Pending data in [off, off + size) of block has to reach the flash first
+static int lfs_port_flush_overlap(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, lfs_size_t size) {
+    LittleFS_Port_Dev *dev = DEV(c);
+
+    if (dev->prog_len > 0 && dev->prog_block == block &&
+        off < dev->prog_off + dev->prog_len && dev->prog_off < off + size) {
+        return lfs_port_flush(c);
+    }
+    return LFS_ERR_OK;
+}
+
+#if LFS_PORT_CACHE_LINES > 0
+// Keep cached copies in step with a program (NOR programs only go into erased space)
+static void lfs_port_cache_update(LittleFS_Port_Dev *dev, lfs_block_t block, lfs_off_t off, const uint8_t *data, lfs_size_t size) {
+    for (int i = 0; i < dev->cache_lines; i++) {
+        lfs_off_t start, end, line_off = dev->lines[i].off;
+
+        if (dev->lines[i].used == 0 || dev->lines[i].block != block) continue;
+        start = (off > line_off) ? off : line_off;
+        end = off + size;
+        if (end > line_off + LFS_PORT_CACHE_LINE_SIZE) end = line_off + LFS_PORT_CACHE_LINE_SIZE;
+        if (start < end) {
+            memcpy(&dev->line_data[i][start - line_off], &data[start - off], end - start);
+        }
+    }
+}
+
+// Cached lines of an erased block read back as erased without touching the flash
+static void lfs_port_cache_erase(LittleFS_Port_Dev *dev, lfs_block_t block) {
+    for (int i = 0; i < dev->cache_lines; i++) {
+        if (dev->lines[i].used != 0 && dev->lines[i].block == block) {
+            memset(dev->line_data[i], dev->bd->erase_value, LFS_PORT_CACHE_LINE_SIZE);
+        }
+    }
+}
+
+static int lfs_port_cache_find(const LittleFS_Port_Dev *dev, lfs_block_t block, lfs_off_t line_off) {
+    for (int i = 0; i < dev->cache_lines; i++) {
+        if (dev->lines[i].used != 0 && dev->lines[i].block == block && dev->lines[i].off == line_off) return i;
+    }
+    return -1;
+}
+
+// The line where [off, ...) starts is cached
+static int lfs_port_cache_holds(const LittleFS_Port_Dev *dev, lfs_block_t block, lfs_off_t off) {
+    return lfs_port_cache_find(dev, block, off - (off % LFS_PORT_CACHE_LINE_SIZE)) >= 0;
+}
+
+// Find the line holding block/off, filling the least recently used one on a miss
+static uint8_t *lfs_port_cache_line(const struct lfs_config *c, lfs_block_t block, lfs_off_t line_off) {
+    LittleFS_Port_Dev *dev = DEV(c);
+    int victim = lfs_port_cache_find(dev, block, line_off);
+
+    if (victim >= 0) {
+        dev->lines[victim].used = ++dev->line_clock;
+        dev->stats->hits++;
+        return dev->line_data[victim];
+    }
+
+    victim = 0;
+    for (int i = 1; i < dev->cache_lines; i++) {
+        if (dev->lines[i].used < dev->lines[victim].used) victim = i;
+    }
+
+    // Lines never cross the end of a block
+    if (lfs_port_flush_overlap(c, block, line_off, LFS_PORT_CACHE_LINE_SIZE) ||
+        BlockDev_Read(dev->bd, ADDR(c, block, line_off), dev->line_data[victim], LFS_PORT_CACHE_LINE_SIZE)) {
+        dev->lines[victim].used = 0;
+        return NULL;
+    }
+    dev->lines[victim].block = block;
+    dev->lines[victim].off = line_off;
+    dev->lines[victim].used = ++dev->line_clock;
+    dev->stats->misses++;
+    return dev->line_data[victim];
+}
+#endif
+
+static void lfs_port_cache_clear(LittleFS_Port_Dev *dev) {
+    memset(dev->lines, 0, sizeof(dev->lines));
+    dev->line_clock = 0;
+    dev->prog_len = 0;
+}
 
 /* 
  * Wrapper functions that match lfs interface 
  */
 
 // Read: Read 'size' bytes from 'block' + 'off'
-int lfs_w25q_read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size) {
-    uint32_t addr = (block * c->block_size) + off;
+static int lfs_port_read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size) {
+    LittleFS_Port_Dev *dev = DEV(c);
+    uint32_t addr = ADDR(c, block, off);
     
     // Check bounds
-    if (addr + size > (c->block_count * c->block_size)) {
+    if ((block * c->block_size) + off + size > (c->block_count * c->block_size)) {
         return LFS_ERR_IO;
     }
 
-    // Call W25Q driver
-    // Note: W25QXX_Read usually takes (Handler, Buffer, Address, Length)
-    W25QXX_Read(&w25qxx_handle, (uint8_t*)buffer, addr, size);
-    
-    return LFS_ERR_OK;
+    dev->stats->reads++;
+
+#if LFS_PORT_CACHE_LINES > 0
+    // Reads smaller than a line fill whole lines (read-ahead for the tag and
+    // metadata reads that follow). Line-sized reads are littlefs refilling
+    // its own cache: they go through the lines only when they continue one
+    // that is cached, so a cold sequential scan does not flush the cache.
+    if (dev->cached && dev->cache_lines > 0 && (c->block_size % LFS_PORT_CACHE_LINE_SIZE) == 0 &&
+        (size < LFS_PORT_CACHE_LINE_SIZE ||
+         (size == LFS_PORT_CACHE_LINE_SIZE && lfs_port_cache_holds(dev, block, off)))) {
+        uint8_t *dst = (uint8_t *)buffer;
+
+        while (size > 0) {
+            lfs_off_t line_off = off - (off % LFS_PORT_CACHE_LINE_SIZE);
+            lfs_size_t n = LFS_PORT_CACHE_LINE_SIZE - (off - line_off);
+            if (n > size) n = size;
+
+            const uint8_t *line = lfs_port_cache_line(c, block, line_off);
+
+            if (line == NULL) return LFS_ERR_IO;
+            memcpy(dst, &line[off - line_off], n);
+            dst += n;
+            off += n;
+            size -= n;
+        }
+        return LFS_ERR_OK;
+    }
+#endif
+
+    if (lfs_port_flush_overlap(c, block, off, size)) {
+        return LFS_ERR_IO;
+    }
+    dev->stats->direct++;
+
+    return BlockDev_Read(dev->bd, addr, buffer, size) ? LFS_ERR_IO : LFS_ERR_OK;
 }
 
 // Prog: Program 'size' bytes. 
 // LittleFS guarantees that 'size' is a multiple of 'prog_size' (256) 
 // and that 'off' is aligned.
-int lfs_w25q_prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size) {
-    uint32_t addr = (block * c->block_size) + off;
+static int lfs_port_prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size) {
+    LittleFS_Port_Dev *dev = DEV(c);
+    uint32_t addr = ADDR(c, block, off);
+
+    dev->stats->progs++;
+
+#if LFS_PORT_CACHE_LINES > 0
+    lfs_port_cache_update(dev, block, off, (const uint8_t *)buffer, size);
+#endif
+
+    if (!dev->cached || size > sizeof(dev->prog_buf)) {
+        if (lfs_port_flush(c)) return LFS_ERR_IO;
+        return BlockDev_Prog(dev->bd, addr, buffer, size) ? LFS_ERR_IO : LFS_ERR_OK;
+    }
 
-    // Call W25Q driver
-    W25QXX_Write(&w25qxx_handle, (uint8_t*)buffer, addr, size);
+    // Append to the pending run, or start a new one
+    if (dev->prog_len > 0 && (dev->prog_block != block || dev->prog_off + dev->prog_len != off ||
+                              dev->prog_len + size > sizeof(dev->prog_buf))) {
+        if (lfs_port_flush(c)) return LFS_ERR_IO;
+    }
+    if (dev->prog_len == 0) {
+        dev->prog_block = block;
+        dev->prog_off = off;
+    }
+    memcpy(&dev->prog_buf[dev->prog_len], buffer, size);
+    dev->prog_len += size;
 
     return LFS_ERR_OK;
 }
 
-// Erase: Erase a block. W25Q Sector Erase (4KB)
-int lfs_w25q_erase(const struct lfs_config *c, lfs_block_t block) {
-    uint32_t addr = block * c->block_size;
+// Erase: Erase a block. The device picks its erase command: on W25Q a
+// Sector Erase (4KB), or one Block Erase (64KB) for partitions with large blocks
+static int lfs_port_erase(const struct lfs_config *c, lfs_block_t block) {
+    LittleFS_Port_Dev *dev = DEV(c);
+    uint32_t addr = ADDR(c, block, 0);
     
-    W25QXX_Erase_Sector(&w25qxx_handle, addr);
+    dev->stats->erases++;
+
+    // Programs into a block that is about to be erased are moot
+    if (dev->prog_len > 0 && dev->prog_block == block) {
+        dev->prog_len = 0;
+    }
+    if (lfs_port_flush(c) || BlockDev_Erase(dev->bd, addr, c->block_size)) {
+        return LFS_ERR_IO;
+    }
+
+#if LFS_PORT_CACHE_LINES > 0
+    // Devices without an erase (SD) keep their data, and so do the lines
+    if (dev->bd->erase_size != 0) {
+        lfs_port_cache_erase(dev, block);
+    }
+#endif
     
     return LFS_ERR_OK;
 }
 
-// Sync: Ensure data is on media. W25QXX_Write is usually blocking until write complete.
-// If you use DMA/ISR, you might need to wait here.
-int lfs_w25q_sync(const struct lfs_config *c) {
+// Sync: Ensure data is on media. Pending programs are written here;
+// W25QXX_Write blocks until the last page is programmed.
+static int lfs_port_sync(const struct lfs_config *c) {
+    DEV(c)->stats->syncs++;
+    if (lfs_port_flush(c) || BlockDev_Sync(DEV(c)->bd)) {
+        return LFS_ERR_IO;
+    }
     return LFS_ERR_OK;
 }
 
 
-int LittleFS_Port_Init(void) {
-    // 1. Ensure W25Q driver is initialized (User should have done this)
-    // We can assume w25qxx_handle.Info is valid if Init was called.
-    
-    // 2. Setup Config
-    memset(&cfg, 0, sizeof(cfg));
-
-    cfg.read  = lfs_w25q_read;
-    cfg.prog  = lfs_w25q_prog;
-    cfg.erase = lfs_w25q_erase;
-    cfg.sync  = lfs_w25q_sync;
-
-    // Attributes for W25Q64 / Q128 etc.
-    // Ideally we use info from handle
-    cfg.read_size = 1;        // Can read 1 byte
-    cfg.prog_size = 256;      // Page size
-    cfg.block_size = 4096;    // Sector size (Erase granulariry)
-    
-    if (w25qxx_handle.Info.SectorCount > 0) {
-        cfg.block_count = w25qxx_handle.Info.SectorCount;
-    } else {
-        // Fallback defaults if not inited properly (dangerous)
-        cfg.block_count = 2048; // Assume 8MB (2048 * 4KB)
+void LittleFS_Port_SetCache(uint8_t enable) {
+    cache_enabled = enable ? 1 : 0;
+}
+
+
+int LittleFS_Port_GeometryFromW25Q(const W25QXX_HandleTypeDef *hflash, LittleFS_Port_Geometry *geo) {
+    // W25QXX_Init leaves SectorCount at 0 for a chip it does not know
+    if (hflash->Info.SectorCount == 0 || hflash->Info.SectorSize == 0) {
+        return LFS_ERR_INVAL;
+    }
+
+    geo->capacity = hflash->Info.SectorCount * hflash->Info.SectorSize;
+    geo->prog_size = hflash->Info.PageSize;
+    geo->sector_size = hflash->Info.SectorSize;
+    geo->block_size = hflash->Info.BlockSize;
+    return LFS_ERR_OK;
+}
+
+int LittleFS_Port_GeometryFromBD(const Block_Device *bd, LittleFS_Port_Geometry *geo) {
+    if (bd->capacity == 0 || bd->prog_size == 0) {
+        return LFS_ERR_INVAL;
+    }
+
+    geo->capacity = bd->capacity;
+    geo->prog_size = bd->prog_size;
+    geo->sector_size = bd->erase_size ? bd->erase_size : LFS_PORT_NO_ERASE_BLOCK;
+    geo->block_size = bd->block_size;
+    return LFS_ERR_OK;
+}
+
+// Fill the lfs_config of one filesystem: blocks of block_size starting at dev->base
+static int lfs_port_config(struct lfs_config *c, LittleFS_Port_Dev *dev, const LittleFS_Port_Geometry *geo,
+                           uint32_t block_size, uint32_t size, const LittleFS_Partition_Config *conf) {
+    memset(c, 0, sizeof(*c));
+    lfs_port_cache_clear(dev);
+
+    c->context = dev;
+    c->read  = lfs_port_read;
+    c->prog  = lfs_port_prog;
+    c->erase = lfs_port_erase;
+    c->sync  = lfs_port_sync;
+
+    dev->cached = cache_enabled;
+    dev->cache_lines = LFS_PORT_CACHE_LINES;
+    if (conf->cache_lines > 0 && conf->cache_lines < LFS_PORT_CACHE_LINES) {
+        dev->cache_lines = conf->cache_lines;
+    }
+    // Lines are filled with one read each, so they have to be whole read units
+    if (LFS_PORT_CACHE_LINE_SIZE % dev->bd->read_size != 0) {
+        dev->cache_lines = 0;
+    }
+
+    c->read_size = 1;         // Can read 1 byte
+    if (dev->cached) {
+        // littlefs rounds its own reads to this, so a 4-byte tag read pulls in
+        // its neighbours (tuned on the host simulator with 8 x 256 lines)
+        c->read_size = 32;
+    }
+    if (c->read_size < dev->bd->read_size) {
+        c->read_size = dev->bd->read_size;
     }
+    c->prog_size = geo->prog_size;
+    c->block_size = block_size;
+    c->block_count = size / block_size;
 
-    cfg.cache_size = 256;         // Read cache (Must be >= prog_size if prog_size > 1? No, cache should be >= read_size)
-                                  // Recommendations: cache_size = prog_size usually good.
-    cfg.lookahead_size = 256;     // Bitmask for free blocks lookahead (RAM usage)
-    cfg.block_cycles = 500;       // Wear leveling metadata logic
+    // littlefs cache: one page unless the partition asks for more (larger
+    // helps sequential file reads, costs RAM x (open files + 2))
+    c->cache_size = conf->cache_size ? conf->cache_size : geo->prog_size;
+    c->lookahead_size = conf->lookahead_size ? conf->lookahead_size : LFS_PORT_DEFAULT_LOOKAHEAD;
+    c->block_cycles = conf->block_cycles ? conf->block_cycles : LFS_PORT_DEFAULT_BLOCK_CYCLES;
 
+    if (c->block_count < 2 || (c->cache_size % c->prog_size) != 0 || (c->cache_size % c->read_size) != 0 ||
+        (block_size % c->cache_size) != 0 || (c->lookahead_size % 8) != 0) {
+        return LFS_ERR_INVAL;
+    }
+
+    // Metadata pairs are whole blocks: with 64 KB blocks a compaction would
+    // read and rewrite 64 KB, so keep the metadata log to one sector
+    if (block_size > geo->sector_size) {
+        c->metadata_max = geo->sector_size;
+    }
+    return LFS_ERR_OK;
+}
+
+static int lfs_port_mount(lfs_t *fs, const struct lfs_config *c) {
     // 3. Mount
-    int err = lfs_mount(&lfs, &cfg);
+    int err = lfs_mount(fs, c);
     
     // 4. Reformat if needed
     if (err) {
         // If mount failed, it might be first run. Format.
-        lfs_format(&lfs, &cfg);
-        err = lfs_mount(&lfs, &cfg);
+        lfs_format(fs, c);
+        err = lfs_mount(fs, c);
     }
     
     return err;
 }
 
+int LittleFS_Port_Init(void) {
+    static const LittleFS_Partition_Config whole_chip = {0};
+    LittleFS_Port_Geometry geo;
+    int err;
+
+    // 1. Ensure W25Q driver is initialized (User should have done this)
+    err = LittleFS_Port_GeometryFromW25Q(&w25qxx_handle, &geo);
+    if (err || W25QXX_BlockDev(&default_dev.own_bd, &w25qxx_handle)) {
+        return LFS_ERR_INVAL;
+    }
+
+    // 2. Setup Config: the whole chip in sectors
+    default_dev.bd = &default_dev.own_bd;
+    default_dev.base = 0;
+    default_dev.stats = &lfs_port_stats;
+    err = lfs_port_config(&cfg, &default_dev, &geo, geo.sector_size, geo.capacity, &whole_chip);
+    if (err) {
+        return err;
+    }
+
+    return lfs_port_mount(&lfs, &cfg);
+}
+
 void LittleFS_Port_DeInit(void) {
     lfs_unmount(&lfs);
+    lfs_port_flush(&cfg);
+}
+
+/*
+ * Partitions
+ */
+
+static int lfs_port_partition_mount(LittleFS_Partition *part, Block_Device *bd,
+                                    const LittleFS_Port_Geometry *geo, const LittleFS_Partition_Config *conf) {
+    uint32_t erase_size = geo->sector_size;
+    uint32_t size = conf->size;
+    int err;
+
+    if (conf->large_blocks) {
+        if (geo->block_size == 0) return LFS_ERR_INVAL;
+        erase_size = geo->block_size;
+    }
+    if (size == 0 && conf->offset < geo->capacity) {
+        size = geo->capacity - conf->offset;
+    }
+
+    // The range has to be whole erase units on the chip
+    if (size == 0 || conf->offset % erase_size != 0 || size % erase_size != 0 ||
+        conf->offset > geo->capacity || size > geo->capacity - conf->offset) {
+        return LFS_ERR_INVAL;
+    }
+
+    // ... and must not overlap another mounted partition on the same chip
+    for (LittleFS_Partition *p = partitions; p != NULL; p = p->next) {
+        uint32_t p_size = p->cfg.block_count * p->cfg.block_size;
+
+        if (p == part) return LFS_ERR_INVAL;    // Already mounted
+        if (p->dev.bd->ctx == bd->ctx && conf->offset < p->dev.base + p_size && p->dev.base < conf->offset + size) {
+            return LFS_ERR_INVAL;
+        }
+    }
+
+    memset(&part->stats, 0, sizeof(part->stats));
+    part->name = conf->name;
+    part->dev.bd = bd;
+    part->dev.base = conf->offset;
+    part->dev.stats = &part->stats;
+
+    err = lfs_port_config(&part->cfg, &part->dev, geo, erase_size, size, conf);
+    if (err) {
+        return err;
+    }
+
+    err = lfs_port_mount(&part->lfs, &part->cfg);
+    if (err) {
+        return err;
+    }
+
+    part->next = partitions;
+    partitions = part;
+    return LFS_ERR_OK;
+}
+
+int LittleFS_Partition_Mount(LittleFS_Partition *part, W25QXX_HandleTypeDef *hflash,
+                             const LittleFS_Port_Geometry *geo, const LittleFS_Partition_Config *conf) {
+    if (W25QXX_BlockDev(&part->dev.own_bd, hflash)) {
+        return LFS_ERR_INVAL;
+    }
+    return lfs_port_partition_mount(part, &part->dev.own_bd, geo, conf);
+}
+
+int LittleFS_Partition_MountBD(LittleFS_Partition *part, Block_Device *bd, const LittleFS_Partition_Config *conf) {
+    LittleFS_Port_Geometry geo;
+
+    if (LittleFS_Port_GeometryFromBD(bd, &geo)) {
+        return LFS_ERR_INVAL;
+    }
+    return lfs_port_partition_mount(part, bd, &geo, conf);
+}
+
+void LittleFS_Partition_Unmount(LittleFS_Partition *part) {
+    LittleFS_Partition **pp;
+
+    for (pp = &partitions; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == part) {
+            *pp = part->next;
+            lfs_unmount(&part->lfs);
+            lfs_port_flush(&part->cfg);
+            part->next = NULL;
+            return;
+        }
+    }
+}
+
+LittleFS_Partition *LittleFS_Partition_Find(const char *name) {
+    for (LittleFS_Partition *p = partitions; p != NULL; p = p->next) {
+        if (p->name != NULL && strcmp(p->name, name) == 0) return p;
+    }
+    return NULL;
 }
@@ -1,6 +1,36 @@
 /**
  * @file littlefs_port.h
- * @brief LittleFS Port for W25Qxx SPI Flash
+ * @brief LittleFS Port for SPI Flash (W25Qxx, SFUD) and other block devices
+ *
+ * Three ways to use it:
+ *
+ * 1. One filesystem on the whole chip (global lfs/cfg):
+ *      W25QXX_Init(&w25qxx_handle, &hspi1, GPIOA, GPIO_PIN_4);
+ *      LittleFS_Port_Init();
+ *      lfs_file_open(&lfs, &file, "boot_count", LFS_O_RDWR | LFS_O_CREAT);
+ *
+ * 2. Several partitions on one chip, each with its own lfs instance and
+ *    tuning. Geometry comes from the driver (W25QXX Info, or SFUD/SFDP with
+ *    littlefs_sfud.h):
+ *      static LittleFS_Partition log_part, asset_part;
+ *      static const LittleFS_Partition_Config log_conf = {
+ *          .name = "log", .offset = 0, .size = 1024 * 1024,
+ *          .block_cycles = 100,                   // high churn: level often
+ *      };
+ *      static const LittleFS_Partition_Config asset_conf = {
+ *          .name = "assets", .offset = 1024 * 1024, .size = 0,   // rest of chip
+ *          .large_blocks = 1, .cache_size = 1024, // 64 KB erase, big reads
+ *      };
+ *      LittleFS_Port_Geometry geo;
+ *      LittleFS_Port_GeometryFromW25Q(&w25qxx_handle, &geo);
+ *      LittleFS_Partition_Mount(&log_part, &w25qxx_handle, &geo, &log_conf);
+ *      LittleFS_Partition_Mount(&asset_part, &w25qxx_handle, &geo, &asset_conf);
+ *      lfs_file_open(&log_part.lfs, &file, "today.log", LFS_O_WRONLY | LFS_O_APPEND);
+ *
+ * 3. Partitions on any Block_Device (block_dev.h), e.g. a second chip
+ *    driven by SFUD on another bus; geometry comes from the device:
+ *      SFUD_Port_BlockDev(&data_bd, &data_flash);
+ *      LittleFS_Partition_MountBD(&data_part, &data_bd, &data_conf);
  */
 
 #ifndef LITTLEFS_PORT_H
@@ -13,17 +43,112 @@ extern "C" {
 #include "main.h"
 #include "lfs.h"
 #include "w25qxx.h"
+#include "block_dev.h"
 
 // --- Configuration ---
 // Define the W25Qxx handle that LittleFS should use.
 // You must initialize this handle in your main code before mounting LFS.
-extern W25QXX_HandleTypeDef w25qxx_handle; 
+extern W25QXX_HandleTypeDef w25qxx_handle;
+
+// Read cache between littlefs and the flash: LFS_PORT_CACHE_LINES lines of
+// LFS_PORT_CACHE_LINE_SIZE bytes (aligned within a block, LRU replaced).
+// A miss fetches the whole line in one SPI transaction, so the many small
+// tag and metadata reads of a mount or directory scan become a few line
+// fills. RAM = LINES * LINE_SIZE per filesystem. Set LINES to 0 to remove
+// the cache.
+#ifndef LFS_PORT_CACHE_LINES
+#define LFS_PORT_CACHE_LINES 8
+#endif
+
+#ifndef LFS_PORT_CACHE_LINE_SIZE
+#define LFS_PORT_CACHE_LINE_SIZE 256
+#endif
+
+// Write-back buffer: contiguous programs are collected here and written
+// when littlefs calls sync (or when a read, erase or non-contiguous program
+// needs the flash to be up to date). Must be a multiple of 256 (page size).
+#ifndef LFS_PORT_PROG_BUFFER_SIZE
+#define LFS_PORT_PROG_BUFFER_SIZE 512
+#endif
+
+// littlefs block on devices without an erase (SD cards)
+#define LFS_PORT_NO_ERASE_BLOCK 4096
+
+// Defaults for partition settings left at 0
+#define LFS_PORT_DEFAULT_BLOCK_CYCLES   500
+#define LFS_PORT_DEFAULT_LOOKAHEAD      256
+
+typedef struct {
+    uint32_t reads;         // read callbacks from littlefs
+    uint32_t hits;          // cache lines served from RAM
+    uint32_t misses;        // cache line fills (one flash read each)
+    uint32_t direct;        // reads done straight from flash (large or cache off)
+    uint32_t progs;         // prog callbacks
+    uint32_t flushes;       // write-back buffer programs
+    uint32_t erases;
+    uint32_t syncs;
+} LittleFS_Port_Stats;
+
+// Flash geometry partitions are laid out on
+typedef struct {
+    uint32_t capacity;      // Bytes
+    uint32_t prog_size;     // Page program size
+    uint32_t sector_size;   // Smallest erase (4 KB on W25Q)
+    uint32_t block_size;    // 64 KB erase, 0 if the chip has none
+} LittleFS_Port_Geometry;
+
+typedef struct {
+    const char *name;
+    uint32_t    offset;         // Byte offset on the chip, multiple of the erase size used
+    uint32_t    size;           // Bytes, 0 = up to the end of the chip
+    uint8_t     large_blocks;   // 1: littlefs blocks of the device's block_size (64 KB), one erase each
+    uint8_t     cache_lines;    // Port read cache lines, 0 = LFS_PORT_CACHE_LINES
+    int32_t     block_cycles;   // Wear leveling, 0 = default, -1 = off
+    uint32_t    cache_size;     // littlefs cache, 0 = page size
+    uint32_t    lookahead_size; // Allocator bitmap bytes, 0 = default
+} LittleFS_Partition_Config;
+
+// Per-filesystem port state, reached through lfs_config.context
+typedef struct {
+    Block_Device *bd;
+    Block_Device own_bd;        // Set up from the W25QXX handle by the W25QXX entry points
+    uint32_t    base;           // Chip address of block 0
+    uint8_t     cached;
+    uint8_t     cache_lines;
+    LittleFS_Port_Stats *stats;
+
+    // Read cache
+    struct {
+        lfs_block_t block;
+        lfs_off_t   off;        // Line start within the block
+        uint32_t    used;       // LRU stamp, 0 = empty
+    } lines[LFS_PORT_CACHE_LINES > 0 ? LFS_PORT_CACHE_LINES : 1];
+    uint8_t     line_data[LFS_PORT_CACHE_LINES > 0 ? LFS_PORT_CACHE_LINES : 1][LFS_PORT_CACHE_LINE_SIZE];
+    uint32_t    line_clock;
+
+    // Write-back buffer
+    uint8_t     prog_buf[LFS_PORT_PROG_BUFFER_SIZE];
+    lfs_block_t prog_block;
+    lfs_off_t   prog_off;
+    lfs_size_t  prog_len;       // 0 = nothing pending
+} LittleFS_Port_Dev;
+
+typedef struct LittleFS_Partition {
+    const char          *name;
+    lfs_t                lfs;   // Use with the lfs_xxx API
+    struct lfs_config    cfg;
+    LittleFS_Port_Dev    dev;
+    LittleFS_Port_Stats  stats;
+    struct LittleFS_Partition *next;
+} LittleFS_Partition;
 
 /**
  * @brief Initialize the LittleFS configuration structure
  *        and Mount the filesystem.
  *        If mount fails (corrupt/first time), it will format and remount.
- * @return 0 on success, <0 on error
+ * @note  Geometry comes from w25qxx_handle.Info, so W25QXX_Init must have
+ *        identified the chip.
+ * @return 0 on success, <0 on error (LFS_ERR_INVAL for an unknown chip)
  */
 int LittleFS_Port_Init(void);
 
@@ -32,9 +157,59 @@ int LittleFS_Port_Init(void);
  */
 void LittleFS_Port_DeInit(void);
 
+/**
+ * @brief Turn the read cache and write-back buffer on or off (default on)
+ * @note  Applies to filesystems mounted afterwards. Off gives the plain
+ *        pass-through port (read_size 1, every callback straight to the
+ *        flash), which is useful to compare against or to debug.
+ */
+void LittleFS_Port_SetCache(uint8_t enable);
+
+/**
+ * @brief Fill geo from an initialized W25QXX handle
+ * @return 0 on success, LFS_ERR_INVAL if the chip was not identified
+ */
+int LittleFS_Port_GeometryFromW25Q(const W25QXX_HandleTypeDef *hflash, LittleFS_Port_Geometry *geo);
+
+/**
+ * @brief Fill geo from a block device
+ * @note  Devices without an erase get LFS_PORT_NO_ERASE_BLOCK sectors.
+ * @return 0 on success, LFS_ERR_INVAL for an empty device
+ */
+int LittleFS_Port_GeometryFromBD(const Block_Device *bd, LittleFS_Port_Geometry *geo);
+
+/**
+ * @brief Mount a partition, formatting it if it holds no filesystem
+ * @param conf Layout and tuning; must stay valid while mounted (name is kept)
+ * @return 0 on success, LFS_ERR_INVAL for a range that is misaligned, does
+ *         not fit the chip or overlaps a mounted partition, <0 lfs error
+ */
+int LittleFS_Partition_Mount(LittleFS_Partition *part, W25QXX_HandleTypeDef *hflash,
+                             const LittleFS_Port_Geometry *geo, const LittleFS_Partition_Config *conf);
+
+/**
+ * @brief Mount a partition on a block device, geometry taken from bd
+ * @note  Partitions on block devices with the same ctx (the same chip)
+ *        must not overlap.
+ * @return As LittleFS_Partition_Mount
+ */
+int LittleFS_Partition_MountBD(LittleFS_Partition *part, Block_Device *bd, const LittleFS_Partition_Config *conf);
+
+/**
+ * @brief Write back pending programs and unmount
+ */
+void LittleFS_Partition_Unmount(LittleFS_Partition *part);
+
+/**
+ * @brief Look up a mounted partition by name
+ * @return NULL if no partition of that name is mounted
+ */
+LittleFS_Partition *LittleFS_Partition_Find(const char *name);
+
 // Expose the global lfs instance so user code can use lfs_open, lfs_read etc.
 extern lfs_t lfs;
 extern struct lfs_config cfg;
+extern LittleFS_Port_Stats lfs_port_stats;
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,125 @@
+/**
+ * @file littlefs_rambd.c
+ * @brief RAM block device for LittleFS with emulated flash/SD timing
+ */
+
+#include "littlefs_rambd.h"
+#include "delay.h"
+#include <string.h>
+
+const LittleFS_RamBD_Profile lfs_rambd_w25q = {
+    .name = "w25q", .block_size = 4096, .read_size = 1, .prog_size = 256, .erase_value = 0xFF,
+    .read_us = 3, .read_ns_per_byte = 450,
+    .prog_us = 400, .prog_unit = 256, .prog_ns_per_byte = 450,
+    .erase_us = 45000,
+};
+
+const LittleFS_RamBD_Profile lfs_rambd_sd = {
+    .name = "sd", .block_size = 4096, .read_size = 512, .prog_size = 512, .erase_value = -1,
+    .read_us = 250, .read_ns_per_byte = 450,
+    .prog_us = 1000, .prog_unit = 512, .prog_ns_per_byte = 450,
+    .erase_us = 0,
+};
+
+const LittleFS_RamBD_Profile lfs_rambd_ram = {
+    .name = "ram", .block_size = 4096, .read_size = 1, .prog_size = 1, .erase_value = 0xFF,
+};
+
+#define BD(c) ((LittleFS_RamBD *)(c)->context)
+
+// Charge us + ns of device time
+static void rambd_wait(LittleFS_RamBD *bd, uint32_t us, uint64_t ns) {
+    ns += bd->pending_ns;
+    us += (uint32_t)(ns / 1000U);
+    bd->pending_ns = (uint32_t)(ns % 1000U);
+    if (us == 0) return;
+
+    bd->stats.busy_us += us;
+    if (bd->wait_us) {
+        bd->wait_us(us);
+    } else {
+        Delay_us(us);
+    }
+}
+
+static int rambd_read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size) {
+    LittleFS_RamBD *bd = BD(c);
+    const LittleFS_RamBD_Profile *p = bd->profile;
+
+    memcpy(buffer, &bd->buffer[(block * c->block_size) + off], size);
+
+    bd->stats.reads++;
+    bd->stats.read_bytes += size;
+    rambd_wait(bd, p->read_us, (uint64_t)size * p->read_ns_per_byte);
+    return LFS_ERR_OK;
+}
+
+static int rambd_prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size) {
+    LittleFS_RamBD *bd = BD(c);
+    const LittleFS_RamBD_Profile *p = bd->profile;
+    uint8_t *dst = &bd->buffer[(block * c->block_size) + off];
+    const uint8_t *src = (const uint8_t *)buffer;
+    uint32_t units = p->prog_unit ? (size + p->prog_unit - 1) / p->prog_unit : 0;
+
+    if (p->erase_value >= 0) {
+        // NOR: a program can only clear bits of erased bytes
+        for (lfs_size_t i = 0; i < size; i++) {
+            if (dst[i] != (uint8_t)p->erase_value) bd->stats.prog_violations++;
+            dst[i] &= src[i];
+        }
+    } else {
+        memcpy(dst, src, size);
+    }
+
+    bd->stats.progs++;
+    bd->stats.prog_bytes += size;
+    rambd_wait(bd, units * p->prog_us, (uint64_t)size * p->prog_ns_per_byte);
+    return LFS_ERR_OK;
+}
+
+static int rambd_erase(const struct lfs_config *c, lfs_block_t block) {
+    LittleFS_RamBD *bd = BD(c);
+    const LittleFS_RamBD_Profile *p = bd->profile;
+
+    if (p->erase_value >= 0) {
+        memset(&bd->buffer[block * c->block_size], p->erase_value, c->block_size);
+    }
+    if (bd->wear) {
+        bd->wear[block]++;
+    }
+
+    bd->stats.erases++;
+    rambd_wait(bd, p->erase_us, 0);
+    return LFS_ERR_OK;
+}
+
+static int rambd_sync(const struct lfs_config *c) {
+    (void)c;
+    return LFS_ERR_OK;
+}
+
+int LittleFS_RamBD_Init(LittleFS_RamBD *bd, struct lfs_config *cfg, uint8_t *buffer, uint32_t size,
+                        const LittleFS_RamBD_Profile *profile) {
+    if (size / profile->block_size < 2) {
+        return LFS_ERR_INVAL;
+    }
+
+    memset(bd, 0, sizeof(*bd));
+    bd->buffer = buffer;
+    bd->size = size;
+    bd->profile = profile;
+    memset(buffer, profile->erase_value >= 0 ? profile->erase_value : 0xFF, size);
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->context = bd;
+    cfg->read  = rambd_read;
+    cfg->prog  = rambd_prog;
+    cfg->erase = rambd_erase;
+    cfg->sync  = rambd_sync;
+
+    cfg->read_size = profile->read_size;
+    cfg->prog_size = profile->prog_size;
+    cfg->block_size = profile->block_size;
+    cfg->block_count = size / profile->block_size;
+    return LFS_ERR_OK;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file littlefs_rambd.h
+ * @brief RAM block device for LittleFS with emulated flash/SD timing
+ *
+ * Runs littlefs on a RAM buffer while charging the latency of a real
+ * device (W25Q NOR or an SD card over SPI) for every read, program and
+ * erase, so settings can be compared without wearing out real flash.
+ *
+ * Usage:
+ *      static uint8_t ram[256 * 4096];
+ *      static LittleFS_RamBD bd;
+ *      static struct lfs_config bd_cfg;
+ *      LittleFS_RamBD_Init(&bd, &bd_cfg, ram, sizeof(ram), &lfs_rambd_w25q);
+ *      bd_cfg.cache_size = 256;          // Tuning is left to the caller
+ *      bd_cfg.lookahead_size = 32;
+ *      bd_cfg.block_cycles = 500;
+ *      lfs_format(&fs, &bd_cfg);
+ */
+
+#ifndef LITTLEFS_RAMBD_H
+#define LITTLEFS_RAMBD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include "lfs.h"
+
+// Device being emulated: geometry and timing
+typedef struct {
+    const char *name;
+    uint32_t    block_size;         // littlefs block (erase unit)
+    uint32_t    read_size;
+    uint32_t    prog_size;
+    int16_t     erase_value;        // 0xFF for NOR (programs only clear bits), -1: erase is a no-op (SD)
+
+    uint32_t    read_us;            // Fixed cost per read (command, address, wait for data)
+    uint32_t    read_ns_per_byte;   // Bus transfer
+    uint32_t    prog_us;            // Busy time per prog_unit bytes (page program, block write)
+    uint32_t    prog_unit;
+    uint32_t    prog_ns_per_byte;
+    uint32_t    erase_us;           // Per block erase
+} LittleFS_RamBD_Profile;
+
+typedef struct {
+    uint32_t reads;
+    uint32_t read_bytes;
+    uint32_t progs;
+    uint32_t prog_bytes;
+    uint32_t erases;
+    uint32_t prog_violations;       // NOR: programmed a byte that was not erased
+    uint64_t busy_us;               // Emulated device time
+} LittleFS_RamBD_Stats;
+
+typedef struct {
+    uint8_t    *buffer;
+    uint32_t    size;
+    const LittleFS_RamBD_Profile *profile;
+    void      (*wait_us)(uint32_t us);  // Charges latency, NULL = Delay_us
+    uint32_t   *wear;               // Optional erase count per block (block_count entries)
+    uint32_t    pending_ns;         // Latency below 1 us carried to the next call
+    LittleFS_RamBD_Stats stats;
+} LittleFS_RamBD;
+
+// SPI NOR (W25Q64JV typ. at 18 MHz SPI): 4 KB blocks, 256 B pages
+extern const LittleFS_RamBD_Profile lfs_rambd_w25q;
+// SD card over SPI at 18 MHz: 512 B sectors in 4 KB blocks, no erase
+extern const LittleFS_RamBD_Profile lfs_rambd_sd;
+// Plain RAM, no latency
+extern const LittleFS_RamBD_Profile lfs_rambd_ram;
+
+/**
+ * @brief Set up the block device and the geometry part of cfg
+ * @note  Fills cfg read/prog/erase/sync, context, read_size, prog_size,
+ *        block_size and block_count; zeroes the rest. The buffer starts erased.
+ * @return 0 on success, LFS_ERR_INVAL if size holds fewer than 2 blocks
+ */
+int LittleFS_RamBD_Init(LittleFS_RamBD *bd, struct lfs_config *cfg, uint8_t *buffer, uint32_t size,
+                        const LittleFS_RamBD_Profile *profile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
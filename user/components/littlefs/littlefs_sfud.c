@@ -0,0 +1,17 @@
+/**
+ * @file littlefs_sfud.c
+ * @brief Flash geometry for the LittleFS port from SFUD
+ */
+
+#include "littlefs_sfud.h"
+#include "sfud_port.h"
+
+int LittleFS_Port_GeometryFromSFUD(const sfud_flash *flash, LittleFS_Port_Geometry *geo) {
+    Block_Device bd;
+
+    // SFUD_Port_BlockDev reads the SFDP erase table, or the chip table
+    if (SFUD_Port_BlockDev(&bd, flash) != BLOCK_DEV_OK) {
+        return LFS_ERR_INVAL;
+    }
+    return LittleFS_Port_GeometryFromBD(&bd, geo);
+}
@@ -0,0 +1,35 @@
+/**
+ * @file littlefs_sfud.h
+ * @brief Flash geometry for the LittleFS port from SFUD (SFDP or chip table)
+ *
+ * Usage:
+ *      SFUD_Port_Init();
+ *      LittleFS_Port_Geometry geo;
+ *      LittleFS_Port_GeometryFromSFUD(SFUD_Port_GetDefaultFlash(), &geo);
+ *      LittleFS_Partition_Mount(&part, &w25qxx_handle, &geo, &conf);
+ */
+
+#ifndef LITTLEFS_SFUD_H
+#define LITTLEFS_SFUD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "littlefs_port.h"
+#include "sfud.h"
+
+/**
+ * @brief Fill geo from an initialized SFUD device
+ * @note  Uses the SFDP erase table when the chip provides one, otherwise
+ *        SFUD's chip table, where a 4 KB 0x20 erase implies the standard
+ *        64 KB 0xD8 block erase. block_size is 0 if none is known.
+ * @return 0 on success, LFS_ERR_INVAL if the device is not initialized
+ */
+int LittleFS_Port_GeometryFromSFUD(const sfud_flash *flash, LittleFS_Port_Geometry *geo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,12 +3,13 @@
  * @brief LVGL Port Implementation for STM32 HAL
  *
  * This file provides the hardware abstraction layer for LVGL:
- * - Display flush callback
+ * - Display flush callback (DMA, completion reported from the interrupt)
  * - Tick source
  * - Optional input device handling
  */
 
 #include "lvgl_port.h"
+#include "display_spi.h"
 #include <string.h>
 
 /* ============================================================================
@@ -18,11 +19,11 @@
 static lv_display_t *disp;
 static uint32_t lvgl_tick_count = 0;
 
-/* Display buffer - LVGL will render to this buffer before flushing */
-static lv_color_t disp_buf1[LVGL_DISP_BUF_SIZE];
-
-/* Optional: Double buffering for smoother rendering (uses 2x RAM) */
-// static lv_color_t disp_buf2[LVGL_DISP_BUF_SIZE];
+/* Display buffers - LVGL renders into one while the other is flushed (RGB565) */
+LV_ATTRIBUTE_MEM_ALIGN static uint16_t disp_buf1[LVGL_DISP_BUF_SIZE];
+#if LVGL_DISP_DOUBLE_BUF
+LV_ATTRIBUTE_MEM_ALIGN static uint16_t disp_buf2[LVGL_DISP_BUF_SIZE];
+#endif
 
 /* ============================================================================
  *                          DISPLAY DRIVER HELPERS
@@ -50,11 +51,7 @@ static lv_color_t disp_buf1[LVGL_DISP_BUF_SIZE];
 #define LCD_BLK_Pin         GPIO_PIN_1
 #endif
 
-/* Low-level GPIO control macros */
-#define LCD_CS_LOW()    HAL_GPIO_WritePin(LCD_CS_GPIO_Port, LCD_CS_Pin, GPIO_PIN_RESET)
-#define LCD_CS_HIGH()   HAL_GPIO_WritePin(LCD_CS_GPIO_Port, LCD_CS_Pin, GPIO_PIN_SET)
-#define LCD_DC_LOW()    HAL_GPIO_WritePin(LCD_DC_GPIO_Port, LCD_DC_Pin, GPIO_PIN_RESET)
-#define LCD_DC_HIGH()   HAL_GPIO_WritePin(LCD_DC_GPIO_Port, LCD_DC_Pin, GPIO_PIN_SET)
+/* Low-level GPIO control macros (CS and DC are driven by display_spi) */
 #define LCD_RST_LOW()   HAL_GPIO_WritePin(LCD_RST_GPIO_Port, LCD_RST_Pin, GPIO_PIN_RESET)
 #define LCD_RST_HIGH()  HAL_GPIO_WritePin(LCD_RST_GPIO_Port, LCD_RST_Pin, GPIO_PIN_SET)
 #define LCD_BLK_ON()    HAL_GPIO_WritePin(LCD_BLK_GPIO_Port, LCD_BLK_Pin, GPIO_PIN_SET)
@@ -79,58 +76,15 @@ static lv_color_t disp_buf1[LVGL_DISP_BUF_SIZE];
 #define ST7789_COLMOD    0x3A
 #define ST7789_MADCTL    0x36
 
-/**
- * @brief Send command to ST7789
- */
-static void ST7789_WriteCmd(uint8_t cmd)
-{
-    LCD_DC_LOW();
-    LCD_CS_LOW();
-    HAL_SPI_Transmit(&hspi1, &cmd, 1, HAL_MAX_DELAY);
-    LCD_CS_HIGH();
-}
-
-/**
- * @brief Send data to ST7789
- */
-static void ST7789_WriteData(uint8_t *data, uint16_t len)
-{
-    LCD_DC_HIGH();
-    LCD_CS_LOW();
-    HAL_SPI_Transmit(&hspi1, data, len, HAL_MAX_DELAY);
-    LCD_CS_HIGH();
-}
-
-/**
- * @brief Send single byte data
- */
-static void ST7789_WriteData8(uint8_t data)
-{
-    ST7789_WriteData(&data, 1);
-}
+/* Shared SPI transport: command framing, byte swap and DMA streaming */
+static Display_SPI_HandleTypeDef lcd_bus;
 
 /**
- * @brief Set drawing window
+ * @brief Send command with its parameters to ST7789
  */
-static void ST7789_SetWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+static void ST7789_WriteCmd(uint8_t cmd, const uint8_t *params, uint16_t len)
 {
-    uint8_t data[4];
-
-    ST7789_WriteCmd(ST7789_CASET);
-    data[0] = (x0 >> 8) & 0xFF;
-    data[1] = x0 & 0xFF;
-    data[2] = (x1 >> 8) & 0xFF;
-    data[3] = x1 & 0xFF;
-    ST7789_WriteData(data, 4);
-
-    ST7789_WriteCmd(ST7789_RASET);
-    data[0] = (y0 >> 8) & 0xFF;
-    data[1] = y0 & 0xFF;
-    data[2] = (y1 >> 8) & 0xFF;
-    data[3] = y1 & 0xFF;
-    ST7789_WriteData(data, 4);
-
-    ST7789_WriteCmd(ST7789_RAMWR);
+    Display_SPI_WriteCommand(&lcd_bus, cmd, params, len);
 }
 
 /**
@@ -138,6 +92,9 @@ static void ST7789_SetWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
  */
 static void ST7789_Init(void)
 {
+    Display_SPI_Init(&lcd_bus, &hspi1, LCD_CS_GPIO_Port, LCD_CS_Pin,
+                     LCD_DC_GPIO_Port, LCD_DC_Pin, DISPLAY_SPI_RGB565);
+
     /* Hardware reset */
     LCD_RST_LOW();
     HAL_Delay(50);
@@ -145,58 +102,68 @@ static void ST7789_Init(void)
     HAL_Delay(150);
 
     /* Software reset */
-    ST7789_WriteCmd(ST7789_SWRESET);
+    ST7789_WriteCmd(ST7789_SWRESET, NULL, 0);
     HAL_Delay(150);
 
     /* Exit sleep mode */
-    ST7789_WriteCmd(ST7789_SLPOUT);
+    ST7789_WriteCmd(ST7789_SLPOUT, NULL, 0);
     HAL_Delay(120);
 
     /* Color mode: 16-bit RGB565 */
-    ST7789_WriteCmd(ST7789_COLMOD);
-    ST7789_WriteData8(0x55);  /* 16-bit color */
+    ST7789_WriteCmd(ST7789_COLMOD, (const uint8_t[]){0x55}, 1);
     HAL_Delay(10);
 
     /* Memory access control (orientation) */
-    ST7789_WriteCmd(ST7789_MADCTL);
-    ST7789_WriteData8(0x00);  /* Default orientation */
+    ST7789_WriteCmd(ST7789_MADCTL, (const uint8_t[]){0x00}, 1);  /* Default orientation */
 
     /* Inversion on (most ST7789 modules need this) */
-    ST7789_WriteCmd(ST7789_INVON);
+    ST7789_WriteCmd(ST7789_INVON, NULL, 0);
     HAL_Delay(10);
 
     /* Normal display mode */
-    ST7789_WriteCmd(ST7789_NORON);
+    ST7789_WriteCmd(ST7789_NORON, NULL, 0);
     HAL_Delay(10);
 
     /* Display on */
-    ST7789_WriteCmd(ST7789_DISPON);
+    ST7789_WriteCmd(ST7789_DISPON, NULL, 0);
     HAL_Delay(10);
 
     /* Turn on backlight */
     LCD_BLK_ON();
 }
 
+/**
+ * @brief Pixel stream finished (DMA complete interrupt, or inline without DMA)
+ */
+static void ST7789_FlushDone(void *ctx)
+{
+    /* IMPORTANT: Tell LVGL flushing is done */
+    lv_display_flush_ready((lv_display_t *)ctx);
+}
+
 /**
  * @brief LVGL flush callback for ST7789
+ * @note  Only starts the transfer. With double buffering LVGL renders the
+ *        next band while this one is on the bus.
  */
 static void ST7789_Flush(lv_display_t *display, const lv_area_t *area, uint8_t *px_map)
 {
+    (void)display;
     uint32_t size = lv_area_get_width(area) * lv_area_get_height(area);
 
-    ST7789_SetWindow(area->x1, area->y1, area->x2, area->y2);
+    Display_SPI_SetWindow(&lcd_bus, area->x1, area->y1, area->x2, area->y2);
 
-    /* Send pixel data */
-    LCD_DC_HIGH();
-    LCD_CS_LOW();
-    
-    /* RGB565 = 2 bytes per pixel */
-    HAL_SPI_Transmit(&hspi1, px_map, size * 2, HAL_MAX_DELAY);
-    
-    LCD_CS_HIGH();
+    /* RGB565 is byte swapped for the panel chunk by chunk while DMA runs */
+    Display_SPI_WritePixels(&lcd_bus, (const uint16_t *)px_map, size);
+}
 
-    /* IMPORTANT: Tell LVGL flushing is done */
-    lv_display_flush_ready(display);
+/**
+ * @brief Called by LVGL before it reuses a buffer that may still be on the bus
+ */
+static void ST7789_FlushWait(lv_display_t *display)
+{
+    (void)display;
+    Display_SPI_Wait(&lcd_bus);
 }
 
 #endif /* LVGL_DISPLAY_ST7789 */
@@ -245,12 +212,18 @@ void LVGL_Port_Init(void)
     disp = lv_display_create(LVGL_HOR_RES, LVGL_VER_RES);
 
     /* 3. Set display draw buffers */
+#if LVGL_DISP_DOUBLE_BUF
+    lv_display_set_buffers(disp, disp_buf1, disp_buf2, sizeof(disp_buf1), LV_DISPLAY_RENDER_MODE_PARTIAL);
+#else
     lv_display_set_buffers(disp, disp_buf1, NULL, sizeof(disp_buf1), LV_DISPLAY_RENDER_MODE_PARTIAL);
+#endif
 
     /* 4. Initialize hardware display and set flush callback */
 #ifdef LVGL_DISPLAY_ST7789
     ST7789_Init();
+    Display_SPI_SetDoneCallback(&lcd_bus, ST7789_FlushDone, disp);
     lv_display_set_flush_cb(disp, ST7789_Flush);
+    lv_display_set_flush_wait_cb(disp, ST7789_FlushWait);
 #endif
 
 #ifdef LVGL_DISPLAY_SSD1306
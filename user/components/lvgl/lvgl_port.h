@@ -18,6 +18,8 @@
  *       - Mode: Transmit Only Master
  *       - Data Size: 8 Bits
  *       - Prescaler: SPI_BAUDRATEPRESCALER_2 (最快速度)
+ *       - DMA: add SPIx_TX (Memory to Peripheral, Byte) and enable the SPI
+ *         global interrupt; without it flushes fall back to blocking
  *       - Configure GPIO:
  *         - CS:  PA4 (Output Push-Pull)
  *         - DC:  PA3 (Output Push-Pull)
@@ -114,6 +116,15 @@ extern "C" {
  */
 #define LVGL_DISP_BUF_SIZE    (LVGL_HOR_RES * 20)
 
+/**
+ * Double buffering (uses 2x LVGL_DISP_BUF_SIZE RAM)
+ * LVGL renders the next band into one buffer while DMA sends the other.
+ * With 0 every flush waits for its transfer before rendering continues.
+ */
+#ifndef LVGL_DISP_DOUBLE_BUF
+#define LVGL_DISP_DOUBLE_BUF  1
+#endif
+
 /* ============================================================================
  *                          HARDWARE HANDLES
  * ============================================================================ */
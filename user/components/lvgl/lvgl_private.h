@@ -0,0 +1,144 @@
+/**
+ * @file lvgl_private.h
+ *
+ */
+
+#ifndef LVGL_PRIVATE_H
+#define LVGL_PRIVATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "csrc/core/lv_group_private.h"
+#include "csrc/core/lv_obj_class_private.h"
+#include "csrc/core/lv_obj_draw_private.h"
+#include "csrc/core/lv_obj_event_private.h"
+#include "csrc/core/lv_obj_private.h"
+#include "csrc/core/lv_obj_scroll_private.h"
+#include "csrc/core/lv_obj_style_private.h"
+#include "csrc/core/lv_refr_private.h"
+#include "csrc/display/lv_display_private.h"
+#include "csrc/indev/lv_indev_gesture_private.h"
+#include "csrc/indev/lv_indev_private.h"
+#include "csrc/misc/cache/lv_cache_entry_private.h"
+#include "csrc/misc/cache/lv_cache_private.h"
+#include "csrc/misc/lv_anim_private.h"
+#include "csrc/misc/lv_anim_timeline_private.h"
+#include "csrc/misc/lv_area_private.h"
+#include "csrc/misc/lv_bidi_private.h"
+#include "csrc/misc/lv_color_op_private.h"
+#include "csrc/misc/lv_event_private.h"
+#include "csrc/misc/lv_fs_private.h"
+#include "csrc/misc/lv_profiler_builtin_private.h"
+#include "csrc/misc/lv_rb_private.h"
+#include "csrc/misc/lv_style_private.h"
+#include "csrc/misc/lv_text_private.h"
+#include "csrc/misc/lv_timer_private.h"
+#include "csrc/stdlib/builtin/lv_tlsf_private.h"
+#include "csrc/stdlib/lv_mem_private.h"
+#include "csrc/tick/lv_tick_private.h"
+#include "csrc/osal/lv_os_private.h"
+#include "csrc/draw/dma2d/lv_draw_dma2d_private.h"
+#include "csrc/draw/espressif/ppa/lv_draw_ppa_private.h"
+#include "csrc/draw/eve/lv_draw_eve_private.h"
+#include "csrc/draw/lv_draw_buf_private.h"
+#include "csrc/draw/lv_draw_image_private.h"
+#include "csrc/draw/lv_draw_label_private.h"
+#include "csrc/draw/lv_draw_mask_private.h"
+#include "csrc/draw/lv_draw_private.h"
+#include "csrc/draw/lv_draw_rect_private.h"
+#include "csrc/draw/lv_draw_triangle_private.h"
+#include "csrc/draw/lv_draw_vector_private.h"
+#include "csrc/draw/lv_image_decoder_private.h"
+#include "csrc/draw/sw/blend/lv_draw_sw_blend_private.h"
+#include "csrc/draw/sw/lv_draw_sw_mask_private.h"
+#include "csrc/draw/sw/lv_draw_sw_private.h"
+#include "csrc/font/lv_font_fmt_txt_private.h"
+#include "csrc/layouts/lv_layout_private.h"
+#include "csrc/libs/barcode/lv_barcode_private.h"
+#include "csrc/libs/ffmpeg/lv_ffmpeg_private.h"
+#include "csrc/libs/freetype/lv_freetype_private.h"
+#include "csrc/libs/qrcode/lv_qrcode_private.h"
+#include "csrc/libs/rlottie/lv_rlottie_private.h"
+#include "csrc/others/file_explorer/lv_file_explorer_private.h"
+#include "csrc/others/fragment/lv_fragment_private.h"
+#include "csrc/others/ime/lv_ime_pinyin_private.h"
+#include "csrc/others/monkey/lv_monkey_private.h"
+#include "csrc/others/observer/lv_observer_private.h"
+#include "csrc/others/sysmon/lv_sysmon_private.h"
+#include "csrc/others/test/lv_test_private.h"
+#include "csrc/others/translation/lv_translation_private.h"
+#include "csrc/others/xml/lv_xml_component_private.h"
+#include "csrc/others/xml/lv_xml_load_private.h"
+#include "csrc/others/xml/lv_xml_private.h"
+#include "csrc/themes/lv_theme_private.h"
+#include "csrc/widgets/3dtexture/lv_3dtexture_private.h"
+#include "csrc/widgets/animimage/lv_animimage_private.h"
+#include "csrc/widgets/arc/lv_arc_private.h"
+#include "csrc/widgets/arclabel/lv_arclabel_private.h"
+#include "csrc/widgets/bar/lv_bar_private.h"
+#include "csrc/widgets/button/lv_button_private.h"
+#include "csrc/widgets/buttonmatrix/lv_buttonmatrix_private.h"
+#include "csrc/widgets/calendar/lv_calendar_private.h"
+#include "csrc/widgets/canvas/lv_canvas_private.h"
+#include "csrc/widgets/chart/lv_chart_private.h"
+#include "csrc/widgets/checkbox/lv_checkbox_private.h"
+#include "csrc/widgets/dropdown/lv_dropdown_private.h"
+#include "csrc/widgets/image/lv_image_private.h"
+#include "csrc/widgets/imagebutton/lv_imagebutton_private.h"
+#include "csrc/widgets/keyboard/lv_keyboard_private.h"
+#include "csrc/widgets/label/lv_label_private.h"
+#include "csrc/widgets/led/lv_led_private.h"
+#include "csrc/widgets/line/lv_line_private.h"
+#include "csrc/widgets/lottie/lv_lottie_private.h"
+#include "csrc/widgets/menu/lv_menu_private.h"
+#include "csrc/widgets/msgbox/lv_msgbox_private.h"
+#include "csrc/widgets/roller/lv_roller_private.h"
+#include "csrc/widgets/scale/lv_scale_private.h"
+#include "csrc/widgets/slider/lv_slider_private.h"
+#include "csrc/widgets/span/lv_span_private.h"
+#include "csrc/widgets/spinbox/lv_spinbox_private.h"
+#include "csrc/widgets/switch/lv_switch_private.h"
+#include "csrc/widgets/table/lv_table_private.h"
+#include "csrc/widgets/tabview/lv_tabview_private.h"
+#include "csrc/widgets/textarea/lv_textarea_private.h"
+#include "csrc/widgets/tileview/lv_tileview_private.h"
+#include "csrc/widgets/win/lv_win_private.h"
+#include "csrc/drivers/display/drm/lv_linux_drm_egl_private.h"
+#include "csrc/drivers/evdev/lv_evdev_private.h"
+#include "csrc/drivers/libinput/lv_libinput_private.h"
+#include "csrc/drivers/libinput/lv_xkb_private.h"
+#include "csrc/drivers/opengles/lv_opengles_egl_private.h"
+#include "csrc/drivers/opengles/lv_opengles_private.h"
+#include "csrc/drivers/opengles/lv_opengles_texture_private.h"
+#include "csrc/drivers/sdl/lv_sdl_private.h"
+#include "csrc/drivers/uefi/lv_uefi_private.h"
+#include "csrc/drivers/wayland/lv_wayland_private.h"
+#include "csrc/drivers/windows/lv_windows_input_private.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LVGL_PRIVATE_H*/
@@ -60,6 +60,14 @@ $dstLvglH = Join-Path $ScriptDir "lvgl.h"
 $content = Get-Content $srcLvglH -Raw
 $content = $content -replace '"src/', '"csrc/'
 $content | Set-Content $dstLvglH -NoNewline
+
+# lvgl_private.h includes src/ the same way (csrc/lvgl_private.h includes it)
+$srcPrivH = Join-Path $SourcePath "lvgl_private.h"
+if (Test-Path $srcPrivH) {
+    $content = Get-Content $srcPrivH -Raw
+    $content = $content -replace '"src/', '"csrc/'
+    $content | Set-Content (Join-Path $ScriptDir "lvgl_private.h") -NoNewline
+}
 Write-Host "   Done. (src/ -> csrc/ paths updated)" -ForegroundColor Green
 
 # 5. Copy lv_version.h if it exists at root
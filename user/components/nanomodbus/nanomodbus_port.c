@@ -5,14 +5,21 @@
 
 #include "nanomodbus_port.h"
 #include "stm32f1xx_hal.h"
+#include "delay.h"
+#include "crc16.h"
 #include <string.h>
 
-/* Global server data pointer for callbacks */
-static nmbs_server_data_t* g_server_data = NULL;
+/* Map over nmbs_server_data_t for the server_data init functions */
+static nmbs_map_range g_data_ranges[2];
+static nmbs_map_unit  g_data_unit;
+static nmbs_map_t     g_data_map;
 
 /* UART handle for transport */
 static UART_HandleTypeDef* g_huart = NULL;
 
+/* RTU transports by UART channel, for the RX callback */
+static nmbs_rtu_t* g_rtu[UART_CHANNEL_MAX];
+
 /* ========================================================================
  * Platform Transport Functions (UART RTU)
  * ======================================================================== */
@@ -70,133 +77,495 @@ static int32_t platform_write_uart(const uint8_t* buf, uint16_t count, int32_t b
 }
 
 /* ========================================================================
- * Server Callbacks (Data Access Functions)
+ * RTU Transport on uart.c (event-driven)
  * ======================================================================== */
 
+#define RTU_NEXT(i) ((uint8_t)(((i) + 1) % NMBS_RTU_RX_FRAMES))
+
 /**
- * @brief Server callback: Read Coils (FC 01)
+ * @brief Table-driven CRC for nanoMODBUS (same result as nmbs_crc_calc)
  */
-static nmbs_error server_read_coils(uint16_t address, uint16_t quantity, 
-                                     nmbs_bitfield coils_out, uint8_t unit_id, void* arg) {
-    if (!g_server_data || unit_id != g_server_data->unit_id) {
-        return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+static uint16_t rtu_crc_calc(const uint8_t* data, uint32_t length, void* arg) {
+    (void)arg;
+    uint16_t crc = CRC16_Update(CRC16_MODBUS_INIT, data, length);
+
+    return (uint16_t)((crc << 8) | (crc >> 8));
+}
+
+static bool rtu_unit_accepted(const nmbs_rtu_t* rtu, uint8_t unit_id) {
+    uint32_t any = 0;
+    for (int i = 0; i < 8; i++) any |= rtu->units[i];
+
+    return !any || unit_id == NMBS_BROADCAST_ADDRESS || (rtu->units[unit_id >> 5] & (1UL << (unit_id & 31)));
+}
+
+/**
+ * @brief The frame in slot [head] has ended: queue it or drop it
+ */
+static void rtu_frame_end(nmbs_rtu_t* rtu) {
+    uint16_t len = rtu->rx_len;
+    uint16_t crc = rtu->rx_crc;
+    const uint8_t* f = rtu->frame[rtu->head];
+
+    rtu->rx_len = 0;
+    rtu->rx_crc = CRC16_MODBUS_INIT;
+
+    /* Unit ID + FC + CRC at least; the CRC over a frame including its own CRC is 0 */
+    if (len < 4 || len > NMBS_RTU_FRAME_MAX || crc != 0) {
+        rtu->frame_errors++;
+        return;
     }
-    
-    /* Check address bounds */
-    if (address + quantity > NMBS_COIL_BUF_SIZE) {
-        return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+    if (!rtu->client && !rtu_unit_accepted(rtu, f[0])) {
+        rtu->foreign++;
+        return;
     }
-    
-    /* Copy coils to output */
-    for (uint16_t i = 0; i < quantity; i++) {
-        bool bit = nmbs_bitfield_read(g_server_data->coils, address + i);
-        nmbs_bitfield_write(coils_out, i, bit);
+    if (RTU_NEXT(rtu->head) == rtu->tail) {
+        rtu->overruns++;
+        return;
     }
-    
-    return NMBS_ERROR_NONE;
+    rtu->frame_len[rtu->head] = len;
+    rtu->head = RTU_NEXT(rtu->head);
+    rtu->frames++;
 }
 
 /**
- * @brief Server callback: Read Holding Registers (FC 03)
+ * @brief UART RX callback: append the new bytes to the frame being received
+ * @note Runs in the RX event interrupt (or in UART_Poll / UART_PollRx context)
  */
-static nmbs_error server_read_holding_registers(uint16_t address, uint16_t quantity, 
-                                                  uint16_t* registers_out, uint8_t unit_id, void* arg) {
-    if (!g_server_data || unit_id != g_server_data->unit_id) {
-        return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+static void rtu_rx_callback(UART_Channel channel) {
+    nmbs_rtu_t* rtu = g_rtu[channel];
+    if (!rtu) return;
+
+    uint32_t now = DWT->CYCCNT;
+    uint16_t batch = UART_Available(channel);
+
+    /* The batch ends about now; silence before its first byte of T3.5 or more
+     * means what was collected so far is a frame of its own */
+    if (rtu->rx_len > 0 && now - rtu->rx_time >= rtu->t35_cycles + (uint32_t)batch * rtu->char_cycles) {
+        rtu_frame_end(rtu);
     }
-    
-    /* Check address bounds */
-    if (address + quantity > NMBS_REG_BUF_SIZE) {
-        return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+
+    const uint8_t* span;
+    uint16_t len;
+    uint8_t* f = rtu->frame[rtu->head];
+
+    while ((len = UART_PeekLinear(channel, &span)) > 0) {
+        for (uint16_t i = 0; i < len; i++) {
+            if (rtu->rx_len < NMBS_RTU_FRAME_MAX) {
+                f[rtu->rx_len] = span[i];
+                rtu->rx_crc = CRC16_UpdateByte(rtu->rx_crc, span[i]);
+            }
+            if (rtu->rx_len <= NMBS_RTU_FRAME_MAX) rtu->rx_len++;
+        }
+        UART_Skip(channel, len);
     }
-    
-    /* Copy registers to output */
-    memcpy(registers_out, &g_server_data->regs[address], quantity * sizeof(uint16_t));
-    
-    return NMBS_ERROR_NONE;
+    rtu->rx_time = now;
+
+#if NMBS_RTU_EARLY_CRC
+    /* Line went idle (or DMA half/full) on a frame with a correct CRC: done */
+    if (rtu->rx_len >= 4 && rtu->rx_crc == 0) {
+        rtu_frame_end(rtu);
+    }
+#endif
 }
 
 /**
- * @brief Server callback: Write Single Coil (FC 05)
+ * @brief End the frame being received once the line has been quiet for T3.5
  */
-static nmbs_error server_write_single_coil(uint16_t address, bool value, uint8_t unit_id, void* arg) {
-    if (!g_server_data || unit_id != g_server_data->unit_id) {
-        return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+static void rtu_check_gap(nmbs_rtu_t* rtu) {
+    /* Bytes the DMA holds between RX events count as line activity; the
+     * callback (and its CRC) runs with interrupts enabled */
+    UART_PollRx(rtu->channel);
+
+    /* Only the check itself must not race with the RX event interrupt */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (rtu->rx_len > 0 && DWT->CYCCNT - rtu->rx_time >= rtu->t35_cycles) {
+        rtu_frame_end(rtu);
     }
-    
-    /* Check address bounds */
-    if (address >= NMBS_COIL_BUF_SIZE) {
-        return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+    __set_PRIMASK(primask);
+}
+
+static void rtu_release(nmbs_rtu_t* rtu) {
+    if (rtu->rd_active) {
+        rtu->rd_active = 0;
+        rtu->tail = RTU_NEXT(rtu->tail);
     }
-    
-    /* Write coil */
-    nmbs_bitfield_write(g_server_data->coils, address, value);
-    
-    return NMBS_ERROR_NONE;
 }
 
 /**
- * @brief Server callback: Write Single Register (FC 06)
+ * @brief Client: wait for a complete frame (timeout_ms < 0: forever)
  */
-static nmbs_error server_write_single_register(uint16_t address, uint16_t value, uint8_t unit_id, void* arg) {
-    if (!g_server_data || unit_id != g_server_data->unit_id) {
-        return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+static bool rtu_wait_frame(nmbs_rtu_t* rtu, int32_t timeout_ms) {
+    uint32_t start = HAL_GetTick();
+
+    while (1) {
+        rtu_check_gap(rtu);
+        if (rtu->tail != rtu->head) return true;
+        if (timeout_ms >= 0 && HAL_GetTick() - start >= (uint32_t)timeout_ms) return false;
     }
-    
-    /* Check address bounds */
-    if (address >= NMBS_REG_BUF_SIZE) {
-        return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+}
+
+/**
+ * @brief RTU read for nanoMODBUS: bytes of the current frame, never past its end
+ *
+ * Server: the frame is handed over by nmbs_rtu_server_poll, no waiting.
+ * Client: waits up to byte_timeout_ms for the response frame.
+ */
+static int32_t platform_read_rtu(uint8_t* buf, uint16_t count, int32_t byte_timeout_ms, void* arg) {
+    nmbs_rtu_t* rtu = (nmbs_rtu_t*)arg;
+
+    if (!rtu->rd_active) {
+        if (!rtu->client || !rtu_wait_frame(rtu, byte_timeout_ms)) return 0;
+        rtu->rd_active = 1;
+        rtu->rd_pos = 0;
     }
-    
-    /* Write register */
-    g_server_data->regs[address] = value;
-    
-    return NMBS_ERROR_NONE;
+
+    uint16_t avail = rtu->frame_len[rtu->tail] - rtu->rd_pos;
+    uint16_t n = (count < avail) ? count : avail;
+
+    memcpy(buf, &rtu->frame[rtu->tail][rtu->rd_pos], n);
+    rtu->rd_pos += n;
+
+    if (rtu->client && rtu->rd_pos >= rtu->frame_len[rtu->tail]) {
+        rtu_release(rtu);
+    }
+    return n;
 }
 
 /**
- * @brief Server callback: Write Multiple Coils (FC 15)
+ * @brief RTU write for nanoMODBUS: queue the frame on the UART TX ring
+ * @return count, or 0 if the TX ring had no room for the whole frame
  */
-static nmbs_error server_write_multiple_coils(uint16_t address, uint16_t quantity, 
-                                                const nmbs_bitfield coils, uint8_t unit_id, void* arg) {
-    if (!g_server_data || unit_id != g_server_data->unit_id) {
-        return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+static int32_t platform_write_rtu(const uint8_t* buf, uint16_t count, int32_t byte_timeout_ms, void* arg) {
+    nmbs_rtu_t* rtu = (nmbs_rtu_t*)arg;
+    (void)byte_timeout_ms;
+
+    if (rtu->client) {
+        /* Whatever is left over can't be the response to this request */
+        rtu_release(rtu);
+        rtu->tail = rtu->head;
     }
-    
-    /* Check address bounds */
-    if (address + quantity > NMBS_COIL_BUF_SIZE) {
+
+    bool ok = rtu->rs485 ? RS485_SendAsync(rtu->rs485, buf, count)
+                         : UART_Send(rtu->channel, buf, count);
+    return ok ? count : 0;
+}
+
+/* ========================================================================
+ * Register Map
+ * ======================================================================== */
+
+static bool map_is_bits(nmbs_map_table type) {
+    return type == NMBS_MAP_COILS || type == NMBS_MAP_DISCRETE_INPUTS;
+}
+
+static bool map_writable(const nmbs_map_range* r) {
+    return !(r->flags & NMBS_MAP_RO) && (r->data || r->write);
+}
+
+/**
+ * @brief Copy n bits between LSB-first bitfields at any bit offsets
+ *
+ * Whole bytes when both offsets are byte aligned, otherwise one destination
+ * byte per step from a 16-bit window of the source.
+ */
+static void map_bits_copy(uint8_t* dst, uint32_t dst_off, const uint8_t* src, uint32_t src_off, uint32_t n) {
+    if (((dst_off | src_off) & 7) == 0) {
+        memcpy(&dst[dst_off >> 3], &src[src_off >> 3], n >> 3);
+        dst_off += n & ~7U;
+        src_off += n & ~7U;
+        n &= 7;
+    }
+
+    while (n > 0) {
+        uint32_t s = src_off & 7;
+        uint32_t d = dst_off & 7;
+        uint32_t k = 8 - d;
+        if (k > n) k = n;
+
+        uint32_t w = src[src_off >> 3];
+        if (s + k > 8) w |= (uint32_t)src[(src_off >> 3) + 1] << 8;
+
+        uint8_t mask = (uint8_t)(((1U << k) - 1) << d);
+        uint8_t bits = (uint8_t)(((w >> s) << d) & mask);
+        dst[dst_off >> 3] = (uint8_t)((dst[dst_off >> 3] & ~mask) | bits);
+
+        dst_off += k;
+        src_off += k;
+        n -= k;
+    }
+}
+
+static const nmbs_map_unit* map_find_unit(const nmbs_map_t* map, uint8_t unit_id) {
+    for (uint8_t i = 0; i < map->count; i++) {
+        if (map->units[i].unit_id == unit_id) return &map->units[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Index of the range holding address (tables are sorted), or -1
+ */
+static int32_t map_find_range(const nmbs_map_range* ranges, uint16_t len, uint16_t address) {
+    int32_t lo = 0, hi = (int32_t)len - 1;
+
+    while (lo <= hi) {
+        int32_t mid = (lo + hi) / 2;
+        const nmbs_map_range* r = &ranges[mid];
+
+        if (address < r->start) hi = mid - 1;
+        else if ((uint32_t)address >= (uint32_t)r->start + r->count) lo = mid + 1;
+        else return mid;
+    }
+    return -1;
+}
+
+/**
+ * @brief Copy between one range and the request buffer
+ * @param pos Position of the range's part in buf (bits or registers)
+ */
+static nmbs_error map_range_access(const nmbs_map_range* r, nmbs_map_table type, uint16_t offset,
+                                   uint16_t quantity, void* buf, uint16_t pos, bool write) {
+    bool bits = map_is_bits(type);
+
+    if (!write) {
+        if (r->read) {
+            if (!bits) return r->read(offset, quantity, (uint16_t*)buf + pos, r->arg);
+            if ((pos & 7) == 0) return r->read(offset, quantity, (uint8_t*)buf + pos / 8, r->arg);
+
+            /* Getter writes from bit 0: collect, then shift into place */
+            nmbs_bitfield tmp = {0};
+            nmbs_error err = r->read(offset, quantity, tmp, r->arg);
+            if (err == NMBS_ERROR_NONE) map_bits_copy(buf, pos, tmp, 0, quantity);
+            return err;
+        }
+        if (bits) map_bits_copy(buf, pos, r->data, offset, quantity);
+        else memcpy((uint16_t*)buf + pos, (const uint16_t*)r->data + offset, quantity * sizeof(uint16_t));
+        return NMBS_ERROR_NONE;
+    }
+
+    if (r->data) {
+        if (bits) map_bits_copy(r->data, offset, buf, pos, quantity);
+        else memcpy((uint16_t*)r->data + offset, (const uint16_t*)buf + pos, quantity * sizeof(uint16_t));
+        if (!r->write) return NMBS_ERROR_NONE;
+    }
+
+    if (!bits) return r->write(offset, quantity, (const uint16_t*)buf + pos, r->arg);
+    if ((pos & 7) == 0) return r->write(offset, quantity, (const uint8_t*)buf + pos / 8, r->arg);
+
+    nmbs_bitfield tmp = {0};
+    map_bits_copy(tmp, 0, buf, pos, quantity);
+    return r->write(offset, quantity, tmp, r->arg);
+}
+
+/**
+ * @brief Read or write quantity items from address of one unit's table
+ *
+ * The whole request is checked (no gaps, writable) before anything is copied.
+ */
+static nmbs_error map_unit_access(const nmbs_map_unit* unit, nmbs_map_table type, uint16_t address,
+                                  uint16_t quantity, void* buf, bool write) {
+    const nmbs_map_range* ranges = unit->table[type];
+    uint16_t len = unit->table_len[type];
+
+    if (!ranges || len == 0) {
+        return NMBS_EXCEPTION_ILLEGAL_FUNCTION;
+    }
+
+    int32_t first = map_find_range(ranges, len, address);
+    if (first < 0) {
         return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
     }
-    
-    /* Write coils */
-    for (uint16_t i = 0; i < quantity; i++) {
-        bool bit = nmbs_bitfield_read(coils, i);
-        nmbs_bitfield_write(g_server_data->coils, address + i, bit);
+
+    uint32_t end = (uint32_t)address + quantity;
+    uint32_t next = address;
+    for (int32_t i = first; next < end; i++) {
+        if (i >= len || (i > first && ranges[i].start != next)) {
+            return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+        }
+        if (write && !map_writable(&ranges[i])) {
+            return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+        }
+        next = (uint32_t)ranges[i].start + ranges[i].count;
     }
-    
+
+    uint16_t done = 0;
+    for (int32_t i = first; done < quantity; i++) {
+        const nmbs_map_range* r = &ranges[i];
+        uint16_t offset = (uint16_t)(address + done - r->start);
+        uint16_t n = (uint16_t)(r->count - offset);
+        if (n > quantity - done) n = (uint16_t)(quantity - done);
+
+        nmbs_error err = map_range_access(r, type, offset, n, buf, done, write);
+        if (err != NMBS_ERROR_NONE) {
+            return err;
+        }
+        done = (uint16_t)(done + n);
+    }
+
     return NMBS_ERROR_NONE;
 }
 
 /**
- * @brief Server callback: Write Multiple Registers (FC 16)
+ * @brief Dispatch a request to the addressed unit; broadcasts write to every unit
  */
-static nmbs_error server_write_multiple_registers(uint16_t address, uint16_t quantity, 
-                                                    const uint16_t* registers, uint8_t unit_id, void* arg) {
-    if (!g_server_data || unit_id != g_server_data->unit_id) {
-        return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
+static nmbs_error map_access(void* arg, uint8_t unit_id, nmbs_map_table type, uint16_t address,
+                             uint16_t quantity, void* buf, bool write) {
+    const nmbs_map_t* map = (const nmbs_map_t*)arg;
+
+    if (unit_id == NMBS_BROADCAST_ADDRESS) {
+        if (!write) {
+            return NMBS_EXCEPTION_ILLEGAL_FUNCTION;
+        }
+        /* Never answered: units that lack the addresses just don't take it */
+        for (uint8_t i = 0; i < map->count; i++) {
+            map_unit_access(&map->units[i], type, address, quantity, buf, true);
+        }
+        return NMBS_ERROR_NONE;
     }
-    
-    /* Check address bounds */
-    if (address + quantity > NMBS_REG_BUF_SIZE) {
+
+    const nmbs_map_unit* unit = map_find_unit(map, unit_id);
+    if (!unit) {
         return NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS;
     }
-    
-    /* Write registers */
-    memcpy(&g_server_data->regs[address], registers, quantity * sizeof(uint16_t));
-    
+    return map_unit_access(unit, type, address, quantity, buf, write);
+}
+
+static bool map_table_ok(const nmbs_map_range* ranges, uint16_t len) {
+    if (len > 0 && !ranges) return false;
+
+    for (uint16_t i = 0; i < len; i++) {
+        const nmbs_map_range* r = &ranges[i];
+
+        if (r->count == 0 || (uint32_t)r->start + r->count > 0x10000UL) return false;
+        if (!r->data && !r->read) return false;
+        if (i > 0 && r->start < (uint32_t)ranges[i - 1].start + ranges[i - 1].count) return false;
+    }
+    return true;
+}
+
+nmbs_error nmbs_map_init(nmbs_map_t* map, const nmbs_map_unit* units, uint8_t count) {
+    if (!map || !units || count == 0) {
+        return NMBS_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (units[i].unit_id == NMBS_BROADCAST_ADDRESS || units[i].unit_id > 247) {
+            return NMBS_ERROR_INVALID_ARGUMENT;
+        }
+        for (uint8_t j = 0; j < i; j++) {
+            if (units[j].unit_id == units[i].unit_id) return NMBS_ERROR_INVALID_ARGUMENT;
+        }
+        for (int t = 0; t < NMBS_MAP_TABLES; t++) {
+            if (!map_table_ok(units[i].table[t], units[i].table_len[t])) return NMBS_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    map->units = units;
+    map->count = count;
     return NMBS_ERROR_NONE;
 }
 
+/* ========================================================================
+ * Server Callbacks (Data Access Functions)
+ * ======================================================================== */
+
+/**
+ * @brief Server callback: Read Coils (FC 01)
+ */
+static nmbs_error server_read_coils(uint16_t address, uint16_t quantity,
+                                    nmbs_bitfield coils_out, uint8_t unit_id, void* arg) {
+    return map_access(arg, unit_id, NMBS_MAP_COILS, address, quantity, coils_out, false);
+}
+
+/**
+ * @brief Server callback: Read Discrete Inputs (FC 02)
+ */
+static nmbs_error server_read_discrete_inputs(uint16_t address, uint16_t quantity,
+                                              nmbs_bitfield inputs_out, uint8_t unit_id, void* arg) {
+    return map_access(arg, unit_id, NMBS_MAP_DISCRETE_INPUTS, address, quantity, inputs_out, false);
+}
+
+/**
+ * @brief Server callback: Read Holding Registers (FC 03)
+ */
+static nmbs_error server_read_holding_registers(uint16_t address, uint16_t quantity,
+                                                uint16_t* registers_out, uint8_t unit_id, void* arg) {
+    return map_access(arg, unit_id, NMBS_MAP_HOLDING_REGISTERS, address, quantity, registers_out, false);
+}
+
+/**
+ * @brief Server callback: Read Input Registers (FC 04)
+ */
+static nmbs_error server_read_input_registers(uint16_t address, uint16_t quantity,
+                                              uint16_t* registers_out, uint8_t unit_id, void* arg) {
+    return map_access(arg, unit_id, NMBS_MAP_INPUT_REGISTERS, address, quantity, registers_out, false);
+}
+
+/**
+ * @brief Server callback: Write Single Coil (FC 05)
+ */
+static nmbs_error server_write_single_coil(uint16_t address, bool value, uint8_t unit_id, void* arg) {
+    uint8_t bit = value ? 1 : 0;
+    return map_access(arg, unit_id, NMBS_MAP_COILS, address, 1, &bit, true);
+}
+
+/**
+ * @brief Server callback: Write Single Register (FC 06)
+ */
+static nmbs_error server_write_single_register(uint16_t address, uint16_t value, uint8_t unit_id, void* arg) {
+    return map_access(arg, unit_id, NMBS_MAP_HOLDING_REGISTERS, address, 1, &value, true);
+}
+
+/**
+ * @brief Server callback: Write Multiple Coils (FC 15)
+ */
+static nmbs_error server_write_multiple_coils(uint16_t address, uint16_t quantity,
+                                              const nmbs_bitfield coils, uint8_t unit_id, void* arg) {
+    return map_access(arg, unit_id, NMBS_MAP_COILS, address, quantity, (void*)coils, true);
+}
+
+/**
+ * @brief Server callback: Write Multiple Registers (FC 16)
+ */
+static nmbs_error server_write_multiple_registers(uint16_t address, uint16_t quantity,
+                                                  const uint16_t* registers, uint8_t unit_id, void* arg) {
+    return map_access(arg, unit_id, NMBS_MAP_HOLDING_REGISTERS, address, quantity, (void*)registers, true);
+}
+
+void nmbs_map_set_callbacks(nmbs_t* nmbs, nmbs_map_t* map) {
+    nmbs->callbacks.read_coils = server_read_coils;
+    nmbs->callbacks.read_discrete_inputs = server_read_discrete_inputs;
+    nmbs->callbacks.read_holding_registers = server_read_holding_registers;
+    nmbs->callbacks.read_input_registers = server_read_input_registers;
+    nmbs->callbacks.write_single_coil = server_write_single_coil;
+    nmbs->callbacks.write_single_register = server_write_single_register;
+    nmbs->callbacks.write_multiple_coils = server_write_multiple_coils;
+    nmbs->callbacks.write_multiple_registers = server_write_multiple_registers;
+    nmbs_set_callbacks_arg(nmbs, map);
+}
+
+/**
+ * @brief One-unit map over nmbs_server_data_t: coils and holding registers from 0
+ */
+static nmbs_error server_data_map(nmbs_server_data_t* server_data, uint8_t unit_id) {
+    memset(server_data, 0, sizeof(nmbs_server_data_t));
+    server_data->unit_id = unit_id;
+
+    g_data_ranges[0] = (nmbs_map_range)NMBS_MAP_VAR(0, NMBS_COIL_BUF_SIZE, server_data->coils);
+    g_data_ranges[1] = (nmbs_map_range)NMBS_MAP_VAR(0, NMBS_REG_BUF_SIZE, server_data->regs);
+
+    memset(&g_data_unit, 0, sizeof(g_data_unit));
+    g_data_unit.unit_id = unit_id;
+    g_data_unit.table[NMBS_MAP_COILS] = &g_data_ranges[0];
+    g_data_unit.table_len[NMBS_MAP_COILS] = 1;
+    g_data_unit.table[NMBS_MAP_HOLDING_REGISTERS] = &g_data_ranges[1];
+    g_data_unit.table_len[NMBS_MAP_HOLDING_REGISTERS] = 1;
+
+    return nmbs_map_init(&g_data_map, &g_data_unit, 1);
+}
+
 /* ========================================================================
  * Public Initialization Functions
  * ======================================================================== */
@@ -208,12 +577,13 @@ nmbs_error nmbs_server_init_rtu(nmbs_t* nmbs, nmbs_server_data_t* server_data,
     }
     
     /* Store global references */
-    g_server_data = server_data;
     g_huart = (UART_HandleTypeDef*)huart;
     
-    /* Initialize server data */
-    memset(server_data, 0, sizeof(nmbs_server_data_t));
-    server_data->unit_id = unit_id;
+    /* Initialize server data and its map */
+    nmbs_error err = server_data_map(server_data, unit_id);
+    if (err != NMBS_ERROR_NONE) {
+        return err;
+    }
     
     /* Configure platform */
     nmbs_platform_conf platform;
@@ -226,18 +596,13 @@ nmbs_error nmbs_server_init_rtu(nmbs_t* nmbs, nmbs_server_data_t* server_data,
     /* Configure callbacks */
     nmbs_callbacks callbacks;
     nmbs_callbacks_create(&callbacks);
-    callbacks.read_coils = server_read_coils;
-    callbacks.read_holding_registers = server_read_holding_registers;
-    callbacks.write_single_coil = server_write_single_coil;
-    callbacks.write_single_register = server_write_single_register;
-    callbacks.write_multiple_coils = server_write_multiple_coils;
-    callbacks.write_multiple_registers = server_write_multiple_registers;
     
     /* Create server */
-    nmbs_error err = nmbs_server_create(nmbs, unit_id, &platform, &callbacks);
+    err = nmbs_server_create(nmbs, unit_id, &platform, &callbacks);
     if (err != NMBS_ERROR_NONE) {
         return err;
     }
+    nmbs_map_set_callbacks(nmbs, &g_data_map);
     
     /* Set timeouts (can be adjusted) */
     nmbs_set_byte_timeout(nmbs, 100);   /* 100ms byte timeout */
@@ -274,3 +639,129 @@ nmbs_error nmbs_client_init_rtu(nmbs_t* nmbs, void* huart) {
     
     return NMBS_ERROR_NONE;
 }
+
+nmbs_error nmbs_rtu_init(nmbs_rtu_t* rtu, UART_Channel channel, uint32_t baud, RS485_HandleTypeDef* rs485) {
+    if (!rtu || channel >= UART_CHANNEL_MAX || baud == 0) {
+        return NMBS_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(rtu, 0, sizeof(nmbs_rtu_t));
+    rtu->channel = channel;
+    rtu->rs485 = rs485;
+    rtu->rx_crc = CRC16_MODBUS_INIT;
+
+    /* A Modbus character is 11 bits (start, 8 data, parity or 2nd stop, stop) */
+    uint32_t cpu_mhz = SystemCoreClock / 1000000U;
+    uint32_t t35_us = NMBS_RTU_T35_US;
+    if (t35_us == 0) {
+        t35_us = (baud > 19200U) ? 1750U : (uint32_t)((38500000ULL + baud - 1) / baud);
+    }
+    rtu->t35_cycles = t35_us * cpu_mhz;
+    rtu->char_cycles = (uint32_t)((11ULL * SystemCoreClock) / baud);
+
+    Delay_Init();   /* DWT cycle counter for the frame gaps */
+
+    g_rtu[channel] = rtu;
+    UART_SetRxCallback(channel, rtu_rx_callback);
+    rtu->event_mode = UART_SetRxEventMode(channel, true);
+
+    return NMBS_ERROR_NONE;
+}
+
+static void rtu_platform_create(nmbs_platform_conf* platform, nmbs_rtu_t* rtu) {
+    nmbs_platform_conf_create(platform);
+    platform->transport = NMBS_TRANSPORT_RTU;
+    platform->read = platform_read_rtu;
+    platform->write = platform_write_rtu;
+    platform->crc_calc = rtu_crc_calc;
+    platform->arg = rtu;
+}
+
+nmbs_error nmbs_server_init_rtu_map(nmbs_t* nmbs, nmbs_map_t* map, nmbs_rtu_t* rtu) {
+    if (!nmbs || !map || !map->units || map->count == 0 || !rtu) {
+        return NMBS_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(rtu->units, 0, sizeof(rtu->units));
+    for (uint8_t i = 0; i < map->count; i++) {
+        uint8_t id = map->units[i].unit_id;
+        rtu->units[id >> 5] |= 1UL << (id & 31);
+    }
+    rtu->client = 0;
+
+    nmbs_platform_conf platform;
+    rtu_platform_create(&platform, rtu);
+
+    nmbs_callbacks callbacks;
+    nmbs_callbacks_create(&callbacks);
+
+    nmbs_error err = nmbs_server_create(nmbs, map->units[0].unit_id, &platform, &callbacks);
+    if (err != NMBS_ERROR_NONE) {
+        return err;
+    }
+    nmbs_map_set_callbacks(nmbs, map);
+
+    /* Reads never wait on the server side: the whole frame is already here */
+    nmbs_set_byte_timeout(nmbs, 0);
+    nmbs_set_read_timeout(nmbs, 0);
+
+    return NMBS_ERROR_NONE;
+}
+
+nmbs_error nmbs_server_init_rtu_uart(nmbs_t* nmbs, nmbs_server_data_t* server_data,
+                                     uint8_t unit_id, nmbs_rtu_t* rtu) {
+    if (!nmbs || !server_data || !rtu) {
+        return NMBS_ERROR_INVALID_ARGUMENT;
+    }
+
+    nmbs_error err = server_data_map(server_data, unit_id);
+    if (err != NMBS_ERROR_NONE) {
+        return err;
+    }
+    return nmbs_server_init_rtu_map(nmbs, &g_data_map, rtu);
+}
+
+nmbs_error nmbs_client_init_rtu_uart(nmbs_t* nmbs, nmbs_rtu_t* rtu) {
+    if (!nmbs || !rtu) {
+        return NMBS_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(rtu->units, 0, sizeof(rtu->units));
+    rtu->client = 1;
+
+    nmbs_platform_conf platform;
+    rtu_platform_create(&platform, rtu);
+
+    nmbs_error err = nmbs_client_create(nmbs, &platform);
+    if (err != NMBS_ERROR_NONE) {
+        return err;
+    }
+
+    /* The response arrives as one frame: only the read timeout matters */
+    nmbs_set_byte_timeout(nmbs, 100);
+    nmbs_set_read_timeout(nmbs, 1000);
+
+    return NMBS_ERROR_NONE;
+}
+
+nmbs_error nmbs_rtu_server_poll(nmbs_t* nmbs) {
+    nmbs_rtu_t* rtu = (nmbs_rtu_t*)nmbs->platform.arg;
+
+    rtu_check_gap(rtu);
+    if (rtu->tail == rtu->head) {
+        return NMBS_ERROR_TIMEOUT;
+    }
+
+    /* One server answers for every unit of the map: as the one addressed */
+    uint8_t unit_id = rtu->frame[rtu->tail][0];
+    if (unit_id != NMBS_BROADCAST_ADDRESS) {
+        nmbs->address_rtu = unit_id;
+    }
+
+    rtu->rd_active = 1;
+    rtu->rd_pos = 0;
+    nmbs_error err = nmbs_server_poll(nmbs);
+    rtu_release(rtu);
+
+    return err;
+}
@@ -4,6 +4,19 @@
  * 
  * This file provides the STM32 HAL porting layer for nanoMODBUS.
  * Supports both RTU (UART) and TCP transports.
+ *
+ * RTU over uart.c (nmbs_rtu_t): the RX event interrupt assembles frames from
+ * the UART ring, a frame ends on a valid CRC at the idle line or after 3.5
+ * character times of silence, and complete frames wait in a small queue for
+ * nmbs_rtu_server_poll(). Responses are queued on the UART TX ring (through
+ * rs485.c when a DE pin is used, which drops DE from the TX complete
+ * interrupt). Nothing blocks while waiting for bytes.
+ *
+ * Register map (nmbs_map_t): the server data is described by const tables of
+ * address ranges per unit ID, each bound to an application variable or to
+ * getter/setter callbacks. Requests are resolved with a binary search over the
+ * sorted tables and served with memcpy / byte-wise bit copies, so a
+ * 125-register read is one lookup and one copy.
  */
 
 #ifndef NANOMODBUS_PORT_H
@@ -16,11 +29,150 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include "csrc/nanomodbus.h"
+#include "uart.h"
+#include "rs485.h"
 
 /* Configuration */
 #define NMBS_COIL_BUF_SIZE 256       /* Max coils storage (bits) */
 #define NMBS_REG_BUF_SIZE  256       /* Max registers storage (16-bit) */
 
+#define NMBS_RTU_FRAME_MAX 256       /* Largest RTU ADU */
+
+#ifndef NMBS_RTU_RX_FRAMES
+#define NMBS_RTU_RX_FRAMES 3         /* Frame slots: one is being received, the rest queue */
+#endif
+
+#ifndef NMBS_RTU_EARLY_CRC
+#define NMBS_RTU_EARLY_CRC 1         /* 1: a frame whose CRC checks at the idle line ends at once, 0: wait T3.5 */
+#endif
+
+#ifndef NMBS_RTU_T35_US
+#define NMBS_RTU_T35_US    0         /* Frame gap override, 0: 3.5 chars (1750 us above 19200 baud) */
+#endif
+
+/**
+ * @brief Modbus RTU transport on a uart.c channel
+ *
+ * Frame slot [head] is being received, [tail]..[head-1] are complete.
+ * All fields are owned by the transport; read the counters only.
+ */
+typedef struct {
+    UART_Channel         channel;
+    RS485_HandleTypeDef* rs485;              /* NULL: plain UART, no DE control */
+    uint32_t             units[8];           /* Server: accepted unit IDs (bitmap), none set accepts all */
+    uint8_t              client;             /* 1: waits for responses in read */
+    uint8_t              event_mode;         /* 1: frames assembled from the RX interrupt */
+    uint32_t             t35_cycles;         /* Frame gap */
+    uint32_t             char_cycles;        /* One 11-bit character */
+
+    uint8_t              frame[NMBS_RTU_RX_FRAMES][NMBS_RTU_FRAME_MAX];
+    uint16_t             frame_len[NMBS_RTU_RX_FRAMES];
+    volatile uint8_t     head;
+    volatile uint8_t     tail;
+    uint16_t             rx_len;             /* Bytes received into [head], > MAX: overlong */
+    uint16_t             rx_crc;             /* Running CRC, 0 once a correct CRC is in */
+    uint32_t             rx_time;            /* DWT->CYCCNT of the last RX batch */
+    uint16_t             rd_pos;             /* nanoMODBUS read index into [tail] */
+    uint8_t              rd_active;          /* [tail] is handed to nanoMODBUS */
+
+    volatile uint32_t    frames;             /* Frames queued */
+    volatile uint32_t    frame_errors;       /* Bad CRC, too short or too long */
+    volatile uint32_t    overruns;           /* Frames dropped, queue full */
+    volatile uint32_t    foreign;            /* Frames for other unit IDs */
+} nmbs_rtu_t;
+
+/**
+ * @brief Register map tables, one per Modbus data type
+ */
+typedef enum {
+    NMBS_MAP_COILS = 0,
+    NMBS_MAP_DISCRETE_INPUTS,
+    NMBS_MAP_HOLDING_REGISTERS,
+    NMBS_MAP_INPUT_REGISTERS,
+    NMBS_MAP_TABLES
+} nmbs_map_table;
+
+/**
+ * @brief Range getter/setter
+ *
+ * offset is relative to the range start. Bits are packed LSB first like
+ * nmbs_bitfield (bit 0 = first requested item), registers are in host order.
+ * Return NMBS_ERROR_NONE or an NMBS_EXCEPTION_* code.
+ */
+typedef nmbs_error (*nmbs_map_read_fn)(uint16_t offset, uint16_t quantity, void* out, void* arg);
+typedef nmbs_error (*nmbs_map_write_fn)(uint16_t offset, uint16_t quantity, const void* in, void* arg);
+
+#define NMBS_MAP_RO 0x01    /* Writes are refused with ILLEGAL_DATA_ADDRESS */
+
+/**
+ * @brief One address range of a table
+ *
+ * With data the range is copied directly; read then overrides reads and write
+ * is called after data was updated (change notification). Without data, read
+ * and write do all the work; a range without a write path is read-only.
+ */
+typedef struct {
+    uint16_t          start;    /* First Modbus address */
+    uint16_t          count;    /* Registers or bits */
+    void*             data;     /* uint16_t[count], or bits packed LSB first; NULL: callbacks only */
+    nmbs_map_read_fn  read;
+    nmbs_map_write_fn write;
+    void*             arg;      /* Passed to read/write */
+    uint8_t           flags;    /* NMBS_MAP_RO */
+} nmbs_map_range;
+
+#define NMBS_MAP_VAR(start, count, ptr)       { (start), (count), (void*)(ptr), NULL, NULL, NULL, 0 }
+#define NMBS_MAP_VAR_RO(start, count, ptr)    { (start), (count), (void*)(ptr), NULL, NULL, NULL, NMBS_MAP_RO }
+#define NMBS_MAP_VAR_NOTIFY(start, count, ptr, write, arg) \
+                                              { (start), (count), (void*)(ptr), NULL, (write), (arg), 0 }
+#define NMBS_MAP_FN(start, count, read, write, arg) \
+                                              { (start), (count), NULL, (read), (write), (arg), 0 }
+
+/**
+ * @brief Tables of one unit ID
+ *
+ * Each table is a const array of ranges sorted by start, without overlaps
+ * (checked by nmbs_map_init). Ranges that touch form one address block, so a
+ * request may span them; a gap answers ILLEGAL_DATA_ADDRESS. A unit without a
+ * table answers ILLEGAL_FUNCTION for its function codes.
+ */
+typedef struct {
+    uint8_t               unit_id;                      /* 1-247 */
+    const nmbs_map_range* table[NMBS_MAP_TABLES];
+    uint16_t              table_len[NMBS_MAP_TABLES];
+} nmbs_map_unit;
+
+/* Designated initializer for one table of an nmbs_map_unit from a range array */
+#define NMBS_MAP_TABLE(type, ranges) \
+    .table[type] = (ranges), .table_len[type] = (uint16_t)(sizeof(ranges) / sizeof((ranges)[0]))
+
+/**
+ * @brief Register map: the units served by one nanoMODBUS server
+ */
+typedef struct {
+    const nmbs_map_unit* units;
+    uint8_t              count;
+} nmbs_map_t;
+
+/**
+ * @brief Check the tables and bind them to a map
+ *
+ * @param map Map instance
+ * @param units Unit array (may be const, in flash)
+ * @param count Number of units
+ * @return NMBS_ERROR_INVALID_ARGUMENT for a bad unit ID, a duplicate unit,
+ *         an unsorted or overlapping table, or a range without storage
+ */
+nmbs_error nmbs_map_init(nmbs_map_t* map, const nmbs_map_unit* units, uint8_t count);
+
+/**
+ * @brief Install the map dispatch callbacks on a server
+ *
+ * Used by the init functions below; call it directly for a server on another
+ * transport. The map becomes the callbacks argument.
+ */
+void nmbs_map_set_callbacks(nmbs_t* nmbs, nmbs_map_t* map);
+
 /**
  * @brief Modbus server data storage structure
  */
@@ -51,6 +203,57 @@ nmbs_error nmbs_server_init_rtu(nmbs_t* nmbs, nmbs_server_data_t* server_data,
  */
 nmbs_error nmbs_client_init_rtu(nmbs_t* nmbs, void* huart);
 
+/**
+ * @brief Bind an RTU transport to a uart.c channel
+ *
+ * The channel must be registered with UART_Register (RX DMA circular, TX ring
+ * of at least NMBS_RTU_FRAME_MAX bytes). The transport switches it to RX event
+ * mode and takes its RX callback; with rs485 the DE pin is driven by
+ * RS485_InitAsync on the same channel.
+ *
+ * @param rtu Transport instance
+ * @param channel uart.c channel
+ * @param baud Line baud rate (for the 3.5 character gap)
+ * @param rs485 RS485 handle initialized with RS485_InitAsync, or NULL
+ * @return nmbs_error NMBS_ERROR_NONE if successful
+ */
+nmbs_error nmbs_rtu_init(nmbs_rtu_t* rtu, UART_Channel channel, uint32_t baud, RS485_HandleTypeDef* rs485);
+
+/**
+ * @brief Initialize nanoMODBUS server instance on an RTU transport
+ *
+ * server_data is served as a one-unit map: coils and holding registers from
+ * address 0. Frames for other unit IDs are dropped by the transport.
+ * Serve requests with nmbs_rtu_server_poll().
+ */
+nmbs_error nmbs_server_init_rtu_uart(nmbs_t* nmbs, nmbs_server_data_t* server_data,
+                                     uint8_t unit_id, nmbs_rtu_t* rtu);
+
+/**
+ * @brief Initialize nanoMODBUS server instance on an RTU transport with a register map
+ *
+ * The transport accepts every unit ID of the map (and broadcasts); each
+ * request is answered as the unit it was addressed to.
+ * Serve requests with nmbs_rtu_server_poll().
+ */
+nmbs_error nmbs_server_init_rtu_map(nmbs_t* nmbs, nmbs_map_t* map, nmbs_rtu_t* rtu);
+
+/**
+ * @brief Initialize nanoMODBUS client instance on an RTU transport
+ *
+ * Requests block until the response frame or the read timeout.
+ */
+nmbs_error nmbs_client_init_rtu_uart(nmbs_t* nmbs, nmbs_rtu_t* rtu);
+
+/**
+ * @brief Hand the oldest complete request frame to nmbs_server_poll()
+ *
+ * Non-blocking, call from the main loop. One frame per call.
+ *
+ * @return NMBS_ERROR_TIMEOUT if no frame was waiting, otherwise the result of nmbs_server_poll()
+ */
+nmbs_error nmbs_rtu_server_poll(nmbs_t* nmbs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,34 +22,128 @@
 #include "sfud_port.h"
 #include "csrc/sfud.h"
 #include "main.h"
+#include "spi_dma.h"
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 /*******************************************************************************
  * CONFIGURATION
  ******************************************************************************/
 
-// SPI handle (defined in main.c by CubeMX)
+// SPI handle of the devices in SFUD_FLASH_DEVICE_TABLE (defined in main.c by CubeMX)
 extern SPI_HandleTypeDef hspi1;
 
-// CS Pin Configuration (modify to match your hardware)
+// CS Pin of the table devices (modify to match your hardware)
 #define SFUD_CS_PORT    GPIOA
 #define SFUD_CS_PIN     GPIO_PIN_4
 
 // SPI Timeout (milliseconds)
 #define SFUD_SPI_TIMEOUT 1000
 
+// Bus of the table devices; SFUD_Port_InitDevice() devices bring their own
+static SFUD_Port_Bus default_bus = {
+    .hspi = &hspi1,
+    .cs_port = SFUD_CS_PORT,
+    .cs_pin = SFUD_CS_PIN,
+};
+
 /*******************************************************************************
  * HELPER MACROS
  ******************************************************************************/
 
-#define SFUD_CS_LOW()   HAL_GPIO_WritePin(SFUD_CS_PORT, SFUD_CS_PIN, GPIO_PIN_RESET)
-#define SFUD_CS_HIGH()  HAL_GPIO_WritePin(SFUD_CS_PORT, SFUD_CS_PIN, GPIO_PIN_SET)
+#define SFUD_CS_LOW(bus)   HAL_GPIO_WritePin((bus)->cs_port, (bus)->cs_pin, GPIO_PIN_RESET)
+#define SFUD_CS_HIGH(bus)  HAL_GPIO_WritePin((bus)->cs_port, (bus)->cs_pin, GPIO_PIN_SET)
+
+// SFDP basic parameter table, DWORD 1 byte 2: fast read modes
+#define SFDP_DW1_READ_1_1_2  (1 << 0)
+#define SFDP_DW1_READ_1_2_2  (1 << 4)
+#define SFDP_DW1_READ_1_4_4  (1 << 5)
+#define SFDP_DW1_READ_1_1_4  (1 << 6)
 
 /*******************************************************************************
  * PLATFORM FUNCTIONS (Required by SFUD)
  ******************************************************************************/
 
+// DMA state: 1 = in flight, 0 = done, 2 = failed
+static void spi_dma_done(void *ctx, bool ok)
+{
+    SFUD_Port_Bus *bus = (SFUD_Port_Bus *)ctx;
+
+    bus->dma_state = ok ? 0 : 2;
+}
+
+static HAL_StatusTypeDef spi_dma_wait(SFUD_Port_Bus *bus)
+{
+    uint32_t start = HAL_GetTick();
+
+    while (bus->dma_state == 1) {
+        if ((HAL_GetTick() - start) > SFUD_SPI_TIMEOUT) {
+            HAL_SPI_Abort(bus->hspi);
+            return HAL_TIMEOUT;
+        }
+    }
+    return bus->dma_state == 0 ? HAL_OK : HAL_ERROR;
+}
+
+/**
+ * @brief Send a write phase, by DMA for page programs
+ * 
+ * Commands and addresses are a few bytes and go out polled; a 256-byte page
+ * program is where DMA frees the CPU.
+ */
+static HAL_StatusTypeDef spi_write(SFUD_Port_Bus *bus, const uint8_t *buf, size_t size)
+{
+    bool use_dma = size >= SFUD_DMA_MIN_BYTES && SPI_DMA_HasTx(bus->hspi);
+
+    while (size > 0) {
+        uint16_t n = (size > 0xFFFF) ? 0xFFFF : (uint16_t)size;
+
+        if (use_dma) {
+            bus->dma_state = 1;
+            if (SPI_DMA_Transmit(bus->hspi, buf, n, spi_dma_done, bus) != HAL_OK ||
+                spi_dma_wait(bus) != HAL_OK) {
+                return HAL_ERROR;
+            }
+        } else if (HAL_SPI_Transmit(bus->hspi, (uint8_t *)buf, n, SFUD_SPI_TIMEOUT) != HAL_OK) {
+            return HAL_ERROR;
+        }
+
+        buf += n;
+        size -= n;
+    }
+    return HAL_OK;
+}
+
+/**
+ * @brief Receive a read phase, by DMA for bulk reads
+ * 
+ * One HAL call moves at most 65535 bytes, so long reads are split. CS stays
+ * low in between and the flash keeps streaming from the next address.
+ */
+static HAL_StatusTypeDef spi_read(SFUD_Port_Bus *bus, uint8_t *buf, size_t size)
+{
+    bool use_dma = size >= SFUD_DMA_MIN_BYTES && SPI_DMA_HasRx(bus->hspi) && SPI_DMA_HasTx(bus->hspi);
+
+    while (size > 0) {
+        uint16_t n = (size > 0xFFFF) ? 0xFFFF : (uint16_t)size;
+
+        if (use_dma) {
+            bus->dma_state = 1;
+            if (SPI_DMA_Receive(bus->hspi, buf, n, spi_dma_done, bus) != HAL_OK ||
+                spi_dma_wait(bus) != HAL_OK) {
+                return HAL_ERROR;
+            }
+        } else if (HAL_SPI_Receive(bus->hspi, buf, n, SFUD_SPI_TIMEOUT) != HAL_OK) {
+            return HAL_ERROR;
+        }
+
+        buf += n;
+        size -= n;
+    }
+    return HAL_OK;
+}
+
 /**
  * @brief SPI write and read function
  * 
@@ -68,43 +162,43 @@ static sfud_err spi_write_read(const sfud_spi *spi,
                                 uint8_t *read_buf, size_t read_size)
 {
     HAL_StatusTypeDef status;
-    SPI_HandleTypeDef *hspi = (SPI_HandleTypeDef *)spi->user_data;
+    SFUD_Port_Bus *bus = (SFUD_Port_Bus *)spi->user_data;
     
     // Pull CS low to start transaction
-    SFUD_CS_LOW();
+    SFUD_CS_LOW(bus);
     
     // Write phase
     if (write_size > 0 && write_buf != NULL) {
-        status = HAL_SPI_Transmit(hspi, (uint8_t *)write_buf, write_size, SFUD_SPI_TIMEOUT);
+        status = spi_write(bus, write_buf, write_size);
         if (status != HAL_OK) {
-            SFUD_CS_HIGH();
+            SFUD_CS_HIGH(bus);
             return SFUD_ERR_TIMEOUT;
         }
     }
     
     // Read phase
     if (read_size > 0 && read_buf != NULL) {
-        status = HAL_SPI_Receive(hspi, read_buf, read_size, SFUD_SPI_TIMEOUT);
+        status = spi_read(bus, read_buf, read_size);
         if (status != HAL_OK) {
-            SFUD_CS_HIGH();
+            SFUD_CS_HIGH(bus);
             return SFUD_ERR_TIMEOUT;
         }
     }
     
     // Pull CS high to end transaction
-    SFUD_CS_HIGH();
+    SFUD_CS_HIGH(bus);
     
     return SFUD_SUCCESS;
 }
 
 /**
- * @brief Delay function (milliseconds)
+ * @brief Delay between busy-wait retries
  * 
- * @param ms Number of milliseconds to delay
+ * SFUD calls this without arguments, once per retry (see retry.times).
  */
-static void spi_delay_ms(uint32_t ms)
+static void retry_delay_1ms(void)
 {
-    HAL_Delay(ms);
+    HAL_Delay(1);
 }
 
 /**
@@ -146,19 +240,68 @@ sfud_err sfud_spi_port_init(sfud_flash *flash)
         return SFUD_ERR_NOT_FOUND;
     }
     
-    // Bind SPI operations
+    // Bind SPI operations. SFUD_Port_InitDevice() passes its bus in
+    // flash->user_data; the devices of the table share the default one.
     flash->spi.wr = spi_write_read;
     flash->spi.lock = spi_lock;
     flash->spi.unlock = spi_unlock;
-    flash->spi.user_data = &hspi1;  // Attach HAL SPI handle
+    flash->spi.user_data = flash->user_data ? flash->user_data : &default_bus;
+    flash->user_data = flash->spi.user_data;
     
     // Set retry configuration
-    flash->retry.times = 10000;     // Retry times for busy wait
-    flash->retry.delay = spi_delay_ms;
+    flash->retry.times = 60 * 1000; // Retry times for busy wait (60 s, covers chip erase)
+    flash->retry.delay = retry_delay_1ms;
     
     return SFUD_SUCCESS;
 }
 
+/**
+ * @brief Pick the read command for SFUD_Port_Read() from the chip's SFDP
+ * 
+ * SFUD takes only the capacity and erasers from the basic parameter table
+ * and reads with 0x03, which the chip limits to a lower clock (50 MHz on
+ * W25Q). A chip with SFDP implements Fast Read (0x0B, 8 dummy clocks) at
+ * its full clock. The dual/quad modes of DWORD 1 are recorded in
+ * read_modes; they need IO2/IO3 (QSPI) and are not used on a SPI bus.
+ */
+static void sfud_port_select_read(sfud_flash *flash)
+{
+    SFUD_Port_Bus *bus = (SFUD_Port_Bus *)flash->spi.user_data;
+
+    bus->read_cmd = SFUD_CMD_READ_DATA;
+    bus->read_dummy = 0;
+    bus->read_modes = 0;
+
+#ifdef SFUD_USING_SFDP
+    uint8_t cmd[5] = {SFUD_CMD_READ_SFDP_REGISTER, 0x00, 0x00, 0x08, SFUD_DUMMY_DATA};
+    uint8_t header[8], dw1[4];
+    uint32_t ptp;
+
+    if (!flash->init_ok || !flash->sfdp.available) {
+        return;
+    }
+    bus->read_cmd = SFUD_CMD_FAST_READ_DATA;
+    bus->read_dummy = 1;
+
+    // Basic parameter header at 08h points to the table
+    if (spi_write_read(&flash->spi, cmd, sizeof(cmd), header, sizeof(header)) != SFUD_SUCCESS) {
+        return;
+    }
+    ptp = (uint32_t)header[4] | ((uint32_t)header[5] << 8) | ((uint32_t)header[6] << 16);
+    cmd[1] = (uint8_t)(ptp >> 16);
+    cmd[2] = (uint8_t)(ptp >> 8);
+    cmd[3] = (uint8_t)ptp;
+    if (spi_write_read(&flash->spi, cmd, sizeof(cmd), dw1, sizeof(dw1)) != SFUD_SUCCESS) {
+        return;
+    }
+
+    if (dw1[2] & SFDP_DW1_READ_1_1_2) bus->read_modes |= SFUD_PORT_READ_1_1_2;
+    if (dw1[2] & SFDP_DW1_READ_1_2_2) bus->read_modes |= SFUD_PORT_READ_1_2_2;
+    if (dw1[2] & SFDP_DW1_READ_1_1_4) bus->read_modes |= SFUD_PORT_READ_1_1_4;
+    if (dw1[2] & SFDP_DW1_READ_1_4_4) bus->read_modes |= SFUD_PORT_READ_1_4_4;
+#endif
+}
+
 /*******************************************************************************
  * DEBUG LOGGING (Optional)
  ******************************************************************************/
@@ -221,6 +364,10 @@ sfud_err SFUD_Port_Init(void)
     // Initialize SFUD library
     result = sfud_init();
     
+    for (size_t i = 0; i < sfud_get_device_num(); i++) {
+        sfud_port_select_read(sfud_get_device(i));
+    }
+
     if (result == SFUD_SUCCESS) {
         // Get the first Flash device
         const sfud_flash *flash = sfud_get_device_table();
@@ -245,3 +392,138 @@ const sfud_flash *SFUD_Port_GetDefaultFlash(void)
 {
     return sfud_get_device_table();
 }
+
+/**
+ * @brief Initialize a flash device on its own SPI bus and CS pin
+ */
+sfud_err SFUD_Port_InitDevice(sfud_flash *flash, SFUD_Port_Bus *bus, const char *name,
+                              SPI_HandleTypeDef *hspi, GPIO_TypeDef *cs_port, uint16_t cs_pin)
+{
+    sfud_err result;
+
+    memset(flash, 0, sizeof(*flash));
+    memset(bus, 0, sizeof(*bus));
+    bus->hspi = hspi;
+    bus->cs_port = cs_port;
+    bus->cs_pin = cs_pin;
+    SFUD_CS_HIGH(bus);
+
+    flash->name = (char *)name;
+    flash->spi.name = (char *)name;
+    flash->user_data = bus;
+
+    result = sfud_device_init(flash);
+    sfud_port_select_read(flash);
+    return result;
+}
+
+SFUD_Port_Bus *SFUD_Port_GetBus(const sfud_flash *flash)
+{
+    return (SFUD_Port_Bus *)flash->spi.user_data;
+}
+
+/**
+ * @brief Read with the command chosen from SFDP, without SFUD's busy poll
+ * 
+ * sfud_read() reads the status register before every read; SFUD's program
+ * and erase calls only return once the chip is idle, so the poll is
+ * redundant on a bus only this port drives.
+ */
+sfud_err SFUD_Port_Read(const sfud_flash *flash, uint32_t addr, size_t size, uint8_t *data)
+{
+    const sfud_spi *spi = &flash->spi;
+    SFUD_Port_Bus *bus = (SFUD_Port_Bus *)spi->user_data;
+    uint8_t cmd[6];
+    uint8_t len = 0;
+    sfud_err result;
+
+    if (!flash->init_ok) {
+        return SFUD_ERR_NOT_FOUND;
+    }
+    if (addr + size > flash->chip.capacity) {
+        return SFUD_ERR_ADDR_OUT_OF_BOUND;
+    }
+
+    cmd[len++] = bus->read_cmd;
+    if (flash->addr_in_4_byte) {
+        cmd[len++] = (uint8_t)(addr >> 24);
+    }
+    cmd[len++] = (uint8_t)(addr >> 16);
+    cmd[len++] = (uint8_t)(addr >> 8);
+    cmd[len++] = (uint8_t)addr;
+    if (bus->read_dummy) {
+        cmd[len++] = SFUD_DUMMY_DATA;
+    }
+
+    if (spi->lock) {
+        spi->lock(spi);
+    }
+    result = spi_write_read(spi, cmd, len, data, size);
+    if (spi->unlock) {
+        spi->unlock(spi);
+    }
+    return result;
+}
+
+/*******************************************************************************
+ * BLOCK DEVICE
+ ******************************************************************************/
+
+#define SFUD_BD_BLOCK_SIZE (64UL * 1024UL)
+
+static int sfud_bd_read(Block_Device *bd, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    return SFUD_Port_Read((const sfud_flash *)bd->ctx, addr, len, buf) == SFUD_SUCCESS ? BLOCK_DEV_OK : BLOCK_DEV_ERR_IO;
+}
+
+static int sfud_bd_prog(Block_Device *bd, uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+    return sfud_write((const sfud_flash *)bd->ctx, addr, len, buf) == SFUD_SUCCESS ? BLOCK_DEV_OK : BLOCK_DEV_ERR_IO;
+}
+
+// sfud_erase() picks the largest SFDP eraser that fits each step
+static int sfud_bd_erase(Block_Device *bd, uint32_t addr, uint32_t len)
+{
+    return sfud_erase((const sfud_flash *)bd->ctx, addr, len) == SFUD_SUCCESS ? BLOCK_DEV_OK : BLOCK_DEV_ERR_IO;
+}
+
+static const Block_Device_Ops sfud_bd_ops = {
+    .read  = sfud_bd_read,
+    .prog  = sfud_bd_prog,
+    .erase = sfud_bd_erase,
+};
+
+/**
+ * @brief Describe an initialized SFUD device as a Block_Device
+ */
+int SFUD_Port_BlockDev(Block_Device *bd, const sfud_flash *flash)
+{
+    if (!flash->init_ok || flash->chip.capacity == 0 || flash->chip.erase_gran == 0) {
+        return BLOCK_DEV_ERR_PARAM;
+    }
+
+    bd->name = flash->name;
+    bd->ops = &sfud_bd_ops;
+    bd->ctx = (void *)flash;
+    bd->capacity = flash->chip.capacity;
+    bd->read_size = 1;
+    bd->prog_size = (flash->chip.write_mode & SFUD_WM_PAGE_256B) ? 256 : 1;
+    bd->erase_size = flash->chip.erase_gran;
+    bd->block_size = 0;
+    bd->erase_value = 0xFF;
+
+#ifdef SFUD_USING_SFDP
+    if (flash->sfdp.available) {
+        bd->prog_size = flash->sfdp.write_gran;
+        for (int i = 0; i < SFUD_SFDP_ERASE_TYPE_MAX_NUM; i++) {
+            if (flash->sfdp.eraser[i].size == SFUD_BD_BLOCK_SIZE) bd->block_size = SFUD_BD_BLOCK_SIZE;
+        }
+    }
+#endif
+
+    // Chips without SFDP: W25Q-style parts all have a 64 KB block erase
+    if (bd->block_size == 0 && bd->erase_size < SFUD_BD_BLOCK_SIZE && flash->chip.erase_gran_cmd == 0x20) {
+        bd->block_size = SFUD_BD_BLOCK_SIZE;
+    }
+    return BLOCK_DEV_OK;
+}
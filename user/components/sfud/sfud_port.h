@@ -5,6 +5,22 @@
  * @date 2025
  * 
  * This file provides the port layer interface for SFUD on STM32.
+ * 
+ * Devices in SFUD_FLASH_DEVICE_TABLE (sfud_cfg.h) sit on hspi1 with CS on
+ * PA4 and are started by SFUD_Port_Init(). Further chips, on any bus, are
+ * started one by one:
+ *      static sfud_flash data_flash;
+ *      static SFUD_Port_Bus data_bus;
+ *      SFUD_Port_InitDevice(&data_flash, &data_bus, "data", &hspi2, GPIOB, GPIO_PIN_12);
+ *      SFUD_Port_Read(&data_flash, 0, sizeof(buf), buf);
+ * 
+ * and mounted by littlefs or FatFs through a Block_Device:
+ *      static Block_Device data_bd;
+ *      SFUD_Port_BlockDev(&data_bd, &data_flash);
+ *      LittleFS_Partition_MountBD(&part, &data_bd, &conf);
+ * 
+ * Transfers of SFUD_DMA_MIN_BYTES or more (page programs, bulk reads) use
+ * DMA when the SPI handle has DMA channels.
  */
 
 #ifndef SFUD_PORT_H
@@ -16,6 +32,29 @@ extern "C" {
 
 #include "csrc/sfud.h"
 #include "main.h"
+#include "block_dev.h"
+
+// Data phases at least this long use DMA when hspi has DMA channels
+#ifndef SFUD_DMA_MIN_BYTES
+#define SFUD_DMA_MIN_BYTES 64
+#endif
+
+// Multi-line read modes listed in the chip's SFDP (SFUD_Port_Bus.read_modes)
+#define SFUD_PORT_READ_1_1_2  0x01
+#define SFUD_PORT_READ_1_2_2  0x02
+#define SFUD_PORT_READ_1_1_4  0x04
+#define SFUD_PORT_READ_1_4_4  0x08
+
+// One chip's connection, reached through sfud_flash.spi.user_data
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    GPIO_TypeDef      *cs_port;
+    uint16_t           cs_pin;
+    volatile uint8_t   dma_state;
+    uint8_t            read_cmd;    // 0x0B if the chip has SFDP, else 0x03
+    uint8_t            read_dummy;  // Dummy bytes after the address
+    uint8_t            read_modes;  // SFUD_PORT_READ_xxx (need QSPI, not used)
+} SFUD_Port_Bus;
 
 /**
  * @brief Initialize SFUD with default hardware configuration
@@ -34,6 +73,37 @@ sfud_err SFUD_Port_Init(void);
  */
 const sfud_flash *SFUD_Port_GetDefaultFlash(void);
 
+/**
+ * @brief Probe a flash chip that is not in the device table
+ * @param flash, bus Storage for the device; must stay valid while in use
+ * @param name Kept as the device name
+ * @return sfud_err SFUD_SUCCESS on success
+ */
+sfud_err SFUD_Port_InitDevice(sfud_flash *flash, SFUD_Port_Bus *bus, const char *name,
+                              SPI_HandleTypeDef *hspi, GPIO_TypeDef *cs_port, uint16_t cs_pin);
+
+/**
+ * @brief Bus and read command the port uses for a device
+ */
+SFUD_Port_Bus *SFUD_Port_GetBus(const sfud_flash *flash);
+
+/**
+ * @brief Read using the fast read command selected from SFDP
+ * @note  Skips sfud_read()'s status poll: the chip must be idle, which it is
+ *        after any SFUD call returns.
+ * @return sfud_err SFUD_SUCCESS on success
+ */
+sfud_err SFUD_Port_Read(const sfud_flash *flash, uint32_t addr, size_t size, uint8_t *data);
+
+/**
+ * @brief Describe an initialized device as a Block_Device
+ * @note  Reads go through SFUD_Port_Read(), erases through sfud_erase()
+ *        (largest SFDP eraser that fits). block_size is 64 KB when the
+ *        chip has a 64 KB erase, 0 otherwise.
+ * @return 0 on success, BLOCK_DEV_ERR_PARAM if the device is not initialized
+ */
+int SFUD_Port_BlockDev(Block_Device *bd, const sfud_flash *flash);
+
 #ifdef __cplusplus
 }
 #endif
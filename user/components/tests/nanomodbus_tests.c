@@ -17,11 +17,13 @@
  *    - Data Direction: Receive and Transmit
  *    - Over Sampling: 16 Samples
  * 
+ *    - DMA: USART2_RX Circular, USART2_TX Normal (server test, uart.c transport)
+ * 
  * 2. GPIO Configuration:
- *    - Optional: RS485 DE/RE control pin (if using RS485 transceiver)
+ *    - Optional: RS485 DE/RE control pin (if using RS485 transceiver), set MODBUS_USE_RS485
  * 
  * 3. NVIC Settings:
- *    - USART1 global interrupt: Enabled (if using interrupts, optional for this test)
+ *    - USART2 global interrupt and its DMA channels: Enabled (server test)
  * 
  * Wiring:
  * =======
@@ -53,6 +55,13 @@
 /* External UART handle (from main.c or CubeMX generated code) */
 extern UART_HandleTypeDef huart2;
 
+/* Server transport: uart.c channel, optional RS485 DE pin */
+#define MODBUS_UART_CHANNEL 1
+#define MODBUS_BAUD         9600
+#define MODBUS_USE_RS485    0
+#define MODBUS_DE_PORT      GPIOA
+#define MODBUS_DE_PIN       GPIO_PIN_1
+
 /* Print helper */
 #define PRINT(fmt, ...) do { \
     char buf[128]; \
@@ -67,15 +76,32 @@ extern UART_HandleTypeDef huart2;
 
 static nmbs_t modbus_server;
 static nmbs_server_data_t server_data;
+static nmbs_rtu_t modbus_rtu;
+static uint8_t modbus_rx_dma[64];
+static uint8_t modbus_rx_ring[512];
+static uint8_t modbus_tx_ring[512];
+#if MODBUS_USE_RS485
+static RS485_HandleTypeDef modbus_rs485;
+#endif
 
 void Test_ModbusRTU_Server(void) {
     PRINT("=== nanoMODBUS RTU Server Test ===");
     PRINT("Unit ID: 1");
-    PRINT("UART: 9600 8E1");
+    PRINT("UART: 9600 8E1 (uart.c channel %d, RX event mode)", MODBUS_UART_CHANNEL);
     PRINT("Waiting for Modbus requests...\r\n");
     
-    /* Initialize Modbus server */
-    nmbs_error err = nmbs_server_init_rtu(&modbus_server, &server_data, 0x01, &huart2);
+    /* Frames are assembled from the RX interrupt; the loop below never blocks */
+    UART_Register(MODBUS_UART_CHANNEL, &huart2, modbus_rx_dma, sizeof(modbus_rx_dma),
+                  modbus_rx_ring, sizeof(modbus_rx_ring), modbus_tx_ring, sizeof(modbus_tx_ring));
+#if MODBUS_USE_RS485
+    RS485_InitAsync(&modbus_rs485, MODBUS_UART_CHANNEL, MODBUS_DE_PORT, MODBUS_DE_PIN);
+    nmbs_error err = nmbs_rtu_init(&modbus_rtu, MODBUS_UART_CHANNEL, MODBUS_BAUD, &modbus_rs485);
+#else
+    nmbs_error err = nmbs_rtu_init(&modbus_rtu, MODBUS_UART_CHANNEL, MODBUS_BAUD, NULL);
+#endif
+    if (err == NMBS_ERROR_NONE) {
+        err = nmbs_server_init_rtu_uart(&modbus_server, &server_data, 0x01, &modbus_rtu);
+    }
     if (err != NMBS_ERROR_NONE) {
         PRINT("ERROR: Server init failed: %s", nmbs_strerror(err));
         return;
@@ -96,11 +122,14 @@ void Test_ModbusRTU_Server(void) {
     PRINT("  Coil[1] = %d\r\n", nmbs_bitfield_read(server_data.coils, 1));
     
     uint32_t request_count = 0;
+    uint32_t last_report = HAL_GetTick();
     
     /* Main server loop */
     while (1) {
-        /* Poll for incoming Modbus requests */
-        err = nmbs_server_poll(&modbus_server);
+        UART_Poll();
+
+        /* Hand a complete request frame (if any) to nanoMODBUS */
+        err = nmbs_rtu_server_poll(&modbus_server);
         
         if (err == NMBS_ERROR_NONE) {
             request_count++;
@@ -110,14 +139,15 @@ void Test_ModbusRTU_Server(void) {
             PRINT("  Current Reg[0] = 0x%04X", server_data.regs[0]);
             PRINT("  Current Coil[0] = %d", nmbs_bitfield_read(server_data.coils, 0));
             
-        } else if (err == NMBS_ERROR_TIMEOUT) {
-            /* Timeout is normal when no requests */
-            HAL_Delay(10);
-            
-        } else {
-            /* Error occurred */
+        } else if (err != NMBS_ERROR_TIMEOUT) {
+            /* Timeout only means no frame was waiting */
             PRINT("ERROR: %s", nmbs_strerror(err));
-            HAL_Delay(100);
+        }
+
+        if (HAL_GetTick() - last_report >= 5000) {
+            last_report = HAL_GetTick();
+            PRINT("frames %lu  errors %lu  overruns %lu  other units %lu",
+                  modbus_rtu.frames, modbus_rtu.frame_errors, modbus_rtu.overruns, modbus_rtu.foreign);
         }
     }
 }
@@ -22,10 +22,19 @@
 #define TF_TYPE_BYTES   1   // 1, 2, or 4
 
 // Checksum type (0 = NONE, 8 = XOR, 16 = CRC16, 32 = CRC32)
+// NONE, XOR, CRC16 and CRC32 are computed a span at a time by tinyframe_port.c
+#ifndef TF_CKSUM_TYPE
 #define TF_CKSUM_TYPE   TF_CKSUM_CRC16
-
-// Start of Frame byte
+#endif
+
+// Start of Frame byte (lets the parser resync and skip noise quickly).
+// Off by default to keep the original wire format; both ends must agree
+#ifndef TF_USE_SOF_BYTE
+#define TF_USE_SOF_BYTE 0
+#endif
+#ifndef TF_SOF_BYTE
 #define TF_SOF_BYTE     0x01
+#endif
 
 // Max listener counts
 #define TF_MAX_ID_LST       5
@@ -43,18 +52,25 @@ typedef uint8_t  TF_COUNT;  // Type for listener counters
 //  Buffers
 //---------------------------------------------------------------------------
 
-// Max payloads
+// Max payloads (override from the build for bigger frames)
+#ifndef TF_MAX_PAYLOAD_TX
 #define TF_MAX_PAYLOAD_TX   256
+#endif
+#ifndef TF_MAX_PAYLOAD_RX
 #define TF_MAX_PAYLOAD_RX   256
+#endif
 
 // Receive buffer size (internal to TinyFrame struct)
 // Note: TF_MAX_PAYLOAD_RX is used for the buffer size in the struct
 
 // Send buffer size
-// This buffer is used to compose the frame before sending
-// It must be large enough to hold:
-// SOF(1) + ID(TF_ID_BYTES) + LEN(TF_LEN_BYTES) + TYPE(TF_TYPE_BYTES) + HEAD_CKSUM(1 or 2) + DATA(TF_MAX_PAYLOAD_TX) + DATA_CKSUM(1 or 2)
-#define TF_SENDBUF_LEN (1 + TF_ID_BYTES + TF_LEN_BYTES + TF_TYPE_BYTES + 2 + TF_MAX_PAYLOAD_TX + 2)
+// TinyFrame composes frames here and flushes it through TF_WriteImpl whenever
+// it is full. tinyframe_port.c collects those chunks in a TX buffer from its
+// shared pool (TINYFRAME_TX_POOL) and sends the whole frame in one write, so
+// this only has to hold the header: SOF + ID + LEN + TYPE + HEAD_CKSUM
+#ifndef TF_SENDBUF_LEN
+#define TF_SENDBUF_LEN  32
+#endif
 
 //---------------------------------------------------------------------------
 //  Features
@@ -63,7 +79,12 @@ typedef uint8_t  TF_COUNT;  // Type for listener counters
 // Peer bit (for master/slave distinction)
 #define TF_PEER     TF_MASTER // or TF_SLAVE
 
-#define TF_USE_MUTEX    0
+// TF_ClaimTx/TF_ReleaseTx are implemented in tinyframe_port.c (per-instance
+// TX lock, FreeRTOS mutex with TINYFRAME_USE_FREERTOS)
+#define TF_USE_MUTEX    1
 #define TF_ERROR_CALLBACKS 0
 
+// Error reporter, implemented in tinyframe_port.c
+void TF_Error(const char *fmt, ...);
+
 #endif // TF_CONFIG_H
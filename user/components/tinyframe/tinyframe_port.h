@@ -4,6 +4,12 @@
  * 
  * This file provides the platform-specific configuration and
  * helper functions for using TinyFrame with the STM32 UART driver.
+ *
+ * Instances are created on demand, each bound to a transport (UART channel,
+ * USB CDC, in-memory loopback or your own TinyFrame_Transport). Frames are
+ * assembled in a TX buffer pool shared by all instances and handed to the
+ * transport in one write; TX is serialised per instance (a FreeRTOS mutex
+ * with TINYFRAME_USE_FREERTOS).
  */
 
 #ifndef __TINYFRAME_PORT_H__
@@ -25,7 +31,53 @@ extern "C" {
  * @note Make sure this UART is enabled in uart.h (e.g., #define USE_UART2)
  */
 #ifndef TINYFRAME_UART_CHANNEL
-#define TINYFRAME_UART_CHANNEL  UART_CHANNEL_2
+#define TINYFRAME_UART_CHANNEL  1   // Second registered channel
+#endif
+
+/**
+ * @brief Instance slots for TinyFrame_Create (TinyFrame_Init uses one)
+ */
+#ifndef TINYFRAME_MAX_INSTANCES
+#define TINYFRAME_MAX_INSTANCES  4
+#endif
+
+/**
+ * @brief Shared TX frame buffers: frames being sent at the same time
+ * @note A buffer is held from TF_Send until the frame is queued on the
+ *       transport (or across a TF_Send_Multipart ... TF_Multipart_Close)
+ */
+#ifndef TINYFRAME_TX_POOL
+#define TINYFRAME_TX_POOL  2
+#endif
+
+/**
+ * @brief Set to 1 to serialise TX with a FreeRTOS mutex per instance
+ * @note Without it a send that finds the instance busy (e.g. from an ISR
+ *       interrupting a send) fails at once
+ */
+#ifndef TINYFRAME_USE_FREERTOS
+#define TINYFRAME_USE_FREERTOS  0
+#endif
+
+/**
+ * @brief How long a FreeRTOS task waits for the TX mutex and a pool buffer
+ */
+#ifndef TINYFRAME_TX_TIMEOUT_MS
+#define TINYFRAME_TX_TIMEOUT_MS  50
+#endif
+
+/**
+ * @brief Set to 1 to build the USB CDC transport (needs the usb_cdc driver)
+ */
+#ifndef TINYFRAME_USE_USB_CDC
+#define TINYFRAME_USE_USB_CDC  0
+#endif
+
+/**
+ * @brief RX ring of an in-memory loopback link (bytes)
+ */
+#ifndef TINYFRAME_LOOPBACK_SIZE
+#define TINYFRAME_LOOPBACK_SIZE  512
 #endif
 
 /**
@@ -43,6 +95,13 @@ extern "C" {
 #define TF_MAX_PAYLOAD_TX  256
 #endif
 
+/**
+ * @brief Zero-copy listener slots per instance (see TinyFrame_AddZeroCopyListener)
+ */
+#ifndef TINYFRAME_ZC_LISTENERS
+#define TINYFRAME_ZC_LISTENERS  4
+#endif
+
 /**
  * @brief Enable CRC checksum for frames
  * @note 0 = No checksum, 8 = CRC8, 16 = CRC16, 32 = CRC32
@@ -51,24 +110,145 @@ extern "C" {
 #define TF_CKSUM_TYPE  TF_CKSUM_CRC16
 #endif
 
+/* ============================================================================
+ * Transports
+ * ========================================================================= */
+
+/**
+ * @brief Link an instance sends and receives frames over
+ */
+typedef struct {
+    /**
+     * @brief Queue bytes for sending (a whole frame unless it is larger than
+     *        a pool buffer)
+     * @return false if they did not fit
+     */
+    bool (*write)(void *ctx, const uint8_t *data, uint32_t len);
+
+    /**
+     * @brief Point *data at the oldest contiguous block of received bytes
+     * @param more Set true if the bytes received next will follow right after
+     *        the block (same ring, no wrap), false otherwise
+     * @return Block length, 0 if nothing was received
+     */
+    uint32_t (*peek)(void *ctx, const uint8_t **data, bool *more);
+
+    /**
+     * @brief Consume len bytes of the block returned by peek
+     */
+    void (*skip)(void *ctx, uint32_t len);
+} TinyFrame_Transport;
+
+/**
+ * @brief UART transport: ctx is the UART_Channel, TINYFRAME_UART_CTX(ch)
+ */
+extern const TinyFrame_Transport TinyFrame_UartTransport;
+#define TINYFRAME_UART_CTX(ch)  ((void *)(uintptr_t)(ch))
+
+#if TINYFRAME_USE_USB_CDC
+/**
+ * @brief USB CDC transport (ctx unused)
+ */
+extern const TinyFrame_Transport TinyFrame_UsbCdcTransport;
+#endif
+
+/**
+ * @brief In-memory link end, ctx of TinyFrame_LoopbackTransport
+ * @note Writes land in the peer's ring (in its own with no peer)
+ */
+typedef struct TinyFrame_Loopback {
+    struct TinyFrame_Loopback *peer;
+    uint8_t  buf[TINYFRAME_LOOPBACK_SIZE];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped;   // Bytes that did not fit
+} TinyFrame_Loopback;
+
+extern const TinyFrame_Transport TinyFrame_LoopbackTransport;
+
+/**
+ * @brief Clear both ends and connect them (b may be NULL: a talks to itself)
+ */
+void TinyFrame_LoopbackConnect(TinyFrame_Loopback *a, TinyFrame_Loopback *b);
+
 /* ============================================================================
  * Port Layer API
  * ========================================================================= */
 
+/**
+ * @brief Create an instance bound to a transport
+ * @param transport Transport functions (must outlive the instance)
+ * @param ctx Passed to the transport functions
+ * @param peer TF_MASTER or TF_SLAVE (the two ends of a link must differ)
+ * @return Instance, or NULL if all TINYFRAME_MAX_INSTANCES slots are used
+ */
+TinyFrame* TinyFrame_Create(const TinyFrame_Transport *transport, void *ctx, TF_Peer peer);
+
+/**
+ * @brief Create an instance on a registered UART channel
+ */
+TinyFrame* TinyFrame_CreateUart(UART_Channel channel, TF_Peer peer);
+
+/**
+ * @brief Free an instance slot (not while it is sending)
+ */
+void TinyFrame_Destroy(TinyFrame *tf);
+
+/**
+ * @brief Bytes the transport refused since the instance was created
+ */
+uint32_t TinyFrame_GetTxDropCount(TinyFrame *tf);
+
 /**
  * @brief Initialize TinyFrame with port-specific configuration
  * @return Pointer to initialized TinyFrame instance
- * @note This function allocates static memory for TinyFrame
+ * @note Creates the default instance on TINYFRAME_UART_CHANNEL on the first
+ *       call and resets it on later ones
  */
 TinyFrame* TinyFrame_Init(void);
 
 /**
- * @brief Process incoming data from UART
+ * @brief Process incoming data from the instance's transport
  * @param tf Pointer to TinyFrame instance
  * @note Call this function periodically in your main loop or from a timer
  */
 void TinyFrame_Process(TinyFrame *tf);
 
+/**
+ * @brief Feed a contiguous block of received bytes (bulk TF_Accept)
+ * @param tf Pointer to TinyFrame instance
+ * @param buf Received bytes
+ * @param len Number of bytes
+ * @param more true if the bytes that follow will be appended right after buf
+ *        (same ring, no wrap): an incomplete frame for a zero-copy listener is
+ *        then left unconsumed so it can be delivered in place later
+ * @return Bytes consumed (len unless more is set); pass the rest again with
+ *         the new data after it
+ * @note Payload is copied and checksummed in bulk; frames that lie whole in
+ *       buf go to zero-copy listeners in place. The RX ring must hold the
+ *       largest frame.
+ */
+uint32_t TF_AcceptSpan(TinyFrame *tf, const uint8_t *buf, uint32_t len, bool more);
+
+/**
+ * @brief Add a listener that reads payloads in place
+ * @param tf Pointer to TinyFrame instance
+ * @param type Frame type
+ * @param cb Listener; msg->data points into the transport's RX buffer (or into
+ *        TinyFrame's buffer for a frame that arrived over several spans) and
+ *        is valid only during the call
+ * @return false if no slot is free or the type already has one
+ * @note Do not register the same type with TF_AddTypeListener. The listener
+ *       is final: TF_NEXT counts as TF_STAY. ID listeners (responses to
+ *       TF_Query) still get their frames first.
+ */
+bool TinyFrame_AddZeroCopyListener(TinyFrame *tf, TF_TYPE type, TF_Listener cb);
+
+/**
+ * @brief Remove a zero-copy listener by its type
+ */
+bool TinyFrame_RemoveZeroCopyListener(TinyFrame *tf, TF_TYPE type);
+
 #ifdef __cplusplus
 }
 #endif
@@ -14,10 +14,20 @@
 #define RS485_TX_MODE(h)  HAL_GPIO_WritePin(h->DePort, h->DePin, GPIO_PIN_SET)
 #define RS485_RX_MODE(h)  HAL_GPIO_WritePin(h->DePort, h->DePin, GPIO_PIN_RESET)
 
+// Async handles by UART channel, for the TX complete callback
+static RS485_HandleTypeDef *rs485_async[UART_CHANNEL_MAX];
+
+// TX queue of the channel drained and TC set: release the bus
+static void RS485_TxDone(UART_Channel channel) {
+    RS485_HandleTypeDef *hrs485 = rs485_async[channel];
+    if (hrs485) RS485_RX_MODE(hrs485);
+}
+
 void RS485_Init(RS485_HandleTypeDef *hrs485, UART_HandleTypeDef *huart, GPIO_TypeDef *de_port, uint16_t de_pin) {
     hrs485->huart = huart;
     hrs485->DePort = de_port;
     hrs485->DePin = de_pin;
+    hrs485->Async = 0;
     
     // Default state: Receive Mode (Bus Idle)
     RS485_RX_MODE(hrs485);
@@ -60,3 +70,40 @@ void RS485_Printf(RS485_HandleTypeDef *hrs485, const char *format, ...) {
     
     RS485_Send(hrs485, (uint8_t*)buffer, strlen(buffer), 1000);
 }
+
+void RS485_InitAsync(RS485_HandleTypeDef *hrs485, UART_Channel channel, GPIO_TypeDef *de_port, uint16_t de_pin) {
+    if (channel >= UART_CHANNEL_MAX) return;
+
+    hrs485->huart = NULL;
+    hrs485->DePort = de_port;
+    hrs485->DePin = de_pin;
+    hrs485->Channel = channel;
+    hrs485->Async = 1;
+
+    rs485_async[channel] = hrs485;
+    UART_SetTxCallback(channel, RS485_TxDone);
+
+    RS485_RX_MODE(hrs485);
+}
+
+bool RS485_SendAsync(RS485_HandleTypeDef *hrs485, const uint8_t *pData, uint16_t Size) {
+    if (!hrs485->Async || Size == 0) return false;
+
+    // DE up and the data queued as one step: a TX complete of the previous
+    // transfer in between would otherwise drop DE under the new data
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    RS485_TX_MODE(hrs485);
+    bool ok = UART_Send(hrs485->Channel, pData, Size);
+    if (!UART_IsTxBusy(hrs485->Channel)) {
+        RS485_RX_MODE(hrs485); // Nothing went out, no callback will come
+    }
+
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+bool RS485_IsTxBusy(RS485_HandleTypeDef *hrs485) {
+    return hrs485->Async && UART_IsTxBusy(hrs485->Channel);
+}
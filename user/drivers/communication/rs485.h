@@ -14,6 +14,8 @@
 #include "main.h"
 #endif
 
+#include "uart.h"
+
 typedef struct {
     UART_HandleTypeDef *huart;       // Pointer to UART Handle
     GPIO_TypeDef       *DePort;      // Driver Enable / Receive Enable Port
@@ -23,6 +25,10 @@ typedef struct {
     uint8_t            *RxBuffer;
     uint16_t            RxBufferSize;
     volatile uint16_t   RxIndex;
+
+    // Event-driven mode (RS485_InitAsync): TX goes through a uart.c channel
+    UART_Channel        Channel;
+    uint8_t             Async;
 } RS485_HandleTypeDef;
 
 /* Function Prototypes */
@@ -47,4 +53,24 @@ uint8_t RS485_Receive(RS485_HandleTypeDef *hrs485, uint8_t *pData, uint16_t Size
  */
 void RS485_Printf(RS485_HandleTypeDef *hrs485, const char *format, ...);
 
+/**
+ * @brief Initialize RS485 on a uart.c channel (event-driven)
+ * @note  The channel must already be registered with UART_Register. DE is raised
+ *        when data is queued and dropped from the channel's TX complete callback,
+ *        i.e. once the last stop bit has left the shift register. RS485 takes
+ *        over the channel's UART_SetTxCallback slot.
+ */
+void RS485_InitAsync(RS485_HandleTypeDef *hrs485, UART_Channel channel, GPIO_TypeDef *de_port, uint16_t de_pin);
+
+/**
+ * @brief Queue data for sending (non-blocking, async mode only)
+ * @return false if it did not fit in the channel's TX ring (as UART_Send)
+ */
+bool RS485_SendAsync(RS485_HandleTypeDef *hrs485, const uint8_t *pData, uint16_t Size);
+
+/**
+ * @brief True while async data is queued or still on the wire (DE is up)
+ */
+bool RS485_IsTxBusy(RS485_HandleTypeDef *hrs485);
+
 #endif // __RS485_H
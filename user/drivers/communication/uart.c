@@ -16,6 +16,11 @@ static UART_HandleTypeDef* UART_Handles[UART_CHANNEL_MAX] = {NULL};
 static UART_RxCallback RxCallbacks[UART_CHANNEL_MAX] = {NULL};
 static UART_TxCallback TxCallbacks[UART_CHANNEL_MAX] = {NULL};
 static UART_ErrorCallback ErrorCallbacks[UART_CHANNEL_MAX] = {NULL};
+static volatile uint8_t RxCbActive[UART_CHANNEL_MAX];   // RX callback running
+static volatile uint8_t RxCbPending[UART_CHANNEL_MAX];  // Data came in meanwhile
+#if UART_USE_FREERTOS
+static TaskHandle_t RxNotifyTasks[UART_CHANNEL_MAX] = {NULL};
+#endif
 
 /* ============================================================================
  * Internal Function Prototypes
@@ -23,8 +28,16 @@ static UART_ErrorCallback ErrorCallbacks[UART_CHANNEL_MAX] = {NULL};
 static UART_HandleTypeDef* UART_GetHandle(UART_Channel ch);
 static int UART_HandleToChannel(UART_HandleTypeDef *huart);
 static void UART_ProcessDMA(UART_Channel ch);
+static bool UART_ProcessRx(UART_Channel ch);
+static void UART_RunRxCallback(UART_Channel ch);
 static void UART_TxKick(UART_Channel ch);
 static bool UART_RingBuf_Pop(UART_Channel ch, uint8_t *out);
+static uint16_t UART_RingBuf_Used(const UART_RingBuf *rb);
+static uint16_t UART_RingBuf_Linear(const UART_RingBuf *rb, const uint8_t **data);
+static void UART_RestartRxDMA(UART_Channel ch, UART_HandleTypeDef *huart);
+static uint16_t UART_TxRing_Write(UART_TxRingBuf *tb, const uint8_t *data, uint16_t len);
+static uint16_t UART_TxRing_Used(const UART_TxRingBuf *tb);
+static bool UART_TxCopy(UART_Channel channel, const uint8_t *data, uint16_t len, bool whole);
 
 /* ============================================================================
  * Internal Function Implementations
@@ -45,36 +58,87 @@ static int UART_HandleToChannel(UART_HandleTypeDef *huart)
     return -1;
 }
 
-// Helper to transfer a chunk from DMA buffer to Ring Buffer
+// Helper to transfer a chunk from DMA buffer to Ring Buffer (at most two memcpy)
 static void UART_TransferChunk(UART_RingBuf *rb, const uint8_t *dma_buf, uint16_t start_idx, uint16_t count)
 {
     uint16_t head = rb->head;
     uint16_t ring_size = rb->size;
-    
-    for (uint16_t i = 0; i < count; i++) {
-        uint16_t next = (head + 1) % ring_size;
-        if (next != rb->tail) {
-            rb->buf[head] = dma_buf[start_idx + i];
-            head = next;
-        } else {
-            rb->overrun_cnt++;
-        }
+    uint16_t space = ring_size - 1 - UART_RingBuf_Used(rb);
+
+    // Ring full: newest bytes are dropped, same as before
+    if (count > space) {
+        rb->overrun_cnt += count - space;
+        count = space;
     }
+
+    uint16_t first = ring_size - head;
+    if (first > count) first = count;
+
+    memcpy(&rb->buf[head], &dma_buf[start_idx], first);
+    memcpy(rb->buf, &dma_buf[start_idx + first], count - first);
+
+    head += count;
+    if (head >= ring_size) head -= ring_size;
     rb->head = head;
 }
 
 static void UART_ProcessDMA(UART_Channel ch) {
+    if (ch >= UART_CHANNEL_MAX) return;
+
+    // Event mode: the IDLE/HT/TC interrupt is the only producer
+    if (uart_rbuf[ch].rx_event) return;
+
+    UART_ProcessRx(ch);
+}
+
+// Run the RX callback with interrupts enabled. A callback is never nested:
+// if the RX interrupt brings data while it runs (e.g. it was called from
+// UART_PollRx), it is run again once it returns.
+static void UART_RunRxCallback(UART_Channel ch)
+{
+    if (!RxCallbacks[ch]) return;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (RxCbActive[ch]) {
+        RxCbPending[ch] = 1;
+        __set_PRIMASK(primask);
+        return;
+    }
+    RxCbActive[ch] = 1;
+    __set_PRIMASK(primask);
+
+    bool again;
+    do {
+        RxCbPending[ch] = 0;
+        RxCallbacks[ch](ch);
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+        again = RxCbPending[ch] != 0;
+        if (!again) RxCbActive[ch] = 0;
+        __set_PRIMASK(primask);
+    } while (again);
+}
+
+// Move newly received DMA bytes into the ring, returns true if there were any.
+// Interrupts are masked only while the DMA index and ring are updated (the RX
+// event interrupt may be the other producer); the callback runs unmasked.
+static bool UART_ProcessRx(UART_Channel ch) {
     UART_HandleTypeDef *huart = UART_GetHandle(ch);
-    if (!huart || !huart->hdmarx) return;
+    if (!huart || !huart->hdmarx) return false;
 
     UART_RingBuf *rb = &uart_rbuf[ch];
-    if (!rb->buf || !rb->dma_buf) return; // Safety check
+    if (!rb->buf || !rb->dma_buf) return false; // Safety check
 
     uint16_t dma_size = rb->dma_size;
     uint16_t ring_size = rb->size;
-    if (dma_size == 0 || ring_size == 0) return;
+    if (dma_size == 0 || ring_size == 0) return false;
 
     uint8_t *dma_buf = rb->dma_buf;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
     
     // Calculate current DMA position
     uint16_t dma_curr_pos = dma_size - __HAL_DMA_GET_COUNTER(huart->hdmarx);
@@ -82,10 +146,22 @@ static void UART_ProcessDMA(UART_Channel ch) {
 
     uint16_t last_pos = RxDMAPos[ch];
 
-    if (dma_curr_pos != last_pos) {
-        uint32_t primask = __get_PRIMASK();
-        __disable_irq();
-        
+    if (dma_curr_pos != last_pos && rb->zero_copy) {
+        uint16_t arrived = (dma_curr_pos > last_pos) ? (dma_curr_pos - last_pos)
+                                                     : (dma_size - last_pos + dma_curr_pos);
+        uint16_t used = UART_RingBuf_Used(rb);
+
+        // DMA wrote over unread data: drop everything up to the write index
+        // (all of it is counted, as that is what the reader loses)
+        if ((uint32_t)used + arrived >= dma_size) {
+            rb->overrun_cnt += (uint32_t)used + arrived;
+            rb->tail = dma_curr_pos;
+        }
+
+        // DMA buffer is the ring: publishing the write index is a single store
+        rb->head = dma_curr_pos;
+        RxDMAPos[ch] = dma_curr_pos;
+    } else if (dma_curr_pos != last_pos) {
         if (dma_curr_pos > last_pos) {
             // One contiguous chunk
             UART_TransferChunk(rb, dma_buf, last_pos, dma_curr_pos - last_pos);
@@ -96,22 +172,26 @@ static void UART_ProcessDMA(UART_Channel ch) {
         }
         
         RxDMAPos[ch] = dma_curr_pos;
-        
-        __set_PRIMASK(primask);
+    }
 
-        if (RxCallbacks[ch]) {
-            RxCallbacks[ch](ch);
-        }
+    __set_PRIMASK(primask);
+
+    if (dma_curr_pos != last_pos) {
+        UART_RunRxCallback(ch);
     }
+
+    return dma_curr_pos != last_pos;
 }
 
+#define UART_TX_DESC_NEXT(i) ((uint8_t)(((i) + 1) % UART_TX_DESC_MAX))
+
+// Start DMA on the descriptor at the queue tail (ring segment or referenced buffer)
 static void UART_TxKick(UART_Channel ch)
 {
     UART_HandleTypeDef *huart = UART_GetHandle(ch);
     if (huart == NULL) return;
 
     UART_TxRingBuf *tb = &uart_tbuf[ch];
-    if (!tb->buf || tb->size == 0) return;
 
     uint32_t primask = __get_PRIMASK();
     __disable_irq();
@@ -120,16 +200,23 @@ static void UART_TxKick(UART_Channel ch)
         __set_PRIMASK(primask);
         return;
     }
-    if (tb->head == tb->tail) {
+    if (tb->desc_head == tb->desc_tail) {
         __set_PRIMASK(primask);
         return;
     }
 
+    UART_TxDesc *d = &tb->desc[tb->desc_tail];
+    const uint8_t *ptr;
     uint16_t len = 0;
-    if (tb->head > tb->tail) {
-        len = tb->head - tb->tail;
+
+    if (d->data) {
+        ptr = d->data;
+        len = d->len;
     } else {
+        // Ring segment: only the contiguous part, the wrapped rest follows on completion
+        ptr = &tb->buf[tb->tail];
         len = tb->size - tb->tail;
+        if (len > d->len) len = d->len;
     }
     
     if (len == 0) {
@@ -142,7 +229,7 @@ static void UART_TxKick(UART_Channel ch)
 
     __set_PRIMASK(primask);
 
-    HAL_StatusTypeDef status = HAL_UART_Transmit_DMA(huart, &tb->buf[tb->tail], len);
+    HAL_StatusTypeDef status = HAL_UART_Transmit_DMA(huart, (uint8_t *)ptr, len);
     if (status != HAL_OK) {
         tb->busy = 0;
         tb->inflight_len = 0;
@@ -150,6 +237,34 @@ static void UART_TxKick(UART_Channel ch)
     }
 }
 
+static uint16_t UART_TxRing_Used(const UART_TxRingBuf *tb)
+{
+    uint16_t head = tb->head;
+    uint16_t tail = tb->tail;
+    return (head >= tail) ? (head - tail) : (tb->size - (tail - head));
+}
+
+// Copy into the TX ring (at most two memcpy), caller holds the critical section
+static uint16_t UART_TxRing_Write(UART_TxRingBuf *tb, const uint8_t *data, uint16_t len)
+{
+    uint16_t head = tb->head;
+    uint16_t space = tb->size - 1 - UART_TxRing_Used(tb);
+
+    if (len > space) len = space;
+
+    uint16_t first = tb->size - head;
+    if (first > len) first = len;
+
+    memcpy(&tb->buf[head], data, first);
+    memcpy(tb->buf, &data[first], len - first);
+
+    head += len;
+    if (head >= tb->size) head -= tb->size;
+    tb->head = head;
+
+    return len;
+}
+
 static bool UART_RingBuf_Pop(UART_Channel ch, uint8_t *out)
 {
     UART_RingBuf *rb = &uart_rbuf[ch];
@@ -161,6 +276,46 @@ static bool UART_RingBuf_Pop(UART_Channel ch, uint8_t *out)
     return true;
 }
 
+static uint16_t UART_RingBuf_Used(const UART_RingBuf *rb)
+{
+    uint16_t head = rb->head;
+    uint16_t tail = rb->tail;
+
+    if (head >= tail) return head - tail;
+    return rb->size - (tail - head);
+}
+
+// Contiguous readable block starting at tail
+static uint16_t UART_RingBuf_Linear(const UART_RingBuf *rb, const uint8_t **data)
+{
+    uint16_t head = rb->head;
+    uint16_t tail = rb->tail;
+
+    *data = &rb->buf[tail];
+    if (head >= tail) return head - tail;
+    return rb->size - tail;
+}
+
+static void UART_RestartRxDMA(UART_Channel ch, UART_HandleTypeDef *huart)
+{
+    UART_RingBuf *rb = &uart_rbuf[ch];
+    if (!rb->dma_buf || rb->dma_size == 0) return;
+
+    RxDMAPos[ch] = 0;
+    if (rb->zero_copy) {
+        // DMA restarts writing at index 0, unread data in the buffer is lost
+        rb->head = 0;
+        rb->tail = 0;
+    }
+#ifdef HAL_UART_RECEPTION_TOIDLE
+    if (rb->rx_event) {
+        HAL_UARTEx_ReceiveToIdle_DMA(huart, rb->dma_buf, rb->dma_size);
+        return;
+    }
+#endif
+    HAL_UART_Receive_DMA(huart, rb->dma_buf, rb->dma_size);
+}
+
 /* ============================================================================
  * Public API Implementation
  * ========================================================================= */
@@ -181,10 +336,13 @@ void UART_Register(UART_Channel channel, UART_HandleTypeDef *huart,
     uart_tbuf[channel].tail = 0;
     uart_tbuf[channel].busy = 0;
     uart_tbuf[channel].inflight_len = 0;
+    uart_tbuf[channel].desc_head = 0;
+    uart_tbuf[channel].desc_tail = 0;
     
-    // Config RX
-    uart_rbuf[channel].buf = rx_ring_buf;
-    uart_rbuf[channel].size = rx_ring_size;
+    // Config RX (no ring buffer given: DMA buffer is the ring)
+    uart_rbuf[channel].zero_copy = (rx_ring_buf == NULL || rx_ring_size == 0);
+    uart_rbuf[channel].buf = uart_rbuf[channel].zero_copy ? rx_dma_buf : rx_ring_buf;
+    uart_rbuf[channel].size = uart_rbuf[channel].zero_copy ? rx_dma_size : rx_ring_size;
     uart_rbuf[channel].dma_buf = rx_dma_buf;
     uart_rbuf[channel].dma_size = rx_dma_size;
     uart_rbuf[channel].head = 0;
@@ -200,6 +358,7 @@ void UART_Register(UART_Channel channel, UART_HandleTypeDef *huart,
     uart_rbuf[channel].ore_error_cnt = 0;
     uart_rbuf[channel].dma_error_cnt = 0;
     uart_rbuf[channel].error_flag = 0;
+    uart_rbuf[channel].rx_event = 0;
     
     RxDMAPos[channel] = 0;
 
@@ -226,36 +385,140 @@ void UART_SetErrorCallback(UART_Channel channel, UART_ErrorCallback cb)
     ErrorCallbacks[channel] = cb;
 }
 
+bool UART_SetRxEventMode(UART_Channel channel, bool enable)
+{
+#ifdef HAL_UART_RECEPTION_TOIDLE
+    UART_HandleTypeDef *huart = UART_GetHandle(channel);
+    if (huart == NULL) return false;
+
+    UART_RingBuf *rb = &uart_rbuf[channel];
+    if (!rb->dma_buf || rb->dma_size == 0) return false;
+
+    // Take over what the old mode already received, then restart from index 0
+    UART_ProcessRx(channel);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
 
+    HAL_UART_AbortReceive(huart);
+    rb->rx_event = enable ? 1 : 0;
+    UART_RestartRxDMA(channel, huart);
+
+    __set_PRIMASK(primask);
+    return true;
+#else
+    (void)channel;
+    (void)enable;
+    return false; // HAL without ReceiveToIdle support
+#endif
+}
+
+void UART_PollRx(UART_Channel channel)
+{
+    if (channel >= UART_CHANNEL_MAX) return;
+
+    // Safe against the RX interrupt (the other producer in event mode); the
+    // callback runs with interrupts enabled
+    UART_ProcessRx(channel);
+}
+
+#if UART_USE_FREERTOS
+void UART_SetRxNotifyTask(UART_Channel channel, TaskHandle_t task)
+{
+    if (channel >= UART_CHANNEL_MAX) return;
+    RxNotifyTasks[channel] = task;
+}
+#endif
+
+
+
+// Queue a copy in the TX ring. whole: all of it or nothing (not counted as
+// dropped); otherwise what fits is queued and the rest counted as dropped.
+static bool UART_TxCopy(UART_Channel channel, const uint8_t *data, uint16_t len, bool whole)
+{
+    UART_TxRingBuf *tb = &uart_tbuf[channel];
+    if (!tb->buf || tb->size == 0) return false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // Extend the last ring segment, or queue a new one behind referenced buffers
+    uint8_t last = (uint8_t)((tb->desc_head + UART_TX_DESC_MAX - 1) % UART_TX_DESC_MAX);
+    bool is_new = false;
+    UART_TxDesc *d = NULL;
+
+    if (tb->desc_head != tb->desc_tail && tb->desc[last].data == NULL) {
+        d = &tb->desc[last];
+    } else if (UART_TX_DESC_NEXT(tb->desc_head) != tb->desc_tail) {
+        d = &tb->desc[tb->desc_head];
+        d->data = NULL;
+        d->len = 0;
+        d->release = NULL;
+        is_new = true;
+    }
+
+    if (whole && (d == NULL || tb->size - 1 - UART_TxRing_Used(tb) < len)) {
+        __set_PRIMASK(primask);
+        return false;
+    }
+
+    uint16_t written = d ? UART_TxRing_Write(tb, data, len) : 0;
+    if (d) d->len += written;
+    if (is_new && written > 0) {
+        tb->desc_head = UART_TX_DESC_NEXT(tb->desc_head);
+    }
+
+    if (written < len) {
+        uart_rbuf[channel].tx_dropped += (len - written);
+    }
+
+    __set_PRIMASK(primask);
+
+    UART_TxKick(channel);
+    return written == len;
+}
 
 bool UART_Send(UART_Channel channel, const uint8_t *data, uint16_t len)
 {
     UART_HandleTypeDef *huart = UART_GetHandle(channel);
     if (huart == NULL || data == NULL || len == 0) return false;
 
+    return UART_TxCopy(channel, data, len, false);
+}
+
+bool UART_SendRef(UART_Channel channel, const uint8_t *data, uint16_t len, UART_TxReleaseCallback release)
+{
+    UART_HandleTypeDef *huart = UART_GetHandle(channel);
+    if (huart == NULL || data == NULL || len == 0) return false;
+
     UART_TxRingBuf *tb = &uart_tbuf[channel];
-    if (!tb->buf || tb->size == 0) return false;
 
-    bool success = true;
+    // Small writes: a copy is cheaper than a DMA transfer of its own. Only
+    // if it fits whole; otherwise the buffer is queued by reference below.
+    if (len < UART_TX_REF_MIN && UART_TxCopy(channel, data, len, true)) {
+        if (release) release(channel, data, len);
+        return true;
+    }
 
     uint32_t primask = __get_PRIMASK();
     __disable_irq();
 
-    for (uint16_t i = 0; i < len; i++) {
-        uint16_t next = (tb->head + 1) % tb->size;
-        if (next == tb->tail) {
-            uart_rbuf[channel].tx_dropped += (len - i);
-            success = false;
-            break;
-        }
-        tb->buf[tb->head] = data[i];
-        tb->head = next;
+    if (UART_TX_DESC_NEXT(tb->desc_head) == tb->desc_tail) {
+        uart_rbuf[channel].tx_dropped += len;
+        __set_PRIMASK(primask);
+        return false;
     }
 
+    UART_TxDesc *d = &tb->desc[tb->desc_head];
+    d->data = data;
+    d->len = len;
+    d->release = release;
+    tb->desc_head = UART_TX_DESC_NEXT(tb->desc_head);
+
     __set_PRIMASK(primask);
 
     UART_TxKick(channel);
-    return success;
+    return true;
 }
 
 void UART_SendString(UART_Channel channel, const char *str)
@@ -271,8 +534,7 @@ uint16_t UART_Available(UART_Channel ch)
     UART_RingBuf *rb = &uart_rbuf[ch];
     if (!rb->buf || rb->size == 0) return 0;
 
-    if (rb->head >= rb->tail) return rb->head - rb->tail;
-    return rb->size - (rb->tail - rb->head);
+    return UART_RingBuf_Used(rb);
 }
 
 bool UART_Read(UART_Channel ch, uint8_t *out)
@@ -287,16 +549,62 @@ uint16_t UART_ReadBytes(UART_Channel ch, uint8_t *buf, uint16_t max_len)
     
     UART_ProcessDMA(ch);
     
+    UART_RingBuf *rb = &uart_rbuf[ch];
+    if (!rb->buf || rb->size == 0) return 0;
+
     uint16_t count = 0;
-    uint8_t byte;
-    
-    while (count < max_len && UART_RingBuf_Pop(ch, &byte)) {
-        buf[count++] = byte;
+    const uint8_t *src;
+
+    // At most two blocks: up to the end of the ring, then from the start
+    while (count < max_len) {
+        uint16_t n = UART_RingBuf_Linear(rb, &src);
+        if (n == 0) break;
+        if (n > max_len - count) n = max_len - count;
+        memcpy(&buf[count], src, n);
+        count += n;
+        UART_Skip(ch, n);
     }
     
     return count;
 }
 
+uint16_t UART_PeekLinear(UART_Channel ch, const uint8_t **data)
+{
+    if (ch >= UART_CHANNEL_MAX || !data) return 0;
+
+    UART_ProcessDMA(ch);
+
+    UART_RingBuf *rb = &uart_rbuf[ch];
+    if (!rb->buf || rb->size == 0) {
+        *data = NULL;
+        return 0;
+    }
+
+    return UART_RingBuf_Linear(rb, data);
+}
+
+uint16_t UART_Skip(UART_Channel ch, uint16_t len)
+{
+    if (ch >= UART_CHANNEL_MAX) return 0;
+
+    UART_RingBuf *rb = &uart_rbuf[ch];
+    if (!rb->buf || rb->size == 0) return 0;
+
+    // Short critical section: in event mode an overrun in the ISR also moves tail
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint16_t used = UART_RingBuf_Used(rb);
+    if (len > used) len = used;
+
+    uint16_t tail = rb->tail + len;
+    if (tail >= rb->size) tail -= rb->size;
+    rb->tail = tail;
+
+    __set_PRIMASK(primask);
+    return len;
+}
+
 bool UART_Receive(UART_Channel ch, uint8_t *out, uint32_t timeout_ms)
 {
     uint32_t start = HAL_GetTick();
@@ -325,6 +633,12 @@ void UART_Flush(UART_Channel ch)
         RxDMAPos[ch] = rb->dma_size - __HAL_DMA_GET_COUNTER(huart->hdmarx);
         if (RxDMAPos[ch] >= rb->dma_size) RxDMAPos[ch] = 0;
     }
+
+    // Zero-copy: ring indices are DMA buffer indices
+    if (rb->zero_copy) {
+        rb->head = RxDMAPos[ch];
+        rb->tail = RxDMAPos[ch];
+    }
     
     __set_PRIMASK(primask);
 }
@@ -338,7 +652,7 @@ bool UART_IsTxBusy(UART_Channel ch)
 
     // Check if DMA is physically busy
     bool busy = uart_tbuf[ch].busy;
-    bool has_pending = (uart_tbuf[ch].head != uart_tbuf[ch].tail);
+    bool has_pending = (uart_tbuf[ch].desc_head != uart_tbuf[ch].desc_tail);
     
     __set_PRIMASK(primask);
     
@@ -365,6 +679,24 @@ void UART_AbortTx(UART_Channel ch)
     uart_tbuf[ch].inflight_len = 0;
     
     __set_PRIMASK(primask);
+
+    // Hand referenced buffers back to their owners (outside critical section)
+    UART_TxRingBuf *tb = &uart_tbuf[ch];
+    while (1) {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        if (tb->desc_head == tb->desc_tail) {
+            __set_PRIMASK(primask);
+            break;
+        }
+        UART_TxDesc d = tb->desc[tb->desc_tail];
+        tb->desc_tail = UART_TX_DESC_NEXT(tb->desc_tail);
+        __set_PRIMASK(primask);
+
+        if (d.data && d.release) {
+            d.release(ch, d.data, d.len);
+        }
+    }
 }
 
 void UART_AbortRx(UART_Channel ch)
@@ -385,12 +717,9 @@ void UART_AbortRx(UART_Channel ch)
     // Reset RX Ring Buffer
     rb->head = 0;
     rb->tail = 0;
-    RxDMAPos[ch] = 0;
     
     // Restart DMA
-    if (rb->dma_buf && rb->dma_size > 0) {
-        HAL_UART_Receive_DMA(huart, rb->dma_buf, rb->dma_size);
-    }
+    UART_RestartRxDMA(ch, huart);
     
     __set_PRIMASK(primask);
 }
@@ -405,15 +734,14 @@ uint16_t UART_GetTxPending(UART_Channel ch)
     uint32_t primask = __get_PRIMASK();
     __disable_irq();
     
-    uint16_t pending;
-    if (tb->head >= tb->tail) {
-        pending = tb->head - tb->tail;
-    } else {
-        pending = tb->size - (tb->tail - tb->head);
+    // Ring bytes plus referenced buffers still queued (or in flight)
+    uint32_t pending = UART_TxRing_Used(tb);
+    for (uint8_t i = tb->desc_tail; i != tb->desc_head; i = UART_TX_DESC_NEXT(i)) {
+        if (tb->desc[i].data) pending += tb->desc[i].len;
     }
     
     __set_PRIMASK(primask);
-    return pending;
+    return (pending > 0xFFFF) ? 0xFFFF : (uint16_t)pending;
 }
 
 uint16_t UART_GetTxFree(UART_Channel ch)
@@ -423,8 +751,8 @@ uint16_t UART_GetTxFree(UART_Channel ch)
     UART_TxRingBuf *tb = &uart_tbuf[ch];
     if (!tb->buf || tb->size == 0) return 0;
     
-    // Free = Size - Pending - 1 (one slot always empty in ring buffer)
-    uint16_t pending = UART_GetTxPending(ch);
+    // Free = Size - Used - 1 (one slot always empty in ring buffer)
+    uint16_t pending = UART_TxRing_Used(tb);
     if (pending >= tb->size - 1) return 0;
     return tb->size - 1 - pending;
 }
@@ -454,17 +782,14 @@ void UART_Poll(void)
             uint32_t primask = __get_PRIMASK();
             __disable_irq();
             if (huart->RxState != HAL_UART_STATE_BUSY_RX) {
-                 if (uart_rbuf[i].dma_buf && uart_rbuf[i].dma_size > 0) {
-                    RxDMAPos[i] = 0;
-                    HAL_UART_Receive_DMA(huart, uart_rbuf[i].dma_buf, uart_rbuf[i].dma_size);
-                 }
+                UART_RestartRxDMA((UART_Channel)i, huart);
             }
             __set_PRIMASK(primask);
         }
         
         UART_ProcessDMA((UART_Channel)i);
         
-        if (uart_tbuf[i].head != uart_tbuf[i].tail) {
+        if (uart_tbuf[i].desc_head != uart_tbuf[i].desc_tail) {
             UART_TxKick((UART_Channel)i);
         }
     }
@@ -518,22 +843,39 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
     if (ch < 0 || ch >= UART_CHANNEL_MAX) return;
 
     UART_TxRingBuf *tb = &uart_tbuf[ch];
-    if (tb->size == 0) return;
+    if (!tb->busy || tb->desc_head == tb->desc_tail) return;
 
     // Critical section for tail/busy update
     uint32_t primask = __get_PRIMASK();
     __disable_irq();
 
-    tb->tail = (tb->tail + tb->inflight_len) % tb->size;
+    UART_TxDesc *d = &tb->desc[tb->desc_tail];
+    const uint8_t *ref = d->data;
+    uint16_t ref_len = d->len;
+    UART_TxReleaseCallback release = d->release;
+
+    if (ref) {
+        tb->desc_tail = UART_TX_DESC_NEXT(tb->desc_tail);
+    } else {
+        tb->tail = (tb->tail + tb->inflight_len) % tb->size;
+        d->len -= tb->inflight_len;
+        if (d->len == 0) {
+            tb->desc_tail = UART_TX_DESC_NEXT(tb->desc_tail);
+        }
+    }
     tb->inflight_len = 0;
     tb->busy = 0;
     
-    bool buffer_empty = (tb->head == tb->tail);
+    bool buffer_empty = (tb->desc_head == tb->desc_tail);
 
     __set_PRIMASK(primask);
 
-    // Try to send more if pending
+    // Chain the next descriptor first, then release the finished buffer
     UART_TxKick((UART_Channel)ch);
+
+    if (ref && release) {
+        release((UART_Channel)ch, ref, ref_len);
+    }
     
     // Fire TX Complete callback if buffer is now empty
     if (buffer_empty && TxCallbacks[ch]) {
@@ -541,6 +883,28 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
     }
 }
 
+#ifdef HAL_UART_RECEPTION_TOIDLE
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    int ch = UART_HandleToChannel(huart);
+    if (ch < 0) return;
+
+    // Size is the DMA index at the event; the counter read in ProcessRx is at least as recent
+    (void)Size;
+    bool received = UART_ProcessRx((UART_Channel)ch);
+
+#if UART_USE_FREERTOS
+    if (received && RxNotifyTasks[ch]) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(RxNotifyTasks[ch], &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+#else
+    (void)received;
+#endif
+}
+#endif
+
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
     int ch = UART_HandleToChannel(huart);
@@ -567,10 +931,7 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
     __HAL_UART_CLEAR_PEFLAG(huart);
     
     if (huart->RxState != HAL_UART_STATE_BUSY_RX) {
-         if (rb->dma_buf && rb->dma_size > 0) {
-            RxDMAPos[ch] = 0;
-            HAL_UART_Receive_DMA(huart, rb->dma_buf, rb->dma_size);
-         }
+        UART_RestartRxDMA((UART_Channel)ch, huart);
     }
     
     __set_PRIMASK(primask);
@@ -36,6 +36,16 @@ extern "C" {
     #include "main.h"
 #endif
 
+// Set to 1 to wake a task from the RX event interrupt (UART_SetRxNotifyTask)
+#ifndef UART_USE_FREERTOS
+#define UART_USE_FREERTOS 0
+#endif
+
+#if UART_USE_FREERTOS
+    #include "FreeRTOS.h"
+    #include "task.h"
+#endif
+
 // Logic channel ID, managed by user application
 typedef uint8_t UART_Channel;
 
@@ -52,6 +62,25 @@ typedef uint8_t UART_Channel;
 #define UART_DEBUG_CHANNEL 0
 #endif
 
+// TX descriptor queue depth per channel (one slot is kept empty)
+#ifndef UART_TX_DESC_MAX
+#define UART_TX_DESC_MAX 8
+#endif
+
+// UART_SendRef writes shorter than this are copied into the TX ring instead
+#ifndef UART_TX_REF_MIN
+#define UART_TX_REF_MIN 16
+#endif
+
+// Release callback for buffers handed over with UART_SendRef
+typedef void (*UART_TxReleaseCallback)(UART_Channel channel, const uint8_t *data, uint16_t len);
+
+typedef struct {
+    const uint8_t *data;            // NULL: len bytes come from the TX ring
+    uint16_t len;
+    UART_TxReleaseCallback release; // Called when a referenced buffer is no longer needed
+} UART_TxDesc;
+
 
 typedef struct {
     uint8_t *buf;
@@ -69,6 +98,8 @@ typedef struct {
     volatile uint32_t ore_error_cnt; // Overrun Errors
     volatile uint32_t dma_error_cnt; // DMA Transfer Errors
     volatile uint8_t error_flag;    // Error flag for recovery in main loop
+    uint8_t zero_copy;              // 1: buf is the DMA buffer itself (no ring copy)
+    volatile uint8_t rx_event;      // 1: ring is filled from the IDLE/HT/TC interrupt
 } UART_RingBuf;
 
 typedef struct {
@@ -78,6 +109,9 @@ typedef struct {
     volatile uint16_t tail;
     volatile uint8_t busy;
     uint16_t inflight_len;
+    UART_TxDesc desc[UART_TX_DESC_MAX]; // Transmit order: ring segments and referenced buffers
+    volatile uint8_t desc_head;
+    volatile uint8_t desc_tail;
 } UART_TxRingBuf;
 
 /* ============================================================================
@@ -90,6 +124,9 @@ typedef void (*UART_TxCallback)(UART_Channel channel);
 typedef void (*UART_ErrorCallback)(UART_Channel channel, uint32_t error_code);
 
 // Registration
+// Pass rx_ring_buf = NULL / rx_ring_size = 0 to use the RX DMA buffer itself as the
+// ring (zero-copy mode). The DMA buffer must then be large enough to hold everything
+// that arrives between two reads, as old data is overwritten by the DMA.
 void UART_Register(UART_Channel channel, UART_HandleTypeDef *huart, 
                    uint8_t *rx_dma_buf, uint16_t rx_dma_size,
                    uint8_t *rx_ring_buf, uint16_t rx_ring_size,
@@ -100,16 +137,42 @@ void UART_SetRxCallback(UART_Channel channel, UART_RxCallback cb);
 void UART_SetTxCallback(UART_Channel channel, UART_TxCallback cb);
 void UART_SetErrorCallback(UART_Channel channel, UART_ErrorCallback cb);
 
+// Event-driven Reception
+// Switches RX to HAL_UARTEx_ReceiveToIdle_DMA: received data is moved into the ring from the
+// IDLE / half / full transfer interrupts instead of UART_Poll. The RX callback (and the
+// optional task notification) then runs in interrupt context. Returns false if the HAL has
+// no ReceiveToIdle support.
+bool UART_SetRxEventMode(UART_Channel channel, bool enable);
+#if UART_USE_FREERTOS
+void UART_SetRxNotifyTask(UART_Channel channel, TaskHandle_t task);
+#endif
+// Moves what the RX DMA has received so far into the ring now, in either RX mode (e.g. to
+// time a gap on the line between two RX events). Runs the RX callback if there was data.
+void UART_PollRx(UART_Channel channel);
+
 // Transmission
 bool UART_Send(UART_Channel channel, const uint8_t *data, uint16_t len);
 void UART_SendString(UART_Channel channel, const char *str);
 
+// Zero-copy Transmission
+// The buffer is sent by DMA directly and must stay valid until release(ch, data, len) is called
+// (from the TX complete interrupt). Writes shorter than UART_TX_REF_MIN are copied into the ring
+// and released immediately if they fit whole (else queued by reference). Returns false if the
+// queue is full; nothing is queued and release is not called then.
+bool UART_SendRef(UART_Channel channel, const uint8_t *data, uint16_t len, UART_TxReleaseCallback release);
+
 // Reception
 uint16_t UART_Available(UART_Channel channel);
 bool UART_Read(UART_Channel channel, uint8_t *out);
 uint16_t UART_ReadBytes(UART_Channel channel, uint8_t *buf, uint16_t max_len);
 bool UART_Receive(UART_Channel channel, uint8_t *out, uint32_t timeout_ms);
 
+// Block Reception (lwrb-style)
+// PeekLinear returns the length of the contiguous readable block and points *data at it.
+// The data stays valid until UART_Skip() is called. A wrapped ring needs two calls.
+uint16_t UART_PeekLinear(UART_Channel channel, const uint8_t **data);
+uint16_t UART_Skip(UART_Channel channel, uint16_t len);
+
 // Control
 void UART_Flush(UART_Channel channel);
 void UART_AbortTx(UART_Channel channel);
@@ -117,8 +180,8 @@ void UART_AbortRx(UART_Channel channel);
 
 // Status
 bool UART_IsTxBusy(UART_Channel channel);
-uint16_t UART_GetTxPending(UART_Channel channel);
-uint16_t UART_GetTxFree(UART_Channel channel);
+uint16_t UART_GetTxPending(UART_Channel channel);    // Ring bytes + referenced buffers not yet sent
+uint16_t UART_GetTxFree(UART_Channel channel);       // Free space in the TX ring
 
 // Polling (Required for DMA processing)
 void UART_Poll(void);
@@ -1,6 +1,16 @@
 /**
  * @file usb_cdc.c
  * @brief USB CDC Wrapper Implementation
+ *
+ * RX: the OUT endpoint receives straight into a queue of packet slots. Each
+ * packet is handed over whole; the slot goes back to the USB stack when the
+ * application has consumed it, and the host is NAKed while none is free.
+ *
+ * TX: writes are copied into a ring. The oldest contiguous block goes out
+ * as one transfer, and the next block is started from the TX complete
+ * callback, so small writes made meanwhile leave as full-size packets. The
+ * host sees the end of n*64 bytes of data by a ZLP: the ST class sends it,
+ * with USB_CDC_CLASS_ZLP 0 this driver does when the ring runs empty.
  */
 
 #include "usb_cdc.h"
@@ -9,10 +19,10 @@
 #include <stdarg.h>
 
 // Include HAL/CubeMX generated Headers
-#include "main.h" 
+#include "main.h"
 // Expecting "usbd_cdc_if.h" to be available in include path for CDC_Transmit_FS
 // If user has not generated USB code, this will fail to link/compile.
-#include "usbd_cdc_if.h" 
+#include "usbd_cdc_if.h"
 #include "usbd_core.h" // For USBD_STATE_CONFIGURED
 
 extern USBD_HandleTypeDef hUsbDeviceFS;
@@ -21,32 +31,105 @@ extern USBD_HandleTypeDef hUsbDeviceFS;
  * Internal Types
  * ========================================================================= */
 typedef struct {
-    uint8_t buf[USB_RX_BUF_SIZE];
-    volatile uint32_t head;
-    volatile uint32_t tail;
+    uint8_t buf[USB_CDC_RX_PACKETS][USB_CDC_PACKET_SIZE];
+    volatile uint16_t len[USB_CDC_RX_PACKETS];
+    volatile uint32_t head;     // Packets received (ISR)
+    volatile uint32_t tail;     // Packets consumed
+    uint32_t offset;            // Bytes consumed in the tail packet
+    volatile bool paused;       // OUT endpoint left unarmed: no free slot
     volatile uint32_t overrun_cnt;
-} USB_RingBuf_t;
+} USB_RxQueue_t;
 
-static USB_RingBuf_t rx_rb;
+typedef struct {
+    uint8_t buf[USB_TX_BUF_SIZE];
+    volatile uint32_t head;     // Bytes written (free-running)
+    volatile uint32_t tail;     // Bytes sent (free-running)
+    volatile uint32_t inflight; // Bytes in the transfer in flight
+    volatile bool busy;         // Transfer or ZLP in flight
+    volatile bool need_zlp;     // Last transfer was n*64 bytes
+    volatile uint32_t drop_cnt;
+} USB_TxRing_t;
+
+static USB_RxQueue_t rx_q;
+static USB_TxRing_t tx_rb;
 
 /* ============================================================================
  * Internal Helpers
  * ========================================================================= */
-static void RB_Push(USB_RingBuf_t *rb, uint8_t b) {
-    uint32_t next = (rb->head + 1) % USB_RX_BUF_SIZE;
-    if (next != rb->tail) {
-        rb->buf[rb->head] = b;
-        rb->head = next;
+static bool USB_IsConfigured(void) {
+    return hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED;
+}
+
+// Hand the next free slot to the OUT endpoint (ISR or IRQs disabled)
+static void RX_Arm(void) {
+    if (rx_q.head - rx_q.tail >= USB_CDC_RX_PACKETS) {
+        rx_q.paused = true;
+        return;
+    }
+    rx_q.paused = false;
+    USBD_CDC_SetRxBuffer(&hUsbDeviceFS, rx_q.buf[rx_q.head % USB_CDC_RX_PACKETS]);
+    USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+}
+
+// Start the next transfer if the endpoint is idle (ISR or IRQs disabled)
+static void TX_Kick(void) {
+    if (tx_rb.busy || !USB_IsConfigured()) return;
+
+    uint32_t used = tx_rb.head - tx_rb.tail;
+    if (used == 0) {
+        if (tx_rb.need_zlp && CDC_Transmit_FS(tx_rb.buf, 0) == USBD_OK) {
+            tx_rb.need_zlp = false;
+            tx_rb.inflight = 0;
+            tx_rb.busy = true;
+        }
+        return;
+    }
+
+    // Oldest contiguous block: more data follows, so no ZLP is owed any more
+    uint32_t start = tx_rb.tail % USB_TX_BUF_SIZE;
+    uint32_t n = USB_TX_BUF_SIZE - start;
+    if (n > used) n = used;
+
+    if (CDC_Transmit_FS(&tx_rb.buf[start], (uint16_t)n) == USBD_OK) {
+        tx_rb.need_zlp = false;
+        tx_rb.inflight = n;
+        tx_rb.busy = true;
+    }
+}
+
+// Transfer done: free its bytes and start the next one (ISR or IRQs disabled)
+static void TX_Complete(void) {
+    USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef *)hUsbDeviceFS.pClassData;
+
+    if (!tx_rb.busy || (hcdc && hcdc->TxState != 0)) return;
+
+    tx_rb.tail += tx_rb.inflight;
+    tx_rb.need_zlp = !USB_CDC_CLASS_ZLP && tx_rb.inflight > 0 &&
+                     (tx_rb.inflight % USB_CDC_PACKET_SIZE) == 0;
+    tx_rb.inflight = 0;
+    tx_rb.busy = false;
+    TX_Kick();
+}
+
+// Finish the transfer in flight if the class is done with it, else start one
+// (ISR or IRQs disabled). Without a TransmitCplt hook this is what moves TX on.
+static void TX_Service(void) {
+    if (tx_rb.busy) {
+        TX_Complete();
     } else {
-        rb->overrun_cnt++;
+        TX_Kick();
     }
 }
 
-static bool RB_Pop(USB_RingBuf_t *rb, uint8_t *b) {
-    if (rb->head == rb->tail) return false;
-    *b = rb->buf[rb->tail];
-    rb->tail = (rb->tail + 1) % USB_RX_BUF_SIZE;
-    return true;
+// Copy into the ring; caller checked the space (IRQs disabled)
+static void TX_Write(const uint8_t *data, uint32_t len) {
+    uint32_t start = tx_rb.head % USB_TX_BUF_SIZE;
+    uint32_t first = USB_TX_BUF_SIZE - start;
+    if (first > len) first = len;
+
+    memcpy(&tx_rb.buf[start], data, first);
+    memcpy(tx_rb.buf, data + first, len - first);
+    tx_rb.head += len;
 }
 
 /* ============================================================================
@@ -62,34 +145,107 @@ void USB_CDC_Hack_Reset(void) {
     GPIO_InitStruct.Pin = GPIO_PIN_12;
     GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-    
+
     // 1. Take control of PA12 (USB D+)
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
     // 2. Pull Low to simulate disconnect
     HAL_GPIO_WritePin(GPIOA, GPIO_PIN_12, GPIO_PIN_RESET);
-    HAL_Delay(50); 
+    HAL_Delay(50);
     // 3. Release back to USB Peripheral
-    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_12, GPIO_PIN_SET); 
+    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_12, GPIO_PIN_SET);
     HAL_GPIO_DeInit(GPIOA, GPIO_PIN_12);
 #endif
 }
 
 void USB_CDC_Init(void) {
-    rx_rb.head = 0;
-    rx_rb.tail = 0;
-    rx_rb.overrun_cnt = 0;
+    uint32_t primask_bit = __get_PRIMASK();
+    __disable_irq();
+    rx_q.head = 0;
+    rx_q.tail = 0;
+    rx_q.offset = 0;
+    rx_q.overrun_cnt = 0;
+    // Until the first packet the endpoint may still hold the generated buffer
+    rx_q.paused = false;
+
+    tx_rb.head = 0;
+    tx_rb.tail = 0;
+    tx_rb.inflight = 0;
+    tx_rb.busy = false;
+    tx_rb.need_zlp = false;
+    tx_rb.drop_cnt = 0;
+    __set_PRIMASK(primask_bit);
 }
 
 uint32_t USB_CDC_Available(void) {
-    USB_RingBuf_t *rb = &rx_rb;
-    if (rb->head >= rb->tail) 
-        return rb->head - rb->tail;
-    else 
-        return USB_RX_BUF_SIZE - (rb->tail - rb->head);
+    uint32_t total = 0;
+    uint32_t head = rx_q.head;
+
+    for (uint32_t i = rx_q.tail; i != head; i++) {
+        total += rx_q.len[i % USB_CDC_RX_PACKETS];
+    }
+    return total - ((head != rx_q.tail) ? rx_q.offset : 0);
+}
+
+uint32_t USB_CDC_PeekPacket(const uint8_t **data) {
+    if (data == NULL) return 0;
+    if (rx_q.head == rx_q.tail) {
+        *data = NULL;
+        return 0;
+    }
+    uint32_t slot = rx_q.tail % USB_CDC_RX_PACKETS;
+    *data = &rx_q.buf[slot][rx_q.offset];
+    return rx_q.len[slot] - rx_q.offset;
+}
+
+uint32_t USB_CDC_Skip(uint32_t len) {
+    uint32_t skipped = 0;
+    bool freed = false;
+
+    while (len > 0 && rx_q.head != rx_q.tail) {
+        uint32_t slot = rx_q.tail % USB_CDC_RX_PACKETS;
+        uint32_t left = rx_q.len[slot] - rx_q.offset;
+        uint32_t n = (len < left) ? len : left;
+
+        rx_q.offset += n;
+        skipped += n;
+        len -= n;
+        if (rx_q.offset >= rx_q.len[slot]) {
+            rx_q.offset = 0;
+            rx_q.tail++;
+            freed = true;
+        }
+    }
+
+    // A slot came free while the host was being NAKed: re-arm the endpoint
+    if (freed && rx_q.paused) {
+        uint32_t primask_bit = __get_PRIMASK();
+        __disable_irq();
+        if (rx_q.paused) RX_Arm();
+        __set_PRIMASK(primask_bit);
+    }
+    return skipped;
 }
 
 bool USB_CDC_Read(uint8_t *byte) {
-    return RB_Pop(&rx_rb, byte);
+    const uint8_t *p;
+    if (byte == NULL || USB_CDC_PeekPacket(&p) == 0) return false;
+    *byte = *p;
+    USB_CDC_Skip(1);
+    return true;
+}
+
+uint32_t USB_CDC_ReadBytes(uint8_t *buf, uint32_t max_len) {
+    uint32_t count = 0;
+    const uint8_t *p;
+
+    while (count < max_len) {
+        uint32_t n = USB_CDC_PeekPacket(&p);
+        if (n == 0) break;
+        if (n > max_len - count) n = max_len - count;
+        memcpy(buf + count, p, n);
+        count += USB_CDC_Skip(n);
+    }
+    return count;
 }
 
 bool USB_CDC_Receive(uint8_t *out, uint32_t timeout_ms) {
@@ -104,9 +260,10 @@ void USB_CDC_Flush(void) {
     // Critical Section to prevent race condition with USB ISR
     uint32_t primask_bit = __get_PRIMASK();
     __disable_irq();
-    rx_rb.head = 0;
-    rx_rb.tail = 0;
-    rx_rb.overrun_cnt = 0;
+    rx_q.tail = rx_q.head;
+    rx_q.offset = 0;
+    rx_q.overrun_cnt = 0;
+    if (rx_q.paused) RX_Arm();
     __set_PRIMASK(primask_bit);
 }
 
@@ -114,50 +271,37 @@ bool USB_CDC_Send(const uint8_t *data, uint32_t len) {
     if (len == 0 || data == NULL) return false;
 
     // Check if USB is Configured (Enumerated by PC)
-    if (hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED) {
-        return false; 
+    if (!USB_IsConfigured()) {
+        return false;
     }
 
-    // Direct call to ST CDC Driver
-    // CDC_Transmit_FS is non-blocking BUT returns BUSY if previous transfer is not done.
-    
-    // Check if we are called from an ISR to avoid strictly time-based HAL_Delay/Ticker loops
-    // which might fail if SysTick is preempted.
-    bool is_isr = (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0;
-
+    // In an ISR the ring cannot drain while we wait: take all or nothing
+    bool is_isr = __get_IPSR() != 0;
     uint32_t start = HAL_GetTick();
-    uint8_t result;
-    
-    // Limits avoiding infinite loops in ISR
-    volatile uint32_t isr_loop_limit = 0; 
-    const uint32_t ISR_LIMIT_MAX = 0xFFFF;
-
-    do {
-        result = CDC_Transmit_FS((uint8_t*)data, (uint16_t)len);
-        
-        if (result == USBD_OK) return true;
-        
-        if (result == USBD_BUSY) {
-            if (is_isr) {
-                // In ISR, we cannot rely on HAL_GetTick() updating if interrupt priority > SysTick.
-                // Use a simple counter limit.
-                if (++isr_loop_limit > ISR_LIMIT_MAX) {
-                    return false;
-                }
-            } else {
-                // In Thread mode, use reliable time-based timeout
-                if ((HAL_GetTick() - start) > 50) { // 50ms Timeout
-                    return false;
-                }
-            }
-        } else {
-            // USBD_FAIL or USBD_BUSY is handled, anything else fail
+
+    while (len > 0) {
+        uint32_t primask_bit = __get_PRIMASK();
+        __disable_irq();
+
+        uint32_t space = USB_TX_BUF_SIZE - (tx_rb.head - tx_rb.tail);
+        uint32_t n = (len < space) ? len : space;
+        if (is_isr && n < len) n = 0;
+        if (n > 0) TX_Write(data, n);
+        TX_Service();
+        __set_PRIMASK(primask_bit);
+
+        data += n;
+        len -= n;
+        if (len == 0) break;
+
+        if (is_isr || (HAL_GetTick() - start) > USB_CDC_TX_TIMEOUT_MS || !USB_IsConfigured()) {
+            tx_rb.drop_cnt += len;
             return false;
         }
-
-    } while (result == USBD_BUSY);
-    
-    return false;
+        // Ring full: the host is slower than the producer
+        USB_CDC_Poll();
+    }
+    return true;
 }
 
 void USB_CDC_SendString(const char *str) {
@@ -165,13 +309,38 @@ void USB_CDC_SendString(const char *str) {
 }
 
 void USB_CDC_Printf(const char *fmt, ...) {
-    char buf[256];
+    char buf[USB_CDC_PRINTF_BUF_SIZE];
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buf, sizeof(buf), fmt, args);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
     va_end(args);
-    
-    USB_CDC_Send((uint8_t*)buf, strlen(buf));
+
+    if (n <= 0) return;
+    if (n >= (int)sizeof(buf)) n = sizeof(buf) - 1;
+    USB_CDC_Send((uint8_t*)buf, (uint32_t)n);
+}
+
+uint32_t USB_CDC_GetTxPending(void) {
+    return tx_rb.head - tx_rb.tail;
+}
+
+uint32_t USB_CDC_GetTxFree(void) {
+    return USB_TX_BUF_SIZE - (tx_rb.head - tx_rb.tail);
+}
+
+uint32_t USB_CDC_GetRxOverrunCount(void) {
+    return rx_q.overrun_cnt;
+}
+
+uint32_t USB_CDC_GetTxDropCount(void) {
+    return tx_rb.drop_cnt;
+}
+
+void USB_CDC_Poll(void) {
+    uint32_t primask_bit = __get_PRIMASK();
+    __disable_irq();
+    TX_Service();
+    __set_PRIMASK(primask_bit);
 }
 
 /* ============================================================================
@@ -179,7 +348,22 @@ void USB_CDC_Printf(const char *fmt, ...) {
  * ========================================================================= */
 
 void USB_CDC_RxCallback(uint8_t *Buf, uint32_t Len) {
-    for (uint32_t i = 0; i < Len; i++) {
-        RB_Push(&rx_rb, Buf[i]);
+    if (Len > USB_CDC_PACKET_SIZE) Len = USB_CDC_PACKET_SIZE;
+
+    if (Len > 0) {
+        if (rx_q.head - rx_q.tail < USB_CDC_RX_PACKETS) {
+            uint32_t slot = rx_q.head % USB_CDC_RX_PACKETS;
+            // Normally received in place; the first packet may be in the generated buffer
+            if (Buf != rx_q.buf[slot]) memcpy(rx_q.buf[slot], Buf, Len);
+            rx_q.len[slot] = (uint16_t)Len;
+            rx_q.head++;
+        } else {
+            rx_q.overrun_cnt += Len;
+        }
     }
+    RX_Arm();
+}
+
+void USB_CDC_TxCpltCallback(void) {
+    TX_Complete();
 }
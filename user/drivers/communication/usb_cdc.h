@@ -8,24 +8,74 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 
+// Full-speed bulk packet size
+#define USB_CDC_PACKET_SIZE 64
+
+// RX queue: whole packets, USB_RX_BUF_SIZE / USB_CDC_PACKET_SIZE of them
 #ifndef USB_RX_BUF_SIZE
 #define USB_RX_BUF_SIZE 512
 #endif
+#define USB_CDC_RX_PACKETS (USB_RX_BUF_SIZE / USB_CDC_PACKET_SIZE)
+
+// TX ring: writes are coalesced here and sent as one transfer per contiguous block
+#ifndef USB_TX_BUF_SIZE
+#define USB_TX_BUF_SIZE 1024
+#endif
+
+// How long USB_CDC_Send waits for ring space in thread mode (never in an ISR)
+#ifndef USB_CDC_TX_TIMEOUT_MS
+#define USB_CDC_TX_TIMEOUT_MS 50
+#endif
+
+// 1: the CDC class ends transfers of n*64 bytes with a ZLP itself, as the ST
+// USB Device library in this tree does (usbd_cdc.c DataIn). Set to 0 for a
+// class that does not, and the driver sends the ZLP instead
+#ifndef USB_CDC_CLASS_ZLP
+#define USB_CDC_CLASS_ZLP 1
+#endif
+
+#ifndef USB_CDC_PRINTF_BUF_SIZE
+#define USB_CDC_PRINTF_BUF_SIZE 128
+#endif
 
 void USB_CDC_Init(void);
 void USB_CDC_Hack_Reset(void);
 
 uint32_t USB_CDC_Available(void);
 bool USB_CDC_Read(uint8_t *byte);
+uint32_t USB_CDC_ReadBytes(uint8_t *buf, uint32_t max_len);
 bool USB_CDC_Receive(uint8_t *out, uint32_t timeout_ms);
 void USB_CDC_Flush(void);
 
+// Packet Reception (zero-copy)
+// PeekPacket points *data at the unread part of the oldest packet and returns its length.
+// The data stays valid until USB_CDC_Skip() consumes it. A packet slot is handed back to
+// the USB stack once fully consumed; while all slots are full the host is NAKed.
+uint32_t USB_CDC_PeekPacket(const uint8_t **data);
+uint32_t USB_CDC_Skip(uint32_t len);
+
+// Queue data for sending. Returns false if not configured or if it did not fit
+// (after USB_CDC_TX_TIMEOUT_MS in thread mode; at once in an ISR).
 bool USB_CDC_Send(const uint8_t *data, uint32_t len);
 void USB_CDC_SendString(const char *str);
 void USB_CDC_Printf(const char *fmt, ...);
 
-// Hook for usbd_cdc_if.c
+// Status
+uint32_t USB_CDC_GetTxPending(void);
+uint32_t USB_CDC_GetTxFree(void);
+uint32_t USB_CDC_GetRxOverrunCount(void);
+uint32_t USB_CDC_GetTxDropCount(void);
+
+// Completes transfers and restarts TX when CDC_TransmitCplt_FS is not hooked.
+// USB_CDC_Send also checks for a finished transfer, so sends never stall; the
+// F103 class has no TransmitCplt hook and relies on that (or on this poll).
+void USB_CDC_Poll(void);
+
+// Hooks for usbd_cdc_if.c: CDC_Receive_FS calls USB_CDC_RxCallback and must
+// not re-arm the OUT endpoint itself; CDC_TransmitCplt_FS (F4) calls
+// USB_CDC_TxCpltCallback
 void USB_CDC_RxCallback(uint8_t *Buf, uint32_t Len);
+void USB_CDC_TxCpltCallback(void);
 
 #ifdef __cplusplus
 }
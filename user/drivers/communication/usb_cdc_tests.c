@@ -16,13 +16,14 @@ void app_main(void)
     USB_CDC_SendString("\r\n===================================\r\n");
     USB_CDC_SendString("      USB CDC Driver Test Suite    \r\n");
     USB_CDC_SendString("===================================\r\n");
-    USB_CDC_Printf("Cmds: [s]SendBursts [f]Flush [e]Echo \r\n");
+    USB_CDC_Printf("Cmds: [s]SendBursts [t]Throughput [f]Flush [e]Echo \r\n");
 
     uint32_t last_tick = 0;
 
     while (1)
     {
-        // No Poll() needed for USB CDC (it's interrupt driven from USB stack)
+        // Only needed if CDC_TransmitCplt_FS is not hooked (older USB Device library)
+        USB_CDC_Poll();
 
         // 4. Heartbeat
         if (HAL_GetTick() - last_tick > 1000) {
@@ -44,6 +45,18 @@ void app_main(void)
                         USB_CDC_SendString("[Test] Sending Burst 3...\r\n");
                         break;
                     
+                    case 't': // Test Throughput: 64 KB of small writes, coalesced by the TX ring
+                    {
+                        uint32_t t0 = HAL_GetTick();
+                        for (uint32_t i = 0; i < 4096; i++) {
+                            USB_CDC_Printf("%08lX:01234\r\n", i);
+                        }
+                        uint32_t ms = HAL_GetTick() - t0;
+                        USB_CDC_Printf("[Test] 64 KB queued in %lu ms, dropped %lu\r\n",
+                                       ms, USB_CDC_GetTxDropCount());
+                        break;
+                    }
+
                     case 'f': // Test Flush
                         USB_CDC_Printf("[Test] Flushing Rx Buffer... \r\n");
                         USB_CDC_Flush();
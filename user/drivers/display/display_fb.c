@@ -0,0 +1,195 @@
+/**
+ * @file display_fb.c
+ * @brief Framebuffer with dirty-rectangle tracking for the SPI TFT drivers
+ */
+
+#include "display_fb.h"
+
+// --- Private Functions ---
+
+static uint32_t Display_FB_Area(const Display_FB_Rect *r) {
+    return (uint32_t)(r->x1 - r->x0 + 1) * (uint32_t)(r->y1 - r->y0 + 1);
+}
+
+static Display_FB_Rect Display_FB_Union(const Display_FB_Rect *a, const Display_FB_Rect *b) {
+    Display_FB_Rect u;
+    u.x0 = (a->x0 < b->x0) ? a->x0 : b->x0;
+    u.y0 = (a->y0 < b->y0) ? a->y0 : b->y0;
+    u.x1 = (a->x1 > b->x1) ? a->x1 : b->x1;
+    u.y1 = (a->y1 > b->y1) ? a->y1 : b->y1;
+    return u;
+}
+
+// Clean pixels that merging a and b would send on top of their own pixels
+static uint32_t Display_FB_MergeCost(const Display_FB_Rect *a, const Display_FB_Rect *b) {
+    Display_FB_Rect u = Display_FB_Union(a, b);
+    uint32_t sum = Display_FB_Area(a) + Display_FB_Area(b);
+    uint32_t area = Display_FB_Area(&u);
+
+    return (area > sum) ? (area - sum) : 0;
+}
+
+static void Display_FB_Remove(Display_FB_HandleTypeDef *hfb, uint8_t idx) {
+    hfb->DirtyCount--;
+    hfb->Dirty[idx] = hfb->Dirty[hfb->DirtyCount];
+}
+
+// Merge region idx with every region it is cheap to combine with
+static void Display_FB_Coalesce(Display_FB_HandleTypeDef *hfb, uint8_t idx) {
+    bool merged = true;
+
+    while (merged) {
+        merged = false;
+        for (uint8_t i = 0; i < hfb->DirtyCount; i++) {
+            if (i == idx) continue;
+            if (Display_FB_MergeCost(&hfb->Dirty[idx], &hfb->Dirty[i]) <= DISPLAY_FB_MERGE_SLACK) {
+                hfb->Dirty[idx] = Display_FB_Union(&hfb->Dirty[idx], &hfb->Dirty[i]);
+                Display_FB_Remove(hfb, i);
+                // The last entry moved into slot i
+                if (idx == hfb->DirtyCount) idx = i;
+                merged = true;
+                break;
+            }
+        }
+    }
+}
+
+static void Display_FB_AddDirty(Display_FB_HandleTypeDef *hfb, const Display_FB_Rect *r) {
+    uint8_t best = 0;
+    uint32_t best_cost = UINT32_MAX;
+
+    for (uint8_t i = 0; i < hfb->DirtyCount; i++) {
+        uint32_t cost = Display_FB_MergeCost(&hfb->Dirty[i], r);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = i;
+        }
+    }
+
+    if (hfb->DirtyCount > 0 && (best_cost <= DISPLAY_FB_MERGE_SLACK || hfb->DirtyCount >= DISPLAY_FB_MAX_DIRTY)) {
+        // Cheap to combine, or out of slots: grow the closest region
+        hfb->Dirty[best] = Display_FB_Union(&hfb->Dirty[best], r);
+        Display_FB_Coalesce(hfb, best);
+        return;
+    }
+
+    hfb->Dirty[hfb->DirtyCount] = *r;
+    hfb->DirtyCount++;
+}
+
+// Clip x/y/w/h to the canvas; false if nothing is left
+static bool Display_FB_Clip(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                            Display_FB_Rect *r) {
+    if (w == 0 || h == 0 || x >= hfb->Width || y >= hfb->Height) return false;
+    if ((uint32_t)x + w > hfb->Width) w = hfb->Width - x;
+    if ((uint32_t)y + h > hfb->Height) h = hfb->Height - y;
+
+    r->x0 = x;
+    r->y0 = y;
+    r->x1 = x + w - 1;
+    r->y1 = y + h - 1;
+    return true;
+}
+
+// --- Public Functions ---
+
+void Display_FB_Init(Display_FB_HandleTypeDef *hfb, Display_SPI_HandleTypeDef *bus,
+                     uint16_t *pixels, uint16_t width, uint16_t height,
+                     uint16_t x_off, uint16_t y_off)
+{
+    hfb->Bus = bus;
+    hfb->Pixels = pixels;
+    hfb->Width = width;
+    hfb->Height = height;
+    hfb->XOffset = x_off;
+    hfb->YOffset = y_off;
+    hfb->DirtyCount = 0;
+    hfb->FlushCount = 0;
+    hfb->RegionsSent = 0;
+    hfb->PixelsSent = 0;
+
+    Display_FB_InvalidateAll(hfb);
+}
+
+void Display_FB_DrawPixel(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y, uint16_t color) {
+    Display_FB_Rect r;
+
+    if (x >= hfb->Width || y >= hfb->Height) return;
+    if (hfb->Pixels[(uint32_t)y * hfb->Width + x] == color) return;
+
+    hfb->Pixels[(uint32_t)y * hfb->Width + x] = color;
+    r.x0 = r.x1 = x;
+    r.y0 = r.y1 = y;
+    Display_FB_AddDirty(hfb, &r);
+}
+
+void Display_FB_FillRect(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    Display_FB_Rect r;
+
+    if (!Display_FB_Clip(hfb, x, y, w, h, &r)) return;
+
+    for (uint16_t row = r.y0; row <= r.y1; row++) {
+        uint16_t *dst = &hfb->Pixels[(uint32_t)row * hfb->Width];
+        for (uint16_t col = r.x0; col <= r.x1; col++) {
+            dst[col] = color;
+        }
+    }
+    Display_FB_AddDirty(hfb, &r);
+}
+
+void Display_FB_DrawImage(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *data) {
+    Display_FB_Rect r;
+
+    if (data == NULL || !Display_FB_Clip(hfb, x, y, w, h, &r)) return;
+
+    // Clipped images keep their source stride
+    for (uint16_t row = r.y0; row <= r.y1; row++) {
+        const uint16_t *src = &data[(uint32_t)(row - y) * w];
+        uint16_t *dst = &hfb->Pixels[(uint32_t)row * hfb->Width];
+        for (uint16_t col = r.x0; col <= r.x1; col++) {
+            dst[col] = src[col - x];
+        }
+    }
+    Display_FB_AddDirty(hfb, &r);
+}
+
+uint16_t Display_FB_GetPixel(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y) {
+    if (x >= hfb->Width || y >= hfb->Height) return 0;
+    return hfb->Pixels[(uint32_t)y * hfb->Width + x];
+}
+
+void Display_FB_Invalidate(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    Display_FB_Rect r;
+
+    if (Display_FB_Clip(hfb, x, y, w, h, &r)) {
+        Display_FB_AddDirty(hfb, &r);
+    }
+}
+
+void Display_FB_InvalidateAll(Display_FB_HandleTypeDef *hfb) {
+    hfb->DirtyCount = 0;
+    Display_FB_Invalidate(hfb, 0, 0, hfb->Width, hfb->Height);
+}
+
+uint8_t Display_FB_Flush(Display_FB_HandleTypeDef *hfb) {
+    uint8_t sent = hfb->DirtyCount;
+
+    for (uint8_t i = 0; i < hfb->DirtyCount; i++) {
+        const Display_FB_Rect *r = &hfb->Dirty[i];
+        uint16_t w = r->x1 - r->x0 + 1;
+        uint16_t h = r->y1 - r->y0 + 1;
+
+        // SetWindow waits for the previous region's stream
+        Display_SPI_SetWindow(hfb->Bus, hfb->XOffset + r->x0, hfb->YOffset + r->y0,
+                              hfb->XOffset + r->x1, hfb->YOffset + r->y1);
+        Display_SPI_WriteRect(hfb->Bus, &hfb->Pixels[(uint32_t)r->y0 * hfb->Width + r->x0],
+                              w, h, hfb->Width);
+        hfb->PixelsSent += (uint32_t)w * h;
+    }
+    Display_SPI_Wait(hfb->Bus);
+
+    hfb->RegionsSent += sent;
+    hfb->FlushCount++;
+    hfb->DirtyCount = 0;
+    return sent;
+}
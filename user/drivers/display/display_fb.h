@@ -0,0 +1,95 @@
+/**
+ * @file display_fb.h
+ * @brief Framebuffer with dirty-rectangle tracking for the SPI TFT drivers
+ *
+ * Drawing goes into a RAM canvas (RGB565, native endianness) and only marks
+ * the touched area dirty. Display_FB_Flush() sends each dirty region with a
+ * single address window and one DMA stream, so a dashboard that changes a few
+ * fields per frame sends those fields and nothing else.
+ *
+ * The canvas does not have to cover the whole panel: a 120x32 canvas placed
+ * at (XOffset, YOffset) works as a tile for one screen area and keeps RAM
+ * use small on parts that cannot hold a full frame.
+ *
+ * Usage (ILI9341 or ST7789, both embed a Display_SPI_HandleTypeDef):
+ *   static uint16_t pixels[240 * 320];
+ *   Display_FB_Init(&fb, &hlcd.Bus, pixels, 240, 320, 0, 0);
+ *   Display_FB_FillRect(&fb, 10, 10, 60, 16, ILI9341_BLACK);
+ *   Display_FB_Flush(&fb);
+ */
+
+#ifndef __DISPLAY_FB_H
+#define __DISPLAY_FB_H
+
+#include "main.h"
+#include "display_spi.h"
+#include <stdbool.h>
+
+// Dirty regions tracked at once; when full, the closest pair is merged
+#ifndef DISPLAY_FB_MAX_DIRTY
+#define DISPLAY_FB_MAX_DIRTY 8
+#endif
+
+// Clean pixels worth sending to save one address window setup
+#ifndef DISPLAY_FB_MERGE_SLACK
+#define DISPLAY_FB_MERGE_SLACK 64
+#endif
+
+// Inclusive canvas coordinates
+typedef struct {
+    uint16_t x0;
+    uint16_t y0;
+    uint16_t x1;
+    uint16_t y1;
+} Display_FB_Rect;
+
+typedef struct {
+    Display_SPI_HandleTypeDef *Bus;
+    uint16_t          *Pixels;      // Width * Height, row major
+    uint16_t          Width;
+    uint16_t          Height;
+    uint16_t          XOffset;      // Panel position of canvas pixel (0,0)
+    uint16_t          YOffset;
+
+    Display_FB_Rect   Dirty[DISPLAY_FB_MAX_DIRTY];
+    uint8_t           DirtyCount;
+
+    // Statistics
+    uint32_t          FlushCount;
+    uint32_t          RegionsSent;
+    uint32_t          PixelsSent;
+} Display_FB_HandleTypeDef;
+
+/* Function Prototypes */
+
+/**
+ * @brief Attach a canvas to a display transport
+ * @param pixels Canvas memory, width * height pixels
+ * @param x_off  Panel X of the canvas origin
+ * @param y_off  Panel Y of the canvas origin
+ * @note  The whole canvas starts dirty so the first flush draws it
+ */
+void Display_FB_Init(Display_FB_HandleTypeDef *hfb, Display_SPI_HandleTypeDef *bus,
+                     uint16_t *pixels, uint16_t width, uint16_t height,
+                     uint16_t x_off, uint16_t y_off);
+
+void Display_FB_DrawPixel(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y, uint16_t color);
+void Display_FB_FillRect(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+void Display_FB_DrawImage(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *data);
+uint16_t Display_FB_GetPixel(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y);
+
+/**
+ * @brief Mark an area dirty after writing hfb->Pixels directly
+ */
+void Display_FB_Invalidate(Display_FB_HandleTypeDef *hfb, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+void Display_FB_InvalidateAll(Display_FB_HandleTypeDef *hfb);
+
+/**
+ * @brief Send all dirty regions to the panel, one address window each
+ * @return Number of regions sent
+ * @note  Blocks until the last region is out, so the canvas can be drawn
+ *        into again as soon as it returns
+ */
+uint8_t Display_FB_Flush(Display_FB_HandleTypeDef *hfb);
+
+#endif // __DISPLAY_FB_H
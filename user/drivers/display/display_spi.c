@@ -0,0 +1,299 @@
+/**
+ * @file display_spi.c
+ * @brief Shared SPI transport for DCS TFT controllers
+ */
+
+#include "display_spi.h"
+#include "spi_dma.h"
+
+// Upper bound for one pixel stream (a full 480x320 RGB666 frame at 1 MHz is ~3.7 s)
+#ifndef DISPLAY_SPI_TIMEOUT_MS
+#define DISPLAY_SPI_TIMEOUT_MS 5000
+#endif
+
+// --- Private Functions ---
+
+static void Display_SPI_Select(Display_SPI_HandleTypeDef *hdsp) {
+    HAL_GPIO_WritePin(hdsp->CsPort, hdsp->CsPin, GPIO_PIN_RESET);
+}
+
+static void Display_SPI_Deselect(Display_SPI_HandleTypeDef *hdsp) {
+    HAL_GPIO_WritePin(hdsp->CsPort, hdsp->CsPin, GPIO_PIN_SET);
+}
+
+static void Display_SPI_Cmd(Display_SPI_HandleTypeDef *hdsp, uint8_t cmd) {
+    HAL_GPIO_WritePin(hdsp->DcPort, hdsp->DcPin, GPIO_PIN_RESET);
+    HAL_SPI_Transmit(hdsp->hspi, &cmd, 1, 100);
+    HAL_GPIO_WritePin(hdsp->DcPort, hdsp->DcPin, GPIO_PIN_SET);
+}
+
+// Convert the next chunk of the stream into buffer idx
+static void Display_SPI_Prepare(Display_SPI_HandleTypeDef *hdsp, uint8_t idx) {
+    uint32_t max_pixels = DISPLAY_SPI_BUF_BYTES / hdsp->PixelBytes;
+    uint32_t n = (hdsp->Remaining > max_pixels) ? max_pixels : hdsp->Remaining;
+
+    if (n == 0) {
+        hdsp->Len[idx] = 0;
+        return;
+    }
+
+    // Fill streams: both buffers were filled with the color once at the start
+    if (hdsp->Src != NULL) {
+        uint8_t *dst = hdsp->Buf[idx];
+        uint32_t left = n;
+
+        while (left > 0) {
+            // Convert up to the end of the current source row
+            const uint16_t *src = hdsp->Src;
+            uint32_t run = (left < hdsp->RowLeft) ? left : hdsp->RowLeft;
+
+            if (hdsp->PixelBytes == DISPLAY_SPI_RGB565) {
+                for (uint32_t i = 0; i < run; i++) {
+                    *dst++ = (uint8_t)(src[i] >> 8);
+                    *dst++ = (uint8_t)src[i];
+                }
+            } else {
+                for (uint32_t i = 0; i < run; i++) {
+                    uint16_t color = src[i];
+                    *dst++ = (uint8_t)((((color >> 11) & 0x1F) * 527 + 23) >> 6);
+                    *dst++ = (uint8_t)((((color >> 5) & 0x3F) * 259 + 33) >> 6);
+                    *dst++ = (uint8_t)(((color & 0x1F) * 527 + 23) >> 6);
+                }
+            }
+
+            left -= run;
+            hdsp->RowLeft -= run;
+            if (hdsp->RowLeft == 0) {
+                hdsp->Src += run + (hdsp->Stride - hdsp->RowPixels);
+                hdsp->RowLeft = hdsp->RowPixels;
+            } else {
+                hdsp->Src += run;
+            }
+        }
+    }
+
+    hdsp->Remaining -= n;
+    hdsp->Len[idx] = (uint16_t)(n * hdsp->PixelBytes);
+}
+
+static void Display_SPI_Finish(Display_SPI_HandleTypeDef *hdsp) {
+    Display_SPI_Deselect(hdsp);
+    hdsp->Len[0] = 0;
+    hdsp->Len[1] = 0;
+    hdsp->Busy = 0;
+
+    if (hdsp->DoneCb) {
+        hdsp->DoneCb(hdsp->DoneCtx);
+    }
+}
+
+static void Display_SPI_DmaDone(void *ctx, bool ok);
+
+static void Display_SPI_Kick(Display_SPI_HandleTypeDef *hdsp, uint8_t idx) {
+    hdsp->Active = idx;
+    if (SPI_DMA_Transmit(hdsp->hspi, hdsp->Buf[idx], hdsp->Len[idx], Display_SPI_DmaDone, hdsp) != HAL_OK) {
+        hdsp->Errors++;
+        Display_SPI_Finish(hdsp);
+    }
+}
+
+// DMA complete interrupt: start the buffer prepared meanwhile, refill the one just sent
+static void Display_SPI_DmaDone(void *ctx, bool ok) {
+    Display_SPI_HandleTypeDef *hdsp = (Display_SPI_HandleTypeDef *)ctx;
+    uint8_t done = hdsp->Active;
+    uint8_t next = done ^ 1;
+
+    hdsp->Len[done] = 0;
+    if (!ok) {
+        hdsp->Errors++;
+        Display_SPI_Finish(hdsp);
+        return;
+    }
+
+    if (hdsp->Len[next] == 0) {
+        Display_SPI_Finish(hdsp);
+        return;
+    }
+
+    Display_SPI_Kick(hdsp, next);
+    Display_SPI_Prepare(hdsp, done);
+}
+
+static void Display_SPI_Start(Display_SPI_HandleTypeDef *hdsp) {
+    hdsp->Busy = 1;
+    Display_SPI_Select(hdsp);
+    HAL_GPIO_WritePin(hdsp->DcPort, hdsp->DcPin, GPIO_PIN_SET);
+
+    Display_SPI_Prepare(hdsp, 0);
+    Display_SPI_Prepare(hdsp, 1);
+
+    if (hdsp->UseDMA) {
+        if (hdsp->Len[0] > 0) {
+            Display_SPI_Kick(hdsp, 0);
+        } else {
+            Display_SPI_Finish(hdsp);
+        }
+        return;
+    }
+
+    // No DMA: same ping-pong order, blocking
+    uint8_t idx = 0;
+    while (hdsp->Len[idx] > 0) {
+        HAL_SPI_Transmit(hdsp->hspi, hdsp->Buf[idx], hdsp->Len[idx], 1000);
+        hdsp->Len[idx] = 0;
+        Display_SPI_Prepare(hdsp, idx);
+        idx ^= 1;
+    }
+    Display_SPI_Finish(hdsp);
+}
+
+// --- Public Functions ---
+
+void Display_SPI_Init(Display_SPI_HandleTypeDef *hdsp, SPI_HandleTypeDef *hspi,
+                      GPIO_TypeDef *cs_port, uint16_t cs_pin,
+                      GPIO_TypeDef *dc_port, uint16_t dc_pin,
+                      uint8_t pixel_bytes)
+{
+    hdsp->hspi = hspi;
+    hdsp->CsPort = cs_port; hdsp->CsPin = cs_pin;
+    hdsp->DcPort = dc_port; hdsp->DcPin = dc_pin;
+    hdsp->PixelBytes = (pixel_bytes == DISPLAY_SPI_RGB666) ? DISPLAY_SPI_RGB666 : DISPLAY_SPI_RGB565;
+    hdsp->UseDMA = SPI_DMA_HasTx(hspi) ? 1 : 0;
+    hdsp->Len[0] = 0;
+    hdsp->Len[1] = 0;
+    hdsp->Active = 0;
+    hdsp->Src = NULL;
+    hdsp->RowPixels = 0;
+    hdsp->RowLeft = 0;
+    hdsp->Stride = 0;
+    hdsp->Remaining = 0;
+    hdsp->Busy = 0;
+    hdsp->Errors = 0;
+    hdsp->DoneCb = NULL;
+    hdsp->DoneCtx = NULL;
+
+    Display_SPI_Deselect(hdsp);
+}
+
+void Display_SPI_WriteCommand(Display_SPI_HandleTypeDef *hdsp, uint8_t cmd, const uint8_t *params, uint16_t len) {
+    Display_SPI_Wait(hdsp);
+
+    Display_SPI_Select(hdsp);
+    Display_SPI_Cmd(hdsp, cmd);
+    if (params != NULL && len > 0) {
+        HAL_SPI_Transmit(hdsp->hspi, (uint8_t *)params, len, 100);
+    }
+    Display_SPI_Deselect(hdsp);
+}
+
+void Display_SPI_SetWindow(Display_SPI_HandleTypeDef *hdsp, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+    uint8_t data[4];
+
+    Display_SPI_Wait(hdsp);
+    Display_SPI_Select(hdsp);
+
+    Display_SPI_Cmd(hdsp, DISPLAY_SPI_CASET);
+    data[0] = (x0 >> 8) & 0xFF;
+    data[1] = x0 & 0xFF;
+    data[2] = (x1 >> 8) & 0xFF;
+    data[3] = x1 & 0xFF;
+    HAL_SPI_Transmit(hdsp->hspi, data, 4, 100);
+
+    Display_SPI_Cmd(hdsp, DISPLAY_SPI_RASET);
+    data[0] = (y0 >> 8) & 0xFF;
+    data[1] = y0 & 0xFF;
+    data[2] = (y1 >> 8) & 0xFF;
+    data[3] = y1 & 0xFF;
+    HAL_SPI_Transmit(hdsp->hspi, data, 4, 100);
+
+    Display_SPI_Cmd(hdsp, DISPLAY_SPI_RAMWR);
+    Display_SPI_Deselect(hdsp);
+}
+
+void Display_SPI_WriteData(Display_SPI_HandleTypeDef *hdsp, const uint8_t *data, uint16_t len) {
+    Display_SPI_Wait(hdsp);
+
+    Display_SPI_Select(hdsp);
+    HAL_GPIO_WritePin(hdsp->DcPort, hdsp->DcPin, GPIO_PIN_SET);
+    HAL_SPI_Transmit(hdsp->hspi, (uint8_t *)data, len, 1000);
+    Display_SPI_Deselect(hdsp);
+}
+
+void Display_SPI_WritePixels(Display_SPI_HandleTypeDef *hdsp, const uint16_t *pixels, uint32_t count) {
+    if (pixels == NULL || count == 0) return;
+    Display_SPI_Wait(hdsp);
+
+    // One row as long as the whole stream
+    hdsp->Src = pixels;
+    hdsp->RowPixels = 0xFFFF;
+    hdsp->RowLeft = 0xFFFF;
+    hdsp->Stride = 0xFFFF;
+    hdsp->Remaining = count;
+    Display_SPI_Start(hdsp);
+}
+
+void Display_SPI_WriteRect(Display_SPI_HandleTypeDef *hdsp, const uint16_t *pixels,
+                           uint16_t w, uint16_t h, uint16_t stride)
+{
+    if (pixels == NULL || w == 0 || h == 0 || stride < w) return;
+    Display_SPI_Wait(hdsp);
+
+    hdsp->Src = pixels;
+    hdsp->RowPixels = w;
+    hdsp->RowLeft = w;
+    hdsp->Stride = stride;
+    hdsp->Remaining = (uint32_t)w * h;
+    Display_SPI_Start(hdsp);
+}
+
+void Display_SPI_Fill(Display_SPI_HandleTypeDef *hdsp, uint16_t color, uint32_t count) {
+    if (count == 0) return;
+    Display_SPI_Wait(hdsp);
+
+    // Encode the color once, then fill both buffers with it
+    uint8_t px[3];
+    uint32_t max_pixels = DISPLAY_SPI_BUF_BYTES / hdsp->PixelBytes;
+    uint32_t n = (count > max_pixels) ? max_pixels : count;
+
+    hdsp->Src = &color;
+    hdsp->RowLeft = 1;
+    hdsp->RowPixels = 1;
+    hdsp->Stride = 1;
+    hdsp->Remaining = 1;
+    Display_SPI_Prepare(hdsp, 0);
+    for (uint8_t b = 0; b < hdsp->PixelBytes; b++) px[b] = hdsp->Buf[0][b];
+
+    for (uint32_t i = 0; i < n * hdsp->PixelBytes; i += hdsp->PixelBytes) {
+        for (uint8_t b = 0; b < hdsp->PixelBytes; b++) {
+            hdsp->Buf[0][i + b] = px[b];
+            hdsp->Buf[1][i + b] = px[b];
+        }
+    }
+
+    hdsp->Src = NULL;
+    hdsp->Color = color;
+    hdsp->Remaining = count;
+    Display_SPI_Start(hdsp);
+}
+
+void Display_SPI_Wait(Display_SPI_HandleTypeDef *hdsp) {
+    uint32_t start = HAL_GetTick();
+
+    while (hdsp->Busy) {
+        if ((HAL_GetTick() - start) > DISPLAY_SPI_TIMEOUT_MS) {
+            HAL_SPI_Abort(hdsp->hspi);
+            hdsp->Errors++;
+            Display_SPI_Finish(hdsp);
+            break;
+        }
+    }
+}
+
+bool Display_SPI_IsBusy(Display_SPI_HandleTypeDef *hdsp) {
+    return hdsp->Busy != 0;
+}
+
+void Display_SPI_SetDoneCallback(Display_SPI_HandleTypeDef *hdsp, Display_SPI_DoneCallback cb, void *ctx) {
+    hdsp->DoneCb = cb;
+    hdsp->DoneCtx = ctx;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file display_spi.h
+ * @brief Shared SPI transport for DCS TFT controllers (ILI9341, ILI9488, ST7735, ST7789)
+ *
+ * Commands and their parameters go out in one CS window. Pixel streams use two
+ * ping-pong buffers: while DMA sends chunk N, chunk N+1 is converted (byte swap
+ * for RGB565, expansion for RGB666) into the other buffer from the DMA complete
+ * interrupt. Without a TX DMA channel the same pipeline runs blocking.
+ *
+ * Pixel calls return as soon as the stream has started. Display_SPI_Wait()
+ * blocks until it is finished; every other call waits for the previous
+ * stream first, so the blocking driver API keeps working unchanged.
+ */
+
+#ifndef __DISPLAY_SPI_H
+#define __DISPLAY_SPI_H
+
+#include "main.h"
+#include <stdbool.h>
+
+// Bytes per ping-pong buffer (two of them per display)
+#ifndef DISPLAY_SPI_BUF_BYTES
+#define DISPLAY_SPI_BUF_BYTES 384
+#endif
+
+// Bytes sent per pixel
+#define DISPLAY_SPI_RGB565 2
+#define DISPLAY_SPI_RGB666 3
+
+// Standard DCS commands shared by all supported controllers
+#define DISPLAY_SPI_CASET 0x2A
+#define DISPLAY_SPI_RASET 0x2B
+#define DISPLAY_SPI_RAMWR 0x2C
+
+// Called when a pixel stream has been sent (interrupt context with DMA)
+typedef void (*Display_SPI_DoneCallback)(void *ctx);
+
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    GPIO_TypeDef      *CsPort;
+    uint16_t          CsPin;
+    GPIO_TypeDef      *DcPort;
+    uint16_t          DcPin;
+    uint8_t           PixelBytes;   // DISPLAY_SPI_RGB565 or DISPLAY_SPI_RGB666
+    uint8_t           UseDMA;       // hspi has a TX DMA channel
+
+    // Pixel stream state (shared with the DMA complete interrupt)
+    uint8_t           Buf[2][DISPLAY_SPI_BUF_BYTES];
+    uint16_t          Len[2];       // Bytes ready in each buffer, 0 = empty
+    uint8_t           Active;       // Buffer currently on the bus
+    const uint16_t    *Src;         // NULL: fill with Color
+    uint16_t          RowPixels;    // Pixels per source row
+    uint16_t          RowLeft;      // Pixels left in the current source row
+    uint16_t          Stride;       // Pixels between source row starts
+    uint16_t          Color;
+    uint32_t          Remaining;    // Pixels not yet converted
+    volatile uint8_t  Busy;
+    uint32_t          Errors;
+
+    Display_SPI_DoneCallback DoneCb;
+    void              *DoneCtx;
+} Display_SPI_HandleTypeDef;
+
+/* Function Prototypes */
+
+void Display_SPI_Init(Display_SPI_HandleTypeDef *hdsp, SPI_HandleTypeDef *hspi,
+                      GPIO_TypeDef *cs_port, uint16_t cs_pin,
+                      GPIO_TypeDef *dc_port, uint16_t dc_pin,
+                      uint8_t pixel_bytes);
+
+/**
+ * @brief Send a command and its parameters in one CS window
+ */
+void Display_SPI_WriteCommand(Display_SPI_HandleTypeDef *hdsp, uint8_t cmd, const uint8_t *params, uint16_t len);
+
+/**
+ * @brief CASET + RASET + RAMWR in one CS window
+ */
+void Display_SPI_SetWindow(Display_SPI_HandleTypeDef *hdsp, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+
+/**
+ * @brief Write raw data bytes (blocking), e.g. a single pixel after SetWindow
+ */
+void Display_SPI_WriteData(Display_SPI_HandleTypeDef *hdsp, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Stream RGB565 pixels (native endianness) into the current window
+ * @note  Returns once the stream has started; pixels must stay valid until it is done
+ */
+void Display_SPI_WritePixels(Display_SPI_HandleTypeDef *hdsp, const uint16_t *pixels, uint32_t count);
+
+/**
+ * @brief Stream a w x h block out of a larger pixel buffer (rows stride pixels apart)
+ * @note  Same rules as Display_SPI_WritePixels; the window should be w x h
+ */
+void Display_SPI_WriteRect(Display_SPI_HandleTypeDef *hdsp, const uint16_t *pixels,
+                           uint16_t w, uint16_t h, uint16_t stride);
+
+/**
+ * @brief Stream count pixels of one color into the current window
+ */
+void Display_SPI_Fill(Display_SPI_HandleTypeDef *hdsp, uint16_t color, uint32_t count);
+
+void Display_SPI_Wait(Display_SPI_HandleTypeDef *hdsp);
+bool Display_SPI_IsBusy(Display_SPI_HandleTypeDef *hdsp);
+void Display_SPI_SetDoneCallback(Display_SPI_HandleTypeDef *hdsp, Display_SPI_DoneCallback cb, void *ctx);
+
+#endif // __DISPLAY_SPI_H
@@ -73,35 +73,8 @@
 
 // --- Private Functions ---
 
-static void ILI9341_WriteCommand(ILI9341_HandleTypeDef *hlcd, uint8_t cmd) {
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_RESET); // Command
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET); // Select
-    HAL_SPI_Transmit(hlcd->hspi, &cmd, 1, 100);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);   // Deselect
-}
-
-static void ILI9341_WriteData(ILI9341_HandleTypeDef *hlcd, uint8_t* buff, size_t buff_size) {
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_SET);   // Data
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET); // Select
-    
-    // Handle large transfers by chunking
-    uint8_t *ptr = buff;
-    size_t remaining = buff_size;
-    while (remaining > 0) {
-        uint16_t chunk = (remaining > 0xFFFF) ? 0xFFFF : (uint16_t)remaining;
-        HAL_SPI_Transmit(hlcd->hspi, ptr, chunk, 1000);
-        remaining -= chunk;
-        ptr += chunk;
-    }
-    
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);   // Deselect
-}
-
-static void ILI9341_WriteSmallData(ILI9341_HandleTypeDef *hlcd, uint8_t data) {
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_SET);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(hlcd->hspi, &data, 1, 100);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);
+static void ILI9341_WriteCommand(ILI9341_HandleTypeDef *hlcd, uint8_t cmd, const uint8_t *params, uint16_t len) {
+    Display_SPI_WriteCommand(&hlcd->Bus, cmd, params, len);
 }
 
 // --- Public Functions ---
@@ -117,6 +90,7 @@ uint8_t ILI9341_Init(ILI9341_HandleTypeDef *hlcd, SPI_HandleTypeDef *hspi,
     hlcd->DcPort = dc_port; hlcd->DcPin = dc_pin;
     hlcd->RstPort = rst_port; hlcd->RstPin = rst_pin;
     hlcd->BlkPort = blk_port; hlcd->BlkPin = blk_pin;
+    Display_SPI_Init(&hlcd->Bus, hspi, cs_port, cs_pin, dc_port, dc_pin, DISPLAY_SPI_RGB565);
     hlcd->Width = ILI9341_WIDTH;
     hlcd->Height = ILI9341_HEIGHT;
     hlcd->Rotation = 0;
@@ -129,113 +103,50 @@ uint8_t ILI9341_Init(ILI9341_HandleTypeDef *hlcd, SPI_HandleTypeDef *hspi,
     HAL_Delay(100);
 
     // Initialization Sequence
-    ILI9341_WriteCommand(hlcd, 0xEF);
-    ILI9341_WriteSmallData(hlcd, 0x03);
-    ILI9341_WriteSmallData(hlcd, 0x80);
-    ILI9341_WriteSmallData(hlcd, 0x02);
-
-    ILI9341_WriteCommand(hlcd, 0xCF);
-    ILI9341_WriteSmallData(hlcd, 0x00);
-    ILI9341_WriteSmallData(hlcd, 0xC1);
-    ILI9341_WriteSmallData(hlcd, 0x30);
-
-    ILI9341_WriteCommand(hlcd, 0xED);
-    ILI9341_WriteSmallData(hlcd, 0x64);
-    ILI9341_WriteSmallData(hlcd, 0x03);
-    ILI9341_WriteSmallData(hlcd, 0x12);
-    ILI9341_WriteSmallData(hlcd, 0x81);
-
-    ILI9341_WriteCommand(hlcd, 0xE8);
-    ILI9341_WriteSmallData(hlcd, 0x85);
-    ILI9341_WriteSmallData(hlcd, 0x00);
-    ILI9341_WriteSmallData(hlcd, 0x78);
-
-    ILI9341_WriteCommand(hlcd, 0xCB);
-    ILI9341_WriteSmallData(hlcd, 0x39);
-    ILI9341_WriteSmallData(hlcd, 0x2C);
-    ILI9341_WriteSmallData(hlcd, 0x00);
-    ILI9341_WriteSmallData(hlcd, 0x34);
-    ILI9341_WriteSmallData(hlcd, 0x02);
-
-    ILI9341_WriteCommand(hlcd, 0xF7);
-    ILI9341_WriteSmallData(hlcd, 0x20);
-
-    ILI9341_WriteCommand(hlcd, 0xEA);
-    ILI9341_WriteSmallData(hlcd, 0x00);
-    ILI9341_WriteSmallData(hlcd, 0x00);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_PWCTR1); // Power control
-    ILI9341_WriteSmallData(hlcd, 0x23);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_PWCTR2); // Power control
-    ILI9341_WriteSmallData(hlcd, 0x10);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_VMCTR1); // VCM control
-    ILI9341_WriteSmallData(hlcd, 0x3e);
-    ILI9341_WriteSmallData(hlcd, 0x28);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_VMCTR2); // VCM control2
-    ILI9341_WriteSmallData(hlcd, 0x86);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_MADCTL); // Memory Access Control
-    ILI9341_WriteSmallData(hlcd, 0x48);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_PIXFMT);
-    ILI9341_WriteSmallData(hlcd, 0x55);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_FRMCTR1);
-    ILI9341_WriteSmallData(hlcd, 0x00);
-    ILI9341_WriteSmallData(hlcd, 0x18);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_DFUNCTR); // Display Function Control
-    ILI9341_WriteSmallData(hlcd, 0x08);
-    ILI9341_WriteSmallData(hlcd, 0x82);
-    ILI9341_WriteSmallData(hlcd, 0x27);
-
-    ILI9341_WriteCommand(hlcd, 0xF2); // 3Gamma Function Disable
-    ILI9341_WriteSmallData(hlcd, 0x00);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_GAMMASET); // Gamma curve selected
-    ILI9341_WriteSmallData(hlcd, 0x01);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_GMCTRP1); // Set Gamma
-    ILI9341_WriteSmallData(hlcd, 0x0F);
-    ILI9341_WriteSmallData(hlcd, 0x31);
-    ILI9341_WriteSmallData(hlcd, 0x2B);
-    ILI9341_WriteSmallData(hlcd, 0x0C);
-    ILI9341_WriteSmallData(hlcd, 0x0E);
-    ILI9341_WriteSmallData(hlcd, 0x08);
-    ILI9341_WriteSmallData(hlcd, 0x4E);
-    ILI9341_WriteSmallData(hlcd, 0xF1);
-    ILI9341_WriteSmallData(hlcd, 0x37);
-    ILI9341_WriteSmallData(hlcd, 0x07);
-    ILI9341_WriteSmallData(hlcd, 0x10);
-    ILI9341_WriteSmallData(hlcd, 0x03);
-    ILI9341_WriteSmallData(hlcd, 0x0E);
-    ILI9341_WriteSmallData(hlcd, 0x09);
-    ILI9341_WriteSmallData(hlcd, 0x00);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_GMCTRN1);
-    ILI9341_WriteSmallData(hlcd, 0x00);
-    ILI9341_WriteSmallData(hlcd, 0x0E);
-    ILI9341_WriteSmallData(hlcd, 0x14);
-    ILI9341_WriteSmallData(hlcd, 0x03);
-    ILI9341_WriteSmallData(hlcd, 0x11);
-    ILI9341_WriteSmallData(hlcd, 0x07);
-    ILI9341_WriteSmallData(hlcd, 0x31);
-    ILI9341_WriteSmallData(hlcd, 0xC1);
-    ILI9341_WriteSmallData(hlcd, 0x48);
-    ILI9341_WriteSmallData(hlcd, 0x08);
-    ILI9341_WriteSmallData(hlcd, 0x0F);
-    ILI9341_WriteSmallData(hlcd, 0x0C);
-    ILI9341_WriteSmallData(hlcd, 0x31);
-    ILI9341_WriteSmallData(hlcd, 0x36);
-    ILI9341_WriteSmallData(hlcd, 0x0F);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_SLPOUT); // Exit Sleep
+    ILI9341_WriteCommand(hlcd, 0xEF, (const uint8_t[]){0x03, 0x80, 0x02}, 3);
+
+    ILI9341_WriteCommand(hlcd, 0xCF, (const uint8_t[]){0x00, 0xC1, 0x30}, 3);
+
+    ILI9341_WriteCommand(hlcd, 0xED, (const uint8_t[]){0x64, 0x03, 0x12, 0x81}, 4);
+
+    ILI9341_WriteCommand(hlcd, 0xE8, (const uint8_t[]){0x85, 0x00, 0x78}, 3);
+
+    ILI9341_WriteCommand(hlcd, 0xCB, (const uint8_t[]){0x39, 0x2C, 0x00, 0x34, 0x02}, 5);
+
+    ILI9341_WriteCommand(hlcd, 0xF7, (const uint8_t[]){0x20}, 1);
+
+    ILI9341_WriteCommand(hlcd, 0xEA, (const uint8_t[]){0x00, 0x00}, 2);
+
+    ILI9341_WriteCommand(hlcd, ILI9341_PWCTR1, (const uint8_t[]){0x23}, 1); // Power control
+
+    ILI9341_WriteCommand(hlcd, ILI9341_PWCTR2, (const uint8_t[]){0x10}, 1); // Power control
+
+    ILI9341_WriteCommand(hlcd, ILI9341_VMCTR1, (const uint8_t[]){0x3e, 0x28}, 2); // VCM control
+
+    ILI9341_WriteCommand(hlcd, ILI9341_VMCTR2, (const uint8_t[]){0x86}, 1); // VCM control2
+
+    ILI9341_WriteCommand(hlcd, ILI9341_MADCTL, (const uint8_t[]){0x48}, 1); // Memory Access Control
+
+    ILI9341_WriteCommand(hlcd, ILI9341_PIXFMT, (const uint8_t[]){0x55}, 1);
+
+    ILI9341_WriteCommand(hlcd, ILI9341_FRMCTR1, (const uint8_t[]){0x00, 0x18}, 2);
+
+    ILI9341_WriteCommand(hlcd, ILI9341_DFUNCTR, (const uint8_t[]){0x08, 0x82, 0x27}, 3); // Display Function Control
+
+    ILI9341_WriteCommand(hlcd, 0xF2, (const uint8_t[]){0x00}, 1); // 3Gamma Function Disable
+
+    ILI9341_WriteCommand(hlcd, ILI9341_GAMMASET, (const uint8_t[]){0x01}, 1); // Gamma curve selected
+
+    ILI9341_WriteCommand(hlcd, ILI9341_GMCTRP1, (const uint8_t[]){0x0F, 0x31, 0x2B, 0x0C, 0x0E, 0x08, 0x4E, 0xF1,
+        0x37, 0x07, 0x10, 0x03, 0x0E, 0x09, 0x00}, 15); // Set Gamma
+
+    ILI9341_WriteCommand(hlcd, ILI9341_GMCTRN1, (const uint8_t[]){0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1,
+        0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F}, 15);
+
+    ILI9341_WriteCommand(hlcd, ILI9341_SLPOUT, NULL, 0); // Exit Sleep
     HAL_Delay(120);
     
-    ILI9341_WriteCommand(hlcd, ILI9341_DISPON); // Turn on Display
+    ILI9341_WriteCommand(hlcd, ILI9341_DISPON, NULL, 0); // Turn on Display
     
     // Set Rotation 0 default
     ILI9341_SetRotation(hlcd, 0);
@@ -249,78 +160,52 @@ uint8_t ILI9341_Init(ILI9341_HandleTypeDef *hlcd, SPI_HandleTypeDef *hspi,
 }
 
 void ILI9341_SetRotation(ILI9341_HandleTypeDef *hlcd, uint8_t m) {
-    ILI9341_WriteCommand(hlcd, ILI9341_MADCTL);
+    uint8_t madctl = 0;
     uint8_t rotation = m % 4; // can be 0-3
     hlcd->Rotation = rotation;
     
     switch (rotation) {
         case 0:
-            ILI9341_WriteSmallData(hlcd, MADCTL_MX | MADCTL_BGR);
+            madctl = MADCTL_MX | MADCTL_BGR;
             hlcd->Width  = ILI9341_WIDTH;
             hlcd->Height = ILI9341_HEIGHT;
             break;
         case 1:
-            ILI9341_WriteSmallData(hlcd, MADCTL_MV | MADCTL_BGR);
+            madctl = MADCTL_MV | MADCTL_BGR;
             hlcd->Width  = ILI9341_HEIGHT;
             hlcd->Height = ILI9341_WIDTH;
             break;
         case 2:
-            ILI9341_WriteSmallData(hlcd, MADCTL_MY | MADCTL_BGR);
+            madctl = MADCTL_MY | MADCTL_BGR;
             hlcd->Width  = ILI9341_WIDTH;
             hlcd->Height = ILI9341_HEIGHT;
             break;
         case 3:
-            ILI9341_WriteSmallData(hlcd, MADCTL_MX | MADCTL_MY | MADCTL_MV | MADCTL_BGR);
+            madctl = MADCTL_MX | MADCTL_MY | MADCTL_MV | MADCTL_BGR;
             hlcd->Width  = ILI9341_HEIGHT;
             hlcd->Height = ILI9341_WIDTH;
             break;
     }
+
+    ILI9341_WriteCommand(hlcd, ILI9341_MADCTL, &madctl, 1);
 }
 
 static void ILI9341_SetAddressWindow(ILI9341_HandleTypeDef *hlcd, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
-    uint8_t data[4];
-    
-    ILI9341_WriteCommand(hlcd, ILI9341_CASET);
-    data[0] = (x0 >> 8) & 0xFF;
-    data[1] = x0 & 0xFF;
-    data[2] = (x1 >> 8) & 0xFF;
-    data[3] = x1 & 0xFF;
-    ILI9341_WriteData(hlcd, data, 4);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_PASET);
-    data[0] = (y0 >> 8) & 0xFF;
-    data[1] = y0 & 0xFF;
-    data[2] = (y1 >> 8) & 0xFF;
-    data[3] = y1 & 0xFF;
-    ILI9341_WriteData(hlcd, data, 4);
-
-    ILI9341_WriteCommand(hlcd, ILI9341_RAMWR);
+    Display_SPI_SetWindow(&hlcd->Bus, x0, y0, x1, y1);
 }
 
-void ILI9341_FillRect(ILI9341_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+void ILI9341_FillRectAsync(ILI9341_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
     if ((x >= hlcd->Width) || (y >= hlcd->Height)) return;
     if ((x + w - 1) >= hlcd->Width) w = hlcd->Width - x;
     if ((y + h - 1) >= hlcd->Height) h = hlcd->Height - y;
 
     ILI9341_SetAddressWindow(hlcd, x, y, x + w - 1, y + h - 1);
+    Display_SPI_Fill(&hlcd->Bus, color, (uint32_t)w * h);
+}
 
-    uint8_t color_buff[512]; 
-    uint8_t hi = (color >> 8) & 0xFF;
-    uint8_t lo = color & 0xFF;
-    
-    // Fill buffer efficiently
-    uint16_t buffer_pixels = sizeof(color_buff) / 2;
-    for (uint16_t i = 0; i < buffer_pixels; i++) {
-        color_buff[i*2] = hi;
-        color_buff[i*2+1] = lo;
-    }
-
-    uint32_t total_pixels = w * h;
-    while (total_pixels > 0) {
-        uint32_t chunk_pixels = (total_pixels > buffer_pixels) ? buffer_pixels : total_pixels;
-        ILI9341_WriteData(hlcd, color_buff, chunk_pixels * 2);
-        total_pixels -= chunk_pixels;
-    }
+void ILI9341_FillRect(ILI9341_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    ILI9341_FillRectAsync(hlcd, x, y, w, h, color);
+    Display_SPI_Wait(&hlcd->Bus);
 }
 
 void ILI9341_FillScreen(ILI9341_HandleTypeDef *hlcd, uint16_t color) {
@@ -332,32 +217,31 @@ void ILI9341_DrawPixel(ILI9341_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint
 
     ILI9341_SetAddressWindow(hlcd, x, y, x, y);
     uint8_t data[2] = {(color >> 8) & 0xFF, color & 0xFF};
-    ILI9341_WriteData(hlcd, data, 2);
+    Display_SPI_WriteData(&hlcd->Bus, data, 2);
 }
 
-void ILI9341_DrawImage(ILI9341_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
+void ILI9341_DrawImageAsync(ILI9341_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
     if ((x >= hlcd->Width) || (y >= hlcd->Height)) return;
     if ((x + w - 1) >= hlcd->Width) return;
     if ((y + h - 1) >= hlcd->Height) return;
 
     ILI9341_SetAddressWindow(hlcd, x, y, x + w - 1, y + h - 1);
-    
-    uint32_t total_pixels = w * h;
-    uint32_t i = 0;
-    uint8_t line_buff[256]; 
-    uint16_t chunk_size = 128;
-    
-    while (i < total_pixels) {
-        uint32_t current_chunk = (total_pixels - i > chunk_size) ? chunk_size : (total_pixels - i);
-        for (uint32_t k = 0; k < current_chunk; k++) {
-            line_buff[k*2]     = (data[i+k] >> 8) & 0xFF;
-            line_buff[k*2+1]   = data[i+k] & 0xFF;
-        }
-        ILI9341_WriteData(hlcd, line_buff, current_chunk * 2);
-        i += current_chunk;
-    }
+    Display_SPI_WritePixels(&hlcd->Bus, data, (uint32_t)w * h);
+}
+
+void ILI9341_DrawImage(ILI9341_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
+    ILI9341_DrawImageAsync(hlcd, x, y, w, h, data);
+    Display_SPI_Wait(&hlcd->Bus);
+}
+
+void ILI9341_WaitDone(ILI9341_HandleTypeDef *hlcd) {
+    Display_SPI_Wait(&hlcd->Bus);
+}
+
+uint8_t ILI9341_IsBusy(ILI9341_HandleTypeDef *hlcd) {
+    return Display_SPI_IsBusy(&hlcd->Bus) ? 1 : 0;
 }
 
 void ILI9341_InvertColors(ILI9341_HandleTypeDef *hlcd, uint8_t invert) {
-    ILI9341_WriteCommand(hlcd, invert ? ILI9341_INVON : ILI9341_INVOFF);
+    ILI9341_WriteCommand(hlcd, invert ? ILI9341_INVON : ILI9341_INVOFF, NULL, 0);
 }
@@ -44,75 +44,8 @@
 
 // --- Private Functions ---
 
-static void ILI9488_WriteCommand(ILI9488_HandleTypeDef *hlcd, uint8_t cmd) {
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_RESET);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(hlcd->hspi, &cmd, 1, 100);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);
-}
-
-// Write generic data bytes (parameters)
-static void ILI9488_WriteData(ILI9488_HandleTypeDef *hlcd, uint8_t* buff, size_t buff_size) {
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_SET);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET);
-    
-    uint8_t *ptr = buff;
-    size_t remaining = buff_size;
-    while (remaining > 0) {
-        uint16_t chunk = (remaining > 0xFFFF) ? 0xFFFF : (uint16_t)remaining;
-        HAL_SPI_Transmit(hlcd->hspi, ptr, chunk, 1000);
-        remaining -= chunk;
-        ptr += chunk;
-    }
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);
-}
-
-static void ILI9488_WriteSmallData(ILI9488_HandleTypeDef *hlcd, uint8_t data) {
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_SET);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(hlcd->hspi, &data, 1, 100);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);
-}
-
-// Convert RGB565 to RGB888 and write
-// ILI9488 in 4-wire SPI often requires 18-bit (sent as 3 bytes/pixel)
-static void ILI9488_WritePixelData(ILI9488_HandleTypeDef *hlcd, const uint16_t *pixels, size_t pixel_count) {
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_SET);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET);
-
-    // Buffer for chunking conversion to save RAM
-    // 3 bytes per pixel
-    uint8_t line_buff[384]; // 128 pixels max per chunk
-    size_t max_pixels_per_chunk = sizeof(line_buff) / 3;
-    
-    size_t processed = 0;
-    while (processed < pixel_count) {
-        size_t current_chunk = (pixel_count - processed > max_pixels_per_chunk) ? max_pixels_per_chunk : (pixel_count - processed);
-        size_t buff_idx = 0;
-        
-        for (size_t i = 0; i < current_chunk; i++) {
-            uint16_t color = pixels[processed + i];
-            
-            // Extract RGB565
-            uint8_t r5 = (color >> 11) & 0x1F;
-            uint8_t g6 = (color >> 5) & 0x3F;
-            uint8_t b5 = (color & 0x1F);
-            
-            // Convert to RGB888
-            uint8_t r8 = (r5 * 527 + 23) >> 6;
-            uint8_t g8 = (g6 * 259 + 33) >> 6;
-            uint8_t b8 = (b5 * 527 + 23) >> 6;
-            
-            line_buff[buff_idx++] = r8;
-            line_buff[buff_idx++] = g8;
-            line_buff[buff_idx++] = b8;
-        }
-        
-        HAL_SPI_Transmit(hlcd->hspi, line_buff, buff_idx, 1000);
-        processed += current_chunk;
-    }
-
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);
+static void ILI9488_WriteCommand(ILI9488_HandleTypeDef *hlcd, uint8_t cmd, const uint8_t *params, uint16_t len) {
+    Display_SPI_WriteCommand(&hlcd->Bus, cmd, params, len);
 }
 
 // --- Public Functions ---
@@ -128,6 +61,7 @@ uint8_t ILI9488_Init(ILI9488_HandleTypeDef *hlcd, SPI_HandleTypeDef *hspi,
     hlcd->DcPort = dc_port; hlcd->DcPin = dc_pin;
     hlcd->RstPort = rst_port; hlcd->RstPin = rst_pin;
     hlcd->BlkPort = blk_port; hlcd->BlkPin = blk_pin;
+    Display_SPI_Init(&hlcd->Bus, hspi, cs_port, cs_pin, dc_port, dc_pin, DISPLAY_SPI_RGB666);
     hlcd->Width = ILI9488_WIDTH;
     hlcd->Height = ILI9488_HEIGHT;
     hlcd->Rotation = 0;
@@ -140,61 +74,41 @@ uint8_t ILI9488_Init(ILI9488_HandleTypeDef *hlcd, SPI_HandleTypeDef *hspi,
     HAL_Delay(100);
 
     // Init Sequence
-    ILI9488_WriteCommand(hlcd, ILI9488_SWRESET); 
+    ILI9488_WriteCommand(hlcd, ILI9488_SWRESET, NULL, 0); 
     HAL_Delay(100);
 
-    ILI9488_WriteCommand(hlcd, 0xE0); // Positive Gamma Control
     uint8_t gammaP[] = {0x00, 0x03, 0x09, 0x08, 0x16, 0x0A, 0x3F, 0x78, 0x4C, 0x09, 0x0A, 0x08, 0x16, 0x1A, 0x0F};
-    ILI9488_WriteData(hlcd, gammaP, 15);
+    ILI9488_WriteCommand(hlcd, 0xE0, gammaP, 15); // Positive Gamma Control
 
-    ILI9488_WriteCommand(hlcd, 0xE1); // Negative Gamma Control
     uint8_t gammaN[] = {0x00, 0x16, 0x19, 0x03, 0x11, 0x05, 0x26, 0x28, 0x44, 0x04, 0x05, 0x05, 0x24, 0x1C, 0x0F};
-    ILI9488_WriteData(hlcd, gammaN, 15);
+    ILI9488_WriteCommand(hlcd, 0xE1, gammaN, 15); // Negative Gamma Control
 
-    ILI9488_WriteCommand(hlcd, 0XC0); // Power Control 1
-    ILI9488_WriteSmallData(hlcd, 0x17);
-    ILI9488_WriteSmallData(hlcd, 0x15);
+    ILI9488_WriteCommand(hlcd, 0XC0, (const uint8_t[]){0x17, 0x15}, 2); // Power Control 1
 
-    ILI9488_WriteCommand(hlcd, 0xC1); // Power Control 2
-    ILI9488_WriteSmallData(hlcd, 0x41);
+    ILI9488_WriteCommand(hlcd, 0xC1, (const uint8_t[]){0x41}, 1); // Power Control 2
 
-    ILI9488_WriteCommand(hlcd, 0xC5); // VCOM Control
-    ILI9488_WriteSmallData(hlcd, 0x00);
-    ILI9488_WriteSmallData(hlcd, 0x12);
-    ILI9488_WriteSmallData(hlcd, 0x80);
+    ILI9488_WriteCommand(hlcd, 0xC5, (const uint8_t[]){0x00, 0x12, 0x80}, 3); // VCOM Control
 
-    ILI9488_WriteCommand(hlcd, ILI9488_MADCTL);
-    ILI9488_WriteSmallData(hlcd, 0x48); // MX, BGR
+    ILI9488_WriteCommand(hlcd, ILI9488_MADCTL, (const uint8_t[]){0x48}, 1); // MX, BGR
 
-    ILI9488_WriteCommand(hlcd, ILI9488_PIXFMT);
-    ILI9488_WriteSmallData(hlcd, 0x66); // 18-bit (RGB666) - Required for SPI 4-wire on ILI9488
+    ILI9488_WriteCommand(hlcd, ILI9488_PIXFMT, (const uint8_t[]){0x66}, 1); // 18-bit (RGB666) - Required for SPI 4-wire on ILI9488
 
-    ILI9488_WriteCommand(hlcd, 0xB0); // Interface Mode Control
-    ILI9488_WriteSmallData(hlcd, 0x00);
+    ILI9488_WriteCommand(hlcd, 0xB0, (const uint8_t[]){0x00}, 1); // Interface Mode Control
 
-    ILI9488_WriteCommand(hlcd, 0xB1); // Frame Rate Control
-    ILI9488_WriteSmallData(hlcd, 0xA0);
+    ILI9488_WriteCommand(hlcd, 0xB1, (const uint8_t[]){0xA0}, 1); // Frame Rate Control
 
-    ILI9488_WriteCommand(hlcd, 0xB4); // Display Inversion Control
-    ILI9488_WriteSmallData(hlcd, 0x02); // 2-dot inversion
+    ILI9488_WriteCommand(hlcd, 0xB4, (const uint8_t[]){0x02}, 1); // Display Inversion Control
 
-    ILI9488_WriteCommand(hlcd, 0xB6); // Display Function Control
-    ILI9488_WriteSmallData(hlcd, 0x02);
-    ILI9488_WriteSmallData(hlcd, 0x02);
+    ILI9488_WriteCommand(hlcd, 0xB6, (const uint8_t[]){0x02, 0x02}, 2); // Display Function Control
 
-    ILI9488_WriteCommand(hlcd, 0xE9); // Set Image Function
-    ILI9488_WriteSmallData(hlcd, 0x00);
+    ILI9488_WriteCommand(hlcd, 0xE9, (const uint8_t[]){0x00}, 1); // Set Image Function
 
-    ILI9488_WriteCommand(hlcd, 0xF7); // Adjust Control 3
-    ILI9488_WriteSmallData(hlcd, 0xA9);
-    ILI9488_WriteSmallData(hlcd, 0x51);
-    ILI9488_WriteSmallData(hlcd, 0x2C);
-    ILI9488_WriteSmallData(hlcd, 0x82);
+    ILI9488_WriteCommand(hlcd, 0xF7, (const uint8_t[]){0xA9, 0x51, 0x2C, 0x82}, 4); // Adjust Control 3
 
-    ILI9488_WriteCommand(hlcd, ILI9488_SLPOUT);
+    ILI9488_WriteCommand(hlcd, ILI9488_SLPOUT, NULL, 0);
     HAL_Delay(120);
 
-    ILI9488_WriteCommand(hlcd, ILI9488_DISPON);
+    ILI9488_WriteCommand(hlcd, ILI9488_DISPON, NULL, 0);
     HAL_Delay(100);
 
     ILI9488_SetRotation(hlcd, 0);
@@ -209,92 +123,52 @@ uint8_t ILI9488_Init(ILI9488_HandleTypeDef *hlcd, SPI_HandleTypeDef *hspi,
 }
 
 void ILI9488_SetRotation(ILI9488_HandleTypeDef *hlcd, uint8_t m) {
-    ILI9488_WriteCommand(hlcd, ILI9488_MADCTL);
+    uint8_t madctl = 0;
     uint8_t rotation = m % 4; 
     hlcd->Rotation = rotation;
     
     switch (rotation) {
         case 0: // Portrait
-            ILI9488_WriteSmallData(hlcd, MADCTL_MX | MADCTL_BGR);
+            madctl = MADCTL_MX | MADCTL_BGR;
             hlcd->Width  = ILI9488_WIDTH;
             hlcd->Height = ILI9488_HEIGHT;
             break;
         case 1: // Landscape
-            ILI9488_WriteSmallData(hlcd, MADCTL_MV | MADCTL_BGR);
+            madctl = MADCTL_MV | MADCTL_BGR;
             hlcd->Width  = ILI9488_HEIGHT;
             hlcd->Height = ILI9488_WIDTH;
             break;
         case 2: // Inverted Portrait
-            ILI9488_WriteSmallData(hlcd, MADCTL_MY | MADCTL_BGR);
+            madctl = MADCTL_MY | MADCTL_BGR;
             hlcd->Width  = ILI9488_WIDTH;
             hlcd->Height = ILI9488_HEIGHT;
             break;
         case 3: // Inverted Landscape
-            ILI9488_WriteSmallData(hlcd, MADCTL_MX | MADCTL_MY | MADCTL_MV | MADCTL_BGR);
+            madctl = MADCTL_MX | MADCTL_MY | MADCTL_MV | MADCTL_BGR;
             hlcd->Width  = ILI9488_HEIGHT;
             hlcd->Height = ILI9488_WIDTH;
             break;
     }
+
+    ILI9488_WriteCommand(hlcd, ILI9488_MADCTL, &madctl, 1);
 }
 
 static void ILI9488_SetAddressWindow(ILI9488_HandleTypeDef *hlcd, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
-    uint8_t data[4];
-    
-    ILI9488_WriteCommand(hlcd, ILI9488_CASET);
-    data[0] = (x0 >> 8) & 0xFF;
-    data[1] = x0 & 0xFF;
-    data[2] = (x1 >> 8) & 0xFF;
-    data[3] = x1 & 0xFF;
-    ILI9488_WriteData(hlcd, data, 4);
-
-    ILI9488_WriteCommand(hlcd, ILI9488_PASET);
-    data[0] = (y0 >> 8) & 0xFF;
-    data[1] = y0 & 0xFF;
-    data[2] = (y1 >> 8) & 0xFF;
-    data[3] = y1 & 0xFF;
-    ILI9488_WriteData(hlcd, data, 4);
-
-    ILI9488_WriteCommand(hlcd, ILI9488_RAMWR);
+    Display_SPI_SetWindow(&hlcd->Bus, x0, y0, x1, y1);
 }
 
-void ILI9488_FillRect(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+void ILI9488_FillRectAsync(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
     if ((x >= hlcd->Width) || (y >= hlcd->Height)) return;
     if ((x + w - 1) >= hlcd->Width) w = hlcd->Width - x;
     if ((y + h - 1) >= hlcd->Height) h = hlcd->Height - y;
 
     ILI9488_SetAddressWindow(hlcd, x, y, x + w - 1, y + h - 1);
-    
-    // We need to write pixel by pixel (converted to 3 bytes)
-    // To be efficient, we prepare a buffer of IDENTICAL pixels
-    uint32_t total_pixels = w * h;
-    
-    // Prepare a small buffer of the converted color
-    // 64 pixels * 3 bytes = 192 bytes
-    uint8_t r5 = (color >> 11) & 0x1F;
-    uint8_t g6 = (color >> 5) & 0x3F;
-    uint8_t b5 = (color & 0x1F);
-    
-    uint8_t r8 = (r5 * 527 + 23) >> 6;
-    uint8_t g8 = (g6 * 259 + 33) >> 6;
-    uint8_t b8 = (b5 * 527 + 23) >> 6;
-    
-    uint8_t chunk_buff[192]; // holds 64 pixels
-    for (int i=0; i<64; i++) {
-        chunk_buff[i*3] = r8;
-        chunk_buff[i*3+1] = g8;
-        chunk_buff[i*3+2] = b8;
-    }
-    
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_SET);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET);
-    
-    while(total_pixels > 0) {
-        uint32_t chunk = (total_pixels > 64) ? 64 : total_pixels;
-        HAL_SPI_Transmit(hlcd->hspi, chunk_buff, chunk * 3, 1000);
-        total_pixels -= chunk;
-    }
-    
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);
+    Display_SPI_Fill(&hlcd->Bus, color, (uint32_t)w * h);
+}
+
+void ILI9488_FillRect(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    ILI9488_FillRectAsync(hlcd, x, y, w, h, color);
+    Display_SPI_Wait(&hlcd->Bus);
 }
 
 void ILI9488_FillScreen(ILI9488_HandleTypeDef *hlcd, uint16_t color) {
@@ -315,18 +189,29 @@ void ILI9488_DrawPixel(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint
     data[1] = (g6 * 259 + 33) >> 6; // G
     data[2] = (b5 * 527 + 23) >> 6; // B
     
-    ILI9488_WriteData(hlcd, data, 3);
+    Display_SPI_WriteData(&hlcd->Bus, data, 3);
 }
 
-// Assumes 'data' is array of RGB565
-void ILI9488_DrawImage(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
+void ILI9488_DrawImageAsync(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
     if ((x >= hlcd->Width) || (y >= hlcd->Height)) return;
+
     ILI9488_SetAddressWindow(hlcd, x, y, x + w - 1, y + h - 1);
-    
-    uint32_t total_pixels = w * h;
-    ILI9488_WritePixelData(hlcd, data, total_pixels);
+    Display_SPI_WritePixels(&hlcd->Bus, data, (uint32_t)w * h);
+}
+
+void ILI9488_DrawImage(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
+    ILI9488_DrawImageAsync(hlcd, x, y, w, h, data);
+    Display_SPI_Wait(&hlcd->Bus);
+}
+
+void ILI9488_WaitDone(ILI9488_HandleTypeDef *hlcd) {
+    Display_SPI_Wait(&hlcd->Bus);
+}
+
+uint8_t ILI9488_IsBusy(ILI9488_HandleTypeDef *hlcd) {
+    return Display_SPI_IsBusy(&hlcd->Bus) ? 1 : 0;
 }
 
 void ILI9488_InvertColors(ILI9488_HandleTypeDef *hlcd, uint8_t invert) {
-    ILI9488_WriteCommand(hlcd, invert ? ILI9488_DINVON : ILI9488_DINVOFF);
+    ILI9488_WriteCommand(hlcd, invert ? ILI9488_DINVON : ILI9488_DINVOFF, NULL, 0);
 }
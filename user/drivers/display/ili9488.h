@@ -9,6 +9,7 @@
 #define __ILI9488_H
 
 #include "main.h"
+#include "display_spi.h"
 
 #ifndef __STM32F1xx_HAL_SPI_H
 #include "main.h"
@@ -52,6 +53,8 @@ typedef struct {
     uint16_t          Width;
     uint16_t          Height;
     uint8_t           Rotation; // 0-3
+
+    Display_SPI_HandleTypeDef Bus; // Shared SPI transport (ping-pong buffers, DMA)
 } ILI9488_HandleTypeDef;
 
 /* Function Prototypes */
@@ -71,6 +74,17 @@ void ILI9488_FillScreen(ILI9488_HandleTypeDef *hlcd, uint16_t color);
 void ILI9488_DrawPixel(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t color);
 void ILI9488_FillRect(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 void ILI9488_DrawImage(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data);
+
+/**
+ * @brief Start a fill/image stream and return immediately
+ * @note  With a TX DMA channel on hspi the pixels stream in the background.
+ *        Image data must stay valid until ILI9488_IsBusy() returns 0. Any other
+ *        call on the same display waits for the stream first.
+ */
+void ILI9488_FillRectAsync(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+void ILI9488_DrawImageAsync(ILI9488_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data);
+void ILI9488_WaitDone(ILI9488_HandleTypeDef *hlcd);
+uint8_t ILI9488_IsBusy(ILI9488_HandleTypeDef *hlcd);
 void ILI9488_InvertColors(ILI9488_HandleTypeDef *hlcd, uint8_t invert);
 
 #endif // __ILI9488_H
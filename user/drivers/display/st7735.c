@@ -64,34 +64,8 @@
 
 // --- Private Functions ---
 
-static void ST7735_WriteCommand(ST7735_HandleTypeDef *hlcd, uint8_t cmd) {
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_RESET);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(hlcd->hspi, &cmd, 1, 100);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);
-}
-
-static void ST7735_WriteData(ST7735_HandleTypeDef *hlcd, uint8_t* buff, size_t buff_size) {
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_SET);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET);
-    
-    uint8_t *ptr = buff;
-    size_t remaining = buff_size;
-    while (remaining > 0) {
-        uint16_t chunk = (remaining > 0xFFFF) ? 0xFFFF : (uint16_t)remaining;
-        HAL_SPI_Transmit(hlcd->hspi, ptr, chunk, 1000);
-        remaining -= chunk;
-        ptr += chunk;
-    }
-
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);
-}
-
-static void ST7735_WriteSmallData(ST7735_HandleTypeDef *hlcd, uint8_t data) {
-    HAL_GPIO_WritePin(hlcd->DcPort, hlcd->DcPin, GPIO_PIN_SET);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(hlcd->hspi, &data, 1, 100);
-    HAL_GPIO_WritePin(hlcd->CsPort, hlcd->CsPin, GPIO_PIN_SET);
+static void ST7735_WriteCommand(ST7735_HandleTypeDef *hlcd, uint8_t cmd, const uint8_t *params, uint16_t len) {
+    Display_SPI_WriteCommand(&hlcd->Bus, cmd, params, len);
 }
 
 // --- Public Functions ---
@@ -107,6 +81,7 @@ uint8_t ST7735_Init(ST7735_HandleTypeDef *hlcd, SPI_HandleTypeDef *hspi,
     hlcd->DcPort = dc_port; hlcd->DcPin = dc_pin;
     hlcd->RstPort = rst_port; hlcd->RstPin = rst_pin;
     hlcd->BlkPort = blk_port; hlcd->BlkPin = blk_pin;
+    Display_SPI_Init(&hlcd->Bus, hspi, cs_port, cs_pin, dc_port, dc_pin, DISPLAY_SPI_RGB565);
     
     // Default 1.8" settings
     hlcd->Width = ST7735_WIDTH;
@@ -123,104 +98,49 @@ uint8_t ST7735_Init(ST7735_HandleTypeDef *hlcd, SPI_HandleTypeDef *hspi,
     HAL_Delay(50);
 
     // Init Sequence for ST7735R (Most common) ("Red Tab")
-    ST7735_WriteCommand(hlcd, ST7735_SWRESET);
+    ST7735_WriteCommand(hlcd, ST7735_SWRESET, NULL, 0);
     HAL_Delay(150);
 
-    ST7735_WriteCommand(hlcd, ST7735_SLPOUT);
+    ST7735_WriteCommand(hlcd, ST7735_SLPOUT, NULL, 0);
     HAL_Delay(255);
 
-    ST7735_WriteCommand(hlcd, ST7735_FRMCTR1);
-    ST7735_WriteSmallData(hlcd, 0x01);
-    ST7735_WriteSmallData(hlcd, 0x2C);
-    ST7735_WriteSmallData(hlcd, 0x2D);
-
-    ST7735_WriteCommand(hlcd, ST7735_FRMCTR2);
-    ST7735_WriteSmallData(hlcd, 0x01);
-    ST7735_WriteSmallData(hlcd, 0x2C);
-    ST7735_WriteSmallData(hlcd, 0x2D);
-
-    ST7735_WriteCommand(hlcd, ST7735_FRMCTR3);
-    ST7735_WriteSmallData(hlcd, 0x01);
-    ST7735_WriteSmallData(hlcd, 0x2C);
-    ST7735_WriteSmallData(hlcd, 0x2D);
-    ST7735_WriteSmallData(hlcd, 0x01);
-    ST7735_WriteSmallData(hlcd, 0x2C);
-    ST7735_WriteSmallData(hlcd, 0x2D);
-
-    ST7735_WriteCommand(hlcd, ST7735_INVCTR);
-    ST7735_WriteSmallData(hlcd, 0x07);
-
-    ST7735_WriteCommand(hlcd, ST7735_PWCTR1);
-    ST7735_WriteSmallData(hlcd, 0xA2);
-    ST7735_WriteSmallData(hlcd, 0x02);
-    ST7735_WriteSmallData(hlcd, 0x84);
-
-    ST7735_WriteCommand(hlcd, ST7735_PWCTR2);
-    ST7735_WriteSmallData(hlcd, 0xC5);
-
-    ST7735_WriteCommand(hlcd, ST7735_PWCTR3);
-    ST7735_WriteSmallData(hlcd, 0x0A);
-    ST7735_WriteSmallData(hlcd, 0x00);
-
-    ST7735_WriteCommand(hlcd, ST7735_PWCTR4);
-    ST7735_WriteSmallData(hlcd, 0x8A);
-    ST7735_WriteSmallData(hlcd, 0x2A);
-
-    ST7735_WriteCommand(hlcd, ST7735_PWCTR5);
-    ST7735_WriteSmallData(hlcd, 0x8A);
-    ST7735_WriteSmallData(hlcd, 0xEE);
-
-    ST7735_WriteCommand(hlcd, ST7735_VMCTR1);
-    ST7735_WriteSmallData(hlcd, 0x0E);
-
-    ST7735_WriteCommand(hlcd, ST7735_INVOFF);
-
-    ST7735_WriteCommand(hlcd, ST7735_MADCTL);
-    ST7735_WriteSmallData(hlcd, MADCTL_MX | MADCTL_MY | MADCTL_BGR); // Default rotation
-
-    ST7735_WriteCommand(hlcd, ST7735_COLMOD);
-    ST7735_WriteSmallData(hlcd, 0x05);
-
-    ST7735_WriteCommand(hlcd, ST7735_GMCTRP1);
-    ST7735_WriteSmallData(hlcd, 0x02);
-    ST7735_WriteSmallData(hlcd, 0x1c);
-    ST7735_WriteSmallData(hlcd, 0x07);
-    ST7735_WriteSmallData(hlcd, 0x12);
-    ST7735_WriteSmallData(hlcd, 0x37);
-    ST7735_WriteSmallData(hlcd, 0x32);
-    ST7735_WriteSmallData(hlcd, 0x29);
-    ST7735_WriteSmallData(hlcd, 0x2d);
-    ST7735_WriteSmallData(hlcd, 0x29);
-    ST7735_WriteSmallData(hlcd, 0x25);
-    ST7735_WriteSmallData(hlcd, 0x2B);
-    ST7735_WriteSmallData(hlcd, 0x39);
-    ST7735_WriteSmallData(hlcd, 0x00);
-    ST7735_WriteSmallData(hlcd, 0x01);
-    ST7735_WriteSmallData(hlcd, 0x03);
-    ST7735_WriteSmallData(hlcd, 0x10);
-
-    ST7735_WriteCommand(hlcd, ST7735_GMCTRN1);
-    ST7735_WriteSmallData(hlcd, 0x03);
-    ST7735_WriteSmallData(hlcd, 0x1d);
-    ST7735_WriteSmallData(hlcd, 0x07);
-    ST7735_WriteSmallData(hlcd, 0x06);
-    ST7735_WriteSmallData(hlcd, 0x2E);
-    ST7735_WriteSmallData(hlcd, 0x2C);
-    ST7735_WriteSmallData(hlcd, 0x29);
-    ST7735_WriteSmallData(hlcd, 0x2D);
-    ST7735_WriteSmallData(hlcd, 0x2E);
-    ST7735_WriteSmallData(hlcd, 0x2E);
-    ST7735_WriteSmallData(hlcd, 0x37);
-    ST7735_WriteSmallData(hlcd, 0x3F);
-    ST7735_WriteSmallData(hlcd, 0x00);
-    ST7735_WriteSmallData(hlcd, 0x00);
-    ST7735_WriteSmallData(hlcd, 0x02);
-    ST7735_WriteSmallData(hlcd, 0x10);
-
-    ST7735_WriteCommand(hlcd, ST7735_NORON);
+    ST7735_WriteCommand(hlcd, ST7735_FRMCTR1, (const uint8_t[]){0x01, 0x2C, 0x2D}, 3);
+
+    ST7735_WriteCommand(hlcd, ST7735_FRMCTR2, (const uint8_t[]){0x01, 0x2C, 0x2D}, 3);
+
+    ST7735_WriteCommand(hlcd, ST7735_FRMCTR3, (const uint8_t[]){0x01, 0x2C, 0x2D,
+        0x01, 0x2C, 0x2D}, 6);
+
+    ST7735_WriteCommand(hlcd, ST7735_INVCTR, (const uint8_t[]){0x07}, 1);
+
+    ST7735_WriteCommand(hlcd, ST7735_PWCTR1, (const uint8_t[]){0xA2, 0x02, 0x84}, 3);
+
+    ST7735_WriteCommand(hlcd, ST7735_PWCTR2, (const uint8_t[]){0xC5}, 1);
+
+    ST7735_WriteCommand(hlcd, ST7735_PWCTR3, (const uint8_t[]){0x0A, 0x00}, 2);
+
+    ST7735_WriteCommand(hlcd, ST7735_PWCTR4, (const uint8_t[]){0x8A, 0x2A}, 2);
+
+    ST7735_WriteCommand(hlcd, ST7735_PWCTR5, (const uint8_t[]){0x8A, 0xEE}, 2);
+
+    ST7735_WriteCommand(hlcd, ST7735_VMCTR1, (const uint8_t[]){0x0E}, 1);
+
+    ST7735_WriteCommand(hlcd, ST7735_INVOFF, NULL, 0);
+
+    ST7735_WriteCommand(hlcd, ST7735_MADCTL, (const uint8_t[]){MADCTL_MX | MADCTL_MY | MADCTL_BGR}, 1); // Default rotation
+
+    ST7735_WriteCommand(hlcd, ST7735_COLMOD, (const uint8_t[]){0x05}, 1);
+
+    ST7735_WriteCommand(hlcd, ST7735_GMCTRP1, (const uint8_t[]){0x02, 0x1c, 0x07, 0x12, 0x37, 0x32, 0x29, 0x2d,
+        0x29, 0x25, 0x2B, 0x39, 0x00, 0x01, 0x03, 0x10}, 16);
+
+    ST7735_WriteCommand(hlcd, ST7735_GMCTRN1, (const uint8_t[]){0x03, 0x1d, 0x07, 0x06, 0x2E, 0x2C, 0x29, 0x2D,
+        0x2E, 0x2E, 0x37, 0x3F, 0x00, 0x00, 0x02, 0x10}, 16);
+
+    ST7735_WriteCommand(hlcd, ST7735_NORON, NULL, 0);
     HAL_Delay(10);
     
-    ST7735_WriteCommand(hlcd, ST7735_DISPON);
+    ST7735_WriteCommand(hlcd, ST7735_DISPON, NULL, 0);
     HAL_Delay(100);
 
     if (hlcd->BlkPort != NULL) {
@@ -239,77 +159,48 @@ void ST7735_SetType(ST7735_HandleTypeDef *hlcd, uint16_t x_off, uint16_t y_off,
 }
 
 void ST7735_SetRotation(ST7735_HandleTypeDef *hlcd, uint8_t m) {
-    ST7735_WriteCommand(hlcd, ST7735_MADCTL);
+    uint8_t madctl = 0;
     uint8_t rotation = m % 4; 
     hlcd->Rotation = rotation;
     
     switch (rotation) {
         case 0:
-            ST7735_WriteSmallData(hlcd, MADCTL_MX | MADCTL_MY | MADCTL_BGR);
+            madctl = MADCTL_MX | MADCTL_MY | MADCTL_BGR;
             // Re-apply offsets if swapping dimensions is needed, but for simple 0-3 usually we swap W/H logic in SW or here.
             // ST7735 offsets often relative to physical RAM, so they change with rotation.
             // Simplified handling:
             break;
         case 1:
-            ST7735_WriteSmallData(hlcd, MADCTL_MY | MADCTL_MV | MADCTL_BGR);
+            madctl = MADCTL_MY | MADCTL_MV | MADCTL_BGR;
             break;
         case 2:
-            ST7735_WriteSmallData(hlcd, MADCTL_BGR);
+            madctl = MADCTL_BGR;
             break;
         case 3:
-            ST7735_WriteSmallData(hlcd, MADCTL_MX | MADCTL_MV | MADCTL_BGR);
+            madctl = MADCTL_MX | MADCTL_MV | MADCTL_BGR;
             break;
     }
+
+    ST7735_WriteCommand(hlcd, ST7735_MADCTL, &madctl, 1);
 }
 
 static void ST7735_SetAddressWindow(ST7735_HandleTypeDef *hlcd, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
-    uint8_t data[4];
-    uint16_t x_start = x0 + hlcd->XOffset;
-    uint16_t x_end   = x1 + hlcd->XOffset;
-    uint16_t y_start = y0 + hlcd->YOffset;
-    uint16_t y_end   = y1 + hlcd->YOffset;
-
-    ST7735_WriteCommand(hlcd, ST7735_CASET);
-    data[0] = (x_start >> 8) & 0xFF;
-    data[1] = x_start & 0xFF;
-    data[2] = (x_end >> 8) & 0xFF;
-    data[3] = x_end & 0xFF;
-    ST7735_WriteData(hlcd, data, 4);
-
-    ST7735_WriteCommand(hlcd, ST7735_RASET);
-    data[0] = (y_start >> 8) & 0xFF;
-    data[1] = y_start & 0xFF;
-    data[2] = (y_end >> 8) & 0xFF;
-    data[3] = y_end & 0xFF;
-    ST7735_WriteData(hlcd, data, 4);
-
-    ST7735_WriteCommand(hlcd, ST7735_RAMWR);
+    Display_SPI_SetWindow(&hlcd->Bus, x0 + hlcd->XOffset, y0 + hlcd->YOffset,
+                          x1 + hlcd->XOffset, y1 + hlcd->YOffset);
 }
 
-void ST7735_FillRect(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+void ST7735_FillRectAsync(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
     if ((x >= hlcd->Width) || (y >= hlcd->Height)) return;
     if ((x + w - 1) >= hlcd->Width) w = hlcd->Width - x;
     if ((y + h - 1) >= hlcd->Height) h = hlcd->Height - y;
 
     ST7735_SetAddressWindow(hlcd, x, y, x + w - 1, y + h - 1);
+    Display_SPI_Fill(&hlcd->Bus, color, (uint32_t)w * h);
+}
 
-    uint8_t color_buff[256]; 
-    uint8_t hi = (color >> 8) & 0xFF;
-    uint8_t lo = color & 0xFF;
-    
-    // Fill buffer
-    uint16_t buffer_pixels = sizeof(color_buff) / 2;
-    for (uint16_t i = 0; i < buffer_pixels; i++) {
-        color_buff[i*2] = hi;
-        color_buff[i*2+1] = lo;
-    }
-
-    uint32_t total_pixels = w * h;
-    while (total_pixels > 0) {
-        uint32_t chunk_pixels = (total_pixels > buffer_pixels) ? buffer_pixels : total_pixels;
-        ST7735_WriteData(hlcd, color_buff, chunk_pixels * 2);
-        total_pixels -= chunk_pixels;
-    }
+void ST7735_FillRect(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    ST7735_FillRectAsync(hlcd, x, y, w, h, color);
+    Display_SPI_Wait(&hlcd->Bus);
 }
 
 void ST7735_FillScreen(ST7735_HandleTypeDef *hlcd, uint16_t color) {
@@ -321,29 +212,29 @@ void ST7735_DrawPixel(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16
 
     ST7735_SetAddressWindow(hlcd, x, y, x, y);
     uint8_t data[2] = {(color >> 8) & 0xFF, color & 0xFF};
-    ST7735_WriteData(hlcd, data, 2);
+    Display_SPI_WriteData(&hlcd->Bus, data, 2);
 }
 
-void ST7735_DrawImage(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
+void ST7735_DrawImageAsync(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
     if ((x >= hlcd->Width) || (y >= hlcd->Height)) return;
+
     ST7735_SetAddressWindow(hlcd, x, y, x + w - 1, y + h - 1);
-    
-    uint32_t total_pixels = w * h;
-    uint32_t i = 0;
-    uint8_t line_buff[256]; 
-    uint16_t chunk_size = 128;
-    
-    while (i < total_pixels) {
-        uint32_t current_chunk = (total_pixels - i > chunk_size) ? chunk_size : (total_pixels - i);
-        for (uint32_t k = 0; k < current_chunk; k++) {
-            line_buff[k*2]     = (data[i+k] >> 8) & 0xFF;
-            line_buff[k*2+1]   = data[i+k] & 0xFF;
-        }
-        ST7735_WriteData(hlcd, line_buff, current_chunk * 2);
-        i += current_chunk;
-    }
+    Display_SPI_WritePixels(&hlcd->Bus, data, (uint32_t)w * h);
+}
+
+void ST7735_DrawImage(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
+    ST7735_DrawImageAsync(hlcd, x, y, w, h, data);
+    Display_SPI_Wait(&hlcd->Bus);
+}
+
+void ST7735_WaitDone(ST7735_HandleTypeDef *hlcd) {
+    Display_SPI_Wait(&hlcd->Bus);
+}
+
+uint8_t ST7735_IsBusy(ST7735_HandleTypeDef *hlcd) {
+    return Display_SPI_IsBusy(&hlcd->Bus) ? 1 : 0;
 }
 
 void ST7735_InvertColors(ST7735_HandleTypeDef *hlcd, uint8_t invert) {
-    ST7735_WriteCommand(hlcd, invert ? ST7735_INVON : ST7735_INVOFF);
+    ST7735_WriteCommand(hlcd, invert ? ST7735_INVON : ST7735_INVOFF, NULL, 0);
 }
@@ -9,6 +9,7 @@
 #define __ST7735_H
 
 #include "main.h"
+#include "display_spi.h"
 
 #ifndef __STM32F1xx_HAL_SPI_H
 #include "main.h"
@@ -57,6 +58,8 @@ typedef struct {
     uint16_t          XOffset;
     uint16_t          YOffset;
     uint8_t           Rotation;
+
+    Display_SPI_HandleTypeDef Bus; // Shared SPI transport (ping-pong buffers, DMA)
 } ST7735_HandleTypeDef;
 
 /* Function Prototypes */
@@ -87,4 +90,15 @@ void ST7735_DrawPixel(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16
 void ST7735_FillRect(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 void ST7735_DrawImage(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data);
 
+/**
+ * @brief Start a fill/image stream and return immediately
+ * @note  With a TX DMA channel on hspi the pixels stream in the background.
+ *        Image data must stay valid until ST7735_IsBusy() returns 0. Any other
+ *        call on the same display waits for the stream first.
+ */
+void ST7735_FillRectAsync(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+void ST7735_DrawImageAsync(ST7735_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data);
+void ST7735_WaitDone(ST7735_HandleTypeDef *hlcd);
+uint8_t ST7735_IsBusy(ST7735_HandleTypeDef *hlcd);
+
 #endif // __ST7735_H
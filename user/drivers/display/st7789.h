@@ -27,6 +27,7 @@
 #define __ST7789_H
 
 #include "main.h"
+#include "display_spi.h"
 
 #ifndef __STM32F1xx_HAL_SPI_H
 #include "main.h"
@@ -57,6 +58,8 @@ typedef struct {
     uint16_t          RstPin;
     GPIO_TypeDef      *BlkPort; // Backlight, optional (set to NULL if not used)
     uint16_t          BlkPin;
+
+    Display_SPI_HandleTypeDef Bus; // Shared SPI transport (ping-pong buffers, DMA)
 } ST7789_HandleTypeDef;
 
 /* Function Prototypes */
@@ -89,6 +92,17 @@ void ST7789_DrawPixel(ST7789_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16
 void ST7789_FillRect(ST7789_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 void ST7789_DrawImage(ST7789_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data);
 
+/**
+ * @brief Start a fill/image stream and return immediately
+ * @note  With a TX DMA channel on hspi the pixels stream in the background.
+ *        Image data must stay valid until ST7789_IsBusy() returns 0. Any other
+ *        call on the same display waits for the stream first.
+ */
+void ST7789_FillRectAsync(ST7789_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+void ST7789_DrawImageAsync(ST7789_HandleTypeDef *hlcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data);
+void ST7789_WaitDone(ST7789_HandleTypeDef *hlcd);
+uint8_t ST7789_IsBusy(ST7789_HandleTypeDef *hlcd);
+
 // Simple test pattern
 void ST7789_TestSequence(ST7789_HandleTypeDef *hlcd);
 
@@ -0,0 +1,101 @@
+/**
+ * @file i2c_dma.c
+ * @brief Shared I2C memory-transfer completion dispatch
+ */
+
+#include "i2c_dma.h"
+
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    I2C_DMA_Callback   cb;
+    void              *ctx;
+} I2C_DMA_Slot;
+
+static I2C_DMA_Slot i2c_dma_slots[I2C_DMA_MAX_BUSES];
+
+// --- Private Functions ---
+
+static I2C_DMA_Slot *I2C_DMA_Bind(I2C_HandleTypeDef *hi2c, I2C_DMA_Callback cb, void *ctx) {
+    I2C_DMA_Slot *free_slot = NULL;
+
+    for (int i = 0; i < I2C_DMA_MAX_BUSES; i++) {
+        if (i2c_dma_slots[i].hi2c == hi2c) {
+            free_slot = &i2c_dma_slots[i];
+            break;
+        }
+        if (free_slot == NULL && i2c_dma_slots[i].hi2c == NULL) {
+            free_slot = &i2c_dma_slots[i];
+        }
+    }
+    if (free_slot == NULL) return NULL;
+
+    // Completion cannot fire before the transfer is started, so no locking is needed here
+    free_slot->cb = cb;
+    free_slot->ctx = ctx;
+    free_slot->hi2c = hi2c;
+    return free_slot;
+}
+
+static void I2C_DMA_Complete(I2C_HandleTypeDef *hi2c, bool ok) {
+    for (int i = 0; i < I2C_DMA_MAX_BUSES; i++) {
+        if (i2c_dma_slots[i].hi2c == hi2c) {
+            I2C_DMA_Callback cb = i2c_dma_slots[i].cb;
+            void *ctx = i2c_dma_slots[i].ctx;
+
+            // Unbind first: the callback may start the next transfer
+            i2c_dma_slots[i].cb = NULL;
+            if (cb) cb(ctx, ok);
+            return;
+        }
+    }
+}
+
+// --- Public Functions ---
+
+HAL_StatusTypeDef I2C_DMA_MemWrite(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                   uint16_t MemAddSize, const uint8_t *data, uint16_t len,
+                                   I2C_DMA_Callback cb, void *ctx) {
+    I2C_DMA_Slot *slot = I2C_DMA_Bind(hi2c, cb, ctx);
+    HAL_StatusTypeDef status;
+
+    if (slot == NULL) return HAL_ERROR;
+
+    if (hi2c->hdmatx != NULL) {
+        status = HAL_I2C_Mem_Write_DMA(hi2c, DevAddress, MemAddress, MemAddSize, (uint8_t *)data, len);
+    } else {
+        status = HAL_I2C_Mem_Write_IT(hi2c, DevAddress, MemAddress, MemAddSize, (uint8_t *)data, len);
+    }
+    if (status != HAL_OK) slot->cb = NULL;
+    return status;
+}
+
+HAL_StatusTypeDef I2C_DMA_MemRead(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                  uint16_t MemAddSize, uint8_t *data, uint16_t len,
+                                  I2C_DMA_Callback cb, void *ctx) {
+    I2C_DMA_Slot *slot = I2C_DMA_Bind(hi2c, cb, ctx);
+    HAL_StatusTypeDef status;
+
+    if (slot == NULL) return HAL_ERROR;
+
+    if (hi2c->hdmarx != NULL) {
+        status = HAL_I2C_Mem_Read_DMA(hi2c, DevAddress, MemAddress, MemAddSize, data, len);
+    } else {
+        status = HAL_I2C_Mem_Read_IT(hi2c, DevAddress, MemAddress, MemAddSize, data, len);
+    }
+    if (status != HAL_OK) slot->cb = NULL;
+    return status;
+}
+
+// --- HAL Callbacks ---
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    I2C_DMA_Complete(hi2c, true);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    I2C_DMA_Complete(hi2c, true);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+    I2C_DMA_Complete(hi2c, false);
+}
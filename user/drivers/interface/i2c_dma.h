@@ -0,0 +1,46 @@
+/**
+ * @file i2c_dma.h
+ * @brief Shared I2C memory-transfer completion dispatch
+ *
+ * The I2C counterpart of spi_dma.h. The HAL has a single
+ * HAL_I2C_MemTxCpltCallback / MemRxCpltCallback for all I2C instances, so
+ * drivers that run I2C memory transfers in the background start them through
+ * this module instead of defining the HAL callbacks themselves.
+ *
+ * Transfers use DMA when the handle has the channel (hi2c->hdmatx / hdmarx)
+ * and the interrupt-driven HAL_I2C_Mem_xxx_IT otherwise, so the I2C event and
+ * error interrupts must be enabled in CubeMX either way. Callbacks run in
+ * interrupt context.
+ */
+
+#ifndef __I2C_DMA_H
+#define __I2C_DMA_H
+
+#include "main.h"
+#include <stdbool.h>
+
+// Number of I2C instances that can have a transfer in flight at the same time
+#ifndef I2C_DMA_MAX_BUSES
+#define I2C_DMA_MAX_BUSES 2
+#endif
+
+/**
+ * @brief Transfer complete callback
+ * @param ctx Context given when the transfer was started
+ * @param ok  false if the HAL reported an error (NACK, arbitration loss, ...)
+ */
+typedef void (*I2C_DMA_Callback)(void *ctx, bool ok);
+
+/**
+ * @brief Start a memory write/read and bind its completion to cb(ctx, ok)
+ * @note  The data buffer must stay valid until the callback runs.
+ * @return HAL status of the underlying HAL call (cb is not called on failure)
+ */
+HAL_StatusTypeDef I2C_DMA_MemWrite(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                   uint16_t MemAddSize, const uint8_t *data, uint16_t len,
+                                   I2C_DMA_Callback cb, void *ctx);
+HAL_StatusTypeDef I2C_DMA_MemRead(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                  uint16_t MemAddSize, uint8_t *data, uint16_t len,
+                                  I2C_DMA_Callback cb, void *ctx);
+
+#endif // __I2C_DMA_H
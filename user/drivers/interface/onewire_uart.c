@@ -0,0 +1,224 @@
+/**
+ * @file onewire_uart.c
+ * @brief 1-Wire bus master on a half-duplex UART
+ */
+
+#include "onewire_uart.h"
+#include <string.h>
+
+#define ONEWIRE_SLOT_1      0xFF    // Write 1 / read
+#define ONEWIRE_SLOT_0      0x00    // Write 0
+#define ONEWIRE_RESET_BYTE  0xF0
+
+// --- Private Functions ---
+
+static uint8_t OneWire_SetBaud(OneWire_HandleTypeDef *how, uint32_t baud) {
+    if (how->huart->Init.BaudRate == baud) return ONEWIRE_OK;
+    how->huart->Init.BaudRate = baud;
+    return (HAL_HalfDuplex_Init(how->huart) == HAL_OK) ? ONEWIRE_OK : ONEWIRE_ERR_BUS;
+}
+
+// Send n slot chars from SlotTx and collect their echoes in SlotRx
+static uint8_t OneWire_Slots(OneWire_HandleTypeDef *how, uint16_t n) {
+    UART_HandleTypeDef *huart = how->huart;
+
+    how->Slots += n;
+    how->Transfers++;
+
+    if (how->UseDMA) {
+        uint32_t start;
+
+        // Arm the receiver first: the first echo arrives one char after TX starts
+        if (HAL_UART_Receive_DMA(huart, how->SlotRx, n) != HAL_OK) {
+            how->Errors++;
+            return ONEWIRE_ERR_BUS;
+        }
+        if (HAL_UART_Transmit_DMA(huart, how->SlotTx, n) != HAL_OK) {
+            HAL_UART_AbortReceive(huart);
+            how->Errors++;
+            return ONEWIRE_ERR_BUS;
+        }
+
+        // Interrupts stay enabled: the slots are timed by the UART
+        start = HAL_GetTick();
+        while (huart->RxState != HAL_UART_STATE_READY || huart->gState != HAL_UART_STATE_READY) {
+            if (HAL_GetTick() - start > ONEWIRE_TIMEOUT_MS) {
+                HAL_UART_AbortTransmit(huart);
+                HAL_UART_AbortReceive(huart);
+                how->Errors++;
+                return ONEWIRE_ERR_BUS;
+            }
+        }
+        return ONEWIRE_OK;
+    }
+
+    for (uint16_t i = 0; i < n; i++) {
+        if (HAL_UART_Transmit(huart, &how->SlotTx[i], 1, ONEWIRE_TIMEOUT_MS) != HAL_OK ||
+            HAL_UART_Receive(huart, &how->SlotRx[i], 1, ONEWIRE_TIMEOUT_MS) != HAL_OK) {
+            how->Errors++;
+            return ONEWIRE_ERR_BUS;
+        }
+    }
+    return ONEWIRE_OK;
+}
+
+// Expand bytes into 8 slot chars each, LSB first
+static void OneWire_Expand(OneWire_HandleTypeDef *how, const uint8_t *data, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        for (uint8_t b = 0; b < 8; b++) {
+            how->SlotTx[i * 8 + b] = (data[i] & (1U << b)) ? ONEWIRE_SLOT_1 : ONEWIRE_SLOT_0;
+        }
+    }
+}
+
+// --- Public Functions ---
+
+uint8_t OneWire_Init(OneWire_HandleTypeDef *how, UART_HandleTypeDef *huart) {
+    memset(how, 0, sizeof(*how));
+    how->huart = huart;
+    how->UseDMA = (huart->hdmatx != NULL && huart->hdmarx != NULL) ? 1 : 0;
+
+    huart->Init.BaudRate = ONEWIRE_BAUD_SLOT;
+    return (HAL_HalfDuplex_Init(huart) == HAL_OK) ? ONEWIRE_OK : ONEWIRE_ERR_BUS;
+}
+
+uint8_t OneWire_Reset(OneWire_HandleTypeDef *how) {
+    uint8_t res, echo;
+
+    how->Resets++;
+    if (OneWire_SetBaud(how, ONEWIRE_BAUD_RESET) != ONEWIRE_OK) return ONEWIRE_ERR_BUS;
+
+    how->SlotTx[0] = ONEWIRE_RESET_BYTE;
+    res = OneWire_Slots(how, 1);
+    how->Slots--;   // Not a slot
+    echo = how->SlotRx[0];
+
+    if (OneWire_SetBaud(how, ONEWIRE_BAUD_SLOT) != ONEWIRE_OK || res != ONEWIRE_OK) return ONEWIRE_ERR_BUS;
+    if (echo == ONEWIRE_RESET_BYTE) return ONEWIRE_NO_DEVICE;
+    if (echo == 0x00) {
+        how->Errors++;      // Held low for the whole reset: shorted
+        return ONEWIRE_ERR_BUS;
+    }
+    return ONEWIRE_OK;
+}
+
+uint8_t OneWire_WriteBytes(OneWire_HandleTypeDef *how, const uint8_t *data, uint16_t len) {
+    while (len > 0) {
+        uint16_t chunk = (len > ONEWIRE_MAX_BYTES) ? ONEWIRE_MAX_BYTES : len;
+
+        OneWire_Expand(how, data, chunk);
+        if (OneWire_Slots(how, chunk * 8) != ONEWIRE_OK) return ONEWIRE_ERR_BUS;
+        data += chunk;
+        len -= chunk;
+    }
+    return ONEWIRE_OK;
+}
+
+uint8_t OneWire_ReadBytes(OneWire_HandleTypeDef *how, uint8_t *data, uint16_t len) {
+    while (len > 0) {
+        uint16_t chunk = (len > ONEWIRE_MAX_BYTES) ? ONEWIRE_MAX_BYTES : len;
+
+        memset(how->SlotTx, ONEWIRE_SLOT_1, chunk * 8);
+        if (OneWire_Slots(how, chunk * 8) != ONEWIRE_OK) return ONEWIRE_ERR_BUS;
+        for (uint16_t i = 0; i < chunk; i++) {
+            uint8_t byte = 0;
+
+            for (uint8_t b = 0; b < 8; b++) {
+                if (how->SlotRx[i * 8 + b] == ONEWIRE_SLOT_1) byte |= (uint8_t)(1U << b);
+            }
+            data[i] = byte;
+        }
+        data += chunk;
+        len -= chunk;
+    }
+    return ONEWIRE_OK;
+}
+
+uint8_t OneWire_ReadBit(OneWire_HandleTypeDef *how, uint8_t *bit) {
+    how->SlotTx[0] = ONEWIRE_SLOT_1;
+    if (OneWire_Slots(how, 1) != ONEWIRE_OK) return ONEWIRE_ERR_BUS;
+    *bit = (how->SlotRx[0] == ONEWIRE_SLOT_1) ? 1 : 0;
+    return ONEWIRE_OK;
+}
+
+uint8_t OneWire_Select(OneWire_HandleTypeDef *how, const uint8_t rom[8]) {
+    uint8_t cmd[9];
+    uint8_t res = OneWire_Reset(how);
+
+    if (res != ONEWIRE_OK) return res;
+    if (rom == NULL) {
+        cmd[0] = ONEWIRE_CMD_SKIP_ROM;
+        return OneWire_WriteBytes(how, cmd, 1);
+    }
+    cmd[0] = ONEWIRE_CMD_MATCH_ROM;
+    memcpy(&cmd[1], rom, 8);
+    return OneWire_WriteBytes(how, cmd, sizeof(cmd));
+}
+
+uint8_t OneWire_Search(OneWire_HandleTypeDef *how, uint8_t cmd, uint8_t roms[][8], uint8_t max) {
+    uint8_t rom[8] = {0};
+    int last_discrepancy = -1;
+    uint8_t found = 0;
+
+    while (found < max) {
+        int last_zero = -1;
+
+        if (OneWire_Reset(how) != ONEWIRE_OK) break;
+        if (OneWire_WriteBytes(how, &cmd, 1) != ONEWIRE_OK) break;
+
+        for (int id_bit = 0; id_bit < 64; id_bit++) {
+            uint8_t bit, cmp_bit, dir;
+
+            // Every remaining device sends its bit, then the complement
+            how->SlotTx[0] = ONEWIRE_SLOT_1;
+            how->SlotTx[1] = ONEWIRE_SLOT_1;
+            if (OneWire_Slots(how, 2) != ONEWIRE_OK) return found;
+            bit = (how->SlotRx[0] == ONEWIRE_SLOT_1);
+            cmp_bit = (how->SlotRx[1] == ONEWIRE_SLOT_1);
+
+            if (bit && cmp_bit) return found;       // Nobody left
+            if (bit != cmp_bit) {
+                dir = bit;                          // All agree
+            } else if (id_bit < last_discrepancy) {
+                dir = (rom[id_bit / 8] >> (id_bit % 8)) & 1U;   // Same branch as last time
+            } else {
+                dir = (id_bit == last_discrepancy); // Take the 1 branch this time
+            }
+            if (bit == cmp_bit && dir == 0) last_zero = id_bit;
+
+            if (dir) rom[id_bit / 8] |= (uint8_t)(1U << (id_bit % 8));
+            else     rom[id_bit / 8] &= (uint8_t)~(1U << (id_bit % 8));
+
+            // Devices whose bit differs drop out
+            how->SlotTx[0] = dir ? ONEWIRE_SLOT_1 : ONEWIRE_SLOT_0;
+            if (OneWire_Slots(how, 1) != ONEWIRE_OK) return found;
+        }
+
+        if (OneWire_Crc8(rom, 8) != 0) {
+            how->Errors++;
+            break;
+        }
+        memcpy(roms[found++], rom, 8);
+
+        last_discrepancy = last_zero;
+        if (last_discrepancy < 0) break;            // That was the last device
+    }
+    return found;
+}
+
+uint8_t OneWire_Crc8(const uint8_t *data, uint16_t len) {
+    uint8_t crc = 0;
+
+    while (len--) {
+        uint8_t byte = *data++;
+
+        for (uint8_t b = 0; b < 8; b++) {
+            uint8_t mix = (crc ^ byte) & 0x01;
+
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
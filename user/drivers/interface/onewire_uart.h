@@ -0,0 +1,125 @@
+/**
+ * @file onewire_uart.h
+ * @brief 1-Wire bus master on a half-duplex UART
+ *
+ * The UART generates the 1-Wire timing, so no slot needs a busy wait or an
+ * interrupt-off window:
+ *   - Reset: 0xF0 at 9600 baud is a ~520 us low pulse. A presence pulse
+ *     from any slave changes the byte read back.
+ *   - Slot: one char at 115200 baud. 0x00 is a write-0 slot (~78 us low),
+ *     0xFF a write-1 / read slot (~9 us low start bit). Read back 0xFF means
+ *     the bus stayed high (1); any other value means a slave held it low (0).
+ *
+ * When the UART has both DMA channels linked (hdmatx, hdmarx) a whole
+ * command (up to ONEWIRE_MAX_BYTES bytes, 8 slots each) goes out as one DMA
+ * transfer and the echoes come back by DMA; otherwise each slot is a polled
+ * HAL_UART_Transmit / HAL_UART_Receive. Completion is taken from the HAL
+ * handle state, so no HAL UART callback is claimed and uart.c can serve the
+ * other UARTs in the same build.
+ *
+ * Wiring (CubeMX): USART in Single Wire (Half-Duplex) mode, 8N1, TX pin
+ * alternate function open-drain with a 4.7k pull-up to 3.3 V. The UART
+ * global interrupt must be enabled for DMA mode (the HAL finishes a DMA
+ * transmit on the TC interrupt).
+ *
+ * Usage:
+ *      OneWire_HandleTypeDef ow;
+ *      uint8_t roms[4][8];
+ *      OneWire_Init(&ow, &huart3);
+ *      uint8_t n = OneWire_Search(&ow, ONEWIRE_CMD_SEARCH_ROM, roms, 4);
+ *      OneWire_Select(&ow, roms[0]);          // Reset + Match ROM
+ *      OneWire_WriteBytes(&ow, &cmd, 1);
+ */
+
+#ifndef __ONEWIRE_UART_H
+#define __ONEWIRE_UART_H
+
+#include "main.h"
+
+// Data bytes per DMA transfer (8 slot chars each, two buffers of 8x this)
+// 10 holds Match ROM + ROM code + a function command
+#ifndef ONEWIRE_MAX_BYTES
+#define ONEWIRE_MAX_BYTES 10
+#endif
+
+// Longest wait for one transfer to come back
+#ifndef ONEWIRE_TIMEOUT_MS
+#define ONEWIRE_TIMEOUT_MS 20
+#endif
+
+#define ONEWIRE_BAUD_RESET  9600
+#define ONEWIRE_BAUD_SLOT   115200
+
+// ROM commands
+#define ONEWIRE_CMD_READ_ROM      0x33
+#define ONEWIRE_CMD_MATCH_ROM     0x55
+#define ONEWIRE_CMD_SKIP_ROM      0xCC
+#define ONEWIRE_CMD_SEARCH_ROM    0xF0
+#define ONEWIRE_CMD_ALARM_SEARCH  0xEC
+
+// Return codes
+#define ONEWIRE_OK            0
+#define ONEWIRE_NO_DEVICE     1     // No presence pulse
+#define ONEWIRE_ERR_BUS       2     // UART/DMA failure, timeout or bus held low
+
+typedef struct {
+    UART_HandleTypeDef *huart;
+    uint8_t   UseDMA;           // Slots by DMA (huart has TX and RX channels)
+
+    uint8_t   SlotTx[ONEWIRE_MAX_BYTES * 8];
+    uint8_t   SlotRx[ONEWIRE_MAX_BYTES * 8];
+
+    uint32_t  Resets;
+    uint32_t  Slots;
+    uint32_t  Transfers;        // DMA transfers or polled slot groups
+    uint32_t  Errors;
+} OneWire_HandleTypeDef;
+
+/**
+ * @brief Bind the bus to a UART in half-duplex mode, at slot speed
+ * @return ONEWIRE_OK, ONEWIRE_ERR_BUS if the UART could not be initialized
+ */
+uint8_t OneWire_Init(OneWire_HandleTypeDef *how, UART_HandleTypeDef *huart);
+
+/**
+ * @brief Reset pulse and presence detect
+ * @return ONEWIRE_OK if at least one device answered, ONEWIRE_NO_DEVICE,
+ *         ONEWIRE_ERR_BUS if the line is shorted to ground
+ */
+uint8_t OneWire_Reset(OneWire_HandleTypeDef *how);
+
+/**
+ * @brief Write / read bytes, LSB first
+ * @return ONEWIRE_OK or ONEWIRE_ERR_BUS
+ */
+uint8_t OneWire_WriteBytes(OneWire_HandleTypeDef *how, const uint8_t *data, uint16_t len);
+uint8_t OneWire_ReadBytes(OneWire_HandleTypeDef *how, uint8_t *data, uint16_t len);
+
+/**
+ * @brief Single read slot (bit is 0 or 1)
+ * @note  Slaves that signal "busy" by holding read slots low (DS18B20 during
+ *        a conversion) can be polled with this.
+ */
+uint8_t OneWire_ReadBit(OneWire_HandleTypeDef *how, uint8_t *bit);
+
+/**
+ * @brief Reset, then address one device (Match ROM) or all (Skip ROM, rom NULL)
+ * @return As OneWire_Reset
+ */
+uint8_t OneWire_Select(OneWire_HandleTypeDef *how, const uint8_t rom[8]);
+
+/**
+ * @brief Enumerate the devices on the bus (Maxim search algorithm)
+ * @param cmd  ONEWIRE_CMD_SEARCH_ROM for all, ONEWIRE_CMD_ALARM_SEARCH for
+ *             devices with an alarm condition
+ * @param roms Receives the ROM codes, CRC checked
+ * @return Number of devices found (at most max)
+ */
+uint8_t OneWire_Search(OneWire_HandleTypeDef *how, uint8_t cmd, uint8_t roms[][8], uint8_t max);
+
+/**
+ * @brief Dallas/Maxim CRC-8 (x^8 + x^5 + x^4 + 1), 0 over data + its CRC
+ */
+uint8_t OneWire_Crc8(const uint8_t *data, uint16_t len);
+
+#endif // __ONEWIRE_UART_H
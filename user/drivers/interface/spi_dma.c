@@ -0,0 +1,109 @@
+/**
+ * @file spi_dma.c
+ * @brief Shared SPI DMA completion dispatch
+ */
+
+#include "spi_dma.h"
+
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    SPI_DMA_Callback   cb;
+    void              *ctx;
+} SPI_DMA_Slot;
+
+static SPI_DMA_Slot spi_dma_slots[SPI_DMA_MAX_BUSES];
+
+// --- Private Functions ---
+
+static SPI_DMA_Slot *SPI_DMA_Bind(SPI_HandleTypeDef *hspi, SPI_DMA_Callback cb, void *ctx) {
+    SPI_DMA_Slot *free_slot = NULL;
+
+    for (int i = 0; i < SPI_DMA_MAX_BUSES; i++) {
+        if (spi_dma_slots[i].hspi == hspi) {
+            free_slot = &spi_dma_slots[i];
+            break;
+        }
+        if (free_slot == NULL && spi_dma_slots[i].hspi == NULL) {
+            free_slot = &spi_dma_slots[i];
+        }
+    }
+    if (free_slot == NULL) return NULL;
+
+    // Completion cannot fire before the DMA is started, so no locking is needed here
+    free_slot->cb = cb;
+    free_slot->ctx = ctx;
+    free_slot->hspi = hspi;
+    return free_slot;
+}
+
+static void SPI_DMA_Complete(SPI_HandleTypeDef *hspi, bool ok) {
+    for (int i = 0; i < SPI_DMA_MAX_BUSES; i++) {
+        if (spi_dma_slots[i].hspi == hspi) {
+            SPI_DMA_Callback cb = spi_dma_slots[i].cb;
+            void *ctx = spi_dma_slots[i].ctx;
+
+            // Unbind first: the callback may start the next transfer
+            spi_dma_slots[i].cb = NULL;
+            if (cb) cb(ctx, ok);
+            return;
+        }
+    }
+}
+
+// --- Public Functions ---
+
+bool SPI_DMA_HasTx(SPI_HandleTypeDef *hspi) {
+    return hspi != NULL && hspi->hdmatx != NULL;
+}
+
+bool SPI_DMA_HasRx(SPI_HandleTypeDef *hspi) {
+    return hspi != NULL && hspi->hdmarx != NULL;
+}
+
+HAL_StatusTypeDef SPI_DMA_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *data, uint16_t len,
+                                   SPI_DMA_Callback cb, void *ctx) {
+    SPI_DMA_Slot *slot = SPI_DMA_Bind(hspi, cb, ctx);
+    if (slot == NULL) return HAL_ERROR;
+
+    HAL_StatusTypeDef status = HAL_SPI_Transmit_DMA(hspi, (uint8_t *)data, len);
+    if (status != HAL_OK) slot->cb = NULL;
+    return status;
+}
+
+HAL_StatusTypeDef SPI_DMA_Receive(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t len,
+                                  SPI_DMA_Callback cb, void *ctx) {
+    SPI_DMA_Slot *slot = SPI_DMA_Bind(hspi, cb, ctx);
+    if (slot == NULL) return HAL_ERROR;
+
+    HAL_StatusTypeDef status = HAL_SPI_Receive_DMA(hspi, data, len);
+    if (status != HAL_OK) slot->cb = NULL;
+    return status;
+}
+
+HAL_StatusTypeDef SPI_DMA_TransmitReceive(SPI_HandleTypeDef *hspi, const uint8_t *tx, uint8_t *rx,
+                                          uint16_t len, SPI_DMA_Callback cb, void *ctx) {
+    SPI_DMA_Slot *slot = SPI_DMA_Bind(hspi, cb, ctx);
+    if (slot == NULL) return HAL_ERROR;
+
+    HAL_StatusTypeDef status = HAL_SPI_TransmitReceive_DMA(hspi, (uint8_t *)tx, rx, len);
+    if (status != HAL_OK) slot->cb = NULL;
+    return status;
+}
+
+// --- HAL Callbacks ---
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+    SPI_DMA_Complete(hspi, true);
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi) {
+    SPI_DMA_Complete(hspi, true);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
+    SPI_DMA_Complete(hspi, true);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+    SPI_DMA_Complete(hspi, false);
+}
@@ -0,0 +1,49 @@
+/**
+ * @file spi_dma.h
+ * @brief Shared SPI DMA completion dispatch
+ *
+ * The HAL has a single HAL_SPI_xxxCpltCallback for all SPI instances. Drivers
+ * that use SPI DMA start their transfers through this module instead of
+ * defining the HAL callbacks themselves, so several drivers (display, flash,
+ * SD card) can share one bus or sit on different buses in the same build.
+ *
+ * The completion callback is bound per transfer: whoever started the current
+ * transfer on a bus gets its completion. Callbacks run in interrupt context.
+ */
+
+#ifndef __SPI_DMA_H
+#define __SPI_DMA_H
+
+#include "main.h"
+#include <stdbool.h>
+
+// Number of SPI instances that can have a transfer in flight at the same time
+#ifndef SPI_DMA_MAX_BUSES
+#define SPI_DMA_MAX_BUSES 3
+#endif
+
+/**
+ * @brief Transfer complete callback
+ * @param ctx Context given when the transfer was started
+ * @param ok  false if the HAL reported an error
+ */
+typedef void (*SPI_DMA_Callback)(void *ctx, bool ok);
+
+/**
+ * @brief Check whether the SPI handle has the DMA channels a transfer needs
+ */
+bool SPI_DMA_HasTx(SPI_HandleTypeDef *hspi);
+bool SPI_DMA_HasRx(SPI_HandleTypeDef *hspi);
+
+/**
+ * @brief Start a DMA transfer and bind its completion to cb(ctx, ok)
+ * @return HAL status of the underlying HAL_SPI_xxx_DMA call (cb is not called on failure)
+ */
+HAL_StatusTypeDef SPI_DMA_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *data, uint16_t len,
+                                   SPI_DMA_Callback cb, void *ctx);
+HAL_StatusTypeDef SPI_DMA_Receive(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t len,
+                                  SPI_DMA_Callback cb, void *ctx);
+HAL_StatusTypeDef SPI_DMA_TransmitReceive(SPI_HandleTypeDef *hspi, const uint8_t *tx, uint8_t *rx,
+                                          uint16_t len, SPI_DMA_Callback cb, void *ctx);
+
+#endif // __SPI_DMA_H
@@ -3,88 +3,173 @@
  * @brief WS2812B Driver Implementation
  * @author Standard Implementation
  * @date 2024
+ *
+ * The timer channel's DMA runs in circular mode over a buffer of two LEDs'
+ * bit timings. Each half/full transfer callback means one LED slot has gone
+ * out, and that half is refilled with the next LED (or with zero duty for
+ * the reset time after the last LED) while the DMA sends the other half.
+ * RAM per LED is the 3-byte pixel only, whatever the strip length.
  */
 
 #include "ws2812.h"
 #include <string.h>
 
+// Strips with a frame in flight, for routing the shared HAL TIM callbacks
+static WS2812_HandleTypeDef *ws2812_active[WS2812_MAX_STRIPS];
+
+// --- Private Functions ---
+
+static void WS2812_BuildTable(WS2812_HandleTypeDef *hws, uint16_t period) {
+    uint16_t pwm_0 = WS2812_DUTY_0(period);
+    uint16_t pwm_1 = WS2812_DUTY_1(period);
+
+    for (int n = 0; n < 16; n++) {
+        for (int j = 0; j < 4; j++) {
+            hws->Nibble[n][j] = (n & (0x08 >> j)) ? pwm_1 : pwm_0;
+        }
+    }
+    hws->Period = period;
+}
+
+static inline void WS2812_ExpandByte(const WS2812_HandleTypeDef *hws, uint16_t *dst, uint8_t v) {
+    memcpy(dst,     hws->Nibble[v >> 4],   sizeof(hws->Nibble[0]));
+    memcpy(dst + 4, hws->Nibble[v & 0x0F], sizeof(hws->Nibble[0]));
+}
+
+// Expand the next LED slot into one half of the DMA buffer
+static void WS2812_FillHalf(WS2812_HandleTypeDef *hws, uint8_t half) {
+    uint16_t *dst = &hws->DMA_Buffer[half * 24];
+
+    if (hws->NextLED < hws->NumLEDs) {
+        const uint8_t *px = hws->Pixels[hws->NextLED];
+
+        // WS2812 Protocol: GRB Order. MSB First.
+        WS2812_ExpandByte(hws, dst,      px[1]);
+        WS2812_ExpandByte(hws, dst + 8,  px[0]);
+        WS2812_ExpandByte(hws, dst + 16, px[2]);
+    } else {
+        // Reset: line low for the whole slot
+        memset(dst, 0, 24 * sizeof(uint16_t));
+    }
+    hws->NextLED++;
+}
+
+static void WS2812_SetActive(WS2812_HandleTypeDef *hws, uint8_t active) {
+    for (int i = 0; i < WS2812_MAX_STRIPS; i++) {
+        if (active && ws2812_active[i] == NULL) {
+            ws2812_active[i] = hws;
+            return;
+        }
+        if (!active && ws2812_active[i] == hws) {
+            ws2812_active[i] = NULL;
+            return;
+        }
+    }
+}
+
+static WS2812_HandleTypeDef *WS2812_FindActive(TIM_HandleTypeDef *htim) {
+    for (int i = 0; i < WS2812_MAX_STRIPS; i++) {
+        WS2812_HandleTypeDef *hws = ws2812_active[i];
+
+        if (hws && hws->htim == htim &&
+            htim->Channel == (HAL_TIM_ActiveChannel)(1U << (hws->Channel >> 2))) {
+            return hws;
+        }
+    }
+    return NULL;
+}
+
+// One LED slot has been sent from the given half
+static void WS2812_SlotSent(WS2812_HandleTypeDef *hws, uint8_t half) {
+    if (!hws->Busy) return;
+
+    hws->SentLEDs++;
+    if (hws->SentLEDs >= hws->NumLEDs + WS2812_RESET_LEDS) {
+        // Frame and reset time are out; the line stays low when PWM stops
+        HAL_TIM_PWM_Stop_DMA(hws->htim, hws->Channel);
+        WS2812_SetActive(hws, 0);
+        hws->Busy = 0;
+        return;
+    }
+    WS2812_FillHalf(hws, half);
+}
+
+// --- Public Functions ---
+
 void WS2812_Init(WS2812_HandleTypeDef *hws, TIM_HandleTypeDef *htim, uint32_t channel, uint16_t num_leds) {
+    WS2812_InitBuffer(hws, htim, channel, hws->RGB_Buffer,
+                      (num_leds > WS2812_MAX_LEDS) ? WS2812_MAX_LEDS : num_leds);
+}
+
+void WS2812_InitBuffer(WS2812_HandleTypeDef *hws, TIM_HandleTypeDef *htim, uint32_t channel,
+                       uint8_t (*pixels)[3], uint16_t num_leds) {
     hws->htim = htim;
     hws->Channel = channel;
-    hws->NumLEDs = (num_leds > WS2812_MAX_LEDS) ? WS2812_MAX_LEDS : num_leds;
+    hws->Pixels = pixels;
+    hws->NumLEDs = num_leds;
     hws->Busy = 0;
-    
+    hws->Period = 0;
+
     // Clear Buffers
     WS2812_Fill(hws, 0, 0, 0);
-    
+
     // Stop PWM initially
     HAL_TIM_PWM_Stop(htim, channel);
 }
 
 void WS2812_SetPixelColor(WS2812_HandleTypeDef *hws, uint16_t index, uint8_t r, uint8_t g, uint8_t b) {
     if (index >= hws->NumLEDs) return;
-    hws->RGB_Buffer[index][0] = r;
-    hws->RGB_Buffer[index][1] = g;
-    hws->RGB_Buffer[index][2] = b;
+    hws->Pixels[index][0] = r;
+    hws->Pixels[index][1] = g;
+    hws->Pixels[index][2] = b;
 }
 
 void WS2812_Fill(WS2812_HandleTypeDef *hws, uint8_t r, uint8_t g, uint8_t b) {
     for (int i=0; i<hws->NumLEDs; i++) {
-        hws->RGB_Buffer[i][0] = r;
-        hws->RGB_Buffer[i][1] = g;
-        hws->RGB_Buffer[i][2] = b;
+        hws->Pixels[i][0] = r;
+        hws->Pixels[i][1] = g;
+        hws->Pixels[i][2] = b;
     }
 }
 
 void WS2812_Show(WS2812_HandleTypeDef *hws) {
     if (hws->Busy) return; // Skip if previous transfer not done
-    
-    hws->Busy = 1;
-    
-    uint16_t period = hws->htim->Init.Period; 
+
+    uint16_t period = hws->htim->Init.Period;
     // Usually Configured ARR is Period-1 logic in registers, but Init.Period holds the set value.
     if (period == 0) period = 90; // Fallback default (~800kHz at 72MHz)
-    
-    uint16_t pwm_0 = WS2812_DUTY_0(period);
-    uint16_t pwm_1 = WS2812_DUTY_1(period);
-    
-    uint32_t ptr = 0;
-    
-    for (int i=0; i<hws->NumLEDs; i++) {
-        // WS2812 Protocol: GRB Order. MSB First.
-        uint8_t g = hws->RGB_Buffer[i][1];
-        uint8_t r = hws->RGB_Buffer[i][0];
-        uint8_t b = hws->RGB_Buffer[i][2];
-        
-        // Green
-        for (int j=7; j>=0; j--) {
-            hws->DMA_Buffer[ptr++] = (g & (1 << j)) ? pwm_1 : pwm_0;
-        }
-        // Red
-        for (int j=7; j>=0; j--) {
-            hws->DMA_Buffer[ptr++] = (r & (1 << j)) ? pwm_1 : pwm_0;
-        }
-        // Blue
-        for (int j=7; j>=0; j--) {
-            hws->DMA_Buffer[ptr++] = (b & (1 << j)) ? pwm_1 : pwm_0;
-        }
+    if (period != hws->Period) WS2812_BuildTable(hws, period);
+
+    hws->NextLED = 0;
+    hws->SentLEDs = 0;
+    WS2812_FillHalf(hws, 0);
+    WS2812_FillHalf(hws, 1);
+
+    hws->Busy = 1;
+    WS2812_SetActive(hws, 1);
+
+    // Circular DMA: the callbacks keep feeding it until the reset time is out
+    if (HAL_TIM_PWM_Start_DMA(hws->htim, hws->Channel, (uint32_t*)hws->DMA_Buffer,
+                              WS2812_DMA_LEDS * 24) != HAL_OK) {
+        WS2812_SetActive(hws, 0);
+        hws->Busy = 0;
     }
-    
-    // Set End pulse (0)
-    hws->DMA_Buffer[ptr] = 0; 
-    
-    // Start DMA
-    // Note: DMA Buffer length = NumLEDs * 24 + 1
-    // Need to cast buffer for HAL API
-    HAL_TIM_PWM_Start_DMA(hws->htim, hws->Channel, (uint32_t*)hws->DMA_Buffer, ptr + 1);
+}
+
+void WS2812_DmaHalfCallback(WS2812_HandleTypeDef *hws) {
+    WS2812_SlotSent(hws, 0);
 }
 
 void WS2812_DmaCallback(WS2812_HandleTypeDef *hws) {
-    // Stop PWM to generate Reset code (>50us low) automatically since last cycle was 0 or just stop
-    HAL_TIM_PWM_Stop_DMA(hws->htim, hws->Channel);
-    // Be careful: Stop_DMA usually stops output.
-    // Ensure the output is Low when Idle.
-    // The last element of buffer was 0, so duty dropped to 0.
-    
-    hws->Busy = 0;
+    WS2812_SlotSent(hws, 1);
+}
+
+void WS2812_TIM_HalfCallback(TIM_HandleTypeDef *htim) {
+    WS2812_HandleTypeDef *hws = WS2812_FindActive(htim);
+    if (hws) WS2812_SlotSent(hws, 0);
+}
+
+void WS2812_TIM_Callback(TIM_HandleTypeDef *htim) {
+    WS2812_HandleTypeDef *hws = WS2812_FindActive(htim);
+    if (hws) WS2812_SlotSent(hws, 1);
 }
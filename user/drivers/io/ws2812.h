@@ -7,7 +7,23 @@ extern "C" {
 
 #include "main.h"
 // --- Configuration ---
+#ifndef WS2812_MAX_LEDS
 #define WS2812_MAX_LEDS     64
+#endif
+
+// LEDs of bit timings in the circular DMA buffer (one per half)
+#define WS2812_DMA_LEDS     2
+
+// Low time after the last LED, in LED slots (30 us each at 800 kHz).
+// 2 covers the 50 us latch of WS2812B; use 10 for the 280 us of WS2812B-V5.
+#ifndef WS2812_RESET_LEDS
+#define WS2812_RESET_LEDS   2
+#endif
+
+// Strips that can be refreshing at the same time (parallel timer channels)
+#ifndef WS2812_MAX_STRIPS
+#define WS2812_MAX_STRIPS   4
+#endif
 
 // Timings (Dynamically calculated based on ARR)
 #define WS2812_DUTY_0(period)  ((period * 32) / 100)
@@ -17,31 +33,51 @@ typedef struct {
     TIM_HandleTypeDef *htim;
     uint32_t           Channel;
     uint16_t           NumLEDs;
-    
-    // Pixel Buffer (RGB)
-    uint8_t            RGB_Buffer[WS2812_MAX_LEDS][3]; 
-                                                       
-    // DMA Buffer (Bit-timing buffer) - Warning: Large Size!
-    // Recommend defining this struct as Global/Static, NOT on Stack.
-    uint16_t           DMA_Buffer[WS2812_MAX_LEDS * 24 + 1]; 
-    
-    uint8_t            Busy;
+
+    // Pixel Buffer (RGB), 3 bytes per LED. Pixels points at RGB_Buffer, or
+    // at a caller buffer for strips longer than WS2812_MAX_LEDS
+    uint8_t            RGB_Buffer[WS2812_MAX_LEDS][3];
+    uint8_t          (*Pixels)[3];
+
+    // DMA Buffer (Bit-timing buffer): two LEDs, refilled from the half and
+    // full transfer callbacks while the other half is being sent
+    uint16_t           DMA_Buffer[WS2812_DMA_LEDS * 24];
+
+    // Bit expansion table: duty values for the 4 bits of each nibble, MSB first
+    uint16_t           Nibble[16][4];
+    uint16_t           Period;      // ARR the table was built for
+
+    uint16_t           NextLED;     // Next LED slot to expand into the buffer
+    uint16_t           SentLEDs;    // LED slots clocked out this frame
+
+    volatile uint8_t   Busy;
 } WS2812_HandleTypeDef;
 
-// Init (htim must be PWM+DMA configured)
+// Init (htim must be PWM+DMA configured, DMA in circular mode)
 void WS2812_Init(WS2812_HandleTypeDef *hws, TIM_HandleTypeDef *htim, uint32_t channel, uint16_t num_leds);
 
+// Init with caller pixel storage (num_leds * 3 bytes), for long strips
+void WS2812_InitBuffer(WS2812_HandleTypeDef *hws, TIM_HandleTypeDef *htim, uint32_t channel,
+                       uint8_t (*pixels)[3], uint16_t num_leds);
+
 // Set Single Pixel
 void WS2812_SetPixelColor(WS2812_HandleTypeDef *hws, uint16_t index, uint8_t r, uint8_t g, uint8_t b);
 
 // Fill All
 void WS2812_Fill(WS2812_HandleTypeDef *hws, uint8_t r, uint8_t g, uint8_t b);
 
-// Update/Refresh (Start DMA Transfer)
+// Update/Refresh (Start DMA Transfer). Skipped while the previous frame is still going out.
+// Pixels are read as the frame goes out: change them only while Busy is 0.
 void WS2812_Show(WS2812_HandleTypeDef *hws);
 
-// DMA Callback (Call from HAL_TIM_PWM_PulseFinishedCallback)
+// DMA Callbacks for a single strip
+// (Call from HAL_TIM_PWM_PulseFinishedCallback / HAL_TIM_PWM_PulseFinishedHalfCpltCallback)
 void WS2812_DmaCallback(WS2812_HandleTypeDef *hws);
+void WS2812_DmaHalfCallback(WS2812_HandleTypeDef *hws);
+
+// DMA Callbacks for several strips: routed to the strip refreshing on htim's active channel
+void WS2812_TIM_Callback(TIM_HandleTypeDef *htim);
+void WS2812_TIM_HalfCallback(TIM_HandleTypeDef *htim);
 
 #ifdef __cplusplus
 }
@@ -26,7 +26,8 @@ void app_main(void)
 
     UART_SendString(CH_DEBUG, "\r\n--- WS2812 Test Start ---\r\n");
     UART_SendString(CH_DEBUG, "Warning: Ensure Timer PWM+DMA is Configured in CubeMX!\r\n");
-    UART_SendString(CH_DEBUG, "Warning: Ensure HAL_TIM_PWM_PulseFinishedCallback calls WS2812_DmaCallback!\r\n");
+    UART_SendString(CH_DEBUG, "Warning: Ensure the TIM DMA is in Circular mode!\r\n");
+    UART_SendString(CH_DEBUG, "Warning: Ensure the PulseFinished (Half)Cplt callbacks call WS2812_Dma(Half)Callback!\r\n");
 
     // Initialize (8 LEDs on TIM2 Channel 1)
     // Adjust TIM and Channel according to your hardware wiring!
@@ -66,8 +67,14 @@ void app_main(void)
 // Note: This might conflict if main.c also defines it without weak linkage.
 /*
 void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim) {
-    if (htim->Instance == TIM2) {
+    if (htim->Instance == TIM3) {
         WS2812_DmaCallback(&hws);
     }
 }
+
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim) {
+    if (htim->Instance == TIM3) {
+        WS2812_DmaHalfCallback(&hws);
+    }
+}
 */
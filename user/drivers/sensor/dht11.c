@@ -1,6 +1,21 @@
 #include "dht11.h"
 #include "delay.h"
 
+/* Background read states */
+#define DHT11_STATE_IDLE    0
+#define DHT11_STATE_START   1   /* Line held low (start signal) */
+#define DHT11_STATE_RX      2   /* Line released, capturing edges */
+
+#define DHT11_START_MS      19  /* >= 18 ms whatever the tick phase */
+#define DHT11_FRAME_MS      10  /* Response + 40 bits take ~5 ms */
+
+/* Falling edge spacing (us) */
+#define DHT11_RESPONSE_MIN  120 /* 80 low + 80 high */
+#define DHT11_RESPONSE_MAX  220
+#define DHT11_BIT_MIN       60  /* 50 low + 26..28 high: 0 */
+#define DHT11_BIT_ONE       100 /* 50 low + 70 high: 1 */
+#define DHT11_BIT_MAX       160
+
 static void DHT11_HandleError(DHT11_Handle_t *dev) {
     if (dev) {
         dev->error_cnt++;
@@ -14,20 +29,16 @@ void DHT11_SetErrorCallback(DHT11_Handle_t *dev, void (*cb)(DHT11_Handle_t *)) {
     if (dev) dev->error_cb = cb;
 }
 
-static void DHT11_Pin_Output(DHT11_Handle_t *dev) {
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin = dev->pin;
-    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-    HAL_GPIO_Init(dev->port, &GPIO_InitStruct);
+void DHT11_SetDoneCallback(DHT11_Handle_t *dev, void (*cb)(DHT11_Handle_t *, DHT11_Status)) {
+    if (dev) dev->done_cb = cb;
 }
 
-static void DHT11_Pin_Input(DHT11_Handle_t *dev) {
+static void DHT11_Pin_Mode(DHT11_Handle_t *dev, uint32_t mode) {
     GPIO_InitTypeDef GPIO_InitStruct = {0};
     GPIO_InitStruct.Pin = dev->pin;
-    GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+    GPIO_InitStruct.Mode = mode;
     GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
     HAL_GPIO_Init(dev->port, &GPIO_InitStruct);
 }
 
@@ -35,32 +46,56 @@ static void DHT11_Pin_Write(DHT11_Handle_t *dev, uint8_t level) {
     HAL_GPIO_WritePin(dev->port, dev->pin, level ? GPIO_PIN_SET : GPIO_PIN_RESET);
 }
 
-static uint8_t DHT11_Pin_Read(DHT11_Handle_t *dev) {
-    return (uint8_t)HAL_GPIO_ReadPin(dev->port, dev->pin);
-}
+/* Bits from the spacing of the captured falling edges */
+static DHT11_Status DHT11_Decode(DHT11_Handle_t *dev) {
+    uint32_t cycles_per_us = HAL_RCC_GetHCLKFreq() / 1000000U;
+    uint8_t buf[5] = {0};
+    uint32_t us;
 
-static uint8_t DHT11_Read_Byte(DHT11_Handle_t *dev) {
-    uint8_t i, byte = 0;
-    for (i = 0; i < 8; i++) {
-        /* Wait for pin to go high (start of bit) */
-        uint32_t timeout = 0;
-        while (DHT11_Pin_Read(dev) == 0) {
-            if (++timeout > 1000) return 0; // simple guard
-        }
-        
-        // Wait 30us to determine 0 or 1
-        Delay_us(35); 
-        
-        if (DHT11_Pin_Read(dev) == 1) {
-            byte |= (1 << (7 - i));
-        }
-        
-        /* Wait for pin to go low (end of bit) */
-        while (DHT11_Pin_Read(dev) == 1) {
-             if (++timeout > 1000) break; 
+    if (dev->edge_cnt < DHT11_EDGES) return DHT11_ERROR_TIMEOUT;
+
+    us = (dev->edges[1] - dev->edges[0]) / cycles_per_us;
+    if (us < DHT11_RESPONSE_MIN || us > DHT11_RESPONSE_MAX) return DHT11_ERROR_TIMEOUT;
+
+    for (uint8_t i = 0; i < 40; i++) {
+        us = (dev->edges[i + 2] - dev->edges[i + 1]) / cycles_per_us;
+        if (us < DHT11_BIT_MIN || us > DHT11_BIT_MAX) return DHT11_ERROR_TIMEOUT;
+        if (us > DHT11_BIT_ONE) {
+            buf[i / 8] |= (uint8_t)(1U << (7 - (i % 8)));
         }
     }
-    return byte;
+
+    /* Check Checksum */
+    uint8_t sum = buf[0] + buf[1] + buf[2] + buf[3];
+    if (sum != buf[4]) return DHT11_ERROR_CHECKSUM;
+
+    dev->humidity_int = buf[0];
+    dev->humidity_dec = buf[1];
+    dev->temp_int = buf[2];
+    dev->temp_dec = buf[3];
+    return DHT11_OK;
+}
+
+static void DHT11_Finish(DHT11_Handle_t *dev, DHT11_Status status) {
+    /* Back to idle high, EXTI off: HAL_GPIO_Init to an output mode leaves the
+     * EXTI line enabled, only HAL_GPIO_DeInit clears it. The line is pulled up,
+     * so it stays high while the pin is briefly an input */
+    HAL_GPIO_DeInit(dev->port, dev->pin);
+    DHT11_Pin_Write(dev, 1);
+    DHT11_Pin_Mode(dev, GPIO_MODE_OUTPUT_OD);
+    dev->state = DHT11_STATE_IDLE;
+    dev->last_status = status;
+
+    if (status == DHT11_OK) {
+        dev->successful_read_cnt++;
+    } else {
+        if (status == DHT11_ERROR_TIMEOUT) dev->timeout_cnt++;
+        if (status == DHT11_ERROR_CHECKSUM) dev->checksum_error_cnt++;
+        DHT11_HandleError(dev);
+    }
+    if (dev->done_cb) {
+        dev->done_cb(dev, status);
+    }
 }
 
 /* ============================================================================
@@ -72,107 +107,86 @@ void DHT11_Init(DHT11_Handle_t *dev, GPIO_TypeDef *port, uint16_t pin) {
 
     dev->port = port;
     dev->pin = pin;
-    
+
     dev->humidity_int = 0;
     dev->humidity_dec = 0;
     dev->temp_int = 0;
     dev->temp_dec = 0;
-    
+
+    dev->state = DHT11_STATE_IDLE;
+    dev->edge_cnt = 0;
+    dev->state_tick = 0;
+    dev->last_status = DHT11_ERROR_TIMEOUT;     /* Nothing read yet */
+
     dev->error_cnt = 0;
     dev->timeout_cnt = 0;
     dev->checksum_error_cnt = 0;
     dev->successful_read_cnt = 0;
     dev->error_cb = NULL;
+    dev->done_cb = NULL;
 
-    DHT11_Pin_Output(dev);
+    Delay_Init();   /* DWT cycle counter for the edge timestamps */
+
+    DHT11_Pin_Mode(dev, GPIO_MODE_OUTPUT_OD);
     DHT11_Pin_Write(dev, 1); // Idle high
 }
 
-DHT11_Status DHT11_Read(DHT11_Handle_t *dev) {
+DHT11_Status DHT11_Start(DHT11_Handle_t *dev) {
     if (!dev) return DHT11_ERROR_GPIO;
+    if (dev->state != DHT11_STATE_IDLE) return DHT11_BUSY;
 
-    uint8_t buf[5] = {0};
-    uint8_t i;
+    DHT11_Pin_Write(dev, 0); // Start signal: low for at least 18ms
+    dev->state_tick = HAL_GetTick();
+    dev->state = DHT11_STATE_START;
+    return DHT11_OK;
+}
 
-    // Critical Section
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
+DHT11_Status DHT11_Poll(DHT11_Handle_t *dev) {
+    if (!dev) return DHT11_ERROR_GPIO;
 
-    DHT11_Pin_Output(dev);
-    DHT11_Pin_Write(dev, 0); // Start signal: low for at least 18ms
-    
-    // Enable IRQ for the long delay (18ms)
-    __set_PRIMASK(primask); 
-    HAL_Delay(18); // Use HAL_Delay for ms
-    __disable_irq();
-    
-    DHT11_Pin_Write(dev, 1); // Pull up
-    Delay_us(30);
-    
-    DHT11_Pin_Input(dev); // Prepare to read
-
-    /* Check Response: Low for ~80us then High for ~80us */
-    uint32_t timeout = 0;
-    
-    // Wait for Low (Response start)
-    while (DHT11_Pin_Read(dev) == 1) {
-        if (++timeout > 500) {
-             __set_PRIMASK(primask);
-             dev->timeout_cnt++;
-             DHT11_HandleError(dev);
-             return DHT11_ERROR_TIMEOUT;
-        }
-        Delay_us(1);
-    }
-    
-    timeout = 0;
-    // Wait for High (Response Low -> High)
-    while (DHT11_Pin_Read(dev) == 0) {
-        if (++timeout > 500) {
-             __set_PRIMASK(primask);
-             dev->timeout_cnt++;
-             DHT11_HandleError(dev);
-             return DHT11_ERROR_TIMEOUT;
+    switch (dev->state) {
+    case DHT11_STATE_START:
+        if (HAL_GetTick() - dev->state_tick < DHT11_START_MS) break;
+        /* Release the line and timestamp the sensor's falling edges */
+        dev->edge_cnt = 0;
+        dev->state_tick = HAL_GetTick();
+        dev->state = DHT11_STATE_RX;
+        DHT11_Pin_Write(dev, 1);
+        DHT11_Pin_Mode(dev, GPIO_MODE_IT_FALLING);
+        break;
+
+    case DHT11_STATE_RX:
+        if (dev->edge_cnt >= DHT11_EDGES) {
+            DHT11_Finish(dev, DHT11_Decode(dev));
+        } else if (HAL_GetTick() - dev->state_tick > DHT11_FRAME_MS) {
+            DHT11_Finish(dev, DHT11_ERROR_TIMEOUT);
         }
-        Delay_us(1);
-    }
-    
-    timeout = 0;
-    // Wait for Low (Response High -> Start of transmission)
-    while (DHT11_Pin_Read(dev) == 1) {
-        if (++timeout > 500) {
-             __set_PRIMASK(primask);
-             dev->timeout_cnt++;
-             DHT11_HandleError(dev);
-             return DHT11_ERROR_TIMEOUT;
-        }
-        Delay_us(1);
-    }
+        break;
 
-    /* Read 5 bytes */
-    for (i = 0; i < 5; i++) {
-        buf[i] = DHT11_Read_Byte(dev);
+    default:
+        return dev->last_status;
     }
+    return (dev->state == DHT11_STATE_IDLE) ? dev->last_status : DHT11_BUSY;
+}
 
-    __set_PRIMASK(primask);
-
-    DHT11_Pin_Output(dev);
-    DHT11_Pin_Write(dev, 1);
+void DHT11_EXTI_Callback(DHT11_Handle_t *dev, uint16_t GPIO_Pin) {
+    if (!dev || GPIO_Pin != dev->pin || dev->state != DHT11_STATE_RX) return;
 
-    /* Check Checksum */
-    uint8_t sum = buf[0] + buf[1] + buf[2] + buf[3];
-    if (sum != buf[4]) {
-        dev->checksum_error_cnt++;
-        DHT11_HandleError(dev);
-        return DHT11_ERROR_CHECKSUM;
+    if (dev->edge_cnt < DHT11_EDGES) {
+        dev->edges[dev->edge_cnt++] = DWT->CYCCNT;
     }
+}
 
-    dev->humidity_int = buf[0];
-    dev->humidity_dec = buf[1];
-    dev->temp_int = buf[2];
-    dev->temp_dec = buf[3];
-    
-    dev->successful_read_cnt++;
-    return DHT11_OK;
+DHT11_Status DHT11_Read(DHT11_Handle_t *dev) {
+    DHT11_Status status = DHT11_Start(dev);
+
+    if (status != DHT11_OK) return status;
+    while ((status = DHT11_Poll(dev)) == DHT11_BUSY) {
+        HAL_Delay(1);
+    }
+    return status;
 }
 
+uint32_t DHT11_GetErrorCount(DHT11_Handle_t *dev) {
+    return dev ? dev->error_cnt : 0;
+}
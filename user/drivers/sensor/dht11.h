@@ -1,6 +1,26 @@
 /**
  * @file dht11.h
  * @brief DHT11 Temperature & Humidity Sensor Driver (Enhanced)
+ *
+ * Reads run in the background: DHT11_Start() pulls the line low,
+ * DHT11_Poll() (1 ms tick or main loop) releases it after 18 ms and turns
+ * the pin into a falling-edge EXTI input. Each edge only stores a DWT
+ * timestamp; the 40 bits are decoded from the edge spacing (78 us for a 0,
+ * 120 us for a 1) in DHT11_Poll(), which then calls the done callback.
+ * Interrupts are never disabled and nothing waits on the pin.
+ *
+ * Integration:
+ *      // CubeMX: data pin with 4.7k pull-up, NVIC for its EXTI line enabled
+ *      void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+ *          DHT11_EXTI_Callback(&dht, GPIO_Pin);
+ *      }
+ *
+ *      DHT11_Init(&dht, GPIOA, GPIO_PIN_1);
+ *      DHT11_SetDoneCallback(&dht, on_dht11);   // on_dht11(dev, status)
+ *      DHT11_Start(&dht);
+ *      // ... every 1 ms: DHT11_Poll(&dht);
+ *
+ * DHT11_Read() is kept as a blocking wrapper over the same state machine.
  */
 #ifndef DHT11_H
 #define DHT11_H
@@ -21,9 +41,13 @@ typedef enum {
     DHT11_OK = 0,
     DHT11_ERROR_CHECKSUM,
     DHT11_ERROR_TIMEOUT,
-    DHT11_ERROR_GPIO
+    DHT11_ERROR_GPIO,
+    DHT11_BUSY
 } DHT11_Status;
 
+/* Falling edges in one frame: response, 40 bit starts, end of frame */
+#define DHT11_EDGES 42
+
 /* Forward struct declaration */
 struct DHT11_Handle_s;
 
@@ -32,21 +56,29 @@ typedef struct DHT11_Handle_s {
     /* Configuration */
     GPIO_TypeDef *port;
     uint16_t pin;
-    
+
     /* Data */
     uint8_t humidity_int;
     uint8_t humidity_dec;
     uint8_t temp_int;
     uint8_t temp_dec;
 
+    /* Background read */
+    volatile uint8_t state;
+    volatile uint8_t edge_cnt;
+    uint32_t edges[DHT11_EDGES];    /* DWT->CYCCNT at each falling edge */
+    uint32_t state_tick;            /* HAL_GetTick() when the state was entered */
+    DHT11_Status last_status;
+
     /* Statistics (Robustness) */
     volatile uint32_t error_cnt;
     volatile uint32_t timeout_cnt;
     volatile uint32_t checksum_error_cnt;
     volatile uint32_t successful_read_cnt;
-    
+
     /* Callback */
-    void (*error_cb)(struct DHT11_Handle_s *dev); 
+    void (*error_cb)(struct DHT11_Handle_s *dev);
+    void (*done_cb)(struct DHT11_Handle_s *dev, DHT11_Status status);
 } DHT11_Handle_t;
 
 /* Public API Functions */
@@ -61,6 +93,29 @@ typedef struct DHT11_Handle_s {
 void DHT11_Init(DHT11_Handle_t *dev, GPIO_TypeDef *port, uint16_t pin);
 
 void DHT11_SetErrorCallback(DHT11_Handle_t *dev, void (*cb)(DHT11_Handle_t *));
+void DHT11_SetDoneCallback(DHT11_Handle_t *dev, void (*cb)(DHT11_Handle_t *, DHT11_Status));
+
+/**
+ * @brief  Start a background read (18 ms start signal, then edge capture).
+ * @retval DHT11_OK, DHT11_BUSY if a read is in progress
+ */
+DHT11_Status DHT11_Start(DHT11_Handle_t *dev);
+
+/**
+ * @brief  Advance the read: release the line, decode, time out.
+ *         Call every 1 ms (timer tick) or from the main loop.
+ * @retval DHT11_BUSY while a read is in progress, else the last result
+ */
+DHT11_Status DHT11_Poll(DHT11_Handle_t *dev);
+
+/**
+ * @brief  Edge timestamp; call from HAL_GPIO_EXTI_Callback.
+ */
+void DHT11_EXTI_Callback(DHT11_Handle_t *dev, uint16_t GPIO_Pin);
+
+/**
+ * @brief  Blocking read: Start, then Poll until done (~23 ms, IRQs stay on).
+ */
 DHT11_Status DHT11_Read(DHT11_Handle_t *dev);
 uint32_t DHT11_GetErrorCount(DHT11_Handle_t *dev);
 
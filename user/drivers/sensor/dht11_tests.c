@@ -6,59 +6,77 @@
 
 static DHT11_Handle_t dht11;
 static char msg[128];
+static volatile uint32_t loop_count;
+
+// CubeMX: PA1 EXTI line enabled in NVIC, 4.7k pull-up
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+    DHT11_EXTI_Callback(&dht11, GPIO_Pin);
+}
 
 void dht11_error_callback(DHT11_Handle_t *dev) {
     snprintf(msg, sizeof(msg), "[DHT11] Error occurred (Total: %u)\r\n", dev->error_cnt);
     UART_SendString(UART_CH, msg);
 }
 
+static void dht11_done_callback(DHT11_Handle_t *dev, DHT11_Status status) {
+    switch (status) {
+        case DHT11_OK:
+            snprintf(msg, sizeof(msg),
+                "Temp: %d.%d°C | Humidity: %d.%d%% | Success: %u\r\n",
+                dev->temp_int, dev->temp_dec,
+                dev->humidity_int, dev->humidity_dec,
+                dev->successful_read_cnt);
+            UART_SendString(UART_CH, msg);
+            break;
+
+        case DHT11_ERROR_CHECKSUM:
+            snprintf(msg, sizeof(msg),
+                "Checksum Error (Total: %u)\r\n",
+                dev->checksum_error_cnt);
+            UART_SendString(UART_CH, msg);
+            break;
+
+        case DHT11_ERROR_TIMEOUT:
+            snprintf(msg, sizeof(msg),
+                "Timeout (Total: %u) - Check wiring!\r\n",
+                dev->timeout_cnt);
+            UART_SendString(UART_CH, msg);
+            break;
+
+        default:
+            UART_SendString(UART_CH, "GPIO Error - Check init!\r\n");
+            break;
+    }
+
+    // The loop kept spinning while the sensor was read
+    snprintf(msg, sizeof(msg), "Stats: Errors=%u, Success=%u, loop passes=%lu\r\n\r\n",
+             dev->error_cnt, dev->successful_read_cnt, loop_count);
+    UART_SendString(UART_CH, msg);
+}
+
 void app_main(void) {
     UART_SendString(UART_CH, "\r\n===== DHT11 Driver Test =====\r\n");
-    
-    // DWT Delay needs no explicit timer start (it auto-inits on use)
-    
+
     DHT11_Init(&dht11, GPIOA, GPIO_PIN_1);
     DHT11_SetErrorCallback(&dht11, dht11_error_callback);
-    
-    UART_SendString(UART_CH, "DHT11 initialized on PA1\r\n");
-    UART_SendString(UART_CH, "Reading every 3 seconds...\r\n");
-    
+    DHT11_SetDoneCallback(&dht11, dht11_done_callback);
+
+    UART_SendString(UART_CH, "DHT11 initialized on PA1 (EXTI)\r\n");
+    UART_SendString(UART_CH, "Reading every 3 seconds in the background...\r\n");
+
+    uint32_t last_start = HAL_GetTick() - 3000;
+
     while (1) {
-        DHT11_Status status = DHT11_Read(&dht11);
-        
-        switch (status) {
-            case DHT11_OK:
-                snprintf(msg, sizeof(msg), 
-                    "Temp: %d.%d°C | Humidity: %d.%d%% | Success: %u\r\n",
-                    dht11.temp_int, dht11.temp_dec,
-                    dht11.humidity_int, dht11.humidity_dec,
-                    dht11.successful_read_cnt);
-                UART_SendString(UART_CH, msg);
-                break;
-                
-            case DHT11_ERROR_CHECKSUM:
-                snprintf(msg, sizeof(msg), 
-                    "Checksum Error (Total: %u)\r\n",
-                    dht11.checksum_error_cnt);
-                UART_SendString(UART_CH, msg);
-                break;
-                
-            case DHT11_ERROR_TIMEOUT:
-                snprintf(msg, sizeof(msg), 
-                    "Timeout (Total: %u) - Check wiring!\r\n",
-                    dht11.timeout_cnt);
-                UART_SendString(UART_CH, msg);
-                break;
-                
-            case DHT11_ERROR_GPIO:
-                UART_SendString(UART_CH, "GPIO Error - Check init!\r\n");
-                break;
+        if (HAL_GetTick() - last_start >= 3000) {
+            last_start = HAL_GetTick();
+            loop_count = 0;
+            DHT11_Start(&dht11);
         }
-        
-        snprintf(msg, sizeof(msg), "Stats: Errors=%u, Success=%u\r\n\r\n",
-                 dht11.error_cnt, dht11.successful_read_cnt);
-        UART_SendString(UART_CH, msg);
-        
-        HAL_Delay(3000);
+
+        // Releases the line after the start signal, decodes, calls back
+        DHT11_Poll(&dht11);
+        loop_count++;
+
+        HAL_Delay(1);
     }
 }
@@ -1,20 +1,13 @@
 #include "ds18b20.h"
-#include "delay.h" 
+#include <string.h>
 
-/* 1-Wire Timing Constants */
-#define OW_RESET_PULSE      480
-#define OW_RESET_WAIT       70
-#define OW_PRESENCE_WAIT    410
-
-// Bit banging timing
-#define OW_WRITE_0_LOW      60
-#define OW_WRITE_0_HIGH     10
-#define OW_WRITE_1_LOW      6
-#define OW_WRITE_1_HIGH     64
-
-#define OW_READ_LOW         6
-#define OW_READ_SAMPLE      9
-#define OW_READ_RECOVER     55
+/* Scratchpad layout */
+#define SP_TEMP_LSB     0
+#define SP_TEMP_MSB     1
+#define SP_TH           2
+#define SP_TL           3
+#define SP_CONFIG       4
+#define SP_SIZE         9
 
 static void DS18B20_HandleError(DS18B20_Handle_t *dev) {
     if (dev) {
@@ -25,129 +18,68 @@ static void DS18B20_HandleError(DS18B20_Handle_t *dev) {
     }
 }
 
-/* GPIO Helper Functions */
-
-// Helper: Set Pin as Output
-static void Mode_Output(DS18B20_Handle_t *h) {
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin = h->pin;
-    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
-    HAL_GPIO_Init(h->port, &GPIO_InitStruct);
-}
-
-// Helper: Set Pin as Input
-static void Mode_Input(DS18B20_Handle_t *h) {
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin = h->pin;
-    GPIO_InitStruct.Mode = GPIO_MODE_INPUT; 
-    GPIO_InitStruct.Pull = GPIO_PULLUP;     
-    HAL_GPIO_Init(h->port, &GPIO_InitStruct);
-}
-
-static void Pin_Low(DS18B20_Handle_t *h) {
-    HAL_GPIO_WritePin(h->port, h->pin, GPIO_PIN_RESET);
-}
-
-static uint8_t Pin_Read(DS18B20_Handle_t *h) {
-    return (uint8_t)HAL_GPIO_ReadPin(h->port, h->pin);
-}
-
-/* 1-Wire Primitives */
-
-static bool OW_Reset(DS18B20_Handle_t *h) {
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-
-    Mode_Output(h);
-    Pin_Low(h);
-    Delay_us(OW_RESET_PULSE);
-    
-    Mode_Input(h); // Release line
-    Delay_us(OW_RESET_WAIT);
-    
-    uint8_t presence = Pin_Read(h); // Should be Low if slave present
-    Delay_us(OW_PRESENCE_WAIT);
-    
-    __set_PRIMASK(primask);
-    
-    return (presence == 0);
-}
-
-static void OW_WriteBit(DS18B20_Handle_t *h, uint8_t bit) {
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    
-    Mode_Output(h);
-    if (bit) {
-        // Write 1
-        Pin_Low(h);
-        Delay_us(OW_WRITE_1_LOW);
-        Mode_Input(h); // Release
-        Delay_us(OW_WRITE_1_HIGH);
-    } else {
-        // Write 0
-        Pin_Low(h);
-        Delay_us(OW_WRITE_0_LOW);
-        Mode_Input(h); // Release
-        Delay_us(OW_WRITE_0_HIGH);
+// Reset, address this sensor and send a function command, in one transfer when addressed by ROM
+static uint8_t DS18B20_Command(DS18B20_Handle_t *h, uint8_t cmd) {
+    uint8_t frame[10];
+    uint8_t res = OneWire_Reset(h->bus);
+
+    if (res != ONEWIRE_OK) return res;
+    if (h->use_rom) {
+        frame[0] = ONEWIRE_CMD_MATCH_ROM;
+        memcpy(&frame[1], h->rom, 8);
+        frame[9] = cmd;
+        return OneWire_WriteBytes(h->bus, frame, 10);
     }
-    
-    __set_PRIMASK(primask);
+    frame[0] = ONEWIRE_CMD_SKIP_ROM;
+    frame[1] = cmd;
+    return OneWire_WriteBytes(h->bus, frame, 2);
 }
 
-static uint8_t OW_ReadBit(DS18B20_Handle_t *h) {
-    uint8_t bit = 0;
-    
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    
-    Mode_Output(h);
-    Pin_Low(h);
-    Delay_us(OW_READ_LOW);
-    
-    Mode_Input(h);
-    Delay_us(OW_READ_SAMPLE);
-    bit = Pin_Read(h);
-    Delay_us(OW_READ_RECOVER);
-    
-    __set_PRIMASK(primask);
-    
-    return bit;
-}
-
-static void OW_WriteByte(DS18B20_Handle_t *h, uint8_t byte) {
-    for (int i=0; i<8; i++) {
-        OW_WriteBit(h, byte & 0x01);
-        byte >>= 1;
+static uint8_t DS18B20_ReadScratchpad(DS18B20_Handle_t *h, uint8_t sp[SP_SIZE]) {
+    if (DS18B20_Command(h, DS18B20_CMD_READ_SP) != ONEWIRE_OK ||
+        OneWire_ReadBytes(h->bus, sp, SP_SIZE) != ONEWIRE_OK) {
+        return ONEWIRE_ERR_BUS;
     }
-}
-
-static uint8_t OW_ReadByte(DS18B20_Handle_t *h) {
-    uint8_t byte = 0;
-    for (int i=0; i<8; i++) {
-        if (OW_ReadBit(h)) {
-            byte |= (1 << i);
-        }
+    // All zeros pass the CRC: the config byte's low 5 bits always read 1
+    if (OneWire_Crc8(sp, SP_SIZE) != 0 || (sp[SP_CONFIG] & 0x1F) != 0x1F) {
+        h->crc_error_cnt++;
+        return ONEWIRE_ERR_BUS;
     }
-    return byte;
+    return ONEWIRE_OK;
 }
 
 /* Public API */
 
-void DS18B20_Init(DS18B20_Handle_t *h, GPIO_TypeDef *port, uint16_t pin) {
+void DS18B20_Init(DS18B20_Handle_t *h, OneWire_HandleTypeDef *bus, const uint8_t rom[8]) {
     if (!h) return;
-    h->port = port;
-    h->pin = pin;
+    h->bus = bus;
+    h->use_rom = (rom != NULL);
+    if (rom) {
+        memcpy(h->rom, rom, 8);
+    } else {
+        memset(h->rom, 0, 8);
+    }
+    h->resolution = 12;     // Power-on default
     h->last_temp = 0.0f;
-    
+
     h->error_cnt = 0;
     h->success_cnt = 0;
     h->crc_error_cnt = 0;
     h->error_cb = NULL;
-    
-    // Ensure high idle
-    Mode_Input(h); 
+}
+
+uint8_t DS18B20_Search(OneWire_HandleTypeDef *bus, DS18B20_Handle_t *handles, uint8_t max) {
+    uint8_t roms[DS18B20_SEARCH_MAX][8];
+    uint8_t found = 0;
+
+    // The bus may carry other 1-Wire devices too: keep family 0x28 only
+    uint8_t n = OneWire_Search(bus, ONEWIRE_CMD_SEARCH_ROM, roms, DS18B20_SEARCH_MAX);
+    for (uint8_t i = 0; i < n && found < max; i++) {
+        if (roms[i][0] == DS18B20_FAMILY_CODE) {
+            DS18B20_Init(&handles[found++], bus, roms[i]);
+        }
+    }
+    return found;
 }
 
 void DS18B20_SetErrorCallback(DS18B20_Handle_t *h, DS18B20_ErrorCallback cb) {
@@ -156,48 +88,94 @@ void DS18B20_SetErrorCallback(DS18B20_Handle_t *h, DS18B20_ErrorCallback cb) {
     }
 }
 
+uint8_t DS18B20_StartConversionAll(OneWire_HandleTypeDef *bus) {
+    uint8_t frame[2] = {ONEWIRE_CMD_SKIP_ROM, DS18B20_CMD_CONVERT_T};
+    uint8_t res = OneWire_Reset(bus);
+
+    if (res != ONEWIRE_OK) return res;
+    return OneWire_WriteBytes(bus, frame, sizeof(frame));
+}
+
+uint8_t DS18B20_ConversionDone(OneWire_HandleTypeDef *bus) {
+    uint8_t bit = 0;
+
+    if (OneWire_ReadBit(bus, &bit) != ONEWIRE_OK) return 0;
+    return bit;
+}
+
 void DS18B20_StartConversion(DS18B20_Handle_t *h) {
     if (!h) return;
-    
-    if (!OW_Reset(h)) {
+
+    if (DS18B20_Command(h, DS18B20_CMD_CONVERT_T) != ONEWIRE_OK) {
         DS18B20_HandleError(h);
-        return;
     }
-    OW_WriteByte(h, 0xCC); // Skip ROM
-    OW_WriteByte(h, 0x44); // Convert T
 }
 
 float DS18B20_ReadTemp(DS18B20_Handle_t *h) {
-    if (!h) return -999.0f;
-    
-    if (!OW_Reset(h)) {
+    uint8_t sp[SP_SIZE];
+
+    if (!h) return DS18B20_ERROR_TEMP;
+
+    if (DS18B20_ReadScratchpad(h, sp) != ONEWIRE_OK) {
         DS18B20_HandleError(h);
-        return -999.0f;
+        return DS18B20_ERROR_TEMP;
     }
-    
-    OW_WriteByte(h, 0xCC); // Skip ROM
-    OW_WriteByte(h, 0xBE); // Read Scratchpad
-    
-    uint8_t temp_l = OW_ReadByte(h);
-    uint8_t temp_h = OW_ReadByte(h);
-    
-    // Process 16-bit generic Temp
-    int16_t temp_raw = (temp_h << 8) | temp_l;
-    
-    // Resolution default 12-bit: 0.0625 step
+
+    // Process 16-bit generic Temp; the unused low bits read 0 below 12-bit
+    int16_t temp_raw = (int16_t)((sp[SP_TEMP_MSB] << 8) | sp[SP_TEMP_LSB]);
     float temp = (float)temp_raw * 0.0625f;
+    h->resolution = (uint8_t)(9 + ((sp[SP_CONFIG] >> 5) & 0x03));
     h->last_temp = temp;
-    
+
     h->success_cnt++;
-    
+
     return temp;
 }
 
+uint8_t DS18B20_ReadAll(DS18B20_Handle_t *handles, uint8_t count) {
+    uint8_t ok = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (DS18B20_ReadTemp(&handles[i]) != DS18B20_ERROR_TEMP) ok++;
+    }
+    return ok;
+}
+
+uint8_t DS18B20_SetResolution(DS18B20_Handle_t *h, uint8_t bits) {
+    uint8_t sp[SP_SIZE];
+    uint8_t frame[3];
+    uint8_t res;
+
+    if (!h || bits < 9 || bits > 12) return ONEWIRE_ERR_BUS;
+
+    // Keep the alarm thresholds, they share the write
+    res = DS18B20_ReadScratchpad(h, sp);
+    if (res == ONEWIRE_OK) res = DS18B20_Command(h, DS18B20_CMD_WRITE_SP);
+    if (res == ONEWIRE_OK) {
+        frame[0] = sp[SP_TH];
+        frame[1] = sp[SP_TL];
+        frame[2] = (uint8_t)(((bits - 9) << 5) | 0x1F);
+        res = OneWire_WriteBytes(h->bus, frame, sizeof(frame));
+    }
+    if (res != ONEWIRE_OK) {
+        DS18B20_HandleError(h);
+        return res;
+    }
+    h->resolution = bits;
+    return ONEWIRE_OK;
+}
+
+uint32_t DS18B20_ConversionTimeMs(const DS18B20_Handle_t *h) {
+    uint8_t bits = (h && h->resolution >= 9 && h->resolution <= 12) ? h->resolution : 12;
+
+    return 750U >> (12 - bits);
+}
+
 float DS18B20_ReadTempBlocked(DS18B20_Handle_t *h) {
     DS18B20_StartConversion(h);
-    
-    // Max conv time 750ms
-    HAL_Delay(750); // Blocking ms delay
-    
+
+    // 93 ms (9-bit) to 750 ms (12-bit)
+    HAL_Delay(DS18B20_ConversionTimeMs(h));
+
     return DS18B20_ReadTemp(h);
 }
@@ -1,6 +1,23 @@
 /**
  * @file ds18b20.h
  * @brief DS18B20 OneWire Temperature Sensor Driver
+ *
+ * Runs on the UART 1-Wire engine (onewire_uart.h): slots are generated by
+ * the UART (and DMA), so reading a sensor never disables interrupts.
+ * Several sensors can share one bus; they are found with a ROM search and
+ * all start converting with one broadcast Convert T.
+ *
+ * Multi-drop usage:
+ *      static OneWire_HandleTypeDef ow;
+ *      static DS18B20_Handle_t sensors[8];
+ *      OneWire_Init(&ow, &huart3);
+ *      uint8_t n = DS18B20_Search(&ow, sensors, 8);
+ *      DS18B20_StartConversionAll(&ow);       // every sensor at once
+ *      HAL_Delay(750);                        // or poll DS18B20_ConversionDone()
+ *      DS18B20_ReadAll(sensors, n);           // sensors[i].last_temp
+ *
+ * A single sensor needs no search: DS18B20_Init(&sensor, &ow, NULL)
+ * addresses it with Skip ROM.
  */
 
 #ifndef DS18B20_H
@@ -11,8 +28,22 @@ extern "C" {
 #endif
 
 #include "main.h"
+#include "onewire_uart.h"
 #include <stdbool.h>
 
+#define DS18B20_FAMILY_CODE     0x28
+#define DS18B20_ERROR_TEMP      (-999.0f)
+
+// Devices DS18B20_Search enumerates per bus (RAM: 8 bytes each, on the stack)
+#ifndef DS18B20_SEARCH_MAX
+#define DS18B20_SEARCH_MAX      16
+#endif
+
+// Function commands
+#define DS18B20_CMD_CONVERT_T   0x44
+#define DS18B20_CMD_READ_SP     0xBE
+#define DS18B20_CMD_WRITE_SP    0x4E
+
 /**
  * @brief DS18B20 Handle
  */
@@ -21,43 +52,85 @@ typedef struct DS18B20_Handle_s DS18B20_Handle_t;
 typedef void (*DS18B20_ErrorCallback)(DS18B20_Handle_t *dev);
 
 struct DS18B20_Handle_s {
-    GPIO_TypeDef *port;
-    uint16_t pin;
-    /* TIM handle removed: uses DWT Delay_us() */
-    
+    OneWire_HandleTypeDef *bus;
+    uint8_t rom[8];
+    uint8_t use_rom;        /* 0: only device on the bus, addressed with Skip ROM */
+    uint8_t resolution;     /* 9..12 bits, sets the conversion time */
+
     float last_temp;
-    
+
     /* Stats */
     volatile uint32_t error_cnt;
     volatile uint32_t success_cnt;
     volatile uint32_t crc_error_cnt;
-    
+
     /* Callback */
     DS18B20_ErrorCallback error_cb;
 };
 
 /**
  * @brief Initialize the DS18B20 handle
+ * @param rom ROM code of the sensor, NULL if it is alone on the bus
+ */
+void DS18B20_Init(DS18B20_Handle_t *handle, OneWire_HandleTypeDef *bus, const uint8_t rom[8]);
+
+/**
+ * @brief Find the DS18B20s on a bus and initialize a handle for each
+ * @return Number of sensors found (at most max)
+ */
+uint8_t DS18B20_Search(OneWire_HandleTypeDef *bus, DS18B20_Handle_t *handles, uint8_t max);
+
+/**
+ * @brief Start a conversion on every sensor of the bus (Skip ROM + Convert T)
+ * @return ONEWIRE_OK, ONEWIRE_NO_DEVICE or ONEWIRE_ERR_BUS
  */
-void DS18B20_Init(DS18B20_Handle_t *handle, GPIO_TypeDef *port, uint16_t pin);
+uint8_t DS18B20_StartConversionAll(OneWire_HandleTypeDef *bus);
 
 /**
- * @brief Start Temperature Conversion
+ * @brief Check whether the conversion started last has finished
+ * @note  Externally powered sensors answer read slots with 0 while
+ *        converting. Call right after a Convert T, with no other command
+ *        in between.
+ * @return 1 done, 0 still converting (or bus error)
+ */
+uint8_t DS18B20_ConversionDone(OneWire_HandleTypeDef *bus);
+
+/**
+ * @brief Start Temperature Conversion on this sensor only
  */
 void DS18B20_StartConversion(DS18B20_Handle_t *handle);
 
 /**
- * @brief Read Temperature
+ * @brief Read Temperature (scratchpad, CRC checked)
+ * @return Temperature in degrees C, DS18B20_ERROR_TEMP on error
  */
 float DS18B20_ReadTemp(DS18B20_Handle_t *handle);
 
+/**
+ * @brief Read every sensor after DS18B20_StartConversionAll
+ * @return Number of sensors read successfully (results in last_temp)
+ */
+uint8_t DS18B20_ReadAll(DS18B20_Handle_t *handles, uint8_t count);
+
+/**
+ * @brief Set the resolution (9..12 bits): 93 ms per conversion at 9 bits,
+ *        doubling per bit up to 750 ms at 12
+ * @return ONEWIRE_OK, ONEWIRE_xxx on a bus error, ONEWIRE_ERR_BUS for bits out of range
+ */
+uint8_t DS18B20_SetResolution(DS18B20_Handle_t *handle, uint8_t bits);
+
+/**
+ * @brief Conversion time in ms for the handle's resolution
+ */
+uint32_t DS18B20_ConversionTimeMs(const DS18B20_Handle_t *handle);
+
 /**
  * @brief Set Error Callback
  */
 void DS18B20_SetErrorCallback(DS18B20_Handle_t *handle, DS18B20_ErrorCallback cb);
 
 /**
- * @brief Sync Wrapper: Start -> Delay(750ms) -> Read
+ * @brief Sync Wrapper: Start -> Delay(conversion time) -> Read
  */
 float DS18B20_ReadTempBlocked(DS18B20_Handle_t *handle);
 
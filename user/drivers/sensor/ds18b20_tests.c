@@ -3,77 +3,140 @@
 #include <stdio.h>
 
 #define UART_CH 0
+#define MAX_SENSORS 8
 
-static DS18B20_Handle_t sensor;
+extern UART_HandleTypeDef huart3;  // 1-Wire bus: Single Wire (Half-Duplex), TX open-drain + 4.7k pull-up
+
+static OneWire_HandleTypeDef ow;
+static DS18B20_Handle_t sensors[MAX_SENSORS];
+static uint8_t sensor_count;
 static char msg[128];
 
 void ds18b20_error_callback(DS18B20_Handle_t *dev) {
-    snprintf(msg, sizeof(msg), "[DS18B20] Error (Total: %lu)\r\n", dev->error_cnt);
+    snprintf(msg, sizeof(msg), "[DS18B20] Error (Total: %lu, CRC: %lu)\r\n",
+             dev->error_cnt, dev->crc_error_cnt);
+    UART_SendString(UART_CH, msg);
+}
+
+static void scan(void) {
+    sensor_count = DS18B20_Search(&ow, sensors, MAX_SENSORS);
+    snprintf(msg, sizeof(msg), "Found %u sensor(s)\r\n", sensor_count);
     UART_SendString(UART_CH, msg);
+
+    for (uint8_t i = 0; i < sensor_count; i++) {
+        const uint8_t *r = sensors[i].rom;
+        DS18B20_SetErrorCallback(&sensors[i], ds18b20_error_callback);
+        snprintf(msg, sizeof(msg), "  [%u] %02X-%02X%02X%02X%02X%02X%02X-%02X\r\n",
+                 i, r[0], r[6], r[5], r[4], r[3], r[2], r[1], r[7]);
+        UART_SendString(UART_CH, msg);
+    }
+}
+
+static void print_all(void) {
+    for (uint8_t i = 0; i < sensor_count; i++) {
+        if (sensors[i].last_temp != DS18B20_ERROR_TEMP) {
+            snprintf(msg, sizeof(msg), "  [%u] %.4f C\r\n", i, sensors[i].last_temp);
+        } else {
+            snprintf(msg, sizeof(msg), "  [%u] read failed\r\n", i);
+        }
+        UART_SendString(UART_CH, msg);
+    }
 }
 
 void app_main(void) {
     UART_SendString(UART_CH, "\r\n===== DS18B20 OneWire Test =====\r\n");
-    
-    // Timer no longer needed
-    
-    DS18B20_Init(&sensor, GPIOB, GPIO_PIN_1);
-    DS18B20_SetErrorCallback(&sensor, ds18b20_error_callback);
-    
-    UART_SendString(UART_CH, "DS18B20 initialized on PB1\r\n");
-    UART_SendString(UART_CH, "Commands: [b]Blocking [n]Non-blocking\r\n");
-    
+
+    if (OneWire_Init(&ow, &huart3) != ONEWIRE_OK) {
+        UART_SendString(UART_CH, "1-Wire UART init failed\r\n");
+    }
+    snprintf(msg, sizeof(msg), "1-Wire on USART3 (%s)\r\n", ow.UseDMA ? "DMA" : "polled");
+    UART_SendString(UART_CH, msg);
+
+    scan();
+    UART_SendString(UART_CH, "Commands: [a]All [b]Blocking [p]Poll done [r]Resolution [f]Find [s]Stats\r\n");
+
     uint8_t cmd;
-    
+    uint8_t bits = 12;
+
     while (1) {
         if (UART_Read(UART_CH, &cmd)) {
             switch (cmd) {
+                case 'a':
+                case 'A': {
+                    // One broadcast conversion for the whole bus
+                    uint32_t t0 = HAL_GetTick();
+                    DS18B20_StartConversionAll(&ow);
+                    HAL_Delay(sensor_count ? DS18B20_ConversionTimeMs(&sensors[0]) : 750);
+                    uint8_t ok = DS18B20_ReadAll(sensors, sensor_count);
+                    snprintf(msg, sizeof(msg), "%u/%u read in %lu ms\r\n",
+                             ok, sensor_count, HAL_GetTick() - t0);
+                    UART_SendString(UART_CH, msg);
+                    print_all();
+                    break;
+                }
+
                 case 'b':
                 case 'B': {
-                    UART_SendString(UART_CH, "Blocking read (750ms)...\r\n");
-                    float temp = DS18B20_ReadTempBlocked(&sensor);
-                    
-                    if (temp != -999.0f) {
-                        snprintf(msg, sizeof(msg), "Temperature: %.2f°C\r\n", temp);
-                    } else {
-                        snprintf(msg, sizeof(msg), "Read failed! Errors: %lu\r\n", 
-                                sensor.error_cnt);
+                    // Sequential blocking reads, for comparison
+                    uint32_t t0 = HAL_GetTick();
+                    for (uint8_t i = 0; i < sensor_count; i++) {
+                        DS18B20_ReadTempBlocked(&sensors[i]);
                     }
+                    snprintf(msg, sizeof(msg), "Sequential: %lu ms\r\n", HAL_GetTick() - t0);
                     UART_SendString(UART_CH, msg);
+                    print_all();
                     break;
                 }
-                
-                case 'n':
-                case 'N': {
-                    UART_SendString(UART_CH, "Starting conversion...\r\n");
-                    DS18B20_StartConversion(&sensor);
-                    UART_SendString(UART_CH, "Wait 750ms then read\r\n");
-                    HAL_Delay(750);
-                    
-                    float temp = DS18B20_ReadTemp(&sensor);
-                    if (temp != -999.0f) {
-                        snprintf(msg, sizeof(msg), "Temperature: %.2f°C\r\n", temp);
-                    } else {
-                        snprintf(msg, sizeof(msg), "Read failed!\r\n");
+
+                case 'p':
+                case 'P': {
+                    // Poll the busy slot instead of waiting out the worst case
+                    uint32_t t0 = HAL_GetTick();
+                    DS18B20_StartConversionAll(&ow);
+                    while (!DS18B20_ConversionDone(&ow) && HAL_GetTick() - t0 < 1000) {
+                        HAL_Delay(5);
                     }
+                    DS18B20_ReadAll(sensors, sensor_count);
+                    snprintf(msg, sizeof(msg), "Done after %lu ms\r\n", HAL_GetTick() - t0);
                     UART_SendString(UART_CH, msg);
+                    print_all();
                     break;
                 }
-                
+
+                case 'r':
+                case 'R':
+                    bits = (bits >= 12) ? 9 : (uint8_t)(bits + 1);
+                    for (uint8_t i = 0; i < sensor_count; i++) {
+                        DS18B20_SetResolution(&sensors[i], bits);
+                    }
+                    snprintf(msg, sizeof(msg), "Resolution %u bits (%lu ms)\r\n", bits,
+                             sensor_count ? DS18B20_ConversionTimeMs(&sensors[0]) : 0UL);
+                    UART_SendString(UART_CH, msg);
+                    break;
+
+                case 'f':
+                case 'F':
+                    scan();
+                    break;
+
                 case 's':
                 case 'S':
-                    snprintf(msg, sizeof(msg), 
-                        "Statistics:\r\n  Success: %lu\r\n  Errors: %lu\r\n  Last: %.2f°C\r\n",
-                        sensor.success_cnt, sensor.error_cnt, sensor.last_temp);
+                    snprintf(msg, sizeof(msg), "Bus: resets %lu, slots %lu, transfers %lu, errors %lu\r\n",
+                             ow.Resets, ow.Slots, ow.Transfers, ow.Errors);
                     UART_SendString(UART_CH, msg);
+                    for (uint8_t i = 0; i < sensor_count; i++) {
+                        snprintf(msg, sizeof(msg), "  [%u] ok %lu, errors %lu, crc %lu\r\n", i,
+                                 sensors[i].success_cnt, sensors[i].error_cnt, sensors[i].crc_error_cnt);
+                        UART_SendString(UART_CH, msg);
+                    }
                     break;
-                    
+
                 default:
-                    UART_SendString(UART_CH, "Unknown cmd. Use: b/n/s\r\n");
+                    UART_SendString(UART_CH, "Unknown cmd. Use: a/b/p/r/f/s\r\n");
                     break;
             }
         }
-        
+
         HAL_Delay(10);
     }
 }
@@ -1,9 +1,20 @@
 #include "hc_sr04.h"
 
-#include <stdbool.h>
-
 #include "delay.h"
 
+/* Background measurement states */
+#define HCSR04_STATE_IDLE       0
+#define HCSR04_STATE_TRIG       1   /* Trigger high */
+#define HCSR04_STATE_ECHO_WAIT  2   /* Burst sent, waiting for the echo to rise */
+#define HCSR04_STATE_ECHO_HIGH  3
+#define HCSR04_STATE_ECHO_DONE  4   /* Falling edge seen, result pending */
+
+#define HCSR04_TRIG_US          10
+
+static uint32_t HCSR04_CyclesPerUs(void) {
+    return HAL_RCC_GetHCLKFreq() / 1000000U;
+}
+
 static void HCSR04_HandleError(HCSR04_HandleTypeDef *dev, bool timeout) {
     if (dev) {
         dev->error_cnt++;
@@ -14,15 +25,29 @@ static void HCSR04_HandleError(HCSR04_HandleTypeDef *dev, bool timeout) {
     }
 }
 
+static void HCSR04_Finish(HCSR04_HandleTypeDef *dev, float distance) {
+    dev->Distance = distance;
+    dev->State = HCSR04_STATE_IDLE;
+    if (dev->done_cb) {
+        dev->done_cb(dev, distance);
+    }
+}
+
 void HCSR04_SetErrorCallback(HCSR04_HandleTypeDef *hsensor, HCSR04_ErrorCallback cb) {
     if (hsensor) {
         hsensor->error_cb = cb;
     }
 }
 
-void HCSR04_Init(HCSR04_HandleTypeDef *hsensor, 
+void HCSR04_SetDoneCallback(HCSR04_HandleTypeDef *hsensor, HCSR04_DoneCallback cb) {
+    if (hsensor) {
+        hsensor->done_cb = cb;
+    }
+}
+
+void HCSR04_Init(HCSR04_HandleTypeDef *hsensor,
                  GPIO_TypeDef *trig_port, uint16_t trig_pin,
-                 GPIO_TypeDef *echo_port, uint16_t echo_pin) 
+                 GPIO_TypeDef *echo_port, uint16_t echo_pin)
 {
     if (!hsensor) return;
 
@@ -31,75 +56,154 @@ void HCSR04_Init(HCSR04_HandleTypeDef *hsensor,
     hsensor->EchoPort = echo_port;
     hsensor->EchoPin = echo_pin;
     hsensor->TimeoutUs = 30000; // 30ms default
-    
+
+    hsensor->State = HCSR04_STATE_IDLE;
+    hsensor->StateCycles = 0;
+    hsensor->EchoCycles = 0;
+    hsensor->Distance = -1.0f;
+
     hsensor->error_cnt = 0;
     hsensor->success_cnt = 0;
     hsensor->timeout_cnt = 0;
     hsensor->error_cb = NULL;
-    
+    hsensor->done_cb = NULL;
+
+    Delay_Init();   // DWT cycle counter for the echo timestamps
+
     // Ensure Trigger is Low
     HAL_GPIO_WritePin(hsensor->TrigPort, hsensor->TrigPin, GPIO_PIN_RESET);
 }
 
-float HCSR04_Read(HCSR04_HandleTypeDef *hsensor) {
-    if (!hsensor) return -1.0f;
-    
-    uint32_t start_tick;
-    uint32_t echo_start = 0;
-    uint32_t echo_end = 0;
-    uint32_t pWidth = 0;
-
-    // 1. Send Trigger Pulse (10us) with strict timing
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
+uint8_t HCSR04_Start(HCSR04_HandleTypeDef *hsensor) {
+    if (!hsensor || hsensor->State != HCSR04_STATE_IDLE) return HCSR04_BUSY;
+
+    hsensor->StateCycles = DWT->CYCCNT;
+    hsensor->State = HCSR04_STATE_TRIG;
     HAL_GPIO_WritePin(hsensor->TrigPort, hsensor->TrigPin, GPIO_PIN_SET);
-    Delay_us(10);
-    HAL_GPIO_WritePin(hsensor->TrigPort, hsensor->TrigPin, GPIO_PIN_RESET);
-    __set_PRIMASK(primask);
-
-    // 2. Wait for Echo High
-    // Capture start time for timeout
-    start_tick = micros();
-    
-    while (HAL_GPIO_ReadPin(hsensor->EchoPort, hsensor->EchoPin) == GPIO_PIN_RESET) {
-        if ((micros() - start_tick) > hsensor->TimeoutUs) {
+    return HCSR04_OK;
+}
+
+uint8_t HCSR04_Poll(HCSR04_HandleTypeDef *hsensor) {
+    if (!hsensor) return HCSR04_OK;
+
+    uint32_t cpu = HCSR04_CyclesPerUs();
+    uint32_t elapsed_us = (DWT->CYCCNT - hsensor->StateCycles) / cpu;
+
+    switch (hsensor->State) {
+    case HCSR04_STATE_TRIG:
+        // Trigger pulse is at least 10us; the burst starts on its falling edge
+        if (elapsed_us < HCSR04_TRIG_US) break;
+        hsensor->StateCycles = DWT->CYCCNT;
+        hsensor->State = HCSR04_STATE_ECHO_WAIT;
+        HAL_GPIO_WritePin(hsensor->TrigPort, hsensor->TrigPin, GPIO_PIN_RESET);
+        break;
+
+    case HCSR04_STATE_ECHO_WAIT:
+    case HCSR04_STATE_ECHO_HIGH:
+        // Timeout waiting for Echo start / end (no object: ~38 ms pulse)
+        if (elapsed_us > hsensor->TimeoutUs) {
+            HCSR04_HandleError(hsensor, true);
+            HCSR04_Finish(hsensor, -1.0f);
+        }
+        break;
+
+    case HCSR04_STATE_ECHO_DONE: {
+        uint32_t pWidth = hsensor->EchoCycles / cpu;
+
+        // Distance = (Time * SpeedOfSound) / 2
+        // SpeedOfSound = 340m/s = 0.034 cm/us
+        // Distance(cm) = pWidth(us) * 0.017
+        float distance = (float)pWidth * 0.017f;
+
+        if (pWidth > hsensor->TimeoutUs) {
             HCSR04_HandleError(hsensor, true);
-            return -1.0f; // Timeout waiting for Echo start
+            HCSR04_Finish(hsensor, -1.0f);
+        } else if (distance > 400.0f || distance < 2.0f) {
+            // Simple filter: invalid ranges
+            HCSR04_HandleError(hsensor, false);
+            HCSR04_Finish(hsensor, -1.0f);
+        } else {
+            hsensor->success_cnt++;
+            HCSR04_Finish(hsensor, distance);
         }
+        break;
     }
-    
-    echo_start = micros();
-
-    // 3. Wait for Echo Low
-    while (HAL_GPIO_ReadPin(hsensor->EchoPort, hsensor->EchoPin) == GPIO_PIN_SET) {
-        if ((micros() - echo_start) > hsensor->TimeoutUs) {
-             HCSR04_HandleError(hsensor, true);
-            return -1.0f; // Timeout waiting for Echo end
+
+    default:
+        break;
+    }
+    return (hsensor->State == HCSR04_STATE_IDLE) ? HCSR04_OK : HCSR04_BUSY;
+}
+
+void HCSR04_EXTI_Callback(HCSR04_HandleTypeDef *hsensor, uint16_t GPIO_Pin) {
+    if (!hsensor || GPIO_Pin != hsensor->EchoPin) return;
+
+    uint32_t now = DWT->CYCCNT;
+
+    if (HAL_GPIO_ReadPin(hsensor->EchoPort, hsensor->EchoPin) == GPIO_PIN_SET) {
+        if (hsensor->State == HCSR04_STATE_ECHO_WAIT) {
+            hsensor->StateCycles = now;
+            hsensor->State = HCSR04_STATE_ECHO_HIGH;
         }
+    } else if (hsensor->State == HCSR04_STATE_ECHO_HIGH) {
+        hsensor->EchoCycles = now - hsensor->StateCycles;
+        hsensor->State = HCSR04_STATE_ECHO_DONE;
+    }
+}
+
+float HCSR04_Read(HCSR04_HandleTypeDef *hsensor) {
+    if (!hsensor || HCSR04_Start(hsensor) != HCSR04_OK) return -1.0f;
+
+    while (HCSR04_Poll(hsensor) == HCSR04_BUSY) {
+        HAL_Delay(1);
     }
-    
-    echo_end = micros();
+    return hsensor->Distance;
+}
+
+/* ============================================================================
+ * Staggered group
+ * ========================================================================= */
+
+void HCSR04_Group_Init(HCSR04_Group_t *group, HCSR04_HandleTypeDef *units, uint8_t count, uint32_t slot_ms) {
+    if (!group) return;
+
+    group->units = units;
+    group->count = count;
+    group->next = 0;
+    group->slot_ms = slot_ms;
+    group->last_fire = 0;
+    group->started = false;
+    group->skipped = 0;
+}
+
+void HCSR04_Group_Poll(HCSR04_Group_t *group) {
+    if (!group || group->count == 0) return;
 
-    // 4. Calculate Distance
-    if (echo_end >= echo_start) {
-        pWidth = echo_end - echo_start;
+    for (uint8_t i = 0; i < group->count; i++) {
+        HCSR04_Poll(&group->units[i]);
+    }
+
+    uint32_t now = HAL_GetTick();
+    if (group->started && now - group->last_fire < group->slot_ms) return;
+
+    // Advance by whole slots so a late poll does not shift the schedule,
+    // unless it is so late that catching up would fire back to back
+    if (group->started && now - group->last_fire < 2 * group->slot_ms) {
+        group->last_fire += group->slot_ms;
     } else {
-        // Handle micros() wrap-around (very rare but possible, 32-bit wrap is ~70mins)
-        pWidth = (0xFFFFFFFF - echo_start) + echo_end + 1;
+        group->last_fire = now;
     }
-    
-    // Distance = (Time * SpeedOfSound) / 2
-    // SpeedOfSound = 340m/s = 0.034 cm/us
-    // Distance(cm) = pWidth(us) * 0.017
-    
-    float distance = (float)pWidth * 0.017f;
-    
-    // Simple filter: invalid ranges
-    if (distance > 400.0f || distance < 2.0f) {
-        HCSR04_HandleError(hsensor, false);
-        return -1.0f;
+    group->started = true;
+    if (HCSR04_Start(&group->units[group->next]) != HCSR04_OK) {
+        group->skipped++;
     }
+    group->next = (uint8_t)((group->next + 1) % group->count);
+}
+
+void HCSR04_Group_EXTI_Callback(HCSR04_Group_t *group, uint16_t GPIO_Pin) {
+    if (!group) return;
 
-    hsensor->success_cnt++;
-    return distance;
+    for (uint8_t i = 0; i < group->count; i++) {
+        HCSR04_EXTI_Callback(&group->units[i], GPIO_Pin);
+    }
 }
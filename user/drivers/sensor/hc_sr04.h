@@ -1,16 +1,43 @@
 /**
  * @file hc_sr04.h
  * @brief HC-SR04 Ultrasonic Sensor Driver Header File
+ *
+ * Measurements run in the background: HCSR04_Start() raises the trigger,
+ * HCSR04_Poll() drops it after 10 us and watches for timeouts, and the echo
+ * pulse is timed by EXTI on both edges with DWT timestamps. The result is
+ * delivered through the done callback from HCSR04_Poll(), so no caller
+ * waits through the (up to 30 ms) echo.
+ *
+ * Integration:
+ *      // CubeMX: Trig output push-pull; Echo EXTI rising/falling, NVIC enabled
+ *      void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+ *          HCSR04_EXTI_Callback(&sonar, GPIO_Pin);
+ *      }
+ *
+ *      HCSR04_Init(&sonar, GPIOA, GPIO_PIN_0, GPIOA, GPIO_PIN_1);
+ *      HCSR04_SetDoneCallback(&sonar, on_distance);   // on_distance(dev, cm)
+ *      HCSR04_Start(&sonar);
+ *      // ... every 1 ms: HCSR04_Poll(&sonar);
+ *
+ * Several sensors: put the handles in an array and let a group fire them
+ * one after another, slot_ms apart (HCSR04_Group_xxx). Each echo pin needs
+ * its own EXTI line, i.e. a different pin number.
  */
 
 #ifndef __HC_SR04_H
 #define __HC_SR04_H
 
 #include "main.h"
+#include <stdbool.h>
+
+/* Return codes of Start / Poll */
+#define HCSR04_OK       0
+#define HCSR04_BUSY     1
 
 /* Forward Declaration */
 typedef struct HCSR04_Handle_s HCSR04_HandleTypeDef;
 typedef void (*HCSR04_ErrorCallback)(HCSR04_HandleTypeDef *dev);
+typedef void (*HCSR04_DoneCallback)(HCSR04_HandleTypeDef *dev, float distance_cm);
 
 struct HCSR04_Handle_s {
     GPIO_TypeDef      *TrigPort;
@@ -18,17 +45,38 @@ struct HCSR04_Handle_s {
     GPIO_TypeDef      *EchoPort;
     uint16_t           EchoPin;
     uint32_t           TimeoutUs;
-    
+
+    /* Background measurement */
+    volatile uint8_t   State;
+    uint32_t           StateCycles;    /* DWT->CYCCNT when the state was entered */
+    volatile uint32_t  EchoCycles;     /* Echo pulse width, set by the falling edge */
+    float              Distance;       /* Last result in cm, -1.0f on error */
+
     /* Stats */
     volatile uint32_t error_cnt;
     volatile uint32_t success_cnt;
     volatile uint32_t timeout_cnt;
-    
+
     /* Callback */
     HCSR04_ErrorCallback error_cb;
+    HCSR04_DoneCallback  done_cb;
 };
 
+/**
+ * @brief Staggered trigger schedule for several sensors
+ */
+typedef struct {
+    HCSR04_HandleTypeDef *units;
+    uint8_t               count;
+    uint8_t               next;        /* Unit fired at the next slot */
+    uint32_t              slot_ms;     /* Time between two triggers */
+    uint32_t              last_fire;
+    bool                  started;
+    uint32_t              skipped;     /* Slots whose unit was still measuring */
+} HCSR04_Group_t;
+
 void HCSR04_SetErrorCallback(HCSR04_HandleTypeDef *hsensor, HCSR04_ErrorCallback cb);
+void HCSR04_SetDoneCallback(HCSR04_HandleTypeDef *hsensor, HCSR04_DoneCallback cb);
 
 /* Function Prototypes */
 
@@ -40,14 +88,42 @@ void HCSR04_SetErrorCallback(HCSR04_HandleTypeDef *hsensor, HCSR04_ErrorCallback
  * @param echo_port Echo GPIO Port
  * @param echo_pin Echo GPIO Pin
  */
-void HCSR04_Init(HCSR04_HandleTypeDef *hsensor, 
+void HCSR04_Init(HCSR04_HandleTypeDef *hsensor,
                  GPIO_TypeDef *trig_port, uint16_t trig_pin,
                  GPIO_TypeDef *echo_port, uint16_t echo_pin);
 
 /**
- * @brief Read distance in centimeters
+ * @brief Start a background measurement (raises the trigger)
+ * @return HCSR04_OK, HCSR04_BUSY if one is in progress
+ */
+uint8_t HCSR04_Start(HCSR04_HandleTypeDef *hsensor);
+
+/**
+ * @brief Advance the measurement: end the trigger pulse, time out, deliver
+ *        the result. Call every 1 ms (timer tick) or from the main loop.
+ * @return HCSR04_BUSY while measuring, HCSR04_OK when idle
+ */
+uint8_t HCSR04_Poll(HCSR04_HandleTypeDef *hsensor);
+
+/**
+ * @brief Echo edge timestamp; call from HAL_GPIO_EXTI_Callback
+ */
+void HCSR04_EXTI_Callback(HCSR04_HandleTypeDef *hsensor, uint16_t GPIO_Pin);
+
+/**
+ * @brief Read distance in centimeters (Start, then Poll until done)
  * @return Distance in cm, or -1.0f on Error/Timeout
  */
 float HCSR04_Read(HCSR04_HandleTypeDef *hsensor);
 
+/**
+ * @brief Fire count sensors round-robin, one every slot_ms
+ * @note  slot_ms >= 30 keeps the echo windows apart; shorter slots overlap
+ *        measurements of different sensors (fine if they cannot hear
+ *        each other)
+ */
+void HCSR04_Group_Init(HCSR04_Group_t *group, HCSR04_HandleTypeDef *units, uint8_t count, uint32_t slot_ms);
+void HCSR04_Group_Poll(HCSR04_Group_t *group);
+void HCSR04_Group_EXTI_Callback(HCSR04_Group_t *group, uint16_t GPIO_Pin);
+
 #endif // __HC_SR04_H
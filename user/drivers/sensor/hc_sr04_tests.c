@@ -3,63 +3,79 @@
 #include <stdio.h>
 
 #define UART_CH 0
+#define N_UNITS 2
 
-static HCSR04_HandleTypeDef ultrasonic;
+// Unit 0: Trig=PA0, Echo=PA1; Unit 1: Trig=PA2, Echo=PA3
+// CubeMX: echo pins EXTI rising/falling with NVIC enabled
+static HCSR04_HandleTypeDef ultrasonic[N_UNITS];
+static HCSR04_Group_t group;
 static char msg[128];
 static uint32_t measurement_count = 0;
 
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+    HCSR04_Group_EXTI_Callback(&group, GPIO_Pin);
+}
+
 void hc_sr04_error_callback(HCSR04_HandleTypeDef *dev) {
-    snprintf(msg, sizeof(msg), "[HC-SR04] Error! Timeouts: %lu\r\n", dev->timeout_cnt);
+    snprintf(msg, sizeof(msg), "[HC-SR04 %d] Error! Timeouts: %lu\r\n",
+             (int)(dev - ultrasonic), dev->timeout_cnt);
     UART_SendString(UART_CH, msg);
 }
 
+void hc_sr04_done_callback(HCSR04_HandleTypeDef *dev, float distance) {
+    measurement_count++;
+
+    // Print every 10th result per unit to keep the console readable
+    if (dev->success_cnt % 10 == 0 && distance > 0) {
+        snprintf(msg, sizeof(msg), "[%lu] Unit %d: %.1f cm\r\n",
+                measurement_count, (int)(dev - ultrasonic), distance);
+        UART_SendString(UART_CH, msg);
+    }
+}
+
 void app_main(void) {
     UART_SendString(UART_CH, "\r\n===== HC-SR04 Ultrasonic Test =====\r\n");
-    
-    // Timer no longer required, uses DWT
-    
-    HCSR04_Init(&ultrasonic,
-                GPIOA, GPIO_PIN_0,  // Trig
-                GPIOA, GPIO_PIN_1); // Echo
-    
-    HCSR04_SetErrorCallback(&ultrasonic, hc_sr04_error_callback);
-    
-    UART_SendString(UART_CH, "HC-SR04: Trig=PA0, Echo=PA1\r\n");
-    UART_SendString(UART_CH, "Measuring every 100ms...\r\n");
-    UART_SendString(UART_CH, "Send 's' for statistics\r\n\r\n");
-    
+
+    HCSR04_Init(&ultrasonic[0], GPIOA, GPIO_PIN_0, GPIOA, GPIO_PIN_1);
+    HCSR04_Init(&ultrasonic[1], GPIOA, GPIO_PIN_2, GPIOA, GPIO_PIN_3);
+    for (int i = 0; i < N_UNITS; i++) {
+        HCSR04_SetErrorCallback(&ultrasonic[i], hc_sr04_error_callback);
+        HCSR04_SetDoneCallback(&ultrasonic[i], hc_sr04_done_callback);
+    }
+
+    // One trigger every 50 ms, alternating units
+    HCSR04_Group_Init(&group, ultrasonic, N_UNITS, 50);
+
+    UART_SendString(UART_CH, "HC-SR04 x2 staggered, 50 ms slots\r\n");
+    UART_SendString(UART_CH, "Send 's' for statistics, 'b' for a blocking read\r\n\r\n");
+
     uint8_t cmd;
-    
+
     while (1) {
-        float distance = HCSR04_Read(&ultrasonic);
-        measurement_count++;
-        
-        if (distance > 0) {
-            snprintf(msg, sizeof(msg), "[%lu] Distance: %.1f cm\r\n", 
-                    measurement_count, distance);
-            UART_SendString(UART_CH, msg);
-        } else {
-            snprintf(msg, sizeof(msg), "[%lu] Out of range / Error\r\n", 
-                    measurement_count);
-            UART_SendString(UART_CH, msg);
-        }
-        
-        if (UART_Read(UART_CH, &cmd) && (cmd == 's' || cmd == 'S')) {
-            snprintf(msg, sizeof(msg), 
-                "\r\nStatistics:\r\n"
-                "  Total Measurements: %lu\r\n"
-                "  Success: %lu\r\n"
-                "  Errors: %lu\r\n"
-                "  Timeouts: %lu\r\n"
-                "  Success Rate: %.1f%%\r\n\r\n",
-                measurement_count,
-                ultrasonic.success_cnt,
-                ultrasonic.error_cnt,
-                ultrasonic.timeout_cnt,
-                (float)ultrasonic.success_cnt * 100.0f / measurement_count);
-            UART_SendString(UART_CH, msg);
+        HCSR04_Group_Poll(&group);
+
+        if (UART_Read(UART_CH, &cmd)) {
+            if (cmd == 's' || cmd == 'S') {
+                for (int i = 0; i < N_UNITS; i++) {
+                    snprintf(msg, sizeof(msg),
+                        "Unit %d: Success %lu, Errors %lu, Timeouts %lu, Last %.1f cm\r\n",
+                        i, ultrasonic[i].success_cnt, ultrasonic[i].error_cnt,
+                        ultrasonic[i].timeout_cnt, ultrasonic[i].Distance);
+                    UART_SendString(UART_CH, msg);
+                }
+                snprintf(msg, sizeof(msg), "Total: %lu, skipped slots: %lu\r\n\r\n",
+                         measurement_count, group.skipped);
+                UART_SendString(UART_CH, msg);
+            } else if (cmd == 'b' || cmd == 'B') {
+                // Wait out the unit's scheduled measurement first
+                while (HCSR04_Poll(&ultrasonic[0]) == HCSR04_BUSY) {
+                    HAL_Delay(1);
+                }
+                snprintf(msg, sizeof(msg), "Blocking: %.1f cm\r\n", HCSR04_Read(&ultrasonic[0]));
+                UART_SendString(UART_CH, msg);
+            }
         }
-        
-        HAL_Delay(100);
+
+        HAL_Delay(1);
     }
 }
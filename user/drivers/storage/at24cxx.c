@@ -6,8 +6,50 @@
  */
 
 #include "at24cxx.h"
+#include "i2c_dma.h"
 #include <string.h>
 
+#define AT24CXX_LINE_DIRTY(l, i)  ((l)->Dirty[(i) >> 3] & (1U << ((i) & 7U)))
+
+static void AT24CXX_StartWrite(AT24CXX_HandleTypeDef *hat24);
+static void AT24CXX_Drain(AT24CXX_HandleTypeDef *hat24);
+
+/**
+ * @brief Device address, memory address and its width for a chip address
+ */
+static void AT24CXX_Address(AT24CXX_HandleTypeDef *hat24, uint32_t addr,
+                            uint16_t *devAddr, uint16_t *memAddr, uint16_t *memSize) {
+    if (hat24->AddressByteWidth == 1) {
+        // For C01-C16, use Block Select bits in DevAddress
+        // Block is calculated from upper bits of address
+        // C04: A8 (1 bit), C08: A9-A8 (2 bits), C16: A10-A8 (3 bits)
+        // Effectively: (addr / 256) << 1
+        *devAddr = hat24->I2C_Address | (uint8_t)((addr / 256) << 1);
+        *memAddr = (uint8_t)(addr % 256);
+        *memSize = I2C_MEMADD_SIZE_8BIT;
+    } else {
+        // For C32+, standard 16-bit address
+        *devAddr = hat24->I2C_Address;
+        *memAddr = (uint16_t)addr;
+        *memSize = I2C_MEMADD_SIZE_16BIT;
+    }
+}
+
+/**
+ * @brief Wait for the internal write cycle by polling for the address ACK
+ * @return 0 when the chip answers, 1 after AT24CXX_WRITE_TIMEOUT_MS
+ */
+static uint8_t AT24CXX_WaitReady(AT24CXX_HandleTypeDef *hat24, uint16_t devAddr) {
+    uint32_t start = HAL_GetTick();
+
+    // One trial per call: HAL trials follow each other with no delay and
+    // ten of them are over long before the 5 ms cycle at 400 kHz
+    while (HAL_I2C_IsDeviceReady(hat24->hi2c, devAddr, 1, 1) != HAL_OK) {
+        if (HAL_GetTick() - start > AT24CXX_WRITE_TIMEOUT_MS) return 1;
+    }
+    return 0;
+}
+
 /**
  * @brief Initialize the AT24Cxx EEPROM driver
  */
@@ -15,6 +57,15 @@ uint8_t AT24CXX_Init(AT24CXX_HandleTypeDef *hat24, I2C_HandleTypeDef *hi2c, uint
     hat24->hi2c = hi2c;
     hat24->I2C_Address = address;
     hat24->Capacity = type + 1;
+    hat24->OpState = AT24CXX_OP_IDLE;
+    hat24->Hold = 0;
+    hat24->InPoll = 0;
+    hat24->FlushAll = 0;
+    hat24->Active = -1;
+    hat24->Seq = 0;
+    hat24->Errors = 0;
+    memset(hat24->Lines, 0, sizeof(hat24->Lines));
+    memset(&hat24->Stats, 0, sizeof(hat24->Stats));
     
     // Setup Page Size and Address Width defaults
     if (type <= AT24C02) {
@@ -31,6 +82,7 @@ uint8_t AT24CXX_Init(AT24CXX_HandleTypeDef *hat24, I2C_HandleTypeDef *hi2c, uint
         
         hat24->AddressByteWidth = 2;
     }
+    hat24->Unit = (hat24->PageSize < AT24CXX_BUF_LINE_SIZE) ? hat24->PageSize : AT24CXX_BUF_LINE_SIZE;
     
     return AT24CXX_Check(hat24);
 }
@@ -45,13 +97,19 @@ uint8_t AT24CXX_Check(AT24CXX_HandleTypeDef *hat24) {
 /**
  * @brief Write data to EEPROM with page management
  */
-void AT24CXX_Write(AT24CXX_HandleTypeDef *hat24, uint32_t WriteAddr, uint8_t *pBuffer, uint16_t NumByteToWrite) {
+uint8_t AT24CXX_Write(AT24CXX_HandleTypeDef *hat24, uint32_t WriteAddr, uint8_t *pBuffer, uint16_t NumByteToWrite) {
     uint16_t pageremain;
-    uint8_t devAddr;
-    uint16_t memAddr;
+    uint16_t devAddr, memAddr, memSize;
     uint32_t currentWriteAddr = WriteAddr;
     uint8_t *currentBuf = pBuffer;
     uint16_t currentLen = NumByteToWrite;
+    uint8_t hold = hat24->Hold;
+    uint8_t status = AT24CXX_OK;
+
+    // Keep the timer's AT24CXX_Poll from starting lines before queued data
+    // is written here, so the bus is ours until the end
+    hat24->Hold = 1;
+    AT24CXX_Drain(hat24);
 
     while (currentLen > 0) {
         pageremain = hat24->PageSize - (currentWriteAddr % hat24->PageSize);
@@ -59,37 +117,108 @@ void AT24CXX_Write(AT24CXX_HandleTypeDef *hat24, uint32_t WriteAddr, uint8_t *pB
             pageremain = currentLen;
         }
 
-        // Calculate Device Address and Memory Address based on chip type
-        if (hat24->AddressByteWidth == 1) {
-            // For C01-C16, use Block Select bits in DevAddress
-            // Block is calculated from upper bits of address
-            // C04: A8 (1 bit), C08: A9-A8 (2 bits), C16: A10-A8 (3 bits)
-            // Effectively: (currentWriteAddr / 256) << 1
-            devAddr = hat24->I2C_Address | (uint8_t)((currentWriteAddr / 256) << 1);
-            memAddr = (uint8_t)(currentWriteAddr % 256);
-            
-            HAL_I2C_Mem_Write(hat24->hi2c, devAddr, memAddr, I2C_MEMADD_SIZE_8BIT, currentBuf, pageremain, 1000);
-        } else {
-            // For C32+, standard 16-bit address
-            devAddr = hat24->I2C_Address;
-            memAddr = (uint16_t)currentWriteAddr;
-            
-            HAL_I2C_Mem_Write(hat24->hi2c, devAddr, memAddr, I2C_MEMADD_SIZE_16BIT, currentBuf, pageremain, 1000);
+        AT24CXX_Address(hat24, currentWriteAddr, &devAddr, &memAddr, &memSize);
+        if (HAL_I2C_Mem_Write(hat24->hi2c, devAddr, memAddr, memSize, currentBuf, pageremain, 1000) != HAL_OK) {
+            status = AT24CXX_ERROR;
+            break;
         }
         
-        // Wait for internal write cycle to finish
-        HAL_I2C_IsDeviceReady(hat24->hi2c, devAddr, 10, 1000); // 5ms typical, polling covers it
+        // Wait for internal write cycle to finish (5ms max)
+        if (AT24CXX_WaitReady(hat24, devAddr) != 0) {
+            status = AT24CXX_ERROR;
+            break;
+        }
 
         currentWriteAddr += pageremain;
         currentBuf += pageremain;
         currentLen -= pageremain;
     }
+
+    hat24->Hold = hold;
+    return status;
+}
+
+/**
+ * @brief Newest line for a write unit that can still take updates
+ */
+static AT24CXX_Line *AT24CXX_FindLine(AT24CXX_HandleTypeDef *hat24, uint32_t base) {
+    AT24CXX_Line *found = NULL;
+
+    for (int i = 0; i < AT24CXX_BUF_LINES; i++) {
+        AT24CXX_Line *line = &hat24->Lines[i];
+        if (line->Seq != 0 && !line->Flushing && line->Addr == base &&
+            (found == NULL || line->Seq > found->Seq)) {
+            found = line;
+        }
+    }
+    return found;
+}
+
+static AT24CXX_Line *AT24CXX_AllocLine(AT24CXX_HandleTypeDef *hat24, uint32_t base) {
+    for (int i = 0; i < AT24CXX_BUF_LINES; i++) {
+        AT24CXX_Line *line = &hat24->Lines[i];
+        if (line->Seq == 0) {
+            if (++hat24->Seq == 0) hat24->Seq = 1;
+            line->Seq = hat24->Seq;
+            line->Addr = base;
+            line->Flushing = 0;
+            line->Retries = 0;
+            memset(line->Dirty, 0, sizeof(line->Dirty));
+            return line;
+        }
+    }
+    return NULL;
+}
+
+static uint8_t AT24CXX_FreeLines(AT24CXX_HandleTypeDef *hat24) {
+    uint8_t n = 0;
+
+    for (int i = 0; i < AT24CXX_BUF_LINES; i++) {
+        if (hat24->Lines[i].Seq == 0) n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Copy buffered bytes over data read from the chip, oldest line first
+ */
+static void AT24CXX_Overlay(AT24CXX_HandleTypeDef *hat24, uint32_t addr, uint8_t *pBuffer, uint16_t len) {
+    uint32_t primask = __get_PRIMASK();
+    uint32_t last = 0;
+
+    __disable_irq();
+    for (;;) {
+        AT24CXX_Line *next = NULL;
+
+        for (int i = 0; i < AT24CXX_BUF_LINES; i++) {
+            AT24CXX_Line *line = &hat24->Lines[i];
+            if (line->Seq > last && (next == NULL || line->Seq < next->Seq)) next = line;
+        }
+        if (next == NULL) break;
+        last = next->Seq;
+
+        for (uint16_t i = 0; i < hat24->Unit; i++) {
+            uint32_t a = next->Addr + i;
+            if (a >= addr && a < addr + len && AT24CXX_LINE_DIRTY(next, i)) {
+                pBuffer[a - addr] = next->Data[i];
+            }
+        }
+    }
+    __set_PRIMASK(primask);
 }
 
 /**
  * @brief Read data from EEPROM
  */
 void AT24CXX_Read(AT24CXX_HandleTypeDef *hat24, uint32_t ReadAddr, uint8_t *pBuffer, uint16_t NumByteToRead) {
+    uint8_t hold = hat24->Hold;
+
+    // The chip does not answer during a write cycle: let the current page finish
+    hat24->Hold = 1;
+    while (hat24->OpState != AT24CXX_OP_IDLE) {
+        AT24CXX_Poll(hat24);
+    }
+
     // For small chips (C01-C16), we might need to handle block boundaries depending on behavior.
     // However, sequential read usually wraps within the block or device.
     // To be safe and consistent with Write logic: split if crossing 256-byte blocks for small chips.
@@ -123,6 +252,9 @@ void AT24CXX_Read(AT24CXX_HandleTypeDef *hat24, uint32_t ReadAddr, uint8_t *pBuf
             currentLen -= blockremain;
         }
     }
+
+    AT24CXX_Overlay(hat24, ReadAddr, pBuffer, NumByteToRead);
+    hat24->Hold = hold;
 }
 
 /**
@@ -144,3 +276,247 @@ void AT24CXX_Erase_Chip(AT24CXX_HandleTypeDef *hat24) {
         AT24CXX_Write(hat24, addr, data, (uint16_t)chunk);
     }
 }
+
+/**
+ * @brief Queue data for the background writer
+ */
+uint8_t AT24CXX_WriteAsync(AT24CXX_HandleTypeDef *hat24, uint32_t WriteAddr, const uint8_t *pBuffer, uint16_t NumByteToWrite) {
+    uint32_t end = WriteAddr + NumByteToWrite;
+    uint32_t addr, primask;
+    uint32_t tick = HAL_GetTick();
+    uint8_t need = 0;
+
+    if (pBuffer == NULL || end > hat24->Capacity) return AT24CXX_ERROR;
+    if (NumByteToWrite == 0) return AT24CXX_OK;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    // Lines the request needs that are not buffered yet: take it whole or not at all
+    for (addr = WriteAddr - WriteAddr % hat24->Unit; addr < end; addr += hat24->Unit) {
+        if (AT24CXX_FindLine(hat24, addr) == NULL) need++;
+    }
+    if (need > AT24CXX_BUF_LINES) {
+        __set_PRIMASK(primask);
+        return AT24CXX_ERROR;
+    }
+    if (need > AT24CXX_FreeLines(hat24)) {
+        // Stop waiting for more updates and drain
+        hat24->FlushAll = 1;
+        hat24->Stats.Full++;
+        __set_PRIMASK(primask);
+        return AT24CXX_BUSY;
+    }
+
+    addr = WriteAddr;
+    while (addr < end) {
+        uint32_t base = addr - addr % hat24->Unit;
+        uint16_t off = (uint16_t)(addr - base);
+        uint16_t n = (uint16_t)(((base + hat24->Unit < end) ? base + hat24->Unit : end) - addr);
+        AT24CXX_Line *line = AT24CXX_FindLine(hat24, base);
+
+        if (line != NULL) {
+            hat24->Stats.Merged += n;
+        } else {
+            line = AT24CXX_AllocLine(hat24, base);
+        }
+        memcpy(&line->Data[off], pBuffer, n);
+        for (uint16_t i = off; i < off + n; i++) {
+            line->Dirty[i >> 3] |= (uint8_t)(1U << (i & 7U));
+        }
+        line->Touched = tick;
+
+        pBuffer += n;
+        addr += n;
+    }
+    hat24->Stats.Queued += NumByteToWrite;
+
+    __set_PRIMASK(primask);
+    return AT24CXX_OK;
+}
+
+/**
+ * @brief Finish the active line: free it, or put it back for another try
+ */
+static void AT24CXX_LineDone(AT24CXX_HandleTypeDef *hat24, bool ok) {
+    AT24CXX_Line *line = &hat24->Lines[hat24->Active];
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (ok || ++line->Retries >= AT24CXX_WRITE_RETRIES) {
+        if (!ok) hat24->Errors++;
+        line->Seq = 0;
+    }
+    line->Flushing = 0;
+    hat24->Active = -1;
+    hat24->OpState = AT24CXX_OP_IDLE;
+    __set_PRIMASK(primask);
+}
+
+static void AT24CXX_TxDone(void *ctx, bool ok) {
+    AT24CXX_HandleTypeDef *hat24 = (AT24CXX_HandleTypeDef *)ctx;
+
+    if (!ok) {
+        AT24CXX_LineDone(hat24, false);
+        return;
+    }
+    hat24->Stats.PageWrites++;
+    hat24->OpTick = HAL_GetTick();
+    hat24->ProbeTick = hat24->OpTick;
+    hat24->OpState = AT24CXX_OP_CYCLE;
+}
+
+static void AT24CXX_FillDone(void *ctx, bool ok) {
+    AT24CXX_HandleTypeDef *hat24 = (AT24CXX_HandleTypeDef *)ctx;
+    AT24CXX_Line *line = &hat24->Lines[hat24->Active];
+
+    if (!ok) {
+        AT24CXX_LineDone(hat24, false);
+        return;
+    }
+    hat24->Stats.FillReads++;
+    for (uint16_t i = 0; i < hat24->SpanLen; i++) {
+        uint16_t off = hat24->SpanOff + i;
+        if (!AT24CXX_LINE_DIRTY(line, off)) line->Data[off] = hat24->Fill[i];
+    }
+    AT24CXX_StartWrite(hat24);
+}
+
+static void AT24CXX_StartWrite(AT24CXX_HandleTypeDef *hat24) {
+    AT24CXX_Line *line = &hat24->Lines[hat24->Active];
+    uint16_t devAddr, memAddr, memSize;
+
+    AT24CXX_Address(hat24, line->Addr + hat24->SpanOff, &devAddr, &memAddr, &memSize);
+    hat24->OpState = AT24CXX_OP_WRITE;
+    if (I2C_DMA_MemWrite(hat24->hi2c, devAddr, memAddr, memSize, &line->Data[hat24->SpanOff],
+                         hat24->SpanLen, AT24CXX_TxDone, hat24) != HAL_OK) {
+        AT24CXX_LineDone(hat24, false);
+    }
+}
+
+/**
+ * @brief Pick the oldest line that is ready and start writing it
+ */
+static void AT24CXX_StartLine(AT24CXX_HandleTypeDef *hat24) {
+    AT24CXX_Line *pick = NULL;
+    uint32_t tick = HAL_GetTick();
+    uint32_t primask = __get_PRIMASK();
+    uint16_t first = 0, last = 0, gaps = 0;
+    uint8_t starved;
+
+    __disable_irq();
+    starved = hat24->FlushAll || AT24CXX_FreeLines(hat24) == 0;
+    for (int i = 0; i < AT24CXX_BUF_LINES; i++) {
+        AT24CXX_Line *line = &hat24->Lines[i];
+        if (line->Seq != 0 && (pick == NULL || line->Seq < pick->Seq)) pick = line;
+    }
+    if (pick == NULL) {
+        hat24->FlushAll = 0;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    // Span from the first to the last written byte, and whether it has holes
+    first = hat24->Unit;
+    for (uint16_t i = 0; i < hat24->Unit; i++) {
+        if (AT24CXX_LINE_DIRTY(pick, i)) {
+            if (first == hat24->Unit) first = i;
+            else gaps += (uint16_t)(i - last - 1U);
+            last = i;
+        }
+    }
+    // A partly filled line waits for more updates unless space is short
+    if (!starved && (first != 0 || last != hat24->Unit - 1U || gaps != 0) &&
+        tick - pick->Touched < AT24CXX_COALESCE_MS) {
+        __set_PRIMASK(primask);
+        return;
+    }
+    pick->Flushing = 1;
+    hat24->Active = (int8_t)(pick - hat24->Lines);
+    hat24->SpanOff = first;
+    hat24->SpanLen = (uint16_t)(last - first + 1U);
+    hat24->OpState = gaps ? AT24CXX_OP_FILL : AT24CXX_OP_WRITE;
+    __set_PRIMASK(primask);
+
+    if (gaps) {
+        uint16_t devAddr, memAddr, memSize;
+
+        AT24CXX_Address(hat24, pick->Addr + first, &devAddr, &memAddr, &memSize);
+        if (I2C_DMA_MemRead(hat24->hi2c, devAddr, memAddr, memSize, hat24->Fill, hat24->SpanLen,
+                            AT24CXX_FillDone, hat24) != HAL_OK) {
+            AT24CXX_LineDone(hat24, false);
+        }
+    } else {
+        AT24CXX_StartWrite(hat24);
+    }
+}
+
+/**
+ * @brief One step of the background writer
+ * @param start Start the next line when the bus is free
+ */
+static uint8_t AT24CXX_Step(AT24CXX_HandleTypeDef *hat24, uint8_t start) {
+    uint32_t tick = HAL_GetTick();
+    uint8_t pending;
+
+    // Called from both a timer interrupt and a blocking wait: one runs at a time
+    if (hat24->InPoll) return 1;
+    hat24->InPoll = 1;
+
+    if (hat24->OpState == AT24CXX_OP_CYCLE) {
+        // One address probe per tick; the cycle takes several
+        if (tick != hat24->ProbeTick) {
+            hat24->ProbeTick = tick;
+            hat24->Stats.AckPolls++;
+            if (HAL_I2C_IsDeviceReady(hat24->hi2c, hat24->I2C_Address, 1, 1) == HAL_OK) {
+                AT24CXX_LineDone(hat24, true);
+            } else if (tick - hat24->OpTick > AT24CXX_WRITE_TIMEOUT_MS) {
+                AT24CXX_LineDone(hat24, false);
+            }
+        }
+    }
+    if (hat24->OpState == AT24CXX_OP_IDLE && start) {
+        AT24CXX_StartLine(hat24);
+    }
+
+    pending = (hat24->OpState != AT24CXX_OP_IDLE) || AT24CXX_FreeLines(hat24) != AT24CXX_BUF_LINES;
+    hat24->InPoll = 0;
+    return pending;
+}
+
+/**
+ * @brief Advance the background writer
+ */
+uint8_t AT24CXX_Poll(AT24CXX_HandleTypeDef *hat24) {
+    return AT24CXX_Step(hat24, !hat24->Hold);
+}
+
+/**
+ * @brief Write every buffered line from a blocking call that holds the bus
+ * @note  Hold is set by the caller, so the timer's AT24CXX_Poll only waits
+ *        out cycles; the lines are started from here.
+ */
+static void AT24CXX_Drain(AT24CXX_HandleTypeDef *hat24) {
+    hat24->FlushAll = 1;
+    while (AT24CXX_Step(hat24, 1)) {
+    }
+}
+
+/**
+ * @brief Write buffered lines without waiting for more updates
+ */
+void AT24CXX_Flush(AT24CXX_HandleTypeDef *hat24) {
+    hat24->FlushAll = 1;
+}
+
+/**
+ * @brief Write everything buffered and wait for it
+ */
+uint8_t AT24CXX_Sync(AT24CXX_HandleTypeDef *hat24) {
+    uint32_t errors = hat24->Errors;
+
+    AT24CXX_Flush(hat24);
+    while (AT24CXX_Poll(hat24)) {
+    }
+    return (hat24->Errors != errors) ? 1 : 0;
+}
@@ -3,12 +3,38 @@
  * @brief AT24Cxx I2C EEPROM Driver Header File
  * @author Standard Implementation
  * @date 2024
+ *
+ * Blocking use:
+ *    AT24CXX_Init(&hat24, &hi2c1, AT24C256, 0xA0);
+ *    AT24CXX_Write(&hat24, 0x100, buf, len);   // ~5 ms per page touched
+ *
+ * Background writer (the caller never waits for the write cycle):
+ *    AT24CXX_WriteAsync(&hat24, 0x100, &params, sizeof(params));
+ *    // From a 1 ms timer interrupt (or the main loop):
+ *    void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+ *        if (htim == &htim6) AT24CXX_Poll(&hat24);
+ *    }
+ *
+ *    WriteAsync copies the bytes into a few page-sized RAM lines and
+ *    returns. Updates to the same page merge into one line, so a burst of
+ *    byte or field writes becomes a single page write. A line is written
+ *    once it is full, once it has not been touched for AT24CXX_COALESCE_MS,
+ *    or when the lines run out. The page goes out by I2C DMA (or IT when
+ *    the handle has no DMA channel) through i2c_dma; the ~5 ms write cycle
+ *    is then waited out by probing the chip's address from Poll, one probe
+ *    per tick, instead of spinning in HAL_I2C_IsDeviceReady. Bytes of a
+ *    line that were not written are read from the chip first, so a page
+ *    is never written more than once per flush.
+ *
+ *    AT24CXX_Read returns buffered bytes that are not on the chip yet.
+ *    AT24CXX_Sync blocks until everything is written (before power down).
  */
 
 #ifndef __AT24CXX_H
 #define __AT24CXX_H
 
 #include "main.h"
+#include <stdbool.h>
 
 #ifndef __STM32F1xx_HAL_I2C_H
 #include "main.h"
@@ -29,12 +55,84 @@
 /* Default I2C Address (A0-A2 grounded) */
 #define AT24CXX_I2C_ADDR  0xA0
 
+/* Background writer configuration */
+// Page-sized RAM lines that collect writes (RAM = LINES * (LINE_SIZE * 9/8 + 16))
+#ifndef AT24CXX_BUF_LINES
+#define AT24CXX_BUF_LINES        4
+#endif
+
+// Largest write unit; pages bigger than this (AT24C512) are written in aligned chunks
+#ifndef AT24CXX_BUF_LINE_SIZE
+#define AT24CXX_BUF_LINE_SIZE    64
+#endif
+
+// A partly filled line is written after this long without updates
+#ifndef AT24CXX_COALESCE_MS
+#define AT24CXX_COALESCE_MS      2
+#endif
+
+// Give up on a write cycle that is still not acknowledged after this (tWR is 5 ms max)
+#ifndef AT24CXX_WRITE_TIMEOUT_MS
+#define AT24CXX_WRITE_TIMEOUT_MS 10
+#endif
+
+// Attempts per line before its bytes are dropped and counted in Errors
+#ifndef AT24CXX_WRITE_RETRIES
+#define AT24CXX_WRITE_RETRIES    3
+#endif
+
+/* Background writer steps */
+#define AT24CXX_OP_IDLE   0
+#define AT24CXX_OP_FILL   1   // Reading the bytes of the page that were not written
+#define AT24CXX_OP_WRITE  2   // Page write on the bus
+#define AT24CXX_OP_CYCLE  3   // Chip busy with its internal write cycle
+
+#define AT24CXX_OK        0
+#define AT24CXX_ERROR     1
+#define AT24CXX_BUSY      2   // No free line: nothing was queued, try again later
+
+typedef struct {
+    uint32_t Addr;          // Chip address of the line (aligned to the write unit)
+    uint32_t Seq;           // Allocation order, 0 = free
+    uint32_t Touched;       // HAL_GetTick() of the last update
+    uint8_t  Flushing;      // Being written: new updates go to another line
+    uint8_t  Retries;
+    uint8_t  Dirty[AT24CXX_BUF_LINE_SIZE / 8];
+    uint8_t  Data[AT24CXX_BUF_LINE_SIZE];
+} AT24CXX_Line;
+
+typedef struct {
+    uint32_t Queued;        // Bytes accepted by WriteAsync
+    uint32_t Merged;        // Of those, bytes that landed in an already buffered line
+    uint32_t PageWrites;    // Write cycles started by the background writer
+    uint32_t FillReads;     // Reads of unwritten bytes before a page write
+    uint32_t AckPolls;      // Address probes during write cycles
+    uint32_t Full;          // WriteAsync calls refused for lack of a line
+} AT24CXX_Stats;
+
 typedef struct {
     I2C_HandleTypeDef *hi2c;
     uint16_t          PageSize;
     uint32_t          Capacity; // In bytes
     uint8_t           I2C_Address;
     uint8_t           AddressByteWidth; // 1 (8-bit) or 2 (16-bit)
+
+    // Background writer state (advanced by AT24CXX_Poll and the I2C callbacks)
+    uint16_t          Unit;         // Bytes per line: min(PageSize, AT24CXX_BUF_LINE_SIZE)
+    volatile uint8_t  OpState;      // AT24CXX_OP_xxx
+    volatile uint8_t  Hold;         // Blocking call in progress: start no new lines
+    volatile uint8_t  InPoll;
+    volatile uint8_t  FlushAll;     // Write lines out without waiting for more updates
+    int8_t            Active;       // Line being written, -1 = none
+    uint16_t          SpanOff;      // Part of the active line that is written
+    uint16_t          SpanLen;
+    uint32_t          OpTick;       // Tick the write cycle started
+    uint32_t          ProbeTick;    // Tick of the last address probe
+    uint32_t          Seq;
+    uint32_t          Errors;       // Lines dropped after AT24CXX_WRITE_RETRIES
+    AT24CXX_Line      Lines[AT24CXX_BUF_LINES];
+    uint8_t           Fill[AT24CXX_BUF_LINE_SIZE];
+    AT24CXX_Stats     Stats;
 } AT24CXX_HandleTypeDef;
 
 /* Function Prototypes */
@@ -57,6 +155,8 @@ uint8_t AT24CXX_Check(AT24CXX_HandleTypeDef *hat24);
 
 /**
  * @brief Read data from EEPROM
+ * @note  Includes bytes still buffered by AT24CXX_WriteAsync. Waits for a
+ *        page write in progress, since the chip does not answer during it.
  * @param hat24 Handle to the AT24Cxx structure
  * @param ReadAddr Address to read from
  * @param pBuffer Pointer to buffer to store data
@@ -66,12 +166,16 @@ void AT24CXX_Read(AT24CXX_HandleTypeDef *hat24, uint32_t ReadAddr, uint8_t *pBuf
 
 /**
  * @brief Write data to EEPROM (Handles page write automatically)
+ * @note  Blocks for each page's write cycle. Data queued with
+ *        AT24CXX_WriteAsync is written first, so the order is kept.
  * @param hat24 Handle to the AT24Cxx structure
  * @param WriteAddr Address to write to
  * @param pBuffer Pointer to data buffer
  * @param NumByteToWrite Number of bytes to write
+ * @return AT24CXX_OK, AT24CXX_ERROR (bus error or write cycle timeout;
+ *         the pages from there on are not written)
  */
-void AT24CXX_Write(AT24CXX_HandleTypeDef *hat24, uint32_t WriteAddr, uint8_t *pBuffer, uint16_t NumByteToWrite);
+uint8_t AT24CXX_Write(AT24CXX_HandleTypeDef *hat24, uint32_t WriteAddr, uint8_t *pBuffer, uint16_t NumByteToWrite);
 
 /**
  * @brief Erase the entire EEPROM (Fill with 0xFF)
@@ -79,4 +183,33 @@ void AT24CXX_Write(AT24CXX_HandleTypeDef *hat24, uint32_t WriteAddr, uint8_t *pB
  */
 void AT24CXX_Erase_Chip(AT24CXX_HandleTypeDef *hat24);
 
+/**
+ * @brief Queue data for the background writer and return at once
+ * @note  The bytes are copied, so pBuffer can be reused right away. The
+ *        request is taken whole or not at all; interrupts are held off
+ *        while it is copied. Safe to call from an interrupt of the same
+ *        or lower priority than the one running AT24CXX_Poll.
+ * @return AT24CXX_OK, AT24CXX_ERROR (out of range), AT24CXX_BUSY (lines full)
+ */
+uint8_t AT24CXX_WriteAsync(AT24CXX_HandleTypeDef *hat24, uint32_t WriteAddr, const uint8_t *pBuffer, uint16_t NumByteToWrite);
+
+/**
+ * @brief Advance the background writer: probe for the end of a write cycle
+ *        and start the next page. Call every millisecond, from a timer
+ *        interrupt or the main loop.
+ * @return 1 while buffered data is still to be written, 0 when idle
+ */
+uint8_t AT24CXX_Poll(AT24CXX_HandleTypeDef *hat24);
+
+/**
+ * @brief Write buffered lines without waiting for more updates (non-blocking)
+ */
+void AT24CXX_Flush(AT24CXX_HandleTypeDef *hat24);
+
+/**
+ * @brief Write everything buffered and wait until the chip has it
+ * @return 0 on success, 1 if lines were dropped since the last Sync
+ */
+uint8_t AT24CXX_Sync(AT24CXX_HandleTypeDef *hat24);
+
 #endif // __AT24CXX_H
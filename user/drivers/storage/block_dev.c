@@ -0,0 +1,40 @@
+/**
+ * @file block_dev.c
+ * @brief Common block device interface: range and alignment checks
+ */
+
+#include "block_dev.h"
+
+static int BlockDev_Check(const Block_Device *bd, uint32_t addr, uint32_t len, uint32_t unit) {
+    if (bd == 0 || addr > bd->capacity || len > bd->capacity - addr) return BLOCK_DEV_ERR_PARAM;
+    if (unit > 1 && (addr % unit != 0 || len % unit != 0)) return BLOCK_DEV_ERR_PARAM;
+    return BLOCK_DEV_OK;
+}
+
+int BlockDev_Read(Block_Device *bd, uint32_t addr, void *buf, uint32_t len) {
+    int err = BlockDev_Check(bd, addr, len, bd ? bd->read_size : 0);
+
+    if (err || len == 0) return err;
+    return bd->ops->read(bd, addr, (uint8_t *)buf, len);
+}
+
+int BlockDev_Prog(Block_Device *bd, uint32_t addr, const void *buf, uint32_t len) {
+    int err = BlockDev_Check(bd, addr, len, bd ? bd->prog_size : 0);
+
+    if (err || len == 0) return err;
+    return bd->ops->prog(bd, addr, (const uint8_t *)buf, len);
+}
+
+int BlockDev_Erase(Block_Device *bd, uint32_t addr, uint32_t len) {
+    int err = BlockDev_Check(bd, addr, len, bd ? bd->erase_size : 0);
+
+    if (err || len == 0) return err;
+    if (bd->erase_size == 0 || bd->ops->erase == 0) return BLOCK_DEV_OK;
+    return bd->ops->erase(bd, addr, len);
+}
+
+int BlockDev_Sync(Block_Device *bd) {
+    if (bd == 0) return BLOCK_DEV_ERR_PARAM;
+    if (bd->ops->sync == 0) return BLOCK_DEV_OK;
+    return bd->ops->sync(bd);
+}
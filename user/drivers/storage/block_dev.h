@@ -0,0 +1,69 @@
+/**
+ * @file block_dev.h
+ * @brief Common block device interface for the storage drivers
+ *
+ * A flash or card driver fills in a Block_Device once; the filesystems
+ * (littlefs through littlefs_port.h, FatFs through fatfs_bd.h) mount any
+ * Block_Device, so one driver serves every consumer and a chip can be
+ * swapped for another driver without touching the filesystem glue.
+ *
+ * Addresses and lengths are in bytes from the start of the device.
+ * Reads must be multiples of read_size, programs of prog_size, erases of
+ * erase_size, all aligned to the same. Devices without an erase (SD cards)
+ * have erase_size 0 and program over old data directly.
+ *
+ * Usage:
+ *      static Block_Device nor;
+ *      W25QXX_BlockDev(&nor, &hflash);           // or SFUD_Port_BlockDev()
+ *      BlockDev_Erase(&nor, 0x10000, 4096);
+ *      BlockDev_Prog(&nor, 0x10000, page, 256);
+ */
+
+#ifndef BLOCK_DEV_H
+#define BLOCK_DEV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define BLOCK_DEV_OK          0
+#define BLOCK_DEV_ERR_IO     -1     // The driver reported a failure
+#define BLOCK_DEV_ERR_PARAM  -2     // Out of range or misaligned
+
+typedef struct Block_Device Block_Device;
+
+typedef struct {
+    int (*read)(Block_Device *bd, uint32_t addr, uint8_t *buf, uint32_t len);
+    int (*prog)(Block_Device *bd, uint32_t addr, const uint8_t *buf, uint32_t len);
+    int (*erase)(Block_Device *bd, uint32_t addr, uint32_t len);   // NULL if erase_size is 0
+    int (*sync)(Block_Device *bd);                                 // NULL if writes complete in prog
+} Block_Device_Ops;
+
+struct Block_Device {
+    const char             *name;
+    const Block_Device_Ops *ops;
+    void                   *ctx;            // Driver handle (same ctx = same chip)
+    uint32_t                capacity;       // Bytes
+    uint32_t                read_size;      // 1 for NOR flash, 512 for SD
+    uint32_t                prog_size;      // Page size
+    uint32_t                erase_size;     // Smallest erase, 0 = no erase needed
+    uint32_t                block_size;     // Larger erase the driver uses for aligned runs, 0 if none
+    uint8_t                 erase_value;
+};
+
+/**
+ * @brief Checked calls into the driver
+ * @return BLOCK_DEV_OK, BLOCK_DEV_ERR_PARAM or the driver's error
+ */
+int BlockDev_Read(Block_Device *bd, uint32_t addr, void *buf, uint32_t len);
+int BlockDev_Prog(Block_Device *bd, uint32_t addr, const void *buf, uint32_t len);
+int BlockDev_Erase(Block_Device *bd, uint32_t addr, uint32_t len);
+int BlockDev_Sync(Block_Device *bd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,296 @@
+/**
+ * @file flash_kv.c
+ * @brief Log-structured key-value store on the internal Flash
+ *
+ * Page layout:
+ *   [seq u32][magic u32] [record] [record] ... [0xFF...]
+ * Record layout (4-byte aligned, so F1 halfword and F4 word programs fit):
+ *   [key u16][len u16][crc32 u32][data, padded with 0xFF to 4 bytes]
+ * len bit 15 marks a deletion. The CRC covers key, len and data.
+ */
+
+#include "flash_kv.h"
+#include "internal_flash.h"
+#include <string.h>
+
+#define FLASH_KV_MAGIC          0x314B5646UL   // "FVK1"
+#define FLASH_KV_HEADER_SIZE    8U
+#define FLASH_KV_REC_HEADER     8U
+#define FLASH_KV_DELETED        0x8000U
+#define FLASH_KV_REC_SIZE(len)  (FLASH_KV_REC_HEADER + (((uint32_t)(len) + 3U) & ~3U))
+
+typedef struct {
+    uint16_t key;
+    uint16_t len;
+    uint32_t crc;
+} FlashKV_Record;
+
+// Staging buffer for one record
+static uint8_t rec_buf[FLASH_KV_REC_SIZE(FLASH_KV_MAX_VALUE)];
+
+static uint32_t FlashKV_Crc32(uint32_t crc, const uint8_t *data, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t FlashKV_PageAddr(const FlashKV_HandleTypeDef *kv, uint16_t page) {
+    return kv->base + (uint32_t)page * kv->page_size;
+}
+
+static uint32_t FlashKV_RecordCrc(const FlashKV_Record *rec, const uint8_t *data) {
+    uint32_t crc = FlashKV_Crc32(0, (const uint8_t *)rec, 4);
+    return FlashKV_Crc32(crc, data, rec->len & ~FLASH_KV_DELETED);
+}
+
+// Build a record in rec_buf, returns its size
+static uint32_t FlashKV_BuildRecord(uint16_t key, uint16_t len, const void *value) {
+    FlashKV_Record rec;
+    uint16_t data_len = len & ~FLASH_KV_DELETED;
+    uint32_t size = FLASH_KV_REC_SIZE(data_len);
+
+    memset(rec_buf, 0xFF, size);
+    if (data_len > 0) memcpy(&rec_buf[FLASH_KV_REC_HEADER], value, data_len);
+    rec.key = key;
+    rec.len = len;
+    rec.crc = FlashKV_RecordCrc(&rec, &rec_buf[FLASH_KV_REC_HEADER]);
+    memcpy(rec_buf, &rec, sizeof(rec));
+    return size;
+}
+
+static bool FlashKV_IsBlank(uint32_t addr, uint32_t len) {
+    const uint8_t *p = (const uint8_t *)(uintptr_t)addr;
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (p[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+// Erase a page and make sure it really reads blank (an erase cut by a
+// power loss can leave anything behind)
+static bool FlashKV_ErasePage(FlashKV_HandleTypeDef *kv, uint16_t page) {
+    uint32_t addr = FlashKV_PageAddr(kv, page);
+
+    for (int tries = 0; tries < 2; tries++) {
+        kv->stats.erases++;
+        if (InternalFlash_ErasePage(addr) && FlashKV_IsBlank(addr, kv->page_size)) return true;
+    }
+    return false;
+}
+
+static bool FlashKV_WriteHeader(FlashKV_HandleTypeDef *kv, uint16_t page, uint32_t seq) {
+    uint32_t hdr[2] = {seq, FLASH_KV_MAGIC};
+
+    // seq is programmed first: the page is only valid once the magic lands
+    return InternalFlash_WriteBytes(FlashKV_PageAddr(kv, page), (const uint8_t *)hdr, sizeof(hdr));
+}
+
+// Rebuild the index from the active page and find its end
+static void FlashKV_Scan(FlashKV_HandleTypeDef *kv) {
+    uint32_t page = FlashKV_PageAddr(kv, kv->active);
+    uint32_t end = page + kv->page_size;
+    uint32_t addr = page + FLASH_KV_HEADER_SIZE;
+
+    memset(kv->index, 0, sizeof(kv->index));
+
+    while (addr + FLASH_KV_REC_HEADER <= end) {
+        FlashKV_Record rec;
+        uint16_t data_len;
+
+        InternalFlash_ReadBytes(addr, (uint8_t *)&rec, sizeof(rec));
+        if (rec.key == 0xFFFF && rec.len == 0xFFFF) break;     // Free space
+
+        data_len = rec.len & ~FLASH_KV_DELETED;
+        if (data_len > FLASH_KV_MAX_VALUE || addr + FLASH_KV_REC_SIZE(data_len) > end ||
+            rec.crc != FlashKV_RecordCrc(&rec, (const uint8_t *)(uintptr_t)(addr + FLASH_KV_REC_HEADER))) {
+            // Interrupted write: nothing after it can be trusted to be blank,
+            // so the next Set compacts into a fresh page
+            kv->stats.recovered++;
+            addr = end;
+            break;
+        }
+
+        // Keys beyond FLASH_KV_MAX_KEYS (built with a larger table) are dropped
+        if (rec.key < FLASH_KV_MAX_KEYS) {
+            kv->index[rec.key] = (rec.len & FLASH_KV_DELETED) ? 0 : addr;
+        }
+        addr += FLASH_KV_REC_SIZE(data_len);
+    }
+
+    kv->write_addr = addr;
+}
+
+// Size of the live record of a key
+static uint32_t FlashKV_LiveSize(const FlashKV_HandleTypeDef *kv, uint16_t key) {
+    FlashKV_Record rec;
+
+    InternalFlash_ReadBytes(kv->index[key], (uint8_t *)&rec, sizeof(rec));
+    return FLASH_KV_REC_SIZE(rec.len);
+}
+
+// Copy every live record to the next page, then switch to it
+static FlashKV_Status FlashKV_CompactInto(FlashKV_HandleTypeDef *kv) {
+    uint16_t target = (uint16_t)((kv->active + 1U) % kv->page_count);
+    uint32_t start = FlashKV_PageAddr(kv, target) + FLASH_KV_HEADER_SIZE;
+    uint32_t end = FlashKV_PageAddr(kv, target) + kv->page_size;
+    uint32_t addr = start;
+
+    for (uint16_t key = 0; key < FLASH_KV_MAX_KEYS; key++) {
+        if (kv->index[key] != 0) addr += FlashKV_LiveSize(kv, key);
+    }
+    if (addr > end) return FLASH_KV_ERR_NO_SPACE;
+
+    if (!FlashKV_ErasePage(kv, target)) return FLASH_KV_ERR_FLASH;
+
+    // The old page stays the valid one until the new header lands, so the
+    // index keeps pointing at it until then
+    addr = start;
+    for (uint16_t key = 0; key < FLASH_KV_MAX_KEYS; key++) {
+        uint32_t size;
+
+        if (kv->index[key] == 0) continue;
+        size = FlashKV_LiveSize(kv, key);
+        InternalFlash_ReadBytes(kv->index[key], rec_buf, size);
+        if (!InternalFlash_WriteBytes(addr, rec_buf, size)) return FLASH_KV_ERR_FLASH;
+        addr += size;
+    }
+
+    if (!FlashKV_WriteHeader(kv, target, kv->seq + 1U)) return FLASH_KV_ERR_FLASH;
+
+    addr = start;
+    for (uint16_t key = 0; key < FLASH_KV_MAX_KEYS; key++) {
+        uint32_t size;
+
+        if (kv->index[key] == 0) continue;
+        size = FlashKV_LiveSize(kv, key);
+        kv->index[key] = addr;
+        addr += size;
+    }
+
+    kv->active = target;
+    kv->seq++;
+    kv->write_addr = addr;
+    kv->stats.compactions++;
+    return FLASH_KV_OK;
+}
+
+static FlashKV_Status FlashKV_Format(FlashKV_HandleTypeDef *kv) {
+    if (!FlashKV_ErasePage(kv, 0) || !FlashKV_WriteHeader(kv, 0, 1)) return FLASH_KV_ERR_FLASH;
+
+    memset(kv->index, 0, sizeof(kv->index));
+    kv->active = 0;
+    kv->seq = 1;
+    kv->write_addr = kv->base + FLASH_KV_HEADER_SIZE;
+    return FLASH_KV_OK;
+}
+
+FlashKV_Status FlashKV_Init(FlashKV_HandleTypeDef *kv, uint32_t base, uint16_t page_count) {
+    bool found = false;
+
+    memset(kv, 0, sizeof(*kv));
+    kv->base = base;
+    kv->page_count = page_count;
+    kv->page_size = InternalFlash_GetPageSize(base);
+
+    if (page_count < 2 || (base % kv->page_size) != 0) return FLASH_KV_ERR_PARAM;
+    for (uint16_t p = 1; p < page_count; p++) {
+        if (InternalFlash_GetPageSize(FlashKV_PageAddr(kv, p)) != kv->page_size) return FLASH_KV_ERR_PARAM;
+    }
+
+    // The valid page with the highest sequence number holds the current values
+    for (uint16_t p = 0; p < page_count; p++) {
+        uint32_t hdr[2];
+
+        InternalFlash_ReadBytes(FlashKV_PageAddr(kv, p), (uint8_t *)hdr, sizeof(hdr));
+        if (hdr[1] != FLASH_KV_MAGIC || hdr[0] == 0xFFFFFFFFUL) continue;
+        if (!found || hdr[0] > kv->seq) {
+            kv->active = p;
+            kv->seq = hdr[0];
+            found = true;
+        }
+    }
+
+    if (!found) return FlashKV_Format(kv);
+
+    FlashKV_Scan(kv);
+    return FLASH_KV_OK;
+}
+
+// Append a record, compacting first if the page is full
+static FlashKV_Status FlashKV_Append(FlashKV_HandleTypeDef *kv, uint16_t key, const void *value, uint16_t len) {
+    uint32_t size = FLASH_KV_REC_SIZE(len & ~FLASH_KV_DELETED);
+    uint32_t addr;
+
+    if (kv->write_addr + size > FlashKV_PageAddr(kv, kv->active) + kv->page_size) {
+        FlashKV_Status status = FlashKV_CompactInto(kv);
+        if (status != FLASH_KV_OK) return status;
+        if (kv->write_addr + size > FlashKV_PageAddr(kv, kv->active) + kv->page_size) return FLASH_KV_ERR_NO_SPACE;
+    }
+
+    addr = kv->write_addr;
+    FlashKV_BuildRecord(key, len, value);
+    if (!InternalFlash_WriteBytes(addr, rec_buf, size)) {
+        // Half-written slot: skip the rest of the page
+        kv->write_addr = FlashKV_PageAddr(kv, kv->active) + kv->page_size;
+        return FLASH_KV_ERR_FLASH;
+    }
+
+    kv->write_addr += size;
+    kv->index[key] = (len & FLASH_KV_DELETED) ? 0 : addr;
+    kv->stats.writes++;
+    return FLASH_KV_OK;
+}
+
+FlashKV_Status FlashKV_Set(FlashKV_HandleTypeDef *kv, uint16_t key, const void *value, uint16_t len) {
+    if (key >= FLASH_KV_MAX_KEYS || len > FLASH_KV_MAX_VALUE || (value == NULL && len > 0)) {
+        return FLASH_KV_ERR_PARAM;
+    }
+
+    // Same value already stored: save the program (and the wear)
+    if (kv->index[key] != 0) {
+        FlashKV_Record rec;
+        InternalFlash_ReadBytes(kv->index[key], (uint8_t *)&rec, sizeof(rec));
+        if (rec.len == len && (len == 0 ||
+            memcmp((const void *)(uintptr_t)(kv->index[key] + FLASH_KV_REC_HEADER), value, len) == 0)) {
+            kv->stats.unchanged++;
+            return FLASH_KV_OK;
+        }
+    }
+
+    return FlashKV_Append(kv, key, value, len);
+}
+
+FlashKV_Status FlashKV_Get(FlashKV_HandleTypeDef *kv, uint16_t key, void *buf, uint16_t size, uint16_t *len) {
+    FlashKV_Record rec;
+
+    if (key >= FLASH_KV_MAX_KEYS) return FLASH_KV_ERR_PARAM;
+    if (kv->index[key] == 0) return FLASH_KV_ERR_NOT_FOUND;
+
+    InternalFlash_ReadBytes(kv->index[key], (uint8_t *)&rec, sizeof(rec));
+    InternalFlash_ReadBytes(kv->index[key] + FLASH_KV_REC_HEADER, (uint8_t *)buf, (rec.len < size) ? rec.len : size);
+    if (len) *len = rec.len;
+    return FLASH_KV_OK;
+}
+
+FlashKV_Status FlashKV_Delete(FlashKV_HandleTypeDef *kv, uint16_t key) {
+    if (key >= FLASH_KV_MAX_KEYS) return FLASH_KV_ERR_PARAM;
+    if (kv->index[key] == 0) return FLASH_KV_ERR_NOT_FOUND;
+
+    return FlashKV_Append(kv, key, NULL, FLASH_KV_DELETED);
+}
+
+FlashKV_Status FlashKV_Compact(FlashKV_HandleTypeDef *kv) {
+    return FlashKV_CompactInto(kv);
+}
+
+uint32_t FlashKV_Free(const FlashKV_HandleTypeDef *kv) {
+    uint32_t end = FlashKV_PageAddr(kv, kv->active) + kv->page_size;
+
+    return (kv->write_addr < end) ? end - kv->write_addr : 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file flash_kv.h
+ * @brief Log-structured key-value store on the internal Flash
+ * @details Values are appended as CRC-protected records to the active page;
+ *          updating a setting costs one small program instead of a page
+ *          erase. When the page is full the live values are copied to the
+ *          next page (round robin, so the erases are spread over all pages)
+ *          and the old page is dropped. A RAM index built at Init gives O(1)
+ *          lookups.
+ *
+ *          Power-fail safe: a record is written header first and only counts
+ *          when its CRC matches; a compacted page only becomes valid when its
+ *          header (written last) carries a higher sequence number than the
+ *          old one. Whatever was interrupted is ignored at the next Init.
+ *
+ * Usage:
+ *      FlashKV_HandleTypeDef kv;
+ *      uint32_t boots = 0;
+ *      uint16_t len;
+ *      // Last two pages of the Flash
+ *      FlashKV_Init(&kv, InternalFlash_GetLastPageAddress() - FLASH_PAGE_SIZE, 2);
+ *      FlashKV_Get(&kv, KEY_BOOTS, &boots, sizeof(boots), &len);
+ *      boots++;
+ *      FlashKV_Set(&kv, KEY_BOOTS, &boots, sizeof(boots));
+ */
+
+#ifndef FLASH_KV_H
+#define FLASH_KV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Keys are small integers: 0 .. FLASH_KV_MAX_KEYS - 1 */
+#ifndef FLASH_KV_MAX_KEYS
+#define FLASH_KV_MAX_KEYS   64
+#endif
+
+/* Largest value in bytes */
+#ifndef FLASH_KV_MAX_VALUE
+#define FLASH_KV_MAX_VALUE  64
+#endif
+
+typedef enum {
+    FLASH_KV_OK = 0,
+    FLASH_KV_ERR_PARAM,         // Bad key, length or layout
+    FLASH_KV_ERR_NOT_FOUND,
+    FLASH_KV_ERR_NO_SPACE,      // Live values do not fit in one page
+    FLASH_KV_ERR_FLASH          // Program or erase failed
+} FlashKV_Status;
+
+typedef struct {
+    uint32_t writes;            // Records appended
+    uint32_t unchanged;         // Set() calls skipped because the value was already stored
+    uint32_t compactions;
+    uint32_t erases;
+    uint32_t recovered;         // Interrupted records/pages ignored at Init
+} FlashKV_Stats;
+
+typedef struct {
+    uint32_t base;              // Address of the first page
+    uint32_t page_size;
+    uint16_t page_count;
+    uint16_t active;            // Page holding the current values
+    uint32_t seq;               // Generation of the active page
+    uint32_t write_addr;        // Next free record slot in the active page
+    uint32_t index[FLASH_KV_MAX_KEYS];  // Record address per key, 0 = not set
+    FlashKV_Stats stats;
+} FlashKV_HandleTypeDef;
+
+/**
+ * @brief  Mount the store, formatting it if no valid page is found.
+ * @param  base Address of the first page (page aligned).
+ * @param  page_count Pages used, at least 2. All must have the same size.
+ */
+FlashKV_Status FlashKV_Init(FlashKV_HandleTypeDef *kv, uint32_t base, uint16_t page_count);
+
+/**
+ * @brief  Store a value (a no-op if the same value is already stored).
+ */
+FlashKV_Status FlashKV_Set(FlashKV_HandleTypeDef *kv, uint16_t key, const void *value, uint16_t len);
+
+/**
+ * @brief  Read a value.
+ * @param  size Size of buf; longer values are truncated.
+ * @param  len Returns the stored length (may be NULL).
+ */
+FlashKV_Status FlashKV_Get(FlashKV_HandleTypeDef *kv, uint16_t key, void *buf, uint16_t size, uint16_t *len);
+
+/**
+ * @brief  Remove a key.
+ */
+FlashKV_Status FlashKV_Delete(FlashKV_HandleTypeDef *kv, uint16_t key);
+
+/**
+ * @brief  Copy the live values to a fresh page now (e.g. at a convenient
+ *         moment instead of inside a time-critical Set).
+ */
+FlashKV_Status FlashKV_Compact(FlashKV_HandleTypeDef *kv);
+
+/**
+ * @brief  Bytes left in the active page before the next compaction.
+ */
+uint32_t FlashKV_Free(const FlashKV_HandleTypeDef *kv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_KV_H
@@ -0,0 +1,63 @@
+/**
+ * @file flash_kv_tests.c
+ * @brief Test Suite for the Flash Key-Value Store
+ */
+
+#include "flash_kv.h"
+#include "internal_flash.h"
+#include "uart.h"
+#include <stdio.h>
+#include <string.h>
+
+enum {
+    KEY_BOOT_COUNT = 0,
+    KEY_PID_P,
+    KEY_WIFI_SSID,
+};
+
+void app_main(void) {
+    FlashKV_HandleTypeDef kv;
+    uint32_t boot_count = 0;
+    float pid_p = 1.5f, pid_back = 0;
+    char ssid[32] = {0};
+    uint16_t len;
+
+    UART_Init();
+    UART_Debug_Printf("\r\n=== Flash KV Test Start ===\r\n");
+
+    // 1. Mount on the last two pages
+    uint32_t base = InternalFlash_GetLastPageAddress() - InternalFlash_GetPageSize(InternalFlash_GetLastPageAddress());
+    if (FlashKV_Init(&kv, base, 2) != FLASH_KV_OK) {
+        UART_Debug_Printf("Init FAILED.\r\n");
+        return;
+    }
+    UART_Debug_Printf("Active page %d, seq %lu, %lu bytes free\r\n", kv.active, kv.seq, FlashKV_Free(&kv));
+
+    // 2. Boot counter survives resets: one small program per boot
+    FlashKV_Get(&kv, KEY_BOOT_COUNT, &boot_count, sizeof(boot_count), &len);
+    boot_count++;
+    FlashKV_Set(&kv, KEY_BOOT_COUNT, &boot_count, sizeof(boot_count));
+    UART_Debug_Printf("Boot Count: %lu\r\n", boot_count);
+
+    // 3. Roundtrip
+    FlashKV_Set(&kv, KEY_PID_P, &pid_p, sizeof(pid_p));
+    FlashKV_Set(&kv, KEY_WIFI_SSID, "TestWiFi_SSID", sizeof("TestWiFi_SSID"));
+    FlashKV_Get(&kv, KEY_PID_P, &pid_back, sizeof(pid_back), &len);
+    FlashKV_Get(&kv, KEY_WIFI_SSID, ssid, sizeof(ssid), &len);
+    UART_Debug_Printf("PID P: %d/10, SSID=%s\r\n", (int)(pid_back * 10), ssid);
+
+    // 4. Many updates: compactions rotate through the pages
+    for (uint32_t i = 0; i < 200; i++) {
+        FlashKV_Set(&kv, KEY_PID_P, &i, sizeof(i));
+    }
+    UART_Debug_Printf("Writes %lu, compactions %lu, erases %lu\r\n",
+                      kv.stats.writes, kv.stats.compactions, kv.stats.erases);
+
+    memset(ssid, 0, sizeof(ssid));
+    FlashKV_Get(&kv, KEY_WIFI_SSID, ssid, sizeof(ssid), &len);
+    if (strcmp(ssid, "TestWiFi_SSID") == 0) {
+        UART_Debug_Printf("=== TEST PASSED: Values kept across compaction ===\r\n");
+    } else {
+        UART_Debug_Printf("=== TEST FAILED: Data Mismatch ===\r\n");
+    }
+}
@@ -81,6 +81,18 @@ uint32_t InternalFlash_GetLastPageAddress(void) {
 #endif
 }
 
+uint32_t InternalFlash_GetPageSize(uint32_t address) {
+#if defined(STM32F4)
+    // Sectors 0-3: 16KB, 4: 64KB, 5-7: 128KB
+    if (address < 0x08010000) return 16 * 1024;
+    if (address < 0x08020000) return 64 * 1024;
+    return 128 * 1024;
+#else
+    (void)address;
+    return FLASH_PAGE_SIZE;
+#endif
+}
+
 bool InternalFlash_ErasePage(uint32_t pageAddress) {
     FLASH_EraseInitTypeDef EraseInitStruct = {0};
     uint32_t PageError = 0;
@@ -109,20 +121,46 @@ bool InternalFlash_ErasePage(uint32_t pageAddress) {
 }
 
 bool InternalFlash_WriteBytes(uint32_t address, const uint8_t *data, uint32_t length) {
+    uint32_t i = 0;
+
     HAL_FLASH_Unlock();
     
-    for (uint32_t i = 0; i < length; i++) {
+    while (i < length) {
+        HAL_StatusTypeDef status;
 #if defined(STM32F4)
-         if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, address + i, data[i]) != HAL_OK) {
-            HAL_FLASH_Lock();
-            return false;
+        // Whole words where aligned, bytes at the edges
+        if (((address + i) & 3U) == 0 && length - i >= 4) {
+            uint32_t word;
+            memcpy(&word, &data[i], 4);
+            status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + i, word);
+            i += 4;
+        } else {
+            status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, address + i, data[i]);
+            i += 1;
         }
 #elif defined(STM32F1)
-         // F1 Logic Placeholder (assuming halfword alignment handled by caller or simple byte loop fails)
-         // This simple loop is risky on F1. 
-         HAL_FLASH_Lock();
-         return false; 
+        // F1 programs halfwords only. A byte at an odd start or even end is
+        // paired with 0xFF, which leaves the neighbouring byte erased.
+        uint32_t hw_addr = (address + i) & ~1U;
+        uint16_t hw;
+        if (hw_addr != address + i) {
+            hw = (uint16_t)(0x00FFU | ((uint16_t)data[i] << 8));
+            i += 1;
+        } else if (length - i == 1) {
+            hw = (uint16_t)(0xFF00U | data[i]);
+            i += 1;
+        } else {
+            hw = (uint16_t)(data[i] | ((uint16_t)data[i + 1] << 8));
+            i += 2;
+        }
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, hw_addr, hw);
+#else
+        status = HAL_ERROR;
 #endif
+        if (status != HAL_OK) {
+            HAL_FLASH_Lock();
+            return false;
+        }
     }
     
     HAL_FLASH_Lock();
@@ -130,5 +168,5 @@ bool InternalFlash_WriteBytes(uint32_t address, const uint8_t *data, uint32_t le
 }
 
 void InternalFlash_ReadBytes(uint32_t address, uint8_t *buffer, uint32_t length) {
-    memcpy(buffer, (void*)address, length);
+    memcpy(buffer, (const void*)(uintptr_t)address, length);
 }
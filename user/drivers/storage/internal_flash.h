@@ -24,6 +24,13 @@ extern "C" {
  */
 uint32_t InternalFlash_GetLastPageAddress(void);
 
+/**
+ * @brief  Size of the page (F1) or sector (F4) containing an address.
+ * @param  address Any address in Flash.
+ * @return Erase unit size in bytes.
+ */
+uint32_t InternalFlash_GetPageSize(uint32_t address);
+
 /**
  * @brief  Erase a specific page in Flash.
  * @param  pageAddress Any address belonging to the page to be erased.
@@ -34,8 +41,11 @@ bool InternalFlash_ErasePage(uint32_t pageAddress);
 /**
  * @brief  Write a buffer of bytes to Flash.
  * @note   The destination area must be erased (0xFF) before writing!
- *         This function handles 16-bit/32-bit alignment automatically.
- * @param  address Start address in Flash (must be 2-byte aligned for F1).
+ *         Programs words on F4 and halfwords on F1 (bytes only at unaligned
+ *         edges). On F1 a halfword can be programmed once per erase: an odd
+ *         start or end pads the other byte with 0xFF, which cannot be
+ *         written later without erasing the page.
+ * @param  address Start address in Flash.
  * @param  data Pointer to source data buffer.
  * @param  length Number of bytes to write.
  * @return true if successful, false otherwise.
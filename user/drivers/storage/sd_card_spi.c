@@ -6,10 +6,17 @@
  */
 
 #include "sd_card_spi.h"
+#include "spi_dma.h"
 #include <string.h>
 
 // --- Definitions ---
 #define SD_DUMMY_BYTE   0xFF
+#define SD_BLOCK_SIZE   512
+
+// Data tokens
+#define SD_TOKEN_START_BLOCK    0xFE    // CMD17/CMD18/CMD24
+#define SD_TOKEN_MULTI_WRITE    0xFC    // CMD25 data block
+#define SD_TOKEN_STOP_TRAN      0xFD    // CMD25 end
 
 // SD Commands
 #define CMD0    0
@@ -69,11 +76,7 @@ static uint8_t SD_SPI_WaitReady(SD_Card_SPI_HandleTypeDef *hsd) {
     return 1;
 }
 
-static uint8_t SD_SPI_SendCommand(SD_Card_SPI_HandleTypeDef *hsd, uint8_t cmd, uint32_t arg, uint8_t crc) {
-    // Wait for card ready
-    SD_SPI_WaitReady(hsd);
-    
-    // Transmit command
+static void SD_SPI_SendFrame(SD_Card_SPI_HandleTypeDef *hsd, uint8_t cmd, uint32_t arg, uint8_t crc) {
     uint8_t frame[6];
     frame[0] = 0x40 | cmd;
     frame[1] = (arg >> 24) & 0xFF;
@@ -88,7 +91,9 @@ static uint8_t SD_SPI_SendCommand(SD_Card_SPI_HandleTypeDef *hsd, uint8_t cmd, u
     if (cmd == CMD8) frame[5] = 0x87;
     
     HAL_SPI_Transmit(hsd->hspi, frame, 6, 100);
-    
+}
+
+static uint8_t SD_SPI_GetR1(SD_Card_SPI_HandleTypeDef *hsd) {
     // Wait for response (R1)
     // Up to 10 bytes wait
     uint8_t res;
@@ -100,6 +105,162 @@ static uint8_t SD_SPI_SendCommand(SD_Card_SPI_HandleTypeDef *hsd, uint8_t cmd, u
     return res;
 }
 
+static uint8_t SD_SPI_SendCommand(SD_Card_SPI_HandleTypeDef *hsd, uint8_t cmd, uint32_t arg, uint8_t crc) {
+    // Wait for card ready
+    SD_SPI_WaitReady(hsd);
+    
+    // Transmit command
+    SD_SPI_SendFrame(hsd, cmd, arg, crc);
+    return SD_SPI_GetR1(hsd);
+}
+
+// End a CMD18 stream. The card may already be sending the next block, so do
+// not wait for 0xFF first, and skip the stuff byte that follows CMD12.
+static uint8_t SD_SPI_StopTransmission(SD_Card_SPI_HandleTypeDef *hsd) {
+    uint8_t res;
+
+    SD_SPI_SendFrame(hsd, CMD12, 0, 0);
+    SD_SPI_TxRx(hsd, SD_DUMMY_BYTE);
+    res = SD_SPI_GetR1(hsd);
+    if (SD_SPI_WaitReady(hsd) != 0) return 0xFF;
+    return res;
+}
+
+static uint32_t SD_SPI_Address(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector) {
+    // Byte address for non-HC cards
+    return (hsd->Type == SD_CARD_TYPE_V2HC) ? sector : sector * SD_BLOCK_SIZE;
+}
+
+static void SD_SPI_DmaDone(void *ctx, bool ok) {
+    SD_Card_SPI_HandleTypeDef *hsd = (SD_Card_SPI_HandleTypeDef *)ctx;
+
+    hsd->DmaOk = ok ? 1 : 0;
+    hsd->DmaBusy = 0;
+}
+
+static uint8_t SD_SPI_DmaWait(SD_Card_SPI_HandleTypeDef *hsd) {
+    uint32_t start = HAL_GetTick();
+
+    while (hsd->DmaBusy) {
+        if ((HAL_GetTick() - start) > SD_SPI_DMA_TIMEOUT_MS) {
+            HAL_SPI_Abort(hsd->hspi);
+            hsd->DmaBusy = 0;
+            hsd->DmaOk = 0;
+        }
+    }
+    if (!hsd->DmaOk) {
+        hsd->Errors++;
+        return 1;
+    }
+    return 0;
+}
+
+// Data phases: DMA when both channels are linked, polled otherwise
+static uint8_t SD_SPI_RxData(SD_Card_SPI_HandleTypeDef *hsd, uint8_t *buffer, uint16_t len) {
+    // A full-duplex master receive clocks the buffer out on MOSI: keep it high
+    memset(buffer, SD_DUMMY_BYTE, len);
+
+    if (hsd->UseDMA) {
+        hsd->DmaBusy = 1;
+        if (SPI_DMA_Receive(hsd->hspi, buffer, len, SD_SPI_DmaDone, hsd) != HAL_OK) {
+            hsd->DmaBusy = 0;
+            hsd->Errors++;
+            return 1;
+        }
+        return SD_SPI_DmaWait(hsd);
+    }
+    return (HAL_SPI_Receive(hsd->hspi, buffer, len, 500) == HAL_OK) ? 0 : 1;
+}
+
+static uint8_t SD_SPI_TxData(SD_Card_SPI_HandleTypeDef *hsd, const uint8_t *buffer) {
+    if (hsd->UseDMA) {
+        hsd->DmaBusy = 1;
+        if (SPI_DMA_Transmit(hsd->hspi, buffer, SD_BLOCK_SIZE, SD_SPI_DmaDone, hsd) != HAL_OK) {
+            hsd->DmaBusy = 0;
+            hsd->Errors++;
+            return 1;
+        }
+        return SD_SPI_DmaWait(hsd);
+    }
+    // cast const away safely here for HAL API
+    return (HAL_SPI_Transmit(hsd->hspi, (uint8_t*)buffer, SD_BLOCK_SIZE, 500) == HAL_OK) ? 0 : 1;
+}
+
+// Data token, len bytes, CRC: one block of a CMD17/CMD18 read (512) or a register (CSD/CID, 16)
+static uint8_t SD_SPI_ReceiveBlock(SD_Card_SPI_HandleTypeDef *hsd, uint8_t *buffer, uint16_t len) {
+    uint8_t crc[2];
+    uint8_t token;
+
+    // Wait for data token (0xFE)
+    // Timeout 200ms
+    uint32_t start = HAL_GetTick();
+    do {
+        token = SD_SPI_TxRx(hsd, SD_DUMMY_BYTE);
+    } while (token == 0xFF && (HAL_GetTick() - start < 200));
+
+    if (token != SD_TOKEN_START_BLOCK) return 1;
+    if (SD_SPI_RxData(hsd, buffer, len) != 0) return 1;
+
+    // Read CRC (2 bytes) - throw away
+    memset(crc, SD_DUMMY_BYTE, sizeof(crc));
+    HAL_SPI_Receive(hsd->hspi, crc, 2, 10);
+    return 0;
+}
+
+// Token, 512 bytes, CRC, then the data response: one block of a CMD24/CMD25 write
+static uint8_t SD_SPI_TransmitBlock(SD_Card_SPI_HandleTypeDef *hsd, uint8_t token, const uint8_t *buffer) {
+    uint8_t tail[3] = {SD_DUMMY_BYTE, SD_DUMMY_BYTE, SD_DUMMY_BYTE};
+    uint8_t resp[3];
+
+    SD_SPI_TxRx(hsd, token);
+    if (SD_SPI_TxData(hsd, buffer) != 0) return 1;
+
+    // Dummy CRC, then the data response ((xxx0010x) & 0x1F) -> 0x05 accepted
+    HAL_SPI_TransmitReceive(hsd->hspi, tail, resp, 3, 10);
+    if ((resp[2] & 0x1F) != 0x05) {
+        hsd->Errors++;
+        return 1;
+    }
+    return 0;
+}
+
+// Card size and erase sector from the CSD register (CMD9)
+static uint8_t SD_SPI_ReadCSD(SD_Card_SPI_HandleTypeDef *hsd) {
+    uint8_t csd[16];
+    uint32_t c_size, mult, read_bl_len, write_bl_len;
+    uint8_t res = 1;
+
+    SD_SPI_Select(hsd);
+    if (SD_SPI_SendCommand(hsd, CMD9, 0, 0) == 0 && SD_SPI_ReceiveBlock(hsd, csd, sizeof(csd)) == 0) {
+        res = 0;
+    }
+    SD_SPI_Deselect(hsd);
+    if (res != 0) return res;
+
+    if ((csd[0] >> 6) == 1 && hsd->Type != SD_CARD_TYPE_MMC) {
+        // CSD 2.0 (SDHC/SDXC): C_SIZE [69:48] in 512 KB units
+        c_size = ((uint32_t)(csd[7] & 0x3F) << 16) | ((uint32_t)csd[8] << 8) | csd[9];
+        hsd->Capacity = (c_size + 1) * 1024;
+    } else {
+        // CSD 1.0 and MMC: (C_SIZE [73:62] + 1) << (C_SIZE_MULT [49:47] + 2) blocks of 2^READ_BL_LEN [83:80]
+        read_bl_len = csd[5] & 0x0F;
+        c_size = ((uint32_t)(csd[6] & 0x03) << 10) | ((uint32_t)csd[7] << 2) | (csd[8] >> 6);
+        mult = ((uint32_t)(csd[9] & 0x03) << 1) | (csd[10] >> 7);
+        if (read_bl_len < 9 || read_bl_len > 11) return 1;
+        hsd->Capacity = (c_size + 1) << (mult + 2 + read_bl_len - 9);
+    }
+
+    // SD erase sector: SECTOR_SIZE [45:39] + 1 write blocks of 2^WRITE_BL_LEN [25:22]
+    hsd->EraseSectors = 0;
+    if (hsd->Type != SD_CARD_TYPE_MMC) {
+        write_bl_len = ((uint32_t)(csd[12] & 0x03) << 2) | (csd[13] >> 6);
+        if (write_bl_len >= 9 && write_bl_len <= 11) {
+            hsd->EraseSectors = ((((uint32_t)(csd[10] & 0x3F) << 1) | (csd[11] >> 7)) + 1) << (write_bl_len - 9);
+        }
+    }
+    return 0;
+}
+
 
 // --- Public Functions ---
 
@@ -107,6 +268,14 @@ uint8_t SD_SPI_Init(SD_Card_SPI_HandleTypeDef *hsd, SPI_HandleTypeDef *hspi, GPI
     hsd->hspi = hspi;
     hsd->CsPort = cs_port; hsd->CsPin = cs_pin;
     hsd->Type = SD_CARD_TYPE_UKN;
+    hsd->Capacity = 0;
+    hsd->EraseSectors = 0;
+    // Full-duplex master RX DMA clocks the bus with the TX channel
+    hsd->UseDMA = (SPI_DMA_HasRx(hspi) && SPI_DMA_HasTx(hspi)) ? 1 : 0;
+    hsd->DmaBusy = 0;
+    hsd->Streaming = 0;
+    hsd->StreamBlocks = 0;
+    hsd->Errors = 0;
     
     // 1. Initial Deselect and explicit dummy clocks
     SD_SPI_Deselect(hsd);
@@ -123,7 +292,7 @@ uint8_t SD_SPI_Init(SD_Card_SPI_HandleTypeDef *hsd, SPI_HandleTypeDef *hspi, GPI
     // CS Low
     SD_SPI_Select(hsd);
     
-    uint8_t n, type, ocr[4];
+    uint8_t n, type = SD_CARD_TYPE_UKN, ocr[4];
     uint8_t res;
 
     // Retry CMD0 multiple times if needed
@@ -191,42 +360,24 @@ uint8_t SD_SPI_Init(SD_Card_SPI_HandleTypeDef *hsd, SPI_HandleTypeDef *hspi, GPI
     
     SD_SPI_Deselect(hsd);
     
-    // Optionally read CSD to get capacity (omitted for brevity, can implement if needed)
-    hsd->Capacity = 0; // Filled if CSD read implemented
-    
-    return (type == SD_CARD_TYPE_UKN) ? 2 : 0;
+    if (type == SD_CARD_TYPE_UKN) return 2;
+
+    // Capacity from the CSD
+    if (SD_SPI_ReadCSD(hsd) != 0) return 3;
+
+    return 0;
 }
 
 // Read Block (Single)
 uint8_t SD_SPI_ReadBlock(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, uint8_t *buffer) {
-    if (hsd->Type == SD_CARD_TYPE_UKN) return 1;
-    
-    uint32_t addr = sector;
-    if (hsd->Type != SD_CARD_TYPE_V2HC) {
-        addr *= 512; // Byte address for non-HC cards
-    }
+    if (hsd->Type == SD_CARD_TYPE_UKN || hsd->Streaming) return 1;
     
     SD_SPI_Select(hsd);
     
-    if (SD_SPI_SendCommand(hsd, CMD17, addr, 0) == 0) {
-        // Wait for data token (0xFE)
-        // Timeout 100ms
-        uint32_t start = HAL_GetTick();
-        uint8_t token;
-        do {
-            token = SD_SPI_TxRx(hsd, SD_DUMMY_BYTE);
-        } while (token == 0xFF && (HAL_GetTick() - start < 200));
-        
-        if (token == 0xFE) {
-            // Read 512 bytes
-            HAL_SPI_Receive(hsd->hspi, buffer, 512, 500);
-            // Read CRC (2 bytes) - throw away
-            SD_SPI_TxRx(hsd, SD_DUMMY_BYTE);
-            SD_SPI_TxRx(hsd, SD_DUMMY_BYTE);
-            
-            SD_SPI_Deselect(hsd);
-            return 0; // Success
-        }
+    if (SD_SPI_SendCommand(hsd, CMD17, SD_SPI_Address(hsd, sector), 0) == 0 &&
+        SD_SPI_ReceiveBlock(hsd, buffer, SD_BLOCK_SIZE) == 0) {
+        SD_SPI_Deselect(hsd);
+        return 0; // Success
     }
     
     SD_SPI_Deselect(hsd);
@@ -235,35 +386,16 @@ uint8_t SD_SPI_ReadBlock(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, uint8_
 
 // Write Block (Single)
 uint8_t SD_SPI_WriteBlock(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, const uint8_t *buffer) {
-    if (hsd->Type == SD_CARD_TYPE_UKN) return 1;
-    
-    uint32_t addr = sector;
-    if (hsd->Type != SD_CARD_TYPE_V2HC) {
-        addr *= 512;
-    }
+    if (hsd->Type == SD_CARD_TYPE_UKN || hsd->Streaming) return 1;
     
     SD_SPI_Select(hsd);
     
-    if (SD_SPI_SendCommand(hsd, CMD24, addr, 0) == 0) {
-        // Send Data Token (0xFE)
-        SD_SPI_TxRx(hsd, 0xFE);
-        
-        // Write 512 bytes
-        HAL_SPI_Transmit(hsd->hspi, (uint8_t*)buffer, 512, 500); // cast const away safely here for HAL API
-        
-        // Send Dummy CRC
-        SD_SPI_TxRx(hsd, 0xFF);
-        SD_SPI_TxRx(hsd, 0xFF);
-        
-        // Receive Data Response ((xxx0010x) & 0x1F) -> 0x05 accepted
-        uint8_t resp = SD_SPI_TxRx(hsd, SD_DUMMY_BYTE);
-        
-        if ((resp & 0x1F) == 0x05) {
-            // Wait while busy (store finishes)
-            SD_SPI_WaitReady(hsd);
-            SD_SPI_Deselect(hsd);
-            return 0; // Success
-        }
+    if (SD_SPI_SendCommand(hsd, CMD24, SD_SPI_Address(hsd, sector), 0) == 0 &&
+        SD_SPI_TransmitBlock(hsd, SD_TOKEN_START_BLOCK, buffer) == 0) {
+        // Wait while busy (store finishes)
+        SD_SPI_WaitReady(hsd);
+        SD_SPI_Deselect(hsd);
+        return 0; // Success
     }
     
     SD_SPI_Deselect(hsd);
@@ -271,15 +403,106 @@ uint8_t SD_SPI_WriteBlock(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, const
 }
 
 uint8_t SD_SPI_ReadBlocks(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, uint8_t *buffer, uint32_t count) {
-    for (uint32_t i=0; i<count; i++) {
-        if(SD_SPI_ReadBlock(hsd, sector+i, buffer + (i*512)) != 0) return 1;
+    uint8_t res = 0;
+
+    if (hsd->Type == SD_CARD_TYPE_UKN || hsd->Streaming) return 1;
+    if (count == 0) return 0;
+    if (count == 1) return SD_SPI_ReadBlock(hsd, sector, buffer);
+
+    SD_SPI_Select(hsd);
+
+    if (SD_SPI_SendCommand(hsd, CMD18, SD_SPI_Address(hsd, sector), 0) != 0) {
+        SD_SPI_Deselect(hsd);
+        return 2;
     }
-    return 0;
+
+    // The card streams the blocks back to back until CMD12
+    for (uint32_t i = 0; i < count; i++) {
+        if (SD_SPI_ReceiveBlock(hsd, buffer + (i * SD_BLOCK_SIZE), SD_BLOCK_SIZE) != 0) {
+            res = 2;
+            break;
+        }
+    }
+    if (SD_SPI_StopTransmission(hsd) != 0) res = 2;
+
+    SD_SPI_Deselect(hsd);
+    return res;
 }
 
 uint8_t SD_SPI_WriteBlocks(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, const uint8_t *buffer, uint32_t count) {
-    for (uint32_t i=0; i<count; i++) {
-        if(SD_SPI_WriteBlock(hsd, sector+i, buffer + (i*512)) != 0) return 1;
+    uint8_t res;
+
+    if (count == 0) return 0;
+    if (count == 1) return SD_SPI_WriteBlock(hsd, sector, buffer);
+
+    res = SD_SPI_WriteStart(hsd, sector, count);
+    if (res != 0) return res;
+
+    for (uint32_t i = 0; i < count; i++) {
+        res = SD_SPI_WriteNext(hsd, buffer + (i * SD_BLOCK_SIZE));
+        if (res != 0) break;
     }
+    if (SD_SPI_WriteStop(hsd) != 0) res = 2;
+    return res;
+}
+
+uint8_t SD_SPI_WriteStart(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, uint32_t count) {
+    if (hsd->Type == SD_CARD_TYPE_UKN || hsd->Streaming) return 1;
+
+    SD_SPI_Select(hsd);
+
+    // Pre-erase count (ACMD23, SD cards only): lets the card erase ahead of
+    // the data, so it is only sent when the caller commits to exactly count
+    hsd->StreamCount = 0;
+    if (count > 0 && count <= 0x7FFFFF && hsd->Type != SD_CARD_TYPE_MMC) {
+        SD_SPI_SendCommand(hsd, CMD55, 0, 0);
+        if (SD_SPI_SendCommand(hsd, CMD23, count, 0) == 0) hsd->StreamCount = count;
+    }
+
+    if (SD_SPI_SendCommand(hsd, CMD25, SD_SPI_Address(hsd, sector), 0) != 0) {
+        SD_SPI_Deselect(hsd);
+        return 2;
+    }
+
+    hsd->Streaming = 1;
+    hsd->StreamBlocks = 0;
     return 0;
 }
+
+uint8_t SD_SPI_WriteNext(SD_Card_SPI_HandleTypeDef *hsd, const uint8_t *buffer) {
+    if (!hsd->Streaming) return 1;
+    if (hsd->StreamCount && hsd->StreamBlocks >= hsd->StreamCount) return 1;
+
+    // The previous block has been programming since the last call
+    if (SD_SPI_WaitReady(hsd) != 0) return 2;
+    if (SD_SPI_TransmitBlock(hsd, SD_TOKEN_MULTI_WRITE, buffer) != 0) return 2;
+
+    hsd->StreamBlocks++;
+    return 0;
+}
+
+uint8_t SD_SPI_WriteStop(SD_Card_SPI_HandleTypeDef *hsd) {
+    uint8_t res = 0;
+
+    if (!hsd->Streaming) return 1;
+    hsd->Streaming = 0;
+
+    if (SD_SPI_WaitReady(hsd) != 0) res = 2;
+    SD_SPI_TxRx(hsd, SD_TOKEN_STOP_TRAN);
+    // One byte before the card signals busy, then wait for the last block
+    SD_SPI_TxRx(hsd, SD_DUMMY_BYTE);
+    if (SD_SPI_WaitReady(hsd) != 0) res = 2;
+
+    SD_SPI_Deselect(hsd);
+
+    // Short of the ACMD23 count: the card may have erased the rest
+    if (hsd->StreamBlocks < hsd->StreamCount) {
+        hsd->Errors++;
+        res = 2;
+    }
+    return res;
+}
+
+uint32_t SD_SPI_GetCapacityKB(SD_Card_SPI_HandleTypeDef *hsd) {
+    return hsd->Capacity / 2;
+}
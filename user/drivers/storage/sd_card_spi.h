@@ -14,6 +14,38 @@
 #include "main.h"
 #endif
 
+/*
+ * Multi-block transfers
+ *   SD_SPI_ReadBlocks streams with CMD18 and ends with CMD12; SD_SPI_WriteBlocks
+ *   pre-erases with ACMD23 and streams with CMD25 and the stop token. The card
+ *   pays its access latency once per call instead of once per sector, and
+ *   programs back-to-back blocks much faster than separate CMD24 writes.
+ *
+ *   When hspi has both DMA channels linked (hdmarx and hdmatx), each 512-byte
+ *   data phase goes out by DMA (see spi_dma.h).
+ *
+ * Streaming writes (data loggers)
+ *   SD_SPI_WriteStart(&hsd, sector, 0);  // Open-ended: no pre-erase hint
+ *   while (logging) {
+ *       fill(buf);                       // the card programs the previous block meanwhile
+ *       SD_SPI_WriteNext(&hsd, buf);     // returns once the card has accepted buf
+ *   }
+ *   SD_SPI_WriteStop(&hsd);
+ *
+ *   The card stays selected from WriteStart to WriteStop, so nothing else may
+ *   use the bus in between.
+ *
+ *   A non-zero count is a promise: it goes to the card as ACMD23, and the card
+ *   may erase that many blocks ahead of the data. A block it pre-erased but
+ *   was never sent has undefined contents, so a stream with a count must write
+ *   exactly count blocks. Pass 0 when the length is not known up front.
+ */
+
+// Timeout for one 512-byte DMA data phase
+#ifndef SD_SPI_DMA_TIMEOUT_MS
+#define SD_SPI_DMA_TIMEOUT_MS 100
+#endif
+
 // --- Card Types ---
 #define SD_CARD_TYPE_UKN    0
 #define SD_CARD_TYPE_MMC    1
@@ -26,14 +58,24 @@ typedef struct {
     GPIO_TypeDef      *CsPort;
     uint16_t          CsPin;
     uint8_t           Type;     // Card Type (SD_CARD_TYPE_...)
-    uint32_t          Capacity; // Card Capacity in sectors (multiply by 512 for bytes)
+    uint32_t          Capacity; // Card Capacity in sectors (multiply by 512 for bytes), from the CSD
+    uint32_t          EraseSectors; // Erase sector in 512-byte sectors from the CSD, 0 if unknown (MMC)
+
+    uint8_t           UseDMA;   // Data phases by DMA (hspi has RX and TX channels)
+    volatile uint8_t  DmaBusy;
+    uint8_t           DmaOk;
+    uint8_t           Streaming;    // Between SD_SPI_WriteStart and SD_SPI_WriteStop
+    uint32_t          StreamBlocks; // Blocks accepted in the current stream
+    uint32_t          StreamCount;  // Blocks promised with ACMD23, 0 for none
+    uint32_t          Errors;       // DMA failures, rejected blocks, short counted streams
 } SD_Card_SPI_HandleTypeDef;
 
 /* Function Prototypes */
 
 /**
  * @brief Initialize the SD Card in SPI mode
- * @return 0 on success, >0 on error
+ * @note  Reads the CSD to fill Capacity and EraseSectors.
+ * @return 0 on success, 1 no response to CMD0, 2 unknown card, 3 CSD read failed
  */
 uint8_t SD_SPI_Init(SD_Card_SPI_HandleTypeDef *hsd, SPI_HandleTypeDef *hspi, GPIO_TypeDef *cs_port, uint16_t cs_pin);
 
@@ -54,17 +96,48 @@ uint8_t SD_SPI_ReadBlock(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, uint8_
 uint8_t SD_SPI_WriteBlock(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, const uint8_t *buffer);
 
 /**
- * @brief Read multiple blocks
+ * @brief Read multiple blocks with one CMD18 stream
+ * @return 0 on success
  */
 uint8_t SD_SPI_ReadBlocks(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, uint8_t *buffer, uint32_t count);
 
 /**
- * @brief Write multiple blocks
+ * @brief Write multiple blocks with one ACMD23 + CMD25 stream
+ * @return 0 on success
  */
 uint8_t SD_SPI_WriteBlocks(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, const uint8_t *buffer, uint32_t count);
 
 /**
- * @brief Get Card Capacity in KBytes
+ * @brief Open a multi-block write stream at sector
+ * @param count Exact number of blocks the stream will write, sent as the
+ *              ACMD23 pre-erase count; 0 for no hint and any length.
+ *              Blocks the card pre-erased but did not receive lose their
+ *              contents, so with a count the stream holds exactly count
+ *              blocks (WriteNext refuses more, WriteStop reports fewer).
+ * @return 0 on success
+ */
+uint8_t SD_SPI_WriteStart(SD_Card_SPI_HandleTypeDef *hsd, uint32_t sector, uint32_t count);
+
+/**
+ * @brief Send the next 512-byte block of the stream
+ * @note  Returns as soon as the card has accepted the block and started
+ *        programming it. The busy time is only waited for at the next call,
+ *        so whatever the caller does in between runs in its shadow.
+ * @return 0 on success, 1 if no stream is open or count blocks were
+ *         already written, 2 if the card rejected the block
+ */
+uint8_t SD_SPI_WriteNext(SD_Card_SPI_HandleTypeDef *hsd, const uint8_t *buffer);
+
+/**
+ * @brief Close the stream (stop token) and wait for the card to finish
+ * @return 0 on success, 2 on a card error or if fewer blocks than the
+ *         WriteStart count were written (the rest of that range may have
+ *         been erased)
+ */
+uint8_t SD_SPI_WriteStop(SD_Card_SPI_HandleTypeDef *hsd);
+
+/**
+ * @brief Get Card Capacity in KBytes (0 before a successful SD_SPI_Init)
  */
 uint32_t SD_SPI_GetCapacityKB(SD_Card_SPI_HandleTypeDef *hsd);
 
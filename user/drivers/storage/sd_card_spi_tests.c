@@ -34,6 +34,8 @@ void app_main(void)
     if (res == 0) {
         UART_Debug_Printf("Init Success!\r\n");
         UART_Debug_Printf("Card Type: %d (2=V1, 4=V2, 6=V2HC)\r\n", hsd.Type);
+        UART_Debug_Printf("Capacity: %lu sectors (%lu MB), erase sector %lu\r\n",
+                          hsd.Capacity, SD_SPI_GetCapacityKB(&hsd) / 1024, hsd.EraseSectors);
     } else {
         UART_Debug_Printf("Init Failed! Error: %d\r\n", res);
         while(1) HAL_Delay(1000);
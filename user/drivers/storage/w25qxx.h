@@ -15,8 +15,33 @@
  * 2. GPIO:
  *    - CS (Chip Select): Any GPIO Output.
  * 
- * 3. Usage:
- *    W25Q_Init(&hspi1, GPIOB, GPIO_PIN_12);
+ * 3. DMA (optional, for bulk reads):
+ *    - Add SPIx_RX and SPIx_TX DMA requests (Byte, Normal mode) and enable the
+ *      SPI global interrupt. Init detects hspi->hdmarx / hdmatx and reads of
+ *      W25QXX_DMA_MIN_BYTES or more then go through DMA.
+ * 
+ * 4. Usage:
+ *    W25QXX_Init(&hflash, &hspi1, GPIOB, GPIO_PIN_12);
+ *    W25QXX_Read(&hflash, buf, 0x1000, 4096);                 // blocking
+ *    W25QXX_ReadDMA(&hflash, buf, 0x1000, 4096, on_done, ctx); // returns at once
+ * 
+ * 5. Background program/erase (no busy-wait in the caller):
+ *    W25QXX_EraseSectorAsync(&hflash, 0x20000, on_erased, ctx);
+ *    while (W25QXX_Poll(&hflash)) { control_loop(); }   // or call Poll from a timer
+ *    A read issued while it runs suspends the program/erase (0x75), reads, and
+ *    resumes it (0x7A), so reads wait ~20 us instead of up to a whole erase.
+ *    Every suspend costs the erase some progress: leave it running between reads.
+ *    Reads of the page/sector being changed, and any read during a chip erase
+ *    (which cannot be suspended), fail instead of returning garbage.
+ * 
+ * 6. Block device (littlefs, FatFs, see block_dev.h):
+ *    W25QXX_BlockDev(&bd, &hflash);   // erases use 64 KB blocks where aligned
+ * 
+ * Reads use Fast Read (0x0B), which the chip accepts at its full SPI clock
+ * (0x03 is limited to 50 MHz). Parts above 16 MB (W25Q256) are addressed with
+ * the 4-byte address opcodes, so the chip's address mode register is never
+ * touched. Dual/quad output reads need IO2/IO3 on a QSPI peripheral and are
+ * not available through the standard SPI bus this driver uses.
  * =================================================================================
  */
 
@@ -24,6 +49,8 @@
 #define __W25QXX_H
 
 #include "main.h"
+#include "block_dev.h"
+#include <stdbool.h>
 
 // Check if HAL SPI is included, otherwise include it manually (adjust for your specific MCU series)
 #ifndef __STM32F1xx_HAL_SPI_H
@@ -48,6 +75,27 @@
 #define W25QXX_DEVICE_ID         0xAB
 #define W25QXX_MANUFACTURER_ID   0x90
 #define W25QXX_JEDEC_ID          0x9F
+#define W25QXX_SUSPEND           0x75
+#define W25QXX_RESUME            0x7A
+
+#define W25QXX_SR2_SUS           0x80   // Program/erase suspended
+
+/* 4-byte address variants (W25Q256 and up) */
+#define W25QXX_READ_DATA_4B       0x13
+#define W25QXX_FAST_READ_4B       0x0C
+#define W25QXX_PAGE_PROGRAM_4B    0x12
+#define W25QXX_SECTOR_ERASE_4B    0x21
+#define W25QXX_BLOCK_ERASE_64K_4B 0xDC
+
+// Reads shorter than this stay polled (DMA setup costs more than it saves)
+#ifndef W25QXX_DMA_MIN_BYTES
+#define W25QXX_DMA_MIN_BYTES 64
+#endif
+
+// Upper bound for one DMA read (a 16 MB read at 18 MHz takes ~7.5 s)
+#ifndef W25QXX_DMA_TIMEOUT_MS
+#define W25QXX_DMA_TIMEOUT_MS 10000
+#endif
 
 #define W25Q80  0x4014
 #define W25Q16  0x4015
@@ -69,26 +117,118 @@ typedef struct {
 	uint8_t   Lock;
 } W25QXX_Info_t;
 
+// Upper bound for the chip to enter suspend (tSUS is 20 us)
+#ifndef W25QXX_SUSPEND_TIMEOUT_MS
+#define W25QXX_SUSPEND_TIMEOUT_MS 2
+#endif
+
+// Background program/erase state
+#define W25QXX_OP_IDLE    0
+#define W25QXX_OP_ERASE   1
+#define W25QXX_OP_PROGRAM 2
+
+// Called when a DMA read (interrupt context) or a background operation
+// (from W25QXX_Poll) has finished
+typedef void (*W25QXX_Callback)(void *ctx, bool ok);
+
 typedef struct {
     SPI_HandleTypeDef *hspi;
     GPIO_TypeDef      *CsPort;
     uint16_t          CsPin;
     W25QXX_Info_t     Info;
+
+    uint8_t           AddrBytes;    // 3, or 4 above 16 MB
+    uint8_t           FastRead;     // 1: 0x0B + dummy byte, 0: 0x03
+    uint8_t           UseDMA;       // hspi has RX and TX DMA channels
+
+    // DMA read state (shared with the completion interrupt)
+    uint8_t           *DmaBuf;      // Next chunk destination
+    uint32_t          DmaLeft;      // Bytes not yet requested
+    volatile uint8_t  Busy;
+    uint32_t          Errors;
+    W25QXX_Callback   DoneCb;
+    void              *DoneCtx;
+
+    // Background program/erase state (advanced by W25QXX_Poll)
+    uint8_t           OpState;      // W25QXX_OP_xxx
+    uint8_t           Suspended;    // Non-zero while suspended (0x75)
+    const uint8_t     *OpSrc;       // Program data not yet sent
+    uint32_t          OpAddr;
+    uint32_t          OpLeft;
+    uint8_t           OpCmd;        // Program/erase command last sent
+    uint32_t          OpBase;       // Range that command is changing
+    uint32_t          OpEnd;
+    W25QXX_Callback   OpCb;
+    void              *OpCtx;
 } W25QXX_HandleTypeDef;
 
 /* Function Prototypes */
 uint8_t W25QXX_Init(W25QXX_HandleTypeDef *hflash, SPI_HandleTypeDef *hspi, GPIO_TypeDef *cs_port, uint16_t cs_pin);
 
-void    W25QXX_Read(W25QXX_HandleTypeDef *hflash, uint8_t* pBuffer, uint32_t ReadAddr, uint32_t NumByteToRead);
+/**
+ * @brief Blocking read; suspends a background program/erase for its duration
+ * @return 1 on success, 0 if the data cannot be read yet: a chip erase is
+ *         running (it cannot be suspended), or the range overlaps the page or
+ *         sector a suspended program/erase is in the middle of
+ */
+uint8_t W25QXX_Read(W25QXX_HandleTypeDef *hflash, uint8_t* pBuffer, uint32_t ReadAddr, uint32_t NumByteToRead);
+
+/**
+ * @brief Start a read and return; cb(ctx, ok) runs from the DMA complete interrupt
+ * @note  Without DMA channels the read is done blocking and cb is called before return.
+ *        Any other call on the handle waits for the read to finish first.
+ * @return 1 if the read was started, 0 on error or when W25QXX_Read would
+ *         refuse it (cb is not called)
+ */
+uint8_t W25QXX_ReadDMA(W25QXX_HandleTypeDef *hflash, uint8_t* pBuffer, uint32_t ReadAddr, uint32_t NumByteToRead,
+                       W25QXX_Callback cb, void *ctx);
+uint8_t W25QXX_IsBusy(W25QXX_HandleTypeDef *hflash);
+void    W25QXX_Wait(W25QXX_HandleTypeDef *hflash);
 void    W25QXX_Write(W25QXX_HandleTypeDef *hflash, uint8_t* pBuffer, uint32_t WriteAddr, uint32_t NumByteToWrite);
 
 void    W25QXX_Erase_Sector(W25QXX_HandleTypeDef *hflash, uint32_t Address);
 void    W25QXX_Erase_Block(W25QXX_HandleTypeDef *hflash, uint32_t Address);
 void    W25QXX_Erase_Chip(W25QXX_HandleTypeDef *hflash); // CAUTION: Long duration
 
+/**
+ * @brief Start a program/erase and return; W25QXX_Poll() carries it on
+ * @note  One background operation at a time. WriteAsync keeps a pointer to
+ *        pBuffer until cb runs. Blocking writes/erases finish it first.
+ * @return 1 if started, 0 if another one is still running
+ */
+uint8_t W25QXX_WriteAsync(W25QXX_HandleTypeDef *hflash, const uint8_t* pBuffer, uint32_t WriteAddr, uint32_t NumByteToWrite,
+                          W25QXX_Callback cb, void *ctx);
+uint8_t W25QXX_EraseSectorAsync(W25QXX_HandleTypeDef *hflash, uint32_t Address, W25QXX_Callback cb, void *ctx);
+uint8_t W25QXX_EraseBlockAsync(W25QXX_HandleTypeDef *hflash, uint32_t Address, W25QXX_Callback cb, void *ctx);
+uint8_t W25QXX_EraseChipAsync(W25QXX_HandleTypeDef *hflash, W25QXX_Callback cb, void *ctx);
+
+/**
+ * @brief Advance the background operation: one status read, next page if due
+ * @note  Call from the main loop or a timer callback (not while another
+ *        W25QXX call is running). cb runs from here when the operation ends.
+ * @return 1 while an operation is pending, 0 when idle
+ */
+uint8_t W25QXX_Poll(W25QXX_HandleTypeDef *hflash);
+
+/**
+ * @brief Suspend the background program/erase so other commands can run
+ * @note  A chip erase cannot be suspended.
+ * @return 1 if it was suspended by this call
+ */
+uint8_t W25QXX_Suspend(W25QXX_HandleTypeDef *hflash);
+void    W25QXX_Resume(W25QXX_HandleTypeDef *hflash);
+
 uint32_t W25QXX_ReadID(W25QXX_HandleTypeDef *hflash);
 void     W25QXX_ReadUniqID(W25QXX_HandleTypeDef *hflash);
 
+/**
+ * @brief Describe an initialized chip as a Block_Device
+ * @note  read_size 1, prog_size 256, erase_size 4 KB; an erase covering
+ *        whole aligned 64 KB blocks uses 0xD8 for those.
+ * @return 0 on success, BLOCK_DEV_ERR_PARAM if the chip was not identified
+ */
+int      W25QXX_BlockDev(Block_Device *bd, W25QXX_HandleTypeDef *hflash);
+
 uint8_t  W25QXX_IsEmpty_Sector(W25QXX_HandleTypeDef *hflash, uint32_t Sector_Address, uint32_t Offset_In_Byte, uint32_t NumByteToCheck_up_to_SectorSize);
 uint8_t  W25QXX_IsEmpty_Block(W25QXX_HandleTypeDef *hflash, uint32_t Block_Address, uint32_t Offset_In_Byte, uint32_t NumByteToCheck_up_to_BlockSize);
 
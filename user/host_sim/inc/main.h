@@ -0,0 +1,11 @@
+/**
+ * @file main.h
+ * @brief Host simulation stand-in for the CubeMX/HAL header of the same name
+ */
+
+#ifndef __SIM_MAIN_H__
+#define __SIM_MAIN_H__
+
+#include "sim_hal.h"
+
+#endif /* __SIM_MAIN_H__ */
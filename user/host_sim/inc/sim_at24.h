@@ -0,0 +1,50 @@
+/**
+ * @file sim_at24.h
+ * @brief AT24Cxx I2C EEPROM model for the host simulator
+ *
+ * A write transaction with data starts the internal write cycle (tWR,
+ * 5 ms by default); until it ends the chip does not acknowledge its
+ * address, which is what ACK polling relies on. Bytes past the end of a
+ * page roll over to the start of the same page, as on the real part.
+ * A write carrying only the memory address loads the address counter
+ * for the following read. Parts of 256 bytes or less use one address
+ * byte, larger ones two; the C04-C16 block-select bits in the device
+ * address are not modelled.
+ */
+
+#ifndef __SIM_AT24_H__
+#define __SIM_AT24_H__
+
+#include "sim_hal.h"
+
+typedef struct {
+    uint64_t writes;           // Write cycles started
+    uint64_t write_bytes;
+    uint64_t reads;
+    uint64_t read_bytes;
+    uint64_t busy_nacks;       // Address not acknowledged during a write cycle
+    uint64_t page_wraps;       // Writes that rolled over a page boundary
+} Sim_AT24_Stats;
+
+typedef struct {
+    Sim_I2CDevice   i2c;           // Must stay first
+    uint8_t        *mem;
+    uint32_t        size;
+    uint16_t        page_size;
+    uint8_t         addr_bytes;
+    uint32_t        addr;          // Internal address counter
+    uint64_t        busy_until;
+    uint32_t        t_wr_us;       // Write cycle time
+    Sim_AT24_Stats  stats;
+} Sim_AT24;
+
+/**
+ * @brief Create an EEPROM model (erased to 0xFF) and attach it to an I2C bus.
+ * @param addr 8-bit device address, e.g. 0xA0
+ */
+void Sim_AT24_Init(Sim_AT24 *dev, I2C_HandleTypeDef *hi2c, uint16_t addr,
+                   uint32_t size, uint16_t page_size);
+void Sim_AT24_Free(Sim_AT24 *dev);
+bool Sim_AT24_IsBusy(const Sim_AT24 *dev);
+
+#endif /* __SIM_AT24_H__ */
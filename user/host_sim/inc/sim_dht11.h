@@ -0,0 +1,40 @@
+/**
+ * @file sim_dht11.h
+ * @brief DHT11 single-wire sensor model for the host simulator
+ *
+ * Watches the data pin: once the MCU has held it low for at least 18 ms
+ * and releases it, the model answers 30 us later with the 80 us low /
+ * 80 us high response and 40 bits (50 us low, then 27 us high for a 0 or
+ * 70 us high for a 1, MSB first), followed by a 50 us low end of frame.
+ * Edges are driven with Sim_GPIO_SetInput, so an EXTI configuration on the
+ * pin sees them as interrupts at their exact virtual time.
+ */
+
+#ifndef __SIM_DHT11_H__
+#define __SIM_DHT11_H__
+
+#include "sim_hal.h"
+
+typedef struct {
+    uint64_t starts;           // Start signals answered
+    uint64_t short_starts;     // Start signals shorter than 18 ms (ignored)
+} Sim_DHT11_Stats;
+
+typedef struct {
+    GPIO_TypeDef    *port;
+    uint16_t         pin;
+    uint8_t          data[5];      // RH int, RH dec, T int, T dec, checksum
+    bool             present;
+    bool             bad_checksum; // Corrupt the checksum of the next frames
+    /* Waveform */
+    uint64_t         low_since;
+    uint16_t         edges[84];    // Durations (us) of the alternating levels
+    uint8_t          edge_count;
+    uint8_t          edge_pos;
+    Sim_DHT11_Stats  stats;
+} Sim_DHT11;
+
+void Sim_DHT11_Init(Sim_DHT11 *dev, GPIO_TypeDef *port, uint16_t pin);
+void Sim_DHT11_Set(Sim_DHT11 *dev, uint8_t humidity, uint8_t temp_int, uint8_t temp_dec);
+
+#endif /* __SIM_DHT11_H__ */
@@ -0,0 +1,766 @@
+/**
+ * @file sim_hal.h
+ * @brief Host-side STM32 HAL simulator
+ *
+ * Provides the subset of the STM32Cube HAL that the user drivers and
+ * component ports rely on (GPIO, SPI, I2C, UART + DMA, TIM, FLASH, SysTick,
+ * PRIMASK, DWT) so they can be compiled and run as native executables.
+ *
+ * Time is virtual: a 64-bit CPU cycle counter at SystemCoreClock that only
+ * moves when the code under test calls into the HAL (blocking transfers,
+ * HAL_Delay, HAL_GetTick polling, DWT reads) or when a test calls
+ * Sim_Advance(). DMA and peripheral completions are modelled as events on
+ * that timeline; interrupt-class events are held back while PRIMASK is set,
+ * exactly like a real NVIC.
+ *
+ * Every bus handle carries a Sim_BusStats block with byte, call and cycle
+ * counters so benchmarks can report bytes/second and CPU cycles per byte.
+ */
+
+#ifndef __SIM_HAL_H__
+#define __SIM_HAL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ============================================================================
+ * Simulator Configuration
+ * ========================================================================= */
+
+#ifndef SIM_CPU_HZ
+#define SIM_CPU_HZ                72000000UL  // STM32F103 @ 72 MHz
+#endif
+
+#ifndef SIM_HAL_CALL_CYCLES
+#define SIM_HAL_CALL_CYCLES       60          // Entry/exit cost of one blocking HAL call
+#endif
+
+#ifndef SIM_POLL_CYCLES
+#define SIM_POLL_CYCLES           8           // Cost of one HAL_GetTick()/DWT poll
+#endif
+
+#ifndef SIM_SPI_DEFAULT_HZ
+#define SIM_SPI_DEFAULT_HZ        18000000UL  // SPI1 @ APB2/4
+#endif
+
+#ifndef SIM_SPI_POLL_GAP_CYCLES
+#define SIM_SPI_POLL_GAP_CYCLES   16          // Inter-byte gap of polled (non-DMA) SPI
+#endif
+
+#ifndef SIM_I2C_DEFAULT_HZ
+#define SIM_I2C_DEFAULT_HZ        400000UL
+#endif
+
+#ifndef SIM_UART_DEFAULT_BAUD
+#define SIM_UART_DEFAULT_BAUD     115200UL
+#endif
+
+#ifndef SIM_MAX_EVENTS
+#define SIM_MAX_EVENTS            128
+#endif
+
+#ifndef SIM_MAX_GPIO_WATCH
+#define SIM_MAX_GPIO_WATCH        32
+#endif
+
+/* ============================================================================
+ * Generic HAL Definitions
+ * ========================================================================= */
+
+typedef enum {
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum { RESET = 0U, SET = !RESET } FlagStatus, ITStatus;
+typedef enum { DISABLE = 0U, ENABLE = !DISABLE } FunctionalState;
+
+#define HAL_MAX_DELAY   0xFFFFFFFFU
+
+#ifndef __weak
+#define __weak          __attribute__((weak))
+#endif
+#ifndef __IO
+#define __IO            volatile
+#endif
+#ifndef UNUSED
+#define UNUSED(X)       (void)(X)
+#endif
+#ifndef __ALIGNED
+#define __ALIGNED(x)    __attribute__((aligned(x)))
+#endif
+
+/* ============================================================================
+ * Simulator Core (virtual time, events, statistics)
+ * ========================================================================= */
+
+typedef void (*Sim_EventFn)(void *ctx);
+
+typedef struct {
+    uint64_t tx_bytes;         // Bytes driven out by the MCU
+    uint64_t rx_bytes;         // Bytes sampled by the MCU
+    uint64_t calls;            // HAL entry points invoked
+    uint64_t transactions;     // Chip-select / start-stop framed transactions
+    uint64_t dma_transfers;    // DMA requests started
+    uint64_t blocking_cycles;  // CPU cycles spent inside blocking HAL calls
+    uint64_t bus_cycles;       // Cycles the wire was actually clocking data
+} Sim_BusStats;
+
+typedef struct {
+    uint64_t irq_disable_count;   // __disable_irq / __set_PRIMASK(1) transitions
+    uint64_t irq_off_cycles;      // Total virtual cycles with PRIMASK set
+    uint64_t irq_off_max_cycles;  // Longest single PRIMASK window (virtual)
+    uint64_t irq_off_max_ns;      // Longest single PRIMASK window (host time)
+    uint64_t isr_count;           // Interrupt-class events dispatched
+    uint64_t isr_deferred;        // Interrupts held back by PRIMASK
+} Sim_CpuStats;
+
+extern uint32_t SystemCoreClock;
+
+void     Sim_Reset(void);
+uint64_t Sim_Now(void);
+uint64_t Sim_UsToCycles(uint32_t us);
+double   Sim_CyclesToUs(uint64_t cycles);
+void     Sim_Advance(uint64_t cycles);
+void     Sim_AdvanceUs(uint32_t us);
+bool     Sim_RunNext(void);
+void     Sim_RunUntilIdle(uint64_t max_cycles);
+bool     Sim_Schedule(uint64_t delay_cycles, Sim_EventFn fn, void *ctx, bool irq);
+void     Sim_Cancel(Sim_EventFn fn, void *ctx);
+bool     Sim_InIsr(void);
+
+Sim_CpuStats *Sim_GetCpuStats(void);
+void     Sim_ResetStats(void);
+uint64_t Sim_HostNs(void);
+
+/* ============================================================================
+ * Cortex-M Core (PRIMASK, DWT, CoreDebug)
+ * ========================================================================= */
+
+uint32_t __get_PRIMASK(void);
+void     __set_PRIMASK(uint32_t priMask);
+void     __disable_irq(void);
+void     __enable_irq(void);
+/** Active exception number: non-zero inside a simulated interrupt. */
+uint32_t __get_IPSR(void);
+
+#define __NOP()  ((void)0)
+#define __DSB()  ((void)0)
+#define __DMB()  ((void)0)
+#define __ISB()  ((void)0)
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+DWT_Type *Sim_DWT(void);
+extern CoreDebug_Type Sim_CoreDebug;
+
+#define DWT                          (Sim_DWT())
+#define CoreDebug                    (&Sim_CoreDebug)
+#define DWT_CTRL_CYCCNTENA_Msk       (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk   (1UL << 24)
+
+typedef int IRQn_Type;
+#define HAL_NVIC_SetPriority(irq, pre, sub)  ((void)(irq), (void)(pre), (void)(sub))
+#define HAL_NVIC_EnableIRQ(irq)              ((void)(irq))
+#define HAL_NVIC_DisableIRQ(irq)             ((void)(irq))
+
+/* ============================================================================
+ * System / RCC / SysTick
+ * ========================================================================= */
+
+uint32_t HAL_GetTick(void);
+void     HAL_Delay(uint32_t Delay);
+void     HAL_IncTick(void);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOD_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_DMA1_CLK_ENABLE()   ((void)0)
+#define __HAL_RCC_DMA2_CLK_ENABLE()   ((void)0)
+
+/* ============================================================================
+ * GPIO
+ * ========================================================================= */
+
+typedef struct {
+    volatile uint32_t IDR;
+    volatile uint32_t ODR;
+    uint32_t          mode[16];   // Last GPIO_InitTypeDef.Mode per pin
+    uint32_t          exti[16];   // EXTI trigger (IT mode); as on the target, only
+                                  // HAL_GPIO_DeInit clears it, not a later Init
+    const char       *name;
+} GPIO_TypeDef;
+
+typedef enum { GPIO_PIN_RESET = 0U, GPIO_PIN_SET } GPIO_PinState;
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_0    ((uint16_t)0x0001)
+#define GPIO_PIN_1    ((uint16_t)0x0002)
+#define GPIO_PIN_2    ((uint16_t)0x0004)
+#define GPIO_PIN_3    ((uint16_t)0x0008)
+#define GPIO_PIN_4    ((uint16_t)0x0010)
+#define GPIO_PIN_5    ((uint16_t)0x0020)
+#define GPIO_PIN_6    ((uint16_t)0x0040)
+#define GPIO_PIN_7    ((uint16_t)0x0080)
+#define GPIO_PIN_8    ((uint16_t)0x0100)
+#define GPIO_PIN_9    ((uint16_t)0x0200)
+#define GPIO_PIN_10   ((uint16_t)0x0400)
+#define GPIO_PIN_11   ((uint16_t)0x0800)
+#define GPIO_PIN_12   ((uint16_t)0x1000)
+#define GPIO_PIN_13   ((uint16_t)0x2000)
+#define GPIO_PIN_14   ((uint16_t)0x4000)
+#define GPIO_PIN_15   ((uint16_t)0x8000)
+#define GPIO_PIN_All  ((uint16_t)0xFFFF)
+
+#define GPIO_MODE_INPUT              0x00000000U
+#define GPIO_MODE_OUTPUT_PP          0x00000001U
+#define GPIO_MODE_OUTPUT_OD          0x00000011U
+#define GPIO_MODE_AF_PP              0x00000002U
+#define GPIO_MODE_AF_OD              0x00000012U
+#define GPIO_MODE_AF_INPUT           GPIO_MODE_INPUT
+#define GPIO_MODE_ANALOG             0x00000003U
+#define GPIO_MODE_IT_RISING          0x10110000U
+#define GPIO_MODE_IT_FALLING         0x10210000U
+#define GPIO_MODE_IT_RISING_FALLING  0x10310000U
+
+#define GPIO_NOPULL    0x00000000U
+#define GPIO_PULLUP    0x00000001U
+#define GPIO_PULLDOWN  0x00000002U
+
+#define GPIO_SPEED_FREQ_LOW        0x00000002U
+#define GPIO_SPEED_FREQ_MEDIUM     0x00000001U
+#define GPIO_SPEED_FREQ_HIGH       0x00000003U
+#define GPIO_SPEED_FREQ_VERY_HIGH  0x00000003U
+
+extern GPIO_TypeDef Sim_GPIOA, Sim_GPIOB, Sim_GPIOC, Sim_GPIOD, Sim_GPIOE;
+#define GPIOA  (&Sim_GPIOA)
+#define GPIOB  (&Sim_GPIOB)
+#define GPIOC  (&Sim_GPIOC)
+#define GPIOD  (&Sim_GPIOD)
+#define GPIOE  (&Sim_GPIOE)
+
+void          HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void          HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void          HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void          HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void          HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+
+typedef void (*Sim_GPIOWatchFn)(void *ctx, GPIO_PinState state);
+
+/** Called on every MCU-driven level change of the pin. */
+bool Sim_GPIO_Watch(GPIO_TypeDef *port, uint16_t pin, Sim_GPIOWatchFn fn, void *ctx);
+/** Drive an input pin from the outside world (fires EXTI if configured). */
+void Sim_GPIO_SetInput(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+
+/* ============================================================================
+ * DMA
+ * ========================================================================= */
+
+#define DMA_NORMAL    0x00000000U
+#define DMA_CIRCULAR  0x00000020U
+
+#define DMA_MDATAALIGN_BYTE      0x00000000U
+#define DMA_MDATAALIGN_HALFWORD  0x00000400U
+#define DMA_MDATAALIGN_WORD      0x00000800U
+
+#define DMA_IT_TC     0x00000002U
+#define DMA_IT_HT     0x00000004U
+#define DMA_IT_TE     0x00000008U
+
+typedef enum {
+    HAL_DMA_STATE_RESET = 0x00U,
+    HAL_DMA_STATE_READY = 0x01U,
+    HAL_DMA_STATE_BUSY  = 0x02U
+} HAL_DMA_StateTypeDef;
+
+typedef struct {
+    uint32_t Direction;
+    uint32_t PeriphInc;
+    uint32_t MemInc;
+    uint32_t PeriphDataAlignment;
+    uint32_t MemDataAlignment;
+    uint32_t Mode;
+    uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef struct __DMA_HandleTypeDef {
+    void                 *Instance;
+    DMA_InitTypeDef       Init;
+    HAL_DMA_StateTypeDef  State;
+    void                 *Parent;
+    uint32_t              ErrorCode;
+    uint32_t              it_enabled;  // Simulated CCR interrupt enable bits
+    volatile uint32_t     counter;     // Simulated CNDTR / NDTR
+} DMA_HandleTypeDef;
+
+#define __HAL_DMA_GET_COUNTER(h)       ((h)->counter)
+#define __HAL_DMA_ENABLE_IT(h, it)     ((h)->it_enabled |= (it))
+#define __HAL_DMA_DISABLE_IT(h, it)    ((h)->it_enabled &= ~(it))
+
+/* ============================================================================
+ * SPI
+ * ========================================================================= */
+
+typedef enum {
+    HAL_SPI_STATE_RESET      = 0x00U,
+    HAL_SPI_STATE_READY      = 0x01U,
+    HAL_SPI_STATE_BUSY       = 0x02U,
+    HAL_SPI_STATE_BUSY_TX    = 0x03U,
+    HAL_SPI_STATE_BUSY_RX    = 0x04U,
+    HAL_SPI_STATE_BUSY_TX_RX = 0x05U,
+    HAL_SPI_STATE_ERROR      = 0x06U
+} HAL_SPI_StateTypeDef;
+
+typedef struct {
+    uint32_t Mode;
+    uint32_t Direction;
+    uint32_t DataSize;
+    uint32_t CLKPolarity;
+    uint32_t CLKPhase;
+    uint32_t NSS;
+    uint32_t BaudRatePrescaler;
+    uint32_t FirstBit;
+} SPI_InitTypeDef;
+
+struct Sim_SPIDevice;
+
+typedef struct {
+    uint32_t               hz;          // Bit clock (0 = SIM_SPI_DEFAULT_HZ)
+    struct Sim_SPIDevice  *devices;     // Slaves attached to this bus
+    const uint8_t         *dma_tx;      // In-flight DMA descriptors
+    uint8_t               *dma_rx;
+    uint16_t               dma_len;
+    uint8_t                dma_op;
+    Sim_BusStats           stats;
+} Sim_SPIBus;
+
+typedef struct __SPI_HandleTypeDef {
+    void                       *Instance;
+    SPI_InitTypeDef             Init;
+    volatile HAL_SPI_StateTypeDef State;
+    volatile uint32_t           ErrorCode;
+    DMA_HandleTypeDef          *hdmatx;
+    DMA_HandleTypeDef          *hdmarx;
+    Sim_SPIBus                  sim;
+} SPI_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi);
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi);
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi);
+
+/**
+ * @brief SPI slave model. Embed as the first member of a device struct.
+ *        The simulator watches the CS pin and routes every byte clocked
+ *        while CS is low through exchange().
+ */
+typedef struct Sim_SPIDevice {
+    GPIO_TypeDef          *cs_port;
+    uint16_t               cs_pin;
+    void                 (*select)(struct Sim_SPIDevice *dev, bool selected);
+    uint8_t              (*exchange)(struct Sim_SPIDevice *dev, uint8_t mosi);
+    SPI_HandleTypeDef     *bus;
+    bool                   selected;
+    struct Sim_SPIDevice  *next;
+} Sim_SPIDevice;
+
+void          Sim_SPI_Attach(SPI_HandleTypeDef *hspi, Sim_SPIDevice *dev);
+void          Sim_SPI_SetClock(SPI_HandleTypeDef *hspi, uint32_t hz);
+Sim_BusStats *Sim_SPI_Stats(SPI_HandleTypeDef *hspi);
+
+/* ============================================================================
+ * I2C
+ * ========================================================================= */
+
+#define I2C_MEMADD_SIZE_8BIT   0x00000001U
+#define I2C_MEMADD_SIZE_16BIT  0x00000010U
+
+typedef enum {
+    HAL_I2C_STATE_RESET   = 0x00U,
+    HAL_I2C_STATE_READY   = 0x20U,
+    HAL_I2C_STATE_BUSY    = 0x24U,
+    HAL_I2C_STATE_BUSY_TX = 0x21U,
+    HAL_I2C_STATE_BUSY_RX = 0x22U
+} HAL_I2C_StateTypeDef;
+
+#define HAL_I2C_ERROR_NONE  0x00000000U
+#define HAL_I2C_ERROR_AF    0x00000004U
+
+typedef struct {
+    uint32_t ClockSpeed;
+    uint32_t DutyCycle;
+    uint32_t OwnAddress1;
+    uint32_t AddressingMode;
+} I2C_InitTypeDef;
+
+struct Sim_I2CDevice;
+
+typedef struct {
+    uint32_t               hz;
+    struct Sim_I2CDevice  *devices;
+    Sim_BusStats           stats;
+    uint8_t                scratch[1040];
+    uint16_t               pending_addr;   // In-flight IT/DMA transfer
+    uint8_t               *pending_rx;
+    uint16_t               pending_len;
+    uint8_t                pending_op;
+} Sim_I2CBus;
+
+typedef struct __I2C_HandleTypeDef {
+    void                         *Instance;
+    I2C_InitTypeDef               Init;
+    volatile HAL_I2C_StateTypeDef State;
+    volatile uint32_t             ErrorCode;
+    DMA_HandleTypeDef            *hdmatx;
+    DMA_HandleTypeDef            *hdmarx;
+    Sim_I2CBus                    sim;
+} I2C_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout);
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c);
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief I2C slave model. addr is the 8-bit (left-shifted) address used by
+ *        the HAL API. write() receives the whole write phase (including any
+ *        memory address bytes); returning false NACKs the transfer.
+ */
+typedef struct Sim_I2CDevice {
+    uint16_t               addr;
+    bool                 (*ack)(struct Sim_I2CDevice *dev);
+    bool                 (*write)(struct Sim_I2CDevice *dev, const uint8_t *data, uint16_t len);
+    bool                 (*read)(struct Sim_I2CDevice *dev, uint8_t *data, uint16_t len);
+    struct Sim_I2CDevice  *next;
+} Sim_I2CDevice;
+
+void          Sim_I2C_Attach(I2C_HandleTypeDef *hi2c, Sim_I2CDevice *dev);
+Sim_BusStats *Sim_I2C_Stats(I2C_HandleTypeDef *hi2c);
+
+/* ============================================================================
+ * UART
+ * ========================================================================= */
+
+typedef enum {
+    HAL_UART_STATE_RESET      = 0x00U,
+    HAL_UART_STATE_READY      = 0x20U,
+    HAL_UART_STATE_BUSY       = 0x24U,
+    HAL_UART_STATE_BUSY_TX    = 0x21U,
+    HAL_UART_STATE_BUSY_RX    = 0x22U,
+    HAL_UART_STATE_BUSY_TX_RX = 0x23U,
+    HAL_UART_STATE_ERROR      = 0xE0U
+} HAL_UART_StateTypeDef;
+
+#define HAL_UART_ERROR_NONE  0x00000000U
+#define HAL_UART_ERROR_PE    0x00000001U
+#define HAL_UART_ERROR_NE    0x00000002U
+#define HAL_UART_ERROR_FE    0x00000004U
+#define HAL_UART_ERROR_ORE   0x00000008U
+#define HAL_UART_ERROR_DMA   0x00000010U
+
+#define UART_FLAG_TXE   0x00000080U
+#define UART_FLAG_TC    0x00000040U
+#define UART_FLAG_RXNE  0x00000020U
+#define UART_FLAG_IDLE  0x00000010U
+
+#define UART_IT_IDLE    0x00000010U
+#define UART_IT_TC      0x00000040U
+
+#define HAL_UART_RECEPTION_STANDARD  0x00000000U
+#define HAL_UART_RECEPTION_TOIDLE    0x00000001U
+
+typedef struct {
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef struct {
+    Sim_BusStats   stats;
+    uint32_t       rx_dropped;      // Bytes that arrived with no reception armed
+    uint16_t       rx_pos;          // DMA write index
+    uint16_t       rx_size;         // Armed reception length
+    uint8_t       *rx_buf;
+    uint8_t        rx_mode;         // Internal: none / blocking fifo / DMA
+    uint8_t       *wire;            // Bytes still "on the wire" towards the MCU
+    uint32_t       wire_len;
+    uint32_t       wire_pos;
+    uint32_t       wire_cap;
+    uint8_t        fifo[256];       // Receiver holding area for polled reads
+    uint16_t       fifo_head;
+    uint16_t       fifo_tail;
+    const uint8_t *tx_ptr;          // In-flight DMA TX
+    uint16_t       tx_len;
+    uint8_t       *tx_log;          // Everything the MCU transmitted
+    uint32_t       tx_log_len;
+    uint32_t       tx_log_cap;
+    void         (*tx_sink)(void *ctx, const uint8_t *data, uint16_t len);
+    void          *tx_sink_ctx;
+    uint8_t      (*line)(void *ctx, uint8_t tx);
+    void          *line_ctx;
+} Sim_UARTPort;
+
+typedef struct __UART_HandleTypeDef {
+    void                           *Instance;
+    UART_InitTypeDef                Init;
+    volatile HAL_UART_StateTypeDef  gState;
+    volatile HAL_UART_StateTypeDef  RxState;
+    volatile uint32_t               ErrorCode;
+    volatile uint32_t               ReceptionType;
+    DMA_HandleTypeDef              *hdmatx;
+    DMA_HandleTypeDef              *hdmarx;
+    Sim_UARTPort                    sim;
+} UART_HandleTypeDef;
+
+#define __HAL_UART_CLEAR_OREFLAG(h)   ((void)(h))
+#define __HAL_UART_CLEAR_NEFLAG(h)    ((void)(h))
+#define __HAL_UART_CLEAR_FEFLAG(h)    ((void)(h))
+#define __HAL_UART_CLEAR_PEFLAG(h)    ((void)(h))
+#define __HAL_UART_CLEAR_IDLEFLAG(h)  ((void)(h))
+#define __HAL_UART_GET_FLAG(h, flag)  (Sim_UART_GetFlag((h), (flag)) ? SET : RESET)
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_HalfDuplex_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+
+/** Queue bytes on the wire; they land in the MCU one char time apart. */
+void     Sim_UART_Inject(UART_HandleTypeDef *huart, const uint8_t *data, uint32_t len);
+/** Raise a line error (HAL_UART_ERROR_xxx) and run the error path. */
+void     Sim_UART_RaiseError(UART_HandleTypeDef *huart, uint32_t error);
+/** Copy and consume up to max bytes of captured MCU output. */
+uint32_t Sim_UART_TakeTx(UART_HandleTypeDef *huart, uint8_t *out, uint32_t max);
+/** Forward MCU output (in addition to the capture log). */
+void     Sim_UART_SetTxSink(UART_HandleTypeDef *huart, void (*sink)(void *ctx, const uint8_t *data, uint16_t len), void *ctx);
+/** Half-duplex line: every transmitted char is also received, as fn returns it
+ *  (the char seen on the wire, e.g. with bits pulled low by open-drain slaves). */
+void     Sim_UART_SetLine(UART_HandleTypeDef *huart, uint8_t (*fn)(void *ctx, uint8_t tx), void *ctx);
+uint64_t Sim_UART_CharCycles(UART_HandleTypeDef *huart);
+bool     Sim_UART_GetFlag(UART_HandleTypeDef *huart, uint32_t flag);
+Sim_BusStats *Sim_UART_Stats(UART_HandleTypeDef *huart);
+
+/* ============================================================================
+ * TIM
+ * ========================================================================= */
+
+#define TIM_CHANNEL_1    0x00000000U
+#define TIM_CHANNEL_2    0x00000004U
+#define TIM_CHANNEL_3    0x00000008U
+#define TIM_CHANNEL_4    0x0000000CU
+#define TIM_CHANNEL_ALL  0x0000003CU
+
+typedef enum {
+    HAL_TIM_ACTIVE_CHANNEL_1       = 0x01U,
+    HAL_TIM_ACTIVE_CHANNEL_2       = 0x02U,
+    HAL_TIM_ACTIVE_CHANNEL_3       = 0x04U,
+    HAL_TIM_ACTIVE_CHANNEL_4       = 0x08U,
+    HAL_TIM_ACTIVE_CHANNEL_CLEARED = 0x00U
+} HAL_TIM_ActiveChannel;
+
+typedef enum {
+    HAL_TIM_STATE_RESET = 0x00U,
+    HAL_TIM_STATE_READY = 0x01U,
+    HAL_TIM_STATE_BUSY  = 0x02U
+} HAL_TIM_StateTypeDef;
+
+typedef struct {
+    volatile uint32_t CNT;
+    volatile uint32_t PSC;
+    volatile uint32_t ARR;
+    volatile uint32_t CCR1;
+    volatile uint32_t CCR2;
+    volatile uint32_t CCR3;
+    volatile uint32_t CCR4;
+} TIM_TypeDef;
+
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t ClockDivision;
+    uint32_t RepetitionCounter;
+    uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+    bool               running;
+    bool               update_it;
+    uint64_t           start;          // Cycle at which CNT was last zero
+    uint32_t           running_ch;     // Bitmask of started PWM/IC channels
+    const uint32_t    *dma_src[4];     // PWM DMA source per channel
+    uint16_t           dma_len[4];
+    uint16_t           dma_pos[4];
+    uint8_t            dma_width[4];
+    void             (*pwm_sink[4])(void *ctx, uint32_t ccr);
+    void              *pwm_sink_ctx[4];
+    Sim_BusStats       stats;
+} Sim_TIMState;
+
+typedef struct __TIM_HandleTypeDef {
+    TIM_TypeDef              *Instance;
+    TIM_Base_InitTypeDef      Init;
+    HAL_TIM_ActiveChannel     Channel;
+    DMA_HandleTypeDef        *hdma[7];
+    volatile HAL_TIM_StateTypeDef State;
+    Sim_TIMState              sim;
+} TIM_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef *htim, uint32_t Channel, const uint32_t *pData, uint16_t Length);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_IC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_IC_Stop_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+uint32_t          HAL_TIM_ReadCapturedValue(TIM_HandleTypeDef *htim, uint32_t Channel);
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim);
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim);
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim);
+
+uint32_t Sim_TIM_GetCounter(TIM_HandleTypeDef *htim);
+void     Sim_TIM_SetCounter(TIM_HandleTypeDef *htim, uint32_t value);
+/** Latch the current counter into CCRx and fire the capture interrupt. */
+void     Sim_TIM_Capture(TIM_HandleTypeDef *htim, uint32_t Channel);
+Sim_BusStats *Sim_TIM_Stats(TIM_HandleTypeDef *htim);
+/** Called with the compare value of every PWM period the channel's DMA loads. */
+void     Sim_TIM_SetPwmSink(TIM_HandleTypeDef *htim, uint32_t Channel,
+                            void (*sink)(void *ctx, uint32_t ccr), void *ctx);
+
+#define __HAL_TIM_GET_COUNTER(h)          Sim_TIM_GetCounter(h)
+#define __HAL_TIM_SET_COUNTER(h, v)       Sim_TIM_SetCounter((h), (v))
+#define __HAL_TIM_GET_AUTORELOAD(h)       ((h)->Instance->ARR)
+#define __HAL_TIM_SET_AUTORELOAD(h, v)    ((h)->Instance->ARR = (v), (h)->Init.Period = (v))
+#define __HAL_TIM_SET_PRESCALER(h, v)     ((h)->Instance->PSC = (v))
+#define __HAL_TIM_SET_COMPARE(h, ch, v)   (*Sim_TIM_CCR((h), (ch)) = (v))
+#define __HAL_TIM_GET_COMPARE(h, ch)      (*Sim_TIM_CCR((h), (ch)))
+volatile uint32_t *Sim_TIM_CCR(TIM_HandleTypeDef *htim, uint32_t Channel);
+
+/* ============================================================================
+ * FLASH (STM32F1 internal flash: halfword programming, 1 KB pages)
+ * ========================================================================= */
+
+#ifndef SIM_FLASH_SIZE
+#define SIM_FLASH_SIZE            (64U * 1024U)   // STM32F103C8
+#endif
+
+#define FLASH_BASE                0x08000000UL
+#define FLASH_PAGE_SIZE           0x400U
+
+#define FLASH_TYPEPROGRAM_HALFWORD   0x01U
+#define FLASH_TYPEPROGRAM_WORD       0x02U
+#define FLASH_TYPEPROGRAM_DOUBLEWORD 0x03U
+
+#define FLASH_TYPEERASE_PAGES     0x00U
+#define FLASH_TYPEERASE_MASSERASE 0x02U
+#define FLASH_BANK_1              0x01U
+
+#define HAL_FLASH_ERROR_NONE      0x00U
+#define HAL_FLASH_ERROR_PROG      0x01U   // PGERR: target halfword not erased
+#define HAL_FLASH_ERROR_WRP       0x02U   // Flash locked or outside the array
+
+typedef struct {
+    uint32_t TypeErase;
+    uint32_t Banks;
+    uint32_t PageAddress;
+    uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+typedef struct {
+    uint64_t halfwords;        // Halfwords programmed
+    uint64_t page_erases;
+    uint64_t prog_errors;      // PGERR
+    uint64_t wrp_errors;       // Locked / out of range
+    uint64_t dropped;          // Operations lost to a simulated power failure
+} Sim_FlashStats;
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError);
+uint32_t          HAL_FLASH_GetError(void);
+
+/**
+ * Map the flash array at FLASH_BASE (so memory-mapped reads work as on the
+ * MCU) and fill it with 0xFF. Contents survive Sim_Reset(), like real flash.
+ * Timings: 52 us per halfword, 20 ms per page erase, CPU stalled meanwhile.
+ */
+void Sim_Flash_Init(void);
+Sim_FlashStats *Sim_Flash_Stats(void);
+/**
+ * Cut power after `ops` more halfword programs / page erases: every later
+ * operation is dropped, and an erase that is cut only clears the first half
+ * of its page. Sim_Flash_PowerRestore() ends the outage.
+ */
+void Sim_Flash_PowerFailAfter(uint32_t ops);
+void Sim_Flash_PowerRestore(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_HAL_H__ */
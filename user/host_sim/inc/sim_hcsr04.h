@@ -0,0 +1,37 @@
+/**
+ * @file sim_hcsr04.h
+ * @brief HC-SR04 ultrasonic ranger model for the host simulator
+ *
+ * A trigger pulse of at least 10 us starts a measurement on its falling
+ * edge: after the 40 kHz burst (about 450 us) the echo pin goes high for
+ * the round-trip time, distance_cm / 0.017 us, or 38 ms when nothing is in
+ * range. Triggers that arrive while a measurement is running are ignored,
+ * as on the module.
+ */
+
+#ifndef __SIM_HCSR04_H__
+#define __SIM_HCSR04_H__
+
+#include "sim_hal.h"
+
+typedef struct {
+    uint64_t measurements;
+    uint64_t short_triggers;   // Trigger pulses below 10 us
+    uint64_t busy_triggers;    // Triggers during a measurement
+} Sim_HCSR04_Stats;
+
+typedef struct {
+    GPIO_TypeDef     *trig_port;
+    uint16_t          trig_pin;
+    GPIO_TypeDef     *echo_port;
+    uint16_t          echo_pin;
+    float             distance_cm;  // <= 0: no echo
+    uint64_t          trig_since;
+    bool              busy;
+    Sim_HCSR04_Stats  stats;
+} Sim_HCSR04;
+
+void Sim_HCSR04_Init(Sim_HCSR04 *dev, GPIO_TypeDef *trig_port, uint16_t trig_pin,
+                     GPIO_TypeDef *echo_port, uint16_t echo_pin);
+
+#endif /* __SIM_HCSR04_H__ */
@@ -0,0 +1,74 @@
+/**
+ * @file sim_onewire.h
+ * @brief 1-Wire bus with DS18B20 models for the host simulator
+ *
+ * The bus sits on a half-duplex UART (Sim_UART_SetLine) and decodes the
+ * chars the MCU sends the way the wire would see them: a char sent below
+ * 20000 baud is a reset pulse, answered with a presence pulse (echo 0xE0)
+ * when a device is attached; at slot speed 0xFF is a write-1 / read slot
+ * and anything else a write-0 slot. Every device drives the slot it is
+ * sending in, open-drain, so the wired-AND of all outputs is what the
+ * master reads back (0xF8 when a slave pulled the line low).
+ *
+ * Devices implement Read / Match / Skip ROM, Search ROM and Alarm Search.
+ * DS18B20 models (family 0x28) also implement Convert T (read slots return
+ * 0 until the conversion time for the configured resolution has passed),
+ * Read / Write Scratchpad and Read Power Supply; other families only take
+ * part in ROM commands. Power-up scratchpad reads 85 degrees C.
+ */
+
+#ifndef __SIM_ONEWIRE_H__
+#define __SIM_ONEWIRE_H__
+
+#include "sim_hal.h"
+
+#define SIM_ONEWIRE_MAX_DEVICES  16
+
+typedef struct {
+    uint64_t resets;
+    uint64_t presences;        // Resets answered by at least one device
+    uint64_t slots;
+    uint64_t converts;         // Convert T started, per device
+    uint64_t sp_reads;         // Read Scratchpad commands, per device
+} Sim_OneWire_Stats;
+
+typedef struct {
+    uint8_t   rom[8];          // Family, 48-bit serial, CRC
+    bool      present;         // Clear to unplug
+    int16_t   temp;            // Temperature seen by the sensor, 1/16 degree C
+    uint8_t   scratch[9];
+    uint64_t  conv_until;      // Conversion in progress until then (0: none)
+    bool      alarm;           // Last conversion was above TH or at/below TL
+    uint32_t  crc_faults;      // Corrupt this many scratchpad reads
+    /* Protocol state */
+    uint8_t   state;
+    uint16_t  bit;             // Bit position in the current state
+    uint8_t   shift[9];
+    uint8_t   search_phase;    // 0: id bit, 1: complement, 2: direction
+} Sim_DS18B20;
+
+typedef struct {
+    UART_HandleTypeDef *huart;
+    Sim_DS18B20         dev[SIM_ONEWIRE_MAX_DEVICES];
+    uint8_t             count;
+    Sim_OneWire_Stats   stats;
+} Sim_OneWire;
+
+/**
+ * @brief Attach an empty bus to a UART (its half-duplex line)
+ */
+void Sim_OneWire_Init(Sim_OneWire *bus, UART_HandleTypeDef *huart);
+
+/**
+ * @brief Plug a device in; the ROM CRC is computed here
+ * @param family 0x28 for a DS18B20, anything else for a ROM-only device
+ * @return The device, NULL if the bus is full
+ */
+Sim_DS18B20 *Sim_OneWire_AddDevice(Sim_OneWire *bus, uint8_t family, uint64_t serial);
+
+/**
+ * @brief Temperature the next conversion measures, degrees C
+ */
+void Sim_DS18B20_SetTemp(Sim_DS18B20 *dev, float celsius);
+
+#endif /* __SIM_ONEWIRE_H__ */
@@ -0,0 +1,54 @@
+/**
+ * @file sim_panel.h
+ * @brief MIPI-DCS SPI TFT panel model (ILI9341 / ILI9488 / ST7735 / ST7789)
+ *
+ * Decodes the 4-wire SPI protocol (D/C pin sampled per byte): CASET,
+ * PASET/RASET, RAMWR, MADCTL and COLMOD. RGB565 pixels written through
+ * RAMWR land in a framebuffer so tests can check what is actually on the
+ * glass, and counters expose command/data overhead per frame.
+ */
+
+#ifndef __SIM_PANEL_H__
+#define __SIM_PANEL_H__
+
+#include "sim_hal.h"
+
+typedef struct {
+    uint64_t commands;
+    uint64_t data_bytes;
+    uint64_t pixels;
+    uint64_t window_sets;     // CASET + PASET pairs
+    uint64_t ramwr;
+    uint64_t out_of_window;   // Pixels written past the window end
+} Sim_Panel_Stats;
+
+typedef struct {
+    Sim_SPIDevice    spi;       // Must stay first
+    GPIO_TypeDef    *dc_port;
+    uint16_t         dc_pin;
+    uint16_t         width;     // Native (MADCTL = 0) geometry
+    uint16_t         height;
+    uint8_t          bytes_per_pixel; // 2 = RGB565, 3 = RGB666
+    uint16_t        *fb;
+    uint8_t          madctl;
+    uint8_t          colmod;
+    /* Decoder state */
+    uint8_t          cmd;
+    uint8_t          param[4];
+    uint8_t          param_pos;
+    uint16_t         xs, xe, ys, ye;
+    uint16_t         cx, cy;
+    uint8_t          pix[3];
+    uint8_t          pix_pos;
+    Sim_Panel_Stats  stats;
+} Sim_Panel;
+
+void     Sim_Panel_Init(Sim_Panel *p, SPI_HandleTypeDef *hspi,
+                        GPIO_TypeDef *cs_port, uint16_t cs_pin,
+                        GPIO_TypeDef *dc_port, uint16_t dc_pin,
+                        uint16_t width, uint16_t height);
+void     Sim_Panel_Free(Sim_Panel *p);
+/** Read back a pixel in the current (MADCTL) addressing space. */
+uint16_t Sim_Panel_GetPixel(const Sim_Panel *p, uint16_t x, uint16_t y);
+
+#endif /* __SIM_PANEL_H__ */
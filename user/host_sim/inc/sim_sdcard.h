@@ -0,0 +1,81 @@
+/**
+ * @file sim_sdcard.h
+ * @brief SD card (SPI mode) model for the host simulator
+ *
+ * Byte-accurate SPI-mode protocol: command frames, R1/R2/R3/R7 responses
+ * with Ncr delay, data tokens 0xFE/0xFC/0xFD, data response 0x05 and busy
+ * signalling (MISO held low). Read access latency and programming time are
+ * virtual-time based, so a driver that polls less or pipelines more gets
+ * measurably higher throughput.
+ *
+ * ACMD23 pre-erases: blocks announced for the next CMD25 that the stream
+ * does not write are erased (zeroed) when it stops, the worst case a real
+ * card is allowed.
+ */
+
+#ifndef __SIM_SDCARD_H__
+#define __SIM_SDCARD_H__
+
+#include "sim_hal.h"
+
+#define SIM_SD_BLOCK_SIZE  512U
+
+typedef struct {
+    uint64_t commands;
+    uint64_t cmd17;            // Single block reads
+    uint64_t cmd18;            // Multi block reads
+    uint64_t cmd24;            // Single block writes
+    uint64_t cmd25;            // Multi block writes
+    uint64_t cmd12;            // Stop transmission
+    uint64_t acmd23;           // Pre-erase hints
+    uint64_t blocks_pre_erased; // Announced by ACMD23 but never written
+    uint64_t blocks_read;
+    uint64_t blocks_written;
+    uint64_t busy_polls;       // Bytes clocked while the card was busy
+    uint64_t protocol_errors;  // Unexpected bytes / illegal commands
+} Sim_SDCard_Stats;
+
+typedef struct {
+    Sim_SPIDevice     spi;         // Must stay first
+    uint8_t          *mem;
+    uint32_t          blocks;
+    bool              sdhc;        // Block addressing (CCS=1)
+    bool              idle;        // In idle state (before ACMD41 completes)
+    uint8_t           acmd41_polls;
+    bool              app_cmd;
+    /* Command decoder */
+    uint8_t           frame[6];
+    uint8_t           frame_pos;
+    /* Output queue */
+    uint8_t           out[SIM_SD_BLOCK_SIZE + 32];
+    uint16_t          out_head;
+    uint16_t          out_tail;
+    /* Data phase */
+    uint8_t           state;
+    uint32_t          block;
+    uint64_t          ready_at;
+    uint64_t          busy_until;
+    uint16_t          data_pos;
+    uint8_t           data[SIM_SD_BLOCK_SIZE + 2];
+    bool              multi;
+    uint32_t          pre_erase;     // ACMD23 count for the next CMD25
+    uint32_t          pre_erase_end; // First block past the announced range
+    Sim_SDCard_Stats  stats;
+    /* Timings in microseconds */
+    uint32_t          t_read_first_us;   // NAC before first data token
+    uint32_t          t_read_next_us;    // Gap between blocks in CMD18
+    uint32_t          t_write_single_us; // Busy after CMD24 data
+    uint32_t          t_write_multi_us;  // Busy per block inside CMD25
+    uint32_t          t_stop_us;         // Busy after CMD12 / stop token
+} Sim_SDCard;
+
+void Sim_SDCard_Init(Sim_SDCard *card, SPI_HandleTypeDef *hspi,
+                     GPIO_TypeDef *cs_port, uint16_t cs_pin, uint32_t blocks, bool sdhc);
+void Sim_SDCard_Free(Sim_SDCard *card);
+
+/* Card contents from / to a raw image file (dd of a real card, or a file to
+ * inspect with mtools / loop mount). A short image leaves the rest zeroed. */
+int Sim_SDCard_LoadImage(Sim_SDCard *card, const char *path);
+int Sim_SDCard_SaveImage(const Sim_SDCard *card, const char *path);
+
+#endif /* __SIM_SDCARD_H__ */
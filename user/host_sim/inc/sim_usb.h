@@ -0,0 +1,54 @@
+/**
+ * @file sim_usb.h
+ * @brief USB full-speed CDC link and host model for the host simulator
+ *
+ * Bulk packets of 64 bytes go over the wire at up to 19 per 1 ms frame in
+ * each direction. An IN transfer of any length is split into packets; like
+ * the ST CDC class (usbd_cdc.c DataIn), a transfer that is a non-zero
+ * multiple of 64 bytes is followed by a zero-length packet before it
+ * completes.
+ *
+ * The host reads IN data with requests of SIM_USB_HOST_READ bytes, as a
+ * CDC driver on a PC does: bytes reach the host application when a short
+ * packet (or ZLP) ends the request or the request is full. Bytes received
+ * but not yet handed over are in host_held.
+ *
+ * OUT data written by the host is delivered one packet at a time into the
+ * buffer set with USBD_CDC_SetRxBuffer, and only after the device armed the
+ * endpoint with USBD_CDC_ReceivePacket; until then the host is NAKed.
+ */
+
+#ifndef __SIM_USB_H__
+#define __SIM_USB_H__
+
+#include "usbd_cdc_if.h"
+
+#define SIM_USB_HOST_READ   4096U
+#define SIM_USB_OUT_QUEUE   (64U * 1024U)
+
+typedef struct {
+    uint64_t in_transfers;       // CDC_Transmit_FS calls accepted
+    uint64_t in_packets;         // Including ZLPs
+    uint64_t in_zlps;
+    uint64_t in_busy;            // CDC_Transmit_FS calls refused with USBD_BUSY
+    uint64_t out_packets;
+    uint64_t out_naks;           // Packet slots the host could not deliver
+    uint64_t host_reads;         // Host read requests completed
+} Sim_USB_Stats;
+
+/** Enumerate: device configured, class initialised, OUT endpoint armed. */
+void Sim_USB_Connect(void);
+void Sim_USB_Disconnect(void);
+
+/** Host application writes to the virtual COM port. Returns bytes queued. */
+uint32_t Sim_USB_HostWrite(const uint8_t *data, uint32_t len);
+
+/** Host application side of IN data: called per completed read request. */
+void Sim_USB_SetHostSink(void (*sink)(void *ctx, const uint8_t *data, uint32_t len), void *ctx);
+
+/** IN bytes received by the host controller but not yet handed to the application. */
+uint32_t Sim_USB_HostHeld(void);
+
+Sim_USB_Stats *Sim_USB_GetStats(void);
+
+#endif /* __SIM_USB_H__ */
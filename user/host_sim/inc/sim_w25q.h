@@ -0,0 +1,79 @@
+/**
+ * @file sim_w25q.h
+ * @brief Winbond W25Qxx SPI NOR flash model for the host simulator
+ *
+ * Implements the standard single-I/O command set with datasheet-typical
+ * timings: page program 0.7 ms, 4 KB erase 45 ms, 32/64 KB erase
+ * 120/150 ms, chip erase scaled by size. Programming ANDs bits like real
+ * NOR. Commands issued while BUSY (other than status reads) are counted
+ * as protocol violations and ignored. Suspend (0x75) parks a program or
+ * block/sector erase; during a chip erase it is ignored, as on the part. The SFDP area (0x5A) holds a
+ * W25Q64JV-style header and basic parameter table scaled to the size;
+ * set sfdp_len to 0 after init to model a part without SFDP.
+ */
+
+#ifndef __SIM_W25Q_H__
+#define __SIM_W25Q_H__
+
+#include "sim_hal.h"
+
+typedef struct {
+    uint64_t reads;            // 0x03 / 0x0B commands
+    uint64_t fast_reads;       // 0x0B / 0x0C of those
+    uint64_t sfdp_reads;       // 0x5A commands
+    uint64_t read_bytes;
+    uint64_t programs;         // 0x02 commands
+    uint64_t program_bytes;
+    uint64_t erases_4k;
+    uint64_t erases_32k;
+    uint64_t erases_64k;
+    uint64_t erases_chip;
+    uint64_t status_polls;
+    uint64_t suspends;         // 0x75 accepted during program/erase
+    uint64_t suspends_refused; // 0x75 ignored during a chip erase
+    uint64_t resumes;          // 0x7A accepted while suspended
+    uint64_t busy_violations;  // Commands ignored because the chip was busy
+    uint64_t wel_violations;   // Program/erase without WREN
+    uint64_t commands;
+} Sim_W25Q_Stats;
+
+typedef struct {
+    Sim_SPIDevice   spi;           // Must stay first
+    uint8_t        *mem;
+    uint32_t        size;
+    uint32_t        jedec_id;      // e.g. 0xEF4017 (W25Q64)
+    uint64_t        busy_until;
+    uint8_t         sr1;
+    uint8_t         sr2;
+    uint8_t         sr3;
+    bool            addr4;         // 4-byte address mode (0xB7/0xE9)
+    uint8_t         busy_cmd;      // Program/erase command that set BUSY
+    uint64_t        suspend_left;  // Busy cycles left when suspended (SR2 SUS set)
+    uint8_t         sfdp[64];      // SFDP area, addresses past sfdp_len read 0xFF
+    uint32_t        sfdp_len;      // 0 = no SFDP
+    /* Per-transaction decoder state */
+    uint8_t         cmd;
+    uint32_t        pos;
+    uint32_t        addr;
+    uint32_t        page_base;
+    uint32_t        page_off;
+    Sim_W25Q_Stats  stats;
+    /* Timings in microseconds */
+    uint32_t        t_page_us;
+    uint32_t        t_se_us;
+    uint32_t        t_be32_us;
+    uint32_t        t_be64_us;
+    uint32_t        t_ce_us;
+    uint32_t        t_sus_us;      // Suspend latency
+} Sim_W25Q;
+
+/**
+ * @brief Create a flash model and attach it to an SPI bus.
+ * @param jedec_id 24-bit JEDEC ID; capacity is derived from the low byte.
+ */
+void Sim_W25Q_Init(Sim_W25Q *dev, SPI_HandleTypeDef *hspi,
+                   GPIO_TypeDef *cs_port, uint16_t cs_pin, uint32_t jedec_id);
+void Sim_W25Q_Free(Sim_W25Q *dev);
+bool Sim_W25Q_IsBusy(const Sim_W25Q *dev);
+
+#endif /* __SIM_W25Q_H__ */
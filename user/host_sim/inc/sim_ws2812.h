@@ -0,0 +1,40 @@
+/**
+ * @file sim_ws2812.h
+ * @brief WS2812B LED strip model for the host simulator
+ *
+ * The strip is fed by a timer channel's PWM DMA (Sim_TIM_SetPwmSink): each
+ * period is one bit, decoded from its high time (0.2-0.5 us: 0, 0.6-1.0 us:
+ * 1, anything else is a bad pulse). Zero duty is a low period; 50 us of low
+ * line latches the frame received so far. A low period inside a frame that
+ * is too short to latch is counted as a gap: on a real strip the bits after
+ * it land on the wrong LEDs. Each latched LED shows its GRB value as r/g/b.
+ */
+
+#ifndef __SIM_WS2812_H__
+#define __SIM_WS2812_H__
+
+#include "sim_hal.h"
+
+#define SIM_WS2812_MAX_LEDS  1200
+
+typedef struct {
+    uint64_t frames;           // Latched frames
+    uint64_t bits;
+    uint64_t bad_pulses;       // High time outside both bit windows
+    uint64_t gaps;             // Low periods inside a frame
+} Sim_WS2812_Stats;
+
+typedef struct {
+    TIM_HandleTypeDef *htim;
+    uint8_t            rgb[SIM_WS2812_MAX_LEDS][3];   // What the strip shows
+    uint16_t           latched_leds;                  // LEDs in the last frame
+    /* Shift state */
+    uint8_t            rx[SIM_WS2812_MAX_LEDS * 3];
+    uint32_t           rx_bits;
+    uint32_t           low_periods;
+    Sim_WS2812_Stats   stats;
+} Sim_WS2812;
+
+void Sim_WS2812_Init(Sim_WS2812 *dev, TIM_HandleTypeDef *htim, uint32_t Channel);
+
+#endif /* __SIM_WS2812_H__ */
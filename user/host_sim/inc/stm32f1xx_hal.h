@@ -0,0 +1,11 @@
+/**
+ * @file stm32f1xx_hal.h
+ * @brief Host simulation stand-in for the CubeMX/HAL header of the same name
+ */
+
+#ifndef __SIM_STM32F1XX_HAL_H__
+#define __SIM_STM32F1XX_HAL_H__
+
+#include "sim_hal.h"
+
+#endif /* __SIM_STM32F1XX_HAL_H__ */
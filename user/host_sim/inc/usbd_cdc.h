@@ -0,0 +1,29 @@
+/**
+ * @file usbd_cdc.h
+ * @brief Host simulator stand-in for the ST USB CDC class
+ */
+
+#ifndef __USBD_CDC_H__
+#define __USBD_CDC_H__
+
+#include "usbd_core.h"
+
+#define CDC_DATA_FS_MAX_PACKET_SIZE  64U
+#define CDC_DATA_FS_OUT_PACKET_SIZE  CDC_DATA_FS_MAX_PACKET_SIZE
+#define CDC_IN_EP                    0x81U
+
+typedef struct {
+    uint8_t           *RxBuffer;
+    uint8_t           *TxBuffer;
+    uint32_t           RxLength;
+    uint32_t           TxLength;
+    volatile uint32_t  TxState;     // 1 while an IN transfer is in flight
+    volatile uint32_t  RxState;
+} USBD_CDC_HandleTypeDef;
+
+uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint32_t length);
+uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff);
+uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev);
+uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef *pdev);
+
+#endif /* __USBD_CDC_H__ */
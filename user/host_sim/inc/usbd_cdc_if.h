@@ -0,0 +1,20 @@
+/**
+ * @file usbd_cdc_if.h
+ * @brief Host simulator stand-in for the CubeMX generated CDC interface
+ *
+ * CDC_Receive_FS and CDC_TransmitCplt_FS are weak in the simulator: a test
+ * defines them with the user code a project puts into usbd_cdc_if.c. The
+ * defaults behave like the generated file (re-arm reception, do nothing).
+ */
+
+#ifndef __USBD_CDC_IF_H__
+#define __USBD_CDC_IF_H__
+
+#include "usbd_cdc.h"
+
+uint8_t CDC_Transmit_FS(uint8_t *Buf, uint16_t Len);
+
+int8_t CDC_Receive_FS(uint8_t *Buf, uint32_t *Len);
+int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum);
+
+#endif /* __USBD_CDC_IF_H__ */
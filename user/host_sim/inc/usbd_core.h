@@ -0,0 +1,31 @@
+/**
+ * @file usbd_core.h
+ * @brief Host simulator stand-in for the ST USB device core
+ *
+ * Only the parts of the device handle that drivers look at: the device
+ * state and the class data of the CDC interface.
+ */
+
+#ifndef __USBD_CORE_H__
+#define __USBD_CORE_H__
+
+#include "sim_hal.h"
+
+#define USBD_OK                  0U
+#define USBD_BUSY                1U
+#define USBD_EMEM                2U
+#define USBD_FAIL                3U
+
+#define USBD_STATE_DEFAULT       0x01U
+#define USBD_STATE_ADDRESSED     0x02U
+#define USBD_STATE_CONFIGURED    0x03U
+#define USBD_STATE_SUSPENDED     0x04U
+
+typedef struct _USBD_HandleTypeDef {
+    volatile uint8_t  dev_state;
+    void             *pClassData;
+} USBD_HandleTypeDef;
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+#endif /* __USBD_CORE_H__ */
@@ -0,0 +1,94 @@
+/**
+ * @file sim_at24.c
+ * @brief AT24Cxx I2C EEPROM model
+ */
+
+#include "sim_at24.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool Sim_AT24_IsBusy(const Sim_AT24 *dev)
+{
+    return Sim_Now() < dev->busy_until;
+}
+
+static bool Sim_AT24_Ack(Sim_I2CDevice *i2c)
+{
+    Sim_AT24 *dev = (Sim_AT24 *)i2c;
+
+    if (Sim_AT24_IsBusy(dev)) {
+        dev->stats.busy_nacks++;
+        return false;
+    }
+    return true;
+}
+
+static bool Sim_AT24_Write(Sim_I2CDevice *i2c, const uint8_t *data, uint16_t len)
+{
+    Sim_AT24 *dev = (Sim_AT24 *)i2c;
+    uint32_t base, off;
+    uint16_t n;
+
+    if (len < dev->addr_bytes) {
+        return false;
+    }
+    dev->addr = (dev->addr_bytes == 2) ? ((uint32_t)data[0] << 8 | data[1]) : data[0];
+    dev->addr &= dev->size - 1U;
+    data += dev->addr_bytes;
+    n = (uint16_t)(len - dev->addr_bytes);
+    if (n == 0) {
+        return true;   // Address load before a read
+    }
+
+    base = dev->addr & ~((uint32_t)dev->page_size - 1U);
+    off  = dev->addr - base;
+    if (off + n > dev->page_size) {
+        dev->stats.page_wraps++;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        dev->mem[base + off] = data[i];
+        off = (off + 1U) % dev->page_size;
+    }
+    dev->addr = base + off;
+    dev->stats.writes++;
+    dev->stats.write_bytes += n;
+    dev->busy_until = Sim_Now() + Sim_UsToCycles(dev->t_wr_us);
+    return true;
+}
+
+static bool Sim_AT24_Read(Sim_I2CDevice *i2c, uint8_t *data, uint16_t len)
+{
+    Sim_AT24 *dev = (Sim_AT24 *)i2c;
+
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = dev->mem[dev->addr];
+        dev->addr = (dev->addr + 1U) & (dev->size - 1U);
+    }
+    dev->stats.reads++;
+    dev->stats.read_bytes += len;
+    return true;
+}
+
+void Sim_AT24_Init(Sim_AT24 *dev, I2C_HandleTypeDef *hi2c, uint16_t addr,
+                   uint32_t size, uint16_t page_size)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->size       = size;
+    dev->page_size  = page_size;
+    dev->addr_bytes = (size > 256U) ? 2 : 1;
+    dev->t_wr_us    = 5000;
+    dev->mem        = (uint8_t *)malloc(size);
+    memset(dev->mem, 0xFF, size);
+
+    dev->i2c.addr  = addr;
+    dev->i2c.ack   = Sim_AT24_Ack;
+    dev->i2c.write = Sim_AT24_Write;
+    dev->i2c.read  = Sim_AT24_Read;
+    Sim_I2C_Attach(hi2c, &dev->i2c);
+}
+
+void Sim_AT24_Free(Sim_AT24 *dev)
+{
+    free(dev->mem);
+    dev->mem = NULL;
+}
@@ -0,0 +1,454 @@
+/**
+ * @file sim_core.c
+ * @brief Virtual time, event queue, PRIMASK/NVIC, DWT, SysTick and GPIO
+ */
+
+#include "sim_hal.h"
+#include "sim_internal.h"
+#include <string.h>
+#include <time.h>
+
+/* ============================================================================
+ * Virtual Time / Event Queue
+ * ========================================================================= */
+
+typedef struct {
+    uint64_t    when;
+    uint64_t    seq;
+    Sim_EventFn fn;
+    void       *ctx;
+    bool        irq;
+} Sim_Event;
+
+uint32_t SystemCoreClock = SIM_CPU_HZ;
+
+static uint64_t     s_now;
+static uint64_t     s_seq;
+static Sim_Event    s_events[SIM_MAX_EVENTS];
+static uint32_t     s_event_count;
+static uint32_t     s_primask;
+static uint32_t     s_isr_depth;
+static uint64_t     s_mask_start;
+static uint64_t     s_mask_start_ns;
+static Sim_CpuStats s_cpu;
+
+uint64_t Sim_HostNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t Sim_Now(void)
+{
+    return s_now;
+}
+
+uint64_t Sim_UsToCycles(uint32_t us)
+{
+    return (uint64_t)us * (SystemCoreClock / 1000000U);
+}
+
+double Sim_CyclesToUs(uint64_t cycles)
+{
+    return (double)cycles * 1e6 / (double)SystemCoreClock;
+}
+
+bool Sim_InIsr(void)
+{
+    return s_isr_depth > 0;
+}
+
+Sim_CpuStats *Sim_GetCpuStats(void)
+{
+    return &s_cpu;
+}
+
+void Sim_ResetStats(void)
+{
+    memset(&s_cpu, 0, sizeof(s_cpu));
+    if (s_primask) {
+        s_mask_start    = s_now;
+        s_mask_start_ns = Sim_HostNs();
+    }
+}
+
+bool Sim_Schedule(uint64_t delay_cycles, Sim_EventFn fn, void *ctx, bool irq)
+{
+    if (s_event_count >= SIM_MAX_EVENTS) {
+        return false;
+    }
+    Sim_Event *ev = &s_events[s_event_count++];
+    ev->when = s_now + delay_cycles;
+    ev->seq  = s_seq++;
+    ev->fn   = fn;
+    ev->ctx  = ctx;
+    ev->irq  = irq;
+    return true;
+}
+
+void Sim_Cancel(Sim_EventFn fn, void *ctx)
+{
+    uint32_t i = 0;
+    while (i < s_event_count) {
+        if (s_events[i].fn == fn && s_events[i].ctx == ctx) {
+            s_events[i] = s_events[--s_event_count];
+        } else {
+            i++;
+        }
+    }
+}
+
+/**
+ * @brief Pick the earliest runnable event due at or before limit.
+ *        Interrupt-class events are not runnable while PRIMASK is set or
+ *        another handler is active (single priority level).
+ */
+static int Sim_PickEvent(uint64_t limit)
+{
+    bool irq_ok = (s_primask == 0) && (s_isr_depth == 0);
+    int best = -1;
+
+    for (uint32_t i = 0; i < s_event_count; i++) {
+        const Sim_Event *ev = &s_events[i];
+        if (ev->when > limit) continue;
+        if (ev->irq && !irq_ok) continue;
+        if (best < 0 ||
+            ev->when < s_events[best].when ||
+            (ev->when == s_events[best].when && ev->seq < s_events[best].seq)) {
+            best = (int)i;
+        }
+    }
+    return best;
+}
+
+static void Sim_Dispatch(int idx)
+{
+    Sim_Event ev = s_events[idx];
+    s_events[idx] = s_events[--s_event_count];
+
+    if (ev.when > s_now) {
+        s_now = ev.when;
+    }
+    if (ev.irq) {
+        s_isr_depth++;
+        s_cpu.isr_count++;
+        ev.fn(ev.ctx);
+        s_isr_depth--;
+    } else {
+        ev.fn(ev.ctx);
+    }
+}
+
+void Sim_Advance(uint64_t cycles)
+{
+    uint64_t target = s_now + cycles;
+    int idx;
+
+    while ((idx = Sim_PickEvent(target)) >= 0) {
+        Sim_Dispatch(idx);
+    }
+    if (target > s_now) {
+        s_now = target;
+    }
+}
+
+void Sim_AdvanceUs(uint32_t us)
+{
+    Sim_Advance(Sim_UsToCycles(us));
+}
+
+bool Sim_RunNext(void)
+{
+    int idx = Sim_PickEvent(UINT64_MAX);
+    if (idx < 0) {
+        return false;
+    }
+    Sim_Dispatch(idx);
+    return true;
+}
+
+void Sim_RunUntilIdle(uint64_t max_cycles)
+{
+    uint64_t limit = s_now + max_cycles;
+    int idx;
+
+    while ((idx = Sim_PickEvent(limit)) >= 0) {
+        Sim_Dispatch(idx);
+    }
+}
+
+/** Run any interrupt that became pending while it was masked. */
+static void Sim_FlushPending(void)
+{
+    uint64_t pending = 0;
+    for (uint32_t i = 0; i < s_event_count; i++) {
+        if (s_events[i].irq && s_events[i].when <= s_now) {
+            pending++;
+        }
+    }
+    s_cpu.isr_deferred += pending;
+    Sim_Advance(0);
+}
+
+void Sim_RaiseIrq(Sim_EventFn fn, void *ctx)
+{
+    Sim_Schedule(0, fn, ctx, true);
+    if (s_primask == 0 && s_isr_depth == 0) {
+        Sim_Advance(0);
+    }
+}
+
+void Sim_Busy(uint64_t cycles, Sim_BusStats *stats)
+{
+    if (stats) {
+        stats->blocking_cycles += cycles;
+    }
+    Sim_Advance(cycles);
+}
+
+void Sim_Reset(void)
+{
+    s_now         = 0;
+    s_seq         = 0;
+    s_event_count = 0;
+    s_primask     = 0;
+    s_isr_depth   = 0;
+    memset(&s_cpu, 0, sizeof(s_cpu));
+    Sim_GPIO_Reset();
+}
+
+/* ============================================================================
+ * Cortex-M Core
+ * ========================================================================= */
+
+uint32_t __get_PRIMASK(void)
+{
+    return s_primask;
+}
+
+uint32_t __get_IPSR(void)
+{
+    return s_isr_depth ? 16U : 0U;   // Any IRQn maps to exception 16 and up
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+    priMask &= 1U;
+    if (priMask && !s_primask) {
+        s_primask       = 1;
+        s_mask_start    = s_now;
+        s_mask_start_ns = Sim_HostNs();
+        s_cpu.irq_disable_count++;
+    } else if (!priMask && s_primask) {
+        uint64_t cycles = s_now - s_mask_start;
+        uint64_t ns     = Sim_HostNs() - s_mask_start_ns;
+        s_cpu.irq_off_cycles += cycles;
+        if (cycles > s_cpu.irq_off_max_cycles) s_cpu.irq_off_max_cycles = cycles;
+        if (ns > s_cpu.irq_off_max_ns)         s_cpu.irq_off_max_ns = ns;
+        s_primask = 0;
+        if (s_isr_depth == 0) {
+            Sim_FlushPending();
+        }
+    }
+}
+
+void __disable_irq(void)
+{
+    __set_PRIMASK(1);
+}
+
+void __enable_irq(void)
+{
+    __set_PRIMASK(0);
+}
+
+static DWT_Type s_dwt;
+CoreDebug_Type  Sim_CoreDebug;
+
+DWT_Type *Sim_DWT(void)
+{
+    /* Every access costs a register read; keeps DWT busy-wait loops moving */
+    Sim_Advance(SIM_POLL_CYCLES);
+    s_dwt.CYCCNT = (uint32_t)s_now;
+    return &s_dwt;
+}
+
+/* ============================================================================
+ * System / RCC / SysTick
+ * ========================================================================= */
+
+uint32_t HAL_GetTick(void)
+{
+    Sim_Advance(SIM_POLL_CYCLES);
+    return (uint32_t)(s_now / (SystemCoreClock / 1000U));
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    Sim_Advance((uint64_t)Delay * (SystemCoreClock / 1000U));
+}
+
+void HAL_IncTick(void)
+{
+    /* SysTick is derived from the cycle counter */
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+    return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return SystemCoreClock / 2U;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+    return SystemCoreClock;
+}
+
+/* ============================================================================
+ * GPIO
+ * ========================================================================= */
+
+GPIO_TypeDef Sim_GPIOA = { .name = "GPIOA" };
+GPIO_TypeDef Sim_GPIOB = { .name = "GPIOB" };
+GPIO_TypeDef Sim_GPIOC = { .name = "GPIOC" };
+GPIO_TypeDef Sim_GPIOD = { .name = "GPIOD" };
+GPIO_TypeDef Sim_GPIOE = { .name = "GPIOE" };
+
+typedef struct {
+    GPIO_TypeDef    *port;
+    uint16_t         pin;
+    Sim_GPIOWatchFn  fn;
+    void            *ctx;
+} Sim_GPIOWatch;
+
+static Sim_GPIOWatch s_watch[SIM_MAX_GPIO_WATCH];
+static uint32_t      s_watch_count;
+
+void Sim_GPIO_Reset(void)
+{
+    GPIO_TypeDef *ports[] = { GPIOA, GPIOB, GPIOC, GPIOD, GPIOE };
+    for (size_t i = 0; i < sizeof(ports) / sizeof(ports[0]); i++) {
+        ports[i]->IDR = 0;
+        ports[i]->ODR = 0;
+        memset(ports[i]->mode, 0, sizeof(ports[i]->mode));
+        memset(ports[i]->exti, 0, sizeof(ports[i]->exti));
+    }
+    s_watch_count = 0;
+}
+
+static int Sim_PinIndex(uint16_t pin)
+{
+    for (int i = 0; i < 16; i++) {
+        if (pin & (1U << i)) return i;
+    }
+    return 0;
+}
+
+static bool Sim_PinIsOutput(GPIO_TypeDef *port, uint16_t pin)
+{
+    uint32_t mode = port->mode[Sim_PinIndex(pin)];
+    return mode == GPIO_MODE_OUTPUT_PP || mode == GPIO_MODE_OUTPUT_OD;
+}
+
+bool Sim_GPIO_Watch(GPIO_TypeDef *port, uint16_t pin, Sim_GPIOWatchFn fn, void *ctx)
+{
+    if (s_watch_count >= SIM_MAX_GPIO_WATCH) {
+        return false;
+    }
+    s_watch[s_watch_count].port = port;
+    s_watch[s_watch_count].pin  = pin;
+    s_watch[s_watch_count].fn   = fn;
+    s_watch[s_watch_count].ctx  = ctx;
+    s_watch_count++;
+    return true;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    for (int i = 0; i < 16; i++) {
+        if (GPIO_Init->Pin & (1U << i)) {
+            GPIOx->mode[i] = GPIO_Init->Mode;
+            if (GPIO_Init->Mode == GPIO_MODE_IT_RISING || GPIO_Init->Mode == GPIO_MODE_IT_FALLING ||
+                GPIO_Init->Mode == GPIO_MODE_IT_RISING_FALLING) {
+                GPIOx->exti[i] = GPIO_Init->Mode;
+            }
+        }
+    }
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{
+    for (int i = 0; i < 16; i++) {
+        if (GPIO_Pin & (1U << i)) {
+            GPIOx->mode[i] = GPIO_MODE_INPUT;
+            GPIOx->exti[i] = 0;
+        }
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    uint32_t reg = Sim_PinIsOutput(GPIOx, GPIO_Pin) ? GPIOx->ODR : GPIOx->IDR;
+    return (reg & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    uint32_t old = GPIOx->ODR;
+
+    if (PinState != GPIO_PIN_RESET) {
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+    if (old == GPIOx->ODR) {
+        return;
+    }
+    for (uint32_t i = 0; i < s_watch_count; i++) {
+        if (s_watch[i].port == GPIOx && (s_watch[i].pin & GPIO_Pin) &&
+            ((old ^ GPIOx->ODR) & s_watch[i].pin)) {
+            s_watch[i].fn(s_watch[i].ctx, PinState);
+        }
+    }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    HAL_GPIO_WritePin(GPIOx, GPIO_Pin,
+                      (GPIOx->ODR & GPIO_Pin) ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+__weak void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    UNUSED(GPIO_Pin);
+}
+
+static void Sim_GPIO_ExtiEvent(void *ctx)
+{
+    HAL_GPIO_EXTI_Callback((uint16_t)(uintptr_t)ctx);
+}
+
+void Sim_GPIO_SetInput(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    bool was  = (port->IDR & pin) != 0;
+    bool now  = (state != GPIO_PIN_RESET);
+    uint32_t mode = port->exti[Sim_PinIndex(pin)];
+
+    if (now) {
+        port->IDR |= pin;
+    } else {
+        port->IDR &= ~(uint32_t)pin;
+    }
+    if (was == now) {
+        return;
+    }
+    if ((now  && (mode == GPIO_MODE_IT_RISING  || mode == GPIO_MODE_IT_RISING_FALLING)) ||
+        (!now && (mode == GPIO_MODE_IT_FALLING || mode == GPIO_MODE_IT_RISING_FALLING))) {
+        Sim_RaiseIrq(Sim_GPIO_ExtiEvent, (void *)(uintptr_t)pin);
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * @file sim_dht11.c
+ * @brief DHT11 single-wire sensor model
+ */
+
+#include "sim_dht11.h"
+#include <string.h>
+
+#define SIM_DHT11_NO_LOW    UINT64_MAX
+
+static void Sim_DHT11_Step(void *ctx)
+{
+    Sim_DHT11 *dev = (Sim_DHT11 *)ctx;
+    bool high = (dev->port->IDR & dev->pin) != 0;
+
+    // Every step toggles the line; the first one is the response going low
+    Sim_GPIO_SetInput(dev->port, dev->pin, high ? GPIO_PIN_RESET : GPIO_PIN_SET);
+    if (dev->edge_pos < dev->edge_count) {
+        Sim_Schedule(Sim_UsToCycles(dev->edges[dev->edge_pos++]), Sim_DHT11_Step, dev, false);
+    }
+}
+
+static void Sim_DHT11_Respond(Sim_DHT11 *dev)
+{
+    uint8_t n = 0;
+
+    dev->edges[n++] = 80;   // Response low
+    dev->edges[n++] = 80;   // Response high
+    for (uint8_t i = 0; i < 40; i++) {
+        bool one = (dev->data[i / 8] >> (7 - (i % 8))) & 1U;
+
+        dev->edges[n++] = 50;
+        dev->edges[n++] = one ? 70 : 27;
+    }
+    dev->edges[n++] = 50;   // End of frame, then released
+    dev->edge_count = n;
+    dev->edge_pos = 0;
+
+    if (dev->bad_checksum) {
+        // Flip the last checksum bit: its high time is the last one before the end low
+        dev->edges[n - 2] = (dev->edges[n - 2] == 70) ? 27 : 70;
+    }
+    dev->stats.starts++;
+    Sim_Schedule(Sim_UsToCycles(30), Sim_DHT11_Step, dev, false);
+}
+
+static void Sim_DHT11_Pin(void *ctx, GPIO_PinState state)
+{
+    Sim_DHT11 *dev = (Sim_DHT11 *)ctx;
+
+    if (state == GPIO_PIN_RESET) {
+        dev->low_since = Sim_Now();
+        return;
+    }
+    if (dev->low_since == SIM_DHT11_NO_LOW || !dev->present) {
+        return;
+    }
+    if (Sim_CyclesToUs(Sim_Now() - dev->low_since) >= 18000.0) {
+        Sim_DHT11_Respond(dev);
+    } else {
+        dev->stats.short_starts++;
+    }
+    dev->low_since = SIM_DHT11_NO_LOW;
+}
+
+void Sim_DHT11_Init(Sim_DHT11 *dev, GPIO_TypeDef *port, uint16_t pin)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->port      = port;
+    dev->pin       = pin;
+    dev->present   = true;
+    dev->low_since = SIM_DHT11_NO_LOW;
+    Sim_DHT11_Set(dev, 50, 25, 0);
+
+    Sim_GPIO_SetInput(port, pin, GPIO_PIN_SET);     // Pull-up
+    Sim_GPIO_Watch(port, pin, Sim_DHT11_Pin, dev);
+}
+
+void Sim_DHT11_Set(Sim_DHT11 *dev, uint8_t humidity, uint8_t temp_int, uint8_t temp_dec)
+{
+    dev->data[0] = humidity;
+    dev->data[1] = 0;
+    dev->data[2] = temp_int;
+    dev->data[3] = temp_dec;
+    dev->data[4] = (uint8_t)(dev->data[0] + dev->data[1] + dev->data[2] + dev->data[3]);
+}
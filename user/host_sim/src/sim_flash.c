@@ -0,0 +1,197 @@
+/**
+ * @file sim_flash.c
+ * @brief Simulated STM32F1 internal flash
+ *
+ * The array is mapped at FLASH_BASE and kept read-only, so drivers read it
+ * through plain pointers exactly as on the MCU, and a stray store into
+ * flash faults instead of silently "working". Programming follows the F1
+ * rules: halfword units, the target must read 0xFFFF (writing 0x0000 is
+ * always allowed), FPEC must be unlocked.
+ */
+
+#include "sim_hal.h"
+#include "sim_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0
+#endif
+
+#define SIM_FLASH_PROG_US   52
+#define SIM_FLASH_ERASE_US  20000
+
+static uint8_t       *s_mem;
+static bool           s_unlocked;
+static uint32_t       s_error;
+static Sim_FlashStats s_stats;
+static bool           s_fail_armed;
+static uint32_t       s_fail_left;
+static bool           s_power_lost;
+
+void Sim_Flash_Init(void)
+{
+    if (s_mem == NULL) {
+        void *p = mmap((void *)(uintptr_t)FLASH_BASE, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+        if (p != (void *)(uintptr_t)FLASH_BASE) {
+            fprintf(stderr, "sim_flash: cannot map flash at 0x%08lX\n", (unsigned long)FLASH_BASE);
+            abort();
+        }
+        s_mem = (uint8_t *)p;
+    } else {
+        mprotect(s_mem, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE);
+    }
+
+    memset(s_mem, 0xFF, SIM_FLASH_SIZE);
+    mprotect(s_mem, SIM_FLASH_SIZE, PROT_READ);
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_unlocked = false;
+    s_error = HAL_FLASH_ERROR_NONE;
+    Sim_Flash_PowerRestore();
+}
+
+Sim_FlashStats *Sim_Flash_Stats(void)
+{
+    return &s_stats;
+}
+
+void Sim_Flash_PowerFailAfter(uint32_t ops)
+{
+    s_fail_armed = true;
+    s_fail_left = ops;
+    s_power_lost = false;
+}
+
+void Sim_Flash_PowerRestore(void)
+{
+    s_fail_armed = false;
+    s_power_lost = false;
+}
+
+typedef enum { SIM_FLASH_POWER_OK, SIM_FLASH_POWER_CUT, SIM_FLASH_POWER_OFF } Sim_FlashPower;
+
+// Account one operation against the power-fail budget
+static Sim_FlashPower Sim_Flash_Power(void)
+{
+    if (s_power_lost) {
+        s_stats.dropped++;
+        return SIM_FLASH_POWER_OFF;
+    }
+    if (s_fail_armed) {
+        if (s_fail_left == 0) {
+            s_power_lost = true;
+            s_stats.dropped++;
+            return SIM_FLASH_POWER_CUT;     // Dies during this operation
+        }
+        s_fail_left--;
+    }
+    return SIM_FLASH_POWER_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+    Sim_Advance(SIM_HAL_CALL_CYCLES);
+    s_unlocked = true;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+    Sim_Advance(SIM_HAL_CALL_CYCLES);
+    s_unlocked = false;
+    return HAL_OK;
+}
+
+uint32_t HAL_FLASH_GetError(void)
+{
+    return s_error;
+}
+
+static HAL_StatusTypeDef Sim_Flash_ProgramHalfword(uint32_t Address, uint16_t data)
+{
+    uint32_t off = Address - FLASH_BASE;
+    uint16_t cur;
+
+    Sim_Advance(Sim_UsToCycles(SIM_FLASH_PROG_US));
+    if (Sim_Flash_Power() != SIM_FLASH_POWER_OK) return HAL_OK;   // Halfwords program whole or not at all
+
+    memcpy(&cur, &s_mem[off], sizeof(cur));
+    if (cur != 0xFFFFU && data != 0x0000U) {
+        s_error = HAL_FLASH_ERROR_PROG;
+        s_stats.prog_errors++;
+        return HAL_ERROR;
+    }
+
+    mprotect(s_mem, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE);
+    memcpy(&s_mem[off], &data, sizeof(data));
+    mprotect(s_mem, SIM_FLASH_SIZE, PROT_READ);
+    s_stats.halfwords++;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+    uint32_t count = (TypeProgram == FLASH_TYPEPROGRAM_DOUBLEWORD) ? 4U :
+                     (TypeProgram == FLASH_TYPEPROGRAM_WORD) ? 2U : 1U;
+
+    Sim_Advance(SIM_HAL_CALL_CYCLES);
+    s_error = HAL_FLASH_ERROR_NONE;
+    if (s_mem == NULL || !s_unlocked || (Address & 1U) != 0 ||
+        Address < FLASH_BASE || Address + count * 2U > FLASH_BASE + SIM_FLASH_SIZE) {
+        s_error = HAL_FLASH_ERROR_WRP;
+        s_stats.wrp_errors++;
+        return HAL_ERROR;
+    }
+
+    // Wider types are programmed one halfword after another, low first
+    for (uint32_t i = 0; i < count; i++) {
+        if (Sim_Flash_ProgramHalfword(Address + i * 2U, (uint16_t)(Data >> (16U * i))) != HAL_OK) {
+            return HAL_ERROR;
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+    uint32_t first = pEraseInit->PageAddress & ~(FLASH_PAGE_SIZE - 1U);
+    uint32_t pages = pEraseInit->NbPages;
+
+    Sim_Advance(SIM_HAL_CALL_CYCLES);
+    *PageError = 0xFFFFFFFFU;
+    s_error = HAL_FLASH_ERROR_NONE;
+
+    if (pEraseInit->TypeErase == FLASH_TYPEERASE_MASSERASE) {
+        first = FLASH_BASE;
+        pages = SIM_FLASH_SIZE / FLASH_PAGE_SIZE;
+    }
+    if (s_mem == NULL || !s_unlocked || first < FLASH_BASE ||
+        first + pages * FLASH_PAGE_SIZE > FLASH_BASE + SIM_FLASH_SIZE) {
+        s_error = HAL_FLASH_ERROR_WRP;
+        s_stats.wrp_errors++;
+        *PageError = first;
+        return HAL_ERROR;
+    }
+
+    for (uint32_t p = 0; p < pages; p++) {
+        uint32_t off = first - FLASH_BASE + p * FLASH_PAGE_SIZE;
+        uint32_t len = FLASH_PAGE_SIZE;
+
+        Sim_Advance(Sim_UsToCycles(SIM_FLASH_ERASE_US));
+        switch (Sim_Flash_Power()) {
+        case SIM_FLASH_POWER_OFF: return HAL_OK;
+        case SIM_FLASH_POWER_CUT: len = FLASH_PAGE_SIZE / 2U; break;   // Left half erased
+        default: break;
+        }
+
+        mprotect(s_mem, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE);
+        memset(&s_mem[off], 0xFF, len);
+        mprotect(s_mem, SIM_FLASH_SIZE, PROT_READ);
+        if (len == FLASH_PAGE_SIZE) s_stats.page_erases++;
+    }
+    return HAL_OK;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file sim_hcsr04.c
+ * @brief HC-SR04 ultrasonic ranger model
+ */
+
+#include "sim_hcsr04.h"
+#include <string.h>
+
+#define SIM_HCSR04_BURST_US    450
+#define SIM_HCSR04_NO_ECHO_US  38000
+
+static void Sim_HCSR04_EchoEnd(void *ctx)
+{
+    Sim_HCSR04 *dev = (Sim_HCSR04 *)ctx;
+
+    Sim_GPIO_SetInput(dev->echo_port, dev->echo_pin, GPIO_PIN_RESET);
+    dev->busy = false;
+}
+
+static void Sim_HCSR04_EchoStart(void *ctx)
+{
+    Sim_HCSR04 *dev = (Sim_HCSR04 *)ctx;
+    uint32_t us = (dev->distance_cm > 0.0f) ? (uint32_t)(dev->distance_cm / 0.017f + 0.5f)
+                                            : SIM_HCSR04_NO_ECHO_US;
+
+    Sim_GPIO_SetInput(dev->echo_port, dev->echo_pin, GPIO_PIN_SET);
+    Sim_Schedule(Sim_UsToCycles(us), Sim_HCSR04_EchoEnd, dev, false);
+}
+
+static void Sim_HCSR04_Trig(void *ctx, GPIO_PinState state)
+{
+    Sim_HCSR04 *dev = (Sim_HCSR04 *)ctx;
+
+    if (state == GPIO_PIN_SET) {
+        dev->trig_since = Sim_Now();
+        return;
+    }
+    if (Sim_CyclesToUs(Sim_Now() - dev->trig_since) < 10.0) {
+        dev->stats.short_triggers++;
+        return;
+    }
+    if (dev->busy) {
+        dev->stats.busy_triggers++;
+        return;
+    }
+    dev->busy = true;
+    dev->stats.measurements++;
+    Sim_Schedule(Sim_UsToCycles(SIM_HCSR04_BURST_US), Sim_HCSR04_EchoStart, dev, false);
+}
+
+void Sim_HCSR04_Init(Sim_HCSR04 *dev, GPIO_TypeDef *trig_port, uint16_t trig_pin,
+                     GPIO_TypeDef *echo_port, uint16_t echo_pin)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->trig_port   = trig_port;
+    dev->trig_pin    = trig_pin;
+    dev->echo_port   = echo_port;
+    dev->echo_pin    = echo_pin;
+    dev->distance_cm = 100.0f;
+
+    Sim_GPIO_SetInput(echo_port, echo_pin, GPIO_PIN_RESET);
+    Sim_GPIO_Watch(trig_port, trig_pin, Sim_HCSR04_Trig, dev);
+}
@@ -0,0 +1,301 @@
+/**
+ * @file sim_i2c.c
+ * @brief Simulated I2C master with addressed slave models
+ *
+ * Wire time is 9 bit-times per byte (8 data + ACK) plus start/stop.
+ * Blocking calls burn that time on the CPU; DMA and IT calls raise the
+ * completion interrupt once the last byte has been acknowledged.
+ */
+
+#include "sim_hal.h"
+#include "sim_internal.h"
+#include <string.h>
+
+enum {
+    SIM_I2C_OP_MEM_TX = 1,
+    SIM_I2C_OP_MEM_RX
+};
+
+/* ============================================================================
+ * Bus Helpers
+ * ========================================================================= */
+
+static uint64_t Sim_I2C_Cycles(I2C_HandleTypeDef *hi2c, uint32_t bytes)
+{
+    uint32_t hz = hi2c->sim.hz ? hi2c->sim.hz :
+                  (hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : SIM_I2C_DEFAULT_HZ);
+    /* 9 bits per byte plus ~2 bit-times for START/STOP */
+    return ((uint64_t)(bytes * 9U + 2U) * SystemCoreClock) / hz;
+}
+
+static Sim_I2CDevice *Sim_I2C_Find(I2C_HandleTypeDef *hi2c, uint16_t addr)
+{
+    for (Sim_I2CDevice *dev = hi2c->sim.devices; dev; dev = dev->next) {
+        if ((dev->addr & 0xFE) == (addr & 0xFE)) {
+            return dev;
+        }
+    }
+    return NULL;
+}
+
+static bool Sim_I2C_Ack(Sim_I2CDevice *dev)
+{
+    return dev && (!dev->ack || dev->ack(dev));
+}
+
+void Sim_I2C_Attach(I2C_HandleTypeDef *hi2c, Sim_I2CDevice *dev)
+{
+    dev->next = hi2c->sim.devices;
+    hi2c->sim.devices = dev;
+    if (hi2c->State == HAL_I2C_STATE_RESET) {
+        hi2c->State = HAL_I2C_STATE_READY;
+    }
+}
+
+Sim_BusStats *Sim_I2C_Stats(I2C_HandleTypeDef *hi2c)
+{
+    return &hi2c->sim.stats;
+}
+
+static uint16_t Sim_I2C_PackMem(I2C_HandleTypeDef *hi2c, uint16_t MemAddress, uint16_t MemAddSize,
+                                const uint8_t *pData, uint16_t Size)
+{
+    uint8_t *buf = hi2c->sim.scratch;
+    uint16_t n = 0;
+
+    if (MemAddSize == I2C_MEMADD_SIZE_16BIT) {
+        buf[n++] = (uint8_t)(MemAddress >> 8);
+    }
+    buf[n++] = (uint8_t)MemAddress;
+    if (pData && Size) {
+        if (Size > sizeof(hi2c->sim.scratch) - n) {
+            Size = (uint16_t)(sizeof(hi2c->sim.scratch) - n);
+        }
+        memcpy(&buf[n], pData, Size);
+        n += Size;
+    }
+    return n;
+}
+
+static HAL_StatusTypeDef Sim_I2C_Nack(I2C_HandleTypeDef *hi2c)
+{
+    hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+    Sim_Busy(Sim_I2C_Cycles(hi2c, 1), &hi2c->sim.stats);
+    return HAL_ERROR;
+}
+
+/* ============================================================================
+ * Blocking Transfers
+ * ========================================================================= */
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    Sim_I2CDevice *dev = Sim_I2C_Find(hi2c, DevAddress);
+    UNUSED(Timeout);
+
+    if (hi2c->State == HAL_I2C_STATE_BUSY_TX || hi2c->State == HAL_I2C_STATE_BUSY_RX) {
+        return HAL_BUSY;
+    }
+    hi2c->sim.stats.calls++;
+    hi2c->sim.stats.transactions++;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    if (!Sim_I2C_Ack(dev) || (dev->write && !dev->write(dev, pData, Size))) {
+        return Sim_I2C_Nack(hi2c);
+    }
+    hi2c->sim.stats.tx_bytes += Size;
+    hi2c->sim.stats.bus_cycles += Sim_I2C_Cycles(hi2c, Size + 1U);
+    Sim_Busy(SIM_HAL_CALL_CYCLES + Sim_I2C_Cycles(hi2c, Size + 1U), &hi2c->sim.stats);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    Sim_I2CDevice *dev = Sim_I2C_Find(hi2c, DevAddress);
+    UNUSED(Timeout);
+
+    if (hi2c->State == HAL_I2C_STATE_BUSY_TX || hi2c->State == HAL_I2C_STATE_BUSY_RX) {
+        return HAL_BUSY;
+    }
+    hi2c->sim.stats.calls++;
+    hi2c->sim.stats.transactions++;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    if (!Sim_I2C_Ack(dev) || !dev->read || !dev->read(dev, pData, Size)) {
+        return Sim_I2C_Nack(hi2c);
+    }
+    hi2c->sim.stats.rx_bytes += Size;
+    hi2c->sim.stats.bus_cycles += Sim_I2C_Cycles(hi2c, Size + 1U);
+    Sim_Busy(SIM_HAL_CALL_CYCLES + Sim_I2C_Cycles(hi2c, Size + 1U), &hi2c->sim.stats);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    uint16_t n = Sim_I2C_PackMem(hi2c, MemAddress, MemAddSize, pData, Size);
+    HAL_StatusTypeDef st = HAL_I2C_Master_Transmit(hi2c, DevAddress, hi2c->sim.scratch, n, Timeout);
+
+    if (st == HAL_OK) {
+        hi2c->sim.stats.tx_bytes -= (n - Size);
+    }
+    return st;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    Sim_I2CDevice *dev = Sim_I2C_Find(hi2c, DevAddress);
+    uint16_t n = Sim_I2C_PackMem(hi2c, MemAddress, MemAddSize, NULL, 0);
+    UNUSED(Timeout);
+
+    if (hi2c->State == HAL_I2C_STATE_BUSY_TX || hi2c->State == HAL_I2C_STATE_BUSY_RX) {
+        return HAL_BUSY;
+    }
+    hi2c->sim.stats.calls++;
+    hi2c->sim.stats.transactions++;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    if (!Sim_I2C_Ack(dev) ||
+        (dev->write && !dev->write(dev, hi2c->sim.scratch, n)) ||
+        !dev->read || !dev->read(dev, pData, Size)) {
+        return Sim_I2C_Nack(hi2c);
+    }
+    hi2c->sim.stats.rx_bytes += Size;
+    hi2c->sim.stats.bus_cycles += Sim_I2C_Cycles(hi2c, n + Size + 2U);
+    Sim_Busy(SIM_HAL_CALL_CYCLES + Sim_I2C_Cycles(hi2c, n + Size + 2U), &hi2c->sim.stats);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout)
+{
+    Sim_I2CDevice *dev = Sim_I2C_Find(hi2c, DevAddress);
+    UNUSED(Timeout);
+
+    if (hi2c->State == HAL_I2C_STATE_BUSY_TX || hi2c->State == HAL_I2C_STATE_BUSY_RX) {
+        return HAL_BUSY;
+    }
+    hi2c->sim.stats.calls++;
+    for (uint32_t i = 0; i < Trials; i++) {
+        hi2c->sim.stats.transactions++;
+        Sim_Busy(SIM_HAL_CALL_CYCLES + Sim_I2C_Cycles(hi2c, 1), &hi2c->sim.stats);
+        if (Sim_I2C_Ack(dev)) {
+            return HAL_OK;
+        }
+    }
+    hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+    return HAL_ERROR;
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c)
+{
+    Sim_Advance(SIM_POLL_CYCLES);
+    return hi2c->State;
+}
+
+/* ============================================================================
+ * DMA / IT Transfers
+ * ========================================================================= */
+
+static void Sim_I2C_DmaDone(void *ctx)
+{
+    I2C_HandleTypeDef *hi2c = (I2C_HandleTypeDef *)ctx;
+    Sim_I2CBus *bus = &hi2c->sim;
+    Sim_I2CDevice *dev = Sim_I2C_Find(hi2c, bus->pending_addr);
+    uint8_t op = bus->pending_op;
+    bool ok;
+
+    bus->pending_op = 0;
+    if (op == SIM_I2C_OP_MEM_TX) {
+        ok = Sim_I2C_Ack(dev) && (!dev->write || dev->write(dev, bus->scratch, bus->pending_len));
+    } else {
+        ok = Sim_I2C_Ack(dev) && dev->read && dev->read(dev, bus->pending_rx, bus->pending_len);
+    }
+    hi2c->State = HAL_I2C_STATE_READY;
+    if (!ok) {
+        hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+        HAL_I2C_ErrorCallback(hi2c);
+    } else if (op == SIM_I2C_OP_MEM_TX) {
+        HAL_I2C_MemTxCpltCallback(hi2c);
+    } else {
+        HAL_I2C_MemRxCpltCallback(hi2c);
+    }
+}
+
+static HAL_StatusTypeDef Sim_I2C_MemWriteAsync(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, bool dma)
+{
+    Sim_I2CBus *bus = &hi2c->sim;
+
+    if (hi2c->State == HAL_I2C_STATE_BUSY_TX || hi2c->State == HAL_I2C_STATE_BUSY_RX) {
+        return HAL_BUSY;
+    }
+    bus->stats.calls++;
+    bus->stats.transactions++;
+    if (dma) {
+        bus->stats.dma_transfers++;
+    }
+    Sim_Busy(SIM_HAL_CALL_CYCLES, &bus->stats);
+
+    hi2c->ErrorCode   = HAL_I2C_ERROR_NONE;
+    hi2c->State       = HAL_I2C_STATE_BUSY_TX;
+    bus->pending_addr = DevAddress;
+    bus->pending_len  = Sim_I2C_PackMem(hi2c, MemAddress, MemAddSize, pData, Size);
+    bus->pending_op   = SIM_I2C_OP_MEM_TX;
+    bus->stats.tx_bytes   += Size;
+    bus->stats.bus_cycles += Sim_I2C_Cycles(hi2c, bus->pending_len + 1U);
+    Sim_Schedule(Sim_I2C_Cycles(hi2c, bus->pending_len + 1U), Sim_I2C_DmaDone, hi2c, true);
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef Sim_I2C_MemReadAsync(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, bool dma)
+{
+    Sim_I2CBus *bus = &hi2c->sim;
+    Sim_I2CDevice *dev = Sim_I2C_Find(hi2c, DevAddress);
+    uint16_t n;
+
+    if (hi2c->State == HAL_I2C_STATE_BUSY_TX || hi2c->State == HAL_I2C_STATE_BUSY_RX) {
+        return HAL_BUSY;
+    }
+    bus->stats.calls++;
+    bus->stats.transactions++;
+    if (dma) {
+        bus->stats.dma_transfers++;
+    }
+    Sim_Busy(SIM_HAL_CALL_CYCLES, &bus->stats);
+
+    /* Address phase is latched immediately; data moves on completion */
+    n = Sim_I2C_PackMem(hi2c, MemAddress, MemAddSize, NULL, 0);
+    if (!Sim_I2C_Ack(dev) || (dev->write && !dev->write(dev, bus->scratch, n))) {
+        return Sim_I2C_Nack(hi2c);
+    }
+    hi2c->ErrorCode   = HAL_I2C_ERROR_NONE;
+    hi2c->State       = HAL_I2C_STATE_BUSY_RX;
+    bus->pending_addr = DevAddress;
+    bus->pending_rx   = pData;
+    bus->pending_len  = Size;
+    bus->pending_op   = SIM_I2C_OP_MEM_RX;
+    bus->stats.rx_bytes   += Size;
+    bus->stats.bus_cycles += Sim_I2C_Cycles(hi2c, n + Size + 2U);
+    Sim_Schedule(Sim_I2C_Cycles(hi2c, n + Size + 2U), Sim_I2C_DmaDone, hi2c, true);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size)
+{
+    return Sim_I2C_MemWriteAsync(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size, true);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size)
+{
+    return Sim_I2C_MemReadAsync(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size, true);
+}
+
+/* Interrupt-driven transfers: same bus timing, the per-byte ISR cost is not charged */
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size)
+{
+    return Sim_I2C_MemWriteAsync(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size, false);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size)
+{
+    return Sim_I2C_MemReadAsync(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size, false);
+}
+
+__weak void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c) { UNUSED(hi2c); }
+__weak void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c) { UNUSED(hi2c); }
+__weak void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)     { UNUSED(hi2c); }
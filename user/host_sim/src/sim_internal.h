@@ -0,0 +1,19 @@
+/**
+ * @file sim_internal.h
+ * @brief Helpers shared between the simulated peripherals
+ */
+
+#ifndef __SIM_INTERNAL_H__
+#define __SIM_INTERNAL_H__
+
+#include "sim_hal.h"
+
+/** Queue an interrupt-class event now and run it unless masked. */
+void Sim_RaiseIrq(Sim_EventFn fn, void *ctx);
+
+/** Burn CPU cycles inside a blocking HAL call and account them. */
+void Sim_Busy(uint64_t cycles, Sim_BusStats *stats);
+
+void Sim_GPIO_Reset(void);
+
+#endif /* __SIM_INTERNAL_H__ */
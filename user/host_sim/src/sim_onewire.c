@@ -0,0 +1,271 @@
+/**
+ * @file sim_onewire.c
+ * @brief 1-Wire bus and DS18B20 models
+ */
+
+#include "sim_onewire.h"
+#include <string.h>
+
+#define SIM_ONEWIRE_RESET_BAUD  20000U      // Slower chars are reset pulses
+#define SIM_ONEWIRE_PRESENCE    0xE0
+#define SIM_ONEWIRE_PULLED_LOW  0xF8        // Read slot held low by a slave
+
+enum {
+    SIM_OW_IDLE = 0,        // Not selected, waiting for a reset
+    SIM_OW_ROM_CMD,
+    SIM_OW_MATCH,
+    SIM_OW_SEARCH,
+    SIM_OW_READ_ROM,
+    SIM_OW_FUNC_CMD,
+    SIM_OW_READ_SP,
+    SIM_OW_WRITE_SP,
+    SIM_OW_CONVERT,
+    SIM_OW_POWER
+};
+
+static const uint8_t sim_ds18b20_power_on[8] = {0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10};
+
+static uint8_t Sim_OneWire_Crc8(const uint8_t *data, uint16_t len)
+{
+    uint8_t crc = 0;
+
+    while (len--) {
+        uint8_t byte = *data++;
+
+        for (uint8_t b = 0; b < 8; b++) {
+            uint8_t mix = (crc ^ byte) & 0x01;
+
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+static uint8_t Sim_OneWire_Bit(const uint8_t *bytes, uint16_t bit)
+{
+    return (bytes[bit / 8] >> (bit % 8)) & 1U;
+}
+
+static uint8_t Sim_DS18B20_Resolution(const Sim_DS18B20 *dev)
+{
+    return (uint8_t)(9 + ((dev->scratch[4] >> 5) & 0x03));
+}
+
+// Conversion result lands in the scratchpad when the conversion time is over
+static void Sim_DS18B20_Update(Sim_DS18B20 *dev)
+{
+    int16_t raw, whole;
+
+    if (dev->conv_until == 0 || Sim_Now() < dev->conv_until) {
+        return;
+    }
+    dev->conv_until = 0;
+
+    // Undefined low bits below 12-bit resolution read as 0
+    raw = (int16_t)(dev->temp & ~((1 << (12 - Sim_DS18B20_Resolution(dev))) - 1));
+    dev->scratch[0] = (uint8_t)raw;
+    dev->scratch[1] = (uint8_t)((uint16_t)raw >> 8);
+    dev->scratch[8] = Sim_OneWire_Crc8(dev->scratch, 8);
+
+    whole = (int16_t)(raw >> 4);
+    dev->alarm = (whole > (int8_t)dev->scratch[2]) || (whole <= (int8_t)dev->scratch[3]);
+}
+
+// Level the device drives in a read slot (1: released)
+static uint8_t Sim_DS18B20_Output(const Sim_DS18B20 *dev)
+{
+    switch (dev->state) {
+    case SIM_OW_SEARCH:
+        if (dev->search_phase == 2) return 1;
+        return (uint8_t)(Sim_OneWire_Bit(dev->rom, dev->bit) ^ dev->search_phase);
+    case SIM_OW_READ_ROM:
+        return Sim_OneWire_Bit(dev->rom, dev->bit);
+    case SIM_OW_READ_SP:
+        return (dev->bit < 72) ? Sim_OneWire_Bit(dev->shift, dev->bit) : 1;
+    case SIM_OW_CONVERT:
+        return (dev->conv_until == 0) ? 1 : 0;
+    default:
+        return 1;
+    }
+}
+
+static void Sim_DS18B20_Function(Sim_OneWire *bus, Sim_DS18B20 *dev, uint8_t cmd)
+{
+    dev->state = SIM_OW_IDLE;
+    if (dev->rom[0] != 0x28) {
+        return;
+    }
+
+    switch (cmd) {
+    case 0x44:  // Convert T: 93.75 ms at 9 bits, doubling per bit
+        dev->conv_until = Sim_Now() + Sim_UsToCycles(750000U >> (12 - Sim_DS18B20_Resolution(dev)));
+        dev->state = SIM_OW_CONVERT;
+        bus->stats.converts++;
+        break;
+    case 0xBE:  // Read Scratchpad
+        memcpy(dev->shift, dev->scratch, sizeof(dev->scratch));
+        if (dev->crc_faults) {
+            dev->crc_faults--;
+            dev->shift[0] ^= 0x01;
+        }
+        dev->state = SIM_OW_READ_SP;
+        bus->stats.sp_reads++;
+        break;
+    case 0x4E:  // Write Scratchpad: TH, TL, config
+        memset(dev->shift, 0, sizeof(dev->shift));
+        dev->state = SIM_OW_WRITE_SP;
+        break;
+    case 0xB4:  // Read Power Supply: externally powered
+        dev->state = SIM_OW_POWER;
+        break;
+    default:    // Copy / Recall EEPROM: nothing to model
+        break;
+    }
+}
+
+static void Sim_DS18B20_Sample(Sim_OneWire *bus, Sim_DS18B20 *dev, uint8_t level)
+{
+    switch (dev->state) {
+    case SIM_OW_ROM_CMD:
+    case SIM_OW_FUNC_CMD:
+        if (dev->bit == 0) dev->shift[0] = 0;
+        dev->shift[0] |= (uint8_t)(level << dev->bit);
+        if (++dev->bit < 8) return;
+        dev->bit = 0;
+        if (dev->state == SIM_OW_FUNC_CMD) {
+            Sim_DS18B20_Function(bus, dev, dev->shift[0]);
+            return;
+        }
+        switch (dev->shift[0]) {
+        case 0x33: dev->state = SIM_OW_READ_ROM; break;
+        case 0x55: dev->state = SIM_OW_MATCH;    break;
+        case 0xCC: dev->state = SIM_OW_FUNC_CMD; break;
+        case 0xF0: dev->state = SIM_OW_SEARCH;   break;
+        case 0xEC: dev->state = dev->alarm ? SIM_OW_SEARCH : SIM_OW_IDLE; break;
+        default:   dev->state = SIM_OW_IDLE;     break;
+        }
+        dev->search_phase = 0;
+        return;
+
+    case SIM_OW_MATCH:
+        if (level != Sim_OneWire_Bit(dev->rom, dev->bit)) {
+            dev->state = SIM_OW_IDLE;
+        } else if (++dev->bit == 64) {
+            dev->bit = 0;
+            dev->state = SIM_OW_FUNC_CMD;
+        }
+        return;
+
+    case SIM_OW_SEARCH:
+        if (dev->search_phase < 2) {
+            dev->search_phase++;
+            return;
+        }
+        dev->search_phase = 0;
+        if (level != Sim_OneWire_Bit(dev->rom, dev->bit)) {
+            dev->state = SIM_OW_IDLE;   // Lost this branch
+        } else if (++dev->bit == 64) {
+            dev->bit = 0;
+            dev->state = SIM_OW_FUNC_CMD;
+        }
+        return;
+
+    case SIM_OW_READ_ROM:
+        if (++dev->bit == 64) {
+            dev->bit = 0;
+            dev->state = SIM_OW_FUNC_CMD;
+        }
+        return;
+
+    case SIM_OW_READ_SP:
+        if (dev->bit < 72) dev->bit++;
+        return;
+
+    case SIM_OW_WRITE_SP:
+        dev->shift[dev->bit / 8] |= (uint8_t)(level << (dev->bit % 8));
+        if (++dev->bit < 24) return;
+        dev->scratch[2] = dev->shift[0];
+        dev->scratch[3] = dev->shift[1];
+        dev->scratch[4] = (uint8_t)((dev->shift[2] & 0x60) | 0x1F);
+        dev->scratch[8] = Sim_OneWire_Crc8(dev->scratch, 8);
+        dev->state = SIM_OW_IDLE;
+        return;
+
+    default:
+        return;
+    }
+}
+
+static uint8_t Sim_OneWire_Line(void *ctx, uint8_t tx)
+{
+    Sim_OneWire *bus = (Sim_OneWire *)ctx;
+    bool presence = false;
+    uint8_t level;
+
+    for (uint8_t i = 0; i < bus->count; i++) {
+        Sim_DS18B20_Update(&bus->dev[i]);
+    }
+
+    if (bus->huart->Init.BaudRate < SIM_ONEWIRE_RESET_BAUD) {
+        bus->stats.resets++;
+        for (uint8_t i = 0; i < bus->count; i++) {
+            Sim_DS18B20 *dev = &bus->dev[i];
+
+            dev->state = dev->present ? SIM_OW_ROM_CMD : SIM_OW_IDLE;
+            dev->bit = 0;
+            dev->search_phase = 0;
+            presence |= dev->present;
+        }
+        if (!presence) return tx;
+        bus->stats.presences++;
+        return SIM_ONEWIRE_PRESENCE;
+    }
+
+    // Only a full 0xFF leaves the line high past the slaves' sampling point
+    bus->stats.slots++;
+    level = (tx == 0xFF) ? 1 : 0;
+    for (uint8_t i = 0; i < bus->count; i++) {
+        if (bus->dev[i].present && !Sim_DS18B20_Output(&bus->dev[i])) level = 0;
+    }
+    for (uint8_t i = 0; i < bus->count; i++) {
+        if (bus->dev[i].present) Sim_DS18B20_Sample(bus, &bus->dev[i], level);
+    }
+    return level ? tx : (uint8_t)(tx & SIM_ONEWIRE_PULLED_LOW);
+}
+
+void Sim_OneWire_Init(Sim_OneWire *bus, UART_HandleTypeDef *huart)
+{
+    memset(bus, 0, sizeof(*bus));
+    bus->huart = huart;
+    Sim_UART_SetLine(huart, Sim_OneWire_Line, bus);
+}
+
+Sim_DS18B20 *Sim_OneWire_AddDevice(Sim_OneWire *bus, uint8_t family, uint64_t serial)
+{
+    Sim_DS18B20 *dev;
+
+    if (bus->count >= SIM_ONEWIRE_MAX_DEVICES) {
+        return NULL;
+    }
+    dev = &bus->dev[bus->count++];
+    memset(dev, 0, sizeof(*dev));
+
+    dev->rom[0] = family;
+    for (uint8_t i = 0; i < 6; i++) {
+        dev->rom[1 + i] = (uint8_t)(serial >> (8 * i));
+    }
+    dev->rom[7] = Sim_OneWire_Crc8(dev->rom, 7);
+    dev->present = true;
+
+    memcpy(dev->scratch, sim_ds18b20_power_on, sizeof(sim_ds18b20_power_on));
+    dev->scratch[8] = Sim_OneWire_Crc8(dev->scratch, 8);
+    dev->temp = 0x0190;     // 25 degrees C
+    return dev;
+}
+
+void Sim_DS18B20_SetTemp(Sim_DS18B20 *dev, float celsius)
+{
+    dev->temp = (int16_t)(celsius * 16.0f + (celsius < 0 ? -0.5f : 0.5f));
+}
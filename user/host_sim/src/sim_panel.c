@@ -0,0 +1,172 @@
+/**
+ * @file sim_panel.c
+ * @brief MIPI-DCS SPI TFT panel model
+ */
+
+#include "sim_panel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DCS_CASET   0x2A
+#define DCS_PASET   0x2B
+#define DCS_RAMWR   0x2C
+#define DCS_MADCTL  0x36
+#define DCS_COLMOD  0x3A
+#define MADCTL_MV   0x20
+
+/* ============================================================================
+ * Helpers
+ * ========================================================================= */
+
+static uint16_t Sim_Panel_LogicalWidth(const Sim_Panel *p)
+{
+    return (p->madctl & MADCTL_MV) ? p->height : p->width;
+}
+
+static uint16_t Sim_Panel_LogicalHeight(const Sim_Panel *p)
+{
+    return (p->madctl & MADCTL_MV) ? p->width : p->height;
+}
+
+uint16_t Sim_Panel_GetPixel(const Sim_Panel *p, uint16_t x, uint16_t y)
+{
+    if (x >= Sim_Panel_LogicalWidth(p) || y >= Sim_Panel_LogicalHeight(p)) {
+        return 0;
+    }
+    return p->fb[(size_t)y * Sim_Panel_LogicalWidth(p) + x];
+}
+
+static void Sim_Panel_PutPixel(Sim_Panel *p, uint16_t color)
+{
+    p->stats.pixels++;
+    if (p->cy > p->ye) {
+        p->stats.out_of_window++;
+        return;
+    }
+    if (p->cx < Sim_Panel_LogicalWidth(p) && p->cy < Sim_Panel_LogicalHeight(p)) {
+        p->fb[(size_t)p->cy * Sim_Panel_LogicalWidth(p) + p->cx] = color;
+    }
+    if (++p->cx > p->xe) {
+        p->cx = p->xs;
+        p->cy++;
+    }
+}
+
+/* ============================================================================
+ * SPI Slave Callbacks
+ * ========================================================================= */
+
+static void Sim_Panel_Select(Sim_SPIDevice *spi, bool selected)
+{
+    Sim_Panel *p = (Sim_Panel *)spi;
+    /* Byte assembly restarts on CS, the command context does not */
+    if (selected) {
+        p->pix_pos = 0;
+    }
+}
+
+static void Sim_Panel_Command(Sim_Panel *p, uint8_t cmd)
+{
+    p->stats.commands++;
+    p->cmd = cmd;
+    p->param_pos = 0;
+    p->pix_pos = 0;
+    if (cmd == DCS_RAMWR) {
+        p->stats.ramwr++;
+        p->cx = p->xs;
+        p->cy = p->ys;
+    }
+}
+
+static void Sim_Panel_Data(Sim_Panel *p, uint8_t b)
+{
+    p->stats.data_bytes++;
+
+    switch (p->cmd) {
+    case DCS_CASET:
+    case DCS_PASET:
+        if (p->param_pos < 4) p->param[p->param_pos++] = b;
+        if (p->param_pos == 4) {
+            uint16_t s = (uint16_t)((p->param[0] << 8) | p->param[1]);
+            uint16_t e = (uint16_t)((p->param[2] << 8) | p->param[3]);
+            if (p->cmd == DCS_CASET) {
+                p->xs = s; p->xe = e;
+            } else {
+                p->ys = s; p->ye = e;
+                p->stats.window_sets++;
+            }
+            p->param_pos++;
+        }
+        break;
+
+    case DCS_MADCTL:
+        p->madctl = b;
+        break;
+
+    case DCS_COLMOD:
+        p->colmod = b;
+        break;
+
+    case DCS_RAMWR:
+        p->pix[p->pix_pos++] = b;
+        if (p->pix_pos == p->bytes_per_pixel) {
+            uint16_t color;
+            if (p->bytes_per_pixel == 3) {
+                color = (uint16_t)(((p->pix[0] & 0xF8) << 8) | ((p->pix[1] & 0xFC) << 3) | (p->pix[2] >> 3));
+            } else {
+                color = (uint16_t)((p->pix[0] << 8) | p->pix[1]);
+            }
+            p->pix_pos = 0;
+            Sim_Panel_PutPixel(p, color);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+static uint8_t Sim_Panel_Exchange(Sim_SPIDevice *spi, uint8_t mosi)
+{
+    Sim_Panel *p = (Sim_Panel *)spi;
+
+    if (p->dc_port->ODR & p->dc_pin) {
+        Sim_Panel_Data(p, mosi);
+    } else {
+        Sim_Panel_Command(p, mosi);
+    }
+    return 0xFF;
+}
+
+/* ============================================================================
+ * Public API
+ * ========================================================================= */
+
+void Sim_Panel_Init(Sim_Panel *p, SPI_HandleTypeDef *hspi,
+                    GPIO_TypeDef *cs_port, uint16_t cs_pin,
+                    GPIO_TypeDef *dc_port, uint16_t dc_pin,
+                    uint16_t width, uint16_t height)
+{
+    memset(p, 0, sizeof(*p));
+    p->dc_port = dc_port;
+    p->dc_pin  = dc_pin;
+    p->width   = width;
+    p->height  = height;
+    p->bytes_per_pixel = 2;
+    p->xe = (uint16_t)(width - 1U);
+    p->ye = (uint16_t)(height - 1U);
+    p->fb = (uint16_t *)calloc((size_t)width * height, sizeof(uint16_t));
+
+    p->spi.cs_port  = cs_port;
+    p->spi.cs_pin   = cs_pin;
+    p->spi.select   = Sim_Panel_Select;
+    p->spi.exchange = Sim_Panel_Exchange;
+    HAL_GPIO_WritePin(cs_port, cs_pin, GPIO_PIN_SET);
+    Sim_SPI_Attach(hspi, &p->spi);
+}
+
+void Sim_Panel_Free(Sim_Panel *p)
+{
+    free(p->fb);
+    p->fb = NULL;
+}
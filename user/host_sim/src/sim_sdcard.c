@@ -0,0 +1,400 @@
+/**
+ * @file sim_sdcard.c
+ * @brief SD card SPI-mode model
+ */
+
+#include "sim_sdcard.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    SD_ST_CMD = 0,       // Waiting for a command frame
+    SD_ST_READ,          // CMD17/CMD18 data pending or streaming
+    SD_ST_WRITE_TOKEN,   // CMD24/CMD25 waiting for start token
+    SD_ST_WRITE_DATA     // Receiving 512 data + 2 CRC bytes
+};
+
+/* ============================================================================
+ * Output Queue
+ * ========================================================================= */
+
+static void Sim_SD_Push(Sim_SDCard *c, uint8_t b)
+{
+    uint16_t next = (uint16_t)((c->out_head + 1U) % sizeof(c->out));
+    if (next != c->out_tail) {
+        c->out[c->out_head] = b;
+        c->out_head = next;
+    }
+}
+
+static bool Sim_SD_Pop(Sim_SDCard *c, uint8_t *b)
+{
+    if (c->out_head == c->out_tail) return false;
+    *b = c->out[c->out_tail];
+    c->out_tail = (uint16_t)((c->out_tail + 1U) % sizeof(c->out));
+    return true;
+}
+
+static void Sim_SD_R1(Sim_SDCard *c, uint8_t r1)
+{
+    Sim_SD_Push(c, 0xFF);   // Ncr = 1
+    Sim_SD_Push(c, r1);
+}
+
+static uint32_t Sim_SD_Block(Sim_SDCard *c, uint32_t arg)
+{
+    return c->sdhc ? arg : arg / SIM_SD_BLOCK_SIZE;
+}
+
+static void Sim_SD_Csd(Sim_SDCard *c, uint8_t csd[16])
+{
+    memset(csd, 0, 16);
+    csd[1]  = 0x0E;                 // TAAC
+    csd[3]  = 0x32;                 // TRAN_SPEED 25 MHz
+    csd[4]  = 0x5B;
+    csd[5]  = 0x59;                 // CCC / READ_BL_LEN = 9
+    if (c->sdhc) {
+        uint32_t c_size = c->blocks / 1024U - 1U;
+
+        csd[0]  = 0x40;             // CSD_STRUCTURE = 1 (v2.0)
+        csd[7]  = (uint8_t)((c_size >> 16) & 0x3F);
+        csd[8]  = (uint8_t)(c_size >> 8);
+        csd[9]  = (uint8_t)c_size;
+    } else {
+        // CSD 1.0: blocks = (C_SIZE + 1) << (C_SIZE_MULT + 2)
+        uint32_t mult = 0, c_size;
+
+        while (mult < 7 && (c->blocks >> (mult + 2)) > 4096U) mult++;
+        c_size = (c->blocks >> (mult + 2)) - 1U;
+        csd[6]  = (uint8_t)((c_size >> 10) & 0x03);
+        csd[7]  = (uint8_t)(c_size >> 2);
+        csd[8]  = (uint8_t)((c_size & 0x03) << 6);
+        csd[9]  = (uint8_t)((mult >> 1) & 0x03);
+        csd[10] = (uint8_t)((mult & 0x01) << 7);
+    }
+    csd[10] |= 0x7F;                // ERASE_BLK_EN, SECTOR_SIZE = 127 (64 KB)
+    csd[11] = 0x80;
+    csd[12] = 0x0A;                 // R2W_FACTOR, WRITE_BL_LEN = 9
+    csd[13] = 0x40;
+    csd[15] = 0x01;
+}
+
+/* ============================================================================
+ * Command Execution
+ * ========================================================================= */
+
+static void Sim_SD_Command(Sim_SDCard *c)
+{
+    uint8_t  cmd = c->frame[0] & 0x3F;
+    uint32_t arg = ((uint32_t)c->frame[1] << 24) | ((uint32_t)c->frame[2] << 16) |
+                   ((uint32_t)c->frame[3] << 8)  | c->frame[4];
+    bool app = c->app_cmd;
+    uint8_t r1_idle = c->idle ? 0x01 : 0x00;
+
+    c->app_cmd = false;
+    c->stats.commands++;
+
+    if (cmd == 0) {
+        c->idle = true;
+        c->state = SD_ST_CMD;
+        Sim_SD_R1(c, 0x01);
+        return;
+    }
+    if (c->idle && cmd != 8 && cmd != 55 && cmd != 41 && cmd != 58 && cmd != 1) {
+        Sim_SD_R1(c, 0x05);   // Idle + illegal command
+        c->stats.protocol_errors++;
+        return;
+    }
+
+    switch (cmd) {
+    case 8:
+        Sim_SD_R1(c, r1_idle);
+        Sim_SD_Push(c, 0x00);
+        Sim_SD_Push(c, 0x00);
+        Sim_SD_Push(c, (uint8_t)((arg >> 8) & 0x0F));
+        Sim_SD_Push(c, (uint8_t)arg);
+        break;
+
+    case 55:
+        c->app_cmd = true;
+        Sim_SD_R1(c, r1_idle);
+        break;
+
+    case 41:
+        if (!app) {
+            Sim_SD_R1(c, r1_idle | 0x04);
+            break;
+        }
+        if (c->acmd41_polls) {
+            c->acmd41_polls--;
+        } else {
+            c->idle = false;
+        }
+        Sim_SD_R1(c, c->idle ? 0x01 : 0x00);
+        break;
+
+    case 58:
+        Sim_SD_R1(c, r1_idle);
+        Sim_SD_Push(c, (uint8_t)(c->idle ? 0x00 : (0x80 | (c->sdhc ? 0x40 : 0x00))));
+        Sim_SD_Push(c, 0xFF);
+        Sim_SD_Push(c, 0x80);
+        Sim_SD_Push(c, 0x00);
+        break;
+
+    case 16:
+        Sim_SD_R1(c, (arg == SIM_SD_BLOCK_SIZE || c->sdhc) ? 0x00 : 0x40);
+        break;
+
+    case 13:
+        Sim_SD_R1(c, 0x00);
+        Sim_SD_Push(c, 0x00);
+        break;
+
+    case 9:
+    case 10: {
+        uint8_t reg[16];
+        if (cmd == 9) {
+            Sim_SD_Csd(c, reg);
+        } else {
+            memset(reg, 0, sizeof(reg));
+            memcpy(reg, "\x03SDSIM00", 8);
+        }
+        Sim_SD_R1(c, 0x00);
+        Sim_SD_Push(c, 0xFF);
+        Sim_SD_Push(c, 0xFE);
+        for (int i = 0; i < 16; i++) Sim_SD_Push(c, reg[i]);
+        Sim_SD_Push(c, 0xFF);
+        Sim_SD_Push(c, 0xFF);
+        break;
+    }
+
+    case 23:
+        if (app) {
+            c->stats.acmd23++;
+            c->pre_erase = arg & 0x7FFFFFU;
+        }
+        Sim_SD_R1(c, 0x00);
+        break;
+
+    case 12:
+        c->stats.cmd12++;
+        c->state = SD_ST_CMD;
+        c->out_head = c->out_tail = 0;
+        Sim_SD_Push(c, 0xFF);   // Stuff byte
+        Sim_SD_R1(c, 0x00);
+        c->busy_until = Sim_Now() + Sim_UsToCycles(c->t_stop_us);
+        break;
+
+    case 17:
+    case 18:
+        if (Sim_SD_Block(c, arg) >= c->blocks) {
+            Sim_SD_R1(c, 0x20);
+            break;
+        }
+        if (cmd == 17) c->stats.cmd17++; else c->stats.cmd18++;
+        Sim_SD_R1(c, 0x00);
+        c->block    = Sim_SD_Block(c, arg);
+        c->multi    = (cmd == 18);
+        c->state    = SD_ST_READ;
+        c->ready_at = Sim_Now() + Sim_UsToCycles(c->t_read_first_us);
+        break;
+
+    case 24:
+    case 25:
+        if (Sim_SD_Block(c, arg) >= c->blocks) {
+            Sim_SD_R1(c, 0x20);
+            break;
+        }
+        if (cmd == 24) c->stats.cmd24++; else c->stats.cmd25++;
+        Sim_SD_R1(c, 0x00);
+        c->block = Sim_SD_Block(c, arg);
+        c->multi = (cmd == 25);
+        c->state = SD_ST_WRITE_TOKEN;
+        c->pre_erase_end = c->multi && c->pre_erase ? c->block + c->pre_erase : 0;
+        c->pre_erase = 0;
+        break;
+
+    default:
+        c->stats.protocol_errors++;
+        Sim_SD_R1(c, 0x04);
+        break;
+    }
+}
+
+/* ============================================================================
+ * SPI Slave Callbacks
+ * ========================================================================= */
+
+static void Sim_SD_Select(Sim_SPIDevice *spi, bool selected)
+{
+    Sim_SDCard *c = (Sim_SDCard *)spi;
+
+    c->frame_pos = 0;
+    if (!selected) {
+        c->out_head = c->out_tail = 0;
+        if (c->state == SD_ST_READ) {
+            c->state = SD_ST_CMD;
+        }
+    }
+}
+
+static void Sim_SD_ReadNext(Sim_SDCard *c)
+{
+    uint8_t *src = &c->mem[(size_t)c->block * SIM_SD_BLOCK_SIZE];
+
+    Sim_SD_Push(c, 0xFE);
+    for (uint32_t i = 0; i < SIM_SD_BLOCK_SIZE; i++) Sim_SD_Push(c, src[i]);
+    Sim_SD_Push(c, 0xFF);   // CRC (not checked in SPI mode)
+    Sim_SD_Push(c, 0xFF);
+    c->stats.blocks_read++;
+
+    if (c->multi && c->block + 1U < c->blocks) {
+        c->block++;
+        c->ready_at = Sim_Now() + Sim_UsToCycles(c->t_read_next_us);
+    } else {
+        c->state = SD_ST_CMD;
+    }
+}
+
+static uint8_t Sim_SD_Exchange(Sim_SPIDevice *spi, uint8_t mosi)
+{
+    Sim_SDCard *c = (Sim_SDCard *)spi;
+    uint8_t miso = 0xFF;    // Bus idle
+
+    /* 1. Drive MISO */
+    if (!Sim_SD_Pop(c, &miso)) {
+        if (Sim_Now() < c->busy_until) {
+            miso = 0x00;
+            c->stats.busy_polls++;
+        } else if (c->state == SD_ST_READ && Sim_Now() >= c->ready_at) {
+            Sim_SD_ReadNext(c);
+            Sim_SD_Pop(c, &miso);
+        } else {
+            miso = 0xFF;
+        }
+    }
+
+    /* 2. Sample MOSI */
+    switch (c->state) {
+    case SD_ST_WRITE_TOKEN:
+        if (Sim_Now() < c->busy_until || mosi == 0xFF) {
+            break;
+        }
+        if (mosi == 0xFE && !c->multi) {
+            c->state = SD_ST_WRITE_DATA;
+            c->data_pos = 0;
+        } else if (mosi == 0xFC && c->multi) {
+            c->state = SD_ST_WRITE_DATA;
+            c->data_pos = 0;
+        } else if (mosi == 0xFD && c->multi) {
+            // Pre-erased blocks the stream never reached
+            for (; c->block < c->pre_erase_end && c->block < c->blocks; c->block++) {
+                memset(&c->mem[(size_t)c->block * SIM_SD_BLOCK_SIZE], 0, SIM_SD_BLOCK_SIZE);
+                c->stats.blocks_pre_erased++;
+            }
+            c->pre_erase_end = 0;
+            c->state = SD_ST_CMD;
+            Sim_SD_Push(c, 0xFF);
+            c->busy_until = Sim_Now() + Sim_UsToCycles(c->t_stop_us);
+        } else {
+            c->stats.protocol_errors++;
+        }
+        break;
+
+    case SD_ST_WRITE_DATA:
+        c->data[c->data_pos++] = mosi;
+        if (c->data_pos == SIM_SD_BLOCK_SIZE + 2U) {
+            memcpy(&c->mem[(size_t)c->block * SIM_SD_BLOCK_SIZE], c->data, SIM_SD_BLOCK_SIZE);
+            c->stats.blocks_written++;
+            Sim_SD_Push(c, 0xE5);   // Data accepted
+            c->busy_until = Sim_Now() + Sim_UsToCycles(c->multi ? c->t_write_multi_us
+                                                                 : c->t_write_single_us);
+            if (c->multi && c->block + 1U < c->blocks) {
+                c->block++;
+                c->state = SD_ST_WRITE_TOKEN;
+            } else {
+                c->state = SD_ST_CMD;
+            }
+        }
+        break;
+
+    default:
+        /* Command frames may arrive in idle or during CMD18 streaming */
+        if (c->frame_pos == 0) {
+            if ((mosi & 0xC0) == 0x40) {
+                c->frame[c->frame_pos++] = mosi;
+            }
+        } else {
+            c->frame[c->frame_pos++] = mosi;
+            if (c->frame_pos == 6) {
+                c->frame_pos = 0;
+                if (c->state == SD_ST_READ && (c->frame[0] & 0x3F) != 12) {
+                    c->stats.protocol_errors++;
+                }
+                Sim_SD_Command(c);
+            }
+        }
+        break;
+    }
+    return miso;
+}
+
+/* ============================================================================
+ * Public API
+ * ========================================================================= */
+
+void Sim_SDCard_Init(Sim_SDCard *card, SPI_HandleTypeDef *hspi,
+                     GPIO_TypeDef *cs_port, uint16_t cs_pin, uint32_t blocks, bool sdhc)
+{
+    memset(card, 0, sizeof(*card));
+    card->blocks = blocks;
+    card->sdhc   = sdhc;
+    card->idle   = true;
+    card->acmd41_polls = 2;
+    card->mem = (uint8_t *)malloc((size_t)blocks * SIM_SD_BLOCK_SIZE);
+    memset(card->mem, 0, (size_t)blocks * SIM_SD_BLOCK_SIZE);
+
+    card->t_read_first_us   = 300;
+    card->t_read_next_us    = 60;
+    card->t_write_single_us = 900;
+    card->t_write_multi_us  = 180;
+    card->t_stop_us         = 250;
+
+    card->spi.cs_port  = cs_port;
+    card->spi.cs_pin   = cs_pin;
+    card->spi.select   = Sim_SD_Select;
+    card->spi.exchange = Sim_SD_Exchange;
+    HAL_GPIO_WritePin(cs_port, cs_pin, GPIO_PIN_SET);
+    Sim_SPI_Attach(hspi, &card->spi);
+}
+
+void Sim_SDCard_Free(Sim_SDCard *card)
+{
+    free(card->mem);
+    card->mem = NULL;
+}
+
+int Sim_SDCard_LoadImage(Sim_SDCard *card, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    size_t size = (size_t)card->blocks * SIM_SD_BLOCK_SIZE;
+    size_t n;
+
+    if (f == NULL) return -1;
+    n = fread(card->mem, 1, size, f);
+    fclose(f);
+    if (n < size) memset(card->mem + n, 0, size - n);
+    return 0;
+}
+
+int Sim_SDCard_SaveImage(const Sim_SDCard *card, const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    size_t size = (size_t)card->blocks * SIM_SD_BLOCK_SIZE;
+    size_t n;
+
+    if (f == NULL) return -1;
+    n = fwrite(card->mem, 1, size, f);
+    return (fclose(f) == 0 && n == size) ? 0 : -1;
+}
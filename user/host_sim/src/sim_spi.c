@@ -0,0 +1,227 @@
+/**
+ * @file sim_spi.c
+ * @brief Simulated SPI master with chip-select routed slave models
+ *
+ * Polled transfers clock one byte at a time and advance virtual time by the
+ * wire time plus a small per-byte gap (FIFO polling). DMA transfers move
+ * the data when the last bit leaves the wire and then raise the completion
+ * interrupt, so a driver that releases CS before the callback loses data.
+ */
+
+#include "sim_hal.h"
+#include "sim_internal.h"
+
+enum {
+    SIM_SPI_OP_TX = 1,
+    SIM_SPI_OP_RX,
+    SIM_SPI_OP_TXRX
+};
+
+/* ============================================================================
+ * Bus Helpers
+ * ========================================================================= */
+
+static uint64_t Sim_SPI_ByteCycles(SPI_HandleTypeDef *hspi)
+{
+    uint32_t hz = hspi->sim.hz ? hspi->sim.hz : SIM_SPI_DEFAULT_HZ;
+    uint64_t c  = (8ULL * SystemCoreClock + hz - 1) / hz;
+    return c ? c : 1;
+}
+
+static uint8_t Sim_SPI_Clock(SPI_HandleTypeDef *hspi, uint8_t mosi)
+{
+    uint8_t miso = 0xFF;
+
+    for (Sim_SPIDevice *dev = hspi->sim.devices; dev; dev = dev->next) {
+        if (dev->selected && dev->exchange) {
+            miso &= dev->exchange(dev, mosi);
+        }
+    }
+    return miso;
+}
+
+static void Sim_SPI_CsWatch(void *ctx, GPIO_PinState state)
+{
+    Sim_SPIDevice *dev = (Sim_SPIDevice *)ctx;
+    bool selected = (state == GPIO_PIN_RESET);
+
+    if (selected == dev->selected) {
+        return;
+    }
+    dev->selected = selected;
+    if (selected) {
+        dev->bus->sim.stats.transactions++;
+    }
+    if (dev->select) {
+        dev->select(dev, selected);
+    }
+}
+
+void Sim_SPI_Attach(SPI_HandleTypeDef *hspi, Sim_SPIDevice *dev)
+{
+    dev->bus      = hspi;
+    dev->selected = (dev->cs_port->ODR & dev->cs_pin) == 0;
+    dev->next     = hspi->sim.devices;
+    hspi->sim.devices = dev;
+    if (hspi->State == HAL_SPI_STATE_RESET) {
+        hspi->State = HAL_SPI_STATE_READY;
+    }
+    Sim_GPIO_Watch(dev->cs_port, dev->cs_pin, Sim_SPI_CsWatch, dev);
+}
+
+void Sim_SPI_SetClock(SPI_HandleTypeDef *hspi, uint32_t hz)
+{
+    hspi->sim.hz = hz;
+}
+
+Sim_BusStats *Sim_SPI_Stats(SPI_HandleTypeDef *hspi)
+{
+    return &hspi->sim.stats;
+}
+
+/* ============================================================================
+ * Blocking Transfers
+ * ========================================================================= */
+
+static HAL_StatusTypeDef Sim_SPI_Polled(SPI_HandleTypeDef *hspi, const uint8_t *tx,
+                                        uint8_t *rx, uint16_t size)
+{
+    Sim_BusStats *st = &hspi->sim.stats;
+    uint64_t byte_cycles = Sim_SPI_ByteCycles(hspi);
+
+    if (hspi->State != HAL_SPI_STATE_READY && hspi->State != HAL_SPI_STATE_RESET) {
+        return HAL_BUSY;
+    }
+    if (size == 0) {
+        return HAL_ERROR;
+    }
+
+    st->calls++;
+    Sim_Busy(SIM_HAL_CALL_CYCLES, st);
+    for (uint16_t i = 0; i < size; i++) {
+        uint8_t miso = Sim_SPI_Clock(hspi, tx ? tx[i] : 0xFF);
+        if (rx) rx[i] = miso;
+        st->bus_cycles += byte_cycles;
+        Sim_Busy(byte_cycles + SIM_SPI_POLL_GAP_CYCLES, st);
+    }
+    if (tx) st->tx_bytes += size;
+    if (rx) st->rx_bytes += size;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    UNUSED(Timeout);
+    return Sim_SPI_Polled(hspi, pData, NULL, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    UNUSED(Timeout);
+    return Sim_SPI_Polled(hspi, NULL, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, uint32_t Timeout)
+{
+    UNUSED(Timeout);
+    return Sim_SPI_Polled(hspi, pTxData, pRxData, Size);
+}
+
+/* ============================================================================
+ * DMA Transfers
+ * ========================================================================= */
+
+static void Sim_SPI_DmaIrq(void *ctx)
+{
+    SPI_HandleTypeDef *hspi = (SPI_HandleTypeDef *)ctx;
+    uint8_t op = hspi->sim.dma_op;
+
+    hspi->sim.dma_op = 0;
+    hspi->State = HAL_SPI_STATE_READY;
+    if (op == SIM_SPI_OP_TX) {
+        HAL_SPI_TxCpltCallback(hspi);
+    } else if (op == SIM_SPI_OP_RX) {
+        HAL_SPI_RxCpltCallback(hspi);
+    } else if (op == SIM_SPI_OP_TXRX) {
+        HAL_SPI_TxRxCpltCallback(hspi);
+    }
+}
+
+static void Sim_SPI_DmaDone(void *ctx)
+{
+    SPI_HandleTypeDef *hspi = (SPI_HandleTypeDef *)ctx;
+    Sim_SPIBus *bus = &hspi->sim;
+
+    for (uint16_t i = 0; i < bus->dma_len; i++) {
+        uint8_t miso = Sim_SPI_Clock(hspi, bus->dma_tx ? bus->dma_tx[i] : 0xFF);
+        if (bus->dma_rx) bus->dma_rx[i] = miso;
+    }
+    if (bus->dma_tx) bus->stats.tx_bytes += bus->dma_len;
+    if (bus->dma_rx) bus->stats.rx_bytes += bus->dma_len;
+    Sim_Schedule(0, Sim_SPI_DmaIrq, hspi, true);
+}
+
+static HAL_StatusTypeDef Sim_SPI_StartDma(SPI_HandleTypeDef *hspi, const uint8_t *tx,
+                                          uint8_t *rx, uint16_t size, uint8_t op)
+{
+    Sim_SPIBus *bus = &hspi->sim;
+    uint64_t wire;
+
+    if (hspi->State != HAL_SPI_STATE_READY && hspi->State != HAL_SPI_STATE_RESET) {
+        return HAL_BUSY;
+    }
+    if (size == 0) {
+        return HAL_ERROR;
+    }
+
+    bus->stats.calls++;
+    bus->stats.dma_transfers++;
+    Sim_Busy(SIM_HAL_CALL_CYCLES, &bus->stats);
+
+    hspi->State  = (op == SIM_SPI_OP_TX) ? HAL_SPI_STATE_BUSY_TX :
+                   (op == SIM_SPI_OP_RX) ? HAL_SPI_STATE_BUSY_RX : HAL_SPI_STATE_BUSY_TX_RX;
+    bus->dma_tx  = tx;
+    bus->dma_rx  = rx;
+    bus->dma_len = size;
+    bus->dma_op  = op;
+
+    wire = Sim_SPI_ByteCycles(hspi) * size;
+    bus->stats.bus_cycles += wire;
+    Sim_Schedule(wire, Sim_SPI_DmaDone, hspi, false);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size)
+{
+    return Sim_SPI_StartDma(hspi, pData, NULL, Size, SIM_SPI_OP_TX);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size)
+{
+    return Sim_SPI_StartDma(hspi, NULL, pData, Size, SIM_SPI_OP_RX);
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size)
+{
+    return Sim_SPI_StartDma(hspi, pTxData, pRxData, Size, SIM_SPI_OP_TXRX);
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi)
+{
+    Sim_Cancel(Sim_SPI_DmaDone, hspi);
+    Sim_Cancel(Sim_SPI_DmaIrq, hspi);
+    hspi->sim.dma_op = 0;
+    hspi->State = HAL_SPI_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi)
+{
+    Sim_Advance(SIM_POLL_CYCLES);
+    return hspi->State;
+}
+
+__weak void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)   { UNUSED(hspi); }
+__weak void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi)   { UNUSED(hspi); }
+__weak void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) { UNUSED(hspi); }
+__weak void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)    { UNUSED(hspi); }
@@ -0,0 +1,356 @@
+/**
+ * @file sim_tim.c
+ * @brief Simulated general-purpose timer (time base, PWM + DMA, input capture)
+ *
+ * The timer clock equals SystemCoreClock. CNT is derived from virtual time
+ * rather than stored, so reading it is always consistent with HAL_GetTick()
+ * and DWT->CYCCNT. PWM DMA moves one element into CCRx per update event.
+ */
+
+#include "sim_hal.h"
+#include "sim_internal.h"
+
+/* ============================================================================
+ * Helpers
+ * ========================================================================= */
+
+static uint32_t Sim_TIM_Psc(TIM_HandleTypeDef *htim)
+{
+    return htim->Instance ? htim->Instance->PSC : htim->Init.Prescaler;
+}
+
+static uint32_t Sim_TIM_Arr(TIM_HandleTypeDef *htim)
+{
+    return htim->Instance ? htim->Instance->ARR : htim->Init.Period;
+}
+
+static uint64_t Sim_TIM_PeriodCycles(TIM_HandleTypeDef *htim)
+{
+    return ((uint64_t)Sim_TIM_Psc(htim) + 1U) * ((uint64_t)Sim_TIM_Arr(htim) + 1U);
+}
+
+static int Sim_TIM_Index(uint32_t Channel)
+{
+    return (int)((Channel >> 2) & 0x3U);
+}
+
+static void Sim_TIM_Sync(TIM_HandleTypeDef *htim)
+{
+    if (htim->Instance && !htim->sim.running && !htim->sim.running_ch) {
+        htim->Instance->PSC = htim->Init.Prescaler;
+        htim->Instance->ARR = htim->Init.Period;
+    }
+}
+
+volatile uint32_t *Sim_TIM_CCR(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    switch (Channel) {
+    case TIM_CHANNEL_2: return &htim->Instance->CCR2;
+    case TIM_CHANNEL_3: return &htim->Instance->CCR3;
+    case TIM_CHANNEL_4: return &htim->Instance->CCR4;
+    default:            return &htim->Instance->CCR1;
+    }
+}
+
+uint32_t Sim_TIM_GetCounter(TIM_HandleTypeDef *htim)
+{
+    uint64_t ticks;
+
+    Sim_Advance(SIM_POLL_CYCLES);
+    if (!htim->sim.running && !htim->sim.running_ch) {
+        return htim->Instance ? htim->Instance->CNT : 0;
+    }
+    ticks = (Sim_Now() - htim->sim.start) / ((uint64_t)Sim_TIM_Psc(htim) + 1U);
+    htim->Instance->CNT = (uint32_t)(ticks % ((uint64_t)Sim_TIM_Arr(htim) + 1U));
+    return htim->Instance->CNT;
+}
+
+void Sim_TIM_SetCounter(TIM_HandleTypeDef *htim, uint32_t value)
+{
+    htim->Instance->CNT = value;
+    htim->sim.start = Sim_Now() - (uint64_t)value * ((uint64_t)Sim_TIM_Psc(htim) + 1U);
+}
+
+Sim_BusStats *Sim_TIM_Stats(TIM_HandleTypeDef *htim)
+{
+    return &htim->sim.stats;
+}
+
+void Sim_TIM_SetPwmSink(TIM_HandleTypeDef *htim, uint32_t Channel,
+                        void (*sink)(void *ctx, uint32_t ccr), void *ctx)
+{
+    htim->sim.pwm_sink[Sim_TIM_Index(Channel)]     = sink;
+    htim->sim.pwm_sink_ctx[Sim_TIM_Index(Channel)] = ctx;
+}
+
+static void Sim_TIM_Start(TIM_HandleTypeDef *htim)
+{
+    if (!htim->sim.running && !htim->sim.running_ch) {
+        Sim_TIM_Sync(htim);
+        htim->sim.start = Sim_Now() - (uint64_t)htim->Instance->CNT * ((uint64_t)Sim_TIM_Psc(htim) + 1U);
+    }
+}
+
+static void Sim_TIM_Freeze(TIM_HandleTypeDef *htim)
+{
+    if (!htim->sim.running && !htim->sim.running_ch) {
+        return;
+    }
+    (void)Sim_TIM_GetCounter(htim);
+}
+
+/* ============================================================================
+ * Time Base
+ * ========================================================================= */
+
+static void Sim_TIM_UpdateIrq(void *ctx)
+{
+    TIM_HandleTypeDef *htim = (TIM_HandleTypeDef *)ctx;
+
+    if (!htim->sim.update_it) {
+        return;
+    }
+    Sim_Schedule(Sim_TIM_PeriodCycles(htim), Sim_TIM_UpdateIrq, htim, true);
+    HAL_TIM_PeriodElapsedCallback(htim);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim)
+{
+    Sim_TIM_Start(htim);
+    htim->sim.running = true;
+    htim->State = HAL_TIM_STATE_BUSY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim)
+{
+    Sim_TIM_Freeze(htim);
+    htim->sim.running = false;
+    htim->State = HAL_TIM_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+{
+    uint64_t remaining;
+
+    Sim_TIM_Start(htim);
+    htim->sim.running   = true;
+    htim->sim.update_it = true;
+    htim->State = HAL_TIM_STATE_BUSY;
+    Sim_Cancel(Sim_TIM_UpdateIrq, htim);
+    remaining = Sim_TIM_PeriodCycles(htim) - ((Sim_Now() - htim->sim.start) % Sim_TIM_PeriodCycles(htim));
+    Sim_Schedule(remaining, Sim_TIM_UpdateIrq, htim, true);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim)
+{
+    Sim_Cancel(Sim_TIM_UpdateIrq, htim);
+    htim->sim.update_it = false;
+    return HAL_TIM_Base_Stop(htim);
+}
+
+/* ============================================================================
+ * PWM
+ * ========================================================================= */
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    Sim_TIM_Start(htim);
+    htim->sim.running_ch |= 1U << Sim_TIM_Index(Channel);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    Sim_TIM_Freeze(htim);
+    htim->sim.running_ch &= ~(1U << Sim_TIM_Index(Channel));
+    return HAL_OK;
+}
+
+typedef struct {
+    TIM_HandleTypeDef *htim;
+    uint32_t           channel;
+} Sim_TIMRef;
+
+static Sim_TIMRef s_tim_refs[8][4];
+static uint32_t   s_tim_ref_count;
+static TIM_HandleTypeDef *s_tim_ref_owner[8];
+
+static Sim_TIMRef *Sim_TIM_Ref(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    uint32_t i;
+    for (i = 0; i < s_tim_ref_count; i++) {
+        if (s_tim_ref_owner[i] == htim) break;
+    }
+    if (i == s_tim_ref_count) {
+        if (s_tim_ref_count >= 8) return NULL;
+        s_tim_ref_owner[s_tim_ref_count++] = htim;
+    }
+    Sim_TIMRef *ref = &s_tim_refs[i][Sim_TIM_Index(Channel)];
+    ref->htim    = htim;
+    ref->channel = Channel;
+    return ref;
+}
+
+static void Sim_TIM_PwmHalfIrq(void *ctx)
+{
+    Sim_TIMRef *ref = (Sim_TIMRef *)ctx;
+    ref->htim->Channel = (HAL_TIM_ActiveChannel)(1U << Sim_TIM_Index(ref->channel));
+    HAL_TIM_PWM_PulseFinishedHalfCpltCallback(ref->htim);
+    ref->htim->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+}
+
+static void Sim_TIM_PwmCpltIrq(void *ctx)
+{
+    Sim_TIMRef *ref = (Sim_TIMRef *)ctx;
+    ref->htim->Channel = (HAL_TIM_ActiveChannel)(1U << Sim_TIM_Index(ref->channel));
+    HAL_TIM_PWM_PulseFinishedCallback(ref->htim);
+    ref->htim->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+}
+
+/** One update event: the DMA request copies the next element into CCRx. */
+static void Sim_TIM_PwmDmaRequest(void *ctx)
+{
+    Sim_TIMRef *ref = (Sim_TIMRef *)ctx;
+    TIM_HandleTypeDef *htim = ref->htim;
+    Sim_TIMState *st = &htim->sim;
+    int idx = Sim_TIM_Index(ref->channel);
+    DMA_HandleTypeDef *hdma = htim->hdma[1 + idx];
+    bool circular = hdma && hdma->Init.Mode == DMA_CIRCULAR;
+    uint32_t value;
+
+    if (st->dma_src[idx] == NULL) {
+        return;
+    }
+    if (st->dma_width[idx] == 2) {
+        value = ((const uint16_t *)st->dma_src[idx])[st->dma_pos[idx]];
+    } else if (st->dma_width[idx] == 1) {
+        value = ((const uint8_t *)st->dma_src[idx])[st->dma_pos[idx]];
+    } else {
+        value = st->dma_src[idx][st->dma_pos[idx]];
+    }
+    *Sim_TIM_CCR(htim, ref->channel) = value;
+    if (st->pwm_sink[idx]) st->pwm_sink[idx](st->pwm_sink_ctx[idx], value);
+    st->dma_pos[idx]++;
+    st->stats.tx_bytes += st->dma_width[idx];
+
+    if (st->dma_pos[idx] == st->dma_len[idx] / 2) {
+        Sim_Schedule(0, Sim_TIM_PwmHalfIrq, ref, true);
+    }
+    if (st->dma_pos[idx] >= st->dma_len[idx]) {
+        st->dma_pos[idx] = 0;
+        Sim_Schedule(0, Sim_TIM_PwmCpltIrq, ref, true);
+        if (!circular) {
+            st->dma_src[idx] = NULL;
+            if (hdma) hdma->State = HAL_DMA_STATE_READY;
+            return;
+        }
+    }
+    if (hdma) hdma->counter = (uint32_t)(st->dma_len[idx] - st->dma_pos[idx]);
+    Sim_Schedule(Sim_TIM_PeriodCycles(htim), Sim_TIM_PwmDmaRequest, ref, false);
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef *htim, uint32_t Channel, const uint32_t *pData, uint16_t Length)
+{
+    int idx = Sim_TIM_Index(Channel);
+    DMA_HandleTypeDef *hdma = htim->hdma[1 + idx];
+    Sim_TIMRef *ref;
+
+    if (pData == NULL || Length == 0) {
+        return HAL_ERROR;
+    }
+    if (htim->sim.dma_src[idx] != NULL) {
+        return HAL_BUSY;
+    }
+    ref = Sim_TIM_Ref(htim, Channel);
+    if (ref == NULL) {
+        return HAL_ERROR;
+    }
+
+    htim->sim.stats.calls++;
+    htim->sim.stats.dma_transfers++;
+    Sim_Busy(SIM_HAL_CALL_CYCLES, &htim->sim.stats);
+
+    htim->sim.dma_src[idx]   = pData;
+    htim->sim.dma_len[idx]   = Length;
+    htim->sim.dma_pos[idx]   = 0;
+    htim->sim.dma_width[idx] = 4;
+    if (hdma) {
+        if (hdma->Init.MemDataAlignment == DMA_MDATAALIGN_HALFWORD)  htim->sim.dma_width[idx] = 2;
+        else if (hdma->Init.MemDataAlignment == DMA_MDATAALIGN_BYTE) htim->sim.dma_width[idx] = 1;
+        hdma->State   = HAL_DMA_STATE_BUSY;
+        hdma->counter = Length;
+    }
+
+    Sim_TIM_Start(htim);
+    htim->sim.running_ch |= 1U << idx;
+    /* First request fires on the next update event */
+    Sim_Schedule(Sim_TIM_PeriodCycles(htim) -
+                 ((Sim_Now() - htim->sim.start) % Sim_TIM_PeriodCycles(htim)),
+                 Sim_TIM_PwmDmaRequest, ref, false);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    int idx = Sim_TIM_Index(Channel);
+    Sim_TIMRef *ref = Sim_TIM_Ref(htim, Channel);
+
+    if (ref) {
+        Sim_Cancel(Sim_TIM_PwmDmaRequest, ref);
+        Sim_Cancel(Sim_TIM_PwmHalfIrq, ref);
+        Sim_Cancel(Sim_TIM_PwmCpltIrq, ref);
+    }
+    htim->sim.dma_src[idx] = NULL;
+    if (htim->hdma[1 + idx]) htim->hdma[1 + idx]->State = HAL_DMA_STATE_READY;
+    return HAL_TIM_PWM_Stop(htim, Channel);
+}
+
+/* ============================================================================
+ * Input Capture
+ * ========================================================================= */
+
+HAL_StatusTypeDef HAL_TIM_IC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    Sim_TIM_Start(htim);
+    htim->sim.running_ch |= 1U << Sim_TIM_Index(Channel);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Stop_IT(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    Sim_TIM_Freeze(htim);
+    htim->sim.running_ch &= ~(1U << Sim_TIM_Index(Channel));
+    return HAL_OK;
+}
+
+uint32_t HAL_TIM_ReadCapturedValue(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    return *Sim_TIM_CCR(htim, Channel);
+}
+
+static void Sim_TIM_CaptureIrq(void *ctx)
+{
+    Sim_TIMRef *ref = (Sim_TIMRef *)ctx;
+    ref->htim->Channel = (HAL_TIM_ActiveChannel)(1U << Sim_TIM_Index(ref->channel));
+    HAL_TIM_IC_CaptureCallback(ref->htim);
+    ref->htim->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+}
+
+void Sim_TIM_Capture(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    Sim_TIMRef *ref = Sim_TIM_Ref(htim, Channel);
+
+    if (!(htim->sim.running_ch & (1U << Sim_TIM_Index(Channel))) || ref == NULL) {
+        return;
+    }
+    *Sim_TIM_CCR(htim, Channel) = Sim_TIM_GetCounter(htim);
+    Sim_RaiseIrq(Sim_TIM_CaptureIrq, ref);
+}
+
+__weak void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)             { UNUSED(htim); }
+__weak void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim)         { UNUSED(htim); }
+__weak void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim) { UNUSED(htim); }
+__weak void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)                { UNUSED(htim); }
@@ -0,0 +1,443 @@
+/**
+ * @file sim_uart.c
+ * @brief Simulated USART with DMA RX/TX
+ *
+ * Incoming bytes are queued on a virtual wire with Sim_UART_Inject() and
+ * land one character time apart (10 bit-times, 8N1). With DMA reception
+ * armed each byte is written straight into the DMA buffer and the NDTR
+ * counter drops, raising half/full transfer interrupts like the real
+ * controller. Without DMA the bytes wait in a small receiver FIFO that
+ * blocking HAL_UART_Receive() drains.
+ *
+ * HAL_UARTEx_ReceiveToIdle_DMA() reports half/full transfer and line idle
+ * (one character time without a new start bit) through
+ * HAL_UARTEx_RxEventCallback() instead, as the F1 HAL does.
+ *
+ * Everything the MCU transmits is captured in a log that tests can read
+ * back with Sim_UART_TakeTx(), and optionally forwarded to a sink.
+ *
+ * A half-duplex line (Sim_UART_SetLine) receives every transmitted char
+ * back, as the device model on the wire turns it into. With DMA the echo
+ * of each char lands when that char has gone out; a blocking transmit
+ * leaves the echoes in the receiver FIFO (or the armed DMA buffer).
+ */
+
+#include "sim_hal.h"
+#include "sim_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    SIM_UART_RX_NONE = 0,
+    SIM_UART_RX_DMA
+};
+
+/* ============================================================================
+ * Helpers
+ * ========================================================================= */
+
+uint64_t Sim_UART_CharCycles(UART_HandleTypeDef *huart)
+{
+    uint32_t baud = huart->Init.BaudRate ? huart->Init.BaudRate : SIM_UART_DEFAULT_BAUD;
+    return (10ULL * SystemCoreClock + baud - 1) / baud;
+}
+
+Sim_BusStats *Sim_UART_Stats(UART_HandleTypeDef *huart)
+{
+    return &huart->sim.stats;
+}
+
+static void Sim_UART_Log(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len)
+{
+    Sim_UARTPort *p = &huart->sim;
+
+    if (p->tx_log_len + len > p->tx_log_cap) {
+        uint32_t cap = p->tx_log_cap ? p->tx_log_cap : 1024;
+        while (cap < p->tx_log_len + len) cap *= 2;
+        p->tx_log = (uint8_t *)realloc(p->tx_log, cap);
+        p->tx_log_cap = cap;
+    }
+    memcpy(&p->tx_log[p->tx_log_len], data, len);
+    p->tx_log_len += len;
+    p->stats.tx_bytes += len;
+
+    if (p->tx_sink) {
+        p->tx_sink(p->tx_sink_ctx, data, len);
+    }
+}
+
+uint32_t Sim_UART_TakeTx(UART_HandleTypeDef *huart, uint8_t *out, uint32_t max)
+{
+    Sim_UARTPort *p = &huart->sim;
+    uint32_t n = (p->tx_log_len < max) ? p->tx_log_len : max;
+
+    if (out && n) {
+        memcpy(out, p->tx_log, n);
+    }
+    memmove(p->tx_log, p->tx_log + n, p->tx_log_len - n);
+    p->tx_log_len -= n;
+    return n;
+}
+
+void Sim_UART_SetTxSink(UART_HandleTypeDef *huart,
+                        void (*sink)(void *ctx, const uint8_t *data, uint16_t len), void *ctx)
+{
+    huart->sim.tx_sink     = sink;
+    huart->sim.tx_sink_ctx = ctx;
+}
+
+bool Sim_UART_GetFlag(UART_HandleTypeDef *huart, uint32_t flag)
+{
+    Sim_Advance(SIM_POLL_CYCLES);
+    switch (flag) {
+    case UART_FLAG_TC:
+    case UART_FLAG_TXE:
+        return huart->sim.tx_len == 0;
+    case UART_FLAG_RXNE:
+        return huart->sim.fifo_head != huart->sim.fifo_tail;
+    default:
+        return false;
+    }
+}
+
+void Sim_UART_SetLine(UART_HandleTypeDef *huart, uint8_t (*fn)(void *ctx, uint8_t tx), void *ctx)
+{
+    huart->sim.line     = fn;
+    huart->sim.line_ctx = ctx;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    huart->gState    = HAL_UART_STATE_READY;
+    huart->RxState   = HAL_UART_STATE_READY;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_HalfDuplex_Init(UART_HandleTypeDef *huart)
+{
+    return HAL_UART_Init(huart);
+}
+
+/* ============================================================================
+ * Receive Path
+ * ========================================================================= */
+
+static void Sim_UART_RxHalfIrq(void *ctx)
+{
+    HAL_UART_RxHalfCpltCallback((UART_HandleTypeDef *)ctx);
+}
+
+static void Sim_UART_RxCpltIrq(void *ctx)
+{
+    HAL_UART_RxCpltCallback((UART_HandleTypeDef *)ctx);
+}
+
+static void Sim_UART_RxEventHalfIrq(void *ctx)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)ctx;
+    HAL_UARTEx_RxEventCallback(huart, (uint16_t)(huart->sim.rx_size / 2));
+}
+
+static void Sim_UART_RxEventCpltIrq(void *ctx)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)ctx;
+    HAL_UARTEx_RxEventCallback(huart, huart->sim.rx_size);
+}
+
+static void Sim_UART_IdleIrq(void *ctx)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)ctx;
+    Sim_UARTPort *p = &huart->sim;
+    bool circular = huart->hdmarx && huart->hdmarx->Init.Mode == DMA_CIRCULAR;
+    uint16_t pos = p->rx_pos;
+
+    /* HAL only reports idle when the buffer is partly filled */
+    if (p->rx_mode != SIM_UART_RX_DMA || huart->ReceptionType != HAL_UART_RECEPTION_TOIDLE || pos == 0) {
+        return;
+    }
+    if (!circular) {
+        p->rx_mode     = SIM_UART_RX_NONE;
+        huart->RxState = HAL_UART_STATE_READY;
+    }
+    HAL_UARTEx_RxEventCallback(huart, pos);
+}
+
+static void Sim_UART_ErrorIrq(void *ctx)
+{
+    HAL_UART_ErrorCallback((UART_HandleTypeDef *)ctx);
+}
+
+static void Sim_UART_Deliver(UART_HandleTypeDef *huart, uint8_t byte)
+{
+    Sim_UARTPort *p = &huart->sim;
+
+    if (p->rx_mode == SIM_UART_RX_DMA) {
+        bool circular = huart->hdmarx && huart->hdmarx->Init.Mode == DMA_CIRCULAR;
+        bool to_idle  = (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE);
+
+        p->rx_buf[p->rx_pos++] = byte;
+        p->stats.rx_bytes++;
+        if (p->rx_pos == p->rx_size / 2) {
+            Sim_Schedule(0, to_idle ? Sim_UART_RxEventHalfIrq : Sim_UART_RxHalfIrq, huart, true);
+        }
+        if (p->rx_pos >= p->rx_size) {
+            p->rx_pos = 0;
+            if (!circular) {
+                p->rx_mode     = SIM_UART_RX_NONE;
+                huart->RxState = HAL_UART_STATE_READY;
+            }
+            Sim_Schedule(0, to_idle ? Sim_UART_RxEventCpltIrq : Sim_UART_RxCpltIrq, huart, true);
+        }
+        if (huart->hdmarx) {
+            huart->hdmarx->counter = (uint32_t)(p->rx_size - p->rx_pos);
+            if (p->rx_mode == SIM_UART_RX_NONE) huart->hdmarx->counter = 0;
+        }
+    } else {
+        uint16_t next = (uint16_t)((p->fifo_head + 1) % sizeof(p->fifo));
+        if (next != p->fifo_tail) {
+            p->fifo[p->fifo_head] = byte;
+            p->fifo_head = next;
+        } else {
+            p->rx_dropped++;
+        }
+    }
+}
+
+static void Sim_UART_RxByte(void *ctx)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)ctx;
+    Sim_UARTPort *p = &huart->sim;
+
+    Sim_UART_Deliver(huart, p->wire[p->wire_pos++]);
+
+    if (p->wire_pos < p->wire_len) {
+        Sim_Schedule(Sim_UART_CharCycles(huart), Sim_UART_RxByte, huart, false);
+    } else {
+        p->wire_pos = 0;
+        p->wire_len = 0;
+        Sim_Schedule(Sim_UART_CharCycles(huart), Sim_UART_IdleIrq, huart, true);
+    }
+}
+
+void Sim_UART_Inject(UART_HandleTypeDef *huart, const uint8_t *data, uint32_t len)
+{
+    Sim_UARTPort *p = &huart->sim;
+    bool idle = (p->wire_len == 0);
+
+    if (len == 0) return;
+    if (p->wire_len + len > p->wire_cap) {
+        uint32_t cap = p->wire_cap ? p->wire_cap : 1024;
+        while (cap < p->wire_len + len) cap *= 2;
+        p->wire = (uint8_t *)realloc(p->wire, cap);
+        p->wire_cap = cap;
+    }
+    memcpy(&p->wire[p->wire_len], data, len);
+    p->wire_len += len;
+
+    if (idle) {
+        Sim_Cancel(Sim_UART_IdleIrq, huart);   // New start bit before the idle frame completed
+        Sim_Schedule(Sim_UART_CharCycles(huart), Sim_UART_RxByte, huart, false);
+    }
+}
+
+void Sim_UART_RaiseError(UART_HandleTypeDef *huart, uint32_t error)
+{
+    huart->ErrorCode |= error;
+    if (huart->sim.rx_mode == SIM_UART_RX_DMA) {
+        /* HAL aborts the DMA reception on ORE/FE/NE with DMA enabled */
+        huart->sim.rx_mode = SIM_UART_RX_NONE;
+        huart->RxState     = HAL_UART_STATE_READY;
+        if (huart->hdmarx) huart->hdmarx->counter = 0;
+    }
+    Sim_RaiseIrq(Sim_UART_ErrorIrq, huart);
+}
+
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    Sim_UARTPort *p = &huart->sim;
+    uint64_t deadline;
+
+    if (huart->RxState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+    p->stats.calls++;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    deadline = (Timeout == HAL_MAX_DELAY) ? UINT64_MAX :
+               Sim_Now() + (uint64_t)Timeout * (SystemCoreClock / 1000U);
+
+    for (uint16_t i = 0; i < Size; i++) {
+        while (p->fifo_head == p->fifo_tail) {
+            if (Sim_Now() >= deadline || (p->wire_len == 0 && Timeout == HAL_MAX_DELAY)) {
+                huart->RxState = HAL_UART_STATE_READY;
+                return HAL_TIMEOUT;
+            }
+            Sim_Busy(Sim_UART_CharCycles(huart), &p->stats);
+        }
+        pData[i] = p->fifo[p->fifo_tail];
+        p->fifo_tail = (uint16_t)((p->fifo_tail + 1) % sizeof(p->fifo));
+        p->stats.rx_bytes++;
+    }
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    Sim_UARTPort *p = &huart->sim;
+
+    if (huart->RxState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0) {
+        return HAL_ERROR;
+    }
+    p->stats.calls++;
+    p->stats.dma_transfers++;
+    Sim_Busy(SIM_HAL_CALL_CYCLES, &p->stats);
+
+    huart->ErrorCode     = HAL_UART_ERROR_NONE;
+    huart->RxState       = HAL_UART_STATE_BUSY_RX;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    p->rx_mode = SIM_UART_RX_DMA;
+    p->rx_buf  = pData;
+    p->rx_size = Size;
+    p->rx_pos  = 0;
+    p->fifo_head = p->fifo_tail = 0;
+    if (huart->hdmarx) {
+        huart->hdmarx->counter = Size;
+        huart->hdmarx->State   = HAL_DMA_STATE_BUSY;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    HAL_StatusTypeDef status = HAL_UART_Receive_DMA(huart, pData, Size);
+
+    if (status == HAL_OK) {
+        huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+    }
+    return status;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart)
+{
+    huart->sim.rx_mode = SIM_UART_RX_NONE;
+    huart->RxState     = HAL_UART_STATE_READY;
+    Sim_Cancel(Sim_UART_RxHalfIrq, huart);
+    Sim_Cancel(Sim_UART_RxCpltIrq, huart);
+    Sim_Cancel(Sim_UART_RxEventHalfIrq, huart);
+    Sim_Cancel(Sim_UART_RxEventCpltIrq, huart);
+    Sim_Cancel(Sim_UART_IdleIrq, huart);
+    if (huart->hdmarx) {
+        huart->hdmarx->counter = 0;
+        huart->hdmarx->State   = HAL_DMA_STATE_READY;
+    }
+    return HAL_OK;
+}
+
+/* ============================================================================
+ * Transmit Path
+ * ========================================================================= */
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    Sim_UARTPort *p = &huart->sim;
+    uint64_t wire;
+    UNUSED(Timeout);
+
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0) {
+        return HAL_ERROR;
+    }
+    p->stats.calls++;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    wire = Sim_UART_CharCycles(huart) * Size;
+    p->stats.bus_cycles += wire;
+    Sim_Busy(SIM_HAL_CALL_CYCLES + wire, &p->stats);
+    Sim_UART_Log(huart, pData, Size);
+    if (p->line) {
+        for (uint16_t i = 0; i < Size; i++) Sim_UART_Deliver(huart, p->line(p->line_ctx, pData[i]));
+    }
+    huart->gState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+static void Sim_UART_TxCpltIrq(void *ctx)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)ctx;
+
+    huart->gState = HAL_UART_STATE_READY;
+    if (huart->hdmatx) huart->hdmatx->State = HAL_DMA_STATE_READY;
+    HAL_UART_TxCpltCallback(huart);
+}
+
+static void Sim_UART_TxDone(void *ctx)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)ctx;
+    Sim_UARTPort *p = &huart->sim;
+
+    Sim_UART_Log(huart, p->tx_ptr, p->tx_len);
+    p->tx_ptr = NULL;
+    p->tx_len = 0;
+    if (huart->hdmatx) huart->hdmatx->counter = 0;
+    Sim_Schedule(0, Sim_UART_TxCpltIrq, huart, true);
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    Sim_UARTPort *p = &huart->sim;
+    uint64_t wire;
+
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0) {
+        return HAL_ERROR;
+    }
+    p->stats.calls++;
+    p->stats.dma_transfers++;
+    Sim_Busy(SIM_HAL_CALL_CYCLES, &p->stats);
+
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    p->tx_ptr = pData;
+    p->tx_len = Size;
+    if (huart->hdmatx) {
+        huart->hdmatx->counter = Size;
+        huart->hdmatx->State   = HAL_DMA_STATE_BUSY;
+    }
+    wire = Sim_UART_CharCycles(huart) * Size;
+    p->stats.bus_cycles += wire;
+    Sim_Schedule(wire, Sim_UART_TxDone, huart, false);
+    if (p->line) {
+        // Each echo arrives as its char completes on the wire
+        for (uint16_t i = 0; i < Size; i++) {
+            uint8_t echo = p->line(p->line_ctx, pData[i]);
+            Sim_UART_Inject(huart, &echo, 1);
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart)
+{
+    Sim_Cancel(Sim_UART_TxDone, huart);
+    Sim_Cancel(Sim_UART_TxCpltIrq, huart);
+    huart->sim.tx_ptr = NULL;
+    huart->sim.tx_len = 0;
+    huart->gState = HAL_UART_STATE_READY;
+    if (huart->hdmatx) {
+        huart->hdmatx->counter = 0;
+        huart->hdmatx->State   = HAL_DMA_STATE_READY;
+    }
+    return HAL_OK;
+}
+
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)     { UNUSED(huart); }
+__weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)     { UNUSED(huart); }
+__weak void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart) { UNUSED(huart); }
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)      { UNUSED(huart); }
+__weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) { UNUSED(huart); UNUSED(Size); }
@@ -0,0 +1,261 @@
+/**
+ * @file sim_usb.c
+ * @brief USB full-speed CDC link, device class stand-in and host model
+ */
+
+#include "sim_usb.h"
+#include "sim_internal.h"
+#include <string.h>
+
+#define SIM_USB_PACKETS_PER_FRAME  19U
+
+USBD_HandleTypeDef hUsbDeviceFS;
+
+static USBD_CDC_HandleTypeDef s_cdc;
+static uint8_t       s_user_rx[CDC_DATA_FS_MAX_PACKET_SIZE];   // UserRxBufferFS
+static Sim_USB_Stats s_stats;
+
+/* IN: current transfer and the host read request it fills */
+static uint32_t      s_in_pos;
+static uint8_t       s_host_buf[SIM_USB_HOST_READ];
+static uint32_t      s_host_len;
+static void        (*s_host_sink)(void *ctx, const uint8_t *data, uint32_t len);
+static void         *s_host_ctx;
+
+/* OUT: bytes written by the host, not yet delivered */
+static uint8_t       s_out[SIM_USB_OUT_QUEUE];
+static uint32_t      s_out_head, s_out_tail;
+static bool          s_rx_armed;
+static bool          s_out_scheduled;
+
+static uint64_t Sim_USB_PacketCycles(void)
+{
+    return Sim_UsToCycles(1000) / SIM_USB_PACKETS_PER_FRAME;
+}
+
+/* ============================================================================
+ * IN (device to host)
+ * ========================================================================= */
+
+static void Sim_USB_HostComplete(void)
+{
+    if (s_host_sink) {
+        s_host_sink(s_host_ctx, s_host_buf, s_host_len);
+    }
+    s_host_len = 0;
+    s_stats.host_reads++;
+}
+
+static void Sim_USB_InDone(void *ctx)
+{
+    (void)ctx;
+    s_cdc.TxState = 0;
+    CDC_TransmitCplt_FS(s_cdc.TxBuffer, &s_cdc.TxLength, CDC_IN_EP);
+}
+
+static void Sim_USB_InPacket(void *ctx)
+{
+    uint32_t n = s_cdc.TxLength - s_in_pos;
+
+    (void)ctx;
+    if (n > CDC_DATA_FS_MAX_PACKET_SIZE) n = CDC_DATA_FS_MAX_PACKET_SIZE;
+
+    memcpy(&s_host_buf[s_host_len], &s_cdc.TxBuffer[s_in_pos], n);
+    s_host_len += n;
+    s_in_pos   += n;
+    s_stats.in_packets++;
+    if (n == 0) s_stats.in_zlps++;
+
+    // A short packet ends the host's read request, so does a full one
+    if (n < CDC_DATA_FS_MAX_PACKET_SIZE || s_host_len == SIM_USB_HOST_READ) {
+        Sim_USB_HostComplete();
+    }
+
+    // As the ST CDC class: a transfer ending on a full packet gets a ZLP
+    if (n < CDC_DATA_FS_MAX_PACKET_SIZE) {
+        Sim_Schedule(0, Sim_USB_InDone, NULL, true);
+    } else {
+        Sim_Schedule(Sim_USB_PacketCycles(), Sim_USB_InPacket, NULL, false);
+    }
+}
+
+uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint32_t length)
+{
+    (void)pdev;
+    s_cdc.TxBuffer = pbuff;
+    s_cdc.TxLength = length;
+    return USBD_OK;
+}
+
+uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev)
+{
+    if (pdev->pClassData == NULL || pdev->dev_state != USBD_STATE_CONFIGURED) {
+        return USBD_FAIL;
+    }
+    if (s_cdc.TxState != 0) {
+        s_stats.in_busy++;
+        return USBD_BUSY;
+    }
+    s_cdc.TxState = 1;
+    s_in_pos = 0;
+    s_stats.in_transfers++;
+    Sim_Schedule(Sim_USB_PacketCycles(), Sim_USB_InPacket, NULL, false);
+    return USBD_OK;
+}
+
+uint8_t CDC_Transmit_FS(uint8_t *Buf, uint16_t Len)
+{
+    if (s_cdc.TxState != 0) {
+        s_stats.in_busy++;
+        return USBD_BUSY;
+    }
+    USBD_CDC_SetTxBuffer(&hUsbDeviceFS, Buf, Len);
+    return USBD_CDC_TransmitPacket(&hUsbDeviceFS);
+}
+
+/* ============================================================================
+ * OUT (host to device)
+ * ========================================================================= */
+
+static uint32_t Sim_USB_OutQueued(void)
+{
+    return s_out_head - s_out_tail;
+}
+
+static void Sim_USB_OutPacket(void *ctx)
+{
+    uint32_t n = Sim_USB_OutQueued();
+
+    (void)ctx;
+    s_out_scheduled = false;
+    if (n == 0 || hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED) {
+        return;
+    }
+    if (!s_rx_armed) {
+        // NAKed until the device re-arms the endpoint
+        s_stats.out_naks++;
+        return;
+    }
+    if (n > CDC_DATA_FS_MAX_PACKET_SIZE) n = CDC_DATA_FS_MAX_PACKET_SIZE;
+    for (uint32_t i = 0; i < n; i++) {
+        s_cdc.RxBuffer[i] = s_out[(s_out_tail + i) % SIM_USB_OUT_QUEUE];
+    }
+    s_out_tail += n;
+    s_cdc.RxLength = n;
+    s_rx_armed = false;
+    s_stats.out_packets++;
+
+    if (Sim_USB_OutQueued()) {
+        s_out_scheduled = true;
+        Sim_Schedule(Sim_USB_PacketCycles(), Sim_USB_OutPacket, NULL, true);
+    }
+    CDC_Receive_FS(s_cdc.RxBuffer, &s_cdc.RxLength);
+}
+
+static void Sim_USB_OutKick(void)
+{
+    if (!s_out_scheduled && Sim_USB_OutQueued()) {
+        s_out_scheduled = true;
+        Sim_Schedule(Sim_USB_PacketCycles(), Sim_USB_OutPacket, NULL, true);
+    }
+}
+
+uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff)
+{
+    (void)pdev;
+    s_cdc.RxBuffer = pbuff;
+    return USBD_OK;
+}
+
+uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef *pdev)
+{
+    if (pdev->pClassData == NULL) {
+        return USBD_FAIL;
+    }
+    s_rx_armed = true;
+    Sim_USB_OutKick();
+    return USBD_OK;
+}
+
+uint32_t Sim_USB_HostWrite(const uint8_t *data, uint32_t len)
+{
+    uint32_t space = SIM_USB_OUT_QUEUE - Sim_USB_OutQueued();
+
+    if (len > space) len = space;
+    for (uint32_t i = 0; i < len; i++) {
+        s_out[(s_out_head + i) % SIM_USB_OUT_QUEUE] = data[i];
+    }
+    s_out_head += len;
+    Sim_USB_OutKick();
+    return len;
+}
+
+/* ============================================================================
+ * Link / Host
+ * ========================================================================= */
+
+void Sim_USB_Connect(void)
+{
+    Sim_Cancel(Sim_USB_InPacket, NULL);
+    Sim_Cancel(Sim_USB_InDone, NULL);
+    Sim_Cancel(Sim_USB_OutPacket, NULL);
+    memset(&s_cdc, 0, sizeof(s_cdc));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_in_pos = 0;
+    s_host_len = 0;
+    s_out_head = s_out_tail = 0;
+    s_out_scheduled = false;
+
+    // As CDC_Init_FS: generated buffers, OUT endpoint armed
+    hUsbDeviceFS.pClassData = &s_cdc;
+    hUsbDeviceFS.dev_state  = USBD_STATE_CONFIGURED;
+    s_cdc.RxBuffer = s_user_rx;
+    s_rx_armed = true;
+}
+
+void Sim_USB_Disconnect(void)
+{
+    Sim_Cancel(Sim_USB_InPacket, NULL);
+    Sim_Cancel(Sim_USB_InDone, NULL);
+    Sim_Cancel(Sim_USB_OutPacket, NULL);
+    hUsbDeviceFS.dev_state = USBD_STATE_DEFAULT;
+    s_cdc.TxState = 0;
+    s_rx_armed = false;
+    s_out_scheduled = false;
+}
+
+void Sim_USB_SetHostSink(void (*sink)(void *ctx, const uint8_t *data, uint32_t len), void *ctx)
+{
+    s_host_sink = sink;
+    s_host_ctx  = ctx;
+}
+
+uint32_t Sim_USB_HostHeld(void)
+{
+    return s_host_len;
+}
+
+Sim_USB_Stats *Sim_USB_GetStats(void)
+{
+    return &s_stats;
+}
+
+/* ============================================================================
+ * usbd_cdc_if.c user code defaults
+ * ========================================================================= */
+
+__weak int8_t CDC_Receive_FS(uint8_t *Buf, uint32_t *Len)
+{
+    (void)Len;
+    USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
+    USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+    return USBD_OK;
+}
+
+__weak int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+    (void)Buf;
+    (void)Len;
+    (void)epnum;
+    return USBD_OK;
+}
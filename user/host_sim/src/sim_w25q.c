@@ -0,0 +1,333 @@
+/**
+ * @file sim_w25q.c
+ * @brief W25Qxx SPI NOR flash model
+ */
+
+#include "sim_w25q.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SR1_BUSY  0x01
+#define SR1_WEL   0x02
+#define SR2_SUS   0x80
+
+/* ============================================================================
+ * Helpers
+ * ========================================================================= */
+
+bool Sim_W25Q_IsBusy(const Sim_W25Q *dev)
+{
+    return Sim_Now() < dev->busy_until;
+}
+
+static uint8_t Sim_W25Q_Sr1(Sim_W25Q *dev)
+{
+    uint8_t sr = dev->sr1 & (uint8_t)~SR1_BUSY;
+    if (Sim_W25Q_IsBusy(dev)) {
+        sr |= SR1_BUSY;
+    } else if (dev->busy_until) {
+        /* Operation finished: WEL auto-clears */
+        dev->busy_until = 0;
+        dev->sr1 &= (uint8_t)~SR1_WEL;
+        sr &= (uint8_t)~SR1_WEL;
+    }
+    return sr;
+}
+
+static void Sim_W25Q_StartBusy(Sim_W25Q *dev, uint32_t us)
+{
+    dev->busy_cmd = dev->cmd;
+    dev->busy_until = Sim_Now() + Sim_UsToCycles(us);
+    dev->sr1 |= SR1_BUSY;
+}
+
+static uint8_t Sim_W25Q_AddrBytes(const Sim_W25Q *dev, uint8_t cmd)
+{
+    switch (cmd) {
+    case 0x13: case 0x0C: case 0x12: case 0x21: case 0xDC: case 0x3C: case 0x6C:
+        return 4;
+    default:
+        return dev->addr4 ? 4 : 3;
+    }
+}
+
+static void Sim_W25Q_Erase(Sim_W25Q *dev, uint32_t addr, uint32_t len, uint32_t us)
+{
+    addr &= ~(len - 1U);
+    if (addr < dev->size) {
+        memset(&dev->mem[addr], 0xFF, (addr + len <= dev->size) ? len : dev->size - addr);
+    }
+    Sim_W25Q_StartBusy(dev, us);
+}
+
+/* ============================================================================
+ * SPI Slave Callbacks
+ * ========================================================================= */
+
+static void Sim_W25Q_Select(Sim_SPIDevice *spi, bool selected)
+{
+    Sim_W25Q *dev = (Sim_W25Q *)spi;
+
+    if (selected) {
+        dev->pos = 0;
+        dev->cmd = 0;
+        dev->addr = 0;
+        return;
+    }
+
+    /* CS rising edge commits program/erase commands */
+    uint8_t ab = Sim_W25Q_AddrBytes(dev, dev->cmd);
+    bool has_addr = dev->pos >= 1U + ab;
+
+    switch (dev->cmd) {
+    case 0x02:
+    case 0x12:
+        if (dev->pos > 1U + ab) {
+            dev->stats.programs++;
+            Sim_W25Q_StartBusy(dev, dev->t_page_us);
+        }
+        break;
+    case 0x20:
+    case 0x21:
+        if (has_addr) { dev->stats.erases_4k++;  Sim_W25Q_Erase(dev, dev->addr, 4096, dev->t_se_us); }
+        break;
+    case 0x52:
+        if (has_addr) { dev->stats.erases_32k++; Sim_W25Q_Erase(dev, dev->addr, 32768, dev->t_be32_us); }
+        break;
+    case 0xD8:
+    case 0xDC:
+        if (has_addr) { dev->stats.erases_64k++; Sim_W25Q_Erase(dev, dev->addr, 65536, dev->t_be64_us); }
+        break;
+    case 0xC7:
+    case 0x60:
+        if (dev->pos == 1) {
+            dev->stats.erases_chip++;
+            memset(dev->mem, 0xFF, dev->size);
+            Sim_W25Q_StartBusy(dev, dev->t_ce_us);
+        }
+        break;
+    default:
+        break;
+    }
+    dev->cmd = 0;
+    dev->pos = 0;
+}
+
+static bool Sim_W25Q_NeedsWel(uint8_t cmd)
+{
+    return cmd == 0x02 || cmd == 0x12 || cmd == 0x20 || cmd == 0x21 || cmd == 0x52 ||
+           cmd == 0xD8 || cmd == 0xDC || cmd == 0xC7 || cmd == 0x60;
+}
+
+static uint8_t Sim_W25Q_Exchange(Sim_SPIDevice *spi, uint8_t mosi)
+{
+    Sim_W25Q *dev = (Sim_W25Q *)spi;
+    uint32_t pos = dev->pos++;
+    uint8_t ab;
+
+    if (pos == 0) {
+        dev->stats.commands++;
+        /* While busy only status reads (and suspend) are accepted */
+        if (Sim_W25Q_IsBusy(dev) && mosi != 0x05 && mosi != 0x35 && mosi != 0x15 && mosi != 0x75) {
+            dev->stats.busy_violations++;
+            dev->cmd = 0xFF;
+            return 0xFF;
+        }
+        if (Sim_W25Q_NeedsWel(mosi) && !(dev->sr1 & SR1_WEL)) {
+            dev->stats.wel_violations++;
+            dev->cmd = 0xFF;
+            return 0xFF;
+        }
+        dev->cmd = mosi;
+        switch (mosi) {
+        case 0x06: dev->sr1 |= SR1_WEL; break;
+        case 0x04: dev->sr1 &= (uint8_t)~SR1_WEL; break;
+        case 0xB7: dev->addr4 = true;  dev->sr3 |= 0x01; break;
+        case 0xE9: dev->addr4 = false; dev->sr3 &= (uint8_t)~0x01; break;
+        case 0x05: dev->stats.status_polls++; break;
+        case 0x75:
+            /* Program/erase suspend: the rest of the operation is parked and
+             * BUSY drops after tSUS. A chip erase cannot be suspended. */
+            if (Sim_W25Q_IsBusy(dev) && (dev->busy_cmd == 0xC7 || dev->busy_cmd == 0x60)) {
+                dev->stats.suspends_refused++;
+            } else if (Sim_W25Q_IsBusy(dev) && !(dev->sr2 & SR2_SUS)) {
+                dev->stats.suspends++;
+                dev->suspend_left = dev->busy_until - Sim_Now();
+                dev->busy_until = Sim_Now() + Sim_UsToCycles(dev->t_sus_us);
+                dev->sr2 |= SR2_SUS;
+            }
+            break;
+        case 0x7A:
+            if ((dev->sr2 & SR2_SUS) && !Sim_W25Q_IsBusy(dev)) {
+                dev->stats.resumes++;
+                dev->sr2 &= (uint8_t)~SR2_SUS;
+                dev->busy_until = Sim_Now() + dev->suspend_left;
+                dev->sr1 |= SR1_BUSY | SR1_WEL;
+                dev->suspend_left = 0;
+            }
+            break;
+        default: break;
+        }
+        return 0xFF;
+    }
+
+    ab = Sim_W25Q_AddrBytes(dev, dev->cmd);
+    switch (dev->cmd) {
+    case 0x05:
+        return Sim_W25Q_Sr1(dev);
+    case 0x35:
+        return dev->sr2;
+    case 0x15:
+        return dev->sr3;
+
+    case 0x9F:
+        if (pos <= 3) return (uint8_t)(dev->jedec_id >> (8 * (3 - pos)));
+        return 0xFF;
+
+    case 0x90:   /* Manufacturer / device ID after 3 dummy address bytes */
+        if (pos == 4) return (uint8_t)(dev->jedec_id >> 16);
+        if (pos == 5) return (uint8_t)(dev->jedec_id - 1U);
+        return 0xFF;
+
+    case 0xAB:   /* Release power-down / device ID */
+        if (pos >= 4) return (uint8_t)((dev->jedec_id & 0xFF) - 1U);
+        return 0xFF;
+
+    case 0x4B:   /* Unique ID: 4 dummy bytes then 8 ID bytes */
+        if (pos >= 5 && pos < 13) return (uint8_t)(0xA0 + pos);
+        return 0xFF;
+
+    case 0x5A:   /* SFDP: 3 address bytes, 1 dummy byte, then data */
+        if (pos <= 3) {
+            dev->addr = (dev->addr << 8) | mosi;
+            if (pos == 3) dev->stats.sfdp_reads++;
+            return 0xFF;
+        }
+        if (pos == 4) return 0xFF;
+        if (dev->addr < dev->sfdp_len) return dev->sfdp[dev->addr++];
+        return 0xFF;
+
+    case 0x03:
+    case 0x13:
+    case 0x0B:
+    case 0x0C: {
+        uint32_t dummy = (dev->cmd == 0x0B || dev->cmd == 0x0C) ? 1U : 0U;
+        if (pos <= ab) {
+            dev->addr = (dev->addr << 8) | mosi;
+            if (pos == ab) {
+                dev->stats.reads++;
+                if (dummy) dev->stats.fast_reads++;
+            }
+            return 0xFF;
+        }
+        if (pos <= ab + dummy) {
+            return 0xFF;
+        }
+        dev->stats.read_bytes++;
+        return dev->mem[dev->addr++ % dev->size];
+    }
+
+    case 0x02:
+    case 0x12:
+        if (pos <= ab) {
+            dev->addr = (dev->addr << 8) | mosi;
+            if (pos == ab) {
+                dev->addr %= dev->size;
+                dev->page_base = dev->addr & ~0xFFU;
+                dev->page_off  = dev->addr & 0xFFU;
+            }
+            return 0xFF;
+        }
+        /* Page program wraps within the 256-byte page */
+        dev->mem[dev->page_base + dev->page_off] &= mosi;
+        dev->page_off = (dev->page_off + 1U) & 0xFFU;
+        dev->stats.program_bytes++;
+        return 0xFF;
+
+    case 0x20: case 0x21: case 0x52: case 0xD8: case 0xDC:
+        if (pos <= ab) dev->addr = (dev->addr << 8) | mosi;
+        return 0xFF;
+
+    default:
+        return 0xFF;
+    }
+}
+
+/* ============================================================================
+ * Public API
+ * ========================================================================= */
+
+static void Sim_W25Q_Put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* JESD216 header, one parameter header and the 9-DWORD basic table of a
+ * W25Q64JV, with the density (and 3/4-byte addressing) of this size */
+static void Sim_W25Q_BuildSfdp(Sim_W25Q *dev)
+{
+    static const uint32_t basic[9] = {
+        0xFFF920E5,  /* 4 KB erase 0x20, 1-1-2/1-2-2/1-4-4/1-1-4 reads */
+        0,           /* Density, filled in below */
+        0x6B08EB44,  /* 1-4-4 0xEB, 1-1-4 0x6B */
+        0xBB423B08,  /* 1-1-2 0x3B, 1-2-2 0xBB */
+        0xFFFFFFEE,
+        0xFF00FFFF,
+        0xFF00FFFF,
+        0x520F200C,  /* 4 KB 0x20, 32 KB 0x52 */
+        0xFF00D810,  /* 64 KB 0xD8 */
+    };
+
+    memset(dev->sfdp, 0xFF, sizeof(dev->sfdp));
+    memcpy(dev->sfdp, "SFDP", 4);
+    dev->sfdp[4] = 0x05;          /* Rev 1.5 */
+    dev->sfdp[5] = 0x01;
+    dev->sfdp[6] = 0x00;          /* One parameter header */
+    dev->sfdp[8] = 0x00;          /* JEDEC basic table, rev 1.5, 9 DWORDs at 0x10 */
+    dev->sfdp[9] = 0x05;
+    dev->sfdp[10] = 0x01;
+    dev->sfdp[11] = 9;
+    dev->sfdp[12] = 0x10;
+    dev->sfdp[13] = 0x00;
+    dev->sfdp[14] = 0x00;
+    for (int i = 0; i < 9; i++) Sim_W25Q_Put32(&dev->sfdp[0x10 + 4 * i], basic[i]);
+    Sim_W25Q_Put32(&dev->sfdp[0x14], dev->size * 8U - 1U);
+    if (dev->size > 16UL * 1024UL * 1024UL) {
+        dev->sfdp[0x12] |= 0x02;  /* 3- or 4-byte addressing */
+    }
+    dev->sfdp_len = 0x10 + 9 * 4;
+}
+
+void Sim_W25Q_Init(Sim_W25Q *dev, SPI_HandleTypeDef *hspi,
+                   GPIO_TypeDef *cs_port, uint16_t cs_pin, uint32_t jedec_id)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->jedec_id = jedec_id;
+    dev->size     = 1UL << (jedec_id & 0xFF);
+    dev->mem      = (uint8_t *)malloc(dev->size);
+    memset(dev->mem, 0xFF, dev->size);
+
+    dev->t_page_us = 700;
+    dev->t_se_us   = 45000;
+    dev->t_be32_us = 120000;
+    dev->t_be64_us = 150000;
+    dev->t_ce_us   = (dev->size / 65536U) * 150000U / 4U;
+    dev->t_sus_us  = 20;
+    Sim_W25Q_BuildSfdp(dev);
+
+    dev->spi.cs_port  = cs_port;
+    dev->spi.cs_pin   = cs_pin;
+    dev->spi.select   = Sim_W25Q_Select;
+    dev->spi.exchange = Sim_W25Q_Exchange;
+    HAL_GPIO_WritePin(cs_port, cs_pin, GPIO_PIN_SET);
+    Sim_SPI_Attach(hspi, &dev->spi);
+}
+
+void Sim_W25Q_Free(Sim_W25Q *dev)
+{
+    free(dev->mem);
+    dev->mem = NULL;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file sim_ws2812.c
+ * @brief WS2812B LED strip model
+ */
+
+#include "sim_ws2812.h"
+#include <string.h>
+
+#define SIM_WS2812_LATCH_NS  50000U
+
+static uint32_t Sim_WS2812_TickNs(Sim_WS2812 *dev)
+{
+    return (uint32_t)(1000000000ULL * (dev->htim->Instance->PSC + 1U) / SystemCoreClock);
+}
+
+static void Sim_WS2812_Latch(Sim_WS2812 *dev)
+{
+    uint32_t leds = dev->rx_bits / 24;
+
+    for (uint32_t i = 0; i < leds; i++) {
+        dev->rgb[i][0] = dev->rx[i * 3 + 1];    // Wire order is G, R, B
+        dev->rgb[i][1] = dev->rx[i * 3 + 0];
+        dev->rgb[i][2] = dev->rx[i * 3 + 2];
+    }
+    dev->latched_leds = (uint16_t)leds;
+    dev->stats.frames++;
+    dev->rx_bits = 0;
+}
+
+static void Sim_WS2812_Period(void *ctx, uint32_t ccr)
+{
+    Sim_WS2812 *dev = (Sim_WS2812 *)ctx;
+    uint32_t tick_ns = Sim_WS2812_TickNs(dev);
+    uint32_t high_ns = ccr * tick_ns;
+    bool one;
+
+    if (ccr == 0) {
+        dev->low_periods++;
+        if (dev->rx_bits && dev->low_periods * (dev->htim->Instance->ARR + 1U) * tick_ns >= SIM_WS2812_LATCH_NS) {
+            Sim_WS2812_Latch(dev);
+        }
+        return;
+    }
+    if (dev->low_periods && dev->rx_bits) {
+        dev->stats.gaps++;
+    }
+    dev->low_periods = 0;
+
+    if (high_ns >= 200 && high_ns <= 500) {
+        one = false;
+    } else if (high_ns >= 600 && high_ns <= 1000) {
+        one = true;
+    } else {
+        dev->stats.bad_pulses++;
+        one = high_ns > 550;
+    }
+    if (dev->rx_bits < SIM_WS2812_MAX_LEDS * 24U) {
+        uint8_t *b = &dev->rx[dev->rx_bits / 8];
+
+        *b = (uint8_t)((*b << 1) | (one ? 1U : 0U));
+        dev->rx_bits++;
+    }
+    dev->stats.bits++;
+}
+
+void Sim_WS2812_Init(Sim_WS2812 *dev, TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->htim = htim;
+    Sim_TIM_SetPwmSink(htim, Channel, Sim_WS2812_Period, dev);
+}
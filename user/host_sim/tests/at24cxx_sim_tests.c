@@ -0,0 +1,277 @@
+/**
+ * @file at24cxx_sim_tests.c
+ * @brief at24cxx.c on a simulated AT24C256: blocking page writes vs the
+ *        background writer (I2C DMA + timer ACK polling), write coalescing,
+ *        read-back of buffered data, write-cycle timeout
+ */
+
+#include "sim_test.h"
+#include "sim_at24.h"
+#include "at24cxx.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define EE_SIZE  32768U
+#define EE_PAGE  64U
+
+static I2C_HandleTypeDef      hi2c1;
+static DMA_HandleTypeDef      hdma_i2c1_tx, hdma_i2c1_rx;
+static TIM_HandleTypeDef      htim6;
+static TIM_TypeDef            tim6;
+static Sim_AT24               eeprom;
+static AT24CXX_HandleTypeDef  hat24;
+static uint8_t                shadow[EE_SIZE];
+
+// 1 ms tick runs the background writer, as on the target
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim == &htim6) AT24CXX_Poll(&hat24);
+}
+
+static bool chip_matches_shadow(uint32_t addr, uint32_t len)
+{
+    return memcmp(&eeprom.mem[addr], &shadow[addr], len) == 0;
+}
+
+// Queue, standing in for the control loop while the lines are full
+static uint64_t queue(uint32_t addr, const uint8_t *data, uint16_t len, uint32_t *spins)
+{
+    uint64_t t0, in_call = 0;
+    uint8_t st;
+
+    for (;;) {
+        t0 = Sim_Now();
+        st = AT24CXX_WriteAsync(&hat24, addr, data, len);
+        in_call += Sim_Now() - t0;
+        if (st != AT24CXX_BUSY) break;
+        if (spins) (*spins)++;
+        Sim_AdvanceUs(100);
+    }
+    SIM_CHECK(st == AT24CXX_OK);
+    memcpy(&shadow[addr], data, len);
+    return in_call;
+}
+
+static void drain(void)
+{
+    uint32_t guard = 0;
+
+    while (AT24CXX_Poll(&hat24) && guard++ < 100000) Sim_AdvanceUs(100);
+    SIM_CHECK(hat24.OpState == AT24CXX_OP_IDLE);
+}
+
+static void test_blocking(void)
+{
+    static uint8_t buf[1024], back[1024];
+    uint64_t t0, elapsed;
+
+    for (uint32_t i = 0; i < sizeof(buf); i++) buf[i] = (uint8_t)(i * 7 + 1);
+    t0 = Sim_Now();
+    AT24CXX_Write(&hat24, 0, buf, sizeof(buf));
+    elapsed = Sim_Now() - t0;
+    memcpy(shadow, buf, sizeof(buf));
+
+    printf("BENCH at24 blocking 1 KB            caller blocked %6.1f ms, %llu page writes\n",
+           Sim_CyclesToUs(elapsed) / 1000.0, (unsigned long long)eeprom.stats.writes);
+    SIM_CHECK(eeprom.stats.writes == sizeof(buf) / EE_PAGE);
+    SIM_CHECK(Sim_CyclesToUs(elapsed) > 16 * 5000.0);
+    SIM_CHECK(chip_matches_shadow(0, sizeof(buf)));
+
+    AT24CXX_Read(&hat24, 0, back, sizeof(back));
+    SIM_CHECK(memcmp(back, buf, sizeof(buf)) == 0);
+}
+
+static void test_async_bulk(void)
+{
+    static uint8_t buf[1024];
+    uint64_t writes = eeprom.stats.writes;
+    uint64_t t0, in_calls = 0, elapsed;
+    uint32_t spins = 0;
+
+    for (uint32_t i = 0; i < sizeof(buf); i++) buf[i] = (uint8_t)(i * 13 + 5);
+
+    t0 = Sim_Now();
+    for (uint32_t off = 0; off < sizeof(buf); off += EE_PAGE) {
+        in_calls += queue(0x1000 + off, &buf[off], EE_PAGE, &spins);
+    }
+    drain();
+    elapsed = Sim_Now() - t0;
+
+    printf("BENCH at24 async 1 KB               caller blocked %6.3f ms, done in %5.1f ms, %llu page writes, %lu ACK probes\n",
+           Sim_CyclesToUs(in_calls) / 1000.0, Sim_CyclesToUs(elapsed) / 1000.0,
+           (unsigned long long)(eeprom.stats.writes - writes), (unsigned long)hat24.Stats.AckPolls);
+    SIM_CHECK(eeprom.stats.writes - writes == sizeof(buf) / EE_PAGE);
+    SIM_CHECK(eeprom.stats.page_wraps == 0);
+    SIM_CHECK(Sim_CyclesToUs(in_calls) < 1000.0);
+    SIM_CHECK(chip_matches_shadow(0x1000, sizeof(buf)));
+    SIM_CHECK(Sim_I2C_Stats(&hi2c1)->dma_transfers > 0);
+}
+
+static void test_coalesce(void)
+{
+    uint64_t writes = eeprom.stats.writes;
+    uint32_t merged = hat24.Stats.Merged;
+
+    // A parameter block updated field by field: 64 single-byte writes
+    for (uint32_t i = 0; i < EE_PAGE; i++) {
+        uint8_t v = (uint8_t)(0xA0 ^ i);
+        queue(0x2000 + i, &v, 1, NULL);
+        Sim_AdvanceUs(10);
+    }
+    drain();
+
+    printf("BENCH at24 64 byte updates          %llu page write(s)\n",
+           (unsigned long long)(eeprom.stats.writes - writes));
+    SIM_CHECK(eeprom.stats.writes - writes == 1);
+    SIM_CHECK(hat24.Stats.Merged - merged == EE_PAGE - 1);
+    SIM_CHECK(chip_matches_shadow(0x2000, EE_PAGE));
+}
+
+static void test_holes(void)
+{
+    static uint8_t page[EE_PAGE];
+    uint64_t writes;
+    uint32_t fills = hat24.Stats.FillReads;
+    uint8_t a = 0x11, b = 0x22;
+
+    // Known page content, then two bytes far apart in it
+    for (uint32_t i = 0; i < EE_PAGE; i++) page[i] = (uint8_t)(0x40 + i);
+    AT24CXX_Write(&hat24, 0x2400, page, EE_PAGE);
+    memcpy(&shadow[0x2400], page, EE_PAGE);
+    writes = eeprom.stats.writes;
+
+    queue(0x2403, &a, 1, NULL);
+    queue(0x2428, &b, 1, NULL);
+    drain();
+
+    // One read of the bytes in between, one write of the whole span
+    SIM_CHECK(hat24.Stats.FillReads - fills == 1);
+    SIM_CHECK(eeprom.stats.writes - writes == 1);
+    SIM_CHECK(chip_matches_shadow(0x2400, EE_PAGE));
+}
+
+static void test_read_overlay(void)
+{
+    uint8_t data[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    uint8_t back[20];
+
+    queue(0x3010, data, sizeof(data), NULL);
+    SIM_CHECK(!chip_matches_shadow(0x3010, sizeof(data)));
+
+    // Not on the chip yet, but a read sees it
+    AT24CXX_Read(&hat24, 0x300B, back, sizeof(back));
+    SIM_CHECK(memcmp(back, &shadow[0x300B], sizeof(back)) == 0);
+    drain();
+    SIM_CHECK(chip_matches_shadow(0x3000, EE_PAGE));
+}
+
+static void test_random(void)
+{
+    static uint8_t data[200], back[300];
+    uint32_t mismatches = 0;
+
+    srand(1234);
+    for (int n = 0; n < 400; n++) {
+        uint32_t addr = 0x4000 + (uint32_t)rand() % 4096U;
+        uint16_t len = (uint16_t)(1 + rand() % 100);
+
+        for (uint16_t i = 0; i < len; i++) data[i] = (uint8_t)rand();
+        queue(addr, data, len, NULL);
+
+        if (rand() % 8 == 0) {
+            uint32_t raddr = 0x4000 + (uint32_t)rand() % 4000U;
+            AT24CXX_Read(&hat24, raddr, back, sizeof(back));
+            if (memcmp(back, &shadow[raddr], sizeof(back)) != 0) mismatches++;
+        }
+        Sim_AdvanceUs((uint32_t)(rand() % 3000));
+    }
+    SIM_CHECK(AT24CXX_Sync(&hat24) == 0);
+    SIM_CHECK(mismatches == 0);
+    SIM_CHECK(eeprom.stats.page_wraps == 0);
+    SIM_CHECK(chip_matches_shadow(0, EE_SIZE));
+    printf("BENCH at24 400 random writes        %lu bytes queued, %lu merged, %lu page writes, %lu fill reads\n",
+           (unsigned long)hat24.Stats.Queued, (unsigned long)hat24.Stats.Merged,
+           (unsigned long)hat24.Stats.PageWrites, (unsigned long)hat24.Stats.FillReads);
+}
+
+// An interrupt queueing data while a blocking write has the bus
+static void queue_from_irq(void *ctx)
+{
+    static const uint8_t data[4] = {0xA1, 0xA2, 0xA3, 0xA4};
+    UNUSED(ctx);
+
+    SIM_CHECK(AT24CXX_WriteAsync(&hat24, 0x5200, data, sizeof(data)) == AT24CXX_OK);
+    memcpy(&shadow[0x5200], data, sizeof(data));
+}
+
+static void test_blocking_after_queue(void)
+{
+    static uint8_t buf[4 * EE_PAGE];
+    uint8_t v = 0x3C;
+    uint32_t errors = hat24.Errors;
+
+    // A partial line still waiting for updates, then a blocking write
+    // that an interrupt tries to add to halfway through
+    queue(0x5000, &v, 1, NULL);
+    for (uint32_t i = 0; i < sizeof(buf); i++) buf[i] = (uint8_t)(i ^ 0x5A);
+    Sim_Schedule(Sim_UsToCycles(12000), queue_from_irq, NULL, true);
+    SIM_CHECK(AT24CXX_Write(&hat24, 0x5100, buf, sizeof(buf)) == AT24CXX_OK);
+    memcpy(&shadow[0x5100], buf, sizeof(buf));
+
+    // Queued data first, the blocking write whole, the interrupt's data after
+    SIM_CHECK(chip_matches_shadow(0x5000, 1));
+    SIM_CHECK(chip_matches_shadow(0x5100, sizeof(buf)));
+    SIM_CHECK(!chip_matches_shadow(0x5200, 4));
+    drain();
+    SIM_CHECK(chip_matches_shadow(0x5000, 0x300));
+    SIM_CHECK(hat24.Errors == errors);
+}
+
+static void test_timeout(void)
+{
+    uint8_t v = 0x5A;
+
+    // A write cycle that never ends within AT24CXX_WRITE_TIMEOUT_MS
+    eeprom.t_wr_us = 40000;
+    SIM_CHECK(AT24CXX_WriteAsync(&hat24, 0x6000, &v, 1) == AT24CXX_OK);
+    SIM_CHECK(AT24CXX_Sync(&hat24) == 1);
+    SIM_CHECK(hat24.Errors == 1);
+    SIM_CHECK(AT24CXX_Poll(&hat24) == 0);
+
+    // The blocking write reports it too
+    SIM_CHECK(AT24CXX_Write(&hat24, 0x6000, &v, 1) == AT24CXX_ERROR);
+
+    eeprom.t_wr_us = 5000;
+    Sim_AdvanceUs(50000);
+    SIM_CHECK(AT24CXX_Check(&hat24) == 0);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    hi2c1.Init.ClockSpeed = 400000;
+    hi2c1.hdmatx = &hdma_i2c1_tx;
+    hi2c1.hdmarx = &hdma_i2c1_rx;
+    Sim_AT24_Init(&eeprom, &hi2c1, AT24CXX_I2C_ADDR, EE_SIZE, EE_PAGE);
+    memset(shadow, 0xFF, sizeof(shadow));
+
+    SIM_CHECK(AT24CXX_Init(&hat24, &hi2c1, AT24C256, AT24CXX_I2C_ADDR) == 0);
+    SIM_CHECK(hat24.PageSize == EE_PAGE && hat24.Unit == EE_PAGE);
+
+    htim6.Instance = &tim6;
+    htim6.Init.Prescaler = 71;
+    htim6.Init.Period = 999;
+    HAL_TIM_Base_Start_IT(&htim6);
+
+    test_blocking();
+    test_async_bulk();
+    test_coalesce();
+    test_holes();
+    test_read_overlay();
+    test_random();
+    test_blocking_after_queue();
+    test_timeout();
+
+    Sim_AT24_Free(&eeprom);
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,144 @@
+/**
+ * @file dht11_sim_tests.c
+ * @brief dht11.c on a simulated sensor: background read driven by a 1 ms
+ *        tick and EXTI edge timestamps vs the blocking wrapper, checksum
+ *        error, missing sensor, busy handling
+ */
+
+#include "sim_test.h"
+#include "sim_dht11.h"
+#include "dht11.h"
+#include <string.h>
+
+static TIM_HandleTypeDef  htim6;
+static TIM_TypeDef        tim6;
+static Sim_DHT11          sensor;
+static DHT11_Handle_t     dht;
+static bool               tick_polls;
+static uint32_t           done_calls;
+static DHT11_Status       done_status;
+static uint32_t           exti_calls;
+
+// 1 ms tick runs the state machine, as on the target
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim == &htim6 && tick_polls) DHT11_Poll(&dht);
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    exti_calls++;
+    DHT11_EXTI_Callback(&dht, GPIO_Pin);
+}
+
+static void on_done(DHT11_Handle_t *dev, DHT11_Status status)
+{
+    (void)dev;
+    done_calls++;
+    done_status = status;
+}
+
+// Start a read and keep "working" in 100 us steps until the callback; returns
+// the virtual time the caller spent inside driver calls
+static uint64_t read_async(uint32_t *elapsed_ms)
+{
+    uint64_t t0 = Sim_Now(), in_call, guard = 0;
+    uint32_t calls = done_calls;
+
+    SIM_CHECK(DHT11_Start(&dht) == DHT11_OK);
+    in_call = Sim_Now() - t0;
+    SIM_CHECK(DHT11_Start(&dht) == DHT11_BUSY);
+    while (done_calls == calls && guard++ < 1000) Sim_AdvanceUs(100);
+    SIM_CHECK(done_calls == calls + 1);
+    *elapsed_ms = (uint32_t)(Sim_CyclesToUs(Sim_Now() - t0) / 1000.0);
+    return in_call;
+}
+
+static void test_async(void)
+{
+    uint32_t ms;
+    uint64_t in_call;
+
+    Sim_DHT11_Set(&sensor, 61, 23, 4);
+    in_call = read_async(&ms);
+    SIM_CHECK(done_status == DHT11_OK);
+    SIM_CHECK(dht.humidity_int == 61 && dht.temp_int == 23 && dht.temp_dec == 4);
+    SIM_CHECK(dht.successful_read_cnt == 1);
+    SIM_CHECK(ms >= 18 && ms <= 25);
+    SIM_CHECK(DHT11_Poll(&dht) == DHT11_OK);
+
+    printf("BENCH dht11 background read        %3u ms to result, caller blocked %6.1f us\n",
+           ms, Sim_CyclesToUs(in_call));
+    SIM_CHECK(Sim_CyclesToUs(in_call) < 20.0);
+}
+
+static void test_blocking(void)
+{
+    uint64_t t0;
+    double ms;
+
+    tick_polls = false;
+    Sim_DHT11_Set(&sensor, 40, 30, 0);
+    t0 = Sim_Now();
+    SIM_CHECK(DHT11_Read(&dht) == DHT11_OK);
+    ms = Sim_CyclesToUs(Sim_Now() - t0) / 1000.0;
+    SIM_CHECK(dht.humidity_int == 40 && dht.temp_int == 30);
+    printf("BENCH dht11 blocking read          caller blocked %6.1f ms (IRQs enabled)\n", ms);
+    tick_polls = true;
+}
+
+static void test_errors(void)
+{
+    uint32_t ms;
+
+    sensor.bad_checksum = true;
+    read_async(&ms);
+    SIM_CHECK(done_status == DHT11_ERROR_CHECKSUM);
+    SIM_CHECK(dht.checksum_error_cnt == 1);
+    sensor.bad_checksum = false;
+
+    sensor.present = false;
+    read_async(&ms);
+    SIM_CHECK(done_status == DHT11_ERROR_TIMEOUT);
+    SIM_CHECK(dht.timeout_cnt == 1);
+    SIM_CHECK(ms <= 19 + 12);
+    sensor.present = true;
+
+    SIM_CHECK(DHT11_GetErrorCount(&dht) == 2);
+
+    // Still good afterwards
+    read_async(&ms);
+    SIM_CHECK(done_status == DHT11_OK);
+
+    // The EXTI line is off between reads: edges on the pin raise nothing
+    exti_calls = 0;
+    Sim_GPIO_SetInput(GPIOA, GPIO_PIN_1, GPIO_PIN_RESET);
+    Sim_AdvanceUs(100);
+    Sim_GPIO_SetInput(GPIOA, GPIO_PIN_1, GPIO_PIN_SET);
+    Sim_AdvanceUs(100);
+    SIM_CHECK(exti_calls == 0);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    Sim_DHT11_Init(&sensor, GPIOA, GPIO_PIN_1);
+    DHT11_Init(&dht, GPIOA, GPIO_PIN_1);
+    DHT11_SetDoneCallback(&dht, on_done);
+
+    htim6.Instance = &tim6;
+    htim6.Init.Prescaler = 71;
+    htim6.Init.Period = 999;
+    tick_polls = true;
+    HAL_TIM_Base_Start_IT(&htim6);
+
+    test_async();
+    test_blocking();
+    test_errors();
+
+    // Only start signals of 18 ms or more went out
+    SIM_CHECK(sensor.stats.short_starts == 0);
+    SIM_CHECK(Sim_GetCpuStats()->irq_off_max_cycles == 0);
+
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,182 @@
+/**
+ * @file display_fb_sim_tests.c
+ * @brief display_fb.c on an ILI9341 panel: dirty-rectangle merging, partial
+ *        refresh traffic vs full redraws, per-pixel drawing cost
+ */
+
+#include "sim_test.h"
+#include "sim_panel.h"
+#include "ili9341.h"
+#include "display_fb.h"
+#include <string.h>
+
+#define W 240
+#define H 320
+
+static SPI_HandleTypeDef        hspi1;
+static DMA_HandleTypeDef        hdma_spi1_tx;
+static Sim_Panel                panel;
+static ILI9341_HandleTypeDef    hlcd;
+static Display_FB_HandleTypeDef fb;
+static uint16_t                 pixels[W * H];
+
+static bool panel_matches_fb(void)
+{
+    for (uint16_t y = 0; y < H; y++) {
+        for (uint16_t x = 0; x < W; x++) {
+            if (Sim_Panel_GetPixel(&panel, x, y) != Display_FB_GetPixel(&fb, x, y)) {
+                printf("mismatch at %u,%u\n", x, y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void test_first_flush(void)
+{
+    Display_FB_Init(&fb, &hlcd.Bus, pixels, W, H, 0, 0);
+    Display_FB_FillRect(&fb, 0, 0, W, H, ILI9341_NAVY);
+
+    // Init marks everything dirty; the fill lands inside it
+    SIM_CHECK(fb.DirtyCount == 1);
+    SIM_CHECK(Display_FB_Flush(&fb) == 1);
+    SIM_CHECK(fb.PixelsSent == (uint32_t)W * H);
+    SIM_CHECK(panel_matches_fb());
+
+    // Nothing changed: nothing is sent
+    SIM_CHECK(Display_FB_Flush(&fb) == 0);
+}
+
+static void test_merge(void)
+{
+    // Overlapping and touching rects become one region
+    Display_FB_FillRect(&fb, 10, 10, 20, 20, ILI9341_RED);
+    Display_FB_FillRect(&fb, 15, 12, 20, 20, ILI9341_GREEN);
+    Display_FB_FillRect(&fb, 35, 12, 8, 20, ILI9341_BLUE);
+    SIM_CHECK(fb.DirtyCount == 1);
+    SIM_CHECK(fb.Dirty[0].x0 == 10 && fb.Dirty[0].y0 == 10);
+    SIM_CHECK(fb.Dirty[0].x1 == 42 && fb.Dirty[0].y1 == 31);
+
+    // Far apart rects stay separate
+    Display_FB_FillRect(&fb, 200, 300, 10, 10, ILI9341_WHITE);
+    SIM_CHECK(fb.DirtyCount == 2);
+
+    // Clipped at the canvas edge
+    Display_FB_FillRect(&fb, 235, 0, 50, 5, ILI9341_YELLOW);
+    SIM_CHECK(fb.DirtyCount == 3);
+    SIM_CHECK(fb.Dirty[2].x1 == W - 1);
+
+    SIM_CHECK(Display_FB_Flush(&fb) == 3);
+    SIM_CHECK(panel.stats.out_of_window == 0);
+    SIM_CHECK(panel_matches_fb());
+
+    // More scattered regions than slots: closest ones merge, output stays right
+    for (uint16_t i = 0; i < 3 * DISPLAY_FB_MAX_DIRTY; i++) {
+        Display_FB_FillRect(&fb, (uint16_t)((i * 37) % 220), (uint16_t)((i * 53) % 300), 6, 6, (uint16_t)(i * 1111));
+    }
+    SIM_CHECK(fb.DirtyCount <= DISPLAY_FB_MAX_DIRTY);
+    Display_FB_Flush(&fb);
+    SIM_CHECK(panel.stats.out_of_window == 0);
+    SIM_CHECK(panel_matches_fb());
+}
+
+static void test_dashboard(void)
+{
+    static const uint16_t field_x[4] = {16, 140, 16, 140};
+    static const uint16_t field_y[4] = {40, 40, 200, 200};
+    static uint16_t glyph[8 * 16];
+    Sim_BusStats *bus = Sim_SPI_Stats(&hspi1);
+    Sim_Bench bench;
+    uint64_t tx_start, partial_bytes, full_bytes;
+    const int frames = 10;
+
+    // Partial refresh: four 5-digit fields change per frame
+    tx_start = bus->tx_bytes;
+    Sim_Bench_Begin(&bench, "fb dashboard partial", bus);
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < 4; i++) {
+            Display_FB_FillRect(&fb, field_x[i], field_y[i], 48, 16, ILI9341_BLACK);
+            for (int d = 0; d < 5; d++) {
+                for (uint32_t k = 0; k < 8U * 16U; k++) glyph[k] = (uint16_t)((k * (f + d + 1)) | 0x0821);
+                Display_FB_DrawImage(&fb, (uint16_t)(field_x[i] + 2 + d * 9), field_y[i], 8, 16, glyph);
+            }
+        }
+        SIM_CHECK(Display_FB_Flush(&fb) == 4);
+    }
+    partial_bytes = bus->tx_bytes - tx_start;
+    Sim_Bench_End(&bench, partial_bytes);
+    SIM_CHECK(panel_matches_fb());
+
+    // Same frames as full-screen redraws
+    tx_start = bus->tx_bytes;
+    Sim_Bench_Begin(&bench, "fb dashboard full redraw", bus);
+    for (int f = 0; f < frames; f++) {
+        Display_FB_InvalidateAll(&fb);
+        Display_FB_Flush(&fb);
+    }
+    full_bytes = bus->tx_bytes - tx_start;
+    Sim_Bench_End(&bench, full_bytes);
+
+    printf("BENCH fb dashboard                 %llu B/frame partial vs %llu B/frame full (%.1fx)\n",
+           (unsigned long long)(partial_bytes / frames), (unsigned long long)(full_bytes / frames),
+           (double)full_bytes / (double)partial_bytes);
+    SIM_CHECK(partial_bytes * 10 < full_bytes);
+}
+
+static void test_pixels(void)
+{
+    Sim_BusStats *bus = Sim_SPI_Stats(&hspi1);
+    Sim_Bench bench;
+    uint64_t start, calls, direct_bytes, direct_calls, fb_bytes, fb_calls;
+
+    // Text-like pattern (every other pixel of a 40x8 cell) straight to the
+    // panel: one address window per pixel
+    start = bus->tx_bytes;
+    calls = bus->calls;
+    Sim_Bench_Begin(&bench, "direct 160 pixels", bus);
+    for (uint16_t y = 0; y < 8; y++) {
+        for (uint16_t x = y & 1; x < 40; x += 2) {
+            ILI9341_DrawPixel(&hlcd, 20 + x, 100 + y, ILI9341_ORANGE);
+        }
+    }
+    direct_bytes = bus->tx_bytes - start;
+    direct_calls = bus->calls - calls;
+    Sim_Bench_End(&bench, direct_bytes);
+
+    // The same pattern through the framebuffer: one region
+    start = bus->tx_bytes;
+    calls = bus->calls;
+    Sim_Bench_Begin(&bench, "fb 160 pixels", bus);
+    for (uint16_t y = 0; y < 8; y++) {
+        for (uint16_t x = y & 1; x < 40; x += 2) {
+            Display_FB_DrawPixel(&fb, 20 + x, 100 + y, ILI9341_ORANGE);
+        }
+    }
+    SIM_CHECK(fb.DirtyCount == 1);
+    Display_FB_Flush(&fb);
+    fb_bytes = bus->tx_bytes - start;
+    fb_calls = bus->calls - calls;
+    Sim_Bench_End(&bench, fb_bytes);
+
+    SIM_CHECK(fb_bytes < direct_bytes);
+    SIM_CHECK(fb_calls * 10 < direct_calls);
+    SIM_CHECK(panel_matches_fb());
+}
+
+int main(void)
+{
+    Sim_Reset();
+    Sim_Panel_Init(&panel, &hspi1, GPIOA, GPIO_PIN_4, GPIOA, GPIO_PIN_3, W, H);
+    hspi1.hdmatx = &hdma_spi1_tx;
+    SIM_CHECK(ILI9341_Init(&hlcd, &hspi1, GPIOA, GPIO_PIN_4, GPIOA, GPIO_PIN_3,
+                           GPIOA, GPIO_PIN_2, NULL, 0) == 0);
+
+    test_first_flush();
+    test_merge();
+    test_dashboard();
+    test_pixels();
+
+    Sim_Panel_Free(&panel);
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,256 @@
+/**
+ * @file ds18b20_sim_tests.c
+ * @brief ds18b20.c on the UART 1-Wire engine with a simulated multi-drop
+ *        bus: ROM search, broadcast conversion vs one sensor at a time,
+ *        busy polling, resolution, CRC faults, alarm search, polled mode
+ */
+
+#include "sim_test.h"
+#include "sim_onewire.h"
+#include "ds18b20.h"
+#include <string.h>
+
+#define N_SENSORS 5
+
+static UART_HandleTypeDef     huart3;     // DMA, multi-drop bus
+static DMA_HandleTypeDef      hdma_tx, hdma_rx;
+static UART_HandleTypeDef     huart4;     // No DMA, single sensor
+static Sim_OneWire            wire3, wire4;
+static OneWire_HandleTypeDef  ow3, ow4;
+static DS18B20_Handle_t       sensors[8];
+static uint8_t                found;
+static Sim_DS18B20           *model[N_SENSORS];
+static uint32_t               error_callbacks;
+
+static const float temps[N_SENSORS] = {21.5f, -10.125f, 0.0625f, 85.0f, 36.6875f};
+
+static void on_error(DS18B20_Handle_t *dev)
+{
+    (void)dev;
+    error_callbacks++;
+}
+
+static Sim_DS18B20 *model_of(const DS18B20_Handle_t *h)
+{
+    for (uint8_t i = 0; i < N_SENSORS; i++) {
+        if (memcmp(model[i]->rom, h->rom, 8) == 0) return model[i];
+    }
+    return NULL;
+}
+
+// Reading equals the model temperature truncated to the resolution
+static bool temp_matches(const DS18B20_Handle_t *h, uint8_t bits)
+{
+    Sim_DS18B20 *m = model_of(h);
+
+    if (m == NULL) return false;
+    return h->last_temp * 16.0f == (float)(m->temp & ~((1 << (12 - bits)) - 1));
+}
+
+static void test_no_device(void)
+{
+    uint8_t roms[2][8];
+
+    SIM_CHECK(OneWire_Reset(&ow3) == ONEWIRE_NO_DEVICE);
+    SIM_CHECK(OneWire_Search(&ow3, ONEWIRE_CMD_SEARCH_ROM, roms, 2) == 0);
+    SIM_CHECK(DS18B20_Search(&ow3, sensors, 8) == 0);
+    SIM_CHECK(DS18B20_StartConversionAll(&ow3) == ONEWIRE_NO_DEVICE);
+}
+
+static void test_search(void)
+{
+    uint8_t roms[8][8];
+    uint8_t n;
+
+    for (uint8_t i = 0; i < N_SENSORS; i++) {
+        // Serials share low bits so the search has to branch deep into the ROM
+        model[i] = Sim_OneWire_AddDevice(&wire3, DS18B20_FAMILY_CODE, 0x00A1B2C3D400ULL + i * 0x11ULL);
+        Sim_DS18B20_SetTemp(model[i], temps[i]);
+    }
+    Sim_OneWire_AddDevice(&wire3, 0x2D, 0x000000123456ULL);     // DS2431 EEPROM, not a sensor
+
+    SIM_CHECK(OneWire_Reset(&ow3) == ONEWIRE_OK);
+    n = OneWire_Search(&ow3, ONEWIRE_CMD_SEARCH_ROM, roms, 8);
+    SIM_CHECK(n == N_SENSORS + 1);
+    for (uint8_t i = 0; i < n; i++) SIM_CHECK(OneWire_Crc8(roms[i], 8) == 0);
+
+    found = DS18B20_Search(&ow3, sensors, 8);
+    SIM_CHECK(found == N_SENSORS);
+    for (uint8_t i = 0; i < found; i++) {
+        SIM_CHECK(sensors[i].use_rom && model_of(&sensors[i]) != NULL);
+        for (uint8_t j = 0; j < i; j++) SIM_CHECK(memcmp(sensors[i].rom, sensors[j].rom, 8) != 0);
+        DS18B20_SetErrorCallback(&sensors[i], on_error);
+    }
+
+    // Stops at max
+    SIM_CHECK(OneWire_Search(&ow3, ONEWIRE_CMD_SEARCH_ROM, roms, 2) == 2);
+    printf("BENCH ds18b20 search %u devices       %6lu slots, %lu transfers\n",
+           n, (unsigned long)ow3.Slots, (unsigned long)ow3.Transfers);
+}
+
+static void test_broadcast_vs_sequential(void)
+{
+    uint64_t t0;
+    double seq_ms, all_ms, poll_ms;
+
+    // Before any conversion the power-on value reads back
+    SIM_CHECK(DS18B20_ReadTemp(&sensors[0]) == 85.0f);
+
+    t0 = Sim_Now();
+    for (uint8_t i = 0; i < found; i++) {
+        SIM_CHECK(DS18B20_ReadTempBlocked(&sensors[i]) != DS18B20_ERROR_TEMP);
+        SIM_CHECK(temp_matches(&sensors[i], 12));
+    }
+    seq_ms = Sim_CyclesToUs(Sim_Now() - t0) / 1000.0;
+
+    // Fixed worst-case wait
+    for (uint8_t i = 0; i < N_SENSORS; i++) Sim_DS18B20_SetTemp(model[i], temps[i] + 1.0f);
+    t0 = Sim_Now();
+    SIM_CHECK(DS18B20_StartConversionAll(&ow3) == ONEWIRE_OK);
+    HAL_Delay(DS18B20_ConversionTimeMs(&sensors[0]));
+    SIM_CHECK(DS18B20_ReadAll(sensors, found) == found);
+    all_ms = Sim_CyclesToUs(Sim_Now() - t0) / 1000.0;
+    for (uint8_t i = 0; i < found; i++) SIM_CHECK(temp_matches(&sensors[i], 12));
+
+    // Busy polling: read slots stay low until every sensor is done
+    for (uint8_t i = 0; i < N_SENSORS; i++) Sim_DS18B20_SetTemp(model[i], temps[i] - 1.0f);
+    t0 = Sim_Now();
+    SIM_CHECK(DS18B20_StartConversionAll(&ow3) == ONEWIRE_OK);
+    SIM_CHECK(DS18B20_ConversionDone(&ow3) == 0);
+    while (!DS18B20_ConversionDone(&ow3)) HAL_Delay(5);
+    SIM_CHECK(Sim_CyclesToUs(Sim_Now() - t0) >= 750000.0);
+    SIM_CHECK(DS18B20_ReadAll(sensors, found) == found);
+    poll_ms = Sim_CyclesToUs(Sim_Now() - t0) / 1000.0;
+    for (uint8_t i = 0; i < found; i++) SIM_CHECK(temp_matches(&sensors[i], 12));
+
+    printf("BENCH ds18b20 %u sensors sequential  %7.1f ms\n", found, seq_ms);
+    printf("BENCH ds18b20 %u sensors broadcast   %7.1f ms (%.1fx)\n", found, all_ms, seq_ms / all_ms);
+    printf("BENCH ds18b20 %u sensors busy-poll   %7.1f ms\n", found, poll_ms);
+    SIM_CHECK(seq_ms > found * 750.0);
+    SIM_CHECK(all_ms < 750.0 + found * 20.0);
+    SIM_CHECK(wire3.stats.converts == (uint64_t)found * 3);
+}
+
+static void test_resolution(void)
+{
+    uint64_t t0;
+    double ms;
+
+    for (uint8_t i = 0; i < found; i++) {
+        SIM_CHECK(DS18B20_SetResolution(&sensors[i], 9) == ONEWIRE_OK);
+        SIM_CHECK(DS18B20_ConversionTimeMs(&sensors[i]) == 93);
+    }
+    SIM_CHECK(DS18B20_SetResolution(&sensors[0], 13) == ONEWIRE_ERR_BUS);
+
+    t0 = Sim_Now();
+    DS18B20_StartConversionAll(&ow3);
+    while (!DS18B20_ConversionDone(&ow3)) HAL_Delay(1);
+    ms = Sim_CyclesToUs(Sim_Now() - t0) / 1000.0;
+    SIM_CHECK(ms >= 93.0 && ms < 100.0);
+    SIM_CHECK(DS18B20_ReadAll(sensors, found) == found);
+    for (uint8_t i = 0; i < found; i++) {
+        SIM_CHECK(sensors[i].resolution == 9);
+        SIM_CHECK(temp_matches(&sensors[i], 9));
+    }
+    printf("BENCH ds18b20 9-bit broadcast        %7.1f ms to done\n", ms);
+
+    for (uint8_t i = 0; i < found; i++) SIM_CHECK(DS18B20_SetResolution(&sensors[i], 12) == ONEWIRE_OK);
+}
+
+static void test_errors(void)
+{
+    DS18B20_Handle_t rescan[8];
+    Sim_DS18B20 *m = model_of(&sensors[1]);
+    uint32_t crc_before = sensors[1].crc_error_cnt;
+
+    error_callbacks = 0;
+    m->crc_faults = 1;
+    SIM_CHECK(DS18B20_ReadTemp(&sensors[1]) == DS18B20_ERROR_TEMP);
+    SIM_CHECK(sensors[1].crc_error_cnt == crc_before + 1);
+    SIM_CHECK(error_callbacks == 1);
+    SIM_CHECK(DS18B20_ReadTemp(&sensors[1]) != DS18B20_ERROR_TEMP);
+
+    // Unplugged: the others still answer the reset, nobody answers the read
+    m->present = false;
+    SIM_CHECK(DS18B20_ReadTemp(&sensors[1]) == DS18B20_ERROR_TEMP);
+    SIM_CHECK(DS18B20_ReadAll(sensors, found) == found - 1);
+    SIM_CHECK(DS18B20_Search(&ow3, rescan, 8) == found - 1);
+    m->present = true;
+    SIM_CHECK(error_callbacks == 3);
+}
+
+static void test_alarm_search(void)
+{
+    uint8_t roms[8][8];
+    uint8_t frame[4] = {DS18B20_CMD_WRITE_SP, 30, (uint8_t)(int8_t)-5, 0x7F};   // TH 30, TL -5, 12-bit
+    uint8_t n, hot = 0;
+
+    for (uint8_t i = 0; i < found; i++) {
+        SIM_CHECK(OneWire_Select(&ow3, sensors[i].rom) == ONEWIRE_OK);
+        SIM_CHECK(OneWire_WriteBytes(&ow3, frame, sizeof(frame)) == ONEWIRE_OK);
+    }
+    for (uint8_t i = 0; i < N_SENSORS; i++) {
+        Sim_DS18B20_SetTemp(model[i], temps[i]);
+        if (temps[i] >= 31.0f || temps[i] < -4.0f) hot++;
+    }
+    DS18B20_StartConversionAll(&ow3);
+    HAL_Delay(750);
+
+    n = OneWire_Search(&ow3, ONEWIRE_CMD_ALARM_SEARCH, roms, 8);
+    SIM_CHECK(n == hot && hot == 3);
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = 0; j < N_SENSORS; j++) {
+            if (memcmp(model[j]->rom, roms[i], 8) == 0) SIM_CHECK(model[j]->alarm);
+        }
+    }
+}
+
+static void test_polled(void)
+{
+    DS18B20_Handle_t single;
+    Sim_DS18B20 *m;
+    Sim_Bench b;
+
+    Sim_OneWire_Init(&wire4, &huart4);
+    m = Sim_OneWire_AddDevice(&wire4, DS18B20_FAMILY_CODE, 0x000000000042ULL);
+    Sim_DS18B20_SetTemp(m, -55.0f);
+
+    SIM_CHECK(OneWire_Init(&ow4, &huart4) == ONEWIRE_OK);
+    SIM_CHECK(ow4.UseDMA == 0 && ow3.UseDMA == 1);
+
+    DS18B20_Init(&single, &ow4, NULL);
+    SIM_CHECK(DS18B20_ReadTempBlocked(&single) == -55.0f);
+
+    // Same Match ROM + scratchpad read with and without DMA
+    DS18B20_Init(&single, &ow4, m->rom);
+    Sim_Bench_Begin(&b, "ds18b20 read polled", Sim_UART_Stats(&huart4));
+    SIM_CHECK(DS18B20_ReadTemp(&single) == -55.0f);
+    Sim_Bench_End(&b, 9);
+    Sim_Bench_Begin(&b, "ds18b20 read dma", Sim_UART_Stats(&huart3));
+    SIM_CHECK(DS18B20_ReadTemp(&sensors[0]) != DS18B20_ERROR_TEMP);
+    Sim_Bench_End(&b, 9);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    huart3.hdmatx = &hdma_tx;
+    huart3.hdmarx = &hdma_rx;
+    Sim_OneWire_Init(&wire3, &huart3);
+    SIM_CHECK(OneWire_Init(&ow3, &huart3) == ONEWIRE_OK);
+    SIM_CHECK(huart3.Init.BaudRate == ONEWIRE_BAUD_SLOT);
+
+    test_no_device();
+    test_search();
+    test_broadcast_vs_sequential();
+    test_resolution();
+    test_errors();
+    test_alarm_search();
+    test_polled();
+
+    // The UART times every slot: no interrupt-off window anywhere
+    SIM_CHECK(Sim_GetCpuStats()->irq_off_max_cycles == 0);
+    SIM_CHECK(ow3.Errors == 0 && ow4.Errors == 0);
+
+    return SIM_TEST_RESULT();
+}
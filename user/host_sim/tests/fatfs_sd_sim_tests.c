@@ -0,0 +1,323 @@
+/**
+ * @file fatfs_sd_sim_tests.c
+ * @brief FatFs on the SPI SD driver (fatfs_sd.c): capacity from the CSD,
+ *        multi-sector transfers, sector cache, and logger throughput on a
+ *        card image file for each cluster size and cache setting
+ *
+ * The card is formatted per cluster size and saved to an image file; every
+ * cache setting then starts from that image. Set SIM_SD_IMAGE to a raw image
+ * (e.g. dd of a logger's card) to run the workloads on it instead of the
+ * formatted ones; the image file itself is not modified.
+ */
+
+#include "sim_test.h"
+#include "sim_sdcard.h"
+#include "fatfs_sd.h"
+#include "ff.h"
+#include "diskio.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCKS      (128U * 1024U)   // 64 MB card
+#define IMAGE_FILE  "fatfs_sd_sim.img"
+
+#define LOG_RECORDS     1024U   // 64-byte records
+#define LOG_SYNC_EVERY  16U     // f_sync per 1 KB, as a logger bounding its loss on power cut
+#define BULK_BYTES      (256U * 1024U)
+#define SCAN_FILES      24U
+
+static SPI_HandleTypeDef         hspi2;
+static DMA_HandleTypeDef         hdma_spi2_rx, hdma_spi2_tx;
+static Sim_SDCard                card;
+static SD_Card_SPI_HandleTypeDef hsd;
+static FATFS                     fs;
+static char                      path[4];
+static uint8_t                   work[_MAX_SS];
+
+typedef struct {
+    double   log_kbs;
+    double   bulk_kbs;
+    double   scan_ms;
+    uint64_t log_cmds;          // Card commands for the logger run
+    uint64_t scan_reads;        // CMD17 + CMD18 for the directory scan
+} Workload_Result;
+
+static uint64_t card_commands(void)
+{
+    return card.stats.cmd17 + card.stats.cmd18 + card.stats.cmd24 + card.stats.cmd25;
+}
+
+static void record(char *buf, uint32_t n)
+{
+    // Fixed 64-byte CSV line; tmp holds the widest the format can produce
+    char tmp[136];
+    int len = snprintf(tmp, sizeof(tmp), "%08lu,%+06ld,%+06ld,%+06ld,%05lu,status=ok,.................\n",
+                       (unsigned long)n, (long)(n % 2000) - 1000, (long)(n * 7 % 2000) - 1000,
+                       (long)(n * 13 % 2000) - 1000, (unsigned long)(n * 17 % 65536));
+
+    SIM_CHECK(len == 64);
+    memcpy(buf, tmp, 64);
+}
+
+static void test_init(void)
+{
+    DWORD sectors = 0, block = 0;
+    WORD size = 0;
+
+    SIM_CHECK(SD_SPI_Init(&hsd, &hspi2, GPIOB, GPIO_PIN_12) == 0);
+    SIM_CHECK(hsd.Type == SD_CARD_TYPE_V2HC && hsd.UseDMA);
+    SIM_CHECK(hsd.Capacity == BLOCKS);
+    SIM_CHECK(SD_SPI_GetCapacityKB(&hsd) == BLOCKS / 2);
+    SIM_CHECK(hsd.EraseSectors == 128);
+
+    SIM_CHECK(FatFs_SD_Link(&hsd, path) == 0);
+    SIM_CHECK(disk_initialize(0) == 0);
+    SIM_CHECK(disk_ioctl(0, GET_SECTOR_COUNT, &sectors) == RES_OK && sectors == BLOCKS);
+    SIM_CHECK(disk_ioctl(0, GET_SECTOR_SIZE, &size) == RES_OK && size == 512);
+    SIM_CHECK(disk_ioctl(0, GET_BLOCK_SIZE, &block) == RES_OK && block == 128);
+}
+
+// Raw diskio: multi-sector calls are single streams, the cache is coherent with them
+static void test_diskio(void)
+{
+    static uint8_t src[16 * 512], dst[16 * 512];
+    uint8_t sector[512];
+    uint64_t cmd18 = card.stats.cmd18, cmd25 = card.stats.cmd25, cmd17 = card.stats.cmd17;
+
+    for (uint32_t i = 0; i < sizeof(src); i++) src[i] = (uint8_t)(i * 29 + 7);
+
+    SIM_CHECK(disk_write(0, src, 1000, 16) == RES_OK);
+    SIM_CHECK(disk_read(0, dst, 1000, 16) == RES_OK);
+    SIM_CHECK(memcmp(src, dst, sizeof(src)) == 0);
+    SIM_CHECK(card.stats.cmd25 - cmd25 == 1 && card.stats.cmd18 - cmd18 == 1);
+
+    // Single sectors: the second read is a hit
+    SIM_CHECK(disk_read(0, sector, 1003, 1) == RES_OK);
+    SIM_CHECK(disk_read(0, sector, 1003, 1) == RES_OK);
+    SIM_CHECK(card.stats.cmd17 - cmd17 == 1);
+    SIM_CHECK(memcmp(sector, &src[3 * 512], 512) == 0);
+
+    // A cached write is seen by a multi-sector read before it reaches the card
+    memset(sector, 0xA5, sizeof(sector));
+    SIM_CHECK(disk_write(0, sector, 1005, 1) == RES_OK);
+    SIM_CHECK(card.mem[1005 * 512] == src[5 * 512]);
+    SIM_CHECK(disk_read(0, dst, 1000, 16) == RES_OK);
+    SIM_CHECK(dst[5 * 512] == 0xA5 && memcmp(dst, src, 5 * 512) == 0);
+    SIM_CHECK(disk_ioctl(0, CTRL_SYNC, NULL) == RES_OK);
+    SIM_CHECK(card.mem[1005 * 512] == 0xA5);
+
+    // A multi-sector write supersedes cached copies
+    SIM_CHECK(disk_read(0, sector, 1006, 1) == RES_OK);
+    SIM_CHECK(disk_write(0, src, 1000, 16) == RES_OK);
+    SIM_CHECK(disk_read(0, sector, 1006, 1) == RES_OK);
+    SIM_CHECK(memcmp(sector, &src[6 * 512], 512) == 0);
+
+    // Consecutive dirty sectors are written back as one stream
+    cmd25 = card.stats.cmd25;
+    for (uint32_t s = 0; s < 3; s++) SIM_CHECK(disk_write(0, &src[s * 512], 2000 + s, 1) == RES_OK);
+    SIM_CHECK(FatFs_SD_Flush() == 0);
+    SIM_CHECK(card.stats.cmd25 - cmd25 == 1);
+    SIM_CHECK(memcmp(&card.mem[2000 * 512], src, 3 * 512) == 0);
+    SIM_CHECK(card.stats.protocol_errors == 0);
+}
+
+static void format_image(DWORD au)
+{
+    memset(card.mem, 0, (size_t)BLOCKS * 512U);
+    SIM_CHECK(f_mkfs(path, FM_ANY, au, work, sizeof(work)) == FR_OK);
+
+    // Files for the directory scan, laid down before the timed runs
+    SIM_CHECK(f_mount(&fs, path, 1) == FR_OK);
+    SIM_CHECK(f_mkdir("0:/cfg") == FR_OK);
+    for (uint32_t i = 0; i < SCAN_FILES; i++) {
+        char name[24];
+        FIL f;
+        UINT bw;
+
+        snprintf(name, sizeof(name), "0:/cfg/param%02lu.ini", (unsigned long)i);
+        SIM_CHECK(f_open(&f, name, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK);
+        SIM_CHECK(f_write(&f, name, (UINT)strlen(name), &bw) == FR_OK);
+        SIM_CHECK(f_close(&f) == FR_OK);
+    }
+    SIM_CHECK(f_mount(NULL, path, 0) == FR_OK);
+    SIM_CHECK(Sim_SDCard_SaveImage(&card, IMAGE_FILE) == 0);
+}
+
+static void run_workloads(const char *image, Workload_Result *res)
+{
+    static uint8_t chunk[4096];
+    char line[64];
+    uint64_t t0, cmds, reads;
+    FIL f;
+    UINT bw;
+    FILINFO info;
+
+    SIM_CHECK(Sim_SDCard_LoadImage(&card, image) == 0);
+    SIM_CHECK(f_mount(&fs, path, 1) == FR_OK);
+
+    // Logger: small records, f_sync every LOG_SYNC_EVERY
+    SIM_CHECK(f_open(&f, "0:/log.csv", FA_WRITE | FA_CREATE_ALWAYS) == FR_OK);
+    t0 = Sim_Now();
+    cmds = card_commands();
+    for (uint32_t n = 0; n < LOG_RECORDS; n++) {
+        record(line, n);
+        SIM_CHECK(f_write(&f, line, 64, &bw) == FR_OK && bw == 64);
+        if ((n + 1) % LOG_SYNC_EVERY == 0) SIM_CHECK(f_sync(&f) == FR_OK);
+    }
+    SIM_CHECK(f_close(&f) == FR_OK);
+    res->log_kbs = LOG_RECORDS * 64.0 / 1024.0 / (Sim_CyclesToUs(Sim_Now() - t0) / 1e6);
+    res->log_cmds = card_commands() - cmds;
+
+    // Bulk: 4 KB writes
+    SIM_CHECK(f_open(&f, "0:/bulk.bin", FA_WRITE | FA_CREATE_ALWAYS) == FR_OK);
+    t0 = Sim_Now();
+    for (uint32_t off = 0; off < BULK_BYTES; off += sizeof(chunk)) {
+        for (uint32_t i = 0; i < sizeof(chunk); i++) chunk[i] = (uint8_t)((off + i) * 7 >> 3);
+        SIM_CHECK(f_write(&f, chunk, sizeof(chunk), &bw) == FR_OK && bw == sizeof(chunk));
+    }
+    SIM_CHECK(f_close(&f) == FR_OK);
+    res->bulk_kbs = BULK_BYTES / 1024.0 / (Sim_CyclesToUs(Sim_Now() - t0) / 1e6);
+
+    // Directory scan: stat every config file by path
+    t0 = Sim_Now();
+    reads = card.stats.cmd17 + card.stats.cmd18;
+    for (uint32_t i = 0; i < SCAN_FILES; i++) {
+        char name[24];
+
+        snprintf(name, sizeof(name), "0:/cfg/param%02lu.ini", (unsigned long)i);
+        if (f_stat(name, &info) != FR_OK) break;
+    }
+    res->scan_ms = Sim_CyclesToUs(Sim_Now() - t0) / 1000.0;
+    res->scan_reads = card.stats.cmd17 + card.stats.cmd18 - reads;
+
+    SIM_CHECK(f_mount(NULL, path, 0) == FR_OK);
+}
+
+// Everything written with the cache on is on the card after f_close
+static void verify_card(void)
+{
+    static uint8_t chunk[4096];
+    char line[64], back[64];
+    uint32_t bad = 0;
+    FIL f;
+    UINT br;
+
+    SIM_CHECK(Sim_SDCard_SaveImage(&card, IMAGE_FILE) == 0);
+    memset(card.mem, 0, (size_t)BLOCKS * 512U);
+    SIM_CHECK(Sim_SDCard_LoadImage(&card, IMAGE_FILE) == 0);
+    SIM_CHECK(f_mount(&fs, path, 1) == FR_OK);
+
+    SIM_CHECK(f_open(&f, "0:/log.csv", FA_READ) == FR_OK);
+    SIM_CHECK(f_size(&f) == LOG_RECORDS * 64U);
+    for (uint32_t n = 0; n < LOG_RECORDS; n++) {
+        record(line, n);
+        if (f_read(&f, back, 64, &br) != FR_OK || br != 64 || memcmp(back, line, 64) != 0) bad++;
+    }
+    SIM_CHECK(f_close(&f) == FR_OK);
+
+    SIM_CHECK(f_open(&f, "0:/bulk.bin", FA_READ) == FR_OK);
+    for (uint32_t off = 0; off < BULK_BYTES; off += sizeof(chunk)) {
+        if (f_read(&f, chunk, sizeof(chunk), &br) != FR_OK || br != sizeof(chunk)) bad++;
+        for (uint32_t i = 0; i < sizeof(chunk); i++) {
+            if (chunk[i] != (uint8_t)((off + i) * 7 >> 3)) {
+                bad++;
+                break;
+            }
+        }
+    }
+    SIM_CHECK(f_close(&f) == FR_OK);
+    SIM_CHECK(bad == 0);
+    SIM_CHECK(f_mount(NULL, path, 0) == FR_OK);
+}
+
+static void print_result(const char *label, uint8_t cache, const Workload_Result *r)
+{
+    printf("BENCH fatfs sd %-10s cache %u   log %6.1f KB/s %5llu cmds   bulk %6.1f KB/s   scan %6.2f ms %4llu reads\n",
+           label, cache, r->log_kbs, (unsigned long long)r->log_cmds, r->bulk_kbs,
+           r->scan_ms, (unsigned long long)r->scan_reads);
+}
+
+static void test_matrix(void)
+{
+    static const DWORD au_sizes[] = {4096, 16384, 32768};
+    static const uint8_t caches[] = {0, 2, FATFS_SD_CACHE_SECTORS};
+    static const char *fat_names[] = {"", "FAT12", "FAT16", "FAT32"};
+
+    for (uint32_t a = 0; a < sizeof(au_sizes) / sizeof(au_sizes[0]); a++) {
+        Workload_Result res[sizeof(caches)];
+        uint64_t cmd25 = card.stats.cmd25;
+        char label[32];
+
+        SIM_CHECK(FatFs_SD_SetCache(FATFS_SD_CACHE_SECTORS) == 0);
+        format_image(au_sizes[a]);
+        SIM_CHECK(f_mount(&fs, path, 1) == FR_OK);
+        SIM_CHECK(fs.csize * 512U == au_sizes[a]);
+        snprintf(label, sizeof(label), "%s %2luK", fat_names[fs.fs_type < 4 ? fs.fs_type : 0],
+                 (unsigned long)(au_sizes[a] / 1024));
+        SIM_CHECK(f_mount(NULL, path, 0) == FR_OK);
+
+        for (uint32_t c = 0; c < sizeof(caches); c++) {
+            SIM_CHECK(FatFs_SD_SetCache(caches[c]) == 0);
+            run_workloads(IMAGE_FILE, &res[c]);
+            print_result(label, caches[c], &res[c]);
+        }
+        verify_card();
+
+        // Whole sectors of f_write go out as CMD25 streams
+        SIM_CHECK(card.stats.cmd25 - cmd25 >= BULK_BYTES / au_sizes[a]);
+        // The cache takes the repeated FAT and directory reads off the card
+        SIM_CHECK(res[sizeof(caches) - 1].scan_reads < res[0].scan_reads);
+        SIM_CHECK(res[sizeof(caches) - 1].scan_ms < res[0].scan_ms);
+        SIM_CHECK(res[sizeof(caches) - 1].log_cmds < res[0].log_cmds);
+    }
+    SIM_CHECK(card.stats.protocol_errors == 0);
+    remove(IMAGE_FILE);
+}
+
+// A user-supplied image: workloads only, the file is not written
+static int run_user_image(const char *image)
+{
+    static const uint8_t caches[] = {0, 2, FATFS_SD_CACHE_SECTORS};
+    FILE *f = fopen(image, "rb");
+    long size;
+
+    if (f == NULL) {
+        printf("FAIL cannot open %s\n", image);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fclose(f);
+
+    Sim_SDCard_Init(&card, &hspi2, GPIOB, GPIO_PIN_12, (uint32_t)(size / 512), true);
+    SIM_CHECK(SD_SPI_Init(&hsd, &hspi2, GPIOB, GPIO_PIN_12) == 0);
+    SIM_CHECK(FatFs_SD_Link(&hsd, path) == 0);
+    for (uint32_t c = 0; c < sizeof(caches); c++) {
+        Workload_Result res;
+
+        SIM_CHECK(FatFs_SD_SetCache(caches[c]) == 0);
+        run_workloads(image, &res);
+        print_result("image", caches[c], &res);
+    }
+    Sim_SDCard_Free(&card);
+    return SIM_TEST_RESULT();
+}
+
+int main(void)
+{
+    const char *image = getenv("SIM_SD_IMAGE");
+
+    Sim_Reset();
+    hspi2.hdmarx = &hdma_spi2_rx;
+    hspi2.hdmatx = &hdma_spi2_tx;
+    if (image != NULL && image[0] != '\0') return run_user_image(image);
+
+    Sim_SDCard_Init(&card, &hspi2, GPIOB, GPIO_PIN_12, BLOCKS, true);
+
+    test_init();
+    test_diskio();
+    test_matrix();
+
+    Sim_SDCard_Free(&card);
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,220 @@
+/**
+ * @file flash_kv_sim_tests.c
+ * @brief flash_kv.c on internal_flash.c on the simulated F1 flash: roundtrip,
+ *        cost of a setting update vs rewriting a page, compaction wear
+ *        spreading, power cuts at every flash operation
+ */
+
+#include "sim_test.h"
+#include "flash_kv.h"
+#include "internal_flash.h"
+#include <string.h>
+
+#define PAGES 4
+
+static FlashKV_HandleTypeDef kv;
+
+static uint32_t kv_base(void)
+{
+    return InternalFlash_GetLastPageAddress() - (PAGES - 1) * FLASH_PAGE_SIZE;
+}
+
+static uint32_t get_u32(uint16_t key)
+{
+    uint32_t v = 0xDEADBEEF;
+    uint16_t len = 0;
+
+    if (FlashKV_Get(&kv, key, &v, sizeof(v), &len) != FLASH_KV_OK || len != sizeof(v)) return 0xDEADBEEF;
+    return v;
+}
+
+static FlashKV_Status set_u32(uint16_t key, uint32_t v)
+{
+    return FlashKV_Set(&kv, key, &v, sizeof(v));
+}
+
+static void test_internal_flash(void)
+{
+    static const uint8_t data[7] = {1, 2, 3, 4, 5, 6, 7};
+    uint32_t page = InternalFlash_GetLastPageAddress();
+    uint8_t back[8];
+
+    // Halfword programming with an odd start and an odd end
+    SIM_CHECK(InternalFlash_GetPageSize(page) == FLASH_PAGE_SIZE);
+    SIM_CHECK(InternalFlash_ErasePage(page));
+    SIM_CHECK(InternalFlash_WriteBytes(page + 1, data, sizeof(data)));
+    InternalFlash_ReadBytes(page, back, sizeof(back));
+    SIM_CHECK(back[0] == 0xFF && memcmp(&back[1], data, sizeof(data)) == 0);
+    SIM_CHECK(Sim_Flash_Stats()->halfwords == 4);
+
+    // Programming over data fails like PGERR on the chip
+    SIM_CHECK(!InternalFlash_WriteBytes(page + 2, data, 2));
+    SIM_CHECK(Sim_Flash_Stats()->prog_errors == 1);
+}
+
+static void test_roundtrip(void)
+{
+    char name[16] = {0};
+    uint16_t len;
+
+    SIM_CHECK(FlashKV_Init(&kv, kv_base(), PAGES) == FLASH_KV_OK);
+    SIM_CHECK(kv.page_size == FLASH_PAGE_SIZE && kv.seq == 1);
+    SIM_CHECK(FlashKV_Get(&kv, 0, name, sizeof(name), &len) == FLASH_KV_ERR_NOT_FOUND);
+
+    SIM_CHECK(set_u32(0, 1234) == FLASH_KV_OK);
+    SIM_CHECK(FlashKV_Set(&kv, 1, "sensor-7", 9) == FLASH_KV_OK);
+    SIM_CHECK(set_u32(2, 99) == FLASH_KV_OK);
+    SIM_CHECK(FlashKV_Delete(&kv, 2) == FLASH_KV_OK);
+    SIM_CHECK(FlashKV_Delete(&kv, 2) == FLASH_KV_ERR_NOT_FOUND);
+    SIM_CHECK(set_u32(FLASH_KV_MAX_KEYS, 1) == FLASH_KV_ERR_PARAM);
+
+    // Same value again: no program
+    SIM_CHECK(set_u32(0, 1234) == FLASH_KV_OK);
+    SIM_CHECK(kv.stats.unchanged == 1 && kv.stats.writes == 4);
+
+    // Reboot: the index is rebuilt from flash
+    SIM_CHECK(FlashKV_Init(&kv, kv_base(), PAGES) == FLASH_KV_OK);
+    SIM_CHECK(get_u32(0) == 1234);
+    SIM_CHECK(FlashKV_Get(&kv, 1, name, sizeof(name), &len) == FLASH_KV_OK);
+    SIM_CHECK(len == 9 && strcmp(name, "sensor-7") == 0);
+    SIM_CHECK(FlashKV_Get(&kv, 2, name, sizeof(name), &len) == FLASH_KV_ERR_NOT_FOUND);
+    SIM_CHECK(kv.stats.recovered == 0);
+}
+
+static void test_update_cost(void)
+{
+    // The old way: the settings struct rewritten into its own page per change
+    static uint8_t config[96];
+    Sim_FlashStats *fs = Sim_Flash_Stats();
+    uint32_t page = InternalFlash_GetLastPageAddress() - PAGES * FLASH_PAGE_SIZE;
+    uint64_t t0, page_us, kv_us, erases;
+    const int updates = 100;
+
+    t0 = Sim_Now();
+    erases = fs->page_erases;
+    for (int i = 0; i < updates; i++) {
+        memcpy(config, &i, sizeof(i));
+        SIM_CHECK(InternalFlash_ErasePage(page));
+        SIM_CHECK(InternalFlash_WriteBytes(page, config, sizeof(config)));
+    }
+    page_us = (uint64_t)Sim_CyclesToUs(Sim_Now() - t0);
+    printf("BENCH flash page rewrite        %6.2f ms/update  %llu erases\n",
+           page_us / 1000.0 / updates, (unsigned long long)(fs->page_erases - erases));
+
+    t0 = Sim_Now();
+    erases = fs->page_erases;
+    for (int i = 0; i < updates; i++) {
+        SIM_CHECK(set_u32(5, (uint32_t)i) == FLASH_KV_OK);
+    }
+    kv_us = (uint64_t)Sim_CyclesToUs(Sim_Now() - t0);
+    printf("BENCH flash kv set              %6.2f ms/update  %llu erases  %lu compactions\n",
+           kv_us / 1000.0 / updates, (unsigned long long)(fs->page_erases - erases),
+           (unsigned long)kv.stats.compactions);
+
+    SIM_CHECK(get_u32(5) == (uint32_t)updates - 1);
+    SIM_CHECK(kv_us * 10 < page_us);
+    SIM_CHECK((fs->page_erases - erases) * 10 < (uint64_t)updates);
+}
+
+static void test_wear(void)
+{
+    uint32_t compactions = kv.stats.compactions;
+    uint16_t visited = 0;
+
+    // Compactions walk round the pages: each is erased in turn
+    for (uint32_t i = 0; i < 2000; i++) {
+        SIM_CHECK(set_u32((uint16_t)(8 + i % 8), i) == FLASH_KV_OK);
+        visited |= (uint16_t)(1U << kv.active);
+    }
+    SIM_CHECK(visited == (1U << PAGES) - 1);
+    SIM_CHECK(kv.stats.compactions - compactions >= 2000 / ((FLASH_PAGE_SIZE - 8) / 12) - 1);
+
+    SIM_CHECK(FlashKV_Init(&kv, kv_base(), PAGES) == FLASH_KV_OK);
+    SIM_CHECK(get_u32(0) == 1234);
+    for (uint16_t k = 0; k < 8; k++) SIM_CHECK(get_u32(8 + k) == 1992U + k);
+
+    // Live values larger than a page are refused, existing ones are kept
+    {
+        uint8_t big[FLASH_KV_MAX_VALUE];
+        FlashKV_Status st = FLASH_KV_OK;
+        uint16_t key;
+
+        memset(big, 0xA5, sizeof(big));
+        for (key = 20; key < FLASH_KV_MAX_KEYS && st == FLASH_KV_OK; key++) {
+            st = FlashKV_Set(&kv, key, big, sizeof(big));
+        }
+        SIM_CHECK(st == FLASH_KV_ERR_NO_SPACE);
+        SIM_CHECK(get_u32(0) == 1234);
+        for (uint16_t k = 20; k < key; k++) FlashKV_Delete(&kv, k);
+        SIM_CHECK(FlashKV_Compact(&kv) == FLASH_KV_OK);
+        SIM_CHECK(set_u32(20, 7) == FLASH_KV_OK);
+    }
+}
+
+// A state close to a full page, so the updates below run into a compaction
+static void power_setup(void)
+{
+    Sim_Flash_Init();
+    SIM_CHECK(FlashKV_Init(&kv, kv_base(), PAGES) == FLASH_KV_OK);
+    SIM_CHECK(set_u32(1, 111) == FLASH_KV_OK);
+    SIM_CHECK(FlashKV_Set(&kv, 2, "keep me", 8) == FLASH_KV_OK);
+    while (FlashKV_Free(&kv) > 3 * 12) {
+        SIM_CHECK(set_u32(0, 1000 + kv.stats.writes) == FLASH_KV_OK);
+    }
+    SIM_CHECK(set_u32(0, 99) == FLASH_KV_OK);
+}
+
+static void test_power_fail(void)
+{
+    Sim_FlashStats *fs = Sim_Flash_Stats();
+    uint32_t cuts = 0, ops_total;
+    char text[8];
+    uint16_t len;
+
+    // How many flash operations the updates take without a cut
+    power_setup();
+    ops_total = (uint32_t)(fs->halfwords + fs->page_erases);
+    for (uint32_t v = 100; v < 106; v++) SIM_CHECK(set_u32(0, v) == FLASH_KV_OK);
+    ops_total = (uint32_t)(fs->halfwords + fs->page_erases) - ops_total;
+    SIM_CHECK(kv.stats.compactions == 1);
+
+    for (uint32_t cut = 0; cut <= ops_total; cut++) {
+        uint32_t v, last_ok = 99;
+
+        power_setup();
+        Sim_Flash_PowerFailAfter(cut);
+        for (v = 100; v < 106; v++) {
+            set_u32(0, v);
+            if (fs->dropped == 0) last_ok = v;
+        }
+        Sim_Flash_PowerRestore();
+
+        // Reboot: key 0 holds the last completed value or the one being
+        // written, nothing else is disturbed
+        SIM_CHECK(FlashKV_Init(&kv, kv_base(), PAGES) == FLASH_KV_OK);
+        v = get_u32(0);
+        SIM_CHECK(v == last_ok || v == last_ok + 1);
+        SIM_CHECK(get_u32(1) == 111);
+        SIM_CHECK(FlashKV_Get(&kv, 2, text, sizeof(text), &len) == FLASH_KV_OK && strcmp(text, "keep me") == 0);
+
+        // ... and keeps working
+        SIM_CHECK(set_u32(3, cut) == FLASH_KV_OK);
+        SIM_CHECK(FlashKV_Init(&kv, kv_base(), PAGES) == FLASH_KV_OK);
+        SIM_CHECK(get_u32(3) == cut && get_u32(1) == 111);
+        cuts++;
+    }
+    printf("BENCH flash kv power cuts       %lu cut points, all recovered\n", (unsigned long)cuts);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    Sim_Flash_Init();
+
+    test_internal_flash();
+    test_roundtrip();
+    test_update_cost();
+    test_wear();
+    test_power_fail();
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,171 @@
+/**
+ * @file hc_sr04_sim_tests.c
+ * @brief hc_sr04.c on simulated rangers: EXTI/DWT echo timing with results
+ *        by callback, blocking wrapper, no-echo timeout, and four sensors
+ *        on a staggered schedule vs reading them one after another
+ */
+
+#include "sim_test.h"
+#include "sim_hcsr04.h"
+#include "hc_sr04.h"
+#include <string.h>
+
+#define N_UNITS 4
+
+static TIM_HandleTypeDef     htim6;
+static TIM_TypeDef           tim6;
+static Sim_HCSR04            ranger[N_UNITS];
+static HCSR04_HandleTypeDef  sonar[N_UNITS];
+static HCSR04_Group_t        group;
+static bool                  group_active;
+static uint32_t              results[N_UNITS];
+static uint32_t              bad_results;
+
+static const float distances[N_UNITS] = {20.0f, 55.5f, 150.0f, 320.0f};
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim != &htim6) return;
+    if (group_active) {
+        HCSR04_Group_Poll(&group);
+    } else {
+        HCSR04_Poll(&sonar[0]);
+    }
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    HCSR04_Group_EXTI_Callback(&group, GPIO_Pin);
+}
+
+static bool near(float a, float b)
+{
+    float d = a - b;
+    return d > -0.1f && d < 0.1f;
+}
+
+static void on_distance(HCSR04_HandleTypeDef *dev, float cm)
+{
+    uint8_t i = (uint8_t)(dev - sonar);
+
+    if (cm > 0 && near(cm, ranger[i].distance_cm)) {
+        results[i]++;
+    } else {
+        bad_results++;
+    }
+}
+
+static void test_blocking(void)
+{
+    uint64_t t0 = Sim_Now();
+    double ms;
+
+    for (uint8_t i = 0; i < N_UNITS; i++) {
+        SIM_CHECK(near(HCSR04_Read(&sonar[i]), distances[i]));
+    }
+    ms = Sim_CyclesToUs(Sim_Now() - t0) / 1000.0;
+    printf("BENCH hc_sr04 %u units one by one   caller blocked %6.1f ms per round\n", N_UNITS, ms);
+}
+
+static void test_async(void)
+{
+    uint64_t t0, in_call;
+    uint32_t guard = 0;
+
+    memset(results, 0, sizeof(results));
+    t0 = Sim_Now();
+    SIM_CHECK(HCSR04_Start(&sonar[0]) == HCSR04_OK);
+    in_call = Sim_Now() - t0;
+    SIM_CHECK(HCSR04_Start(&sonar[0]) == HCSR04_BUSY);
+    while (results[0] == 0 && guard++ < 1000) Sim_AdvanceUs(100);
+    SIM_CHECK(results[0] == 1 && bad_results == 0);
+    SIM_CHECK(near(sonar[0].Distance, distances[0]));
+    SIM_CHECK(Sim_CyclesToUs(in_call) < 10.0);
+}
+
+static void test_no_echo(void)
+{
+    uint32_t timeouts = sonar[1].timeout_cnt;
+
+    ranger[1].distance_cm = 0;
+    SIM_CHECK(HCSR04_Read(&sonar[1]) == -1.0f);
+    SIM_CHECK(sonar[1].timeout_cnt == timeouts + 1);
+    bad_results = 0;
+
+    // The module ends its 38 ms pulse before it takes the next trigger
+    Sim_AdvanceUs(10000);
+    ranger[1].distance_cm = distances[1];
+    SIM_CHECK(near(HCSR04_Read(&sonar[1]), distances[1]));
+    bad_results = 0;
+}
+
+static void test_group(void)
+{
+    uint64_t t0;
+    uint32_t total = 0;
+
+    memset(results, 0, sizeof(results));
+    HCSR04_Group_Init(&group, sonar, N_UNITS, 30);
+    group_active = true;
+
+    // One second of application time in 1 ms steps
+    t0 = Sim_Now();
+    while (Sim_CyclesToUs(Sim_Now() - t0) < 1000000.0) Sim_AdvanceUs(1000);
+
+    for (uint8_t i = 0; i < N_UNITS; i++) {
+        total += results[i];
+        SIM_CHECK(results[i] >= 8);
+    }
+    SIM_CHECK(bad_results == 0 && group.skipped == 0);
+    printf("BENCH hc_sr04 %u units staggered    %3u results/s, caller blocked 0 ms\n",
+           N_UNITS, total);
+
+    // Slots shorter than a far echo: that unit is skipped, the rest carry on
+    memset(results, 0, sizeof(results));
+    HCSR04_Group_Init(&group, sonar, N_UNITS, 5);
+    t0 = Sim_Now();
+    while (Sim_CyclesToUs(Sim_Now() - t0) < 500000.0) Sim_AdvanceUs(1000);
+    SIM_CHECK(group.skipped > 0);
+    SIM_CHECK(results[0] > results[3] && results[3] > 0);
+    SIM_CHECK(bad_results == 0);
+    group_active = false;
+}
+
+int main(void)
+{
+    GPIO_InitTypeDef gpio = {0};
+
+    Sim_Reset();
+    for (uint8_t i = 0; i < N_UNITS; i++) {
+        uint16_t trig = (uint16_t)(GPIO_PIN_0 << i), echo = (uint16_t)(GPIO_PIN_4 << i);
+
+        // CubeMX: trigger output, echo EXTI on both edges
+        gpio.Pin = trig;
+        gpio.Mode = GPIO_MODE_OUTPUT_PP;
+        HAL_GPIO_Init(GPIOA, &gpio);
+        gpio.Pin = echo;
+        gpio.Mode = GPIO_MODE_IT_RISING_FALLING;
+        HAL_GPIO_Init(GPIOB, &gpio);
+
+        Sim_HCSR04_Init(&ranger[i], GPIOA, trig, GPIOB, echo);
+        ranger[i].distance_cm = distances[i];
+        HCSR04_Init(&sonar[i], GPIOA, trig, GPIOB, echo);
+        HCSR04_SetDoneCallback(&sonar[i], on_distance);
+    }
+    // EXTI fans out through the group even before it schedules anything
+    HCSR04_Group_Init(&group, sonar, N_UNITS, 30);
+
+    htim6.Instance = &tim6;
+    htim6.Init.Prescaler = 71;
+    htim6.Init.Period = 999;
+    HAL_TIM_Base_Start_IT(&htim6);
+
+    test_blocking();
+    test_async();
+    test_no_echo();
+    test_group();
+
+    SIM_CHECK(Sim_GetCpuStats()->irq_off_max_cycles == 0);
+
+    return SIM_TEST_RESULT();
+}
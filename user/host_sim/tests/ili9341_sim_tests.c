@@ -0,0 +1,134 @@
+/**
+ * @file ili9341_sim_tests.c
+ * @brief ili9341.c against the simulated DCS panel: fills, pixels, images, fps,
+ *        blocking vs DMA pixel streaming
+ */
+
+#include "sim_test.h"
+#include "sim_panel.h"
+#include "ili9341.h"
+#include <string.h>
+
+static SPI_HandleTypeDef     hspi1;
+static DMA_HandleTypeDef     hdma_spi1_tx;
+static Sim_Panel             panel;
+static ILI9341_HandleTypeDef hlcd;
+static uint16_t              frame[240 * 320];
+
+static void test_init(void)
+{
+    SIM_CHECK(ILI9341_Init(&hlcd, &hspi1, GPIOA, GPIO_PIN_4, GPIOA, GPIO_PIN_3,
+                           GPIOA, GPIO_PIN_2, NULL, 0) == 0);
+    SIM_CHECK(panel.colmod == 0x55);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 239, 319) == ILI9341_BLACK);
+}
+
+static void test_fill_screen(void)
+{
+    Sim_Bench bench;
+
+    Sim_Bench_Begin(&bench, "ili9341 fill screen", Sim_SPI_Stats(&hspi1));
+    ILI9341_FillScreen(&hlcd, ILI9341_BLUE);
+    Sim_Bench_End(&bench, 240U * 320U * 2U);
+
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 0, 0) == ILI9341_BLUE);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 239, 319) == ILI9341_BLUE);
+    SIM_CHECK(panel.stats.out_of_window == 0);
+}
+
+static void test_rect_and_pixel(void)
+{
+    ILI9341_FillRect(&hlcd, 10, 20, 30, 40, ILI9341_RED);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 10, 20) == ILI9341_RED);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 39, 59) == ILI9341_RED);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 40, 59) == ILI9341_BLUE);
+
+    ILI9341_DrawPixel(&hlcd, 100, 100, ILI9341_WHITE);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 100, 100) == ILI9341_WHITE);
+}
+
+static void test_image(void)
+{
+    static uint16_t img[64 * 64];
+    Sim_Bench bench;
+
+    for (uint32_t i = 0; i < 64U * 64U; i++) img[i] = (uint16_t)(i * 17);
+
+    Sim_Bench_Begin(&bench, "ili9341 draw image 64x64", Sim_SPI_Stats(&hspi1));
+    ILI9341_DrawImage(&hlcd, 50, 60, 64, 64, img);
+    Sim_Bench_End(&bench, sizeof(img));
+
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 50, 60) == img[0]);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 113, 123) == img[64 * 64 - 1]);
+}
+
+static void test_frame(const char *name, uint16_t seed)
+{
+    Sim_Bench bench;
+    uint64_t t0, t_return, t_done;
+
+    for (uint32_t i = 0; i < 240U * 320U; i++) frame[i] = (uint16_t)(i * seed);
+
+    Sim_Bench_Begin(&bench, name, Sim_SPI_Stats(&hspi1));
+    t0 = Sim_Now();
+    ILI9341_DrawImageAsync(&hlcd, 0, 0, 240, 320, frame);
+    t_return = Sim_Now();
+    while (ILI9341_IsBusy(&hlcd)) {
+        (void)HAL_GetTick(); // CPU is free here while DMA streams
+    }
+    t_done = Sim_Now();
+    Sim_Bench_End(&bench, sizeof(frame));
+    printf("BENCH %-28s CPU blocked %.1f us of %.1f us\n", name,
+           Sim_CyclesToUs(t_return - t0), Sim_CyclesToUs(t_done - t0));
+
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 0, 0) == frame[0]);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 120, 160) == frame[160 * 240 + 120]);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 239, 319) == frame[240 * 320 - 1]);
+    SIM_CHECK(panel.stats.out_of_window == 0);
+    SIM_CHECK(hlcd.Bus.Errors == 0);
+
+    if (hlcd.Bus.UseDMA) {
+        // The call only sets the window and starts the first chunk
+        SIM_CHECK((t_return - t0) * 20 < (t_done - t0));
+    }
+}
+
+static void test_dma(void)
+{
+    Sim_Bench bench;
+
+    hspi1.hdmatx = &hdma_spi1_tx;
+    SIM_CHECK(ILI9341_Init(&hlcd, &hspi1, GPIOA, GPIO_PIN_4, GPIOA, GPIO_PIN_3,
+                           GPIOA, GPIO_PIN_2, NULL, 0) == 0);
+    SIM_CHECK(hlcd.Bus.UseDMA == 1);
+
+    Sim_Bench_Begin(&bench, "ili9341 dma fill screen", Sim_SPI_Stats(&hspi1));
+    ILI9341_FillScreen(&hlcd, ILI9341_GREEN);
+    Sim_Bench_End(&bench, 240U * 320U * 2U);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 0, 0) == ILI9341_GREEN);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 239, 319) == ILI9341_GREEN);
+
+    // Small blocking calls still work between streams
+    ILI9341_FillRectAsync(&hlcd, 10, 20, 30, 40, ILI9341_RED);
+    ILI9341_DrawPixel(&hlcd, 100, 100, ILI9341_WHITE);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 39, 59) == ILI9341_RED);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 100, 100) == ILI9341_WHITE);
+
+    test_frame("ili9341 dma frame 240x320", 7);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    Sim_Panel_Init(&panel, &hspi1, GPIOA, GPIO_PIN_4, GPIOA, GPIO_PIN_3, 240, 320);
+
+    test_init();
+    test_fill_screen();
+    test_rect_and_pixel();
+    test_image();
+    test_frame("ili9341 frame 240x320", 3);
+    test_dma();
+
+    Sim_Panel_Free(&panel);
+    return SIM_TEST_RESULT();
+}
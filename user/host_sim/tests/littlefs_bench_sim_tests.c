@@ -0,0 +1,119 @@
+/**
+ * @file littlefs_bench_sim_tests.c
+ * @brief littlefs_bench.c on littlefs_rambd.c: workload timings for W25Q and
+ *        SD timing profiles across littlefs cache and lookahead sizes
+ *
+ * Only the emulated device time is charged (littlefs itself runs at host
+ * speed), so the figures compare settings, not CPU load.
+ */
+
+#include "sim_test.h"
+#include "littlefs_rambd.h"
+#include "littlefs_bench.h"
+#include <string.h>
+
+#define RAM_SIZE (1024 * 1024)
+
+typedef struct {
+    const char *label;
+    const LittleFS_RamBD_Profile *profile;
+    uint32_t cache_size;
+    uint32_t lookahead_size;
+} bench_case;
+
+static const bench_case cases[] = {
+    {"w25q cache 256 la 16",   &lfs_rambd_w25q, 256,  16},
+    {"w25q cache 256 la 128",  &lfs_rambd_w25q, 256,  128},
+    {"w25q cache 1024 la 16",  &lfs_rambd_w25q, 1024, 16},
+    {"w25q cache 1024 la 128", &lfs_rambd_w25q, 1024, 128},
+    {"sd cache 512 la 16",     &lfs_rambd_sd,   512,  16},
+    {"sd cache 512 la 128",    &lfs_rambd_sd,   512,  128},
+    {"sd cache 4096 la 16",    &lfs_rambd_sd,   4096, 16},
+    {"sd cache 4096 la 128",   &lfs_rambd_sd,   4096, 128},
+};
+
+static uint8_t               ram[RAM_SIZE];
+static uint32_t              wear[RAM_SIZE / 4096];
+static LittleFS_RamBD        bd;
+static struct lfs_config     bd_cfg;
+static lfs_t                 fs;
+static LittleFS_Bench_Result results[sizeof(cases) / sizeof(cases[0])];
+
+static void run_case(int i)
+{
+    const bench_case *c = &cases[i];
+    uint32_t max_wear = 0;
+
+    SIM_CHECK(LittleFS_RamBD_Init(&bd, &bd_cfg, ram, sizeof(ram), c->profile) == 0);
+    memset(wear, 0, sizeof(wear));
+    bd.wear = wear;
+    bd.wait_us = Sim_AdvanceUs;     // Same virtual time as Delay_us, without the polling
+    bd_cfg.cache_size = c->cache_size;
+    bd_cfg.lookahead_size = c->lookahead_size;
+    bd_cfg.block_cycles = 500;
+
+    SIM_CHECK(LittleFS_Bench_Run(&fs, &bd_cfg, NULL, &results[i]) == 0);
+    LittleFS_Bench_Print(c->label, &results[i]);
+
+    for (uint32_t b = 0; b < bd_cfg.block_count; b++) {
+        if (wear[b] > max_wear) max_wear = wear[b];
+    }
+    printf("      %-26s %lu reads %lu KB  %lu progs %lu KB  %lu erases (max %lu/block)  device %llu ms\n", "",
+           (unsigned long)bd.stats.reads, (unsigned long)(bd.stats.read_bytes / 1024),
+           (unsigned long)bd.stats.progs, (unsigned long)(bd.stats.prog_bytes / 1024),
+           (unsigned long)bd.stats.erases, (unsigned long)max_wear,
+           (unsigned long long)(bd.stats.busy_us / 1000));
+
+    SIM_CHECK(bd.stats.prog_violations == 0);
+}
+
+static void test_rambd(void)
+{
+    static const uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t back[8];
+    uint64_t t0;
+
+    // NOR semantics: programs only clear bits, erase restores 0xFF
+    SIM_CHECK(LittleFS_RamBD_Init(&bd, &bd_cfg, ram, sizeof(ram), &lfs_rambd_w25q) == 0);
+    SIM_CHECK(bd_cfg.block_count == RAM_SIZE / 4096 && bd_cfg.prog_size == 256);
+    t0 = Sim_Now();
+    SIM_CHECK(bd_cfg.prog(&bd_cfg, 3, 0, data, sizeof(data)) == 0);
+    SIM_CHECK(bd_cfg.read(&bd_cfg, 3, 0, back, sizeof(back)) == 0);
+    SIM_CHECK(memcmp(data, back, sizeof(data)) == 0);
+    SIM_CHECK(bd.stats.prog_violations == 0);
+    SIM_CHECK(bd_cfg.prog(&bd_cfg, 3, 0, data, sizeof(data)) == 0);
+    SIM_CHECK(bd.stats.prog_violations == sizeof(data));
+    SIM_CHECK(bd_cfg.erase(&bd_cfg, 3) == 0);
+    SIM_CHECK(bd_cfg.read(&bd_cfg, 3, 0, back, 1) == 0 && back[0] == 0xFF);
+
+    // Latency lands in virtual time: one page program + one sector erase at least
+    SIM_CHECK(Sim_CyclesToUs(Sim_Now() - t0) >= lfs_rambd_w25q.prog_us + lfs_rambd_w25q.erase_us);
+    SIM_CHECK(bd.stats.busy_us >= lfs_rambd_w25q.prog_us + lfs_rambd_w25q.erase_us);
+
+    // Too small for two blocks
+    SIM_CHECK(LittleFS_RamBD_Init(&bd, &bd_cfg, ram, 4096, &lfs_rambd_w25q) == LFS_ERR_INVAL);
+}
+
+static void test_bench(void)
+{
+    const LittleFS_Bench_Result *w25q_small = &results[0], *w25q_large = &results[2];
+    const LittleFS_Bench_Result *sd_small = &results[4], *sd_large = &results[6];
+
+    for (int i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++) run_case(i);
+
+    // Page programs at 400 us each bound the sequential write
+    SIM_CHECK(w25q_small->seq_write_us >= (64 * 1024 / 256) * lfs_rambd_w25q.prog_us);
+    // A bigger littlefs cache means fewer, longer reads
+    SIM_CHECK(w25q_large->seq_read_us < w25q_small->seq_read_us);
+    SIM_CHECK(w25q_large->mount_us < w25q_small->mount_us);
+    // On SD every read call pays the command latency: a block-sized cache wins big
+    SIM_CHECK(sd_large->dir_list_us * 4 < sd_small->dir_list_us);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    test_rambd();
+    test_bench();
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,290 @@
+/**
+ * @file littlefs_sim_tests.c
+ * @brief littlefs_port.c on w25qxx.c on the simulated W25Q64: file roundtrip,
+ *        flash transactions per operation with and without the port cache,
+ *        named partitions with 4 KB and 64 KB blocks, SFUD geometry
+ */
+
+#include "sim_test.h"
+#include "sim_w25q.h"
+#include "littlefs_port.h"
+#include "littlefs_sfud.h"
+#include "sfud_port.h"
+#include <string.h>
+
+W25QXX_HandleTypeDef w25qxx_handle;
+SPI_HandleTypeDef    hspi1;         // Referenced by sfud_port.c
+
+static DMA_HandleTypeDef hdma_spi1_rx;
+static DMA_HandleTypeDef hdma_spi1_tx;
+static Sim_W25Q          flash;
+
+static void test_mount(void)
+{
+    Sim_Bench bench;
+
+    hspi1.hdmarx = &hdma_spi1_rx;
+    hspi1.hdmatx = &hdma_spi1_tx;
+    SIM_CHECK(W25QXX_Init(&w25qxx_handle, &hspi1, GPIOA, GPIO_PIN_4) == 1);
+
+    Sim_Bench_Begin(&bench, "lfs format+mount", Sim_SPI_Stats(&hspi1));
+    SIM_CHECK(LittleFS_Port_Init() == 0);
+    Sim_Bench_End(&bench, 0);
+}
+
+static void test_file_roundtrip(void)
+{
+    enum { LEN = 8192 };
+    static uint8_t src[LEN], dst[LEN];
+    lfs_file_t file;
+    Sim_Bench bench;
+
+    for (uint32_t i = 0; i < LEN; i++) src[i] = (uint8_t)(i * 3 + 11);
+
+    Sim_Bench_Begin(&bench, "lfs write 8K file", Sim_SPI_Stats(&hspi1));
+    SIM_CHECK(lfs_file_open(&lfs, &file, "data.bin", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) == 0);
+    SIM_CHECK(lfs_file_write(&lfs, &file, src, LEN) == LEN);
+    SIM_CHECK(lfs_file_close(&lfs, &file) == 0);
+    Sim_Bench_End(&bench, LEN);
+
+    Sim_Bench_Begin(&bench, "lfs read 8K file", Sim_SPI_Stats(&hspi1));
+    SIM_CHECK(lfs_file_open(&lfs, &file, "data.bin", LFS_O_RDONLY) == 0);
+    SIM_CHECK(lfs_file_read(&lfs, &file, dst, LEN) == LEN);
+    SIM_CHECK(lfs_file_close(&lfs, &file) == 0);
+    Sim_Bench_End(&bench, LEN);
+
+    SIM_CHECK(memcmp(src, dst, LEN) == 0);
+}
+
+static void test_remount(void)
+{
+    struct lfs_info info;
+
+    LittleFS_Port_DeInit();
+    SIM_CHECK(LittleFS_Port_Init() == 0);
+    SIM_CHECK(lfs_stat(&lfs, "data.bin", &info) == 0);
+    SIM_CHECK(info.size == 8192);
+    SIM_CHECK(flash.stats.busy_violations == 0);
+}
+
+static void test_small_files(void)
+{
+    char name[24], text[64];
+    lfs_file_t file;
+
+    SIM_CHECK(lfs_mkdir(&lfs, "cfg") == 0);
+    for (int i = 0; i < 16; i++) {
+        int len = snprintf(text, sizeof(text), "setting %d = %d", i, i * 37);
+
+        snprintf(name, sizeof(name), "cfg/item%02d.txt", i);
+        SIM_CHECK(lfs_file_open(&lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) == 0);
+        SIM_CHECK(lfs_file_write(&lfs, &file, text, len) == len);
+        SIM_CHECK(lfs_file_close(&lfs, &file) == 0);
+    }
+    // close() syncs: nothing may be left in the write-back buffer
+    SIM_CHECK(lfs_port_stats.syncs > 0 && lfs_port_stats.flushes > 0);
+}
+
+typedef struct {
+    uint64_t mount, scan, read;             // Flash read transactions
+    double   mount_us, scan_us, read_us;
+} lfs_op_cost;
+
+// Flash read transactions for mount, a directory listing and 16 small file reads
+static void measure_ops(uint8_t cache, lfs_op_cost *cost)
+{
+    struct lfs_info info;
+    lfs_dir_t dir;
+    lfs_file_t file;
+    char name[24], text[64], expect[64];
+    uint64_t reads, t0;
+    int entries = 0;
+
+    LittleFS_Port_DeInit();
+    LittleFS_Port_SetCache(cache);
+    memset(&lfs_port_stats, 0, sizeof(lfs_port_stats));
+
+    reads = flash.stats.reads;
+    t0 = Sim_Now();
+    SIM_CHECK(LittleFS_Port_Init() == 0);
+    cost->mount_us = Sim_CyclesToUs(Sim_Now() - t0);
+    cost->mount = flash.stats.reads - reads;
+
+    reads = flash.stats.reads;
+    t0 = Sim_Now();
+    SIM_CHECK(lfs_dir_open(&lfs, &dir, "cfg") == 0);
+    while (lfs_dir_read(&lfs, &dir, &info) > 0) entries++;
+    SIM_CHECK(lfs_dir_close(&lfs, &dir) == 0);
+    cost->scan_us = Sim_CyclesToUs(Sim_Now() - t0);
+    cost->scan = flash.stats.reads - reads;
+    SIM_CHECK(entries == 16 + 2);   // "." and ".."
+
+    reads = flash.stats.reads;
+    t0 = Sim_Now();
+    for (int i = 0; i < 16; i++) {
+        int len = snprintf(expect, sizeof(expect), "setting %d = %d", i, i * 37);
+
+        snprintf(name, sizeof(name), "cfg/item%02d.txt", i);
+        SIM_CHECK(lfs_file_open(&lfs, &file, name, LFS_O_RDONLY) == 0);
+        SIM_CHECK(lfs_file_read(&lfs, &file, text, sizeof(text)) == len);
+        SIM_CHECK(memcmp(text, expect, len) == 0);
+        SIM_CHECK(lfs_file_close(&lfs, &file) == 0);
+    }
+    cost->read_us = Sim_CyclesToUs(Sim_Now() - t0);
+    cost->read = flash.stats.reads - reads;
+
+    printf("BENCH lfs cache %-3s  mount %3llu tx %6.0f us  dir scan %3llu tx %6.0f us  small file %5.1f tx %5.0f us  hit %5.1f%%\n",
+           cache ? "on" : "off", (unsigned long long)cost->mount, cost->mount_us,
+           (unsigned long long)cost->scan, cost->scan_us, (double)cost->read / 16.0, cost->read_us / 16.0,
+           lfs_port_stats.hits + lfs_port_stats.misses
+               ? 100.0 * lfs_port_stats.hits / (double)(lfs_port_stats.hits + lfs_port_stats.misses) : 0.0);
+}
+
+static void test_cache(void)
+{
+    lfs_op_cost off, on;
+
+    measure_ops(0, &off);
+    measure_ops(1, &on);
+
+    SIM_CHECK(on.mount * 3 < off.mount);
+    SIM_CHECK(on.mount_us < off.mount_us);
+    SIM_CHECK(on.read_us * 2 < off.read_us);
+    SIM_CHECK(on.scan * 3 < off.scan);
+    SIM_CHECK(on.read * 2 < off.read);
+    SIM_CHECK(flash.stats.busy_violations == 0);
+}
+
+/* ============================================================================
+ * Partitions
+ * ========================================================================= */
+
+static LittleFS_Partition log_part, asset_part, extra_part;
+
+static const LittleFS_Partition_Config log_conf = {
+    .name = "log", .offset = 0, .size = 1024 * 1024, .block_cycles = 100,
+};
+static const LittleFS_Partition_Config asset_conf = {
+    .name = "assets", .offset = 1024 * 1024, .size = 0, .large_blocks = 1, .cache_size = 1024,
+};
+
+static void test_geometry(void)
+{
+    LittleFS_Port_Geometry geo, sf_geo;
+    W25QXX_Info_t info = w25qxx_handle.Info;
+
+    SIM_CHECK(LittleFS_Port_GeometryFromW25Q(&w25qxx_handle, &geo) == 0);
+    SIM_CHECK(geo.capacity == 8UL * 1024UL * 1024UL);
+    SIM_CHECK(geo.prog_size == 256 && geo.sector_size == 4096 && geo.block_size == 65536);
+
+    // Unknown chip: no more guessing a W25Q64
+    memset(&w25qxx_handle.Info, 0, sizeof(w25qxx_handle.Info));
+    SIM_CHECK(LittleFS_Port_GeometryFromW25Q(&w25qxx_handle, &sf_geo) == LFS_ERR_INVAL);
+    SIM_CHECK(LittleFS_Port_Init() == LFS_ERR_INVAL);
+    w25qxx_handle.Info = info;
+
+    // SFUD probing the same chip agrees
+    SIM_CHECK(SFUD_Port_Init() == SFUD_SUCCESS);
+    SIM_CHECK(LittleFS_Port_GeometryFromSFUD(SFUD_Port_GetDefaultFlash(), &sf_geo) == 0);
+    SIM_CHECK(memcmp(&geo, &sf_geo, sizeof(geo)) == 0);
+}
+
+static void write_file(lfs_t *fs, const char *name, const uint8_t *data, lfs_size_t len)
+{
+    lfs_file_t file;
+
+    SIM_CHECK(lfs_file_open(fs, &file, name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) == 0);
+    SIM_CHECK(lfs_file_write(fs, &file, data, len) == (lfs_ssize_t)len);
+    SIM_CHECK(lfs_file_close(fs, &file) == 0);
+}
+
+static void test_partitions(void)
+{
+    enum { ASSET_LEN = 150 * 1024 };
+    static uint8_t asset[ASSET_LEN], back[ASSET_LEN];
+    LittleFS_Partition_Config bad;
+    LittleFS_Port_Geometry geo;
+    struct lfs_info info;
+    lfs_file_t file;
+    uint32_t erases_4k, erases_64k, part_erases;
+    Sim_Bench bench;
+
+    LittleFS_Port_DeInit();
+    SIM_CHECK(LittleFS_Port_GeometryFromW25Q(&w25qxx_handle, &geo) == 0);
+
+    SIM_CHECK(LittleFS_Partition_Mount(&log_part, &w25qxx_handle, &geo, &log_conf) == 0);
+    SIM_CHECK(log_part.cfg.block_size == 4096 && log_part.cfg.block_count == 256);
+    SIM_CHECK(log_part.cfg.block_cycles == 100);
+
+    erases_64k = flash.stats.erases_64k;
+    SIM_CHECK(LittleFS_Partition_Mount(&asset_part, &w25qxx_handle, &geo, &asset_conf) == 0);
+    SIM_CHECK(asset_part.cfg.block_size == 65536 && asset_part.cfg.block_count == 112);
+    SIM_CHECK(asset_part.cfg.cache_size == 1024 && asset_part.cfg.metadata_max == 4096);
+    SIM_CHECK(flash.stats.erases_64k > erases_64k);
+
+    // Misaligned, past the end, overlapping, mounted twice
+    bad = asset_conf;
+    bad.offset = 4096;
+    SIM_CHECK(LittleFS_Partition_Mount(&extra_part, &w25qxx_handle, &geo, &bad) == LFS_ERR_INVAL);
+    bad = log_conf;
+    bad.offset = 8UL * 1024UL * 1024UL - 4096;
+    SIM_CHECK(LittleFS_Partition_Mount(&extra_part, &w25qxx_handle, &geo, &bad) == LFS_ERR_INVAL);
+    bad.offset = 512 * 1024;
+    SIM_CHECK(LittleFS_Partition_Mount(&extra_part, &w25qxx_handle, &geo, &bad) == LFS_ERR_INVAL);
+    SIM_CHECK(LittleFS_Partition_Mount(&log_part, &w25qxx_handle, &geo, &log_conf) == LFS_ERR_INVAL);
+
+    SIM_CHECK(LittleFS_Partition_Find("log") == &log_part);
+    SIM_CHECK(LittleFS_Partition_Find("assets") == &asset_part);
+    SIM_CHECK(LittleFS_Partition_Find("boot") == NULL);
+
+    // Same name in both: separate filesystems
+    for (uint32_t i = 0; i < ASSET_LEN; i++) asset[i] = (uint8_t)(i * 7 + (i >> 9));
+    write_file(&log_part.lfs, "today.log", (const uint8_t *)"boot ok\n", 8);
+
+    erases_4k = flash.stats.erases_4k;
+    erases_64k = flash.stats.erases_64k;
+    part_erases = asset_part.stats.erases;
+    Sim_Bench_Begin(&bench, "lfs 150K asset, 64K blocks", Sim_SPI_Stats(&hspi1));
+    write_file(&asset_part.lfs, "today.log", asset, ASSET_LEN);
+    Sim_Bench_End(&bench, ASSET_LEN);
+    SIM_CHECK(flash.stats.erases_4k == erases_4k);
+    SIM_CHECK(flash.stats.erases_64k - erases_64k >= ASSET_LEN / 65536);
+    SIM_CHECK(asset_part.stats.erases - part_erases == flash.stats.erases_64k - erases_64k);
+    SIM_CHECK(log_part.stats.erases > 0);
+    printf("BENCH lfs partitions       log %lu erases (4K)  assets %lu erases (64K)\n",
+           (unsigned long)log_part.stats.erases, (unsigned long)asset_part.stats.erases);
+
+    // Both survive a remount
+    LittleFS_Partition_Unmount(&asset_part);
+    LittleFS_Partition_Unmount(&log_part);
+    SIM_CHECK(LittleFS_Partition_Find("log") == NULL);
+    SIM_CHECK(LittleFS_Partition_Mount(&asset_part, &w25qxx_handle, &geo, &asset_conf) == 0);
+    SIM_CHECK(LittleFS_Partition_Mount(&log_part, &w25qxx_handle, &geo, &log_conf) == 0);
+
+    SIM_CHECK(lfs_stat(&log_part.lfs, "today.log", &info) == 0 && info.size == 8);
+    SIM_CHECK(lfs_file_open(&asset_part.lfs, &file, "today.log", LFS_O_RDONLY) == 0);
+    SIM_CHECK(lfs_file_read(&asset_part.lfs, &file, back, ASSET_LEN) == ASSET_LEN);
+    SIM_CHECK(lfs_file_close(&asset_part.lfs, &file) == 0);
+    SIM_CHECK(memcmp(asset, back, ASSET_LEN) == 0);
+    SIM_CHECK(flash.stats.busy_violations == 0);
+
+    LittleFS_Partition_Unmount(&asset_part);
+    LittleFS_Partition_Unmount(&log_part);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    Sim_W25Q_Init(&flash, &hspi1, GPIOA, GPIO_PIN_4, 0xEF4017);
+
+    test_mount();
+    test_file_roundtrip();
+    test_remount();
+    test_small_files();
+    test_cache();
+    test_geometry();
+    test_partitions();
+
+    Sim_W25Q_Free(&flash);
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,168 @@
+/**
+ * @file lvgl_sim_tests.c
+ * @brief lvgl_port.c on a simulated ST7789: blocking single buffer vs DMA
+ *        double buffer, frames/sec and render-vs-flush overlap
+ */
+
+#include "sim_test.h"
+#include "sim_panel.h"
+#include "lvgl_port.h"
+#include "display/lv_display_private.h"
+#include <string.h>
+
+#define W LVGL_HOR_RES
+#define H LVGL_VER_RES
+
+// Software render cost charged per rendered pixel. Host rendering takes no
+// virtual time, so this stands in for LVGL's draw time on a Cortex-M3/M4.
+#define RENDER_CYCLES_PER_PX 24
+
+SPI_HandleTypeDef               hspi1;
+static DMA_HandleTypeDef        hdma_spi1_tx;
+static Sim_Panel                panel;
+static uint16_t                 reference[W * H];
+LV_ATTRIBUTE_MEM_ALIGN static uint16_t single_buf[LVGL_DISP_BUF_SIZE];
+
+static uint64_t render_cycles;
+static uint32_t flushes;
+
+static void charge_render(const lv_area_t *area)
+{
+    uint64_t cycles = (uint64_t)lv_area_get_size(area) * RENDER_CYCLES_PER_PX;
+
+    render_cycles += cycles;
+    Sim_Advance(cycles);
+}
+
+// Charge the band's render time when it is done, before LVGL waits for the bus:
+// with two buffers the previous band is still streaming meanwhile
+static void render_cost_cb(lv_event_t *e)
+{
+    lv_display_t *disp = lv_event_get_target(e);
+    lv_event_code_t code = lv_event_get_code(e);
+
+    if (lv_display_is_double_buffered(disp)) {
+        if (code == LV_EVENT_FLUSH_WAIT_START) charge_render(&disp->refreshed_area);
+    } else {
+        if (code == LV_EVENT_FLUSH_START) charge_render(&disp->refreshed_area);
+    }
+    if (code == LV_EVENT_FLUSH_START) flushes++;
+}
+
+static void create_ui(void)
+{
+    lv_obj_t *scr = lv_screen_active();
+    lv_obj_t *box, *label, *bar;
+
+    lv_obj_set_style_bg_color(scr, lv_color_hex(0x102030), 0);
+
+    // Plain red block with a known RGB565 value to check byte order
+    box = lv_obj_create(scr);
+    lv_obj_remove_style_all(box);
+    lv_obj_set_style_bg_opa(box, LV_OPA_COVER, 0);
+    lv_obj_set_style_bg_color(box, lv_color_hex(0xFF0000), 0);
+    lv_obj_set_pos(box, 10, 10);
+    lv_obj_set_size(box, 40, 30);
+
+    label = lv_label_create(scr);
+    lv_label_set_text(label, "Hello LVGL!");
+    lv_obj_align(label, LV_ALIGN_CENTER, 0, -20);
+
+    bar = lv_bar_create(scr);
+    lv_obj_set_size(bar, 180, 16);
+    lv_obj_align(bar, LV_ALIGN_CENTER, 0, 30);
+    lv_bar_set_value(bar, 70, LV_ANIM_OFF);
+
+    lv_obj_t *btn = lv_button_create(scr);
+    lv_obj_set_size(btn, 100, 40);
+    lv_obj_align(btn, LV_ALIGN_BOTTOM_MID, 0, -20);
+}
+
+static void run_frames(const char *name, int frames)
+{
+    Sim_BusStats *bus = Sim_SPI_Stats(&hspi1);
+    uint64_t bus_start = bus->bus_cycles;
+    uint64_t t0, elapsed, busy, hidden;
+    Sim_Bench bench;
+
+    render_cycles = 0;
+    flushes = 0;
+
+    Sim_Bench_Begin(&bench, name, bus);
+    t0 = Sim_Now();
+    for (int f = 0; f < frames; f++) {
+        lv_obj_invalidate(lv_screen_active());
+        lv_refr_now(NULL);
+    }
+    elapsed = Sim_Now() - t0;
+    Sim_Bench_End(&bench, (uint64_t)frames * W * H * 2U);
+
+    // Render time that ran while the bus was streaming the previous band
+    busy = bus->bus_cycles - bus_start;
+    hidden = (render_cycles + busy > elapsed) ? render_cycles + busy - elapsed : 0;
+    printf("BENCH %-28s %5.1f fps  %2u flushes/frame  render %5.1f ms  bus %5.1f ms  overlap %5.1f%%\n",
+           name, (double)frames * SystemCoreClock / (double)elapsed, (unsigned)(flushes / frames),
+           Sim_CyclesToUs(render_cycles) / 1000.0 / frames, Sim_CyclesToUs(busy) / 1000.0 / frames,
+           render_cycles ? 100.0 * (double)hidden / (double)render_cycles : 0.0);
+
+    SIM_CHECK(flushes == (uint32_t)frames * (H / (LVGL_DISP_BUF_SIZE / W)));
+    SIM_CHECK(panel.stats.out_of_window == 0);
+}
+
+static void start(bool dma, bool double_buf)
+{
+    hspi1.hdmatx = dma ? &hdma_spi1_tx : NULL;
+    LVGL_Port_Init();
+    if (!double_buf) {
+        lv_display_set_buffers(lv_display_get_default(), single_buf, NULL, sizeof(single_buf),
+                               LV_DISPLAY_RENDER_MODE_PARTIAL);
+    }
+    lv_display_add_event_cb(lv_display_get_default(), render_cost_cb, LV_EVENT_ALL, NULL);
+    create_ui();
+}
+
+static void test_blocking_single(void)
+{
+    start(false, false);
+    run_frames("lvgl blocking single buf", 5);
+
+    // Byte order: red block, then keep the frame as the reference
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 10, 10) == 0xF800);
+    SIM_CHECK(Sim_Panel_GetPixel(&panel, 49, 39) == 0xF800);
+    for (uint16_t y = 0; y < H; y++) {
+        for (uint16_t x = 0; x < W; x++) reference[y * W + x] = Sim_Panel_GetPixel(&panel, x, y);
+    }
+    lv_deinit();
+}
+
+static void test_dma_double(void)
+{
+    uint32_t mismatches = 0;
+
+    // Wipe the glass so the comparison proves this run drew everything
+    memset(panel.fb, 0, (size_t)W * H * sizeof(uint16_t));
+
+    start(true, true);
+    SIM_CHECK(lv_display_is_double_buffered(lv_display_get_default()));
+    run_frames("lvgl dma double buf", 5);
+
+    for (uint16_t y = 0; y < H; y++) {
+        for (uint16_t x = 0; x < W; x++) {
+            if (Sim_Panel_GetPixel(&panel, x, y) != reference[y * W + x]) mismatches++;
+        }
+    }
+    SIM_CHECK(mismatches == 0);
+    lv_deinit();
+}
+
+int main(void)
+{
+    Sim_Reset();
+    Sim_Panel_Init(&panel, &hspi1, GPIOA, GPIO_PIN_4, GPIOA, GPIO_PIN_3, W, H);
+
+    test_blocking_single();
+    test_dma_double();
+
+    Sim_Panel_Free(&panel);
+    return SIM_TEST_RESULT();
+}
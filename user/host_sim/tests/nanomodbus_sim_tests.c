@@ -0,0 +1,668 @@
+/**
+ * @file nanomodbus_sim_tests.c
+ * @brief nanoMODBUS RTU server on uart.c: frames assembled from the RX event
+ *        interrupt, CRC at the idle line / T3.5 gap, address filter, RS485 DE
+ *        dropped from TX complete, closed-loop master throughput vs the
+ *        blocking HAL transport, register map with two units, sparse ranges,
+ *        getters and unaligned bit copies
+ */
+
+#include "sim_test.h"
+#include "nanomodbus.h"
+#include <string.h>
+
+#define CH              0
+#define UNIT_ID         1
+#define DE_PORT         GPIOA
+#define DE_PIN          GPIO_PIN_1
+#define T35_US          1750U
+#define WORK_US         200U        // Other main loop work per iteration
+
+typedef struct {
+    UART_HandleTypeDef *huart;
+    uint8_t             resp[300];
+    uint32_t            resp_len;
+    uint64_t            resp_end;   // Last response byte off the wire
+    uint64_t            req_end;    // Last request byte on the wire
+    // Closed loop
+    bool                running;
+    uint32_t            sent;
+    uint32_t            answered;
+    uint32_t            bad;
+    uint64_t            turnaround_cycles;
+} Master;
+
+static UART_HandleTypeDef  huart2, huart3;
+static DMA_HandleTypeDef   hdma_rx, hdma_tx;
+static uint8_t             rx_dma[64];
+static uint8_t             rx_ring[512];
+static uint8_t             tx_ring[512];
+static RS485_HandleTypeDef hrs485;
+static nmbs_rtu_t          rtu;
+static nmbs_t              server, legacy;
+static nmbs_server_data_t  data;
+static Master              m2, m3;
+
+// Register map: unit 1 with all four tables, unit 2 with holding registers only
+#define UNIT_2          2
+static uint16_t block[125], block_tail[4], ro_regs[2], inputs[4], unit2_regs[10], fn_regs[3];
+static uint8_t  coil_bits[5], coil_bits2[3];
+static uint32_t fn_reads, fn_writes, notify_calls;
+static uint16_t notify_offset, notify_quantity;
+
+static nmbs_error fn_read(uint16_t offset, uint16_t quantity, void *out, void *arg)
+{
+    (void)arg;
+    fn_reads++;
+    memcpy(out, &fn_regs[offset], quantity * sizeof(uint16_t));
+    return NMBS_ERROR_NONE;
+}
+
+static nmbs_error fn_write(uint16_t offset, uint16_t quantity, const void *in, void *arg)
+{
+    const uint16_t *v = (const uint16_t *)in;
+
+    (void)arg;
+    fn_writes++;
+    for (uint16_t i = 0; i < quantity; i++) {
+        if (v[i] > 1000) return NMBS_EXCEPTION_ILLEGAL_DATA_VALUE;
+    }
+    memcpy(&fn_regs[offset], v, quantity * sizeof(uint16_t));
+    return NMBS_ERROR_NONE;
+}
+
+static nmbs_error coils_written(uint16_t offset, uint16_t quantity, const void *in, void *arg)
+{
+    (void)in;
+    (void)arg;
+    notify_calls++;
+    notify_offset = offset;
+    notify_quantity = quantity;
+    return NMBS_ERROR_NONE;
+}
+
+// Discrete input n (range from 100) reads as (n % 3 == 0), from bit 0 of out
+static nmbs_error di_read(uint16_t offset, uint16_t quantity, void *out, void *arg)
+{
+    (void)arg;
+    for (uint16_t i = 0; i < quantity; i++) nmbs_bitfield_write((uint8_t *)out, i, (100 + offset + i) % 3 == 0);
+    return NMBS_ERROR_NONE;
+}
+
+static const nmbs_map_range u1_holding[] = {
+    NMBS_MAP_VAR(0, 125, block),
+    NMBS_MAP_VAR(125, 4, block_tail),           // Touches the block: one address range
+    NMBS_MAP_VAR_RO(1000, 2, ro_regs),
+    NMBS_MAP_FN(2000, 3, fn_read, fn_write, NULL),
+};
+static const nmbs_map_range u1_input[]    = { NMBS_MAP_VAR(0, 4, inputs) };
+static const nmbs_map_range u1_coils[]    = {
+    NMBS_MAP_VAR(0, 40, coil_bits),
+    NMBS_MAP_VAR_NOTIFY(40, 20, coil_bits2, coils_written, NULL),
+};
+static const nmbs_map_range u1_discrete[] = { NMBS_MAP_FN(100, 16, di_read, NULL, NULL) };
+static const nmbs_map_range u2_holding[]  = { NMBS_MAP_VAR(0, 10, unit2_regs) };
+
+static const nmbs_map_unit map_units[] = {
+    {
+        .unit_id = UNIT_ID,
+        NMBS_MAP_TABLE(NMBS_MAP_HOLDING_REGISTERS, u1_holding),
+        NMBS_MAP_TABLE(NMBS_MAP_INPUT_REGISTERS, u1_input),
+        NMBS_MAP_TABLE(NMBS_MAP_COILS, u1_coils),
+        NMBS_MAP_TABLE(NMBS_MAP_DISCRETE_INPUTS, u1_discrete),
+    },
+    {
+        .unit_id = UNIT_2,
+        NMBS_MAP_TABLE(NMBS_MAP_HOLDING_REGISTERS, u2_holding),
+    },
+};
+static nmbs_map_t map;
+
+static bool     de_high;
+static uint32_t de_rises;
+static uint32_t de_late;            // DE released more than 1 us after the last stop bit
+static uint32_t de_low_during_tx;
+
+static uint16_t crc16(const uint8_t *p, uint32_t n)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint32_t i = 0; i < n; i++) {
+        crc ^= p[i];
+        for (int b = 0; b < 8; b++) crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+    }
+    return crc;
+}
+
+static uint32_t adu(uint8_t *out, uint8_t unit, const uint8_t *pdu, uint32_t len)
+{
+    uint16_t crc;
+
+    out[0] = unit;
+    memcpy(&out[1], pdu, len);
+    crc = crc16(out, len + 1);
+    out[len + 1] = (uint8_t)crc;
+    out[len + 2] = (uint8_t)(crc >> 8);
+    return len + 3;
+}
+
+static bool resp_ok(const Master *m)
+{
+    return m->resp_len >= 4 && crc16(m->resp, m->resp_len) == 0;
+}
+
+static void master_send(Master *m, const uint8_t *frame, uint32_t len)
+{
+    m->resp_len = 0;
+    Sim_UART_Inject(m->huart, frame, len);
+    m->req_end = Sim_Now() + Sim_UART_CharCycles(m->huart) * len;
+}
+
+static void de_watch(void *ctx, GPIO_PinState state)
+{
+    (void)ctx;
+    de_high = (state == GPIO_PIN_SET);
+    if (de_high) {
+        de_rises++;
+    } else if (Sim_Now() - m2.resp_end > Sim_UsToCycles(1)) {
+        de_late++;
+    }
+}
+
+static void read_regs_request(uint8_t *frame, uint32_t *len)
+{
+    static const uint8_t pdu[] = {0x03, 0x00, 0x00, 0x00, 0x0A};   // 10 holding registers at 0
+    *len = adu(frame, UNIT_ID, pdu, sizeof(pdu));
+}
+
+static void master_next(void *ctx)
+{
+    Master *m = (Master *)ctx;
+    uint8_t frame[16];
+    uint32_t len;
+
+    if (!m->running) return;
+    read_regs_request(frame, &len);
+    master_send(m, frame, len);
+    m->sent++;
+}
+
+static void master_sink(void *ctx, const uint8_t *d, uint16_t len)
+{
+    Master *m = (Master *)ctx;
+
+    if (m == &m2 && !de_high) de_low_during_tx++;
+    if (m->resp_len + len <= sizeof(m->resp)) memcpy(&m->resp[m->resp_len], d, len);
+    m->resp_len += len;
+    m->resp_end = Sim_Now();
+
+    // Closed loop: a complete 10-register response, then the next request after T3.5
+    if (m->running && m->resp_len >= 25) {
+        m->turnaround_cycles += (m->resp_end - Sim_UART_CharCycles(m->huart) * m->resp_len) - m->req_end;
+        if (resp_ok(m) && m->resp[1] == 0x03 && m->resp[2] == 20) m->answered++;
+        else m->bad++;
+        Sim_Schedule(Sim_UsToCycles(T35_US), master_next, m, false);
+    }
+}
+
+static void port_init(UART_HandleTypeDef *huart, uint32_t baud, bool dma)
+{
+    memset(huart, 0, sizeof(*huart));
+    huart->Init.BaudRate = baud;
+    if (dma) {
+        memset(&hdma_rx, 0, sizeof(hdma_rx));
+        memset(&hdma_tx, 0, sizeof(hdma_tx));
+        hdma_rx.Init.Mode = DMA_CIRCULAR;
+        huart->hdmarx = &hdma_rx;
+        huart->hdmatx = &hdma_tx;
+    }
+    HAL_UART_Init(huart);
+}
+
+static void setup_port(uint32_t baud)
+{
+    Sim_Reset();
+
+    port_init(&huart2, baud, true);
+    UART_Register(CH, &huart2, rx_dma, sizeof(rx_dma), rx_ring, sizeof(rx_ring), tx_ring, sizeof(tx_ring));
+    RS485_InitAsync(&hrs485, CH, DE_PORT, DE_PIN);
+    SIM_CHECK(nmbs_rtu_init(&rtu, CH, baud, &hrs485) == NMBS_ERROR_NONE);
+    SIM_CHECK(rtu.event_mode);
+
+    memset(&m2, 0, sizeof(m2));
+    m2.huart = &huart2;
+    Sim_UART_SetTxSink(&huart2, master_sink, &m2);
+    de_high = false;
+    de_rises = de_late = de_low_during_tx = 0;
+    Sim_GPIO_Watch(DE_PORT, DE_PIN, de_watch, NULL);
+}
+
+static void setup(uint32_t baud)
+{
+    setup_port(baud);
+    SIM_CHECK(nmbs_server_init_rtu_uart(&server, &data, UNIT_ID, &rtu) == NMBS_ERROR_NONE);
+}
+
+// Main loop: serve requests and do other work, until the master has a response or ms ran out
+static uint32_t serve(uint32_t ms, bool until_response)
+{
+    uint64_t end = Sim_Now() + Sim_UsToCycles(ms * 1000U);
+    uint32_t handled = 0;
+
+    while (Sim_Now() < end) {
+        if (nmbs_rtu_server_poll(&server) != NMBS_ERROR_TIMEOUT) handled++;
+        if (until_response && m2.resp_len > 0 && !RS485_IsTxBusy(&hrs485)) break;
+        Sim_AdvanceUs(WORK_US);
+    }
+    return handled;
+}
+
+static uint32_t transact(uint8_t unit, const uint8_t *pdu, uint32_t len)
+{
+    static uint8_t frame[300];
+
+    master_send(&m2, frame, adu(frame, unit, pdu, len));
+    serve(50, true);
+    return m2.resp_len;
+}
+
+static void test_requests(void)
+{
+    static uint8_t pdu[260];
+    uint32_t n;
+
+    setup(115200);
+    data.regs[0] = 0x1234;
+    data.regs[1] = 0x5678;
+    data.regs[2] = 0xABCD;
+    nmbs_bitfield_write(data.coils, 0, 1);
+    nmbs_bitfield_write(data.coils, 2, 1);
+
+    // FC03: read 3 holding registers
+    static const uint8_t rd[] = {0x03, 0x00, 0x00, 0x00, 0x03};
+    SIM_CHECK(transact(UNIT_ID, rd, sizeof(rd)) == 11);
+    SIM_CHECK(resp_ok(&m2) && m2.resp[0] == UNIT_ID && m2.resp[1] == 0x03 && m2.resp[2] == 6);
+    SIM_CHECK(m2.resp[3] == 0x12 && m2.resp[4] == 0x34 && m2.resp[7] == 0xAB && m2.resp[8] == 0xCD);
+
+    // FC06: write single register, echoed
+    static const uint8_t wr[] = {0x06, 0x00, 0x05, 0xBE, 0xEF};
+    SIM_CHECK(transact(UNIT_ID, wr, sizeof(wr)) == 8);
+    SIM_CHECK(resp_ok(&m2) && memcmp(&m2.resp[1], wr, sizeof(wr)) == 0);
+    SIM_CHECK(data.regs[5] == 0xBEEF);
+
+    // FC16: 100 registers, a 209-byte frame that spans many DMA half/full events
+    pdu[0] = 0x10;
+    pdu[1] = 0x00; pdu[2] = 10;
+    pdu[3] = 0x00; pdu[4] = 100;
+    pdu[5] = 200;
+    for (int i = 0; i < 100; i++) {
+        pdu[6 + 2 * i] = (uint8_t)(0xA0 + i);
+        pdu[7 + 2 * i] = (uint8_t)i;
+    }
+    n = transact(UNIT_ID, pdu, 206);
+    SIM_CHECK(n == 8 && resp_ok(&m2) && m2.resp[1] == 0x10 && m2.resp[5] == 100);
+    SIM_CHECK(data.regs[10] == 0xA000 && data.regs[109] == (uint16_t)((0xA0 + 99) << 8 | 99));
+
+    // FC01: read 8 coils
+    static const uint8_t rc[] = {0x01, 0x00, 0x00, 0x00, 0x08};
+    SIM_CHECK(transact(UNIT_ID, rc, sizeof(rc)) == 6);
+    SIM_CHECK(resp_ok(&m2) && m2.resp[2] == 1 && m2.resp[3] == 0x05);
+
+    // Out of range: exception response
+    static const uint8_t bad[] = {0x03, 0x01, 0x00, 0x00, 0x10};
+    SIM_CHECK(transact(UNIT_ID, bad, sizeof(bad)) == 5);
+    SIM_CHECK(resp_ok(&m2) && m2.resp[1] == 0x83 && m2.resp[2] == NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+
+    SIM_CHECK(rtu.frames == 5 && rtu.frame_errors == 0 && rtu.overruns == 0);
+
+    // DE up for each response, down within 1 us of the last stop bit
+    SIM_CHECK(de_rises == 5);
+    SIM_CHECK(de_late == 0 && de_low_during_tx == 0 && !de_high);
+}
+
+static void test_framing(void)
+{
+    static const uint8_t rd[] = {0x03, 0x00, 0x00, 0x00, 0x01};
+    static const uint8_t wr[] = {0x06, 0x00, 0x07, 0x00, 0x42};
+    uint8_t frame[16];
+    uint32_t len, errors, foreign;
+
+    setup(115200);
+    len = adu(frame, UNIT_ID, rd, sizeof(rd));
+
+    // A pause of 3 characters inside a frame (idle line, but under T3.5): still one frame
+    master_send(&m2, frame, 3);
+    Sim_AdvanceUs(3 * 87 + 3 * 87);
+    master_send(&m2, &frame[3], len - 3);
+    serve(20, true);
+    SIM_CHECK(m2.resp_len == 7 && resp_ok(&m2));
+    SIM_CHECK(rtu.frames == 1 && rtu.frame_errors == 0);
+
+    // A 5 ms pause splits it: two broken frames, no answer
+    master_send(&m2, frame, 3);
+    serve(5, false);
+    master_send(&m2, &frame[3], len - 3);
+    serve(20, false);
+    SIM_CHECK(m2.resp_len == 0);
+    SIM_CHECK(rtu.frames == 1 && rtu.frame_errors == 2);
+
+    // Bad CRC
+    frame[len - 1] ^= 0x55;
+    master_send(&m2, frame, len);
+    serve(20, false);
+    SIM_CHECK(m2.resp_len == 0 && rtu.frame_errors == 3);
+    frame[len - 1] ^= 0x55;
+
+    // Another unit's request, then ours after T3.5: only ours is handed to nanoMODBUS
+    errors = rtu.frame_errors;
+    foreign = rtu.foreign;
+    {
+        uint8_t other[16];
+        master_send(&m2, other, adu(other, 7, rd, sizeof(rd)));
+        Sim_AdvanceUs(8 * 87 + T35_US);
+    }
+    master_send(&m2, frame, len);
+    serve(20, true);
+    SIM_CHECK(m2.resp_len == 7 && resp_ok(&m2) && m2.resp[0] == UNIT_ID);
+    SIM_CHECK(rtu.foreign == foreign + 1 && rtu.frame_errors == errors);
+
+    // Broadcast write: applied, not answered
+    master_send(&m2, frame, adu(frame, NMBS_BROADCAST_ADDRESS, wr, sizeof(wr)));
+    serve(20, false);
+    SIM_CHECK(m2.resp_len == 0 && data.regs[7] == 0x42);
+    SIM_CHECK(rtu.overruns == 0);
+}
+
+static bool coil(const uint8_t *bits, uint32_t n)
+{
+    return (bits[n / 8] >> (n % 8)) & 1;
+}
+
+static bool exception(uint8_t fc, uint8_t code)
+{
+    return m2.resp_len == 5 && resp_ok(&m2) && m2.resp[1] == (fc | 0x80) && m2.resp[2] == code;
+}
+
+static void test_map(void)
+{
+    static uint8_t pdu[64];
+    uint32_t foreign;
+
+    setup_port(115200);
+    SIM_CHECK(nmbs_map_init(&map, map_units, 2) == NMBS_ERROR_NONE);
+    SIM_CHECK(nmbs_server_init_rtu_map(&server, &map, &rtu) == NMBS_ERROR_NONE);
+    for (int i = 0; i < 125; i++) block[i] = (uint16_t)(0x1000 + i);
+    for (int i = 0; i < 4; i++) block_tail[i] = (uint16_t)(0x2000 + i);
+    ro_regs[0] = 0x0BAD;
+    inputs[3] = 0x4444;
+    unit2_regs[9] = 0x0202;
+    fn_regs[2] = 77;
+
+    // FC03: 125 registers straight from the bound array
+    static const uint8_t rd125[] = {0x03, 0x00, 0x00, 0x00, 125};
+    SIM_CHECK(transact(UNIT_ID, rd125, sizeof(rd125)) == 255);
+    SIM_CHECK(resp_ok(&m2) && m2.resp[2] == 250);
+    SIM_CHECK(m2.resp[3] == 0x10 && m2.resp[4] == 0x00 && m2.resp[251] == 0x10 && m2.resp[252] == 124);
+
+    // Across two touching ranges, then past their end into the gap
+    static const uint8_t rd_span[] = {0x03, 0x00, 123, 0x00, 5};
+    SIM_CHECK(transact(UNIT_ID, rd_span, sizeof(rd_span)) == 15);
+    SIM_CHECK(m2.resp[5] == 0x10 && m2.resp[6] == 124 && m2.resp[7] == 0x20 && m2.resp[12] == 0x02);
+    static const uint8_t rd_gap[] = {0x03, 0x00, 127, 0x00, 3};
+    transact(UNIT_ID, rd_gap, sizeof(rd_gap));
+    SIM_CHECK(exception(0x03, NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS));
+
+    // Read-only range: readable, writes refused
+    static const uint8_t rd_ro[] = {0x03, 0x03, 0xE8, 0x00, 2};
+    SIM_CHECK(transact(UNIT_ID, rd_ro, sizeof(rd_ro)) == 9 && m2.resp[3] == 0x0B && m2.resp[4] == 0xAD);
+    static const uint8_t wr_ro[] = {0x06, 0x03, 0xE8, 0x00, 0x01};
+    transact(UNIT_ID, wr_ro, sizeof(wr_ro));
+    SIM_CHECK(exception(0x06, NMBS_EXCEPTION_ILLEGAL_DATA_ADDRESS) && ro_regs[0] == 0x0BAD);
+
+    // Getter/setter range, offsets relative to its start; the setter's exception goes back
+    static const uint8_t rd_fn[] = {0x03, 0x07, 0xD0, 0x00, 3};
+    SIM_CHECK(transact(UNIT_ID, rd_fn, sizeof(rd_fn)) == 11 && m2.resp[8] == 77 && fn_reads == 1);
+    static const uint8_t wr_fn[] = {0x10, 0x07, 0xD1, 0x00, 2, 4, 0x00, 0x05, 0x00, 0x06};
+    SIM_CHECK(transact(UNIT_ID, wr_fn, sizeof(wr_fn)) == 8 && fn_regs[1] == 5 && fn_regs[2] == 6);
+    static const uint8_t wr_fn_bad[] = {0x06, 0x07, 0xD0, 0x27, 0x10};
+    transact(UNIT_ID, wr_fn_bad, sizeof(wr_fn_bad));
+    SIM_CHECK(exception(0x06, NMBS_EXCEPTION_ILLEGAL_DATA_VALUE) && fn_regs[0] == 0);
+
+    // FC15: 13 coils from 35, unaligned and across both coil ranges
+    memset(pdu, 0, sizeof(pdu));
+    pdu[0] = 0x0F; pdu[2] = 35; pdu[4] = 13; pdu[5] = 2;
+    pdu[6] = 0xB5;      // Coils 35..42 = 1,0,1,0,1,1,0,1
+    pdu[7] = 0x1F;      // Coils 43..47 = 1,1,1,1,1
+    coil_bits[0] = 0xFF;
+    SIM_CHECK(transact(UNIT_ID, pdu, 8) == 8 && resp_ok(&m2));
+    SIM_CHECK(coil(coil_bits, 35) && !coil(coil_bits, 36) && coil(coil_bits, 39) && !coil(coil_bits, 34));
+    SIM_CHECK(coil(coil_bits2, 0) && !coil(coil_bits2, 1) && coil(coil_bits2, 7) && !coil(coil_bits2, 8));
+    SIM_CHECK(coil_bits[0] == 0xFF);
+    SIM_CHECK(notify_calls == 1 && notify_offset == 0 && notify_quantity == 8);
+
+    // FC01: 20 coils from 30 read back bit for bit
+    static const uint8_t rd_coils[] = {0x01, 0x00, 30, 0x00, 20};
+    SIM_CHECK(transact(UNIT_ID, rd_coils, sizeof(rd_coils)) == 8 && m2.resp[2] == 3);
+    for (uint32_t i = 0; i < 20; i++) {
+        uint32_t a = 30 + i;
+        bool want = a < 40 ? coil(coil_bits, a) : coil(coil_bits2, a - 40);
+        SIM_CHECK(coil(&m2.resp[3], i) == want);
+    }
+
+    // FC05 on the notifying range
+    static const uint8_t wr_coil[] = {0x05, 0x00, 50, 0xFF, 0x00};
+    SIM_CHECK(transact(UNIT_ID, wr_coil, sizeof(wr_coil)) == 8 && coil(coil_bits2, 10));
+    SIM_CHECK(notify_calls == 2 && notify_offset == 10 && notify_quantity == 1);
+
+    // FC02 from a getter, at an offset inside its range
+    static const uint8_t rd_di[] = {0x02, 0x00, 103, 0x00, 10};
+    SIM_CHECK(transact(UNIT_ID, rd_di, sizeof(rd_di)) == 7);
+    for (uint32_t i = 0; i < 10; i++) SIM_CHECK(coil(&m2.resp[3], i) == ((103 + i) % 3 == 0));
+
+    // FC04
+    static const uint8_t rd_in[] = {0x04, 0x00, 0x00, 0x00, 4};
+    SIM_CHECK(transact(UNIT_ID, rd_in, sizeof(rd_in)) == 13 && m2.resp[9] == 0x44 && m2.resp[10] == 0x44);
+
+    // Second unit: answered as itself; no coil table there
+    static const uint8_t rd_u2[] = {0x03, 0x00, 0x09, 0x00, 1};
+    SIM_CHECK(transact(UNIT_2, rd_u2, sizeof(rd_u2)) == 7 && m2.resp[0] == UNIT_2 && m2.resp[4] == 0x02);
+    transact(UNIT_2, rd_coils, sizeof(rd_coils));
+    SIM_CHECK(m2.resp[0] == UNIT_2 && exception(0x01, NMBS_EXCEPTION_ILLEGAL_FUNCTION));
+    SIM_CHECK(transact(UNIT_ID, rd_u2, sizeof(rd_u2)) == 7 && m2.resp[0] == UNIT_ID);
+
+    // Other units are not answered; broadcasts reach both
+    foreign = rtu.foreign;
+    SIM_CHECK(transact(3, rd_u2, sizeof(rd_u2)) == 0 && rtu.foreign == foreign + 1);
+    static const uint8_t wr_all[] = {0x06, 0x00, 0x00, 0x5A, 0x5A};
+    SIM_CHECK(transact(NMBS_BROADCAST_ADDRESS, wr_all, sizeof(wr_all)) == 0);
+    SIM_CHECK(block[0] == 0x5A5A && unit2_regs[0] == 0x5A5A);
+    SIM_CHECK(rtu.frame_errors == 0 && rtu.overruns == 0);
+
+    // Bad tables are refused
+    static const nmbs_map_range overlap[] = { NMBS_MAP_VAR(0, 10, block), NMBS_MAP_VAR(9, 2, block_tail) };
+    static const nmbs_map_range unsorted[] = { NMBS_MAP_VAR(10, 2, block), NMBS_MAP_VAR(0, 2, block_tail) };
+    static const nmbs_map_range no_storage[] = { NMBS_MAP_FN(0, 2, NULL, fn_write, NULL) };
+    static const nmbs_map_unit bad_units[][1] = {
+        {{ .unit_id = 5, NMBS_MAP_TABLE(NMBS_MAP_HOLDING_REGISTERS, overlap) }},
+        {{ .unit_id = 5, NMBS_MAP_TABLE(NMBS_MAP_INPUT_REGISTERS, unsorted) }},
+        {{ .unit_id = 5, NMBS_MAP_TABLE(NMBS_MAP_COILS, no_storage) }},
+        {{ .unit_id = 0 }},
+    };
+    nmbs_map_t bad;
+    for (unsigned i = 0; i < sizeof(bad_units) / sizeof(bad_units[0]); i++) {
+        SIM_CHECK(nmbs_map_init(&bad, bad_units[i], 1) == NMBS_ERROR_INVALID_ARGUMENT);
+    }
+    static const nmbs_map_unit twice[] = { { .unit_id = 4 }, { .unit_id = 4 } };
+    SIM_CHECK(nmbs_map_init(&bad, twice, 2) == NMBS_ERROR_INVALID_ARGUMENT);
+}
+
+// Per-item access as the old callbacks did it
+static uint16_t reg_one(uint16_t address)
+{
+    return block[address];
+}
+
+static nmbs_error per_register_read(uint16_t offset, uint16_t quantity, void *out, void *arg)
+{
+    (void)arg;
+    for (uint16_t i = 0; i < quantity; i++) ((uint16_t *)out)[i] = reg_one((uint16_t)(offset + i));
+    return NMBS_ERROR_NONE;
+}
+
+static void per_bit_read(const uint8_t *bits, uint16_t address, uint16_t quantity, nmbs_bitfield out)
+{
+    for (uint16_t i = 0; i < quantity; i++) nmbs_bitfield_write(out, i, nmbs_bitfield_read(bits, address + i));
+}
+
+static double host_ns(void (*fn)(uint32_t), uint32_t iterations)
+{
+    double best = 1e30;
+
+    for (int run = 0; run < 5; run++) {
+        uint64_t t0 = Sim_HostNs();
+        fn(iterations);
+        double ns = (double)(Sim_HostNs() - t0) / iterations;
+        if (ns < best) best = ns;
+    }
+    return best;
+}
+
+static uint8_t          bench_bits[2000 / 8 + 1];
+static nmbs_bitfield    bench_out;
+static uint16_t         bench_regs[125];
+static volatile uint8_t bench_sink;
+
+static const nmbs_map_range bench_regs_fn[] = { NMBS_MAP_FN(0, 125, per_register_read, NULL, NULL) };
+static const nmbs_map_range bench_coils[]   = { NMBS_MAP_VAR(0, 2008, bench_bits) };
+static const nmbs_map_unit  bench_units[]   = {
+    { .unit_id = 1, NMBS_MAP_TABLE(NMBS_MAP_HOLDING_REGISTERS, u1_holding), NMBS_MAP_TABLE(NMBS_MAP_COILS, bench_coils) },
+    { .unit_id = 2, NMBS_MAP_TABLE(NMBS_MAP_HOLDING_REGISTERS, bench_regs_fn) },
+};
+
+static void bench_regs_map(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        server.callbacks.read_holding_registers(0, 125, bench_regs, 1, server.callbacks.arg);
+        bench_sink ^= (uint8_t)bench_regs[i % 125];
+    }
+}
+
+static void bench_regs_fn_(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        server.callbacks.read_holding_registers(0, 125, bench_regs, 2, server.callbacks.arg);
+        bench_sink ^= (uint8_t)bench_regs[i % 125];
+    }
+}
+
+static void bench_coils_map(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        server.callbacks.read_coils(3, 2000, bench_out, 1, server.callbacks.arg);
+        bench_sink ^= bench_out[i % 250];
+    }
+}
+
+static void bench_coils_per_bit(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        per_bit_read(bench_bits, 3, 2000, bench_out);
+        bench_sink ^= bench_out[i % 250];
+    }
+}
+
+static void test_map_cost(void)
+{
+    nmbs_map_t bench_map;
+    double regs_map, regs_fn, coils_map, coils_bit;
+
+    setup_port(115200);
+    SIM_CHECK(nmbs_map_init(&bench_map, bench_units, 2) == NMBS_ERROR_NONE);
+    SIM_CHECK(nmbs_server_init_rtu_map(&server, &bench_map, &rtu) == NMBS_ERROR_NONE);
+    for (unsigned i = 0; i < sizeof(bench_bits); i++) bench_bits[i] = (uint8_t)(i * 37U + 11U);
+
+    // Same result both ways
+    nmbs_bitfield ref;
+    per_bit_read(bench_bits, 3, 2000, ref);
+    server.callbacks.read_coils(3, 2000, bench_out, 1, server.callbacks.arg);
+    SIM_CHECK(memcmp(ref, bench_out, 250) == 0);
+
+    regs_map  = host_ns(bench_regs_map, 20000);
+    regs_fn   = host_ns(bench_regs_fn_, 20000);
+    coils_map = host_ns(bench_coils_map, 20000);
+    coils_bit = host_ns(bench_coils_per_bit, 2000);
+
+    printf("BENCH nanomodbus map 125 registers  bound array %7.1f ns   per-register getter %7.1f ns (host)\n",
+           regs_map, regs_fn);
+    printf("BENCH nanomodbus map 2000 coils @3   byte shifts %7.1f ns   per-bit copy        %7.1f ns (host)\n",
+           coils_map, coils_bit);
+    SIM_CHECK(coils_map * 2.0 < coils_bit);
+}
+
+static void closed_loop(Master *m, bool legacy_port, uint32_t ms, double *req_s, double *blocked_pct, double *turn_us)
+{
+    uint64_t t0 = Sim_Now(), end = t0 + Sim_UsToCycles(ms * 1000U), in_poll = 0;
+
+    m->running = true;
+    master_next(m);
+    while (Sim_Now() < end) {
+        uint64_t c0 = Sim_Now();
+
+        if (legacy_port) {
+            nmbs_server_poll(&legacy);      // Blocks up to the read timeout
+        } else {
+            nmbs_rtu_server_poll(&server);
+        }
+        in_poll += Sim_Now() - c0;
+        Sim_AdvanceUs(WORK_US);
+    }
+    m->running = false;
+    Sim_AdvanceUs(20000);
+
+    *req_s = (double)m->answered / ((double)ms / 1000.0);
+    *blocked_pct = 100.0 * (double)in_poll / (double)(Sim_Now() - t0);
+    *turn_us = m->answered ? Sim_CyclesToUs(m->turnaround_cycles) / m->answered : 0.0;
+}
+
+static void test_throughput(void)
+{
+    static const uint32_t bauds[] = {115200, 921600};
+    double req_s, blocked, turn;
+
+    // Old port: blocking HAL_UART_Receive/Transmit on a plain UART
+    Sim_Reset();
+    port_init(&huart3, 115200, false);
+    memset(&m3, 0, sizeof(m3));
+    m3.huart = &huart3;
+    Sim_UART_SetTxSink(&huart3, master_sink, &m3);
+    SIM_CHECK(nmbs_server_init_rtu(&legacy, &data, UNIT_ID, &huart3) == NMBS_ERROR_NONE);
+    closed_loop(&m3, true, 1000, &req_s, &blocked, &turn);
+    printf("BENCH nanomodbus %6lu blocking HAL transport  %5.0f req/s  loop blocked %5.1f%%  turnaround %6.0f us\n",
+           115200UL, req_s, blocked, turn);
+    SIM_CHECK(blocked > 90.0);
+
+    for (unsigned i = 0; i < sizeof(bauds) / sizeof(bauds[0]); i++) {
+        setup(bauds[i]);
+        closed_loop(&m2, false, 1000, &req_s, &blocked, &turn);
+        printf("BENCH nanomodbus %6lu uart.c RTU transport    %5.0f req/s  loop blocked %5.1f%%  turnaround %6.0f us\n",
+               (unsigned long)bauds[i], req_s, blocked, turn);
+
+        // Every request answered, nothing dropped, the loop stays free
+        SIM_CHECK(m2.bad == 0 && m2.answered + 1 >= m2.sent);
+        SIM_CHECK(rtu.frame_errors == 0 && rtu.overruns == 0);
+        SIM_CHECK(req_s > (bauds[i] == 115200 ? 180.0 : 350.0));
+        SIM_CHECK(blocked < 5.0);
+        SIM_CHECK(turn < 2.0 * WORK_US);
+        SIM_CHECK(de_late == 0 && de_low_during_tx == 0);
+    }
+}
+
+int main(void)
+{
+    test_requests();
+    test_framing();
+    test_map();
+    test_map_cost();
+    test_throughput();
+
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,625 @@
+/**
+ * @file ports_sim_tests.c
+ * @brief Component ports on the simulated HAL: TinyFrame over uart.c (span
+ *        parser, slice-by-4 CRC, zero-copy listeners, 2 Mbaud stream),
+ *        instances on USB CDC / loopback / custom transports sharing the TX
+ *        pool, SFUD probe
+ */
+
+#include "sim_test.h"
+#include "sim_w25q.h"
+#include "sim_usb.h"
+#include "tinyframe_port.h"
+#include "usb_cdc.h"
+#include "sfud_port.h"
+#include <string.h>
+
+SPI_HandleTypeDef hspi1;   // Referenced by sfud_port.c
+
+static UART_HandleTypeDef huart2;
+static DMA_HandleTypeDef  hdma_rx;
+static DMA_HandleTypeDef  hdma_spi1_rx, hdma_spi1_tx;
+static uint8_t rx_dma[64], rx_ring[512], tx_ring[512];
+
+static uint32_t tf_frames;
+static uint8_t  tf_last[32];
+
+/* ============================================================================
+ * TinyFrame
+ * ========================================================================= */
+
+static void loopback_sink(void *ctx, const uint8_t *data, uint16_t len)
+{
+    Sim_UART_Inject((UART_HandleTypeDef *)ctx, data, len);
+}
+
+static TF_Result on_frame(TinyFrame *tf, TF_Msg *msg)
+{
+    (void)tf;
+    tf_frames++;
+    memcpy(tf_last, msg->data, msg->len < sizeof(tf_last) ? msg->len : sizeof(tf_last));
+    return TF_STAY;
+}
+
+static void test_tinyframe_loopback(void)
+{
+    const uint8_t payload[] = "ping-over-sim";
+    TinyFrame *tf;
+    Sim_Bench bench;
+
+    hdma_rx.Init.Mode = DMA_CIRCULAR;
+    huart2.Init.BaudRate = 115200;
+    huart2.hdmarx = &hdma_rx;
+    HAL_UART_Init(&huart2);
+    UART_Register(TINYFRAME_UART_CHANNEL, &huart2, rx_dma, sizeof(rx_dma),
+                  rx_ring, sizeof(rx_ring), tx_ring, sizeof(tx_ring));
+    Sim_UART_SetTxSink(&huart2, loopback_sink, &huart2);
+
+    tf = TinyFrame_Init();
+    SIM_CHECK(tf != NULL);
+    SIM_CHECK(TF_AddTypeListener(tf, 0x22, on_frame));
+
+    Sim_Bench_Begin(&bench, "tinyframe loopback 10 frames", Sim_UART_Stats(&huart2));
+    for (int i = 0; i < 10; i++) {
+        SIM_CHECK(TF_SendSimple(tf, 0x22, payload, sizeof(payload)));
+        for (int t = 0; t < 40; t++) {
+            Sim_AdvanceUs(100);
+            TinyFrame_Process(tf);
+        }
+    }
+    Sim_Bench_End(&bench, 10 * sizeof(payload));
+
+    SIM_CHECK(tf_frames == 10);
+    SIM_CHECK(memcmp(tf_last, payload, sizeof(payload)) == 0);
+}
+
+#define STREAM_TYPE     0x33
+#define STREAM_FRAMES   400
+
+static uint8_t  frames_buf[80 * 1024];
+static uint32_t frames_len;
+static uint32_t zc_frames, zc_in_place, zc_bad, copy_frames;
+static const uint8_t *span_lo, *span_hi;
+
+static uint16_t tf_crc16(const uint8_t *p, uint32_t n)
+{
+    uint16_t crc = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        crc ^= p[i];
+        for (int b = 0; b < 8; b++) crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+    }
+    return crc;
+}
+
+// Payload i of a frame: (seq + i * 7), the first byte tells the frame's length
+static void make_payload(uint8_t *p, uint16_t len, uint8_t seq)
+{
+    for (uint16_t i = 0; i < len; i++) p[i] = (uint8_t)(seq + i * 7U);
+}
+
+static bool payload_ok(const TF_Msg *msg)
+{
+    uint8_t seq = msg->data[0];
+    for (uint16_t i = 0; i < msg->len; i++) {
+        if (msg->data[i] != (uint8_t)(seq + i * 7U)) return false;
+    }
+    return true;
+}
+
+// Frame as TinyFrame composes it, with an independent bitwise CRC
+static uint32_t compose(uint8_t *out, uint8_t id, uint8_t type, uint16_t len, uint8_t seq)
+{
+    uint32_t n = 0;
+    uint16_t crc;
+
+    out[n++] = TF_SOF_BYTE;
+    out[n++] = id;
+    out[n++] = (uint8_t)(len >> 8);
+    out[n++] = (uint8_t)len;
+    out[n++] = type;
+    crc = tf_crc16(out, n);
+    out[n++] = (uint8_t)(crc >> 8);
+    out[n++] = (uint8_t)crc;
+    make_payload(&out[n], len, seq);
+    crc = tf_crc16(&out[n], len);
+    n += len;
+    out[n++] = (uint8_t)(crc >> 8);
+    out[n++] = (uint8_t)crc;
+    return n;
+}
+
+static TF_Result on_zc(TinyFrame *tf, TF_Msg *msg)
+{
+    (void)tf;
+    zc_frames++;
+    if (msg->data >= span_lo && msg->data < span_hi) zc_in_place++;
+    if (!payload_ok(msg)) zc_bad++;
+    return TF_STAY;
+}
+
+static TF_Result on_copy(TinyFrame *tf, TF_Msg *msg)
+{
+    (void)tf;
+    copy_frames++;
+    if (!payload_ok(msg)) zc_bad++;
+    return TF_STAY;
+}
+
+// Frames of 1..300 bytes (over TF_MAX_PAYLOAD_RX at the end), with noise in between
+static uint32_t build_stream(uint32_t count, uint32_t *expected)
+{
+    uint32_t n = 0;
+
+    *expected = 0;
+    for (uint32_t f = 0; f < count; f++) {
+        uint16_t len = (uint16_t)(1 + (f * 37U) % 300U);
+        if (n + len + 16 > sizeof(frames_buf)) break;
+        n += compose(&frames_buf[n], (uint8_t)f, STREAM_TYPE, len, (uint8_t)f);
+        if (len <= TF_MAX_PAYLOAD_RX) (*expected)++;
+        if (f % 5 == 0) {
+            memset(&frames_buf[n], 0x55, 3);
+            n += 3;
+        }
+    }
+    return n;
+}
+
+static void test_tinyframe_span(void)
+{
+    static const uint32_t chunks[] = {1, 3, 7, 64, 1000, sizeof(frames_buf)};
+    static TinyFrame ref;
+    uint32_t expected;
+    TinyFrame *tf;
+
+    frames_len = build_stream(STREAM_FRAMES, &expected);
+
+    // Byte parser: the reference result
+    TF_InitStatic(&ref, TF_SLAVE);
+    SIM_CHECK(TF_AddTypeListener(&ref, STREAM_TYPE, on_copy));
+    copy_frames = zc_bad = 0;
+    TF_Accept(&ref, frames_buf, frames_len);
+    SIM_CHECK(copy_frames == expected && zc_bad == 0);
+
+    // Span parser with a copying listener, any split of the input
+    for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        tf = TinyFrame_Init();
+        SIM_CHECK(TF_AddTypeListener(tf, STREAM_TYPE, on_copy));
+        copy_frames = 0;
+        for (uint32_t off = 0; off < frames_len; off += chunks[c]) {
+            uint32_t n = frames_len - off < chunks[c] ? frames_len - off : chunks[c];
+            TF_AcceptSpan(tf, &frames_buf[off], n, false);
+        }
+        SIM_CHECK(copy_frames == expected);
+    }
+
+    // Zero-copy: whole frames in place, split ones from TinyFrame's buffer
+    for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        tf = TinyFrame_Init();
+        SIM_CHECK(TinyFrame_AddZeroCopyListener(tf, STREAM_TYPE, on_zc));
+        SIM_CHECK(!TinyFrame_AddZeroCopyListener(tf, STREAM_TYPE, on_zc));
+        zc_frames = zc_in_place = 0;
+        for (uint32_t off = 0; off < frames_len; off += chunks[c]) {
+            uint32_t n = frames_len - off < chunks[c] ? frames_len - off : chunks[c];
+            span_lo = &frames_buf[off];
+            span_hi = span_lo + n;
+            TF_AcceptSpan(tf, span_lo, n, false);
+        }
+        SIM_CHECK(zc_frames == expected);
+        if (chunks[c] == sizeof(frames_buf)) SIM_CHECK(zc_in_place == expected);
+        if (chunks[c] == 1) SIM_CHECK(zc_in_place == 0);
+    }
+    SIM_CHECK(zc_bad == 0);
+
+    // A corrupted body is dropped by both paths, the next frame still arrives
+    {
+        uint8_t two[64];
+        uint32_t n = compose(two, 1, STREAM_TYPE, 20, 9);
+        n += compose(&two[n], 2, STREAM_TYPE, 20, 10);
+        two[12] ^= 0xFF;
+        zc_frames = 0;
+        span_lo = two;
+        span_hi = two + n;
+        TF_AcceptSpan(tf, two, n, false);
+        SIM_CHECK(zc_frames == 1);
+    }
+}
+
+static double parse_ns_per_byte(TinyFrame *tf, bool span)
+{
+    double best = 1e30;
+
+    for (int run = 0; run < 5; run++) {
+        uint64_t t0 = Sim_HostNs();
+        if (span) TF_AcceptSpan(tf, frames_buf, frames_len, false);
+        else TF_Accept(tf, frames_buf, frames_len);
+        double ns = (double)(Sim_HostNs() - t0) / frames_len;
+        if (ns < best) best = ns;
+    }
+    return best;
+}
+
+static void test_tinyframe_2mbaud(void)
+{
+    static TinyFrame ref;
+    static uint8_t payload[200];
+    double byte_ns, span_ns, zc_ns;
+    uint32_t expected;
+    uint64_t next_rx;
+    TinyFrame *tf;
+    Sim_Bench bench;
+
+    // Parser cost alone, same input
+    frames_len = build_stream(STREAM_FRAMES, &expected);
+    TF_InitStatic(&ref, TF_SLAVE);
+    TF_AddTypeListener(&ref, STREAM_TYPE, on_copy);
+    byte_ns = parse_ns_per_byte(&ref, false);
+    tf = TinyFrame_Init();
+    TF_AddTypeListener(tf, STREAM_TYPE, on_copy);
+    span_ns = parse_ns_per_byte(tf, true);
+    tf = TinyFrame_Init();
+    TinyFrame_AddZeroCopyListener(tf, STREAM_TYPE, on_zc);
+    span_lo = frames_buf;
+    span_hi = frames_buf + frames_len;
+    zc_ns = parse_ns_per_byte(tf, true);
+    printf("BENCH tinyframe parse (host)  TF_Accept %5.2f ns/B  TF_AcceptSpan %5.2f ns/B  zero-copy %5.2f ns/B\n",
+           byte_ns, span_ns, zc_ns);
+    SIM_CHECK(span_ns < byte_ns);
+
+    // 200-byte frames back to back over a 2 Mbaud loopback
+    Sim_Reset();
+    huart2.Init.BaudRate = 2000000;
+    HAL_UART_Init(&huart2);
+    UART_Register(TINYFRAME_UART_CHANNEL, &huart2, rx_dma, sizeof(rx_dma),
+                  rx_ring, sizeof(rx_ring), tx_ring, sizeof(tx_ring));
+    Sim_UART_SetTxSink(&huart2, loopback_sink, &huart2);
+    // The 64-byte DMA buffer wraps every 320 us: RX events move it to the ring
+    SIM_CHECK(UART_SetRxEventMode(TINYFRAME_UART_CHANNEL, true));
+    tf = TinyFrame_Init();
+    SIM_CHECK(TinyFrame_AddZeroCopyListener(tf, STREAM_TYPE, on_zc));
+    span_lo = rx_ring;
+    span_hi = rx_ring + sizeof(rx_ring);
+    zc_frames = zc_in_place = zc_bad = 0;
+
+    // Receiver polls once per millisecond: a frame still arriving is left in the
+    // ring until it is whole, so most are delivered in place (not across the wrap)
+    Sim_Bench_Begin(&bench, "tinyframe 2M 200B zero-copy", Sim_UART_Stats(&huart2));
+    next_rx = Sim_Now() + Sim_UsToCycles(1000);
+    for (uint32_t f = 0; f < 200; f++) {
+        make_payload(payload, sizeof(payload), (uint8_t)f);
+        while (UART_GetTxFree(TINYFRAME_UART_CHANNEL) < sizeof(payload) + 16) {
+            Sim_AdvanceUs(50);
+            if (Sim_Now() >= next_rx) {
+                TinyFrame_Process(tf);
+                next_rx += Sim_UsToCycles(1000);
+            }
+        }
+        SIM_CHECK(TF_SendSimple(tf, STREAM_TYPE, payload, sizeof(payload)));
+    }
+    for (int t = 0; t < 20 && zc_frames < 200; t++) {
+        Sim_AdvanceUs(1000);
+        TinyFrame_Process(tf);
+    }
+    Sim_Bench_End(&bench, 200 * sizeof(payload));
+    printf("BENCH tinyframe 2M 200B frames: %lu of %lu delivered in place from the RX ring\n",
+           (unsigned long)zc_in_place, (unsigned long)zc_frames);
+
+    SIM_CHECK(zc_frames == 200 && zc_bad == 0);
+    SIM_CHECK(zc_in_place >= 100);
+    SIM_CHECK(UART_GetRxOverrunCount(TINYFRAME_UART_CHANNEL) == 0);
+}
+
+// usbd_cdc_if.c user code, as in the usb_cdc README
+int8_t CDC_Receive_FS(uint8_t *Buf, uint32_t *Len)
+{
+    USB_CDC_RxCallback(Buf, *Len);
+    return USBD_OK;
+}
+
+int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+    (void)Buf;
+    (void)Len;
+    (void)epnum;
+    USB_CDC_TxCpltCallback();
+    return USBD_OK;
+}
+
+#define LINK_TYPE   0x44
+
+static uint8_t  usb_host_rx[2048];
+static uint32_t usb_host_len;
+static uint32_t link_a, link_b, link_usb, link_ref, link_bad;
+static uint32_t counted_writes;
+static TinyFrame_Loopback counted_lb;
+
+static void usb_host_sink(void *ctx, const uint8_t *data, uint32_t len)
+{
+    (void)ctx;
+    if (usb_host_len + len <= sizeof(usb_host_rx)) memcpy(&usb_host_rx[usb_host_len], data, len);
+    usb_host_len += len;
+}
+
+// Same type on two instances: each has its own zero-copy table
+static TF_Result on_link_a(TinyFrame *tf, TF_Msg *msg)
+{
+    (void)tf;
+    link_a++;
+    if (!payload_ok(msg)) link_bad++;
+    return TF_STAY;
+}
+
+static TF_Result on_link_b(TinyFrame *tf, TF_Msg *msg)
+{
+    link_b++;
+    if (!payload_ok(msg)) link_bad++;
+    // Echo back on the same link
+    if (!TF_Respond(tf, msg)) link_bad++;
+    return TF_STAY;
+}
+
+static TF_Result on_link_usb(TinyFrame *tf, TF_Msg *msg)
+{
+    link_usb++;
+    if (!payload_ok(msg)) link_bad++;
+    if (!TF_SendSimple(tf, LINK_TYPE, msg->data, msg->len)) link_bad++;
+    return TF_STAY;
+}
+
+static TF_Result on_link_ref(TinyFrame *tf, TF_Msg *msg)
+{
+    (void)tf;
+    link_ref++;
+    if (!payload_ok(msg)) link_bad++;
+    return TF_STAY;
+}
+
+// Custom transport: a loopback that counts writes
+static bool counted_write(void *ctx, const uint8_t *data, uint32_t len)
+{
+    counted_writes++;
+    return TinyFrame_LoopbackTransport.write(ctx, data, len);
+}
+
+static uint32_t counted_peek(void *ctx, const uint8_t **data, bool *more)
+{
+    return TinyFrame_LoopbackTransport.peek(ctx, data, more);
+}
+
+static void counted_skip(void *ctx, uint32_t len)
+{
+    TinyFrame_LoopbackTransport.skip(ctx, len);
+}
+
+static const TinyFrame_Transport counted_transport = {
+    .write = counted_write,
+    .peek  = counted_peek,
+    .skip  = counted_skip,
+};
+
+static void test_tinyframe_links(void)
+{
+    static TinyFrame_Loopback lb_a, lb_b;
+    static TinyFrame ref;
+    uint8_t payload[200], frame[256];
+    TinyFrame *a, *b, *usb, *extra;
+    uint32_t n;
+
+    Sim_USB_SetHostSink(usb_host_sink, NULL);
+    Sim_USB_Connect();
+    USB_CDC_Init();
+
+    // The default UART instance from the tests above holds one slot
+    TinyFrame_LoopbackConnect(&lb_a, &lb_b);
+    a = TinyFrame_Create(&TinyFrame_LoopbackTransport, &lb_a, TF_MASTER);
+    b = TinyFrame_Create(&TinyFrame_LoopbackTransport, &lb_b, TF_SLAVE);
+    usb = TinyFrame_Create(&TinyFrame_UsbCdcTransport, NULL, TF_SLAVE);
+    SIM_CHECK(a && b && usb);
+    SIM_CHECK(TinyFrame_Create(&TinyFrame_LoopbackTransport, &lb_a, TF_MASTER) == NULL);
+    SIM_CHECK(TinyFrame_AddZeroCopyListener(a, LINK_TYPE, on_link_a));
+    SIM_CHECK(TinyFrame_AddZeroCopyListener(b, LINK_TYPE, on_link_b));
+    SIM_CHECK(TinyFrame_AddZeroCopyListener(usb, LINK_TYPE, on_link_usb));
+    link_a = link_b = link_usb = link_ref = link_bad = 0;
+
+    // Loopback: a sends, b echoes with TF_Respond
+    for (uint32_t f = 0; f < 20; f++) {
+        make_payload(payload, (uint16_t)(20 + f * 9), (uint8_t)f);
+        SIM_CHECK(TF_SendSimple(a, LINK_TYPE, payload, (TF_LEN)(20 + f * 9)));
+        TinyFrame_Process(b);
+        TinyFrame_Process(a);
+    }
+    SIM_CHECK(link_a == 20 && link_b == 20 && link_bad == 0);
+
+    // USB CDC: the host sends three frames, the device echoes them
+    n = 0;
+    for (uint32_t f = 0; f < 3; f++) {
+        n = compose(frame, (uint8_t)f, LINK_TYPE, 150, (uint8_t)(f + 40));
+        SIM_CHECK(Sim_USB_HostWrite(frame, n) == n);
+    }
+    for (int t = 0; t < 20; t++) {
+        Sim_AdvanceUs(1000);
+        TinyFrame_Process(usb);
+    }
+    TF_InitStatic(&ref, TF_MASTER);
+    TF_AddTypeListener(&ref, LINK_TYPE, on_link_ref);
+    TF_Accept(&ref, usb_host_rx, usb_host_len);
+    SIM_CHECK(link_usb == 3 && link_ref == 3 && link_bad == 0);
+    SIM_CHECK(usb_host_len == 3 * n);
+
+    // Shared pool: two multipart frames in progress hold both TX buffers
+    SIM_CHECK(TINYFRAME_TX_POOL == 2);
+    make_payload(payload, 100, 7);
+    SIM_CHECK(TF_SendSimple_Multipart(a, LINK_TYPE, 100));
+    SIM_CHECK(!TF_SendSimple(a, LINK_TYPE, payload, 100));      // a is busy
+    SIM_CHECK(TF_SendSimple_Multipart(b, LINK_TYPE, 100));
+    SIM_CHECK(!TF_SendSimple(usb, LINK_TYPE, payload, 100));    // No buffer left
+    TF_Multipart_Payload(a, payload, 60);
+    TF_Multipart_Payload(a, payload + 60, 40);
+    TF_Multipart_Close(a);
+    SIM_CHECK(TF_SendSimple(usb, LINK_TYPE, payload, 100));
+    TF_Multipart_Payload(b, payload, 100);
+    TF_Multipart_Close(b);
+    TinyFrame_Process(b);
+    TinyFrame_Process(a);
+    SIM_CHECK(link_b == 21 && link_a == 22 && link_bad == 0);   // b's frame and b's echo
+
+    // A freed slot takes a custom transport; a frame is one write however
+    // many TF_SENDBUF_LEN chunks TinyFrame composed it in
+    TinyFrame_Destroy(usb);
+    TinyFrame_LoopbackConnect(&counted_lb, NULL);
+    extra = TinyFrame_Create(&counted_transport, &counted_lb, TF_MASTER);
+    SIM_CHECK(extra != NULL);
+    SIM_CHECK(TinyFrame_AddZeroCopyListener(extra, LINK_TYPE, on_link_a));
+    counted_writes = 0;
+    make_payload(payload, sizeof(payload), 99);
+    SIM_CHECK(TF_SendSimple(extra, LINK_TYPE, payload, sizeof(payload)));
+    SIM_CHECK(counted_writes == 1);
+    SIM_CHECK(sizeof(payload) > 4 * TF_SENDBUF_LEN);
+    TinyFrame_Process(extra);
+    SIM_CHECK(link_a == 23 && link_bad == 0);
+    SIM_CHECK(TinyFrame_GetTxDropCount(extra) == 0);
+
+    printf("BENCH tinyframe RAM  instance %u B (sendbuf %u B)  TX frame buffers %u shared by %u instances\n",
+           (unsigned)sizeof(TinyFrame), (unsigned)TF_SENDBUF_LEN, (unsigned)TINYFRAME_TX_POOL,
+           (unsigned)TINYFRAME_MAX_INSTANCES);
+
+    TinyFrame_Destroy(a);
+    TinyFrame_Destroy(b);
+    TinyFrame_Destroy(extra);
+}
+
+// Transport that refuses every write
+static bool refused_write(void *ctx, const uint8_t *data, uint32_t len)
+{
+    (void)ctx;
+    (void)data;
+    (void)len;
+    return false;
+}
+
+static uint32_t refused_peek(void *ctx, const uint8_t **data, bool *more)
+{
+    (void)ctx;
+    *data = NULL;
+    *more = false;
+    return 0;
+}
+
+static void refused_skip(void *ctx, uint32_t len)
+{
+    (void)ctx;
+    (void)len;
+}
+
+static const TinyFrame_Transport refused_transport = {
+    .write = refused_write,
+    .peek  = refused_peek,
+    .skip  = refused_skip,
+};
+
+static uint8_t pool_isr_payload[10];
+static bool pool_isr_sent;
+
+static void pool_isr_send(void *ctx)
+{
+    pool_isr_sent = TF_SendSimple((TinyFrame *)ctx, LINK_TYPE, pool_isr_payload, sizeof(pool_isr_payload));
+}
+
+// Bare-metal TX pool: exhaustion, a send from an interrupt, release on every path
+static void test_tinyframe_pool(void)
+{
+    static TinyFrame_Loopback lb_a, lb_b;
+    uint8_t payload[100];
+    TinyFrame *a, *b, *c;
+
+    TinyFrame_LoopbackConnect(&lb_a, &lb_b);
+    a = TinyFrame_Create(&TinyFrame_LoopbackTransport, &lb_a, TF_MASTER);
+    b = TinyFrame_Create(&TinyFrame_LoopbackTransport, &lb_b, TF_SLAVE);
+    c = TinyFrame_Create(&refused_transport, NULL, TF_MASTER);
+    SIM_CHECK(a && b && c);
+    SIM_CHECK(TinyFrame_AddZeroCopyListener(b, LINK_TYPE, on_link_a));
+    link_a = link_bad = 0;
+    make_payload(payload, sizeof(payload), 3);
+
+    // Both buffers held: further claims fail without taking anything
+    SIM_CHECK(TF_SendSimple_Multipart(a, LINK_TYPE, sizeof(payload)));
+    SIM_CHECK(TF_SendSimple_Multipart(c, LINK_TYPE, 10));
+    for (int i = 0; i < 5; i++) SIM_CHECK(!TF_SendSimple(b, LINK_TYPE, payload, 10));
+
+    // An interrupt sending on a while its frame is open is turned away
+    pool_isr_sent = true;
+    SIM_CHECK(Sim_Schedule(Sim_UsToCycles(10), pool_isr_send, a, true));
+    TF_Multipart_Payload(a, payload, 50);
+    Sim_AdvanceUs(20);
+    SIM_CHECK(!pool_isr_sent);
+    TF_Multipart_Payload(a, payload + 50, 50);
+    TF_Multipart_Close(a);
+
+    // A refused write is counted, the buffer still goes back
+    TF_Multipart_Payload(c, payload, 10);
+    TF_Multipart_Close(c);
+    SIM_CHECK(TinyFrame_GetTxDropCount(c) > 0);
+
+    // Nothing leaked: the instances take turns, then hold both buffers again
+    for (int i = 0; i < 3 * TINYFRAME_TX_POOL; i++) {
+        SIM_CHECK(TF_SendSimple(a, LINK_TYPE, payload, sizeof(payload)));
+        SIM_CHECK(TF_SendSimple(c, LINK_TYPE, payload, 10));
+        TinyFrame_Process(b);
+    }
+    SIM_CHECK(TF_SendSimple_Multipart(a, LINK_TYPE, 10));
+    SIM_CHECK(TF_SendSimple_Multipart(c, LINK_TYPE, 10));
+    TF_Multipart_Payload(a, payload, 10);
+    TF_Multipart_Close(a);
+    TF_Multipart_Payload(c, payload, 10);
+    TF_Multipart_Close(c);
+
+    TinyFrame_Process(b);
+    SIM_CHECK(link_a == 2 + 3 * TINYFRAME_TX_POOL && link_bad == 0);
+    SIM_CHECK(TF_SendSimple(b, LINK_TYPE, payload, 10));
+
+    TinyFrame_Destroy(a);
+    TinyFrame_Destroy(b);
+    TinyFrame_Destroy(c);
+}
+
+/* ============================================================================
+ * SFUD
+ * ========================================================================= */
+
+static void test_sfud_probe(void)
+{
+    static Sim_W25Q flash;
+    const sfud_flash *sf;
+    uint8_t data[64], back[64];
+
+    Sim_W25Q_Init(&flash, &hspi1, GPIOA, GPIO_PIN_4, 0xEF4017);
+    SIM_CHECK(SFUD_Port_Init() == SFUD_SUCCESS);
+    sf = SFUD_Port_GetDefaultFlash();
+    SIM_CHECK(sf->chip.capacity == 8UL * 1024UL * 1024UL);
+
+    for (uint32_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t)(0xC0 + i);
+    SIM_CHECK(sfud_erase_write(sf, 0x3000, sizeof(data), data) == SFUD_SUCCESS);
+    SIM_CHECK(sfud_read(sf, 0x3000, sizeof(back), back) == SFUD_SUCCESS);
+    SIM_CHECK(memcmp(data, back, sizeof(data)) == 0);
+
+    // Same read with DMA channels: the 64-byte read phase goes through spi_dma
+    hspi1.hdmarx = &hdma_spi1_rx;
+    hspi1.hdmatx = &hdma_spi1_tx;
+    memset(back, 0, sizeof(back));
+    SIM_CHECK(sfud_read(sf, 0x3000, sizeof(back), back) == SFUD_SUCCESS);
+    SIM_CHECK(memcmp(data, back, sizeof(data)) == 0);
+    SIM_CHECK(Sim_SPI_Stats(&hspi1)->dma_transfers == 1);
+    SIM_CHECK(flash.stats.busy_violations == 0);
+    Sim_W25Q_Free(&flash);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    test_tinyframe_loopback();
+    test_tinyframe_span();
+    test_tinyframe_2mbaud();
+    test_tinyframe_links();
+    test_tinyframe_pool();
+    test_sfud_probe();
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,248 @@
+/**
+ * @file sd_card_spi_sim_tests.c
+ * @brief sd_card_spi.c against the simulated SDHC card: capacity from the CSD
+ *        (v2.0, and v1.0 on an SDSC card), single vs multi-block commands,
+ *        DMA data phases, streaming logger throughput, ACMD23 count contract
+ */
+
+#include "sim_test.h"
+#include "sim_sdcard.h"
+#include "sd_card_spi.h"
+#include <string.h>
+
+#define BLOCKS  (16U * 1024U)   // 8 MB card
+
+static SPI_HandleTypeDef         hspi2, hspi3;
+static DMA_HandleTypeDef         hdma_spi2_rx;
+static DMA_HandleTypeDef         hdma_spi2_tx;
+static Sim_SDCard                card;
+static SD_Card_SPI_HandleTypeDef hsd;
+
+static void test_init(void)
+{
+    SIM_CHECK(SD_SPI_Init(&hsd, &hspi2, GPIOB, GPIO_PIN_12) == 0);
+    SIM_CHECK(hsd.Type == SD_CARD_TYPE_V2HC);
+    SIM_CHECK(hsd.Capacity == BLOCKS && hsd.EraseSectors == 128);
+    SIM_CHECK(SD_SPI_GetCapacityKB(&hsd) == BLOCKS / 2);
+}
+
+// Standard capacity card: CSD 1.0 (C_SIZE, C_SIZE_MULT), byte addressing
+static void test_sdsc(void)
+{
+    static Sim_SDCard sdsc;
+    SD_Card_SPI_HandleTypeDef hsc;
+    uint8_t buf[512], back[512];
+
+    Sim_SDCard_Init(&sdsc, &hspi3, GPIOC, GPIO_PIN_4, 64U * 1024U, false);
+    SIM_CHECK(SD_SPI_Init(&hsc, &hspi3, GPIOC, GPIO_PIN_4) == 0);
+    SIM_CHECK(hsc.Type == SD_CARD_TYPE_V2);
+    SIM_CHECK(hsc.Capacity == 64U * 1024U && hsc.EraseSectors == 128);
+
+    memset(buf, 0x3C, sizeof(buf));
+    SIM_CHECK(SD_SPI_WriteBlock(&hsc, hsc.Capacity - 1, buf) == 0);
+    SIM_CHECK(SD_SPI_ReadBlock(&hsc, hsc.Capacity - 1, back) == 0);
+    SIM_CHECK(memcmp(buf, back, sizeof(buf)) == 0);
+    SIM_CHECK(sdsc.stats.protocol_errors == 0);
+    Sim_SDCard_Free(&sdsc);
+}
+
+static void test_blocks(void)
+{
+    enum { COUNT = 16 };
+    static uint8_t src[COUNT * 512], dst[COUNT * 512];
+    Sim_Bench bench;
+
+    for (uint32_t i = 0; i < sizeof(src); i++) src[i] = (uint8_t)(i * 31 + 1);
+
+    Sim_Bench_Begin(&bench, "sd write 16 blocks", Sim_SPI_Stats(&hspi2));
+    SIM_CHECK(SD_SPI_WriteBlocks(&hsd, 100, src, COUNT) == 0);
+    Sim_Bench_End(&bench, sizeof(src));
+    SIM_CHECK(card.stats.blocks_written == COUNT);
+    SIM_CHECK(card.stats.cmd25 == 1 && card.stats.acmd23 == 1 && card.stats.cmd24 == 0);
+    SIM_CHECK(memcmp(&card.mem[100 * 512], src, sizeof(src)) == 0);
+
+    Sim_Bench_Begin(&bench, "sd read 16 blocks", Sim_SPI_Stats(&hspi2));
+    SIM_CHECK(SD_SPI_ReadBlocks(&hsd, 100, dst, COUNT) == 0);
+    Sim_Bench_End(&bench, sizeof(dst));
+    SIM_CHECK(memcmp(src, dst, sizeof(src)) == 0);
+    SIM_CHECK(card.stats.cmd18 == 1 && card.stats.cmd12 == 1 && card.stats.cmd17 == 0);
+
+    // Odd tails: single block and a run that ends right at the card's last block
+    SIM_CHECK(SD_SPI_ReadBlocks(&hsd, 100, dst, 1) == 0);
+    SIM_CHECK(SD_SPI_WriteBlocks(&hsd, BLOCKS - 2, src, 2) == 0);
+    SIM_CHECK(SD_SPI_ReadBlocks(&hsd, BLOCKS - 2, dst, 2) == 0);
+    SIM_CHECK(memcmp(src, dst, 2 * 512) == 0);
+
+    SIM_CHECK(card.stats.protocol_errors == 0);
+}
+
+// CMD17/CMD24 per sector, the way ReadBlocks/WriteBlocks used to do it
+static void test_single_vs_multi(void)
+{
+    enum { COUNT = 64 };
+    static uint8_t src[COUNT * 512], dst[COUNT * 512];
+    uint64_t t0, single_wr, multi_wr, single_rd, multi_rd;
+    Sim_Bench bench;
+
+    for (uint32_t i = 0; i < sizeof(src); i++) src[i] = (uint8_t)(i * 7 + 3);
+
+    Sim_Bench_Begin(&bench, "sd write 64 x CMD24", Sim_SPI_Stats(&hspi2));
+    t0 = Sim_Now();
+    for (uint32_t i = 0; i < COUNT; i++) SIM_CHECK(SD_SPI_WriteBlock(&hsd, 1000 + i, src + i * 512) == 0);
+    single_wr = Sim_Now() - t0;
+    Sim_Bench_End(&bench, sizeof(src));
+
+    Sim_Bench_Begin(&bench, "sd write 64 CMD25", Sim_SPI_Stats(&hspi2));
+    t0 = Sim_Now();
+    SIM_CHECK(SD_SPI_WriteBlocks(&hsd, 2000, src, COUNT) == 0);
+    multi_wr = Sim_Now() - t0;
+    Sim_Bench_End(&bench, sizeof(src));
+
+    Sim_Bench_Begin(&bench, "sd read 64 x CMD17", Sim_SPI_Stats(&hspi2));
+    t0 = Sim_Now();
+    for (uint32_t i = 0; i < COUNT; i++) SIM_CHECK(SD_SPI_ReadBlock(&hsd, 1000 + i, dst + i * 512) == 0);
+    single_rd = Sim_Now() - t0;
+    Sim_Bench_End(&bench, sizeof(dst));
+    SIM_CHECK(memcmp(src, dst, sizeof(src)) == 0);
+
+    Sim_Bench_Begin(&bench, "sd read 64 CMD18", Sim_SPI_Stats(&hspi2));
+    t0 = Sim_Now();
+    SIM_CHECK(SD_SPI_ReadBlocks(&hsd, 2000, dst, COUNT) == 0);
+    multi_rd = Sim_Now() - t0;
+    Sim_Bench_End(&bench, sizeof(dst));
+    SIM_CHECK(memcmp(src, dst, sizeof(src)) == 0);
+
+    printf("BENCH sd multi-block speedup         write %.1fx  read %.1fx\n",
+           (double)single_wr / (double)multi_wr, (double)single_rd / (double)multi_rd);
+    SIM_CHECK(multi_wr * 2 < single_wr);
+    SIM_CHECK(multi_rd * 3 < single_rd * 2);
+    SIM_CHECK(card.stats.protocol_errors == 0);
+}
+
+static void test_dma(void)
+{
+    enum { COUNT = 64 };
+    static uint8_t src[COUNT * 512], dst[COUNT * 512];
+    Sim_BusStats *bus = Sim_SPI_Stats(&hspi2);
+    uint64_t dma_start, blocking_start;
+    Sim_Bench bench;
+
+    hspi2.hdmarx = &hdma_spi2_rx;
+    hspi2.hdmatx = &hdma_spi2_tx;
+    SIM_CHECK(SD_SPI_Init(&hsd, &hspi2, GPIOB, GPIO_PIN_12) == 0);
+    SIM_CHECK(hsd.UseDMA == 1);
+
+    for (uint32_t i = 0; i < sizeof(src); i++) src[i] = (uint8_t)(i * 13 + 5);
+
+    dma_start = bus->dma_transfers;
+    Sim_Bench_Begin(&bench, "sd write 64 CMD25 dma", bus);
+    SIM_CHECK(SD_SPI_WriteBlocks(&hsd, 3000, src, COUNT) == 0);
+    Sim_Bench_End(&bench, sizeof(src));
+
+    blocking_start = bus->blocking_cycles;
+    Sim_Bench_Begin(&bench, "sd read 64 CMD18 dma", bus);
+    SIM_CHECK(SD_SPI_ReadBlocks(&hsd, 3000, dst, COUNT) == 0);
+    Sim_Bench_End(&bench, sizeof(dst));
+    // Only the command, tokens and CRC bytes are left as polled bytes
+    SIM_CHECK(bus->blocking_cycles - blocking_start < (uint64_t)sizeof(dst) * 4);
+
+    SIM_CHECK(memcmp(src, dst, sizeof(src)) == 0);
+    SIM_CHECK(bus->dma_transfers - dma_start == 2 * COUNT);
+    SIM_CHECK(hsd.Errors == 0);
+    SIM_CHECK(card.stats.protocol_errors == 0);
+}
+
+// Data logger: each 512-byte record costs FILL_US of CPU time to produce
+static void test_logger(void)
+{
+    enum { RECORDS = 128, FILL_US = 150 };
+    static uint8_t buf[512];
+    uint64_t t0, single, stream;
+    Sim_Bench bench;
+
+    Sim_Bench_Begin(&bench, "sd logger CMD24 per record", Sim_SPI_Stats(&hspi2));
+    t0 = Sim_Now();
+    for (uint32_t r = 0; r < RECORDS; r++) {
+        Sim_AdvanceUs(FILL_US);
+        memset(buf, (int)r, sizeof(buf));
+        SIM_CHECK(SD_SPI_WriteBlock(&hsd, 4000 + r, buf) == 0);
+    }
+    single = Sim_Now() - t0;
+    Sim_Bench_End(&bench, RECORDS * 512U);
+
+    Sim_Bench_Begin(&bench, "sd logger CMD25 stream", Sim_SPI_Stats(&hspi2));
+    t0 = Sim_Now();
+    SIM_CHECK(SD_SPI_WriteStart(&hsd, 5000, RECORDS) == 0);
+    for (uint32_t r = 0; r < RECORDS; r++) {
+        // Runs while the card programs the previous record
+        Sim_AdvanceUs(FILL_US);
+        memset(buf, (int)r, sizeof(buf));
+        SIM_CHECK(SD_SPI_WriteNext(&hsd, buf) == 0);
+    }
+    SIM_CHECK(hsd.StreamBlocks == RECORDS);
+    SIM_CHECK(SD_SPI_WriteStop(&hsd) == 0);
+    stream = Sim_Now() - t0;
+    Sim_Bench_End(&bench, RECORDS * 512U);
+
+    printf("BENCH sd logger sustained            %.0f KB/s single vs %.0f KB/s stream (%.1fx)\n",
+           RECORDS * 0.5 / (Sim_CyclesToUs(single) / 1e6), RECORDS * 0.5 / (Sim_CyclesToUs(stream) / 1e6),
+           (double)single / (double)stream);
+    SIM_CHECK(stream * 3 < single);
+    SIM_CHECK(card.mem[(5000 + RECORDS - 1) * 512] == (uint8_t)(RECORDS - 1));
+
+    // The stream owns the card until it is stopped
+    SIM_CHECK(SD_SPI_WriteNext(&hsd, buf) == 1);
+    SIM_CHECK(card.stats.protocol_errors == 0);
+}
+
+// A counted stream holds exactly count blocks; open-ended streams get no ACMD23
+static void test_stream_count(void)
+{
+    static uint8_t buf[512];
+    uint64_t acmd23 = card.stats.acmd23;
+
+    memset(buf, 0xA5, sizeof(buf));
+    for (uint32_t b = 6000; b < 6008; b++) SIM_CHECK(SD_SPI_WriteBlock(&hsd, b, buf) == 0);
+    memset(buf, 0x3C, sizeof(buf));
+
+    // Open-ended: the blocks after the stream keep their data
+    SIM_CHECK(SD_SPI_WriteStart(&hsd, 6000, 0) == 0);
+    SIM_CHECK(SD_SPI_WriteNext(&hsd, buf) == 0);
+    SIM_CHECK(SD_SPI_WriteStop(&hsd) == 0);
+    SIM_CHECK(card.stats.acmd23 == acmd23);
+    SIM_CHECK(card.mem[6000 * 512] == 0x3C && card.mem[6001 * 512] == 0xA5);
+
+    // Counted: one block more than promised is refused
+    SIM_CHECK(SD_SPI_WriteStart(&hsd, 6000, 2) == 0);
+    SIM_CHECK(SD_SPI_WriteNext(&hsd, buf) == 0);
+    SIM_CHECK(SD_SPI_WriteNext(&hsd, buf) == 0);
+    SIM_CHECK(SD_SPI_WriteNext(&hsd, buf) == 1);
+    SIM_CHECK(SD_SPI_WriteStop(&hsd) == 0);
+    SIM_CHECK(card.stats.acmd23 == acmd23 + 1);
+    SIM_CHECK(card.mem[6001 * 512] == 0x3C && card.mem[6002 * 512] == 0xA5);
+
+    // Short of the count: the card may wipe the rest, and WriteStop says so
+    SIM_CHECK(SD_SPI_WriteStart(&hsd, 6004, 4) == 0);
+    SIM_CHECK(SD_SPI_WriteNext(&hsd, buf) == 0);
+    SIM_CHECK(SD_SPI_WriteStop(&hsd) == 2);
+    SIM_CHECK(card.stats.blocks_pre_erased == 3);
+    SIM_CHECK(card.mem[6005 * 512] != 0xA5);
+    SIM_CHECK(card.stats.protocol_errors == 0);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    Sim_SDCard_Init(&card, &hspi2, GPIOB, GPIO_PIN_12, BLOCKS, true);
+
+    test_init();
+    test_sdsc();
+    test_blocks();
+    test_single_vs_multi();
+    test_dma();
+    test_logger();
+    test_stream_count();
+
+    Sim_SDCard_Free(&card);
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,268 @@
+/**
+ * @file sfud_sim_tests.c
+ * @brief SFUD as a storage backend: two chips on two SPI buses, read command
+ *        chosen from SFDP, DMA page programs, the Block_Device backends
+ *        (SFUD, W25QXX), littlefs and FatFs mounted on them
+ */
+
+#include "sim_test.h"
+#include "sim_w25q.h"
+#include "sfud_port.h"
+#include "w25qxx.h"
+#include "littlefs_port.h"
+#include "fatfs_bd.h"
+#include <string.h>
+
+SPI_HandleTypeDef           hspi1;          // Referenced by sfud_port.c
+W25QXX_HandleTypeDef        w25qxx_handle;  // Referenced by littlefs_port.c
+static SPI_HandleTypeDef    hspi2;
+static DMA_HandleTypeDef    hdma_spi1_rx, hdma_spi1_tx, hdma_spi2_rx, hdma_spi2_tx;
+static Sim_W25Q             chip_a, chip_b;
+static sfud_flash           flash_a, flash_b;
+static SFUD_Port_Bus        bus_a, bus_b;
+static Block_Device         bd_a, bd_b, bd_w25q;
+
+static void fill(uint8_t *buf, uint32_t len, uint32_t seed)
+{
+    for (uint32_t i = 0; i < len; i++) buf[i] = (uint8_t)((i * 31U) ^ (i >> 8) ^ seed);
+}
+
+static void test_probe(void)
+{
+    SFUD_Port_Bus *bus;
+
+    // A: W25Q64 with SFDP on SPI1; B: W25Q32 without SFDP on SPI2
+    SIM_CHECK(SFUD_Port_InitDevice(&flash_a, &bus_a, "A", &hspi1, GPIOA, GPIO_PIN_4) == SFUD_SUCCESS);
+    SIM_CHECK(SFUD_Port_InitDevice(&flash_b, &bus_b, "B", &hspi2, GPIOB, GPIO_PIN_12) == SFUD_SUCCESS);
+
+    bus = SFUD_Port_GetBus(&flash_a);
+    SIM_CHECK(bus == &bus_a && bus->hspi == &hspi1);
+    SIM_CHECK(flash_a.sfdp.available && flash_a.chip.capacity == 8UL * 1024UL * 1024UL);
+    SIM_CHECK(bus->read_cmd == 0x0B && bus->read_dummy == 1);
+    SIM_CHECK(bus->read_modes == (SFUD_PORT_READ_1_1_2 | SFUD_PORT_READ_1_2_2 |
+                                  SFUD_PORT_READ_1_1_4 | SFUD_PORT_READ_1_4_4));
+
+    bus = SFUD_Port_GetBus(&flash_b);
+    SIM_CHECK(bus == &bus_b && bus->hspi == &hspi2);
+    SIM_CHECK(!flash_b.sfdp.available && flash_b.chip.capacity == 4UL * 1024UL * 1024UL);
+    SIM_CHECK(bus->read_cmd == 0x03 && bus->read_dummy == 0 && bus->read_modes == 0);
+}
+
+static void test_transfers(void)
+{
+    enum { LEN = 4096 };
+    static uint8_t data[LEN], back[LEN];
+    uint64_t dma_a = Sim_SPI_Stats(&hspi1)->dma_transfers;
+    uint64_t bytes_b = Sim_SPI_Stats(&hspi2)->tx_bytes;
+    uint64_t fast = chip_a.stats.fast_reads;
+
+    fill(data, LEN, 0x11);
+    SIM_CHECK(sfud_erase_write(&flash_a, 0x10000, LEN, data) == SFUD_SUCCESS);
+
+    // 16 page programs and the read-back by DMA, all on SPI1
+    SIM_CHECK(SFUD_Port_Read(&flash_a, 0x10000, LEN, back) == SFUD_SUCCESS);
+    SIM_CHECK(memcmp(data, back, LEN) == 0);
+    SIM_CHECK(Sim_SPI_Stats(&hspi1)->dma_transfers - dma_a == LEN / 256 + 1);
+    SIM_CHECK(chip_a.stats.fast_reads - fast == 1);
+    SIM_CHECK(Sim_SPI_Stats(&hspi2)->tx_bytes == bytes_b);
+    SIM_CHECK(chip_a.stats.busy_violations == 0);
+
+    // B reads with 0x03 on its own bus
+    fill(data, LEN, 0x22);
+    SIM_CHECK(sfud_erase_write(&flash_b, 0x2000, LEN, data) == SFUD_SUCCESS);
+    SIM_CHECK(SFUD_Port_Read(&flash_b, 0x2000, LEN, back) == SFUD_SUCCESS);
+    SIM_CHECK(memcmp(data, back, LEN) == 0);
+    SIM_CHECK(chip_b.stats.fast_reads == 0 && chip_b.stats.busy_violations == 0);
+    SIM_CHECK(memcmp(&chip_a.mem[0x2000], data, LEN) != 0);
+
+    SIM_CHECK(SFUD_Port_Read(&flash_b, 4UL * 1024UL * 1024UL - 16, 32, back) == SFUD_ERR_ADDR_OUT_OF_BOUND);
+}
+
+// 256-byte reads as a filesystem issues them, through the three read paths
+static void test_read_bench(void)
+{
+    enum { N = 256, LEN = 256 };
+    static uint8_t back[LEN];
+    uint64_t t0, t_sfud, t_port, t_w25q;
+    uint32_t bad = 0;
+    Sim_Bench bench;
+
+    Sim_Bench_Begin(&bench, "sfud_read 256 B x 256", Sim_SPI_Stats(&hspi1));
+    t0 = Sim_Now();
+    for (uint32_t i = 0; i < N; i++) {
+        SIM_CHECK(sfud_read(&flash_a, 0x10000 + (i * LEN) % 4096, LEN, back) == SFUD_SUCCESS);
+    }
+    t_sfud = Sim_Now() - t0;
+    Sim_Bench_End(&bench, N * LEN);
+
+    Sim_Bench_Begin(&bench, "SFUD_Port_Read 256 B x 256", Sim_SPI_Stats(&hspi1));
+    t0 = Sim_Now();
+    for (uint32_t i = 0; i < N; i++) {
+        SIM_CHECK(SFUD_Port_Read(&flash_a, 0x10000 + (i * LEN) % 4096, LEN, back) == SFUD_SUCCESS);
+        if (memcmp(back, &chip_a.mem[0x10000 + (i * LEN) % 4096], LEN) != 0) bad++;
+    }
+    t_port = Sim_Now() - t0;
+    Sim_Bench_End(&bench, N * LEN);
+
+    Sim_Bench_Begin(&bench, "W25QXX_Read 256 B x 256", Sim_SPI_Stats(&hspi1));
+    t0 = Sim_Now();
+    for (uint32_t i = 0; i < N; i++) {
+        W25QXX_Read(&w25qxx_handle, back, 0x10000 + (i * LEN) % 4096, LEN);
+    }
+    t_w25q = Sim_Now() - t0;
+    Sim_Bench_End(&bench, N * LEN);
+
+    // No status poll per read
+    SIM_CHECK(bad == 0);
+    SIM_CHECK(t_port < t_sfud);
+    SIM_CHECK(t_port <= t_w25q + t_w25q / 10);
+}
+
+static void test_block_devices(void)
+{
+    static uint8_t page[256], back[256];
+    uint64_t e4, e64;
+
+    SIM_CHECK(SFUD_Port_BlockDev(&bd_a, &flash_a) == BLOCK_DEV_OK);
+    SIM_CHECK(SFUD_Port_BlockDev(&bd_b, &flash_b) == BLOCK_DEV_OK);
+    SIM_CHECK(W25QXX_BlockDev(&bd_w25q, &w25qxx_handle) == BLOCK_DEV_OK);
+
+    SIM_CHECK(bd_a.capacity == 8UL * 1024UL * 1024UL && bd_a.prog_size == 256);
+    SIM_CHECK(bd_a.erase_size == 4096 && bd_a.block_size == 65536);
+    SIM_CHECK(bd_b.capacity == 4UL * 1024UL * 1024UL && bd_b.erase_size == 4096 && bd_b.block_size == 65536);
+    SIM_CHECK(bd_w25q.capacity == bd_a.capacity && bd_w25q.block_size == bd_a.block_size);
+
+    // Checked wrappers
+    SIM_CHECK(BlockDev_Erase(&bd_a, 0x100, 4096) == BLOCK_DEV_ERR_PARAM);
+    SIM_CHECK(BlockDev_Prog(&bd_a, 0x10, page, 256) == BLOCK_DEV_ERR_PARAM);
+    SIM_CHECK(BlockDev_Read(&bd_a, bd_a.capacity - 4, back, 8) == BLOCK_DEV_ERR_PARAM);
+
+    // SFDP eraser table: one 64 KB erase, then a 4 KB one
+    e4 = chip_a.stats.erases_4k;
+    e64 = chip_a.stats.erases_64k;
+    SIM_CHECK(BlockDev_Erase(&bd_a, 0x20000, 0x11000) == BLOCK_DEV_OK);
+    SIM_CHECK(chip_a.stats.erases_64k - e64 == 1 && chip_a.stats.erases_4k - e4 == 1);
+
+    // W25QXX backend does the same with its own commands
+    e4 = chip_a.stats.erases_4k;
+    e64 = chip_a.stats.erases_64k;
+    SIM_CHECK(BlockDev_Erase(&bd_w25q, 0x40000, 0x11000) == BLOCK_DEV_OK);
+    SIM_CHECK(chip_a.stats.erases_64k - e64 == 1 && chip_a.stats.erases_4k - e4 == 1);
+
+    fill(page, sizeof(page), 0x33);
+    SIM_CHECK(BlockDev_Prog(&bd_a, 0x20100, page, 256) == BLOCK_DEV_OK);
+    SIM_CHECK(BlockDev_Read(&bd_w25q, 0x20100, back, 256) == BLOCK_DEV_OK);
+    SIM_CHECK(memcmp(page, back, sizeof(page)) == 0);
+    SIM_CHECK(BlockDev_Sync(&bd_a) == BLOCK_DEV_OK);
+}
+
+static void test_littlefs(void)
+{
+    static LittleFS_Partition part;
+    static const LittleFS_Partition_Config conf = {
+        .name = "data", .offset = 1024 * 1024, .size = 1024 * 1024,
+    };
+    static uint8_t data[10000], back[10000];
+    lfs_file_t file;
+    Sim_Bench bench;
+
+    fill(data, sizeof(data), 0x44);
+    Sim_Bench_Begin(&bench, "lfs on sfud bd, 10K file", Sim_SPI_Stats(&hspi1));
+    SIM_CHECK(LittleFS_Partition_MountBD(&part, &bd_a, &conf) == 0);
+    SIM_CHECK(lfs_file_open(&part.lfs, &file, "blob", LFS_O_WRONLY | LFS_O_CREAT) == 0);
+    SIM_CHECK(lfs_file_write(&part.lfs, &file, data, sizeof(data)) == (lfs_ssize_t)sizeof(data));
+    SIM_CHECK(lfs_file_close(&part.lfs, &file) == 0);
+    Sim_Bench_End(&bench, sizeof(data));
+    LittleFS_Partition_Unmount(&part);
+
+    // Overlaps the mounted one on the same chip
+    SIM_CHECK(LittleFS_Partition_MountBD(&part, &bd_a, &conf) == 0);
+    {
+        static LittleFS_Partition other;
+        static const LittleFS_Partition_Config overlap = { .offset = 1536 * 1024, .size = 1024 * 1024 };
+        SIM_CHECK(LittleFS_Partition_MountBD(&other, &bd_a, &overlap) == LFS_ERR_INVAL);
+    }
+
+    SIM_CHECK(lfs_file_open(&part.lfs, &file, "blob", LFS_O_RDONLY) == 0);
+    SIM_CHECK(lfs_file_read(&part.lfs, &file, back, sizeof(back)) == (lfs_ssize_t)sizeof(back));
+    SIM_CHECK(lfs_file_close(&part.lfs, &file) == 0);
+    SIM_CHECK(memcmp(data, back, sizeof(data)) == 0);
+    LittleFS_Partition_Unmount(&part);
+    SIM_CHECK(chip_a.stats.busy_violations == 0);
+}
+
+static void test_fatfs(void)
+{
+    static FATFS fs;
+    static FIL fil;
+    static uint8_t work[FATFS_BD_UNIT_SIZE];
+    static uint8_t data[20000], back[20000];
+    static char path[4];
+    char name[16];
+    uint64_t t0;
+    UINT n;
+    Sim_Bench bench;
+
+    fill(data, sizeof(data), 0x55);
+    SIM_CHECK(FatFs_BD_Link(&bd_b, path) == 0);
+    SIM_CHECK(strcmp(path, "0:/") == 0);
+
+    SIM_CHECK(f_mount(&fs, path, 1) == FR_NO_FILESYSTEM);
+    t0 = Sim_Now();
+    SIM_CHECK(f_mkfs(path, FM_ANY, 0, work, sizeof(work)) == FR_OK);
+    printf("BENCH fatfs mkfs on sfud bd (4 MB)  %.1f ms\n", Sim_CyclesToUs(Sim_Now() - t0) / 1000.0);
+    SIM_CHECK(f_mount(&fs, path, 1) == FR_OK);
+
+    Sim_Bench_Begin(&bench, "fatfs write 20K file", Sim_SPI_Stats(&hspi2));
+    snprintf(name, sizeof(name), "%sLOG.BIN", path);
+    SIM_CHECK(f_open(&fil, name, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+    for (uint32_t off = 0; off < sizeof(data); off += 1000) {
+        SIM_CHECK(f_write(&fil, &data[off], 1000, &n) == FR_OK && n == 1000);
+    }
+    SIM_CHECK(f_close(&fil) == FR_OK);
+    Sim_Bench_End(&bench, sizeof(data));
+
+    // Written into erased space: programs only
+    printf("BENCH fatfs units: %lu loads, %lu erased, %lu programmed without erase\n",
+           (unsigned long)fatfs_bd_stats.unit_loads, (unsigned long)fatfs_bd_stats.unit_erases,
+           (unsigned long)fatfs_bd_stats.unit_appends);
+    SIM_CHECK(fatfs_bd_stats.unit_appends > fatfs_bd_stats.unit_erases);
+
+    // Rewrite in place needs erases, and still reads back
+    SIM_CHECK(f_open(&fil, name, FA_OPEN_EXISTING | FA_WRITE) == FR_OK);
+    fill(data, 3000, 0x66);
+    SIM_CHECK(f_write(&fil, data, 3000, &n) == FR_OK && n == 3000);
+    SIM_CHECK(f_close(&fil) == FR_OK);
+
+    SIM_CHECK(f_mount(NULL, path, 0) == FR_OK);
+    SIM_CHECK(f_mount(&fs, path, 1) == FR_OK);
+    SIM_CHECK(f_open(&fil, name, FA_READ) == FR_OK);
+    SIM_CHECK(f_read(&fil, back, sizeof(back), &n) == FR_OK && n == sizeof(back));
+    SIM_CHECK(f_close(&fil) == FR_OK);
+    SIM_CHECK(memcmp(data, back, sizeof(data)) == 0);
+    SIM_CHECK(chip_b.stats.busy_violations == 0);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    hspi1.hdmarx = &hdma_spi1_rx;
+    hspi1.hdmatx = &hdma_spi1_tx;
+    hspi2.hdmarx = &hdma_spi2_rx;
+    hspi2.hdmatx = &hdma_spi2_tx;
+    Sim_W25Q_Init(&chip_a, &hspi1, GPIOA, GPIO_PIN_4, 0xEF4017);
+    Sim_W25Q_Init(&chip_b, &hspi2, GPIOB, GPIO_PIN_12, 0xEF4016);
+    chip_b.sfdp_len = 0;
+    SIM_CHECK(W25QXX_Init(&w25qxx_handle, &hspi1, GPIOA, GPIO_PIN_4) == 1);
+
+    test_probe();
+    test_transfers();
+    test_read_bench();
+    test_block_devices();
+    test_littlefs();
+    test_fatfs();
+
+    Sim_W25Q_Free(&chip_a);
+    Sim_W25Q_Free(&chip_b);
+    return SIM_TEST_RESULT();
+}
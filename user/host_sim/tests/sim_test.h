@@ -0,0 +1,77 @@
+/**
+ * @file sim_test.h
+ * @brief Minimal check/benchmark helpers for host simulator tests
+ */
+
+#ifndef __SIM_TEST_H__
+#define __SIM_TEST_H__
+
+#include "sim_hal.h"
+#include <stdio.h>
+
+static int sim_test_failures;
+
+#define SIM_CHECK(cond)                                                       \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);            \
+            sim_test_failures++;                                              \
+        }                                                                     \
+    } while (0)
+
+#define SIM_TEST_RESULT()                                                     \
+    (printf("%s\n", sim_test_failures ? "FAILED" : "PASSED"),                 \
+     sim_test_failures ? 1 : 0)
+
+typedef struct {
+    const char   *name;
+    uint64_t      start_cycles;
+    uint64_t      start_ns;
+    Sim_BusStats  bus_start;
+    Sim_CpuStats  cpu_start;
+    Sim_BusStats *bus;
+} Sim_Bench;
+
+static inline void Sim_Bench_Begin(Sim_Bench *b, const char *name, Sim_BusStats *bus)
+{
+    b->name         = name;
+    b->bus          = bus;
+    b->bus_start    = bus ? *bus : (Sim_BusStats){0};
+    b->cpu_start    = *Sim_GetCpuStats();
+    b->start_cycles = Sim_Now();
+    b->start_ns     = Sim_HostNs();
+}
+
+/**
+ * @brief Print one benchmark line.
+ *        KB/s is payload over virtual time; cpu/B is blocking HAL cycles per
+ *        payload byte; host ns/B is the native cost of the code under test.
+ */
+static inline void Sim_Bench_End(Sim_Bench *b, uint64_t payload_bytes)
+{
+    uint64_t cycles  = Sim_Now() - b->start_cycles;
+    uint64_t host_ns = Sim_HostNs() - b->start_ns;
+    uint64_t blocking = 0, bus_cycles = 0, calls = 0;
+    const Sim_CpuStats *cpu = Sim_GetCpuStats();
+    double us = Sim_CyclesToUs(cycles);
+
+    if (b->bus) {
+        blocking   = b->bus->blocking_cycles - b->bus_start.blocking_cycles;
+        bus_cycles = b->bus->bus_cycles - b->bus_start.bus_cycles;
+        calls      = b->bus->calls - b->bus_start.calls;
+    }
+    if (payload_bytes == 0) payload_bytes = 1;
+
+    printf("BENCH %-28s %8llu B %10.1f us %9.1f KB/s  bus %5.1f%%  cpu/B %7.1f  calls %6llu  irq-off max %5llu cyc  host %6.1f ns/B\n",
+           b->name,
+           (unsigned long long)payload_bytes,
+           us,
+           us > 0 ? (double)payload_bytes / 1024.0 / (us / 1e6) : 0.0,
+           cycles ? 100.0 * (double)bus_cycles / (double)cycles : 0.0,
+           (double)blocking / (double)payload_bytes,
+           (unsigned long long)calls,
+           (unsigned long long)cpu->irq_off_max_cycles,
+           (double)host_ns / (double)payload_bytes);
+}
+
+#endif /* __SIM_TEST_H__ */
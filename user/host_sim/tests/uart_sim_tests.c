@@ -0,0 +1,418 @@
+/**
+ * @file uart_sim_tests.c
+ * @brief uart.c on the simulated USART: DMA RX ring, zero-copy RX, event RX, TX ring, TX descriptors,
+ *        error recovery
+ */
+
+#include "sim_test.h"
+#include "uart.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CH              0
+#define RX_DMA_SIZE     64
+#define RX_RING_SIZE    512
+#define TX_RING_SIZE    512
+
+static UART_HandleTypeDef huart1;
+static DMA_HandleTypeDef  hdma_rx;
+static DMA_HandleTypeDef  hdma_tx;
+
+static uint8_t rx_dma[RX_DMA_SIZE];
+static uint8_t rx_dma_zc[RX_RING_SIZE];
+static uint8_t rx_ring[RX_RING_SIZE];
+static uint8_t tx_ring[TX_RING_SIZE];
+
+static void setup_port(uint32_t baud)
+{
+    Sim_Reset();
+    memset(&huart1, 0, sizeof(huart1));
+    memset(&hdma_rx, 0, sizeof(hdma_rx));
+    memset(&hdma_tx, 0, sizeof(hdma_tx));
+    hdma_rx.Init.Mode = DMA_CIRCULAR;
+    huart1.Init.BaudRate = baud;
+    huart1.hdmarx = &hdma_rx;
+    huart1.hdmatx = &hdma_tx;
+    HAL_UART_Init(&huart1);
+}
+
+static void setup(uint32_t baud)
+{
+    setup_port(baud);
+    UART_Register(CH, &huart1, rx_dma, RX_DMA_SIZE, rx_ring, RX_RING_SIZE, tx_ring, TX_RING_SIZE);
+}
+
+static void setup_zero_copy(uint32_t baud)
+{
+    setup_port(baud);
+    UART_Register(CH, &huart1, rx_dma_zc, sizeof(rx_dma_zc), NULL, 0, tx_ring, TX_RING_SIZE);
+}
+
+static void test_rx_stream(void)
+{
+    enum { TOTAL = 8192 };
+    static uint8_t src[TOTAL], dst[TOTAL];
+    uint32_t got = 0;
+    Sim_Bench bench;
+
+    setup(921600);
+    for (uint32_t i = 0; i < TOTAL; i++) src[i] = (uint8_t)(i * 7 + 3);
+
+    Sim_Bench_Begin(&bench, "uart rx 921600 poll/100us", Sim_UART_Stats(&huart1));
+    Sim_UART_Inject(&huart1, src, TOTAL);
+    while (got < TOTAL && Sim_Now() < Sim_UsToCycles(1000000)) {
+        Sim_AdvanceUs(100);
+        got += UART_ReadBytes(CH, &dst[got], (uint16_t)(TOTAL - got));
+    }
+    Sim_Bench_End(&bench, got);
+
+    SIM_CHECK(got == TOTAL);
+    SIM_CHECK(memcmp(src, dst, TOTAL) == 0);
+    SIM_CHECK(UART_GetRxOverrunCount(CH) == 0);
+}
+
+static void test_rx_zero_copy(void)
+{
+    enum { TOTAL = 8192 };
+    static uint8_t src[TOTAL], dst[TOTAL];
+    const uint8_t *span;
+    uint32_t got = 0;
+    uint32_t spans = 0;
+    Sim_Bench bench;
+
+    setup_zero_copy(3000000);
+    for (uint32_t i = 0; i < TOTAL; i++) src[i] = (uint8_t)(i * 5 + 1);
+
+    Sim_Bench_Begin(&bench, "uart rx 3M zero-copy spans/100us", Sim_UART_Stats(&huart1));
+    Sim_UART_Inject(&huart1, src, TOTAL);
+    while (got < TOTAL && Sim_Now() < Sim_UsToCycles(1000000)) {
+        Sim_AdvanceUs(100);
+        uint16_t n;
+        while (got < TOTAL && (n = UART_PeekLinear(CH, &span)) > 0) {
+            if (n > TOTAL - got) n = (uint16_t)(TOTAL - got);
+            SIM_CHECK(span >= rx_dma_zc && span + n <= rx_dma_zc + sizeof(rx_dma_zc));
+            memcpy(&dst[got], span, n);   // Stands in for an in-place parser
+            got += UART_Skip(CH, n);
+            spans++;
+        }
+    }
+    Sim_Bench_End(&bench, got);
+
+    SIM_CHECK(got == TOTAL);
+    SIM_CHECK(memcmp(src, dst, TOTAL) == 0);
+    SIM_CHECK(spans > TOTAL / sizeof(rx_dma_zc));
+    SIM_CHECK(UART_GetRxOverrunCount(CH) == 0);
+
+    // ReadBytes works on the same ring
+    Sim_UART_Inject(&huart1, src, 100);
+    Sim_AdvanceUs(1000);
+    SIM_CHECK(UART_Available(CH) == 100);
+    SIM_CHECK(UART_ReadBytes(CH, dst, 100) == 100);
+    SIM_CHECK(memcmp(src, dst, 100) == 0);
+}
+
+static void test_rx_zero_copy_overrun(void)
+{
+    static uint8_t src[600];
+    uint8_t byte;
+
+    setup_zero_copy(3000000);
+    for (uint32_t i = 0; i < sizeof(src); i++) src[i] = (uint8_t)i;
+
+    // Unread data, then enough to wrap past the read index: detected, ring resynced
+    Sim_UART_Inject(&huart1, src, 400);
+    Sim_AdvanceUs(2000);
+    SIM_CHECK(UART_Available(CH) == 400);
+    Sim_UART_Inject(&huart1, &src[400], 200);
+    Sim_AdvanceUs(2000);
+    SIM_CHECK(UART_Available(CH) == 0);
+    SIM_CHECK(UART_GetRxOverrunCount(CH) == 600);   // Every byte the reader lost
+
+    Sim_UART_Inject(&huart1, (const uint8_t *)"Z", 1);
+    Sim_AdvanceUs(100);
+    SIM_CHECK(UART_Read(CH, &byte) && byte == 'Z');
+}
+
+static uint64_t rx_cb_time;
+static uint32_t rx_cb_count;
+
+static void on_rx(UART_Channel ch)
+{
+    (void)ch;
+    if (rx_cb_count++ == 0) rx_cb_time = Sim_Now();
+    SIM_CHECK(Sim_InIsr());
+}
+
+static void test_rx_event_latency(void)
+{
+    const uint8_t frame[8] = { 0x01, 0x03, 0x00, 0x10, 0x00, 0x02, 0xC5, 0xCE };
+    uint8_t buf[16];
+    uint64_t last_byte;
+    double latency_us;
+
+    setup(115200);
+    SIM_CHECK(UART_SetRxEventMode(CH, true));
+    UART_SetRxCallback(CH, on_rx);
+    rx_cb_count = 0;
+
+    Sim_AdvanceUs(500);
+    last_byte = Sim_Now() + sizeof(frame) * Sim_UART_CharCycles(&huart1);
+    Sim_UART_Inject(&huart1, frame, sizeof(frame));
+    Sim_AdvanceUs(5000);    // No UART_Poll: the idle interrupt delivers the frame
+
+    latency_us = Sim_CyclesToUs(rx_cb_time - last_byte);
+    printf("BENCH uart rx event frame-to-handler latency %.1f us (115200)\n", latency_us);
+    SIM_CHECK(rx_cb_count == 1);
+    SIM_CHECK(latency_us < 100.0);
+    SIM_CHECK(UART_ReadBytes(CH, buf, sizeof(buf)) == sizeof(frame));
+    SIM_CHECK(memcmp(buf, frame, sizeof(frame)) == 0);
+    UART_SetRxCallback(CH, NULL);
+}
+
+static void test_rx_event_stream(void)
+{
+    enum { TOTAL = 8192 };
+    static uint8_t src[TOTAL], dst[TOTAL];
+    const uint8_t *span;
+    uint32_t got = 0;
+    Sim_Bench bench;
+
+    // Zero-copy ring filled from HT/TC/IDLE interrupts, consumer every 100 us
+    setup_zero_copy(3000000);
+    SIM_CHECK(UART_SetRxEventMode(CH, true));
+    for (uint32_t i = 0; i < TOTAL; i++) src[i] = (uint8_t)(i * 11 + 5);
+
+    Sim_Bench_Begin(&bench, "uart rx 3M event zero-copy", Sim_UART_Stats(&huart1));
+    Sim_UART_Inject(&huart1, src, TOTAL);
+    while (got < TOTAL && Sim_Now() < Sim_UsToCycles(1000000)) {
+        Sim_AdvanceUs(100);
+        uint16_t n;
+        while (got < TOTAL && (n = UART_PeekLinear(CH, &span)) > 0) {
+            if (n > TOTAL - got) n = (uint16_t)(TOTAL - got);
+            memcpy(&dst[got], span, n);
+            got += UART_Skip(CH, n);
+        }
+    }
+    Sim_Bench_End(&bench, got);
+
+    SIM_CHECK(got == TOTAL);
+    SIM_CHECK(memcmp(src, dst, TOTAL) == 0);
+    SIM_CHECK(UART_GetRxOverrunCount(CH) == 0);
+    SIM_CHECK(Sim_GetCpuStats()->isr_count > TOTAL / (sizeof(rx_dma_zc) / 2));
+}
+
+static int rx_nest_depth, rx_nest_max, rx_nest_calls;
+static uint32_t rx_nest_got;
+static uint8_t rx_nest_buf[32];
+
+static void on_rx_nest(UART_Channel ch)
+{
+    const uint8_t *span;
+    uint16_t n;
+
+    if (++rx_nest_depth > rx_nest_max) rx_nest_max = rx_nest_depth;
+    SIM_CHECK(__get_PRIMASK() == 0);
+    while ((n = UART_PeekLinear(ch, &span)) > 0 && rx_nest_got + n <= sizeof(rx_nest_buf)) {
+        memcpy(&rx_nest_buf[rx_nest_got], span, n);
+        rx_nest_got += UART_Skip(ch, n);
+    }
+    // Long handler: the rest of the frame and its IDLE interrupt arrive meanwhile
+    if (rx_nest_calls++ == 0) Sim_AdvanceUs(3000);
+    rx_nest_depth--;
+}
+
+static void test_rx_poll_callback(void)
+{
+    uint8_t frame[16];
+
+    // UART_PollRx runs the callback unmasked; the RX event during it must not nest it
+    setup_zero_copy(115200);
+    SIM_CHECK(UART_SetRxEventMode(CH, true));
+    UART_SetRxCallback(CH, on_rx_nest);
+    for (uint32_t i = 0; i < sizeof(frame); i++) frame[i] = (uint8_t)(0xA0 + i);
+    rx_nest_depth = rx_nest_max = rx_nest_calls = 0;
+    rx_nest_got = 0;
+
+    Sim_UART_Inject(&huart1, frame, sizeof(frame));
+    Sim_AdvanceUs(500);     // Part of the frame is in the DMA buffer, no event yet
+    UART_PollRx(CH);
+
+    SIM_CHECK(rx_nest_max == 1);
+    SIM_CHECK(rx_nest_calls == 2);  // Run again for the data the interrupt took in
+    SIM_CHECK(rx_nest_got == sizeof(frame));
+    SIM_CHECK(memcmp(rx_nest_buf, frame, sizeof(frame)) == 0);
+    UART_SetRxCallback(CH, NULL);
+}
+
+static void test_tx_stream(void)
+{
+    enum { TOTAL = 4096, CHUNK = 48 };
+    static uint8_t src[TOTAL], out[TOTAL];
+    uint32_t sent = 0;
+    Sim_Bench bench;
+
+    setup(921600);
+    for (uint32_t i = 0; i < TOTAL; i++) src[i] = (uint8_t)(i ^ 0x5A);
+
+    Sim_Bench_Begin(&bench, "uart tx 921600 48B writes", Sim_UART_Stats(&huart1));
+    while (sent < TOTAL) {
+        uint16_t n = (TOTAL - sent < CHUNK) ? (uint16_t)(TOTAL - sent) : CHUNK;
+        if (UART_GetTxFree(CH) >= n) {
+            SIM_CHECK(UART_Send(CH, &src[sent], n));
+            sent += n;
+        } else {
+            Sim_AdvanceUs(50);
+        }
+    }
+    while (UART_IsTxBusy(CH)) {
+        Sim_AdvanceUs(50);
+    }
+    Sim_Bench_End(&bench, TOTAL);
+
+    SIM_CHECK(Sim_UART_TakeTx(&huart1, out, TOTAL) == TOTAL);
+    SIM_CHECK(memcmp(src, out, TOTAL) == 0);
+    SIM_CHECK(UART_GetTxDropCount(CH) == 0);
+}
+
+static uint32_t       released;
+static const uint8_t *released_last;
+
+static void on_release(UART_Channel ch, const uint8_t *data, uint16_t len)
+{
+    (void)ch;
+    (void)len;
+    released++;
+    released_last = data;
+}
+
+static void test_tx_ref(void)
+{
+    enum { FRAMES = 64, FRAME = 128, POOL = 3 };   // 2 descriptors per frame
+    static uint8_t pool[POOL][FRAME];
+    static uint8_t expect[FRAMES * (FRAME + 4)], out[sizeof(expect)];
+    uint32_t exp_len = 0;
+    Sim_Bench bench;
+
+    setup(3000000);
+    released = 0;
+
+    Sim_Bench_Begin(&bench, "uart tx 3M SendRef 128B + 4B hdr", Sim_UART_Stats(&huart1));
+    for (uint32_t f = 0; f < FRAMES; f++) {
+        uint8_t *buf = pool[f % POOL];
+        uint8_t hdr[4] = { '#', (uint8_t)f, (uint8_t)(f >> 8), ':' };
+
+        // Wait until the pool slot has been released
+        while (f >= POOL && released < f - POOL + 1) {
+            Sim_AdvanceUs(10);
+        }
+        for (uint32_t i = 0; i < FRAME; i++) buf[i] = (uint8_t)(f + i);
+
+        SIM_CHECK(UART_Send(CH, hdr, sizeof(hdr)));              // Small: ring copy
+        SIM_CHECK(UART_SendRef(CH, buf, FRAME, on_release));     // Large: DMA from pool
+        memcpy(&expect[exp_len], hdr, sizeof(hdr));
+        memcpy(&expect[exp_len + sizeof(hdr)], buf, FRAME);
+        exp_len += sizeof(hdr) + FRAME;
+    }
+    while (UART_IsTxBusy(CH)) {
+        Sim_AdvanceUs(10);
+    }
+    Sim_Bench_End(&bench, exp_len);
+
+    SIM_CHECK(released == FRAMES);
+    SIM_CHECK(released_last == pool[(FRAMES - 1) % POOL]);
+    SIM_CHECK(Sim_UART_TakeTx(&huart1, out, sizeof(out)) == exp_len);
+    SIM_CHECK(memcmp(expect, out, exp_len) == 0);
+    SIM_CHECK(UART_GetTxDropCount(CH) == 0);
+}
+
+static void test_tx_ref_small_and_abort(void)
+{
+    static const uint8_t big[64] = "referenced-buffer-that-is-aborted";
+    const uint8_t small[] = "tiny";
+
+    setup(115200);
+    released = 0;
+
+    // Below UART_TX_REF_MIN: copied and released at once
+    SIM_CHECK(UART_SendRef(CH, small, sizeof(small) - 1, on_release));
+    SIM_CHECK(released == 1);
+
+    // Queued behind it, then aborted: still released exactly once
+    SIM_CHECK(UART_SendRef(CH, big, sizeof(big), on_release));
+    UART_AbortTx(CH);
+    SIM_CHECK(released == 2 && released_last == big);
+    SIM_CHECK(!UART_IsTxBusy(CH));
+
+    // Queue full: rejected, not released
+    for (int i = 0; i < UART_TX_DESC_MAX - 1; i++) {
+        SIM_CHECK(UART_SendRef(CH, big, sizeof(big), on_release));
+    }
+    SIM_CHECK(!UART_SendRef(CH, big, sizeof(big), on_release));
+    while (UART_IsTxBusy(CH)) {
+        Sim_AdvanceUs(100);
+    }
+    SIM_CHECK(released == 2 + UART_TX_DESC_MAX - 1);
+}
+
+static void test_tx_ref_ring_full(void)
+{
+    static uint8_t fill[TX_RING_SIZE - 5], out[TX_RING_SIZE + 16];
+    const uint8_t small[] = "0123456789";
+
+    setup(115200);
+    released = 0;
+    memset(fill, 'f', sizeof(fill));
+
+    // 4 bytes left in the ring: a small write does not fit and goes by
+    // reference instead of being queued in part
+    SIM_CHECK(UART_Send(CH, fill, sizeof(fill)));
+    SIM_CHECK(UART_GetTxFree(CH) == 4);
+    SIM_CHECK(UART_SendRef(CH, small, sizeof(small) - 1, on_release));
+    SIM_CHECK(released == 0);
+    SIM_CHECK(UART_GetTxDropCount(CH) == 0);
+
+    // Referenced bytes count as pending until they are sent
+    SIM_CHECK(UART_GetTxPending(CH) == sizeof(fill) + sizeof(small) - 1);
+    while (UART_IsTxBusy(CH)) {
+        Sim_AdvanceUs(100);
+    }
+    SIM_CHECK(UART_GetTxPending(CH) == 0);
+    SIM_CHECK(released == 1 && released_last == small);
+    SIM_CHECK(Sim_UART_TakeTx(&huart1, out, sizeof(out)) == sizeof(fill) + sizeof(small) - 1);
+    SIM_CHECK(memcmp(out, fill, sizeof(fill)) == 0);
+    SIM_CHECK(memcmp(&out[sizeof(fill)], small, sizeof(small) - 1) == 0);
+}
+
+static void test_error_recovery(void)
+{
+    const uint8_t msg[] = "after-error";
+    uint8_t buf[32] = {0};
+    uint16_t n;
+
+    setup(115200);
+    Sim_UART_RaiseError(&huart1, HAL_UART_ERROR_ORE);
+    SIM_CHECK(UART_GetOREErrorCount(CH) == 1);
+    SIM_CHECK(huart1.RxState == HAL_UART_STATE_BUSY_RX);
+
+    Sim_UART_Inject(&huart1, msg, sizeof(msg) - 1);
+    Sim_AdvanceUs(2000);
+    n = UART_ReadBytes(CH, buf, sizeof(buf));
+    SIM_CHECK(n == sizeof(msg) - 1);
+    SIM_CHECK(memcmp(buf, msg, n) == 0);
+}
+
+int main(void)
+{
+    test_rx_stream();
+    test_rx_zero_copy();
+    test_rx_zero_copy_overrun();
+    test_rx_event_latency();
+    test_rx_event_stream();
+    test_rx_poll_callback();
+    test_tx_stream();
+    test_tx_ref();
+    test_tx_ref_small_and_abort();
+    test_tx_ref_ring_full();
+    test_error_recovery();
+    return SIM_TEST_RESULT();
+}
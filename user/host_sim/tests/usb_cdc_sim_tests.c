@@ -0,0 +1,281 @@
+/**
+ * @file usb_cdc_sim_tests.c
+ * @brief usb_cdc.c on a simulated full-speed link: packet RX queue with
+ *        host flow control, coalescing TX ring kicked from TX complete,
+ *        ZLP after n*64-byte transfers, Poll fallback, sends from an ISR,
+ *        telemetry vs one CDC_Transmit_FS per write
+ */
+
+#include "sim_test.h"
+#include "sim_usb.h"
+#include "usb_cdc.h"
+#include <string.h>
+
+#define TELEMETRY_BYTES   (300U * 1024U)
+#define RECORD_LEN        20U
+#define RECORD_PERIOD_US  25U      // 800 KB/s of 20-byte records
+
+static TIM_HandleTypeDef htim6;
+static TIM_TypeDef       tim6;
+static bool              tx_hook = true;
+static bool              tick_send;
+static bool              tick_send_ok;
+static uint8_t           host_rx[TELEMETRY_BYTES + 4096];
+static uint8_t           records_src[TELEMETRY_BYTES];
+static uint32_t          host_len;
+
+// usbd_cdc_if.c user code, as in the README
+int8_t CDC_Receive_FS(uint8_t *Buf, uint32_t *Len)
+{
+    USB_CDC_RxCallback(Buf, *Len);
+    return USBD_OK;
+}
+
+int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+    (void)Buf;
+    (void)Len;
+    (void)epnum;
+    if (tx_hook) USB_CDC_TxCpltCallback();
+    return USBD_OK;
+}
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    static const uint8_t big[USB_TX_BUF_SIZE + 1];
+
+    if (htim != &htim6) return;
+    if (!tx_hook) USB_CDC_Poll();
+    if (tick_send) {
+        tick_send = false;
+        // Larger than the ring: refused whole, never partly queued
+        SIM_CHECK(!USB_CDC_Send(big, sizeof(big)));
+        tick_send_ok = USB_CDC_Send((const uint8_t *)"isr\n", 4);
+    }
+}
+
+static void host_sink(void *ctx, const uint8_t *data, uint32_t len)
+{
+    (void)ctx;
+    if (host_len + len <= sizeof(host_rx)) memcpy(&host_rx[host_len], data, len);
+    host_len += len;
+}
+
+static void settle(uint32_t ms)
+{
+    Sim_AdvanceUs(ms * 1000U);
+}
+
+static void make_record(uint8_t *rec, uint32_t seq)
+{
+    for (uint32_t i = 0; i < RECORD_LEN; i++) rec[i] = (uint8_t)(seq * 7U + i);
+}
+
+static bool host_records_ok(uint32_t records)
+{
+    uint8_t rec[RECORD_LEN];
+
+    if (host_len != records * RECORD_LEN) return false;
+    for (uint32_t s = 0; s < records; s++) {
+        make_record(rec, s);
+        if (memcmp(&host_rx[s * RECORD_LEN], rec, RECORD_LEN) != 0) return false;
+    }
+    return true;
+}
+
+static void test_rx_flow_control(void)
+{
+    static uint8_t sent[2000], got[2000];
+    const uint8_t *p;
+    uint32_t n = 0, packets;
+
+    for (uint32_t i = 0; i < sizeof(sent); i++) sent[i] = (uint8_t)(i * 13U + 5U);
+    SIM_CHECK(Sim_USB_HostWrite(sent, sizeof(sent)) == sizeof(sent));
+
+    // Application not reading: the queue fills and the host is NAKed, nothing lost
+    settle(20);
+    SIM_CHECK(Sim_USB_GetStats()->out_packets == USB_CDC_RX_PACKETS);
+    SIM_CHECK(Sim_USB_GetStats()->out_naks > 0);
+    SIM_CHECK(USB_CDC_Available() == USB_CDC_RX_PACKETS * USB_CDC_PACKET_SIZE);
+    SIM_CHECK(USB_CDC_GetRxOverrunCount() == 0);
+
+    // Packets are handed over in place, one whole packet per peek
+    SIM_CHECK(USB_CDC_PeekPacket(&p) == USB_CDC_PACKET_SIZE);
+    SIM_CHECK(memcmp(p, sent, USB_CDC_PACKET_SIZE) == 0);
+
+    while (n < sizeof(got)) {
+        uint32_t avail = USB_CDC_PeekPacket(&p);
+
+        if (avail == 0) {
+            settle(1);
+            continue;
+        }
+        // Mix of block and byte reads
+        if ((n / USB_CDC_PACKET_SIZE) % 2) {
+            SIM_CHECK(USB_CDC_Read(&got[n]));
+            n++;
+        } else {
+            memcpy(&got[n], p, avail);
+            n += USB_CDC_Skip(avail);
+        }
+    }
+    packets = (uint32_t)Sim_USB_GetStats()->out_packets;
+    SIM_CHECK(memcmp(sent, got, sizeof(sent)) == 0);
+    SIM_CHECK(packets == (sizeof(sent) + USB_CDC_PACKET_SIZE - 1) / USB_CDC_PACKET_SIZE);
+    SIM_CHECK(USB_CDC_Available() == 0);
+
+    // Flush drops what is queued and keeps receiving
+    Sim_USB_HostWrite(sent, 100);
+    settle(2);
+    SIM_CHECK(USB_CDC_Available() == 100);
+    USB_CDC_Flush();
+    SIM_CHECK(USB_CDC_Available() == 0);
+    Sim_USB_HostWrite(sent, 10);
+    settle(2);
+    SIM_CHECK(USB_CDC_ReadBytes(got, sizeof(got)) == 10 && memcmp(got, sent, 10) == 0);
+}
+
+static void test_zlp(void)
+{
+    static uint8_t block[128];
+
+    for (uint32_t i = 0; i < sizeof(block); i++) block[i] = (uint8_t)i;
+    host_len = 0;
+    SIM_CHECK(USB_CDC_Send(block, sizeof(block)));
+    settle(5);
+
+    // 128 bytes is two full packets: without the ZLP the host would still be
+    // waiting. The class sends it; the driver must not add a second one
+    SIM_CHECK(Sim_USB_GetStats()->in_zlps == 1);
+    SIM_CHECK(Sim_USB_HostHeld() == 0);
+    SIM_CHECK(host_len == sizeof(block) && memcmp(host_rx, block, sizeof(block)) == 0);
+
+    // A short transfer needs none
+    SIM_CHECK(USB_CDC_Send(block, 10));
+    settle(5);
+    SIM_CHECK(Sim_USB_GetStats()->in_zlps == 1 && host_len == sizeof(block) + 10);
+}
+
+// Old driver: one CDC_Transmit_FS per write, spinning while the endpoint is busy.
+// The endpoint reads the caller's buffer until the transfer ends, so each record
+// gets its own storage here (a reused buffer would be overwritten in flight).
+static bool legacy_send(const uint8_t *data, uint32_t len)
+{
+    uint32_t start = HAL_GetTick();
+
+    while (CDC_Transmit_FS((uint8_t *)data, (uint16_t)len) == USBD_BUSY) {
+        if (HAL_GetTick() - start > 50) return false;
+    }
+    return true;
+}
+
+static void telemetry(bool ring, double *blocked_pct, double *kbps, double *bytes_per_transfer)
+{
+    uint32_t records = TELEMETRY_BYTES / RECORD_LEN;
+    uint64_t t0, blocked = 0, next;
+    uint64_t transfers0 = Sim_USB_GetStats()->in_transfers;
+    bool ok = true;
+
+    host_len = 0;
+    t0 = Sim_Now();
+    next = t0;
+    for (uint32_t s = 0; s < records; s++) {
+        uint8_t *rec = &records_src[s * RECORD_LEN];
+        uint64_t c0;
+
+        // Producer: one record every RECORD_PERIOD_US, doing other work in between
+        if (Sim_Now() < next) Sim_Advance(next - Sim_Now());
+        next += Sim_UsToCycles(RECORD_PERIOD_US);
+
+        make_record(rec, s);
+        c0 = Sim_Now();
+        ok &= ring ? USB_CDC_Send(rec, RECORD_LEN) : legacy_send(rec, RECORD_LEN);
+        blocked += Sim_Now() - c0;
+    }
+    while (host_len < records * RECORD_LEN && Sim_Now() - t0 < Sim_UsToCycles(5000000)) settle(1);
+
+    SIM_CHECK(ok);
+    SIM_CHECK(host_records_ok(records));
+    *blocked_pct = 100.0 * (double)blocked / (double)(Sim_Now() - t0);
+    *kbps = (double)TELEMETRY_BYTES / 1024.0 / (Sim_CyclesToUs(Sim_Now() - t0) / 1e6);
+    *bytes_per_transfer = (double)TELEMETRY_BYTES /
+                          (double)(Sim_USB_GetStats()->in_transfers - transfers0);
+}
+
+static void test_telemetry(void)
+{
+    double ring_blocked, ring_kbps, ring_bpt;
+    double old_blocked, old_kbps, old_bpt;
+
+    telemetry(false, &old_blocked, &old_kbps, &old_bpt);
+    telemetry(true, &ring_blocked, &ring_kbps, &ring_bpt);
+
+    printf("BENCH usb_cdc telemetry one transfer per write  %6.1f KB/s  caller blocked %5.1f%%  %6.1f B/transfer\n",
+           old_kbps, old_blocked, old_bpt);
+    printf("BENCH usb_cdc telemetry coalescing TX ring      %6.1f KB/s  caller blocked %5.1f%%  %6.1f B/transfer\n",
+           ring_kbps, ring_blocked, ring_bpt);
+
+    SIM_CHECK(ring_blocked < 1.0);
+    SIM_CHECK(ring_bpt > 2 * RECORD_LEN);
+    SIM_CHECK(ring_kbps > 700.0);
+    SIM_CHECK(ring_kbps > 1.5 * old_kbps);
+    SIM_CHECK(USB_CDC_GetTxDropCount() == 0);
+    SIM_CHECK(Sim_USB_HostHeld() == 0);
+}
+
+static void test_poll_and_isr(void)
+{
+    static const uint8_t msg[] = "polled completion\n";
+
+    // No CDC_TransmitCplt_FS hook: USB_CDC_Poll from the tick finishes transfers
+    tx_hook = false;
+    host_len = 0;
+    for (int i = 0; i < 50; i++) SIM_CHECK(USB_CDC_Send(msg, sizeof(msg) - 1));
+    settle(20);
+    SIM_CHECK(host_len == 50 * (sizeof(msg) - 1));
+    tx_hook = true;
+
+    // No hook and no poll: each send finishes the transfer before it
+    tx_hook = false;
+    HAL_TIM_Base_Stop_IT(&htim6);
+    host_len = 0;
+    for (int i = 0; i < 5; i++) {
+        SIM_CHECK(USB_CDC_Send(msg, sizeof(msg) - 1));
+        settle(2);
+    }
+    SIM_CHECK(host_len == 5 * (sizeof(msg) - 1));
+    HAL_TIM_Base_Start_IT(&htim6);
+    tx_hook = true;
+
+        // From an ISR: all or nothing
+    host_len = 0;
+    tick_send = true;
+    settle(5);
+    SIM_CHECK(tick_send_ok);
+    SIM_CHECK(USB_CDC_GetTxDropCount() == USB_TX_BUF_SIZE + 1);
+    SIM_CHECK(host_len == 4 && memcmp(host_rx, "isr\n", 4) == 0);
+
+    // Not enumerated: refused
+    Sim_USB_Disconnect();
+    SIM_CHECK(!USB_CDC_Send(msg, 4));
+}
+
+int main(void)
+{
+    Sim_Reset();
+    Sim_USB_SetHostSink(host_sink, NULL);
+    Sim_USB_Connect();
+    USB_CDC_Init();
+
+    htim6.Instance = &tim6;
+    htim6.Init.Prescaler = 71;
+    htim6.Init.Period = 999;
+    HAL_TIM_Base_Start_IT(&htim6);
+
+    test_rx_flow_control();
+    test_zlp();
+    test_telemetry();
+    test_poll_and_isr();
+
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,340 @@
+/**
+ * @file w25qxx_sim_tests.c
+ * @brief w25qxx.c against the simulated W25Q64: identify, erase, program, read,
+ *        DMA reads, 4-byte addressing on a W25Q256, background program/erase
+ *        with suspend/resume, reads a suspend cannot serve
+ */
+
+#include "sim_test.h"
+#include "sim_w25q.h"
+#include "w25qxx.h"
+#include <string.h>
+
+static SPI_HandleTypeDef    hspi1;
+static DMA_HandleTypeDef    hdma_spi1_rx, hdma_spi1_tx;
+static Sim_W25Q             flash;
+static W25QXX_HandleTypeDef hflash;
+static uint8_t              big_src[70000], big_dst[70000];
+
+static volatile uint32_t    done_calls;
+static volatile bool        done_ok;
+
+static void on_read_done(void *ctx, bool ok)
+{
+    (void)ctx;
+    done_calls++;
+    done_ok = ok;
+}
+
+static void test_identify(void)
+{
+    SIM_CHECK(W25QXX_Init(&hflash, &hspi1, GPIOB, GPIO_PIN_12) == 1);
+    SIM_CHECK(hflash.Info.ID == W25Q64);
+    SIM_CHECK(hflash.Info.SectorCount == 2048);
+}
+
+static void test_program_read(void)
+{
+    enum { LEN = 4096 };
+    static uint8_t src[LEN], dst[LEN];
+    Sim_Bench bench;
+
+    for (uint32_t i = 0; i < LEN; i++) src[i] = (uint8_t)(i * 13);
+
+    Sim_Bench_Begin(&bench, "w25q erase 4K", Sim_SPI_Stats(&hspi1));
+    W25QXX_Erase_Sector(&hflash, 0x10000);
+    Sim_Bench_End(&bench, LEN);
+    SIM_CHECK(flash.stats.erases_4k == 1);
+
+    Sim_Bench_Begin(&bench, "w25q program 4K", Sim_SPI_Stats(&hspi1));
+    W25QXX_Write(&hflash, src, 0x10000, LEN);
+    Sim_Bench_End(&bench, LEN);
+    SIM_CHECK(flash.stats.programs == LEN / 256);
+    SIM_CHECK(memcmp(&flash.mem[0x10000], src, LEN) == 0);
+
+    Sim_Bench_Begin(&bench, "w25q read 4K", Sim_SPI_Stats(&hspi1));
+    W25QXX_Read(&hflash, dst, 0x10000, LEN);
+    Sim_Bench_End(&bench, LEN);
+    SIM_CHECK(memcmp(src, dst, LEN) == 0);
+
+    SIM_CHECK(flash.stats.busy_violations == 0);
+    SIM_CHECK(flash.stats.wel_violations == 0);
+}
+
+static void test_unaligned_write(void)
+{
+    const uint8_t msg[] = "crosses-a-page-boundary";
+    uint8_t back[sizeof(msg)];
+
+    W25QXX_Erase_Sector(&hflash, 0x20000);
+    W25QXX_Write(&hflash, (uint8_t *)msg, 0x20000 + 250, sizeof(msg));
+    W25QXX_Read(&hflash, back, 0x20000 + 250, sizeof(msg));
+    SIM_CHECK(memcmp(msg, back, sizeof(msg)) == 0);
+}
+
+static void test_dma_read(void)
+{
+    enum { LEN = 4096 };
+    static uint8_t dst[LEN];
+    Sim_Bench bench;
+    uint64_t t0, t_return;
+
+    hspi1.hdmarx = &hdma_spi1_rx;
+    hspi1.hdmatx = &hdma_spi1_tx;
+    SIM_CHECK(W25QXX_Init(&hflash, &hspi1, GPIOB, GPIO_PIN_12) == 1);
+    SIM_CHECK(hflash.UseDMA == 1);
+
+    Sim_Bench_Begin(&bench, "w25q dma read 4K", Sim_SPI_Stats(&hspi1));
+    W25QXX_Read(&hflash, dst, 0x10000, LEN);
+    Sim_Bench_End(&bench, LEN);
+    SIM_CHECK(memcmp(&flash.mem[0x10000], dst, LEN) == 0);
+
+    // Async: the call returns after the header, the callback reports the end
+    memset(dst, 0, LEN);
+    done_calls = 0;
+    t0 = Sim_Now();
+    SIM_CHECK(W25QXX_ReadDMA(&hflash, dst, 0x10000, LEN, on_read_done, NULL) == 1);
+    t_return = Sim_Now();
+    SIM_CHECK(W25QXX_IsBusy(&hflash));
+    W25QXX_Wait(&hflash);
+    printf("BENCH %-28s CPU blocked %.1f us of %.1f us\n", "w25q dma read 4K async",
+           Sim_CyclesToUs(t_return - t0), Sim_CyclesToUs(Sim_Now() - t0));
+    SIM_CHECK(done_calls == 1 && done_ok);
+    SIM_CHECK(memcmp(&flash.mem[0x10000], dst, LEN) == 0);
+
+    // Longer than one HAL DMA transfer: chained chunks under one CS window
+    for (uint32_t i = 0; i < sizeof(big_src); i++) big_src[i] = (uint8_t)(i * 7 + (i >> 8));
+    memcpy(&flash.mem[0x100000], big_src, sizeof(big_src));
+    Sim_Bench_Begin(&bench, "w25q dma read 70000", Sim_SPI_Stats(&hspi1));
+    W25QXX_Read(&hflash, big_dst, 0x100000, sizeof(big_dst));
+    Sim_Bench_End(&bench, sizeof(big_dst));
+    SIM_CHECK(memcmp(big_src, big_dst, sizeof(big_dst)) == 0);
+
+    // Commands issued while a read is in flight wait for it
+    SIM_CHECK(W25QXX_ReadDMA(&hflash, big_dst, 0x100000, sizeof(big_dst), NULL, NULL) == 1);
+    W25QXX_Erase_Sector(&hflash, 0x30000);
+    SIM_CHECK(memcmp(big_src, big_dst, sizeof(big_dst)) == 0);
+    SIM_CHECK(flash.stats.busy_violations == 0);
+    SIM_CHECK(hflash.Errors == 0);
+}
+
+static volatile uint32_t op_done;
+
+static void on_op_done(void *ctx, bool ok)
+{
+    (void)ctx;
+    if (ok) op_done++;
+}
+
+// 1 kHz control loop: run Poll once per tick, track the longest time it held the CPU
+static uint64_t run_loop_until_done(uint32_t *ticks)
+{
+    uint64_t worst = 0;
+
+    *ticks = 0;
+    for (;;) {
+        uint64_t t0 = Sim_Now();
+        uint8_t pending = W25QXX_Poll(&hflash);
+        uint64_t spent = Sim_Now() - t0;
+
+        if (spent > worst) worst = spent;
+        if (!pending) break;
+        Sim_AdvanceUs(1000);
+        (*ticks)++;
+    }
+    return worst;
+}
+
+static void test_async_erase_program(void)
+{
+    enum { LEN = 4096 };
+    static uint8_t src[LEN], dst[LEN];
+    uint64_t t0, stall, worst;
+    uint32_t ticks;
+
+    // Blocking erase: the caller is stuck for the whole tSE
+    t0 = Sim_Now();
+    W25QXX_Erase_Sector(&hflash, 0x40000);
+    stall = Sim_Now() - t0;
+
+    // Background erase: each Poll is a single status read
+    op_done = 0;
+    t0 = Sim_Now();
+    SIM_CHECK(W25QXX_EraseSectorAsync(&hflash, 0x41000, on_op_done, NULL) == 1);
+    SIM_CHECK(W25QXX_EraseSectorAsync(&hflash, 0x42000, on_op_done, NULL) == 0);
+    worst = run_loop_until_done(&ticks);
+    printf("BENCH %-28s blocking stall %.1f us, async worst poll %.1f us over %lu ticks\n",
+           "w25q erase 4K", Sim_CyclesToUs(stall), Sim_CyclesToUs(worst), (unsigned long)ticks);
+    SIM_CHECK(op_done == 1);
+    SIM_CHECK(worst * 100 < stall);
+    SIM_CHECK(flash.mem[0x41000] == 0xFF);
+
+    // Background program: one page per Poll once the previous one is done
+    for (uint32_t i = 0; i < LEN; i++) src[i] = (uint8_t)(i * 31 + 5);
+    SIM_CHECK(W25QXX_WriteAsync(&hflash, src, 0x41000 + 100, LEN - 100, on_op_done, NULL) == 1);
+    worst = run_loop_until_done(&ticks);
+    printf("BENCH %-28s async worst poll %.1f us over %lu ticks\n", "w25q program 4K",
+           Sim_CyclesToUs(worst), (unsigned long)ticks);
+    SIM_CHECK(op_done == 2);
+    SIM_CHECK(memcmp(&flash.mem[0x41000 + 100], src, LEN - 100) == 0);
+
+    W25QXX_Read(&hflash, dst, 0x41000 + 100, LEN - 100);
+    SIM_CHECK(memcmp(dst, src, LEN - 100) == 0);
+    SIM_CHECK(flash.stats.busy_violations == 0);
+    SIM_CHECK(flash.stats.wel_violations == 0);
+}
+
+static void test_suspend_resume(void)
+{
+    static uint8_t dst[256];
+    uint64_t t0, latency, erase_start;
+    uint32_t ticks;
+
+    memset(&flash.mem[0x10000], 0x5A, sizeof(dst));
+
+    // A 64 KB erase is running when an urgent read comes in
+    op_done = 0;
+    erase_start = Sim_Now();
+    SIM_CHECK(W25QXX_EraseBlockAsync(&hflash, 0x50000, on_op_done, NULL) == 1);
+    Sim_AdvanceUs(20000);
+    SIM_CHECK(W25QXX_Poll(&hflash) == 1);
+
+    t0 = Sim_Now();
+    W25QXX_Read(&hflash, dst, 0x10000, sizeof(dst));
+    latency = Sim_Now() - t0;
+    printf("BENCH %-28s read 256 B in %.1f us during a 64K erase\n", "w25q suspend/resume",
+           Sim_CyclesToUs(latency));
+    SIM_CHECK(dst[0] == 0x5A && dst[255] == 0x5A);
+    SIM_CHECK(flash.stats.suspends == 1 && flash.stats.resumes == 1);
+    SIM_CHECK(latency < Sim_UsToCycles(500));
+
+    // Explicit suspend holds the erase until resumed
+    SIM_CHECK(W25QXX_Suspend(&hflash) == 1);
+    Sim_AdvanceUs(200000);
+    SIM_CHECK(W25QXX_Poll(&hflash) == 1);
+    SIM_CHECK(op_done == 0);
+    W25QXX_Resume(&hflash);
+
+    run_loop_until_done(&ticks);
+    SIM_CHECK(op_done == 1);
+    // Finished, and the suspended stretch did not count towards tBE
+    SIM_CHECK(Sim_Now() - erase_start > Sim_UsToCycles(flash.t_be64_us + 200000));
+    SIM_CHECK(flash.stats.busy_violations == 0);
+
+    // A blocking erase while a background one is suspended finishes it first
+    SIM_CHECK(W25QXX_EraseSectorAsync(&hflash, 0x60000, on_op_done, NULL) == 1);
+    SIM_CHECK(W25QXX_Suspend(&hflash) == 1);
+    W25QXX_Erase_Sector(&hflash, 0x61000);
+    SIM_CHECK(op_done == 2);
+    SIM_CHECK(W25QXX_Poll(&hflash) == 0);
+    SIM_CHECK(flash.stats.busy_violations == 0);
+    SIM_CHECK(hflash.Errors == 0);
+}
+
+static void test_suspend_limits(void)
+{
+    static uint8_t dst[256];
+    Block_Device bd;
+    uint32_t ticks, errors;
+    uint8_t cmd = W25QXX_SUSPEND;
+
+    SIM_CHECK(W25QXX_BlockDev(&bd, &hflash) == BLOCK_DEV_OK);
+    memset(&flash.mem[0x10000], 0x5A, sizeof(dst));
+
+    // The sector a suspended erase is halfway through reads as an error,
+    // the rest of the chip as usual
+    op_done = 0;
+    SIM_CHECK(W25QXX_EraseSectorAsync(&hflash, 0x70000, on_op_done, NULL) == 1);
+    Sim_AdvanceUs(5000);
+    SIM_CHECK(W25QXX_Suspend(&hflash) == 1);
+    SIM_CHECK(W25QXX_Read(&hflash, dst, 0x70F00, sizeof(dst)) == 0);
+    SIM_CHECK(W25QXX_ReadDMA(&hflash, dst, 0x70000, sizeof(dst), on_read_done, NULL) == 0);
+    SIM_CHECK(BlockDev_Read(&bd, 0x70000, dst, sizeof(dst)) == BLOCK_DEV_ERR_IO);
+    SIM_CHECK(W25QXX_Read(&hflash, dst, 0x10000, sizeof(dst)) == 1);
+    SIM_CHECK(dst[0] == 0x5A && dst[255] == 0x5A);
+    W25QXX_Resume(&hflash);
+    run_loop_until_done(&ticks);
+    SIM_CHECK(op_done == 1);
+    SIM_CHECK(W25QXX_Read(&hflash, dst, 0x70F00, sizeof(dst)) == 1);
+    SIM_CHECK(dst[0] == 0xFF);
+
+    // A chip that takes too long to suspend: the read waits for the erase
+    // to end rather than reading a busy chip
+    errors = hflash.Errors;
+    flash.t_sus_us = 5000;
+    SIM_CHECK(W25QXX_EraseSectorAsync(&hflash, 0x71000, on_op_done, NULL) == 1);
+    Sim_AdvanceUs(1000);
+    memset(dst, 0, sizeof(dst));
+    SIM_CHECK(W25QXX_Read(&hflash, dst, 0x10000, sizeof(dst)) == 1);
+    SIM_CHECK(dst[0] == 0x5A && dst[255] == 0x5A);
+    SIM_CHECK(hflash.Errors == errors + 1);
+    flash.t_sus_us = 20;
+    run_loop_until_done(&ticks);
+    SIM_CHECK(op_done == 2);
+
+    // A chip erase cannot be suspended: reads fail until it is done
+    SIM_CHECK(W25QXX_EraseChipAsync(&hflash, on_op_done, NULL) == 1);
+    Sim_AdvanceUs(1000);
+    SIM_CHECK(W25QXX_Suspend(&hflash) == 0);
+    SIM_CHECK(W25QXX_Read(&hflash, dst, 0x10000, sizeof(dst)) == 0);
+    SIM_CHECK(BlockDev_Read(&bd, 0x10000, dst, sizeof(dst)) == BLOCK_DEV_ERR_IO);
+    SIM_CHECK(flash.stats.suspends_refused == 0);
+
+    // and the model ignores a raw 0x75 as the part does
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_RESET);
+    HAL_SPI_Transmit(&hspi1, &cmd, 1, 100);
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_SET);
+    SIM_CHECK(flash.stats.suspends_refused == 1);
+    SIM_CHECK(Sim_W25Q_IsBusy(&flash) && !(flash.sr2 & W25QXX_SR2_SUS));
+
+    run_loop_until_done(&ticks);
+    SIM_CHECK(op_done == 3);
+    SIM_CHECK(W25QXX_Read(&hflash, dst, 0x10000, sizeof(dst)) == 1);
+    SIM_CHECK(dst[0] == 0xFF && dst[255] == 0xFF);
+    SIM_CHECK(flash.stats.busy_violations == 0);
+}
+
+static void test_4byte_address(void)
+{
+    static SPI_HandleTypeDef hspi2;
+    static Sim_W25Q big;
+    static W25QXX_HandleTypeDef hbig;
+    const uint8_t msg[] = "above-16MB";
+    uint8_t back[sizeof(msg)];
+    const uint32_t addr = 0x1800000; // 24 MB
+
+    Sim_W25Q_Init(&big, &hspi2, GPIOB, GPIO_PIN_11, 0xEF4019);
+    SIM_CHECK(W25QXX_Init(&hbig, &hspi2, GPIOB, GPIO_PIN_11) == 1);
+    SIM_CHECK(hbig.Info.ID == W25Q256);
+    SIM_CHECK(hbig.AddrBytes == 4);
+
+    W25QXX_Erase_Sector(&hbig, addr);
+    W25QXX_Write(&hbig, (uint8_t *)msg, addr, sizeof(msg));
+    W25QXX_Read(&hbig, back, addr, sizeof(msg));
+    SIM_CHECK(memcmp(msg, back, sizeof(msg)) == 0);
+    SIM_CHECK(memcmp(&big.mem[addr], msg, sizeof(msg)) == 0);
+
+    // The low 16 MB is untouched (no address wrap) and the mode register stays 3-byte
+    SIM_CHECK(big.mem[addr & 0xFFFFFF] == 0xFF);
+    SIM_CHECK(!big.addr4);
+    SIM_CHECK(big.stats.wel_violations == 0);
+    Sim_W25Q_Free(&big);
+}
+
+int main(void)
+{
+    Sim_Reset();
+    Sim_W25Q_Init(&flash, &hspi1, GPIOB, GPIO_PIN_12, 0xEF4017);
+
+    test_identify();
+    test_program_read();
+    test_unaligned_write();
+    test_dma_read();
+    test_async_erase_program();
+    test_suspend_resume();
+    test_suspend_limits();
+    test_4byte_address();
+
+    Sim_W25Q_Free(&flash);
+    return SIM_TEST_RESULT();
+}
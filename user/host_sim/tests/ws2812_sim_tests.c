@@ -0,0 +1,173 @@
+/**
+ * @file ws2812_sim_tests.c
+ * @brief ws2812.c on simulated strips: two-LED circular DMA buffer refilled
+ *        from the half/full callbacks, a 1000-LED strip, three strips on
+ *        parallel channels of one timer, back-to-back frames
+ */
+
+#include "sim_test.h"
+#include "sim_ws2812.h"
+#include "ws2812.h"
+#include <string.h>
+
+#define LONG_LEDS   1000
+#define N_STRIPS    3
+#define PAR_LEDS    300
+
+static TIM_HandleTypeDef     htim2, htim3;
+static TIM_TypeDef           tim2, tim3;
+static DMA_HandleTypeDef     hdma2, hdma3[N_STRIPS];
+static WS2812_HandleTypeDef  short_strip, long_strip, par_strip[N_STRIPS];
+static Sim_WS2812            strip2, strip3[N_STRIPS];
+static uint8_t               long_pixels[LONG_LEDS][3];
+static uint8_t               par_pixels[N_STRIPS][PAR_LEDS][3];
+static WS2812_HandleTypeDef *tim2_strip;
+
+static const uint32_t channels[N_STRIPS] = {TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3};
+
+// TIM2 has a single strip on it: forwarded directly. TIM3 is shared.
+void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim == &htim2) WS2812_DmaCallback(tim2_strip);
+    else WS2812_TIM_Callback(htim);
+}
+
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim == &htim2) WS2812_DmaHalfCallback(tim2_strip);
+    else WS2812_TIM_HalfCallback(htim);
+}
+
+static void tim_init(TIM_HandleTypeDef *htim, TIM_TypeDef *inst)
+{
+    htim->Instance = inst;
+    htim->Init.Prescaler = 0;
+    htim->Init.Period = 89;     // 800 kHz at 72 MHz
+}
+
+static void dma_init(TIM_HandleTypeDef *htim, uint32_t channel, DMA_HandleTypeDef *hdma)
+{
+    hdma->Init.Mode = DMA_CIRCULAR;
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    htim->hdma[1 + (channel >> 2)] = hdma;
+}
+
+static double wait_idle(WS2812_HandleTypeDef *const *strips, int count)
+{
+    uint64_t t0 = Sim_Now();
+    uint32_t guard = 0;
+    bool busy = true;
+
+    while (busy && guard++ < 100000) {
+        busy = false;
+        for (int i = 0; i < count; i++) busy |= strips[i]->Busy != 0;
+        if (busy) Sim_AdvanceUs(10);
+    }
+    SIM_CHECK(!busy);
+    return Sim_CyclesToUs(Sim_Now() - t0);
+}
+
+static bool strip_matches(const Sim_WS2812 *sim, const WS2812_HandleTypeDef *hws)
+{
+    if (sim->latched_leds != hws->NumLEDs) return false;
+    return memcmp(sim->rgb, hws->Pixels, (size_t)hws->NumLEDs * 3) == 0;
+}
+
+static void test_short(void)
+{
+    WS2812_HandleTypeDef *s = &short_strip;
+
+    tim2_strip = s;
+    WS2812_Init(s, &htim2, TIM_CHANNEL_1, 8);
+    for (uint16_t i = 0; i < 8; i++) {
+        WS2812_SetPixelColor(s, i, (uint8_t)(i * 31), (uint8_t)(0xFF - i), (uint8_t)(1U << i));
+    }
+    WS2812_Show(s);
+    wait_idle(&s, 1);
+    SIM_CHECK(strip2.stats.frames == 1);
+    SIM_CHECK(strip_matches(&strip2, s));
+
+    // Back to back, and a Show during a frame is dropped
+    WS2812_Fill(s, 1, 2, 3);
+    WS2812_Show(s);
+    WS2812_Show(s);
+    SIM_CHECK(s->Busy);
+    wait_idle(&s, 1);
+    SIM_CHECK(strip2.stats.frames == 2);
+    SIM_CHECK(strip2.rgb[7][0] == 1 && strip2.rgb[7][1] == 2 && strip2.rgb[7][2] == 3);
+    WS2812_Fill(s, 9, 9, 9);
+    WS2812_Show(s);
+    wait_idle(&s, 1);
+    SIM_CHECK(strip2.stats.frames == 3 && strip_matches(&strip2, s));
+    SIM_CHECK(strip2.stats.gaps == 0 && strip2.stats.bad_pulses == 0);
+}
+
+static void test_long(void)
+{
+    WS2812_HandleTypeDef *s = &long_strip;
+    double us;
+
+    tim2_strip = s;
+    WS2812_InitBuffer(s, &htim2, TIM_CHANNEL_1, long_pixels, LONG_LEDS);
+    for (uint16_t i = 0; i < LONG_LEDS; i++) {
+        WS2812_SetPixelColor(s, i, (uint8_t)i, (uint8_t)(i >> 2), (uint8_t)(i * 7));
+    }
+    WS2812_Show(s);
+    us = wait_idle(&s, 1);
+
+    SIM_CHECK(strip_matches(&strip2, s));
+    SIM_CHECK(strip2.stats.gaps == 0 && strip2.stats.bad_pulses == 0);
+    // 30 us per LED plus the reset slots
+    SIM_CHECK(us < (LONG_LEDS + WS2812_RESET_LEDS + 1) * 30.0 + 50.0);
+
+    printf("BENCH ws2812 %u LEDs  frame %6.0f us (%4.1f fps)  DMA buffer %u B (full-frame buffer: %u B)\n",
+           LONG_LEDS, us, 1e6 / us, (unsigned)sizeof(s->DMA_Buffer), (unsigned)(LONG_LEDS * 24 + 1) * 2);
+}
+
+static void test_parallel(void)
+{
+    WS2812_HandleTypeDef *strips[N_STRIPS];
+    double us;
+
+    for (int k = 0; k < N_STRIPS; k++) {
+        strips[k] = &par_strip[k];
+        WS2812_InitBuffer(strips[k], &htim3, channels[k], par_pixels[k], PAR_LEDS);
+        for (uint16_t i = 0; i < PAR_LEDS; i++) {
+            WS2812_SetPixelColor(strips[k], i, (uint8_t)(k * 80 + i), (uint8_t)(i ^ k), (uint8_t)(255 - i));
+        }
+    }
+    for (int k = 0; k < N_STRIPS; k++) WS2812_Show(strips[k]);
+    us = wait_idle(strips, N_STRIPS);
+
+    for (int k = 0; k < N_STRIPS; k++) {
+        SIM_CHECK(strip3[k].stats.frames == 1);
+        SIM_CHECK(strip_matches(&strip3[k], strips[k]));
+        SIM_CHECK(strip3[k].stats.gaps == 0 && strip3[k].stats.bad_pulses == 0);
+    }
+    // Parallel, not one after another
+    SIM_CHECK(us < (PAR_LEDS + WS2812_RESET_LEDS + 1) * 30.0 + 50.0);
+    printf("BENCH ws2812 %u strips x %u LEDs on one timer   frame %6.0f us\n", N_STRIPS, PAR_LEDS, us);
+}
+
+int main(void)
+{
+    Sim_Reset();
+
+    tim_init(&htim2, &tim2);
+    dma_init(&htim2, TIM_CHANNEL_1, &hdma2);
+    Sim_WS2812_Init(&strip2, &htim2, TIM_CHANNEL_1);
+
+    tim_init(&htim3, &tim3);
+    for (int k = 0; k < N_STRIPS; k++) {
+        dma_init(&htim3, channels[k], &hdma3[k]);
+        Sim_WS2812_Init(&strip3[k], &htim3, channels[k]);
+    }
+
+    test_short();
+    test_long();
+    test_parallel();
+
+    SIM_CHECK(Sim_GetCpuStats()->irq_off_max_cycles == 0);
+
+    return SIM_TEST_RESULT();
+}
@@ -0,0 +1,42 @@
+/**
+ * @file crc16.h
+ * @brief Table-driven CRC-16, reflected polynomial 0x8005
+ * @details One table for CRC-16/MODBUS (init 0xFFFF) and CRC-16/ARC (init 0,
+ *          TinyFrame). Pure C, no hardware dependencies.
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define CRC16_MODBUS_INIT   0xFFFF
+#define CRC16_ARC_INIT      0x0000
+
+/** Slice-by-4 tables; crc16_table[0] is the plain byte-wise table */
+extern const uint16_t crc16_table[4][256];
+
+/**
+ * @brief  Add one byte to a running CRC
+ */
+static inline uint16_t CRC16_UpdateByte(uint16_t crc, uint8_t byte)
+{
+    return (uint16_t)((crc >> 8) ^ crc16_table[0][(crc ^ byte) & 0xFF]);
+}
+
+/**
+ * @brief  Add a block to a running CRC (4 bytes per step)
+ * @param  crc  CRC so far, or CRC16_xxx_INIT to start
+ * @return Updated CRC (no final XOR for either variant)
+ */
+uint16_t CRC16_Update(uint16_t crc, const uint8_t *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CRC16_H